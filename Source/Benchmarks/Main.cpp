@@ -0,0 +1,669 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+#include "../DSP/ClickRemoval.h"
+#include "../DSP/Decrackle.h"
+#include "../DSP/NoiseReduction.h"
+#include "../DSP/FilterBank.h"
+#include "../DSP/OnnxDenoiser.h"
+#include "../DSP/VariableRateResampler.h"
+#include "../Processors/BatchProcessor.h"
+#include "../Processors/TrackDetector.h"
+#include "../Utils/AudioFileManager.h"
+#if VRS_GPU_ENABLED
+#include "../GPU/GPUBackend.h"
+#include "../GPU/GPUNoiseReduction.h"
+#endif
+#include <functional>
+#include <iostream>
+#include <vector>
+
+//==============================================================================
+/**
+ * Vinyl Restoration Suite - DSP benchmarks
+ *
+ * Times the restoration processors on synthetic audio so throughput can be
+ * compared across releases and machines. The realtime processors run block
+ * by block over a sweep of block sizes, sample rates and channel counts; the
+ * offline paths (batch processing, the full-file click scan, track
+ * detection) run on a long synthetic side. Every result is reported as the
+ * realtime factor (seconds of audio per second of processing) and as
+ * nanoseconds per sample per channel, and written as JSON with the machine
+ * it was measured on.
+ */
+namespace
+{
+    constexpr int exitOk = 0;
+    constexpr int exitFailed = 1;
+    constexpr int exitUsage = 2;
+
+    void printUsage()
+    {
+        std::cout << "Usage: VRSBenchmarks [options]\n"
+                     "\n"
+                     "  --output <file>        Write the results as JSON (default: VRSBenchmarks.json)\n"
+                     "  --filter <text>        Only run benchmarks whose name contains text\n"
+                     "  --quick                A reduced sweep, for a smoke test\n"
+                     "  --min-time <seconds>   Processing time measured per configuration (default: 0.25)\n"
+                     "  --file-minutes <n>     Length of the synthetic side for the full-file paths (default: 10)\n"
+                     "  --no-full-file         Skip the full-file paths\n"
+                     "  --help                 Show this help\n";
+    }
+
+    struct Options
+    {
+        juce::File output = juce::File::getCurrentWorkingDirectory().getChildFile ("VRSBenchmarks.json");
+        juce::String filter;
+        bool quick = false;
+        bool fullFile = true;
+        double minSeconds = 0.25;
+        double fileMinutes = 10.0;
+    };
+
+    /** One configuration of one processor */
+    struct Measurement
+    {
+        juce::String benchmark;
+        juce::String variant;                // Provider, backend/device, or what the full-file path ran
+        double sampleRate = 0.0;
+        int blockSize = 0;                   // 0 for a full-file path
+        int numChannels = 0;
+        double realtimeFactor = 0.0;
+        double nsPerSample = 0.0;            // Per sample per channel
+        juce::String note;
+    };
+
+    /** Wall time spent processing, and the audio it covered */
+    struct Timing
+    {
+        double seconds = 0.0;
+        juce::int64 samples = 0;             // Per channel
+    };
+
+    //==============================================================================
+    /**
+     * Reproducible test material: a few tones over surface noise, a click
+     * every few hundred milliseconds and, with gaps, four seconds of near
+     * silence every three minutes for the track detector to find.
+     */
+    juce::AudioBuffer<float> makeSignal (int numChannels, int numSamples, double sampleRate, bool withGaps)
+    {
+        juce::AudioBuffer<float> signal (numChannels, numSamples);
+        const double twoPi = juce::MathConstants<double>::twoPi;
+        const auto clickInterval = static_cast<int> (sampleRate * 0.37);
+        const auto gapInterval = static_cast<juce::int64> (sampleRate * 180.0);
+        const auto gapLength = static_cast<juce::int64> (sampleRate * 4.0);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            juce::Random random (0x5eed + ch);
+            float* data = signal.getWritePointer (ch);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double t = i / sampleRate;
+                const bool inGap = withGaps && i >= gapLength && (i % gapInterval) < gapLength;
+                const double music = 0.2 * std::sin (twoPi * 220.0 * t)
+                                   + 0.1 * std::sin (twoPi * (330.0 + ch) * t)
+                                   + 0.05 * std::sin (twoPi * 1000.0 * t);
+
+                data[i] = static_cast<float> (inGap ? 0.0 : music) + 0.01f * (random.nextFloat() - 0.5f);
+            }
+
+            for (int i = clickInterval / 2 + ch * 17; i + 3 < numSamples; i += clickInterval)
+            {
+                data[i] += 0.8f;
+                data[i + 1] -= 0.5f;
+                data[i + 2] += 0.2f;
+            }
+        }
+
+        return signal;
+    }
+
+    /**
+     * Feeds signal through processBlock block by block, the signal repeated
+     * until minSeconds of processing have been timed. Only the processBlock
+     * calls are timed; the first pass is a warm-up and is not counted.
+     */
+    Timing timeBlocks (const juce::AudioBuffer<float>& signal, int blockSize, double minSeconds,
+                       const std::function<void (juce::AudioBuffer<float>&)>& processBlock)
+    {
+        juce::AudioBuffer<float> block (signal.getNumChannels(), blockSize);
+        Timing timing;
+        juce::int64 ticks = 0;
+
+        for (int pass = 0; pass == 0 || juce::Time::highResolutionTicksToSeconds (ticks) < minSeconds; ++pass)
+        {
+            for (int position = 0; position + blockSize <= signal.getNumSamples(); position += blockSize)
+            {
+                for (int ch = 0; ch < signal.getNumChannels(); ++ch)
+                    block.copyFrom (ch, 0, signal, ch, position, blockSize);
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                processBlock (block);
+                const auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+                if (pass > 0)
+                {
+                    ticks += elapsed;
+                    timing.samples += blockSize;
+                }
+            }
+        }
+
+        timing.seconds = juce::Time::highResolutionTicksToSeconds (ticks);
+        return timing;
+    }
+
+    /** Times one call of run, which processes numSamples per channel */
+    Timing timeOnce (juce::int64 numSamples, const std::function<void()>& run)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        run();
+
+        Timing timing;
+        timing.seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        timing.samples = numSamples;
+        return timing;
+    }
+
+    //==============================================================================
+    class BenchmarkRunner
+    {
+    public:
+        explicit BenchmarkRunner (const Options& optionsToUse) : options (optionsToUse) {}
+
+        bool shouldRun (const juce::String& benchmark) const
+        {
+            return options.filter.isEmpty() || benchmark.containsIgnoreCase (options.filter);
+        }
+
+        void add (Measurement measurement, const Timing& timing)
+        {
+            if (timing.seconds > 0.0 && timing.samples > 0)
+            {
+                const double audioSeconds = static_cast<double> (timing.samples) / measurement.sampleRate;
+                measurement.realtimeFactor = audioSeconds / timing.seconds;
+                measurement.nsPerSample = timing.seconds * 1.0e9
+                                        / (static_cast<double> (timing.samples) * juce::jmax (1, measurement.numChannels));
+            }
+
+            std::cout << measurement.benchmark.paddedRight (' ', 26)
+                      << measurement.variant.paddedRight (' ', 28)
+                      << juce::String (measurement.sampleRate / 1000.0, 1).paddedLeft (' ', 7) << " kHz"
+                      << juce::String (measurement.blockSize).paddedLeft (' ', 6)
+                      << juce::String (measurement.numChannels).paddedLeft (' ', 3) << " ch"
+                      << juce::String (measurement.realtimeFactor, 1).paddedLeft (' ', 10) << "x"
+                      << juce::String (measurement.nsPerSample, 2).paddedLeft (' ', 10) << " ns/sample"
+                      << (measurement.note.isNotEmpty() ? "  (" + measurement.note + ")" : juce::String())
+                      << std::endl;
+
+            results.push_back (std::move (measurement));
+        }
+
+        /** Block sizes, sample rates and channel counts of the realtime sweep */
+        std::vector<int> getBlockSizes() const
+        {
+            if (options.quick)
+                return { 64, 512, 4096 };
+
+            return { 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+        }
+
+        std::vector<double> getSampleRates() const
+        {
+            if (options.quick)
+                return { 44100.0, 96000.0 };
+
+            return { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        }
+
+        std::vector<int> getChannelCounts() const
+        {
+            if (options.quick)
+                return { 2 };
+
+            return { 1, 2 };
+        }
+
+        /**
+         * Runs a realtime processor over the whole sweep. prepare (spec) returns
+         * the block function for that configuration, or nothing to skip it.
+         */
+        void sweep (const juce::String& benchmark, const juce::String& variant,
+                    const std::function<std::function<void (juce::AudioBuffer<float>&)> (const juce::dsp::ProcessSpec&)>& prepare,
+                    const std::vector<double>& sampleRates = {})
+        {
+            if (!shouldRun (benchmark))
+                return;
+
+            for (const double sampleRate : (sampleRates.empty() ? getSampleRates() : sampleRates))
+            {
+                for (const int numChannels : getChannelCounts())
+                {
+                    // Two seconds of material, repeated as often as the timing needs
+                    const auto signal = makeSignal (numChannels, static_cast<int> (sampleRate * 2.0), sampleRate, false);
+
+                    for (const int blockSize : getBlockSizes())
+                    {
+                        const juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32> (blockSize),
+                                                            static_cast<juce::uint32> (numChannels) };
+                        const auto processBlock = prepare (spec);
+
+                        if (processBlock == nullptr)
+                            continue;
+
+                        add ({ benchmark, variant, sampleRate, blockSize, numChannels },
+                             timeBlocks (signal, blockSize, options.minSeconds, processBlock));
+                    }
+                }
+            }
+        }
+
+        juce::var toVar() const
+        {
+            auto* machine = new juce::DynamicObject();
+            machine->setProperty ("cpu", juce::SystemStats::getCpuModel());
+            machine->setProperty ("cores", juce::SystemStats::getNumCpus());
+            machine->setProperty ("physicalCores", juce::SystemStats::getNumPhysicalCpus());
+            machine->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+            machine->setProperty ("memoryMB", juce::SystemStats::getMemorySizeInMegabytes());
+
+            juce::Array<juce::var> entries;
+
+            for (const auto& measurement : results)
+            {
+                auto* entry = new juce::DynamicObject();
+                entry->setProperty ("benchmark", measurement.benchmark);
+                entry->setProperty ("variant", measurement.variant);
+                entry->setProperty ("sampleRate", measurement.sampleRate);
+                entry->setProperty ("blockSize", measurement.blockSize);
+                entry->setProperty ("numChannels", measurement.numChannels);
+                entry->setProperty ("realtimeFactor", measurement.realtimeFactor);
+                entry->setProperty ("nsPerSample", measurement.nsPerSample);
+
+                if (measurement.note.isNotEmpty())
+                    entry->setProperty ("note", measurement.note);
+
+                entries.add (juce::var (entry));
+            }
+
+            auto* root = new juce::DynamicObject();
+            root->setProperty ("version", VRS_VERSION_STRING);
+            root->setProperty ("time", juce::Time::getCurrentTime().toISO8601 (true));
+            root->setProperty ("quick", options.quick);
+            root->setProperty ("machine", juce::var (machine));
+            root->setProperty ("results", entries);
+            return juce::var (root);
+        }
+
+        const Options& options;
+
+    private:
+        std::vector<Measurement> results;
+    };
+
+    //==============================================================================
+    void benchmarkRealtimeProcessors (BenchmarkRunner& runner)
+    {
+        runner.sweep ("ClickRemoval", "repair", [] (const juce::dsp::ProcessSpec& spec)
+        {
+            auto processor = std::make_shared<ClickRemoval>();
+            processor->prepare (spec);
+            processor->setSensitivity (60.0f);
+            processor->setApplyRemoval (true);
+
+            return std::function<void (juce::AudioBuffer<float>&)> ([processor] (juce::AudioBuffer<float>& block)
+            {
+                juce::dsp::AudioBlock<float> audioBlock (block);
+                juce::dsp::ProcessContextReplacing<float> context (audioBlock);
+                processor->process (context);
+            });
+        });
+
+        runner.sweep ("Decrackle", "width 3", [] (const juce::dsp::ProcessSpec& spec)
+        {
+            auto processor = std::make_shared<Decrackle>();
+            processor->prepare (spec);
+            processor->setFactor (0.5f);
+            processor->setAverageWidth (3);
+
+            return std::function<void (juce::AudioBuffer<float>&)> ([processor] (juce::AudioBuffer<float>& block)
+            {
+                juce::dsp::AudioBlock<float> audioBlock (block);
+                juce::dsp::ProcessContextReplacing<float> context (audioBlock);
+                processor->process (context);
+            });
+        });
+
+        runner.sweep ("NoiseReduction", "12 dB", [] (const juce::dsp::ProcessSpec& spec)
+        {
+            auto processor = std::make_shared<NoiseReduction>();
+            processor->prepare (spec);
+
+            // A profile from the material itself, so the spectral gain is applied rather than bypassed
+            const auto profileSource = makeSignal (static_cast<int> (spec.numChannels), static_cast<int> (spec.sampleRate),
+                                                   spec.sampleRate, false);
+            processor->captureProfileFromBuffer (profileSource, 0, profileSource.getNumSamples());
+            processor->setReduction (12.0f);
+
+            return std::function<void (juce::AudioBuffer<float>&)> ([processor] (juce::AudioBuffer<float>& block)
+            {
+                juce::dsp::AudioBlock<float> audioBlock (block);
+                juce::dsp::ProcessContextReplacing<float> context (audioBlock);
+                processor->process (context);
+            });
+        });
+
+        runner.sweep ("FilterBank", "rumble + hum", [] (const juce::dsp::ProcessSpec& spec)
+        {
+            auto processor = std::make_shared<FilterBank>();
+            processor->prepare (spec);
+            processor->setRumbleFilter (20.0f, false);
+            processor->setHumFilter (50.0f, false);
+
+            return std::function<void (juce::AudioBuffer<float>&)> ([processor] (juce::AudioBuffer<float>& block)
+            {
+                juce::dsp::AudioBlock<float> audioBlock (block);
+                juce::dsp::ProcessContextReplacing<float> context (audioBlock);
+                processor->process (context);
+            });
+        });
+    }
+
+    /** Realtime and offline AI denoise on every provider that can run without fallback */
+    void benchmarkOnnxDenoiser (BenchmarkRunner& runner)
+    {
+        if (!runner.shouldRun ("OnnxDenoiser"))
+            return;
+
+        const std::vector<OnnxDenoiser::Provider> providers { OnnxDenoiser::Provider::cpu, OnnxDenoiser::Provider::dml,
+                                                              OnnxDenoiser::Provider::qnn, OnnxDenoiser::Provider::cuda,
+                                                              OnnxDenoiser::Provider::rocm, OnnxDenoiser::Provider::coreml };
+
+        for (const auto provider : providers)
+        {
+            const auto name = OnnxDenoiser::providerToString (provider);
+
+            // Probe once: a provider that is not built in or finds no device is reported and skipped
+            {
+                OnnxDenoiser probe;
+                probe.setPreferredProvider (provider);
+                probe.setAllowFallback (false);
+
+                if (!probe.loadDefaultModelIfNeeded() || !probe.isReady() || probe.getActiveProvider() != provider)
+                {
+                    std::cout << "OnnxDenoiser: " << name << " unavailable, skipped" << std::endl;
+                    continue;
+                }
+            }
+
+            // The model runs at 48 kHz; other rates add the resamplers
+            runner.sweep ("OnnxDenoiser", name, [provider] (const juce::dsp::ProcessSpec& spec)
+            {
+                auto denoiser = std::make_shared<OnnxDenoiser>();
+                denoiser->setPreferredProvider (provider);
+                denoiser->setAllowFallback (false);
+                denoiser->setAsyncInference (false);
+                denoiser->prepare (spec.sampleRate, static_cast<int> (spec.numChannels), static_cast<int> (spec.maximumBlockSize));
+
+                if (!denoiser->loadDefaultModelIfNeeded())
+                    return std::function<void (juce::AudioBuffer<float>&)>();
+
+                denoiser->setEnabled (true);
+
+                return std::function<void (juce::AudioBuffer<float>&)> ([denoiser] (juce::AudioBuffer<float>& block)
+                {
+                    denoiser->processBlock (block, 1.0f);
+                });
+            }, { 44100.0, 48000.0 });
+
+            OnnxDenoiser offline;
+            offline.setPreferredProvider (provider);
+            offline.setAllowFallback (false);
+
+            const double sampleRate = 48000.0;
+            auto signal = makeSignal (2, static_cast<int> (sampleRate * 30.0), sampleRate, false);
+            bool succeeded = false;
+
+            const auto timing = timeOnce (signal.getNumSamples(), [&] { succeeded = offline.processOffline (signal, sampleRate); });
+            runner.add ({ "OnnxDenoiser offline", name, sampleRate, 0, 2, 0.0, 0.0, succeeded ? juce::String() : "failed" },
+                        succeeded ? timing : Timing());
+        }
+    }
+
+   #if VRS_GPU_ENABLED
+    /** GPU noise reduction on every device of the backend built in, on the path its calibration picks */
+    void benchmarkGPUNoiseReduction (BenchmarkRunner& runner)
+    {
+        if (!runner.shouldRun ("GPUNoiseReduction"))
+            return;
+
+        if (!GPUBackend::initialize())
+        {
+            std::cout << "GPUNoiseReduction: no " << GPUBackend::getBackendName() << " device, skipped" << std::endl;
+            return;
+        }
+
+        for (int device = 0; device < GPUBackend::getNumDevices(); ++device)
+        {
+            const auto info = GPUBackend::getDeviceInfo (device);
+            const juce::String variant = juce::String (GPUBackend::getBackendName()) + " #" + juce::String (device)
+                                       + " " + juce::String (info.name);
+
+            runner.sweep ("GPUNoiseReduction", variant, [device] (const juce::dsp::ProcessSpec& spec)
+            {
+                GPUBackend::setCurrentDevice (device);
+
+                auto processor = std::make_shared<GPUNoiseReduction>();
+                processor->prepare (spec);
+                processor->setNoiseProfile (std::vector<float> (processor->getNoiseProfile().size(), 0.01f));
+                processor->setReduction (12.0f);
+
+                return std::function<void (juce::AudioBuffer<float>&)> ([processor, device] (juce::AudioBuffer<float>& block)
+                {
+                    GPUBackend::setCurrentDevice (device);
+
+                    juce::dsp::AudioBlock<float> audioBlock (block);
+                    juce::dsp::ProcessContextReplacing<float> context (audioBlock);
+                    processor->process (context);
+                });
+            });
+        }
+
+        GPUBackend::shutdown();
+    }
+   #endif
+
+    //==============================================================================
+    /** The offline paths on one long synthetic side (stereo, 44.1 kHz) */
+    void benchmarkFullFilePaths (BenchmarkRunner& runner)
+    {
+        const double sampleRate = 44100.0;
+        const int numChannels = 2;
+        const auto numSamples = static_cast<int> (sampleRate * 60.0 * runner.options.fileMinutes);
+        const auto side = makeSignal (numChannels, numSamples, sampleRate, true);
+        const juce::String variant = juce::String (runner.options.fileMinutes, 1) + " min side";
+
+        if (runner.shouldRun ("ClickDetection"))
+        {
+            // The per-segment work of the editor's click detection task: a detect-only scan
+            auto scanned = side;
+            ClickRemoval detector;
+            detector.prepare ({ sampleRate, 2048u, static_cast<juce::uint32> (numChannels) });
+            detector.setSensitivity (60.0f);
+            detector.setApplyRemoval (false);
+            detector.setStoreDetectedClicks (true);
+
+            int numClicks = 0;
+            const auto timing = timeOnce (numSamples, [&] { numClicks = detector.processBufferRegion (scanned, 0, numSamples); });
+            runner.add ({ "ClickDetection full file", variant, sampleRate, 0, numChannels, 0.0, 0.0,
+                          juce::String (numClicks) + " clicks, one core" }, timing);
+        }
+
+        if (runner.shouldRun ("TrackDetector"))
+        {
+            TrackDetector detector;
+            TrackDetector::DetectionSettings settings;
+            size_t numTracks = 0;
+
+            const auto timing = timeOnce (numSamples, [&] { numTracks = detector.detectTracks (side, sampleRate, settings).size(); });
+            runner.add ({ "TrackDetector detectTracks", variant, sampleRate, 0, numChannels, 0.0, 0.0,
+                          juce::String (static_cast<int> (numTracks)) + " boundaries" }, timing);
+        }
+
+        if (runner.shouldRun ("VariableRateResampler"))
+        {
+            // The eccentric record correction's render: 33 1/3 rpm, 0.5 % wow, the whole side on one thread
+            const double omega = juce::MathConstants<double>::twoPi / (sampleRate * 1.8);
+            const auto map = VariableRateResampler::TimeMap::fromSpeedCurve ([omega] (juce::int64 n)
+            {
+                return 1.0 - 0.005 * std::sin (omega * static_cast<double> (n));
+            }, numSamples);
+
+            VariableRateResampler resampler (map.getMaxSpeed());
+            juce::AudioBuffer<float> corrected (numChannels, numSamples);
+
+            const auto timing = timeOnce (numSamples, [&]
+            {
+                resampler.render (side, { 0, numSamples }, 0, map, 0, numSamples, corrected);
+            });
+            runner.add ({ "VariableRateResampler wow correction", variant, sampleRate, 0, numChannels, 0.0, 0.0,
+                          juce::String (resampler.getKernelRadius() * 2) + " taps, one core" }, timing);
+        }
+
+        if (runner.shouldRun ("BatchProcessor"))
+        {
+            const auto directory = juce::File::createTempFile ("vrs-benchmark");
+            directory.createDirectory();
+            const auto input = directory.getChildFile ("side.wav");
+
+            {
+                std::unique_ptr<juce::AudioFormatWriter> writer (AudioFileManager::createWriterFor (input, sampleRate, numChannels, 24));
+
+                if (writer == nullptr || !writer->writeFromAudioSampleBuffer (side, 0, numSamples))
+                {
+                    std::cerr << "Could not write the synthetic side to " << input.getFullPathName() << std::endl;
+                    directory.deleteRecursively();
+                    return;
+                }
+            }
+
+            BatchProcessor::Settings settings;
+            settings.clickRemoval = true;
+            settings.decrackle = true;
+            settings.noiseReduction = true;
+            settings.rumbleFilter = true;
+            settings.normalize = true;
+            settings.outputDirectory = directory.getChildFile ("out");
+            settings.numWorkers = 1;
+
+            // As in the CLI: no message loop, so the callbacks come from the worker
+            BatchProcessor processor;
+            juce::WaitableEvent finished;
+            bool succeeded = false;
+
+            processor.setCallbacksOnMessageThread (false);
+            processor.setCompletionCallback ([&] (bool success, const juce::String&)
+            {
+                succeeded = success;
+                finished.signal();
+            });
+
+            processor.addFile (input);
+
+            const auto timing = timeOnce (numSamples, [&]
+            {
+                processor.startProcessing (settings);
+                finished.wait (-1);
+            });
+
+            processor.stopThread (10000);
+            runner.add ({ "BatchProcessor processFile", variant, sampleRate, 0, numChannels, 0.0, 0.0,
+                          succeeded ? "clicks, decrackle, NR, rumble, normalise; read and write included" : "failed" },
+                        succeeded ? timing : Timing());
+
+            directory.deleteRecursively();
+        }
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    Options options;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return exitOk;
+        }
+
+        if (arg == "--quick")
+        {
+            options.quick = true;
+        }
+        else if (arg == "--no-full-file")
+        {
+            options.fullFile = false;
+        }
+        else if (arg.startsWith ("--"))
+        {
+            if (i + 1 >= args.size())
+            {
+                std::cerr << "Missing value for " << arg << "\n";
+                return exitUsage;
+            }
+
+            const auto value = args[++i];
+
+            if (arg == "--output")
+                options.output = juce::File::getCurrentWorkingDirectory().getChildFile (value.unquoted());
+            else if (arg == "--filter")
+                options.filter = value;
+            else if (arg == "--min-time")
+                options.minSeconds = juce::jlimit (0.01, 60.0, value.getDoubleValue());
+            else if (arg == "--file-minutes")
+                options.fileMinutes = juce::jlimit (0.1, 240.0, value.getDoubleValue());
+            else
+            {
+                std::cerr << "Unknown option: " << arg << "\n";
+                return exitUsage;
+            }
+        }
+        else
+        {
+            std::cerr << "Unexpected argument: " << arg << "\n";
+            return exitUsage;
+        }
+    }
+
+    BenchmarkRunner runner (options);
+
+    benchmarkRealtimeProcessors (runner);
+    benchmarkOnnxDenoiser (runner);
+   #if VRS_GPU_ENABLED
+    benchmarkGPUNoiseReduction (runner);
+   #endif
+
+    if (options.fullFile)
+        benchmarkFullFilePaths (runner);
+
+    if (!options.output.replaceWithText (juce::JSON::toString (runner.toVar(), false)))
+    {
+        std::cerr << "Could not write results: " << options.output.getFullPathName() << "\n";
+        return exitFailed;
+    }
+
+    std::cout << "Results written to " << options.output.getFullPathName() << std::endl;
+    return exitOk;
+}
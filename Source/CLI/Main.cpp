@@ -0,0 +1,312 @@
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+#include "../Processors/BatchProcessor.h"
+#include "../Utils/SessionFile.h"
+#include <iostream>
+
+//==============================================================================
+/**
+ * Vinyl Restoration Suite - command-line batch processor
+ *
+ * Runs the BatchProcessor without the GUI, for render nodes and job
+ * schedulers: no window, OpenGL context or LookAndFeel is created, so it
+ * starts quickly and many copies fit on one machine. The settings come from
+ * a preset (BatchProcessor::settingsToVar() JSON) or a session file, the
+ * files from the command line and/or a list file. --shard picks every n-th
+ * file, so n processes given the same list split it between them.
+ */
+namespace
+{
+    constexpr int exitOk = 0;
+    constexpr int exitFailed = 1;
+    constexpr int exitUsage = 2;
+
+    void printUsage()
+    {
+        std::cout << "Usage: VinylRestorationCLI --preset <file> [options] [audio files...]\n"
+                     "\n"
+                     "  --preset <file>        Batch settings: a preset or a .vrs session\n"
+                     "  --file-list <file>     Audio files to process, one per line ('#' comments)\n"
+                     "  --output-dir <dir>     Output folder (default: next to each input)\n"
+                     "  --workers <n>          Files processed at once (default: preset, or one per core)\n"
+                     "  --cache <dir>          Render cache, may be shared by all shards (default: preset)\n"
+                     "  --shard <i>/<n>        Process only files i, i+n, i+2n... of the list (i from 0)\n"
+                     "  --log <file>           Write the results log (one line per file) when done\n"
+                     "  --trace <file>         Write a Chrome trace of the run (chrome://tracing, Perfetto)\n"
+                     "  --write-preset <file>  Write the settings in effect as a preset and exit\n"
+                     "  --quiet                Only print the summary and errors\n"
+                     "  --help                 Show this help\n";
+    }
+
+    juce::File getFileArgument (const juce::String& path)
+    {
+        return juce::File::getCurrentWorkingDirectory().getChildFile (path.unquoted());
+    }
+
+    /** A preset is the settings object itself; a session keeps them in its settings (sessionData, in JSON) */
+    bool loadSettings (const juce::File& file, BatchProcessor::Settings& settings)
+    {
+        if (SessionFile::isBinarySession (file))
+        {
+            const SessionFile session (file);
+
+            if (!session.isValid())
+                return false;
+
+            auto preset = session.getSettings();
+
+            if (preset.hasProperty ("batchSettings"))
+                preset = preset["batchSettings"];
+
+            settings = BatchProcessor::settingsFromVar (preset, settings);
+            return true;
+        }
+
+        const auto parsed = juce::JSON::parse (file.loadFileAsString());
+
+        if (!parsed.isObject())
+            return false;
+
+        auto preset = parsed;
+
+        if (parsed.hasProperty ("sessionData"))
+        {
+            preset = parsed["sessionData"];
+
+            if (preset.hasProperty ("batchSettings"))
+                preset = preset["batchSettings"];
+        }
+
+        settings = BatchProcessor::settingsFromVar (preset, settings);
+        return true;
+    }
+
+    void readFileList (const juce::File& listFile, juce::StringArray& paths)
+    {
+        juce::StringArray lines;
+        lines.addLines (listFile.loadFileAsString());
+
+        for (auto line : lines)
+        {
+            line = line.trim();
+
+            if (line.isNotEmpty() && !line.startsWithChar ('#'))
+                paths.add (line);
+        }
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    BatchProcessor::Settings settings;
+    juce::StringArray paths;
+    juce::File presetFile, presetToWrite, logFile, traceFile;
+    juce::String outputDirectory, cacheDirectory;
+    int numWorkers = -1;
+    int shardIndex = 0, numShards = 1;
+    bool quiet = false;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        const bool hasValue = i + 1 < args.size();
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return exitOk;
+        }
+
+        if (arg == "--quiet" || arg == "-q")
+        {
+            quiet = true;
+        }
+        else if (arg.startsWith ("--"))
+        {
+            if (!hasValue)
+            {
+                std::cerr << "Missing value for " << arg << "\n";
+                return exitUsage;
+            }
+
+            const auto value = args[++i];
+
+            if (arg == "--preset")
+            {
+                presetFile = getFileArgument (value);
+            }
+            else if (arg == "--file-list")
+            {
+                const auto listFile = getFileArgument (value);
+
+                if (!listFile.existsAsFile())
+                {
+                    std::cerr << "File list not found: " << listFile.getFullPathName() << "\n";
+                    return exitUsage;
+                }
+
+                readFileList (listFile, paths);
+            }
+            else if (arg == "--output-dir")
+            {
+                outputDirectory = value;
+            }
+            else if (arg == "--cache")
+            {
+                cacheDirectory = value;
+            }
+            else if (arg == "--workers")
+            {
+                numWorkers = juce::jmax (0, value.getIntValue());
+            }
+            else if (arg == "--shard")
+            {
+                shardIndex = value.upToFirstOccurrenceOf ("/", false, false).getIntValue();
+                numShards = value.fromFirstOccurrenceOf ("/", false, false).getIntValue();
+
+                if (!value.containsChar ('/') || numShards < 1 || shardIndex < 0 || shardIndex >= numShards)
+                {
+                    std::cerr << "Invalid shard '" << value << "', expected <index>/<count> with 0 <= index < count\n";
+                    return exitUsage;
+                }
+            }
+            else if (arg == "--log")
+            {
+                logFile = getFileArgument (value);
+            }
+            else if (arg == "--trace")
+            {
+                traceFile = getFileArgument (value);
+            }
+            else if (arg == "--write-preset")
+            {
+                presetToWrite = getFileArgument (value);
+            }
+            else
+            {
+                std::cerr << "Unknown option " << arg << "\n";
+                printUsage();
+                return exitUsage;
+            }
+        }
+        else
+        {
+            paths.add (arg);
+        }
+    }
+
+    if (presetFile != juce::File() && !loadSettings (presetFile, settings))
+    {
+        std::cerr << "Could not read preset: " << presetFile.getFullPathName() << "\n";
+        return exitUsage;
+    }
+
+    if (outputDirectory.isNotEmpty())
+    {
+        settings.outputDirectory = getFileArgument (outputDirectory);
+
+        if (!settings.outputDirectory.createDirectory())
+        {
+            std::cerr << "Could not create output folder: " << settings.outputDirectory.getFullPathName() << "\n";
+            return exitFailed;
+        }
+    }
+
+    if (cacheDirectory.isNotEmpty())
+        settings.cacheDirectory = getFileArgument (cacheDirectory);
+
+    if (numWorkers >= 0)
+        settings.numWorkers = numWorkers;
+
+    settings.traceFile = traceFile;
+
+    if (presetToWrite != juce::File())
+    {
+        if (!presetToWrite.replaceWithText (juce::JSON::toString (BatchProcessor::settingsToVar (settings), true)))
+        {
+            std::cerr << "Could not write preset: " << presetToWrite.getFullPathName() << "\n";
+            return exitFailed;
+        }
+
+        return exitOk;
+    }
+
+    if (presetFile == juce::File() || paths.isEmpty())
+    {
+        printUsage();
+        return exitUsage;
+    }
+
+    //==============================================================================
+    BatchProcessor processor;
+    int missingFiles = 0;
+
+    for (int i = shardIndex; i < paths.size(); i += numShards)
+    {
+        const auto file = getFileArgument (paths[i]);
+
+        if (file.existsAsFile())
+        {
+            processor.addFile (file);
+        }
+        else
+        {
+            std::cerr << "File not found: " << file.getFullPathName() << "\n";
+            ++missingFiles;
+        }
+    }
+
+    if (processor.getQueueSize() == 0)
+    {
+        std::cout << "No files to process in shard " << shardIndex << "/" << numShards << "\n";
+        return missingFiles > 0 ? exitFailed : exitOk;
+    }
+
+    // There is no message loop here: callbacks come straight from the workers
+    juce::CriticalSection outputLock;
+    juce::WaitableEvent finished;
+    bool batchSucceeded = false;
+    juce::String summary;
+
+    processor.setCallbacksOnMessageThread (false);
+
+    if (!quiet)
+    {
+        processor.setProgressCallback ([&outputLock] (const BatchProcessor::ProgressInfo& info)
+        {
+            // Only the start and end of each file; the percent updates in between are skipped
+            if (info.fileProgress > 0.0f && info.fileProgress < 1.0f)
+                return;
+
+            const juce::ScopedLock sl (outputLock);
+            std::cout << "[" << info.filesCompleted << "/" << info.totalFiles << "] " << info.status << std::endl;
+        });
+    }
+
+    processor.setCompletionCallback ([&] (bool success, const juce::String& message)
+    {
+        {
+            const juce::ScopedLock sl (outputLock);
+            batchSucceeded = success;
+            summary = message;
+        }
+
+        finished.signal();
+    });
+
+    processor.startProcessing (settings);
+    finished.wait (-1);
+    processor.stopThread (10000);
+
+    std::cout << summary << std::endl;
+
+    if (logFile != juce::File() && !logFile.replaceWithText (processor.getLog().joinIntoString ("\n") + "\n"))
+        std::cerr << "Could not write log: " << logFile.getFullPathName() << "\n";
+
+    return batchSucceeded && missingFiles == 0 ? exitOk : exitFailed;
+}
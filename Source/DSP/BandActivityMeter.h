@@ -0,0 +1,265 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "FFTCache.h"
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+/**
+ * Band Activity Meter
+ *
+ * Drives the per-band EQ activity display without loading the audio thread.
+ * push() copies one mono frame out of every `decimation` frames into a
+ * lock-free FIFO (juce::AbstractFifo) and does nothing at all while the meter
+ * is stopped. A low-priority thread analyses the frames at GUI frame rate:
+ * one FFT per frame, summed into octave bands around the graphic EQ centres.
+ *
+ * Decimation is in time rather than rate, so every frame keeps the full
+ * bandwidth and the 8 and 16 kHz bands stay measurable.
+ */
+class BandActivityMeter : private juce::Thread
+{
+public:
+    static constexpr int numBands = 10;
+
+    BandActivityMeter()
+        : juce::Thread ("BandActivityMeter"),
+          fifo (fifoSize),
+          fifoBuffer (static_cast<size_t> (fifoSize), 0.0f)
+    {
+        for (auto& level : levels)
+            level.store (0.0f);
+    }
+
+    ~BandActivityMeter() override
+    {
+        stop();
+    }
+
+    //==============================================================================
+    void prepare (double newSampleRate)
+    {
+        sampleRate.store (newSampleRate);
+    }
+
+    /** Analyse one frame out of every `factor` (1-64) */
+    void setDecimation (int factor)
+    {
+        decimation.store (juce::jlimit (1, 64, factor));
+    }
+
+    /** Starts the analysis thread (message thread, e.g. when the editor opens) */
+    void start()
+    {
+        if (isThreadRunning())
+            return;
+
+        active.store (true);
+        startThread (juce::Thread::Priority::low);
+    }
+
+    /** Stops the analysis thread; push() becomes a no-op and the levels fall to zero */
+    void stop()
+    {
+        active.store (false);
+        stopThread (1000);
+
+        for (auto& level : levels)
+            level.store (0.0f);
+    }
+
+    bool isRunning() const { return active.load(); }
+
+    //==============================================================================
+    /** Audio thread: real-time safe. Frames that do not fit in the FIFO are skipped. */
+    void push (const juce::dsp::AudioBlock<float>& block)
+    {
+        if (!active.load (std::memory_order_relaxed))
+            return;
+
+        const int numSamples = static_cast<int> (block.getNumSamples());
+        const int numChannels = juce::jmin (2, static_cast<int> (block.getNumChannels()));
+
+        if (numChannels == 0)
+            return;
+
+        const float* left = block.getChannelPointer (0);
+        const float* right = numChannels > 1 ? block.getChannelPointer (1) : nullptr;
+
+        for (int offset = 0; offset < numSamples;)
+        {
+            if (skipRemaining > 0)
+            {
+                const int skip = juce::jmin (skipRemaining, numSamples - offset);
+                skipRemaining -= skip;
+                offset += skip;
+                continue;
+            }
+
+            // Only start a frame that fits completely, so frames stay contiguous
+            if (captureRemaining == 0)
+            {
+                if (fifo.getFreeSpace() < frameSize)
+                {
+                    skipRemaining = frameSize;
+                    continue;
+                }
+
+                captureRemaining = frameSize;
+            }
+
+            const int count = juce::jmin (captureRemaining, numSamples - offset);
+            const auto scope = fifo.write (count);
+
+            writeMono (left, right, offset, scope.startIndex1, scope.blockSize1);
+            writeMono (left, right, offset + scope.blockSize1, scope.startIndex2, scope.blockSize2);
+
+            captureRemaining -= count;
+            offset += count;
+
+            if (captureRemaining == 0)
+                skipRemaining = frameSize * (decimation.load (std::memory_order_relaxed) - 1);
+        }
+    }
+
+    /** Smoothed activity for a band (0.0 to 1.0), safe from any thread */
+    float getLevel (int band) const
+    {
+        if (juce::isPositiveAndBelow (band, numBands))
+            return levels[static_cast<size_t> (band)].load();
+
+        return 0.0f;
+    }
+
+private:
+    //==============================================================================
+    static constexpr int frameOrder = 10;
+    static constexpr int frameSize = 1 << frameOrder;
+    static constexpr int fifoSize = frameSize * 4;
+    static constexpr int analysisIntervalMs = 33;
+    static constexpr int staleTicks = 15;
+
+    void writeMono (const float* left, const float* right, int sourceOffset, int destination, int count)
+    {
+        float* out = fifoBuffer.data() + destination;
+
+        if (right == nullptr)
+        {
+            juce::FloatVectorOperations::copy (out, left + sourceOffset, count);
+            return;
+        }
+
+        for (int i = 0; i < count; ++i)
+            out[i] = 0.5f * (left[sourceOffset + i] + right[sourceOffset + i]);
+    }
+
+    void run() override
+    {
+        const juce::dsp::FFT fft (frameOrder);
+        const auto window = FFTCache::getWindow (frameSize, juce::dsp::WindowingFunction<float>::hann, true);
+        std::vector<float> frame (static_cast<size_t> (frameSize * 2), 0.0f);
+        std::array<float, numBands> latest {};
+        std::array<float, numBands> smoothed {};
+
+        int ticksSinceFrame = 0;
+
+        double windowPower = 0.0;
+        for (auto w : *window)
+            windowPower += static_cast<double> (w) * w;
+
+        while (!threadShouldExit())
+        {
+            // Analyse every complete frame; the newest one wins
+            while (fifo.getNumReady() >= frameSize)
+            {
+                ticksSinceFrame = 0;
+                readFrame (frame.data());
+                juce::FloatVectorOperations::multiply (frame.data(), window->data(), frameSize);
+                juce::FloatVectorOperations::clear (frame.data() + frameSize, frameSize);
+                fft.performRealOnlyForwardTransform (frame.data(), true);
+                measureBands (frame.data(), windowPower, latest);
+            }
+
+            // Between frames the last measurement is held, so the display does not flicker;
+            // once audio stops arriving the bands fall back to zero
+            if (++ticksSinceFrame > staleTicks)
+                latest.fill (0.0f);
+
+            for (size_t band = 0; band < static_cast<size_t> (numBands); ++band)
+            {
+                const float coeff = latest[band] > smoothed[band] ? attackCoeff : releaseCoeff;
+                smoothed[band] = latest[band] * (1.0f - coeff) + smoothed[band] * coeff;
+
+                // Moderate normalization for selective visibility
+                levels[band].store (juce::jlimit (0.0f, 1.0f, smoothed[band] * 6.0f));
+            }
+
+            wait (analysisIntervalMs);
+        }
+    }
+
+    void readFrame (float* destination)
+    {
+        const auto scope = fifo.read (frameSize);
+
+        if (scope.blockSize1 > 0)
+            juce::FloatVectorOperations::copy (destination, fifoBuffer.data() + scope.startIndex1, scope.blockSize1);
+
+        if (scope.blockSize2 > 0)
+            juce::FloatVectorOperations::copy (destination + scope.blockSize1, fifoBuffer.data() + scope.startIndex2, scope.blockSize2);
+    }
+
+    /** Octave-band RMS from the spectrum, combined with a sine peak estimate as before */
+    void measureBands (const float* spectrum, double windowPower, std::array<float, numBands>& result) const
+    {
+        const double binWidth = sampleRate.load() / frameSize;
+        const int nyquistBin = frameSize / 2;
+
+        for (size_t band = 0; band < static_cast<size_t> (numBands); ++band)
+        {
+            const double centre = bandCentres[band] / binWidth;
+            const int first = juce::jlimit (1, nyquistBin, static_cast<int> (std::floor (centre / juce::MathConstants<double>::sqrt2)));
+            const int last = juce::jlimit (first, nyquistBin, static_cast<int> (std::ceil (centre * juce::MathConstants<double>::sqrt2)));
+
+            double power = 0.0;
+            for (int bin = first; bin <= last; ++bin)
+                power += static_cast<double> (spectrum[bin * 2]) * spectrum[bin * 2]
+                       + static_cast<double> (spectrum[bin * 2 + 1]) * spectrum[bin * 2 + 1];
+
+            // One-sided Parseval, corrected for the window energy
+            const float rmsLevel = static_cast<float> (std::sqrt (2.0 * power / (frameSize * windowPower)));
+            const float peakLevel = rmsLevel * juce::MathConstants<float>::sqrt2;
+
+            // 70% peak (fast/dramatic) + 30% RMS (smooth/stable)
+            result[band] = peakLevel * 0.7f + rmsLevel * 0.3f;
+        }
+    }
+
+    //==============================================================================
+    static constexpr std::array<float, numBands> bandCentres = {
+        31.0f, 62.0f, 125.0f, 250.0f, 500.0f,
+        1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f
+    };
+
+    // Per analysis tick (~30 Hz)
+    static constexpr float attackCoeff = 0.5f;
+    static constexpr float releaseCoeff = 0.85f;
+
+    juce::AbstractFifo fifo;
+    std::vector<float> fifoBuffer;
+
+    std::atomic<bool> active { false };
+    std::atomic<double> sampleRate { 44100.0 };
+    std::atomic<int> decimation { 8 };
+
+    // Audio thread only
+    int skipRemaining = 0;
+    int captureRemaining = 0;
+
+    std::array<std::atomic<float>, numBands> levels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BandActivityMeter)
+};
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <vector>
+
+/**
+ * Biquad Cascade
+ *
+ * Packed multichannel cascade of second-order sections. Channels are
+ * interleaved into SIMD lanes (juce::dsp::SIMDRegister), so four (SSE/NEON)
+ * or eight (AVX) channels are filtered for the cost of one. Every active
+ * section runs in a single pass per sample frame, so the block is walked once
+ * however many sections are enabled.
+ *
+ * Sections are transposed direct form II, matching juce::dsp::IIR::Filter.
+ * Any channel count is supported; channels beyond one register are processed
+ * as further lane groups.
+ *
+ * Coefficients are designed by the caller (message thread) and handed over
+ * with setTarget(). The audio thread picks them up without blocking and
+ * interpolates every coefficient per sample over the ramp length, so moving
+ * a band does not click. Sections fade in from and out to an identity
+ * section. The stable region of (a1, a2) is convex, so every intermediate
+ * section between two stable designs is itself stable.
+ */
+class BiquadCascade
+{
+public:
+    static constexpr int maxSections = 16;
+
+    BiquadCascade() = default;
+
+    //==============================================================================
+    /** Allocates state and interleave scratch. Not real-time safe. */
+    void prepare (int newNumChannels, int newMaxBlockSize)
+    {
+        numChannels = juce::jmax (1, newNumChannels);
+        maxBlockSize = juce::jmax (1, newMaxBlockSize);
+        numGroups = (numChannels + lanes - 1) / lanes;
+
+        states.assign (static_cast<size_t> (numGroups * maxSections), SectionState());
+        frames.assign (static_cast<size_t> (maxBlockSize), broadcast (0.0f));
+
+        reset();
+    }
+
+    /** Clears the filter state; the next pending targets are applied without a ramp */
+    void reset()
+    {
+        std::fill (states.begin(), states.end(), SectionState());
+        hasProcessed = false;
+    }
+
+    /** Length of the coefficient interpolation, in samples (0 = switch at block start) */
+    void setRampLength (int samples) { rampLength = juce::jmax (0, samples); }
+
+    //==============================================================================
+    /**
+     * Hands new coefficients for a section to the audio thread (thread safe,
+     * never blocks processing). First- and second-order designs are accepted.
+     */
+    void setTarget (int index, const juce::dsp::IIR::Coefficients<float>& coefficients, bool active)
+    {
+        if (!juce::isPositiveAndBelow (index, maxSections))
+            return;
+
+        const auto raw = toRaw (coefficients);
+
+        const juce::SpinLock::ScopedLockType lock (pendingLock);
+        pendingCoefficients[static_cast<size_t> (index)] = raw;
+        pendingActive[static_cast<size_t> (index)] = active;
+        pendingChanged = true;
+    }
+
+    /** Sections currently running on the audio thread, including ones fading out */
+    int getNumActiveSections() const { return numRunning; }
+    int getNumChannels() const { return numChannels; }
+
+    /** Number of channels sharing one SIMD register */
+    static constexpr int getNumLanes() { return lanes; }
+
+    //==============================================================================
+    /** Filters a block in place. Channels beyond the prepared count are left untouched. */
+    void process (const juce::dsp::AudioBlock<float>& block)
+    {
+        if (states.empty())
+            return;
+
+        collectPendingTargets();
+        hasProcessed = true;
+
+        if (numRunning == 0)
+            return;
+
+        const int channelsToProcess = juce::jmin (static_cast<int> (block.getNumChannels()), numChannels);
+        const int numSamples = static_cast<int> (block.getNumSamples());
+        float* interleaved = reinterpret_cast<float*> (frames.data());
+
+        for (int offset = 0; offset < numSamples;)
+        {
+            int count = juce::jmin (maxBlockSize, numSamples - offset);
+            const bool ramping = rampRemaining > 0;
+
+            // A ramp ends exactly on a chunk boundary, so the targets are hit precisely
+            if (ramping)
+                count = juce::jmin (count, rampRemaining);
+
+            loadChunkCoefficients();
+
+            for (int group = 0; group * lanes < channelsToProcess; ++group)
+            {
+                const int firstChannel = group * lanes;
+                const int lanesUsed = juce::jmin (lanes, channelsToProcess - firstChannel);
+
+                // Interleave: one frame per sample, one lane per channel; spare lanes carry silence
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    if (lane < lanesUsed)
+                    {
+                        const float* source = block.getChannelPointer (static_cast<size_t> (firstChannel + lane)) + offset;
+                        for (int i = 0; i < count; ++i)
+                            interleaved[i * lanes + lane] = source[i];
+                    }
+                    else
+                    {
+                        for (int i = 0; i < count; ++i)
+                            interleaved[i * lanes + lane] = 0.0f;
+                    }
+                }
+
+                // Every lane group starts the chunk from the same coefficients
+                workingCoefficients = chunkCoefficients;
+                SectionState* groupStates = states.data() + group * maxSections;
+
+                if (ramping)
+                    runSections<true> (groupStates, count);
+                else
+                    runSections<false> (groupStates, count);
+
+                for (int lane = 0; lane < lanesUsed; ++lane)
+                {
+                    float* destination = block.getChannelPointer (static_cast<size_t> (firstChannel + lane)) + offset;
+                    for (int i = 0; i < count; ++i)
+                        destination[i] = interleaved[i * lanes + lane];
+                }
+            }
+
+            if (ramping)
+                advanceRamp (count);
+
+            offset += count;
+        }
+    }
+
+private:
+    //==============================================================================
+   #if JUCE_USE_SIMD
+    using Vector = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = static_cast<int> (Vector::SIMDNumElements);
+    static Vector broadcast (float value) { return Vector::expand (value); }
+   #else
+    using Vector = float;
+    static constexpr int lanes = 1;
+    static Vector broadcast (float value) { return value; }
+   #endif
+
+    /** Normalised coefficients; the default is the identity section */
+    struct RawCoefficients
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+
+    struct Section
+    {
+        Vector b0, b1, b2, a1, a2;
+    };
+
+    struct SectionState
+    {
+        Vector s1 = broadcast (0.0f), s2 = broadcast (0.0f);
+    };
+
+    static RawCoefficients toRaw (const juce::dsp::IIR::Coefficients<float>& coefficients)
+    {
+        const float* c = coefficients.getRawCoefficients();
+        const bool secondOrder = coefficients.getFilterOrder() >= 2;
+
+        // Raw layout: [b0, b1, b2, a1, a2] for biquads, [b0, b1, a1] for first order
+        RawCoefficients raw;
+        raw.b0 = c[0];
+        raw.b1 = c[1];
+        raw.b2 = secondOrder ? c[2] : 0.0f;
+        raw.a1 = secondOrder ? c[3] : c[2];
+        raw.a2 = secondOrder ? c[4] : 0.0f;
+        return raw;
+    }
+
+    //==============================================================================
+    /** Audio thread: takes the latest targets if the message thread is not mid-update */
+    void collectPendingTargets()
+    {
+        std::array<RawCoefficients, maxSections> newTargets;
+        std::array<bool, maxSections> newActive;
+
+        {
+            const juce::SpinLock::ScopedTryLockType lock (pendingLock);
+
+            if (!lock.isLocked() || !pendingChanged)
+                return;
+
+            newTargets = pendingCoefficients;
+            newActive = pendingActive;
+            pendingChanged = false;
+        }
+
+        const bool snap = !hasProcessed || rampLength == 0;
+
+        for (size_t i = 0; i < static_cast<size_t> (maxSections); ++i)
+        {
+            targetActive[i] = newActive[i];
+            target[i] = newActive[i] ? newTargets[i] : RawCoefficients();
+
+            // Newly enabled sections start from identity with cleared state
+            if (newActive[i] && !running[i])
+            {
+                current[i] = RawCoefficients();
+                for (int group = 0; group < numGroups; ++group)
+                    states[static_cast<size_t> (group * maxSections) + i] = SectionState();
+            }
+
+            running[i] = running[i] || newActive[i];
+
+            const float scale = snap ? 0.0f : 1.0f / static_cast<float> (rampLength);
+            delta[i].b0 = (target[i].b0 - current[i].b0) * scale;
+            delta[i].b1 = (target[i].b1 - current[i].b1) * scale;
+            delta[i].b2 = (target[i].b2 - current[i].b2) * scale;
+            delta[i].a1 = (target[i].a1 - current[i].a1) * scale;
+            delta[i].a2 = (target[i].a2 - current[i].a2) * scale;
+        }
+
+        if (snap)
+            finishRamp();
+        else
+            rampRemaining = rampLength;
+
+        rebuildRunningList();
+    }
+
+    void advanceRamp (int count)
+    {
+        rampRemaining -= count;
+
+        if (rampRemaining <= 0)
+        {
+            finishRamp();
+            rebuildRunningList();
+            return;
+        }
+
+        // Recomputed from the target, so rounding does not accumulate across chunks
+        const float remaining = static_cast<float> (rampRemaining);
+        for (size_t i = 0; i < static_cast<size_t> (maxSections); ++i)
+        {
+            if (!running[i])
+                continue;
+
+            current[i].b0 = target[i].b0 - delta[i].b0 * remaining;
+            current[i].b1 = target[i].b1 - delta[i].b1 * remaining;
+            current[i].b2 = target[i].b2 - delta[i].b2 * remaining;
+            current[i].a1 = target[i].a1 - delta[i].a1 * remaining;
+            current[i].a2 = target[i].a2 - delta[i].a2 * remaining;
+        }
+    }
+
+    void finishRamp()
+    {
+        rampRemaining = 0;
+        current = target;
+        running = targetActive;
+    }
+
+    void rebuildRunningList()
+    {
+        numRunning = 0;
+        for (int i = 0; i < maxSections; ++i)
+            if (running[static_cast<size_t> (i)])
+                runningSections[static_cast<size_t> (numRunning++)] = i;
+    }
+
+    /** Broadcasts the running sections' coefficients (and per-sample steps) for one chunk */
+    void loadChunkCoefficients()
+    {
+        for (int k = 0; k < numRunning; ++k)
+        {
+            const auto index = static_cast<size_t> (runningSections[static_cast<size_t> (k)]);
+            const auto& c = current[index];
+            const auto& d = delta[index];
+
+            chunkCoefficients[static_cast<size_t> (k)] = { broadcast (c.b0), broadcast (c.b1), broadcast (c.b2),
+                                                           broadcast (c.a1), broadcast (c.a2) };
+            chunkDeltas[static_cast<size_t> (k)] = { broadcast (d.b0), broadcast (d.b1), broadcast (d.b2),
+                                                     broadcast (d.a1), broadcast (d.a2) };
+        }
+    }
+
+    /** All running sections per frame: the frame stays in a register across the cascade */
+    template <bool ramping>
+    void runSections (SectionState* groupStates, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            Vector x = frames[static_cast<size_t> (i)];
+
+            for (int k = 0; k < numRunning; ++k)
+            {
+                auto& c = workingCoefficients[static_cast<size_t> (k)];
+                auto& state = groupStates[runningSections[static_cast<size_t> (k)]];
+
+                const Vector y = c.b0 * x + state.s1;
+                state.s1 = c.b1 * x - c.a1 * y + state.s2;
+                state.s2 = c.b2 * x - c.a2 * y;
+                x = y;
+
+                if constexpr (ramping)
+                {
+                    const auto& d = chunkDeltas[static_cast<size_t> (k)];
+                    c.b0 = c.b0 + d.b0;
+                    c.b1 = c.b1 + d.b1;
+                    c.b2 = c.b2 + d.b2;
+                    c.a1 = c.a1 + d.a1;
+                    c.a2 = c.a2 + d.a2;
+                }
+            }
+
+            frames[static_cast<size_t> (i)] = x;
+        }
+    }
+
+    //==============================================================================
+    // Message thread -> audio thread handoff (guarded by pendingLock)
+    juce::SpinLock pendingLock;
+    std::array<RawCoefficients, maxSections> pendingCoefficients {};
+    std::array<bool, maxSections> pendingActive {};
+    bool pendingChanged = false;
+
+    // Audio thread only
+    std::array<RawCoefficients, maxSections> current {}, target {}, delta {};
+    std::array<bool, maxSections> running {}, targetActive {};
+    std::array<int, maxSections> runningSections {};
+    int numRunning = 0;
+    int rampLength = 0;
+    int rampRemaining = 0;
+    bool hasProcessed = false;
+
+    std::array<Section, maxSections> chunkCoefficients, chunkDeltas, workingCoefficients;
+
+    int numChannels = 0;
+    int numGroups = 0;
+    int maxBlockSize = 0;
+
+    std::vector<SectionState> states;  // [group][section]
+    std::vector<Vector> frames;        // Interleaved scratch, one register per sample frame
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BiquadCascade)
+};
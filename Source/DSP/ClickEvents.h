@@ -0,0 +1,391 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+/**
+ * Click Events
+ *
+ * Two containers for detected clicks, one per use case:
+ *
+ * - ClickEventQueue: bounded, lock-free single-producer/single-consumer queue
+ *   (juce::AbstractFifo). The audio thread pushes without allocating; the
+ *   message thread drains it for live display. Events are dropped when full.
+ *
+ * - ClickStore: compact structure-of-arrays store for offline scans. Positions
+ *   are delta-encoded against a per-group base (32-bit offsets), widths are
+ *   16-bit, and the manual/applied flags share one byte - about 11 bytes per
+ *   click instead of 24 for an array of structs. CorrectionListView and
+ *   WaveformDisplay read the same store without copying it.
+ */
+
+//==============================================================================
+/** A single detected or manual click */
+struct ClickEvent
+{
+    int64_t position = 0;   // Sample position in stream
+    float magnitude = 0.0f; // Detected magnitude
+    uint16_t width = 0;     // Width in samples
+    uint8_t channel = 0;    // Channel the click was found in
+    bool isManual = false;  // User-inserted correction
+};
+
+//==============================================================================
+class ClickEventQueue
+{
+public:
+    explicit ClickEventQueue (int capacity = 4096)
+        : fifo (capacity), events (static_cast<size_t> (capacity))
+    {
+    }
+
+    /** Producer side (audio thread). Returns false and counts a drop when full. */
+    bool push (const ClickEvent& event) noexcept
+    {
+        const auto scope = fifo.write (1);
+
+        if (scope.blockSize1 > 0)
+            events[static_cast<size_t> (scope.startIndex1)] = event;
+        else if (scope.blockSize2 > 0)
+            events[static_cast<size_t> (scope.startIndex2)] = event;
+        else
+        {
+            dropped.fetch_add (1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+
+    /** Consumer side (message thread). Calls fn (const ClickEvent&) for every queued event. */
+    template <typename Callback>
+    int popAll (Callback&& fn)
+    {
+        const auto scope = fifo.read (fifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            fn (events[static_cast<size_t> (scope.startIndex1 + i)]);
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            fn (events[static_cast<size_t> (scope.startIndex2 + i)]);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    int getNumReady() const { return fifo.getNumReady(); }
+
+    /** Number of events lost because the consumer fell behind */
+    int getNumDropped() const { return dropped.load (std::memory_order_relaxed); }
+
+    /** Only call while neither side is active */
+    void clear()
+    {
+        fifo.reset();
+        dropped.store (0, std::memory_order_relaxed);
+    }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<ClickEvent> events;
+    std::atomic<int> dropped {0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ClickEventQueue)
+};
+
+//==============================================================================
+class ClickStore
+{
+public:
+    ClickStore() = default;
+    ClickStore (ClickStore&&) = default;
+    ClickStore& operator= (ClickStore&&) = default;
+
+    //==============================================================================
+    void clear()
+    {
+        offsets.clear();
+        groupStarts.clear();
+        groupBases.clear();
+        widths.clear();
+        magnitudes.clear();
+        flags.clear();
+        sorted = true;
+    }
+
+    void reserve (size_t numClicks)
+    {
+        offsets.reserve (numClicks);
+        widths.reserve (numClicks);
+        magnitudes.reserve (numClicks);
+        flags.reserve (numClicks);
+        groupStarts.reserve (numClicks / groupSize + 1);
+        groupBases.reserve (numClicks / groupSize + 1);
+    }
+
+    /** Appends a click. Positions may arrive in any order; see sortByPosition(). */
+    void add (int64_t position, int width, float magnitude, bool isManual, bool isApplied = false)
+    {
+        if (!offsets.empty() && position < getPosition (offsets.size() - 1))
+            sorted = false;
+
+        appendEncoded (position);
+        widths.push_back (static_cast<uint16_t> (juce::jlimit (0, maxWidth, width)));
+        magnitudes.push_back (magnitude);
+        flags.push_back (static_cast<uint8_t> ((isManual ? manualFlag : 0) | (isApplied ? appliedFlag : 0)));
+    }
+
+    void add (const ClickEvent& event)
+    {
+        add (event.position, event.width, event.magnitude, event.isManual);
+    }
+
+    //==============================================================================
+    size_t size() const { return offsets.size(); }
+    bool empty() const { return offsets.empty(); }
+    bool isSorted() const { return sorted; }
+
+    int64_t getPosition (size_t index) const
+    {
+        jassert (index < offsets.size());
+        const size_t group = findGroup (index);
+        return groupBases[group] + offsets[index];
+    }
+
+    int getWidth (size_t index) const { return widths[index]; }
+    float getMagnitude (size_t index) const { return magnitudes[index]; }
+    bool isManual (size_t index) const { return (flags[index] & manualFlag) != 0; }
+    bool isApplied (size_t index) const { return (flags[index] & appliedFlag) != 0; }
+
+    void setApplied (size_t index, bool applied)
+    {
+        flags[index] = static_cast<uint8_t> (applied ? (flags[index] | appliedFlag) : (flags[index] & ~appliedFlag));
+    }
+
+    void markAllApplied()
+    {
+        for (auto& f : flags)
+            f = static_cast<uint8_t> (f | appliedFlag);
+    }
+
+    /** Sequential decode: fn (index, position, width, magnitude, isManual, isApplied) for [first, last) */
+    template <typename Callback>
+    void forEach (size_t first, size_t last, Callback&& fn) const
+    {
+        last = juce::jmin (last, offsets.size());
+        if (first >= last)
+            return;
+
+        size_t group = findGroup (first);
+
+        for (size_t i = first; i < last; ++i)
+        {
+            if (group + 1 < groupStarts.size() && i >= groupStarts[group + 1])
+                ++group;
+
+            fn (i, groupBases[group] + offsets[i], static_cast<int> (widths[i]), magnitudes[i],
+                (flags[i] & manualFlag) != 0, (flags[i] & appliedFlag) != 0);
+        }
+    }
+
+    /** First index with position >= target. Requires a sorted store. */
+    size_t lowerBound (int64_t target) const
+    {
+        jassert (sorted);
+
+        // The first group starting at or after the target; the answer is in the group before it
+        auto groupIt = std::lower_bound (groupBases.begin(), groupBases.end(), target);
+        if (groupIt == groupBases.begin())
+            return 0;
+
+        const size_t group = static_cast<size_t> (std::distance (groupBases.begin(), groupIt)) - 1;
+        const size_t end = group + 1 < groupStarts.size() ? groupStarts[group + 1] : offsets.size();
+
+        for (size_t i = groupStarts[group]; i < end; ++i)
+            if (groupBases[group] + offsets[i] >= target)
+                return i;
+
+        return end;
+    }
+
+    //==============================================================================
+    /** Sorts all columns by position (stable, so equal positions keep their order) */
+    void sortByPosition()
+    {
+        if (sorted)
+            return;
+
+        auto positions = decodePositions();
+        std::vector<size_t> order (positions.size());
+        std::iota (order.begin(), order.end(), size_t (0));
+        std::stable_sort (order.begin(), order.end(),
+                          [&positions] (size_t a, size_t b) { return positions[a] < positions[b]; });
+
+        rebuild (positions, order);
+    }
+
+    /** Inserts at the sorted position and returns the new index; only the groups from it on are re-encoded */
+    size_t insert (int64_t position, int width, float magnitude, bool isManual, bool isApplied = false)
+    {
+        sortByPosition();
+        const size_t index = lowerBound (position);
+        const size_t group = offsets.empty() ? 0 : findGroup (juce::jmin (index, offsets.size() - 1));
+
+        auto tail = truncatePositions (group);
+        const size_t first = offsets.size();
+        tail.insert (tail.begin() + static_cast<std::ptrdiff_t> (index - first), position);
+        widths.insert (widths.begin() + static_cast<std::ptrdiff_t> (index),
+                       static_cast<uint16_t> (juce::jlimit (0, maxWidth, width)));
+        magnitudes.insert (magnitudes.begin() + static_cast<std::ptrdiff_t> (index), magnitude);
+        flags.insert (flags.begin() + static_cast<std::ptrdiff_t> (index),
+                      static_cast<uint8_t> ((isManual ? manualFlag : 0) | (isApplied ? appliedFlag : 0)));
+
+        for (auto p : tail)
+            appendEncoded (p);
+
+        return index;
+    }
+
+    void erase (size_t index)
+    {
+        if (index >= offsets.size())
+            return;
+
+        // Removing an entry keeps the order, so only the groups from it on change
+        auto tail = truncatePositions (findGroup (index));
+        const size_t first = offsets.size();
+        tail.erase (tail.begin() + static_cast<std::ptrdiff_t> (index - first));
+        widths.erase (widths.begin() + static_cast<std::ptrdiff_t> (index));
+        magnitudes.erase (magnitudes.begin() + static_cast<std::ptrdiff_t> (index));
+        flags.erase (flags.begin() + static_cast<std::ptrdiff_t> (index));
+
+        for (auto p : tail)
+            appendEncoded (p);
+    }
+
+    /** Approximate heap usage, for diagnostics */
+    size_t getMemoryUsage() const
+    {
+        return offsets.capacity() * sizeof (int32_t) + widths.capacity() * sizeof (uint16_t)
+             + magnitudes.capacity() * sizeof (float) + flags.capacity()
+             + groupStarts.capacity() * sizeof (size_t) + groupBases.capacity() * sizeof (int64_t);
+    }
+
+private:
+    //==============================================================================
+    static constexpr size_t groupSize = 64;
+    static constexpr int maxWidth = std::numeric_limits<uint16_t>::max();
+    static constexpr uint8_t manualFlag = 1;
+    static constexpr uint8_t appliedFlag = 2;
+
+    size_t findGroup (size_t index) const
+    {
+        // Groups are full-sized unless an offset overflowed, so try the direct slot first
+        const size_t guess = juce::jmin (index / groupSize, groupStarts.size() - 1);
+        if (groupStarts[guess] <= index && (guess + 1 == groupStarts.size() || groupStarts[guess + 1] > index))
+            return guess;
+
+        auto it = std::upper_bound (groupStarts.begin(), groupStarts.end(), index);
+        return static_cast<size_t> (std::distance (groupStarts.begin(), it)) - 1;
+    }
+
+    void appendEncoded (int64_t position)
+    {
+        const size_t index = offsets.size();
+        const bool newGroup = groupStarts.empty()
+                           || index - groupStarts.back() >= groupSize
+                           || std::abs (position - groupBases.back()) > std::numeric_limits<int32_t>::max();
+
+        if (newGroup)
+        {
+            groupStarts.push_back (index);
+            groupBases.push_back (position);
+        }
+
+        offsets.push_back (static_cast<int32_t> (position - groupBases.back()));
+    }
+
+    std::vector<int64_t> decodePositions() const
+    {
+        std::vector<int64_t> positions;
+        positions.reserve (offsets.size());
+        forEach (0, offsets.size(), [&positions] (size_t, int64_t position, int, float, bool, bool)
+        {
+            positions.push_back (position);
+        });
+        return positions;
+    }
+
+    /** Drops the positions of the groups from group on and returns them, decoded */
+    std::vector<int64_t> truncatePositions (size_t group)
+    {
+        if (group >= groupStarts.size())
+            return {};
+
+        const size_t first = groupStarts[group];
+        std::vector<int64_t> tail;
+        tail.reserve (offsets.size() - first);
+        forEach (first, offsets.size(), [&tail] (size_t, int64_t position, int, float, bool, bool)
+        {
+            tail.push_back (position);
+        });
+
+        offsets.resize (first);
+        groupStarts.resize (group);
+        groupBases.resize (group);
+        return tail;
+    }
+
+    void encodePositions (const std::vector<int64_t>& positions)
+    {
+        offsets.clear();
+        groupStarts.clear();
+        groupBases.clear();
+
+        sorted = true;
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            if (i > 0 && positions[i] < positions[i - 1])
+                sorted = false;
+
+            appendEncoded (positions[i]);
+        }
+    }
+
+    void rebuild (const std::vector<int64_t>& positions, const std::vector<size_t>& order)
+    {
+        std::vector<int64_t> newPositions (order.size());
+        std::vector<uint16_t> newWidths (order.size());
+        std::vector<float> newMagnitudes (order.size());
+        std::vector<uint8_t> newFlags (order.size());
+
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            newPositions[i] = positions[order[i]];
+            newWidths[i] = widths[order[i]];
+            newMagnitudes[i] = magnitudes[order[i]];
+            newFlags[i] = flags[order[i]];
+        }
+
+        widths = std::move (newWidths);
+        magnitudes = std::move (newMagnitudes);
+        flags = std::move (newFlags);
+        encodePositions (newPositions);
+    }
+
+    //==============================================================================
+    std::vector<int32_t> offsets;     // Position relative to the group base
+    std::vector<size_t> groupStarts;  // First index of each group
+    std::vector<int64_t> groupBases;  // Absolute position of each group's first entry
+    std::vector<uint16_t> widths;
+    std::vector<float> magnitudes;
+    std::vector<uint8_t> flags;
+    bool sorted = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ClickStore)
+};
@@ -2,7 +2,13 @@
 
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_basics/juce_audio_basics.h>
+#include "ClickEvents.h"
+#include <algorithm>
 #include <atomic>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
 
 /**
  * Click and Pop Removal Processor
@@ -13,20 +19,20 @@
  * 3. Automatic detection with adjustable sensitivity
  *
  * Based on Wave Corrector's approach combined with manual crossfade technique.
+ *
+ * Detection is two-pass: a vectorised second-derivative residual is built for
+ * everything that became scannable, then only segments whose peak residual
+ * exceeds the running-RMS threshold are scanned sample by sample. Each channel
+ * keeps getLatencySamples() of carry-over so clicks across block boundaries
+ * are detected once, with the same result for any block size.
+ *
+ * Detected clicks go to a lock-free ClickEventQueue for live display (audio
+ * thread safe) and, when storing is enabled, to a compact ClickStore for
+ * offline scans.
  */
 class ClickRemoval
 {
 public:
-    //==============================================================================
-    /** Information about a detected or manual click correction */
-    struct ClickInfo
-    {
-        int64_t position = 0;       // Sample position in stream
-        int width = 0;              // Width in samples
-        float magnitude = 0.0f;     // Detected magnitude
-        bool isManual = false;      // User-inserted correction
-    };
-
     ClickRemoval() = default;
 
     //==============================================================================
@@ -35,7 +41,9 @@ public:
     {
         sampleRate = spec.sampleRate;
         numChannels = spec.numChannels;
+        maxBlockSize = static_cast<int> (juce::jmax (1u, spec.maximumBlockSize));
 
+        allocateStreamBuffers();
         reset();
     }
 
@@ -44,11 +52,18 @@ public:
     {
         detectedClicks.clear();
         currentSamplePosition = 0;
+        resetStream();
     }
 
-    /** Enable/disable storing detected clicks (for GUI display) */
+    /** Delay between input and output, in samples (lookahead plus repair history) */
+    int getLatencySamples() const { return latencySamples; }
+
+    /** Enable/disable storing detected clicks (offline scans; allocates) */
     void setStoreDetectedClicks (bool store) { storeDetectedClicks = store; }
 
+    /** Enable/disable pushing detected clicks to the live event queue (real-time safe) */
+    void setPublishLiveEvents (bool publish) { publishLiveEvents.store (publish, std::memory_order_relaxed); }
+
     /** Enable/disable applying click removal (false = detection only) */
     void setApplyRemoval (bool apply) { applyRemoval = apply; }
 
@@ -58,22 +73,116 @@ public:
     /** Set sample offset for selection-based detection */
     void setSampleOffset (int64_t offset) { currentSamplePosition = offset; }
 
-    /** Process audio block */
+    /**
+     * Offline helpers only: called with (position, numSamples) before a repair
+     * changes those samples of the region, positions relative to the sample
+     * offset as for clicks. Lets a caller save just the repaired samples for undo.
+     */
+    void setBeforeRepairCallback (std::function<void (int64_t, int)> callback) { beforeRepair = std::move (callback); }
+
+    /** Process audio block (output is delayed by getLatencySamples()) */
     void process (juce::dsp::ProcessContextReplacing<float>& context)
     {
         auto& inputBlock = context.getInputBlock();
         auto& outputBlock = context.getOutputBlock();
 
-        // TODO: Implement click detection and removal
-        // For now, just pass through
-        outputBlock.copyFrom (inputBlock);
+        if (context.usesSeparateInputAndOutputBlocks())
+            outputBlock.copyFrom (inputBlock);
 
-        if (sensitivity > 0.0f)
+        const int numSamples = static_cast<int> (outputBlock.getNumSamples());
+        const int channelsToProcess = juce::jmin (static_cast<int> (outputBlock.getNumChannels()),
+                                                  static_cast<int> (channelStates.size()));
+        int clicksThisBlock = 0;
+
+        for (int offset = 0; offset < numSamples; offset += maxBlockSize)
+        {
+            const int count = juce::jmin (maxBlockSize, numSamples - offset);
+
+            for (int channel = 0; channel < channelsToProcess; ++channel)
+            {
+                float* channelData = outputBlock.getChannelPointer (static_cast<size_t> (channel)) + offset;
+                clicksThisBlock += processChannel (channelStates[static_cast<size_t> (channel)], channelData, count, channel);
+            }
+
+            streamPosition += count;
+            currentSamplePosition += count;
+        }
+
+        // Update activity metrics for visual feedback
+        clicksDetectedLastBlock.store (clicksThisBlock);
+
+        if (sampleRate > 0 && numSamples > 0)
         {
-            detectAndRemoveClicks (outputBlock);
+            float blockDuration = static_cast<float> (numSamples) / static_cast<float> (sampleRate);
+            clickRatePerSecond.store (clicksThisBlock / blockDuration);
         }
     }
 
+    /**
+     * Offline helper: processes a region of a buffer in place with the lookahead
+     * latency compensated. Detected positions are reported relative to the
+     * current sample offset. The optional callback receives progress (0-1) and
+     * returns false to cancel. Returns the number of clicks detected.
+     *
+     * A click detected just before the end is repaired whole: its repair may
+     * write up to half the maximum click width past the region.
+     */
+    int processBufferRegion (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                             std::function<bool (double)> progressCallback = nullptr)
+    {
+        return scanBufferRegion (buffer, &buffer, startSample, numSamples, startSample, std::move (progressCallback));
+    }
+
+    /**
+     * processBufferRegion() over [contextStart, endSample) that only writes
+     * and reports repairs from startSample on. The samples before it are
+     * scanned as context, so the running level and click skips at startSample
+     * are those of a scan from contextStart, and concurrent repairs of
+     * neighbouring regions never write into each other's context. A click
+     * straddling endSample is this region's to repair, past endSample too, so
+     * the next region never starts from a half-repaired click.
+     */
+    int processBufferRegionFrom (juce::AudioBuffer<float>& buffer, int contextStart, int startSample, int endSample,
+                                 std::function<bool (double)> progressCallback = nullptr)
+    {
+        return scanBufferRegion (buffer, &buffer, contextStart, endSample - contextStart, startSample,
+                                 std::move (progressCallback));
+    }
+
+    /**
+     * Detection only version of processBufferRegion() for a buffer that must
+     * not be written, e.g. one of several concurrent scans of the same audio.
+     * Removal must be disabled.
+     */
+    int detectBufferRegion (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                            std::function<bool (double)> progressCallback = nullptr)
+    {
+        jassert (!applyRemoval);
+        return scanBufferRegion (buffer, nullptr, startSample, numSamples, startSample, std::move (progressCallback));
+    }
+
+    /**
+     * Offline streaming: starts a stream whose first numSamples inputs are a
+     * region, so process() treats anything fed after them as silence, as
+     * processBufferRegion() does. Feed getLatencySamples() of zeros after the
+     * region to flush it.
+     */
+    void beginRegionStream (int64_t numSamples)
+    {
+        resetStream();
+        scanLimit = juce::jmax (static_cast<int64_t> (0), numSamples);
+    }
+
+    /**
+     * Live streaming: ends the stream at what has been fed so far, so anything
+     * fed after is treated as silence. Feed getLatencySamples() of zeros after
+     * it to flush the clicks near the end.
+     */
+    void endStream()
+    {
+        scanLimit = streamPosition;
+    }
+
     //==============================================================================
     /** Set click detection sensitivity (0-100) */
     void setSensitivity (float newSensitivity)
@@ -84,7 +193,14 @@ public:
     /** Set maximum width for click correction in samples */
     void setMaxWidth (int samples)
     {
-        maxClickWidth = samples;
+        maxClickWidth = juce::jmax (1, samples);
+
+        // The carry-over covers the widest repair, so the latency follows the width
+        if (!channelStates.empty())
+        {
+            allocateStreamBuffers();
+            resetStream();
+        }
     }
 
     /** Set removal method */
@@ -104,124 +220,445 @@ public:
     /** Manually mark a click for removal (for GUI/standalone mode) */
     void addManualClick (int64_t samplePosition, int width)
     {
-        ClickInfo click;
-        click.position = samplePosition;
-        click.width = width;
-        click.isManual = true;
-        detectedClicks.push_back (click);
+        detectedClicks.add (samplePosition, width, 0.0f, true);
     }
 
-    /** Get list of detected clicks (for GUI display) */
-    const std::vector<ClickInfo>& getDetectedClicks() const
+    /** Get stored clicks (offline scans; not for use while processing) */
+    const ClickStore& getDetectedClicks() const
     {
         return detectedClicks;
     }
 
+    /** Moves the stored clicks out, sorted by position */
+    ClickStore takeDetectedClicks()
+    {
+        detectedClicks.sortByPosition();
+        ClickStore result (std::move (detectedClicks));
+        detectedClicks.clear();
+        return result;
+    }
+
+    /** Live click events, drained by the message thread */
+    ClickEventQueue& getEventQueue() { return eventQueue; }
+
     /** Get activity metrics for visual feedback */
     int getClicksDetectedLastBlock() const { return clicksDetectedLastBlock.load(); }
     float getClickRate() const { return clickRatePerSecond.load(); }
 
-private:
+    /** Position the next reported click is relative to */
+    int64_t getSampleOffset() const { return currentSamplePosition; }
+
+    /** Channels prepared for */
+    int getNumChannels() const { return static_cast<int> (channelStates.size()); }
 
     //==============================================================================
-    void detectAndRemoveClicks (juce::dsp::AudioBlock<float>& block)
+    /**
+     * Bulk detection support, for scanners that find the threshold crossings of a
+     * whole region at once (GPUClickDetector). The running RMS is kept per
+     * getRmsSegmentSize() samples: computeSegmentRms() turns each segment's sum of
+     * squares into the level the streaming scan uses, and getDetectionThreshold()
+     * the threshold for it. A sample is a candidate when its second-derivative
+     * residual |x[i] - 2 x[i-1] + x[i-2]| exceeds its segment's threshold.
+     */
+    static constexpr int getRmsSegmentSize() { return rmsSegmentSize; }
+
+    static void computeSegmentRms (const float* segmentEnergies, size_t numSegments, float* segmentRms)
     {
-        // Improved click detection algorithm based on Wave Corrector approach
-        // Uses first and second derivative analysis with adaptive thresholding
+        // The same recurrence as updateRunningRms(), so the levels match bit for bit
+        float window[rmsWindowSegments] = {};
+        double windowEnergy = 0.0;
 
-        int clicksThisBlock = 0;
+        for (size_t segment = 0; segment < numSegments; ++segment)
+        {
+            auto& oldest = window[segment % rmsWindowSegments];
+            windowEnergy += static_cast<double> (segmentEnergies[segment]) - static_cast<double> (oldest);
+            oldest = segmentEnergies[segment];
+
+            const int64_t segmentsInWindow = juce::jmin (static_cast<int64_t> (segment) + 1, static_cast<int64_t> (rmsWindowSegments));
+            const double meanSquare = juce::jmax (0.0, windowEnergy) / static_cast<double> (segmentsInWindow * rmsSegmentSize);
+            segmentRms[segment] = static_cast<float> (std::sqrt (meanSquare));
+        }
+    }
 
-        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    float getDetectionThreshold (float rmsLevel) { return calculateThreshold (rmsLevel); }
+
+    /**
+     * Verifies sorted candidate positions in samples[0, numSamples) the way the
+     * streaming scan tests each sample: peak search, periodicity and width checks,
+     * then the skip past an accepted click. Samples up to numAvailable are read as
+     * context and everything else counts as silence, as in processBufferRegion(),
+     * so detection-only results are identical to it. With removal enabled, each
+     * click is repaired in place (never beyond numSamples) and the samples its
+     * repair touched are tested again; the levels stay those of the unrepaired
+     * audio. Clicks are stored and published as set, relative to the sample
+     * offset, which is left unchanged. Returns the number of clicks.
+     */
+    int verifyCandidates (float* samples, int numSamples, int numAvailable, const std::vector<int>& candidates,
+                          const std::vector<float>& segmentRms, int channel)
+    {
+        if (sensitivity <= 0.0f || numSamples <= 0 || latencySamples <= 0)
+            return 0;
+
+        // Far enough either way for the residual, peak and width searches and a repair
+        const int reach = latencySamples;
+        const int windowLength = 2 * reach + 1;
+        numAvailable = juce::jmax (numSamples, numAvailable);
+
+        int clicksFound = 0;
+        int retestEnd = 0; // A repair changed the residual up to here
+        auto nextCandidate = candidates.begin();
+        int i = edgeGuardSamples;
+
+        while (i < numSamples)
         {
-            auto* channelData = block.getChannelPointer (channel);
-            auto numSamples = block.getNumSamples();
+            if (i >= retestEnd)
+            {
+                nextCandidate = std::lower_bound (nextCandidate, candidates.end(), i);
+                if (nextCandidate == candidates.end())
+                    break;
+
+                i = *nextCandidate;
+                if (i >= numSamples)
+                    break;
+            }
+
+            // Near either end, work on a copy padded the way the stream sees it
+            const bool nearEdge = i < reach || i + reach >= numSamples;
+            float* data = samples + i - reach;
+
+            if (nearEdge)
+            {
+                edgeWindow.resize (static_cast<size_t> (windowLength));
+
+                for (int k = 0; k < windowLength; ++k)
+                {
+                    const int source = i - reach + k;
+                    edgeWindow[static_cast<size_t> (k)] = (source >= 0 && source < numAvailable) ? samples[source] : 0.0f;
+                }
+
+                data = edgeWindow.data();
+            }
 
-            if (numSamples < 10)
+            const float rmsLevel = segmentRms[static_cast<size_t> (i / rmsSegmentSize)];
+            const float adaptiveThreshold = calculateThreshold (rmsLevel);
+            const float secondDeriv = residualAt (data, reach);
+
+            if (secondDeriv <= adaptiveThreshold)
+            {
+                ++i;
                 continue;
+            }
 
-            // Calculate RMS level for adaptive threshold
-            float rmsLevel = calculateRMS (channelData, numSamples);
-            float adaptiveThreshold = calculateThreshold (rmsLevel);
+            int peakPos = reach;
+            float maxDeriv = secondDeriv;
+            for (int j = reach + 1; j < reach + peakSearchLength; ++j)
+            {
+                const float value = residualAt (data, j);
+                if (value > maxDeriv)
+                {
+                    maxDeriv = value;
+                    peakPos = j;
+                }
+            }
+            i += peakPos - reach;
 
-            // Scan for clicks using derivative analysis
-            for (size_t i = 4; i < numSamples - 4; ++i)
+            if (isPeriodic (data, peakPos, static_cast<size_t> (windowLength), rmsLevel))
             {
-                // Calculate second derivative (acceleration)
-                float secondDeriv = std::abs (channelData[i] - 2.0f * channelData[i - 1] + channelData[i - 2]);
+                ++i;
+                continue;
+            }
 
-                // Click detection: sharp discontinuity in second derivative
-                if (secondDeriv > adaptiveThreshold)
+            const int clickWidth = estimateClickWidth (data, peakPos, static_cast<size_t> (windowLength));
+
+            if (clickWidth <= 0 || clickWidth > maxClickWidth)
+            {
+                ++i;
+                continue;
+            }
+
+            ClickEvent event;
+            event.position = currentSamplePosition + i;
+            event.width = static_cast<uint16_t> (clickWidth);
+            event.magnitude = secondDeriv / adaptiveThreshold;
+            event.channel = static_cast<uint8_t> (channel);
+
+            if (publishLiveEvents.load (std::memory_order_relaxed))
+                eventQueue.push (event);
+
+            if (storeDetectedClicks)
+                detectedClicks.add (event);
+
+            if (applyRemoval)
+            {
+                if (beforeRepair != nullptr)
                 {
-                    // Look ahead a few samples to find the actual peak of the transient
-                    size_t peakPos = i;
-                    float maxDeriv = secondDeriv;
-                    for (size_t j = i + 1; j < juce::jmin(i + 5, numSamples - 4); ++j)
-                    {
-                        float d = std::abs (channelData[j] - 2.0f * channelData[j - 1] + channelData[j - 2]);
-                        if (d > maxDeriv)
-                        {
-                            maxDeriv = d;
-                            peakPos = j;
-                        }
-                    }
-                    i = peakPos;
+                    // Both repair methods stay within this far of the peak
+                    const int repairReach = getRepairReach (clickWidth);
+                    const int repairStart = juce::jmax (0, i - repairReach);
+                    const int repairEnd = juce::jmin (numSamples, i + repairReach + 1);
+
+                    if (repairEnd > repairStart)
+                        beforeRepair (currentSamplePosition + repairStart, repairEnd - repairStart);
+                }
+
+                removeClickAt (data, peakPos, clickWidth, static_cast<size_t> (windowLength));
 
-                    // Check if this is not part of periodic signal (music)
-                    if (!isPeriodic (channelData, static_cast<int> (i), numSamples, rmsLevel))
+                if (nearEdge)
+                {
+                    const int peakStart = i - peakPos;
+
+                    for (int k = 0; k < windowLength; ++k)
                     {
-                        // Estimate click width by finding where signal stabilizes
-                        int clickWidth = estimateClickWidth (channelData, static_cast<int> (i), numSamples);
-
-                        if (clickWidth > 0 && clickWidth <= maxClickWidth)
-                        {
-                            // Store detected click info (for GUI display)
-                            if (storeDetectedClicks)
-                            {
-                                ClickInfo clickInfo;
-                                clickInfo.position = currentSamplePosition + static_cast<int64_t>(i);
-                                clickInfo.width = clickWidth;
-                                clickInfo.magnitude = secondDeriv / adaptiveThreshold;
-                                clickInfo.isManual = false;
-                                detectedClicks.push_back (clickInfo);
-                            }
-
-                            // Apply removal if enabled
-                            if (applyRemoval)
-                            {
-                                removeClickAt (channelData, static_cast<int> (i), clickWidth, numSamples);
-                            }
-
-                            // Count detected click
-                            clicksThisBlock++;
-
-                            // Skip ahead to avoid re-detecting same click
-                            i += clickWidth;
-                        }
+                        const int target = peakStart + k;
+                        if (target >= 0 && target < numSamples)
+                            samples[target] = edgeWindow[static_cast<size_t> (k)];
                     }
                 }
+
+                retestEnd = juce::jmax (retestEnd, i + reach);
             }
+
+            ++clicksFound;
+            i += clickWidth + 1;
         }
 
-        // Update sample position for next block
-        currentSamplePosition += static_cast<int64_t>(block.getNumSamples());
+        return clicksFound;
+    }
 
-        // Update activity metrics for visual feedback
-        clicksDetectedLastBlock.store (clicksThisBlock);
+private:
+
+    //==============================================================================
+    /** Per-channel carry-over: the last latencySamples of input, not yet output */
+    struct ChannelState
+    {
+        std::vector<float> work;            // [pending (latencySamples) | incoming block]
+        std::vector<float> segmentRms;      // RMS per rmsSegmentSize samples, ring indexed by segment
+        std::vector<float> segmentEnergies; // Last rmsWindowSegments segment energies
+        double windowEnergy = 0.0;
+        int64_t completedSegments = 0;
+        int64_t nextScanPosition = 0;       // Stream index; may lie ahead after skipping a click
+    };
+
+    void allocateStreamBuffers()
+    {
+        // Widest repair reach: spline half-length + control point margin, or crossfade length
+        const int repairReach = juce::jmax (maxClickWidth / 2, 16) + 5;
+        lookaheadSamples = juce::jmax (repairReach, maxWidthSearch, periodicCheckRange) + peakSearchLength + 2;
+        historySamples = juce::jmax (repairReach, maxWidthSearch) + 3;
+        latencySamples = lookaheadSamples + historySamples;
+
+        const size_t workSize = static_cast<size_t> (latencySamples + maxBlockSize);
+        const size_t rmsRingSize = static_cast<size_t> ((latencySamples + maxBlockSize) / rmsSegmentSize + 4);
+
+        channelStates.resize (numChannels);
+        for (auto& state : channelStates)
+        {
+            state.work.assign (workSize, 0.0f);
+            state.segmentRms.assign (rmsRingSize, 0.0f);
+            state.segmentEnergies.assign (static_cast<size_t> (rmsWindowSegments), 0.0f);
+        }
+
+        residual.assign (workSize, 0.0f);
+        differences.assign (workSize, 0.0f);
+    }
 
-        // Calculate clicks per second (assuming reasonable block size)
-        if (sampleRate > 0 && block.getNumSamples() > 0)
+    void resetStream()
+    {
+        for (auto& state : channelStates)
         {
-            float blockDuration = static_cast<float> (block.getNumSamples()) / static_cast<float> (sampleRate);
-            clickRatePerSecond.store (blockDuration > 0 ? clicksThisBlock / blockDuration : 0.0f);
+            std::fill (state.work.begin(), state.work.end(), 0.0f);
+            std::fill (state.segmentRms.begin(), state.segmentRms.end(), 0.0f);
+            std::fill (state.segmentEnergies.begin(), state.segmentEnergies.end(), 0.0f);
+            state.windowEnergy = 0.0;
+            state.completedSegments = 0;
+            state.nextScanPosition = edgeGuardSamples;
         }
+
+        streamPosition = 0;
+        scanLimit = std::numeric_limits<int64_t>::max();
+        repairedEnd = 0;
     }
 
-    float calculateRMS (const float* data, size_t numSamples)
+    /** How far either side of a click's peak its repair writes (crossfade half-length, or half the spline) */
+    static int getRepairReach (int clickWidth) { return juce::jmax (clickWidth / 2, 16); }
+
+    /** Appends a block to the carry-over, scans what became scannable and emits the delayed output */
+    int processChannel (ChannelState& state, float* channelData, int numSamples, int channel)
     {
-        float sum = 0.0f;
-        for (size_t i = 0; i < numSamples; ++i)
-            sum += data[i] * data[i];
-        return std::sqrt (sum / static_cast<float> (numSamples));
+        float* work = state.work.data();
+        const int workLength = latencySamples + numSamples;
+
+        // Stream index of work[0]
+        const int64_t workOrigin = streamPosition - latencySamples;
+
+        juce::FloatVectorOperations::copy (work + latencySamples, channelData, numSamples);
+        updateRunningRms (state, work, workOrigin, streamPosition + numSamples);
+
+        int clicksFound = 0;
+        if (sensitivity > 0.0f)
+            clicksFound = detectAndRemoveClicks (state, work, workLength, workOrigin, numSamples, channel);
+
+        // Emit the oldest samples and keep the rest as carry-over
+        juce::FloatVectorOperations::copy (channelData, work, numSamples);
+        std::memmove (work, work + numSamples, sizeof (float) * static_cast<size_t> (latencySamples));
+
+        return clicksFound;
+    }
+
+    /** Accumulates segment energies for every segment completed by the new samples */
+    void updateRunningRms (ChannelState& state, const float* work, int64_t workOrigin, int64_t streamEnd)
+    {
+        while ((state.completedSegments + 1) * rmsSegmentSize <= streamEnd)
+        {
+            const int64_t segment = state.completedSegments;
+            const float* segmentData = work + (segment * rmsSegmentSize - workOrigin);
+
+            float energy = 0.0f;
+            for (int i = 0; i < rmsSegmentSize; ++i)
+                energy += segmentData[i] * segmentData[i];
+
+            auto& oldest = state.segmentEnergies[static_cast<size_t> (segment % rmsWindowSegments)];
+            state.windowEnergy += static_cast<double> (energy) - static_cast<double> (oldest);
+            oldest = energy;
+
+            const int64_t segmentsInWindow = juce::jmin (segment + 1, static_cast<int64_t> (rmsWindowSegments));
+            const double meanSquare = juce::jmax (0.0, state.windowEnergy) / static_cast<double> (segmentsInWindow * rmsSegmentSize);
+            state.segmentRms[static_cast<size_t> (segment % static_cast<int64_t> (state.segmentRms.size()))]
+                = static_cast<float> (std::sqrt (meanSquare));
+
+            ++state.completedSegments;
+        }
+    }
+
+    float getSegmentRms (const ChannelState& state, int64_t streamIndex) const
+    {
+        const int64_t segment = streamIndex / rmsSegmentSize;
+        return state.segmentRms[static_cast<size_t> (segment % static_cast<int64_t> (state.segmentRms.size()))];
+    }
+
+    /** computeResidual() for a single index */
+    static float residualAt (const float* data, int index)
+    {
+        const float later = data[index] - data[index - 1];
+        const float earlier = data[index - 1] - data[index - 2];
+        return std::abs (later - earlier);
+    }
+
+    /** |x[i] - 2 x[i-1] + x[i-2]| for work indices [begin, end) */
+    void computeResidual (const float* work, int begin, int end)
+    {
+        const int count = end - begin;
+        if (count <= 0)
+            return;
+
+        // First differences for [begin - 1, end), then their difference
+        float* diff = differences.data() + begin - 1;
+        juce::FloatVectorOperations::subtract (diff, work + begin - 1, work + begin - 2, count + 1);
+        juce::FloatVectorOperations::subtract (residual.data() + begin, diff + 1, diff, count);
+        juce::FloatVectorOperations::abs (residual.data() + begin, residual.data() + begin, count);
+    }
+
+    int detectAndRemoveClicks (ChannelState& state, float* work, int workLength, int64_t workOrigin,
+                               int numNew, int channel)
+    {
+        // Improved click detection algorithm based on Wave Corrector approach
+        // Uses first and second derivative analysis with adaptive thresholding
+
+        // Positions that now have the full lookahead available
+        const int64_t frontierEnd = juce::jmin (scanLimit, workOrigin + historySamples + numNew);
+        const int scanBegin = static_cast<int> (juce::jmax (state.nextScanPosition, workOrigin + historySamples) - workOrigin);
+        const int scanEnd = static_cast<int> (frontierEnd - workOrigin);
+
+        if (scanEnd <= scanBegin)
+            return 0;
+
+        // Pass 1: dense residual, including the peak search beyond the frontier
+        const int residualEnd = juce::jmin (workLength, scanEnd + peakSearchLength);
+        computeResidual (work, scanBegin, residualEnd);
+
+        // Pass 2: sparse threshold scan, one running-RMS segment at a time
+        int clicksFound = 0;
+        int i = scanBegin;
+
+        while (i < scanEnd)
+        {
+            const int64_t streamIndex = workOrigin + i;
+            const int segmentEnd = juce::jmin (scanEnd, static_cast<int> ((streamIndex / rmsSegmentSize + 1) * rmsSegmentSize - workOrigin));
+            const float rmsLevel = getSegmentRms (state, streamIndex);
+            const float adaptiveThreshold = calculateThreshold (rmsLevel);
+
+            // Most segments contain no candidate at all
+            if (juce::FloatVectorOperations::findMaximum (residual.data() + i, segmentEnd - i) <= adaptiveThreshold)
+            {
+                i = segmentEnd;
+                continue;
+            }
+
+            for (; i < segmentEnd; ++i)
+            {
+                const float secondDeriv = residual[static_cast<size_t> (i)];
+
+                // Click detection: sharp discontinuity in second derivative
+                if (secondDeriv <= adaptiveThreshold)
+                    continue;
+
+                // Look ahead a few samples to find the actual peak of the transient
+                int peakPos = i;
+                float maxDeriv = secondDeriv;
+                for (int j = i + 1; j < juce::jmin (i + peakSearchLength, residualEnd); ++j)
+                {
+                    if (residual[static_cast<size_t> (j)] > maxDeriv)
+                    {
+                        maxDeriv = residual[static_cast<size_t> (j)];
+                        peakPos = j;
+                    }
+                }
+                i = peakPos;
+
+                // Check if this is not part of periodic signal (music)
+                if (isPeriodic (work, i, static_cast<size_t> (workLength), rmsLevel))
+                    continue;
+
+                // Estimate click width by finding where signal stabilizes
+                int clickWidth = estimateClickWidth (work, i, static_cast<size_t> (workLength));
+
+                if (clickWidth <= 0 || clickWidth > maxClickWidth)
+                    continue;
+
+                // Report detected click (for GUI display)
+                ClickEvent event;
+                event.position = currentSamplePosition - streamPosition + workOrigin + i;
+                event.width = static_cast<uint16_t> (clickWidth);
+                event.magnitude = secondDeriv / adaptiveThreshold;
+                event.channel = static_cast<uint8_t> (channel);
+
+                if (publishLiveEvents.load (std::memory_order_relaxed))
+                    eventQueue.push (event);
+
+                if (storeDetectedClicks)
+                    detectedClicks.add (event);
+
+                // Apply removal if enabled
+                if (applyRemoval)
+                {
+                    removeClickAt (work, i, clickWidth, static_cast<size_t> (workLength));
+                    repairedEnd = juce::jmax (repairedEnd, workOrigin + i + getRepairReach (clickWidth) + 1);
+
+                    // The repair changed the samples ahead, so refresh their residual
+                    computeResidual (work, i + 1, residualEnd);
+                }
+
+                // Count detected click
+                clicksFound++;
+
+                // Skip ahead to avoid re-detecting same click
+                i += clickWidth;
+            }
+        }
+
+        // A skip may run past the frontier; the next block resumes from there
+        state.nextScanPosition = workOrigin + juce::jmax (i, scanEnd);
+        return clicksFound;
     }
 
     float calculateThreshold (float rmsLevel)
@@ -308,6 +745,116 @@ private:
         return juce::jmax (1, widthBefore + widthAfter + 1);
     }
 
+    /** processBufferRegion() reading buffer; the region from firstOutputSample on is written to output if given */
+    int scanBufferRegion (const juce::AudioBuffer<float>& buffer, juce::AudioBuffer<float>* output,
+                          int startSample, int numSamples, int firstOutputSample,
+                          std::function<bool (double)> progressCallback)
+    {
+        const int totalSamples = buffer.getNumSamples();
+        startSample = juce::jlimit (0, totalSamples, startSample);
+        numSamples = juce::jlimit (0, totalSamples - startSample, numSamples);
+
+        if (numSamples == 0)
+            return 0;
+
+        const int endSample = startSample + numSamples;
+        const int channelsToProcess = juce::jmin (buffer.getNumChannels(), static_cast<int> (channelStates.size()));
+        const int64_t regionStartPosition = currentSamplePosition;
+        juce::AudioBuffer<float> chunk (juce::jmax (1, channelsToProcess), maxBlockSize);
+        int totalClicks = 0;
+
+        resetStream();
+        scanLimit = static_cast<int64_t> (numSamples);
+
+        // Clicks are only detected before endSample, but the repair of one just before it
+        // reaches past it; the stream runs on until those samples are written as well
+        const int maxOverrun = juce::jmin (getRepairReach (maxClickWidth) + 1, totalSamples - endSample);
+        const auto getWriteEnd = [this, endSample, numSamples, maxOverrun]
+        {
+            return endSample + static_cast<int> (juce::jlimit (static_cast<int64_t> (0), static_cast<int64_t> (maxOverrun),
+                                                               repairedEnd - numSamples));
+        };
+
+        for (int readPos = startSample; readPos < getWriteEnd() + latencySamples; readPos += maxBlockSize)
+        {
+            if (progressCallback != nullptr
+                && !progressCallback (juce::jmin (1.0, (readPos - startSample) / static_cast<double> (numSamples + latencySamples))))
+                break;
+
+            const int samplesThisChunk = juce::jmin (maxBlockSize, getWriteEnd() + latencySamples - readPos);
+            const int available = juce::jlimit (0, samplesThisChunk, totalSamples - readPos);
+
+            for (int channel = 0; channel < channelsToProcess; ++channel)
+            {
+                chunk.copyFrom (channel, 0, buffer, channel, readPos, available);
+                chunk.clear (channel, available, samplesThisChunk - available);
+            }
+
+            juce::dsp::AudioBlock<float> block (chunk.getArrayOfWritePointers(),
+                                                static_cast<size_t> (channelsToProcess), 0,
+                                                static_cast<size_t> (samplesThisChunk));
+            juce::dsp::ProcessContextReplacing<float> context (block);
+            process (context);
+            totalClicks += clicksDetectedLastBlock.load();
+
+            // Output lags input by the latency, so writes never overtake unread samples
+            const int writePos = readPos - latencySamples;
+            const int first = juce::jmax (0, juce::jmax (startSample, firstOutputSample) - writePos);
+            const int last = juce::jmin (samplesThisChunk, getWriteEnd() - writePos);
+
+            if (output == nullptr)
+                continue;
+
+            if (beforeRepair != nullptr && last > first)
+                reportChangedRuns (buffer, chunk, channelsToProcess, writePos, first, last,
+                                   regionStartPosition - startSample);
+
+            for (int channel = 0; channel < channelsToProcess && last > first; ++channel)
+                output->copyFrom (channel, writePos + first, chunk, channel, first, last - first);
+        }
+
+        resetStream();
+        currentSamplePosition = regionStartPosition + numSamples;
+        return totalClicks;
+    }
+
+    /**
+     * Reports the runs of chunk[first, last) that differ from buffer at writePos
+     * in any channel, joining runs closer than a few samples, before they are written.
+     */
+    void reportChangedRuns (const juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& chunk,
+                            int channelsToProcess, int writePos, int first, int last, int64_t positionOffset)
+    {
+        constexpr int joinGapSamples = 32;
+        int runStart = -1;
+        int runEnd = -1;
+
+        for (int i = first; i < last; ++i)
+        {
+            bool changed = false;
+
+            for (int channel = 0; channel < channelsToProcess && !changed; ++channel)
+                changed = chunk.getReadPointer (channel)[i] != buffer.getReadPointer (channel)[writePos + i];
+
+            if (!changed)
+                continue;
+
+            if (runStart >= 0 && i - runEnd > joinGapSamples)
+            {
+                beforeRepair (positionOffset + writePos + runStart, runEnd - runStart);
+                runStart = -1;
+            }
+
+            if (runStart < 0)
+                runStart = i;
+
+            runEnd = i + 1;
+        }
+
+        if (runStart >= 0)
+            beforeRepair (positionOffset + writePos + runStart, runEnd - runStart);
+    }
+
     void removeClickAt (float* channelData, int position, int clickWidth, size_t numSamples)
     {
         // RESEARCH-BASED width-dependent method selection
@@ -440,8 +987,16 @@ private:
     }
 
     //==============================================================================
+    static constexpr int rmsSegmentSize = 64;     // Threshold update interval
+    static constexpr int rmsWindowSegments = 32;  // Running RMS over 2048 samples
+    static constexpr int peakSearchLength = 5;    // Residual peak search after a crossing
+    static constexpr int periodicCheckRange = 24; // Matches isPeriodic()
+    static constexpr int maxWidthSearch = 64;     // Matches estimateClickWidth()
+    static constexpr int edgeGuardSamples = 4;    // Skip the start of a stream
+
     double sampleRate = 44100.0;
     juce::uint32 numChannels = 2;
+    int maxBlockSize = 2048;
     float sensitivity = 50.0f;
 
     // DATA-DRIVEN click width parameters from vinyl sample analysis (1027 clicks)
@@ -454,12 +1009,27 @@ private:
 
     RemovalMethod removalMethod = Automatic;
 
-    std::vector<ClickInfo> detectedClicks;
+    ClickStore detectedClicks;
+    ClickEventQueue eventQueue;
 
     // Processing mode flags
-    bool storeDetectedClicks = false;  // When true, store clicks in detectedClicks vector
+    bool storeDetectedClicks = false;  // When true, store clicks in detectedClicks
+    std::atomic<bool> publishLiveEvents { false };   // When true, push clicks to eventQueue (set by the editor)
     bool applyRemoval = true;          // When true, actually remove clicks
     int64_t currentSamplePosition = 0; // Track position in audio stream
+    std::function<void (int64_t, int)> beforeRepair;
+
+    // Streaming detection state
+    std::vector<ChannelState> channelStates;
+    std::vector<float> residual;
+    std::vector<float> differences;
+    std::vector<float> edgeWindow;      // verifyCandidates() near the ends of a region
+    int lookaheadSamples = 0;
+    int historySamples = 0;
+    int latencySamples = 0;
+    int64_t streamPosition = 0; // Samples received since the stream was reset
+    int64_t scanLimit = std::numeric_limits<int64_t>::max();
+    int64_t repairedEnd = 0;    // Stream index past the last sample a repair changed
 
     // Activity tracking for visual feedback
     std::atomic<int> clicksDetectedLastBlock {0};
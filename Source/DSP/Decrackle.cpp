@@ -1,64 +1,249 @@
 #include "Decrackle.h"
 
 #include <cmath>
-#include <cstring>
 
-void Decrackle::process (juce::AudioBuffer<float>& buffer)
+void Decrackle::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    channelStates.resize (juce::jmax (1u, spec.numChannels));
+    reset();
+}
+
+void Decrackle::reset()
+{
+    resetStream();
+}
+
+void Decrackle::resetStream()
 {
-    const int numSamples = buffer.getNumSamples();
-    const int numChannels = buffer.getNumChannels();
+    for (auto& state : channelStates)
+        state = ChannelState();
 
-    if (numSamples < 3 || numChannels == 0)
+    streamPosition = 0;
+    streamEnd = std::numeric_limits<int64_t>::max();
+    activeWidth = averageWidth.load();
+}
+
+void Decrackle::setActiveWidth (int width)
+{
+    if (width == activeWidth)
         return;
 
-    const int width = juce::jmin (averageWidth, numSamples / 2);
+    activeWidth = width;
 
-    for (int ch = 0; ch < numChannels; ++ch)
+    // Rebuild the running sums around the last emitted sample for the new width
+    const int64_t index = streamPosition - 1 - latencySamples;
+    const int64_t last = juce::jmin (index + width, streamEnd - 1);
+
+    for (auto& state : channelStates)
     {
-        float* data = buffer.getWritePointer (ch);
+        state.windowSum = 0.0;
+        for (int64_t j = juce::jmax (static_cast<int64_t> (0), index - width); j <= last; ++j)
+            state.windowSum += state.values[static_cast<size_t> (j & ringMask)];
+    }
+}
 
-        double absSum = 0.0;
-        for (int i = 1; i < numSamples; ++i)
-            absSum += std::abs (data[i] - data[i - 1]);
+float Decrackle::getLevel (const ChannelState& state) const
+{
+    if (state.fixedLevel >= 0.0f)
+        return state.fixedLevel;
+
+    const int64_t count = juce::jmin (state.completedSegments, static_cast<int64_t> (levelWindowSegments)) * levelSegmentSize
+                        + state.partialCount;
+
+    return count > 0 ? static_cast<float> ((state.levelSum + state.partialSum) / static_cast<double> (count)) : 0.0f;
+}
 
-        const float meanAbsDelta = (numSamples > 1) ? static_cast<float> (absSum / (numSamples - 1)) : 0.0f;
-        const float scaledFactor = factor * meanAbsDelta;
+float Decrackle::processSample (ChannelState& state, float input, int64_t position, int width, float currentFactor)
+{
+    const auto slot = [] (int64_t index) { return static_cast<size_t> (index & ringMask); };
+
+    // Arrival: store the sample and flag its predecessor from the second difference
+    state.flags[slot (position)] = 0;
 
-        std::vector<uint8_t> flags (static_cast<size_t> (numSamples), 0);
+    if (position < streamEnd)
+    {
+        state.values[slot (position)] = input;
+
+        if (position >= 1 && state.fixedLevel < 0.0f)
+        {
+            state.partialSum += std::abs (input - state.previous1);
+
+            if (++state.partialCount == levelSegmentSize)
+            {
+                auto& oldest = state.segmentSums[static_cast<size_t> (state.completedSegments % levelWindowSegments)];
+                state.levelSum += state.partialSum - oldest;
+                oldest = state.partialSum;
+
+                ++state.completedSegments;
+                state.partialSum = 0.0;
+                state.partialCount = 0;
+            }
+        }
 
-        for (int i = 2; i < numSamples; ++i)
+        if (position >= 2)
         {
-            const float dy0 = data[i - 1] - data[i - 2];
-            const float dy1 = data[i] - data[i - 1];
+            const float dy0 = state.previous1 - state.previous2;
+            const float dy1 = input - state.previous1;
             const float dy2dx = dy1 - dy0;
 
-            if (std::abs (dy2dx) > scaledFactor)
-                flags[static_cast<size_t> (i - 1)] = 1;
+            if (std::abs (dy2dx) > currentFactor * getLevel (state))
+                state.flags[slot (position - 1)] = 1;
         }
 
-        std::vector<float> temp (data, data + numSamples);
+        state.previous2 = state.previous1;
+        state.previous1 = input;
+    }
+    else
+    {
+        state.values[slot (position)] = 0.0f;
+    }
+
+    // Output: slide the averaging window to the delayed sample and repair it
+    const int64_t index = position - latencySamples;
+    const int64_t entering = index + width;
+    const int64_t leaving = index - width - 1;
+
+    if (entering >= 0 && entering < streamEnd)
+        state.windowSum += state.values[slot (entering)];
+
+    if (leaving >= 0 && leaving < streamEnd)
+        state.windowSum -= state.values[slot (leaving)];
+
+    if (index < 0 || index >= streamEnd)
+        return 0.0f;
+
+    const int64_t first = juce::jmax (static_cast<int64_t> (0), index - width);
+    const int64_t last = juce::jmin (streamEnd - 1, index + width);
+    const float mean = static_cast<float> (state.windowSum / static_cast<double> (last - first + 1));
+
+    float& value = state.values[slot (index)];
+    const bool flagged = state.flags[slot (index)] != 0;
+    const bool neighborFlagged = (index > 0 && state.flags[slot (index - 1)] != 0) || state.flags[slot (index + 1)] != 0;
+
+    if (!flagged && !neighborFlagged)
+        return value;
+
+    // Later windows see the repaired value, as in the original in-place pass
+    const float repaired = flagged ? mean : 0.5f * (value + mean);
+    state.windowSum += static_cast<double> (repaired) - static_cast<double> (value);
+    value = repaired;
+    return repaired;
+}
+
+void Decrackle::process (juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& inputBlock = context.getInputBlock();
+    auto& outputBlock = context.getOutputBlock();
+
+    if (context.usesSeparateInputAndOutputBlocks())
+        outputBlock.copyFrom (inputBlock);
+
+    const int numSamples = static_cast<int> (outputBlock.getNumSamples());
+    const int channelsToProcess = juce::jmin (static_cast<int> (outputBlock.getNumChannels()),
+                                              static_cast<int> (channelStates.size()));
+    const int width = averageWidth.load();
+    const float currentFactor = factor.load();
+
+    setActiveWidth (width);
+
+    for (int channel = 0; channel < channelsToProcess; ++channel)
+    {
+        auto& state = channelStates[static_cast<size_t> (channel)];
+        float* data = outputBlock.getChannelPointer (static_cast<size_t> (channel));
 
         for (int i = 0; i < numSamples; ++i)
+            data[i] = processSample (state, data[i], streamPosition + i, width, currentFactor);
+    }
+
+    streamPosition += numSamples;
+}
+
+bool Decrackle::processBufferRegion (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                     std::function<bool (double)> progressCallback)
+{
+    const int totalSamples = buffer.getNumSamples();
+    startSample = juce::jlimit (0, totalSamples, startSample);
+    numSamples = juce::jlimit (0, totalSamples - startSample, numSamples);
+
+    if (numSamples < 3)
+        return true;
+
+    const int channelsToProcess = juce::jmin (buffer.getNumChannels(), static_cast<int> (channelStates.size()));
+    const int width = juce::jmin (averageWidth.load(), numSamples / 2);
+    const float currentFactor = factor.load();
+    const int totalSteps = numSamples + latencySamples;
+    constexpr int progressInterval = 65536;
+    bool cancelled = false;
+
+    const auto levels = measureLevels (buffer, startSample, numSamples);
+
+    resetStream();
+    streamEnd = numSamples;
+    activeWidth = width;
+
+    for (int channel = 0; channel < channelsToProcess && !cancelled; ++channel)
+    {
+        auto& state = channelStates[static_cast<size_t> (channel)];
+        float* data = buffer.getWritePointer (channel, startSample);
+
+        state.fixedLevel = levels[static_cast<size_t> (channel)];
+
+        // Output lags input by the latency, so writes never overtake unread samples
+        for (int step = 0; step < totalSteps; ++step)
         {
-            const int start = juce::jmax (0, i - width);
-            const int end = juce::jmin (numSamples - 1, i + width);
-
-            float sum = 0.0f;
-            const int count = end - start + 1;
-            for (int j = start; j <= end; ++j)
-                sum += temp[static_cast<size_t> (j)];
-
-            const float mean = (count > 0) ? (sum / static_cast<float> (count)) : temp[static_cast<size_t> (i)];
-            const bool neighborFlagged = flags[static_cast<size_t> (i)] ||
-                                         (i > 0 && flags[static_cast<size_t> (i - 1)]) ||
-                                         (i + 1 < numSamples && flags[static_cast<size_t> (i + 1)]);
-
-            if (flags[static_cast<size_t> (i)] != 0)
-                temp[static_cast<size_t> (i)] = mean;
-            else if (neighborFlagged)
-                temp[static_cast<size_t> (i)] = 0.5f * (temp[static_cast<size_t> (i)] + mean);
+            if (progressCallback != nullptr && step % progressInterval == 0
+                && !progressCallback ((channel * static_cast<double> (totalSteps) + step)
+                                      / (channelsToProcess * static_cast<double> (totalSteps))))
+            {
+                cancelled = true;
+                break;
+            }
+
+            const float output = processSample (state, step < numSamples ? data[step] : 0.0f, step, width, currentFactor);
+
+            if (step >= latencySamples)
+                data[step - latencySamples] = output;
         }
+    }
+
+    resetStream();
+    return !cancelled;
+}
+
+void Decrackle::beginRegionStream (int64_t numSamples, const std::vector<float>& channelLevels)
+{
+    resetStream();
+    streamEnd = juce::jmax (static_cast<int64_t> (0), numSamples);
+
+    for (size_t channel = 0; channel < channelStates.size() && channel < channelLevels.size(); ++channel)
+        channelStates[channel].fixedLevel = channelLevels[channel];
+}
+
+std::vector<float> Decrackle::measureLevels (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    std::vector<float> levels (static_cast<size_t> (buffer.getNumChannels()), 0.0f);
+
+    if (numSamples < 2)
+        return levels;
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        const float* data = buffer.getReadPointer (channel, startSample);
 
-        std::memcpy (data, temp.data(), static_cast<size_t> (numSamples) * sizeof (float));
+        double absSum = 0.0;
+        for (int i = 1; i < numSamples; ++i)
+            absSum += std::abs (data[i] - data[i - 1]);
+
+        levels[static_cast<size_t> (channel)] = static_cast<float> (absSum / (numSamples - 1));
     }
+
+    return levels;
+}
+
+void Decrackle::process (juce::AudioBuffer<float>& buffer)
+{
+    if (static_cast<int> (channelStates.size()) < buffer.getNumChannels())
+        prepare ({ 0.0, 2048u, static_cast<juce::uint32> (buffer.getNumChannels()) });
+
+    processBufferRegion (buffer, 0, buffer.getNumSamples());
 }
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <juce_dsp/juce_dsp.h>
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
 
 /**
  * Decrackle Processor
@@ -8,27 +15,112 @@
  * Clean-room implementation inspired by classic decrackle concepts:
  * detect rapid changes in the second derivative and replace flagged
  * samples with a local average.
+ *
+ * Streaming: every channel keeps a small ring of carry-over, so the output is
+ * delayed by getLatencySamples() and the result does not depend on the block
+ * size. The local average is a running sum (O(1) per sample, any width) and
+ * nothing is allocated after prepare(), so it can run on the audio thread.
+ *
+ * The detection threshold scales with the mean absolute sample delta: a
+ * running mean over the last ~0.75 s when streaming, the mean of the whole
+ * region for processBufferRegion().
  */
 class Decrackle
 {
 public:
     Decrackle() = default;
 
+    //==============================================================================
+    /** Allocates per-channel state. Not real-time safe. */
+    void prepare (const juce::dsp::ProcessSpec& spec);
+
+    /** Clears the carry-over and the running level */
+    void reset();
+
+    /** Delay between input and output, in samples (fixed, independent of the width) */
+    int getLatencySamples() const { return latencySamples; }
+
+    //==============================================================================
     void setFactor (float newFactor)
     {
-        factor = juce::jlimit (0.01f, 1.0f, newFactor);
+        factor.store (juce::jlimit (0.01f, 1.0f, newFactor));
     }
 
     void setAverageWidth (int newWidth)
     {
-        averageWidth = juce::jlimit (1, 10, newWidth);
+        averageWidth.store (juce::jlimit (1, maxAverageWidth, newWidth));
     }
 
+    float getFactor() const { return factor.load(); }
+    int getAverageWidth() const { return averageWidth.load(); }
+
+    //==============================================================================
+    /** Process audio block (real-time safe, output is delayed by getLatencySamples()) */
+    void process (juce::dsp::ProcessContextReplacing<float>& context);
+
+    /**
+     * Offline helper: processes a region of a buffer in place with the latency
+     * compensated. Each channel's threshold uses the mean delta of the region.
+     * The optional callback receives progress (0-1) and returns false to cancel.
+     * Returns false if cancelled.
+     */
+    bool processBufferRegion (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                              std::function<bool (double)> progressCallback = nullptr);
+
+    /**
+     * Offline streaming: starts a stream whose first numSamples inputs are a
+     * region, fed through process() and flushed with getLatencySamples() of
+     * zeros. channelLevels holds each channel's mean absolute delta over the
+     * region, which fixes the threshold as in processBufferRegion(); channels
+     * without one use the running level.
+     */
+    void beginRegionStream (int64_t numSamples, const std::vector<float>& channelLevels);
+
+    /** Each channel's mean absolute delta over a region, the level processBufferRegion() uses */
+    static std::vector<float> measureLevels (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    /** Offline helper: processes a whole buffer in place (prepares on demand) */
     void process (juce::AudioBuffer<float>& buffer);
 
 private:
-    float factor = 0.5f;
-    int averageWidth = 3;
+    //==============================================================================
+    static constexpr int maxAverageWidth = 10;
+    static constexpr int latencySamples = maxAverageWidth;    // Covers the widest window and the +1 flag lookahead
+    static constexpr int ringSize = 32;                       // > latency + width + 1
+    static constexpr int ringMask = ringSize - 1;
+    static constexpr int levelSegmentSize = 1024;             // Running level: deltas per segment
+    static constexpr int levelWindowSegments = 32;            // Running level: segments per window
+
+    /** Per-channel carry-over */
+    struct ChannelState
+    {
+        std::array<float, ringSize> values {};   // Input until repaired, then output
+        std::array<uint8_t, ringSize> flags {};
+        double windowSum = 0.0;                  // Sum of values over the current averaging window
+        float previous1 = 0.0f;                  // Unrepaired input history for the second difference
+        float previous2 = 0.0f;
+
+        std::array<double, levelWindowSegments> segmentSums {};
+        double levelSum = 0.0;                   // |delta| over the completed segments in the window
+        double partialSum = 0.0;                 // |delta| in the current segment
+        int partialCount = 0;
+        int64_t completedSegments = 0;
+        float fixedLevel = -1.0f;                // Region mean |delta| offline; negative = running level
+    };
+
+    void resetStream();
+    void setActiveWidth (int width);
+    float processSample (ChannelState& state, float input, int64_t position, int width, float currentFactor);
+    float getLevel (const ChannelState& state) const;
+
+    //==============================================================================
+    std::atomic<float> factor {0.5f};
+    std::atomic<int> averageWidth {3};
+
+    std::vector<ChannelState> channelStates;
+    int64_t streamPosition = 0;                                      // Stream index of the next input sample
+    int64_t streamEnd = std::numeric_limits<int64_t>::max();         // Offline: samples past the region are padding
+    int activeWidth = 3;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Decrackle)
 };
@@ -0,0 +1,58 @@
+#include "FFTCache.h"
+#include "../Utils/RealtimeDiagnostics.h"
+
+#include <iterator>
+#include <map>
+#include <tuple>
+
+namespace
+{
+    using WindowKey = std::tuple<int, int, bool>;
+
+    struct CacheStorage
+    {
+        juce::CriticalSection lock;
+        std::map<WindowKey, FFTCache::WindowPtr> windows;
+    };
+
+    CacheStorage& getStorage()
+    {
+        static CacheStorage storage;
+        return storage;
+    }
+}
+
+FFTCache::WindowPtr FFTCache::getWindow (int size, WindowType type, bool periodic)
+{
+    jassert (size > 0);
+
+    auto& storage = getStorage();
+    VRS_RT_NOTE_LOCK();
+    const juce::ScopedLock sl (storage.lock);
+
+    auto& window = storage.windows[WindowKey (size, static_cast<int> (type), periodic)];
+
+    if (window == nullptr)
+    {
+        const int tableSize = periodic ? size + 1 : size;
+        std::vector<float> table (static_cast<size_t> (tableSize));
+
+        juce::dsp::WindowingFunction<float>::fillWindowingTables (
+            table.data(), static_cast<size_t> (tableSize), type, false);
+
+        table.resize (static_cast<size_t> (size));
+        window = std::make_shared<const std::vector<float>> (std::move (table));
+    }
+
+    return window;
+}
+
+void FFTCache::purgeUnused()
+{
+    auto& storage = getStorage();
+    VRS_RT_NOTE_LOCK();
+    const juce::ScopedLock sl (storage.lock);
+
+    for (auto it = storage.windows.begin(); it != storage.windows.end();)
+        it = (it->second.use_count() <= 1) ? storage.windows.erase (it) : std::next (it);
+}
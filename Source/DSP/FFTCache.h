@@ -0,0 +1,42 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <memory>
+#include <vector>
+
+/**
+ * Process-wide Window Table Cache
+ *
+ * Window tables are immutable once built, so every processor instance can
+ * share them. The first request for a (size, window type) builds the entry;
+ * later requests - including every re-prepare and every further plugin
+ * instance - just copy a shared_ptr.
+ *
+ * FFT engines are deliberately not shared: JUCE's fallback engine serialises
+ * perform() on an internal lock, so one process-wide instance would make
+ * every plugin instance's audio thread and every analysis thread contend on
+ * it. Each processor or thread owns its juce::dsp::FFT.
+ *
+ * All functions are thread-safe. They may allocate on first use, so call
+ * them from prepare(), never from the audio thread.
+ */
+class FFTCache
+{
+public:
+    using WindowPtr = std::shared_ptr<const std::vector<float>>;
+    using WindowType = juce::dsp::WindowingFunction<float>::WindowingMethod;
+
+    /**
+     * Returns a shared window table of `size` points.
+     * Periodic tables are the first `size` points of a size + 1 table, which
+     * is what overlap-add resynthesis wants; symmetric tables match
+     * WindowingFunction's default.
+     */
+    static WindowPtr getWindow (int size, WindowType type, bool periodic);
+
+    /** Drops cached entries that are no longer referenced by any processor; SpectralProcessor calls it as it lets go of a table */
+    static void purgeUnused();
+
+private:
+    FFTCache() = delete;
+};
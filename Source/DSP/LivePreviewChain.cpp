@@ -0,0 +1,102 @@
+#include "LivePreviewChain.h"
+
+LivePreviewChain::~LivePreviewChain()
+{
+    setStages (nullptr, nullptr, 0, 0);
+}
+
+void LivePreviewChain::setStages (std::unique_ptr<ClickRemoval> clickRemoval,
+                                  std::unique_ptr<NoiseReduction> noiseReduction,
+                                  int numChannels, int maxBlockSize)
+{
+    std::unique_ptr<Stages> newStages;
+
+    if ((clickRemoval != nullptr || noiseReduction != nullptr) && numChannels > 0 && maxBlockSize > 0)
+    {
+        newStages = std::make_unique<Stages>();
+        newStages->block.setSize (numChannels, maxBlockSize);
+
+        if (clickRemoval != nullptr)
+            newStages->latency += clickRemoval->getLatencySamples();
+
+        if (noiseReduction != nullptr)
+            newStages->latency += noiseReduction->getLatencySamples();
+
+        newStages->clickRemoval = std::move (clickRemoval);
+        newStages->noiseReduction = std::move (noiseReduction);
+    }
+
+    active = newStages != nullptr;
+
+    {
+        const juce::SpinLock::ScopedLockType sl (stagesLock);
+        std::swap (stages, newStages);
+    }
+
+    // newStages now holds the previous set, released outside the lock
+}
+
+void LivePreviewChain::process (const juce::AudioBuffer<float>& source, juce::int64 position,
+                                juce::AudioBuffer<float>& dest, int destStart, int numSamples)
+{
+    const juce::SpinLock::ScopedTryLockType sl (stagesLock);
+
+    if (!sl.isLocked() || stages == nullptr || source.getNumChannels() == 0)
+        return;
+
+    auto& current = *stages;
+    const int blockSize = current.block.getNumSamples();
+
+    // After a seek, start the stream at the new position and run its latency through
+    if (position != current.nextPosition)
+    {
+        if (current.clickRemoval != nullptr)
+        {
+            current.clickRemoval->reset();
+            current.clickRemoval->setSampleOffset (position);
+        }
+
+        if (current.noiseReduction != nullptr)
+            current.noiseReduction->reset();
+
+        for (int primed = 0; primed < current.latency; primed += blockSize)
+            runStages (current, source, position + primed, juce::jmin (blockSize, current.latency - primed));
+    }
+
+    for (int offset = 0; offset < numSamples; offset += blockSize)
+    {
+        const int count = juce::jmin (blockSize, numSamples - offset);
+
+        // The input runs the latency ahead of what is played
+        runStages (current, source, position + current.latency + offset, count);
+
+        for (int channel = 0; channel < dest.getNumChannels(); ++channel)
+            dest.copyFrom (channel, destStart + offset, current.block, channel % current.block.getNumChannels(), 0, count);
+    }
+
+    current.nextPosition = position + numSamples;
+}
+
+void LivePreviewChain::runStages (Stages& stages, const juce::AudioBuffer<float>& source, juce::int64 readPosition, int numSamples)
+{
+    const int numChannels = stages.block.getNumChannels();
+    const auto available = juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, (juce::int64) source.getNumSamples() - readPosition);
+
+    // Past the end of the source the stages are fed silence
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        if (available > 0)
+            stages.block.copyFrom (channel, 0, source, channel % source.getNumChannels(), (int) readPosition, (int) available);
+
+        stages.block.clear (channel, (int) available, numSamples - (int) available);
+    }
+
+    juce::dsp::AudioBlock<float> block (stages.block.getArrayOfWritePointers(), (size_t) numChannels, 0, (size_t) numSamples);
+    juce::dsp::ProcessContextReplacing<float> context (block);
+
+    if (stages.clickRemoval != nullptr)
+        stages.clickRemoval->process (context);
+
+    if (stages.noiseReduction != nullptr)
+        stages.noiseReduction->process (context);
+}
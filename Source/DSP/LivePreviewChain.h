@@ -0,0 +1,66 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "ClickRemoval.h"
+#include "NoiseReduction.h"
+#include <memory>
+
+/**
+ * Live Preview Chain
+ *
+ * Runs the offline restoration stages (click removal, noise reduction) on
+ * playback, so their settings can be tuned by ear before anything is
+ * rendered into the file. The stages read the source ahead of the play
+ * position by their combined latency, so what is heard lines up with the
+ * transport; after a seek they are reset and primed from the new position.
+ *
+ * Stages are built and configured on the message thread and handed over
+ * whole with setStages(); the audio thread never allocates or reconfigures
+ * them. While a hand-over is in progress a block plays unprocessed.
+ */
+class LivePreviewChain
+{
+public:
+    LivePreviewChain() = default;
+    ~LivePreviewChain();
+
+    /**
+     * Replaces the stages (message thread). Processors must already be prepared
+     * for numChannels at the source rate with maxBlockSize; null ones are
+     * skipped, and with neither the preview is off. The previous stages are
+     * destroyed here, not on the audio thread.
+     */
+    void setStages (std::unique_ptr<ClickRemoval> clickRemoval,
+                    std::unique_ptr<NoiseReduction> noiseReduction,
+                    int numChannels, int maxBlockSize);
+
+    bool isActive() const { return active.load(); }
+
+    /**
+     * Audio thread: replaces dest[destStart, destStart + numSamples), which holds
+     * source[position, position + numSamples), with the processed audio. Source
+     * channels map onto dest channels as the playback source maps them.
+     */
+    void process (const juce::AudioBuffer<float>& source, juce::int64 position,
+                  juce::AudioBuffer<float>& dest, int destStart, int numSamples);
+
+private:
+    struct Stages
+    {
+        std::unique_ptr<ClickRemoval> clickRemoval;
+        std::unique_ptr<NoiseReduction> noiseReduction;
+        juce::AudioBuffer<float> block;
+        int latency = 0;
+        juce::int64 nextPosition = -1;      // Play position the stream continues from
+    };
+
+    /** Feeds source[readPosition, readPosition + numSamples) through the stages into stages.block */
+    static void runStages (Stages& stages, const juce::AudioBuffer<float>& source, juce::int64 readPosition, int numSamples);
+
+    std::unique_ptr<Stages> stages;
+    juce::SpinLock stagesLock;
+    std::atomic<bool> active { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LivePreviewChain)
+};
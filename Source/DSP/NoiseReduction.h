@@ -2,7 +2,9 @@
 
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_basics/juce_audio_basics.h>
-#include "SpectralProcessor.h"
+#include "StftEngine.h"
+#include "SpectralGain.h"
+#include <array>
 
 /**
  * Spectral Noise Reduction Processor
@@ -13,10 +15,22 @@
  * - Adjustable reduction amount
  * - Spectral floor to prevent musical noise artifacts
  * - Dual profile support for varying noise (shellac records)
+ * - Selectable FFT size (256 - 8192) and overlap (50% / 75%)
+ * - Multi-resolution mode: long FFT below the crossover, short FFT above it
+ *
+ * Framing is handled by StftEngine, so the output is independent of the host
+ * block size and delayed by getLatencySamples(). The delay is constant: when
+ * bypassed or without a profile the signal still passes through the engine.
  */
 class NoiseReduction
 {
 public:
+    enum class Overlap
+    {
+        percent50,
+        percent75
+    };
+
     NoiseReduction() = default;
 
     //==============================================================================
@@ -24,63 +38,219 @@ public:
     {
         sampleRate = spec.sampleRate;
         numChannels = spec.numChannels;
+        maxBlockSize = static_cast<int> (juce::jmax (1u, spec.maximumBlockSize));
 
-        // Initialize FFT
-        fftOrder = 11; // 2048 samples
+        // Primary path: the selected FFT size
         fftSize = 1 << fftOrder;
-        hopSize = fftSize / 4; // 75% overlap
+        hopSize = overlap == Overlap::percent75 ? fftSize / 4 : fftSize / 2;
+        preparePath (paths[0], fftOrder, hopSize);
 
-        fft = std::make_unique<juce::dsp::FFT> (fftOrder);
-
-        // Allocate buffers
-        fftBuffer.resize (fftSize * 2); // Real + imaginary
-        windowBuffer.resize (fftSize);
-        overlapBuffer.setSize (static_cast<int> (numChannels), fftSize);
-        overlapBuffer.clear();
+        // Secondary path: short FFT for the highs in multi-resolution mode
+        if (multiResolution)
+        {
+            const int shortOrder = juce::jmax (minFftOrder, fftOrder - 3);
+            const int shortSize = 1 << shortOrder;
+            preparePath (paths[1], shortOrder, overlap == Overlap::percent75 ? shortSize / 4 : shortSize / 2);
 
-        // Create Hann window
-        juce::dsp::WindowingFunction<float>::fillWindowingTables (
-            windowBuffer.data(), fftSize,
-            juce::dsp::WindowingFunction<float>::hann, false);
+            buildCrossoverMasks();
 
-        // Initialize noise profile
-        noiseProfile.resize (fftSize / 2 + 1);
-        std::fill (noiseProfile.begin(), noiseProfile.end(), 0.0f);
-        profileCaptured = false;
+            // The short path is delayed so both paths line up
+            alignmentDelay = paths[0].stft.getLatencySamples() - paths[1].stft.getLatencySamples();
+            alignmentBuffer.setSize (static_cast<int> (numChannels), juce::jmax (1, alignmentDelay));
+            shortPathScratch.resize (static_cast<size_t> (maxBlockSize));
+        }
+        else
+        {
+            paths[0].crossoverMask.clear();
+            alignmentDelay = 0;
+            alignmentBuffer.setSize (0, 0);
+            shortPathScratch.clear();
+        }
 
         reset();
     }
 
     void reset()
     {
-        overlapBuffer.clear();
-        processingPosition = 0;
+        for (int p = 0; p < getNumActivePaths(); ++p)
+            paths[static_cast<size_t> (p)].stft.reset();
+
+        alignmentBuffer.clear();
+        alignmentPosition = 0;
     }
 
     void process (juce::dsp::ProcessContextReplacing<float>& context)
     {
         auto& block = context.getOutputBlock();
+        const int numSamples = static_cast<int> (block.getNumSamples());
+        const int channelsToProcess = juce::jmin (static_cast<int> (block.getNumChannels()),
+                                                  paths[0].stft.getNumChannels());
 
-        // Capture profile if requested
-        if (isCapturingProfile)
+        // Process each channel independently
+        for (int channel = 0; channel < channelsToProcess; ++channel)
         {
-            captureProfileFromBlock (block);
-            return; // Don't process during capture
+            processChannel (block.getChannelPointer (static_cast<size_t> (channel)),
+                            numSamples, channel);
         }
 
-        // Bypass if no profile or zero reduction
-        if (!profileCaptured || reductionAmount <= 0.0f)
+        advanceAlignment (numSamples);
+        finishStreamingCapture();
+    }
+
+    //==============================================================================
+    /**
+     * Selects the FFT size (power of two, 256 - 8192), the overlap and whether
+     * the multi-resolution mode is used. Re-prepares the processor when it has
+     * already been prepared, so this is not real-time safe. A captured noise
+     * profile is resampled to the new resolution.
+     */
+    void setResolution (int newFftSize, Overlap newOverlap, bool shouldUseMultiResolution)
+    {
+        int newOrder = juce::roundToInt (std::log2 (static_cast<double> (juce::jmax (1, newFftSize))));
+        newOrder = juce::jlimit (minFftOrder, maxFftOrder, newOrder);
+
+        if (newOrder == fftOrder && newOverlap == overlap && shouldUseMultiResolution == multiResolution)
+            return;
+
+        // Keep the primary profile so a size change doesn't force a new capture
+        std::vector<float> previousProfile;
+        const int previousSize = fftSize;
+        if (profileCaptured)
+            previousProfile = paths[0].noiseProfile;
+
+        fftOrder = newOrder;
+        overlap = newOverlap;
+        multiResolution = shouldUseMultiResolution;
+
+        if (isPrepared())
         {
+            juce::dsp::ProcessSpec spec;
+            spec.sampleRate = sampleRate;
+            spec.numChannels = numChannels;
+            spec.maximumBlockSize = static_cast<juce::uint32> (maxBlockSize);
+            prepare (spec);
+
+            if (!previousProfile.empty())
+            {
+                for (int p = 0; p < getNumActivePaths(); ++p)
+                {
+                    auto& path = paths[static_cast<size_t> (p)];
+                    resampleProfile (previousProfile, previousSize, path.noiseProfile, path.stft.getFFTSize());
+                }
+
+                profileCaptured = true;
+            }
+        }
+    }
+
+    int getFFTSize() const { return 1 << fftOrder; }
+    Overlap getOverlap() const { return overlap; }
+    bool isMultiResolution() const { return multiResolution; }
+
+    //==============================================================================
+    /**
+     * Offline helper: processes a region of a buffer in place with the STFT
+     * latency compensated, so the result stays time-aligned with the input.
+     * Audio after the region (or silence past the end) feeds the final frames.
+     */
+    void processBufferRegion (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        const int totalSamples = buffer.getNumSamples();
+        startSample = juce::jlimit (0, totalSamples, startSample);
+        numSamples = juce::jlimit (0, totalSamples - startSample, numSamples);
+
+        if (numSamples == 0)
             return;
+
+        const int latency = getLatencySamples();
+        const int endSample = startSample + numSamples;
+        const int chunkSize = maxBlockSize;
+        const int channelsToProcess = juce::jmin (buffer.getNumChannels(), paths[0].stft.getNumChannels());
+        juce::AudioBuffer<float> chunk (channelsToProcess, chunkSize);
+
+        reset();
+
+        for (int readPos = startSample; readPos < endSample + latency; readPos += chunkSize)
+        {
+            const int samplesThisChunk = juce::jmin (chunkSize, endSample + latency - readPos);
+            const int available = juce::jlimit (0, samplesThisChunk, totalSamples - readPos);
+
+            for (int channel = 0; channel < channelsToProcess; ++channel)
+            {
+                chunk.copyFrom (channel, 0, buffer, channel, readPos, available);
+                chunk.clear (channel, available, samplesThisChunk - available);
+            }
+
+            juce::dsp::AudioBlock<float> block (chunk.getArrayOfWritePointers(),
+                                                static_cast<size_t> (channelsToProcess), 0,
+                                                static_cast<size_t> (samplesThisChunk));
+            juce::dsp::ProcessContextReplacing<float> context (block);
+            process (context);
+
+            // Output lags input by the latency, so writes never overtake unread samples
+            const int writePos = readPos - latency;
+            const int first = juce::jmax (0, startSample - writePos);
+            const int last = juce::jmin (samplesThisChunk, endSample - writePos);
+
+            for (int channel = 0; channel < channelsToProcess && last > first; ++channel)
+                buffer.copyFrom (channel, writePos + first, chunk, channel, first, last - first);
         }
 
-        // Process each channel independently
-        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        reset();
+    }
+
+    /**
+     * Offline helper: captures the noise profile from a region without modifying
+     * the buffer. Every frame in the region is averaged.
+     */
+    void captureProfileFromBuffer (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        captureProfileFromRegions (buffer, { juce::Range<int> (startSample, startSample + numSamples) });
+    }
+
+    /**
+     * Offline helper: captures one noise profile averaged over the frames of
+     * several regions of a buffer (e.g. the quietest parts of a file). Each
+     * region is analysed on its own, so no frame spans two of them.
+     */
+    void captureProfileFromRegions (const juce::AudioBuffer<float>& buffer, const std::vector<juce::Range<int>>& regions)
+    {
+        isCapturingProfile = false;
+        profileCaptured = false;
+
+        bool allPathsCaptured = true;
+
+        for (int p = 0; p < getNumActivePaths(); ++p)
         {
-            processSpectralSubtraction (block.getChannelPointer (channel),
-                                       block.getNumSamples(),
-                                       static_cast<int> (channel));
+            auto& path = paths[static_cast<size_t> (p)];
+            std::fill (path.noiseProfile.begin(), path.noiseProfile.end(), 0.0f);
+            path.captureFrames = 0;
+
+            const int numBins = path.stft.getNumBins();
+            const int channelsToProcess = juce::jmin (buffer.getNumChannels(), path.stft.getNumChannels());
+
+            for (auto region : regions)
+            {
+                region = region.getIntersectionWith ({ 0, buffer.getNumSamples() });
+                reset();
+
+                for (int channel = 0; channel < channelsToProcess; ++channel)
+                {
+                    path.stft.analyse (buffer.getReadPointer (channel, region.getStart()), region.getLength(), channel,
+                                       [&path, numBins] (const float* spectrum, int)
+                                       {
+                                           SpectralGain::accumulateMagnitudes (spectrum, path.noiseProfile.data(), numBins);
+                                           ++path.captureFrames;
+                                       });
+                }
+            }
+
+            allPathsCaptured = allPathsCaptured && path.captureFrames > 0;
+            normaliseProfile (path);
         }
+
+        reset();
+        profileCaptured = allPathsCaptured;
     }
 
     //==============================================================================
@@ -88,33 +258,42 @@ public:
     void captureProfile()
     {
         isCapturingProfile = true;
-        profileCaptureFrames = 0;
-        std::fill (noiseProfile.begin(), noiseProfile.end(), 0.0f);
+
+        for (auto& path : paths)
+        {
+            path.captureFrames = 0;
+            std::fill (path.noiseProfile.begin(), path.noiseProfile.end(), 0.0f);
+        }
+    }
+
+    /** Set reduction amount in dB */
+    void setReduction (float dB)
+    {
+        reductionAmount = juce::jlimit (0.0f, 24.0f, dB);
+        reductionLinear = juce::Decibels::decibelsToGain (reductionAmount);
     }
 
-    /** Set reduction amount in dB */
-    void setReduction (float dB)
-    {
-        reductionAmount = juce::jlimit (0.0f, 24.0f, dB);
-        reductionLinear = juce::Decibels::decibelsToGain (reductionAmount);
-    }
-
-    /** Enable adaptive noise profile updates during processing */
-    void setAdaptiveEnabled (bool enabled) { adaptiveEnabled = enabled; }
-
-    /** Set adaptive profile update rate (0.0 to 0.2) */
-    void setAdaptiveRate (float rate)
-    {
-        adaptiveRate = juce::jlimit (0.0f, 0.2f, rate);
-    }
-
-    /** Check if noise profile has been captured */
-    bool hasProfile() const { return profileCaptured; }
+    /** Bypass processing while keeping the latency constant */
+    void setBypassed (bool shouldBeBypassed) { bypassed = shouldBeBypassed; }
+
+    /** Enable adaptive noise profile updates during processing */
+    void setAdaptiveEnabled (bool enabled) { adaptiveEnabled = enabled; }
+
+    /** Set adaptive profile update rate (0.0 to 0.2) */
+    void setAdaptiveRate (float rate)
+    {
+        adaptiveRate = juce::jlimit (0.0f, 0.2f, rate);
+    }
+
+    /** Check if noise profile has been captured */
+    bool hasProfile() const { return profileCaptured; }
 
     /** Clear noise profile */
     void clearProfile()
     {
-        std::fill (noiseProfile.begin(), noiseProfile.end(), 0.0f);
+        for (auto& path : paths)
+            std::fill (path.noiseProfile.begin(), path.noiseProfile.end(), 0.0f);
+
         profileCaptured = false;
     }
 
@@ -122,251 +301,235 @@ public:
     bool isActivelyReducing() const { return profileCaptured && reductionAmount > 0.1f; }
     float getReductionAmount() const { return reductionAmount; }
 
+    /** Processing delay introduced by the STFT, in samples */
+    int getLatencySamples() const
+    {
+        return paths[0].stft.isPrepared() ? paths[0].stft.getLatencySamples() : getFFTSize();
+    }
+
 private:
     //==============================================================================
-    void processSpectralSubtraction (float* channelData, size_t numSamples, int channel)
+    /** One STFT resolution with its own profile and kernel */
+    struct SpectralPath
     {
-        // Overlap-add FFT processing for spectral subtraction
-        // Process in frames with 75% overlap for smooth reconstruction
-
-        for (size_t pos = 0; pos < numSamples; pos += hopSize)
-        {
-            // Calculate frame boundaries
-            size_t frameEnd = juce::jmin (pos + fftSize, numSamples);
-            size_t frameSamples = frameEnd - pos;
+        StftEngine stft;
+        SpectralGain gain;
+        std::vector<float> noiseProfile;
+        std::vector<float> crossoverMask; // Per-bin weight of this path; empty = full band
+        int captureFrames = 0;
+    };
+
+    void preparePath (SpectralPath& path, int order, int hop)
+    {
+        path.stft.prepare (order, hop, static_cast<int> (numChannels));
+        path.gain.prepare (1 << order);
+        path.noiseProfile.assign (static_cast<size_t> (path.stft.getNumBins()), 0.0f);
+        path.captureFrames = 0;
+        profileCaptured = false;
+    }
 
-            if (frameSamples < static_cast<size_t> (hopSize))
-                break; // Not enough samples for another frame
+    void processChannel (float* channelData, int numSamples, int channel)
+    {
+        const bool reducing = !bypassed && profileCaptured && reductionAmount > 0.0f;
 
-            // 1. Copy and window the input frame
-            std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
-            for (size_t i = 0; i < frameSamples; ++i)
-            {
-                fftBuffer[i] = channelData[pos + i] * windowBuffer[i];
-            }
+        // Single resolution: without reduction or capture the engine only delays the signal
+        if (!multiResolution)
+        {
+            if (!reducing && !isCapturingProfile)
+                paths[0].stft.processBypassed (channelData, numSamples, channel);
+            else
+                paths[0].stft.process (channelData, numSamples, channel,
+                                       [this] (float* spectrum, int) { processSpectrum (paths[0], spectrum); });
+            return;
+        }
 
-            // 2. Forward FFT (real to complex)
-            fft->performRealOnlyForwardTransform (fftBuffer.data());
+        // Multi-resolution: lows from the long FFT, highs from the short FFT.
+        // Both paths always run so the crossover stays complementary.
+        for (int offset = 0; offset < numSamples; offset += maxBlockSize)
+        {
+            const int count = juce::jmin (maxBlockSize, numSamples - offset);
+            float* data = channelData + offset;
+            float* highs = shortPathScratch.data();
 
-            // 3. Spectral subtraction
-            performSpectralSubtraction();
+            std::copy (data, data + count, highs);
 
-            // 4. Inverse FFT (complex to real)
-            fft->performRealOnlyInverseTransform (fftBuffer.data());
+            paths[0].stft.process (data, count, channel,
+                                   [this] (float* spectrum, int) { processSpectrum (paths[0], spectrum); });
+            paths[1].stft.process (highs, count, channel,
+                                   [this] (float* spectrum, int) { processSpectrum (paths[1], spectrum); });
 
-            // 5. Overlap-add with output windowing
-            // For 75% overlap (4x overlap) with Hann window, normalization factor is 1.5
-            const float normFactor = 1.5f;
+            delayAndAdd (highs, data, count, channel, offset);
+        }
+    }
 
-            for (size_t i = 0; i < frameSamples; ++i)
-            {
-                if (pos + i < numSamples)
-                {
-                    // Apply window and normalize for overlap-add
-                    channelData[pos + i] = fftBuffer[i] * windowBuffer[i] / (fftSize * normFactor);
-
-                    // Add overlap from previous frame
-                    if (channel < overlapBuffer.getNumChannels() && i < static_cast<size_t> (overlapBuffer.getNumSamples()))
-                    {
-                        channelData[pos + i] += overlapBuffer.getSample (channel, static_cast<int> (i));
-                    }
-                }
-            }
+    void processSpectrum (SpectralPath& path, float* spectrum)
+    {
+        const int numBins = path.stft.getNumBins();
 
-            // 6. Store overlap for next frame
-            if (channel < overlapBuffer.getNumChannels())
-            {
-                for (int i = 0; i < overlapBuffer.getNumSamples(); ++i)
-                {
-                    if (static_cast<size_t> (i) + hopSize < frameSamples)
-                    {
-                        overlapBuffer.setSample (channel, i,
-                            fftBuffer[i + hopSize] * windowBuffer[i + hopSize] / (fftSize * normFactor));
-                    }
-                    else
-                    {
-                        overlapBuffer.setSample (channel, i, 0.0f);
-                    }
-                }
-            }
+        if (isCapturingProfile)
+        {
+            // Accumulate magnitude spectrum (averaged across all channels)
+            SpectralGain::accumulateMagnitudes (spectrum, path.noiseProfile.data(), numBins);
+            ++path.captureFrames;
+        }
+        else if (!bypassed && profileCaptured && reductionAmount > 0.0f)
+        {
+            // Scale each bin by a magnitude-ratio gain mask; the phase is left untouched
+            SpectralGain::Parameters params;
+            params.reductionLinear = reductionLinear;
+            params.spectralFloor = spectralFloor;
+            params.adaptiveRate = adaptiveEnabled ? adaptiveRate : 0.0f;
+            params.adaptiveThreshold = adaptiveThreshold;
+
+            path.gain.process (spectrum, path.noiseProfile.data(), params);
         }
+
+        if (!path.crossoverMask.empty())
+            SpectralGain::applyGains (spectrum, path.crossoverMask.data(), numBins);
     }
 
-    void performSpectralSubtraction()
-    {
-        // Process magnitude spectrum: subtract noise profile
-        // Complex FFT output format: [real0, real1, ..., realN/2, imag1, ..., imagN/2-1]
-
-        int numBins = fftSize / 2 + 1;
-
-        for (int bin = 0; bin < numBins; ++bin)
-        {
-            float real, imag;
-
-            // Extract real and imaginary parts from JUCE FFT format
-            if (bin == 0)
-            {
-                real = fftBuffer[0];
-                imag = 0.0f;
-            }
-            else if (bin == fftSize / 2)
-            {
-                real = fftBuffer[fftSize / 2];
-                imag = 0.0f;
-            }
-            else
-            {
-                real = fftBuffer[bin];
-                imag = fftBuffer[fftSize - bin];
-            }
+    void finishStreamingCapture()
+    {
+        // Capture length is counted in frames of the primary (longest) path
+        if (!isCapturingProfile || paths[0].captureFrames < maxCaptureFrames)
+            return;
 
-            // Calculate magnitude and phase
-            float magnitude = std::sqrt (real * real + imag * imag);
-            float phase = std::atan2 (imag, real);
-
-            // Adaptive noise profile update (only when likely noise-dominant)
-            if (adaptiveEnabled && profileCaptured && adaptiveRate > 0.0f)
-            {
-                float profile = noiseProfile[static_cast<size_t> (bin)];
-                if (magnitude <= profile * adaptiveThreshold)
-                    noiseProfile[static_cast<size_t> (bin)] = profile + adaptiveRate * (magnitude - profile);
-            }
-
-            // Spectral subtraction with over-subtraction factor
-            float noiseMag = noiseProfile[static_cast<size_t> (bin)] * reductionLinear;
-            float cleanMag = magnitude - noiseMag;
-
-            // Apply spectral floor to prevent musical noise
-            cleanMag = juce::jmax (cleanMag, magnitude * spectralFloor);
-
-            // Reconstruct complex number with cleaned magnitude and original phase
-            real = cleanMag * std::cos (phase);
-            imag = cleanMag * std::sin (phase);
-
-            // Store back in JUCE FFT format
-            if (bin == 0)
-            {
-                fftBuffer[0] = real;
-            }
-            else if (bin == fftSize / 2)
-            {
-                fftBuffer[fftSize / 2] = real;
-            }
-            else
-            {
-                fftBuffer[bin] = real;
-                fftBuffer[fftSize - bin] = imag;
-            }
-        }
+        for (int p = 0; p < getNumActivePaths(); ++p)
+            normaliseProfile (paths[static_cast<size_t> (p)]);
+
+        profileCaptured = true;
+        isCapturingProfile = false;
     }
 
-    void captureProfileFromBlock (const juce::dsp::AudioBlock<float>& block)
+    static void normaliseProfile (SpectralPath& path)
     {
-        if (!isCapturingProfile || profileCaptureFrames >= maxCaptureFrames)
+        if (path.captureFrames <= 0)
             return;
 
-        // Average noise profile across all channels
-        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
-        {
-            const float* channelData = block.getChannelPointer (channel);
-            size_t numSamples = block.getNumSamples();
+        // Normalize averaged profile
+        const float scale = 1.0f / static_cast<float> (path.captureFrames);
+        for (auto& val : path.noiseProfile)
+            val *= scale;
+    }
 
-            // Process each frame in the block
-            for (size_t pos = 0; pos < numSamples && profileCaptureFrames < maxCaptureFrames; pos += hopSize)
-            {
-                size_t frameEnd = juce::jmin (pos + fftSize, numSamples);
-                size_t frameSamples = frameEnd - pos;
+    /** Maps a magnitude profile between FFT sizes (magnitudes scale with the window length) */
+    static void resampleProfile (const std::vector<float>& source, int sourceSize,
+                                 std::vector<float>& dest, int destSize)
+    {
+        const int sourceBins = static_cast<int> (source.size());
+        const float binRatio = static_cast<float> (sourceSize) / static_cast<float> (destSize);
+        const float levelRatio = static_cast<float> (destSize) / static_cast<float> (sourceSize);
 
-                if (frameSamples < static_cast<size_t> (fftSize / 2))
-                    break;
+        for (size_t bin = 0; bin < dest.size(); ++bin)
+        {
+            const float position = static_cast<float> (bin) * binRatio;
+            const int index = juce::jlimit (0, sourceBins - 1, static_cast<int> (position));
+            const int next = juce::jmin (sourceBins - 1, index + 1);
+            const float frac = position - static_cast<float> (index);
 
-                // Copy and window the frame
-                std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
-                for (size_t i = 0; i < frameSamples; ++i)
-                {
-                    fftBuffer[i] = channelData[pos + i] * windowBuffer[i];
-                }
+            dest[bin] = (source[static_cast<size_t> (index)] * (1.0f - frac)
+                         + source[static_cast<size_t> (next)] * frac) * levelRatio;
+        }
+    }
 
-                // Forward FFT
-                fft->performRealOnlyForwardTransform (fftBuffer.data());
+    void buildCrossoverMasks()
+    {
+        // Complementary raised-cosine crossover, one octave wide on a log-frequency axis
+        auto lowWeight = [this] (float frequency)
+        {
+            const float lowEdge = crossoverFrequency / juce::MathConstants<float>::sqrt2;
+            const float highEdge = crossoverFrequency * juce::MathConstants<float>::sqrt2;
 
-                // Accumulate magnitude spectrum
-                int numBins = fftSize / 2 + 1;
-                for (int bin = 0; bin < numBins; ++bin)
-                {
-                    float real, imag;
-
-                    // Extract real and imaginary parts
-                    if (bin == 0)
-                    {
-                        real = fftBuffer[0];
-                        imag = 0.0f;
-                    }
-                    else if (bin == fftSize / 2)
-                    {
-                        real = fftBuffer[fftSize / 2];
-                        imag = 0.0f;
-                    }
-                    else
-                    {
-                        real = fftBuffer[bin];
-                        imag = fftBuffer[fftSize - bin];
-                    }
-
-                    // Accumulate magnitude
-                    float magnitude = std::sqrt (real * real + imag * imag);
-                    noiseProfile[static_cast<size_t> (bin)] += magnitude;
-                }
+            if (frequency <= lowEdge)
+                return 1.0f;
+            if (frequency >= highEdge)
+                return 0.0f;
 
-                profileCaptureFrames++;
+            const float t = std::log2 (frequency / lowEdge);
+            return 0.5f + 0.5f * std::cos (juce::MathConstants<float>::pi * t);
+        };
 
-                // Check if we've captured enough
-                if (profileCaptureFrames >= maxCaptureFrames)
-                {
-                    // Normalize averaged profile
-                    for (auto& val : noiseProfile)
-                    {
-                        val /= static_cast<float> (maxCaptureFrames);
-                    }
-
-                    profileCaptured = true;
-                    isCapturingProfile = false;
-                    return;
-                }
+        for (int p = 0; p < 2; ++p)
+        {
+            auto& path = paths[static_cast<size_t> (p)];
+            const int numBins = path.stft.getNumBins();
+            const float binWidth = static_cast<float> (sampleRate) / static_cast<float> (path.stft.getFFTSize());
+
+            path.crossoverMask.resize (static_cast<size_t> (numBins));
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                const float low = lowWeight (static_cast<float> (bin) * binWidth);
+                path.crossoverMask[static_cast<size_t> (bin)] = (p == 0) ? low : 1.0f - low;
             }
         }
     }
 
+    void delayAndAdd (const float* highs, float* output, int numSamples, int channel, int blockOffset)
+    {
+        if (alignmentDelay <= 0)
+        {
+            juce::FloatVectorOperations::add (output, highs, numSamples);
+            return;
+        }
+
+        float* ring = alignmentBuffer.getWritePointer (channel);
+        int position = (alignmentPosition + blockOffset) % alignmentDelay;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            output[i] += ring[position];
+            ring[position] = highs[i];
+
+            if (++position == alignmentDelay)
+                position = 0;
+        }
+    }
+
+    void advanceAlignment (int numSamples)
+    {
+        if (alignmentDelay > 0)
+            alignmentPosition = (alignmentPosition + numSamples) % alignmentDelay;
+    }
+
+    bool isPrepared() const { return paths[0].stft.isPrepared(); }
+    int getNumActivePaths() const { return multiResolution ? 2 : 1; }
+
     //==============================================================================
+    static constexpr int minFftOrder = 8;   // 256 samples
+    static constexpr int maxFftOrder = 13;  // 8192 samples
+
     double sampleRate = 44100.0;
     juce::uint32 numChannels = 2;
+    int maxBlockSize = 2048;
 
     // FFT parameters
-    int fftOrder = 11;
+    int fftOrder = 11; // 2048 samples
     int fftSize = 2048;
     int hopSize = 512;
-    std::unique_ptr<juce::dsp::FFT> fft;
-
-    // Buffers
-    std::vector<float> fftBuffer;
-    std::vector<float> windowBuffer;
-    juce::AudioBuffer<float> overlapBuffer;
-    int processingPosition = 0;
-
-    // Noise profile
-    std::vector<float> noiseProfile;
+    Overlap overlap = Overlap::percent75;
+    bool multiResolution = false;
+    const float crossoverFrequency = 1500.0f;
+
+    // STFT paths: [0] = selected size, [1] = short FFT (multi-resolution only)
+    std::array<SpectralPath, 2> paths;
+    juce::AudioBuffer<float> alignmentBuffer;
+    std::vector<float> shortPathScratch;
+    int alignmentDelay = 0;
+    int alignmentPosition = 0;
+
+    // Noise profile state
     bool profileCaptured = false;
     bool isCapturingProfile = false;
-    int profileCaptureFrames = 0;
     const int maxCaptureFrames = 20; // Average over ~1 second
 
     // Parameters
-    float reductionAmount = 0.0f;
-    float reductionLinear = 1.0f;
-    const float spectralFloor = 0.01f; // -40 dB
-    bool adaptiveEnabled = false;
-    float adaptiveRate = 0.0f;
-    const float adaptiveThreshold = 1.5f;
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoiseReduction)
-};
+    float reductionAmount = 0.0f;
+    float reductionLinear = 1.0f;
+    const float spectralFloor = 0.01f; // -40 dB
+    bool bypassed = false;
+    bool adaptiveEnabled = false;
+    float adaptiveRate = 0.0f;
+    const float adaptiveThreshold = 1.5f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoiseReduction)
+};
@@ -0,0 +1,211 @@
+#include "OfflineChain.h"
+#include "../Utils/StageProfiler.h"
+
+OfflineChain::OfflineChain (int numChannelsToUse, int blockSizeToUse)
+    : numChannels (juce::jmax (1, numChannelsToUse)),
+      blockSize (juce::jmax (1, blockSizeToUse)),
+      silence (numChannels, blockSize)
+{
+    silence.clear();
+}
+
+void OfflineChain::addStage (Process process, int latency, int holdSamples, Analyse analyse)
+{
+    auto stage = std::make_unique<Stage>();
+    stage->process = std::move (process);
+    stage->analyse = std::move (analyse);
+    stage->latency = juce::jmax (0, latency);
+    stage->toDrop = stage->latency;
+    stage->block.setSize (numChannels, blockSize);
+    stage->name = "Stage " + juce::String (static_cast<int> (stages.size()) + 1);
+
+    if (holdSamples > 0)
+    {
+        stage->held.setSize (numChannels, holdSamples);
+        stage->holding = true;
+    }
+
+    stages.push_back (std::move (stage));
+}
+
+void OfflineChain::setStageName (int index, const juce::String& name)
+{
+    if (juce::isPositiveAndBelow (index, getNumStages()))
+        stages[static_cast<size_t> (index)]->name = name;
+}
+
+void OfflineChain::setTrace (TraceRecorder* recorder, int threadId)
+{
+    trace = recorder;
+    traceThread = threadId;
+    traceSliceStart = juce::Time::getHighResolutionTicks();
+    traceSliceTicks = juce::Time::getHighResolutionTicksPerSecond() / 20;
+}
+
+bool OfflineChain::push (const juce::AudioBuffer<float>& source, int startSample, int numSamples)
+{
+    const bool ok = numSamples <= 0 || pushTo (0, source, startSample, numSamples);
+    flushTrace (false);
+    return ok;
+}
+
+bool OfflineChain::finish()
+{
+    for (size_t index = 0; index < stages.size(); ++index)
+    {
+        auto& stage = *stages[index];
+
+        if (stage.holding && !release (index))
+            return false;
+
+        if (stage.process == nullptr)
+            continue;
+
+        for (int remaining = stage.latency; remaining > 0; remaining -= blockSize)
+            if (!pushTo (index, silence, 0, juce::jmin (blockSize, remaining)))
+                return false;
+    }
+
+    flushTrace (true);
+    return true;
+}
+
+bool OfflineChain::processRegion (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                  std::function<bool (double)> progressCallback)
+{
+    const int totalSamples = buffer.getNumSamples();
+    startSample = juce::jlimit (0, totalSamples, startSample);
+    numSamples = juce::jlimit (0, totalSamples - startSample, numSamples);
+
+    const int channelsToProcess = juce::jmin (numChannels, buffer.getNumChannels());
+    int writePosition = startSample;
+
+    setSink ([&buffer, &writePosition, channelsToProcess] (const juce::AudioBuffer<float>& output, int outputStart, int count)
+    {
+        for (int channel = 0; channel < channelsToProcess; ++channel)
+            buffer.copyFrom (channel, writePosition, output, channel, outputStart, count);
+
+        writePosition += count;
+        return true;
+    });
+
+    // Blocks are copied into the first stage before anything is written back
+    for (int done = 0; done < numSamples; done += blockSize)
+    {
+        if (progressCallback != nullptr && !progressCallback (done / static_cast<double> (numSamples)))
+            return false;
+
+        push (buffer, startSample + done, juce::jmin (blockSize, numSamples - done));
+    }
+
+    finish();
+    jassert (writePosition == startSample + numSamples);
+    return true;
+}
+
+bool OfflineChain::pushTo (size_t index, const juce::AudioBuffer<float>& source, int startSample, int numSamples)
+{
+    if (index == stages.size())
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            peakLevel = juce::jmax (peakLevel, source.getMagnitude (channel, startSample, numSamples));
+
+        return sink == nullptr || sink (source, startSample, numSamples);
+    }
+
+    auto& stage = *stages[index];
+
+    if (stage.holding)
+    {
+        const int toHold = juce::jmin (numSamples, stage.held.getNumSamples() - stage.numHeld);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            stage.held.copyFrom (channel, stage.numHeld, source, channel, startSample, toHold);
+
+        stage.numHeld += toHold;
+        startSample += toHold;
+        numSamples -= toHold;
+
+        if (stage.numHeld < stage.held.getNumSamples())
+            return true;
+
+        if (!release (index))
+            return false;
+    }
+
+    if (stage.process == nullptr)
+        return numSamples <= 0 || pushTo (index + 1, source, startSample, numSamples);
+
+    for (int done = 0; done < numSamples; done += blockSize)
+    {
+        const int samplesThisBlock = juce::jmin (blockSize, numSamples - done);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            stage.block.copyFrom (channel, 0, source, channel, startSample + done, samplesThisBlock);
+
+        juce::dsp::AudioBlock<float> block (stage.block.getArrayOfWritePointers(),
+                                            static_cast<size_t> (numChannels), 0,
+                                            static_cast<size_t> (samplesThisBlock));
+        juce::dsp::ProcessContextReplacing<float> context (block);
+
+        if (trace != nullptr)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            stage.process (context);
+            stage.sliceTicks += juce::Time::getHighResolutionTicks() - start;
+        }
+        else
+        {
+            stage.process (context);
+        }
+
+        const int dropped = juce::jmin (stage.toDrop, samplesThisBlock);
+        stage.toDrop -= dropped;
+
+        if (dropped < samplesThisBlock && !pushTo (index + 1, stage.block, dropped, samplesThisBlock - dropped))
+            return false;
+    }
+
+    return true;
+}
+
+bool OfflineChain::release (size_t index)
+{
+    auto& stage = *stages[index];
+    stage.holding = false;
+
+    if (stage.analyse != nullptr && !stage.analyse (stage.held, stage.numHeld))
+        stage.process = nullptr;
+
+    // The held samples go through the stage now, and on to the rest of the chain
+    const bool ok = stage.numHeld == 0 || pushTo (index, stage.held, 0, stage.numHeld);
+    stage.held.setSize (0, 0);
+    stage.numHeld = 0;
+    return ok;
+}
+
+void OfflineChain::flushTrace (bool force)
+{
+    if (trace == nullptr)
+        return;
+
+    const auto now = juce::Time::getHighResolutionTicks();
+
+    if (!force && now - traceSliceStart < traceSliceTicks)
+        return;
+
+    // The stages interleave block by block; their totals go end to end instead
+    auto position = traceSliceStart;
+
+    for (auto& stage : stages)
+    {
+        if (stage->sliceTicks <= 0)
+            continue;
+
+        trace->addEvent (stage->name, "stage", traceThread, position, position + stage->sliceTicks);
+        position += stage->sliceTicks;
+        stage->sliceTicks = 0;
+    }
+
+    traceSliceStart = now;
+}
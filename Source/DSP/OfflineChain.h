@@ -0,0 +1,121 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class TraceRecorder;
+
+/**
+ * Offline Chain
+ *
+ * Runs several offline stages back to back on each block, instead of one
+ * full pass over the audio per stage, so a block is still in cache when the
+ * next stage reads it. Every stage processes in place with its latency
+ * compensated as in the processBufferRegion() helpers: its first `latency`
+ * outputs are dropped and as many zeros flush its end, so the output lines
+ * up with the input sample for sample.
+ *
+ * A stage can hold back its first samples and analyse them before it
+ * processes any (e.g. to capture a noise profile from the audio the earlier
+ * stages produced); the analysis may bypass the stage. The peak level of
+ * everything the chain emits is tracked on the way out, so normalizing the
+ * result takes a single gain sweep.
+ *
+ * The audio comes from push() and goes to the sink, or processRegion() runs a
+ * buffer region through in place. Prepare and configure the processors
+ * first; the chain only calls them. A chain runs one stream, so build a new
+ * one for the next. Not for the audio thread.
+ *
+ * With a TraceRecorder attached, the time each stage spends is recorded in
+ * slices of about 50 ms: one event per stage and slice, laid end to end from
+ * the start of the slice. That shows each stage's share of the work without
+ * an event for every block.
+ */
+class OfflineChain
+{
+public:
+    using Process = std::function<void (juce::dsp::ProcessContextReplacing<float>&)>;
+    using Analyse = std::function<bool (const juce::AudioBuffer<float>& held, int numSamples)>;    // false: bypass the stage
+    using Sink = std::function<bool (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)>;
+
+    OfflineChain (int numChannels, int blockSize = 2048);
+
+    //==============================================================================
+    void addStage (Process process, int latency, int holdSamples = 0, Analyse analyse = nullptr);
+
+    /** Adds a processor with process (context) and getLatencySamples() */
+    template <typename Processor>
+    void addProcessor (Processor& processor, int holdSamples = 0, Analyse analyse = nullptr)
+    {
+        addStage ([&processor] (juce::dsp::ProcessContextReplacing<float>& context) { processor.process (context); },
+                  processor.getLatencySamples(), holdSamples, std::move (analyse));
+    }
+
+    int getNumStages() const { return static_cast<int> (stages.size()); }
+
+    /** Name of a stage in traces (default "Stage <index + 1>") */
+    void setStageName (int index, const juce::String& name);
+
+    /** Records stage times as events on threadId of recorder, or nothing if nullptr */
+    void setTrace (TraceRecorder* recorder, int threadId);
+
+    //==============================================================================
+    /** Receives the output, in order; returning false stops the chain */
+    void setSink (Sink newSink) { sink = std::move (newSink); }
+
+    /** Feeds the next samples; false if the sink failed */
+    bool push (const juce::AudioBuffer<float>& source, int startSample, int numSamples);
+
+    /** Releases held samples and flushes each stage in order, after the last push() */
+    bool finish();
+
+    /**
+     * Runs a region of a buffer through the chain in place (replacing the sink).
+     * Output lags input, so writes never overtake unread samples. The optional
+     * callback receives progress (0-1) and returns false to cancel, in which
+     * case the region is left partly processed. Returns false if cancelled.
+     */
+    bool processRegion (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                        std::function<bool (double)> progressCallback = nullptr);
+
+    /** Largest absolute sample emitted so far, over all channels */
+    float getPeakLevel() const { return peakLevel; }
+
+private:
+    //==============================================================================
+    struct Stage
+    {
+        Process process;
+        Analyse analyse;
+        int latency = 0;
+        int toDrop = 0;                         // Leading outputs still to drop
+        juce::AudioBuffer<float> block;
+        juce::AudioBuffer<float> held;
+        int numHeld = 0;
+        bool holding = false;
+        juce::String name;
+        juce::int64 sliceTicks = 0;             // Time processing in the current trace slice
+    };
+
+    bool pushTo (size_t index, const juce::AudioBuffer<float>& source, int startSample, int numSamples);
+    bool release (size_t index);
+    void flushTrace (bool force);
+
+    //==============================================================================
+    const int numChannels;
+    const int blockSize;
+    juce::AudioBuffer<float> silence;
+    Sink sink;
+    std::vector<std::unique_ptr<Stage>> stages;
+    float peakLevel = 0.0f;
+
+    TraceRecorder* trace = nullptr;
+    int traceThread = 0;
+    juce::int64 traceSliceStart = 0;
+    juce::int64 traceSliceTicks = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineChain)
+};
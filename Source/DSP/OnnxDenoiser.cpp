@@ -1,4 +1,5 @@
 #include "OnnxDenoiser.h"
+#include "../Utils/RealtimeDiagnostics.h"
 
 #if defined(ENABLE_ONNX_RUNTIME)
 #include <onnxruntime_c_api.h>
@@ -147,74 +148,403 @@ static bool appendQnnProvider (Ort::SessionOptions& options, const juce::String&
 }
 #endif
 
+//==============================================================================
+namespace
+{
+    struct SharedEnvironment
+    {
+        juce::CriticalSection lock;
+        OnnxDenoiser::ThreadingSettings settings;
+        std::unique_ptr<Ort::Env> env;
+    };
+
+    SharedEnvironment& getSharedEnvironment()
+    {
+        static SharedEnvironment shared;
+        return shared;
+    }
+}
+
+void OnnxDenoiser::setThreadingSettings (const ThreadingSettings& settings)
+{
+    auto& shared = getSharedEnvironment();
+    const juce::ScopedLock sl (shared.lock);
+    shared.settings = settings;
+
+    if (shared.env != nullptr)
+        DBG ("OnnxDenoiser: Thread pool already running, new threading settings apply after a restart");
+}
+
+Ort::Env& OnnxDenoiser::getSharedEnv()
+{
+    auto& shared = getSharedEnvironment();
+    const juce::ScopedLock sl (shared.lock);
+
+    if (shared.env != nullptr)
+        return *shared.env;
+
+    // One global pool instead of a pair per session: with many instances in a
+    // project, CPU use and context switches no longer grow with the count
+    const auto& settings = shared.settings;
+    const int intraOpThreads = juce::jlimit (1, juce::jmax (1, juce::SystemStats::getNumCpus()), settings.intraOpThreads);
+
+    Ort::ThreadingOptions threading;
+    threading.SetGlobalIntraOpNumThreads (intraOpThreads);
+    threading.SetGlobalInterOpNumThreads (1);
+    threading.SetGlobalSpinControl (settings.allowSpinning ? 1 : 0);
+    threading.SetGlobalDenormalAsZero();
+
+    // ORT expects one affinity group per pool thread; the calling thread is not part of the pool
+    const auto affinity = settings.intraOpAffinity.trim();
+    if (affinity.isNotEmpty())
+    {
+        juce::StringArray groups;
+        groups.addTokens (affinity, ";", "");
+        groups.removeEmptyStrings();
+
+        if (groups.size() == intraOpThreads - 1)
+        {
+            const OrtApi& api = Ort::GetApi();
+            if (OrtStatus* status = api.SetGlobalIntraOpThreadAffinity (threading, affinity.toRawUTF8()))
+            {
+                DBG ("OnnxDenoiser: Ignoring thread affinity '" + affinity + "': " + juce::String (api.GetErrorMessage (status)));
+                api.ReleaseStatus (status);
+            }
+        }
+        else
+        {
+            DBG ("OnnxDenoiser: Ignoring thread affinity '" + affinity + "', expected "
+                 + juce::String (intraOpThreads - 1) + " groups");
+        }
+    }
+
+    shared.env = std::make_unique<Ort::Env> (threading, ORT_LOGGING_LEVEL_WARNING, "VRS_OnnxDenoiser");
+    return *shared.env;
+}
+
+//==============================================================================
+class OnnxDenoiser::InferenceThread : public juce::Thread
+{
+public:
+    explicit InferenceThread (OnnxDenoiser& ownerToUse)
+        : juce::Thread ("OnnxInferenceThread"),
+          owner (ownerToUse)
+    {
+    }
+
+    void run() override
+    {
+        // Polled rather than notified, so the audio thread never touches a mutex;
+        // a 1 ms idle wait is small next to the deadline
+        while (!threadShouldExit())
+        {
+            if (!owner.runQueuedFrames())
+                wait (1);
+        }
+    }
+
+private:
+    OnnxDenoiser& owner;
+};
+
+class OnnxDenoiser::SessionLoader : public juce::Thread
+{
+public:
+    explicit SessionLoader (OnnxDenoiser& ownerToUse)
+        : juce::Thread ("OnnxSessionLoader"),
+          owner (ownerToUse)
+    {
+    }
+
+    void run() override
+    {
+        owner.loadDefaultModel();
+
+        if (!owner.cancelLoad.load() && owner.onSessionLoaded != nullptr)
+            owner.onSessionLoaded();
+    }
+
+private:
+    OnnxDenoiser& owner;
+};
+
+//==============================================================================
 OnnxDenoiser::OnnxDenoiser()
-    : env (ORT_LOGGING_LEVEL_WARNING, "VRS_OnnxDenoiser"),
-      sessionOptions(),
-      memoryInfo (Ort::MemoryInfo::CreateCpu (OrtArenaAllocator, OrtMemTypeDefault))
+    : memoryInfo (Ort::MemoryInfo::CreateCpu (OrtArenaAllocator, OrtMemTypeDefault))
 {
-    sessionOptions.SetIntraOpNumThreads (1);
-    sessionOptions.SetInterOpNumThreads (1);
-    sessionOptions.SetGraphOptimizationLevel (GraphOptimizationLevel::ORT_ENABLE_BASIC);
 }
 
 OnnxDenoiser::~OnnxDenoiser()
 {
+    cancelSessionLoad();
+    releaseSession();
+}
+
+void OnnxDenoiser::releaseSession()
+{
+    sessionActive.store (false);
+
+    // The worker runs the bindings, and the bindings refer to the session
+    stopInferenceThread();
+    boundRuns.clear();
+
+    for (auto& channel : channels)
+        channel.recurrent.reset();
+
+    stateTensors.clear();
+    stateSize = 0;
     session.reset();
 }
 
 void OnnxDenoiser::prepare (double newSampleRate, int newNumChannels, int maxBlockSize)
 {
+    // A background load installs its session after this returns, with these settings
+    const juce::ScopedLock sl (sessionLock);
+    stopInferenceThread();
+
     hostSampleRate = newSampleRate;
     numChannels = newNumChannels;
     maxBlock = maxBlockSize;
 
-    resampleInRatio = hostSampleRate / modelSampleRate;
-    resampleOutRatio = modelSampleRate / hostSampleRate;
+    // Both temp buffers hold one host block at the model rate; sized here so processBlock never allocates
+    const int hostBlockSize = juce::jmax (1, maxBlock);
+    resamplerIn.prepare (hostSampleRate, modelSampleRate, numChannels, hostBlockSize);
+    const size_t modelBlockSize = (size_t) resamplerIn.getMaxOutput (hostBlockSize);
+    resamplerOut.prepare (modelSampleRate, hostSampleRate, numChannels, (int) modelBlockSize);
+
+    resampleOutRatio = resamplerIn.getRatio();
+    resampleInRatio = 1.0 / resampleOutRatio;
+
+    // Async results come back one callback later at the earliest, so the output is
+    // held back by a host block plus the worker's deadline
+    asyncDelaySamples = asyncInference ? (int) modelBlockSize + asyncDeadlineFrames * modelFrameSize : 0;
+
+    // The output FIFO is primed with one frame so it never underruns; each
+    // resampler adds its group delay in its own input rate
+    latencySamples = juce::roundToInt (resamplerIn.getLatencyInInputSamples()
+                                       + (modelFrameSize + asyncDelaySamples + resamplerOut.getLatencyInInputSamples())
+                                         * resampleInRatio);
 
     channels.resize ((size_t) numChannels);
-    int fifoCapacity = modelFrameSize * 32;
+    int fifoCapacity = modelFrameSize * 32 + asyncDelaySamples;
+    frameScratch.assign ((size_t) modelFrameSize, 0.0f);
+    tempInPointers.clear();
+    tempOutPointers.clear();
+
     for (auto& channel : channels)
     {
-        channel.resamplerIn.reset();
-        channel.resamplerOut.reset();
         channel.inputFifo.resize (fifoCapacity);
         channel.outputFifo.resize (fifoCapacity);
-        channel.tempIn.clear();
-        channel.tempOut.clear();
-        channel.frameIn.resize ((size_t) modelFrameSize);
-        channel.frameOut.resize ((size_t) modelFrameSize);
+        channel.dryFifo.resize (latencySamples + juce::jmax (1, maxBlock) * 4);
+        channel.pendingFrames.resize (fifoCapacity);
+        channel.framesDelivered = channel.framesSubmitted;
+        channel.tempIn.assign (modelBlockSize, 0.0f);
+        channel.tempOut.assign ((size_t) resamplerOut.getMaxInputRequired (hostBlockSize), 0.0f);
+        channel.dryTemp.assign ((size_t) hostBlockSize, 0.0f);
+        tempInPointers.push_back (channel.tempIn.data());
+        tempOutPointers.push_back (channel.tempOut.data());
+        primeFifos (channel);
     }
 
-    loadDefaultModelIfNeeded();
+    resetPending = false;
+
+    // Batch buffers depend on the block size and channel count; a new session builds them itself
+    if (session != nullptr)
+        prepareBindings();
+    else
+        loadDefaultModelAsync();
 }
 
 void OnnxDenoiser::reset()
 {
+    resamplerIn.reset();
+    resamplerOut.reset();
+
     for (auto& channel : channels)
     {
-        channel.resamplerIn.reset();
-        channel.resamplerOut.reset();
         channel.inputFifo.clear();
         channel.outputFifo.clear();
+        channel.dryFifo.clear();
+        primeFifos (channel);
+
+        // Results still in flight belong to the old stream and are dropped on arrival
+        channel.pendingFrames.clear();
+        channel.framesDelivered = channel.framesSubmitted;
+
+        // The inference thread owns the state, so it clears it before its next frame
+        if (channel.recurrent != nullptr)
+            channel.recurrent->clearPending.store (true);
     }
 }
 
+void OnnxDenoiser::primeFifos (ChannelState& state)
+{
+    // Silence worth one frame plus the async budget (wet) and the full latency (dry)
+    // keeps both paths aligned and gives the output FIFO enough headroom to never run dry
+    const float silence[modelFrameSize] = {};
+    for (int remaining = modelFrameSize + asyncDelaySamples; remaining > 0; remaining -= modelFrameSize)
+        state.outputFifo.push (silence, juce::jmin (remaining, modelFrameSize));
+
+    for (int remaining = latencySamples; remaining > 0; remaining -= modelFrameSize)
+        state.dryFifo.push (silence, juce::jmin (remaining, modelFrameSize));
+}
+
 void OnnxDenoiser::setModelPath (const juce::File& file)
 {
+    // Re-applying unchanged settings keeps the session, so a reload costs nothing
+    if (file == modelPath)
+        return;
+
+    cancelSessionLoad();
     modelPath = file;
-    session.reset();
+    releaseSession();
 }
 
 void OnnxDenoiser::clearModelPath()
 {
-    modelPath = juce::File();
-    session.reset();
+    setModelPath (juce::File());
 }
 
 void OnnxDenoiser::setPreferredProvider (Provider provider)
 {
+    if (provider == preferredProvider)
+        return;
+
+    cancelSessionLoad();
     preferredProvider = provider;
-    session.reset();
+    releaseSession();
+}
+
+void OnnxDenoiser::setAutoProvider (Provider provider)
+{
+    if (provider == autoProvider)
+        return;
+
+    autoProvider = provider;
+
+    // Only a session chosen by Auto depends on it
+    if (preferredProvider == Provider::autoSelect)
+    {
+        cancelSessionLoad();
+        releaseSession();
+    }
+}
+
+std::vector<OnnxDenoiser::ProviderBenchmark> OnnxDenoiser::benchmarkProviders (std::function<bool()> shouldContinue) const
+{
+    std::vector<ProviderBenchmark> results;
+
+    for (const auto provider : { Provider::cpu, Provider::dml, Provider::qnn, Provider::cuda, Provider::rocm, Provider::coreml })
+    {
+        if (shouldContinue != nullptr && !shouldContinue())
+            break;
+
+        if (!isProviderUsable (provider))
+            continue;
+
+        // A session of its own with this instance's model and device settings, never this one's
+        OnnxDenoiser tester;
+        tester.preferredProvider = provider;
+        tester.allowFallback = false;
+        tester.dmlDeviceId = dmlDeviceId;
+        tester.qnnBackendPath = qnnBackendPath;
+        tester.modelPath = modelPath;
+
+        ProviderBenchmark result;
+        result.provider = provider;
+
+        if (tester.loadDefaultModel() && tester.activeProvider == provider)
+        {
+            result.msPerFrame = tester.measureFrameCost (shouldContinue);
+            result.succeeded = result.msPerFrame > 0.0;
+        }
+
+        DBG ("OnnxDenoiser: Benchmark " + providerToString (provider) + ": "
+             + (result.succeeded ? juce::String (result.msPerFrame, 3) + " ms/frame" : juce::String ("failed")));
+
+        results.push_back (result);
+    }
+
+    return results;
+}
+
+double OnnxDenoiser::measureFrameCost (const std::function<bool()>& shouldContinue)
+{
+    constexpr int warmUpRuns = 3;
+    constexpr int timedRuns = 15;
+
+    double total = 0.0;
+    int measured = 0;
+
+    for (const int frames : { 1, 8, 64 })
+    {
+        // Models without a batch axis, and recurrent models, only ever run single frames
+        if (frames > 1 && !supportsBatching)
+            break;
+
+        // Low-level noise rather than silence, so nothing can shortcut the work
+        std::vector<float> input ((size_t) frames * modelFrameSize);
+        std::vector<float> output (input.size(), 0.0f);
+        juce::Random random (frames);
+        for (auto& sample : input)
+            sample = (random.nextFloat() * 2.0f - 1.0f) * 1.0e-3f;
+
+        BoundRun run;
+        std::unique_ptr<RecurrentStream> stream;
+
+        try
+        {
+            if (isRecurrent())
+                stream = createRecurrentStream();
+            else
+                run = createBoundRun (input.data(), output.data(), frames);
+        }
+        catch (const std::exception&)
+        {
+            return 0.0;
+        }
+
+        std::vector<double> times;
+
+        for (int i = 0; i < warmUpRuns + timedRuns; ++i)
+        {
+            if (shouldContinue != nullptr && !shouldContinue())
+                return 0.0;
+
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            if (!(stream != nullptr ? runRecurrentFrame (*stream, input.data(), output.data()) : runBound (run)))
+                return 0.0;
+
+            if (i >= warmUpRuns)
+                times.push_back (juce::Time::getMillisecondCounterHiRes() - start);
+        }
+
+        std::nth_element (times.begin(), times.begin() + (std::ptrdiff_t) times.size() / 2, times.end());
+        total += times[times.size() / 2] / frames;
+        ++measured;
+    }
+
+    return measured > 0 ? total / measured : 0.0;
+}
+
+juce::String OnnxDenoiser::getBenchmarkSignature() const
+{
+    const auto model = modelPath.existsAsFile() ? modelPath : getDefaultModelFile();
+
+    juce::String key = juce::String (OrtGetApiBase()->GetVersionString())
+                     + "|" + juce::SystemStats::getOperatingSystemName()
+                     + "|" + juce::SystemStats::getCpuModel()
+                     + "|" + juce::String (juce::SystemStats::getNumCpus())
+                     + "|" + juce::String (dmlDeviceId)
+                     + "|" + qnnBackendPath
+                     + "|" + model.getFullPathName()
+                     + "|" + juce::String (model.getSize());
+
+    for (const auto provider : { Provider::dml, Provider::qnn, Provider::cuda, Provider::rocm, Provider::coreml })
+        if (isProviderUsable (provider))
+            key += "|" + providerToString (provider);
+
+    return juce::String::toHexString (key.hashCode64());
 }
 
 juce::String OnnxDenoiser::providerToString (Provider provider)
@@ -253,10 +583,48 @@ OnnxDenoiser::Provider OnnxDenoiser::providerFromString (const juce::String& nam
 }
 
 bool OnnxDenoiser::loadDefaultModelIfNeeded()
+{
+    // A background load already in progress is finished rather than raced
+    if (sessionLoader != nullptr)
+    {
+        sessionLoader->waitForThreadToExit (-1);
+        sessionLoader.reset();
+    }
+
+    return loadDefaultModel();
+}
+
+void OnnxDenoiser::loadDefaultModelAsync()
+{
+    if (isReady() || (sessionLoader != nullptr && sessionLoader->isThreadRunning()))
+        return;
+
+    sessionLoader.reset();
+    cancelLoad.store (false);
+
+    sessionLoader = std::make_unique<SessionLoader> (*this);
+    sessionLoader->startThread (juce::Thread::Priority::low);
+}
+
+void OnnxDenoiser::cancelSessionLoad()
+{
+    if (sessionLoader == nullptr)
+        return;
+
+    // Session creation cannot be interrupted: the loader discards its result instead
+    cancelLoad.store (true);
+    sessionLoader->stopThread (-1);
+    sessionLoader.reset();
+    cancelLoad.store (false);
+}
+
+bool OnnxDenoiser::loadDefaultModel()
 {
     if (session != nullptr)
         return true;
 
+    VRS_RT_NOTE_FILE_IO();
+
     const auto providers = getProviderFallbackOrder();
     const auto candidates = getModelCandidates();
 
@@ -264,6 +632,9 @@ bool OnnxDenoiser::loadDefaultModelIfNeeded()
     // This is more robust than trying each model for all providers
     for (const auto provider : providers)
     {
+        if (cancelLoad.load())
+            return false;
+
         if (!isProviderUsable (provider))
             continue;
 
@@ -281,10 +652,7 @@ bool OnnxDenoiser::loadDefaultModelIfNeeded()
                 continue;
 
             if (tryCreateSessionForProvider (candidate, provider))
-            {
-                modelPath = candidate;
                 return true;
-            }
         }
     }
 
@@ -297,99 +665,513 @@ void OnnxDenoiser::processBlock (juce::AudioBuffer<float>& buffer, float mix)
     if (!enabled)
         return;
 
-    if (mix <= 0.0f)
+    // Sessions are created on the loader thread, never on the audio thread
+    if (!sessionActive.load (std::memory_order_acquire))
         return;
 
-    if (!loadDefaultModelIfNeeded())
-        return;
+    if (resetPending)
+    {
+        reset();
+        resetPending = false;
+    }
 
+    // A zero mix still runs the model, so the reported latency holds at any setting
     mix = juce::jlimit (0.0f, 1.0f, mix);
 
     const int numSamples = buffer.getNumSamples();
     const int channelsToProcess = juce::jmin (buffer.getNumChannels(), (int) channels.size());
 
-    for (int ch = 0; ch < channelsToProcess; ++ch)
+    // Blocks beyond the prepared size are taken in prepared-size pieces, so the scratch always fits
+    if (numSamples > maxBlock && maxBlock > 0)
     {
-        auto* channelData = buffer.getWritePointer (ch);
-        processChannel (channels[(size_t) ch], channelData, channelData, numSamples, mix);
+        for (int offset = 0; offset < numSamples; offset += maxBlock)
+        {
+            juce::AudioBuffer<float> piece (buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                            offset, juce::jmin (maxBlock, numSamples - offset));
+            processBlock (piece, mix);
+        }
+
+        return;
     }
+
+    // Every ready frame of every channel goes to the model in one Run
+    pushInput (buffer.getArrayOfReadPointers(), channelsToProcess, numSamples);
+
+    if (inferenceThread != nullptr)
+    {
+        submitReadyFrames (channelsToProcess);
+        collectResults();
+    }
+    else
+    {
+        runReadyFrames (channelsToProcess);
+    }
+
+    pullOutput (buffer.getArrayOfWritePointers(), channelsToProcess, numSamples, mix);
 }
 
-void OnnxDenoiser::processChannel (ChannelState& state,
-                                   const float* input,
-                                   float* output,
-                                   int numSamples,
-                                   float mix)
+void OnnxDenoiser::pushInput (const float* const* input, int channelsToProcess, int numSamples)
 {
-    const int targetSamples = (int) std::ceil (numSamples / resampleInRatio);
-    if ((int) state.tempIn.size() < targetSamples)
-        state.tempIn.resize ((size_t) targetSamples);
+    // The buffer is processed in place: keep the dry signal before anything is written
+    for (int ch = 0; ch < channelsToProcess; ++ch)
+        channels[(size_t) ch].dryFifo.push (input[ch], numSamples);
+
+    // Already at the model rate: straight into the FIFOs, no copy
+    if (resamplerIn.isBypassed())
+    {
+        for (int ch = 0; ch < channelsToProcess; ++ch)
+            channels[(size_t) ch].inputFifo.push (input[ch], numSamples);
+
+        return;
+    }
 
-    const int producedSamples = state.resamplerIn.process (resampleInRatio,
-                                                           input,
-                                                           state.tempIn.data(),
-                                                           targetSamples);
-    state.inputFifo.push (state.tempIn.data(), producedSamples);
+    const int produced = resamplerIn.process (input, channelsToProcess, numSamples,
+                                              tempInPointers.data(), (int) channels[0].tempIn.size());
 
-    while (state.inputFifo.available() >= modelFrameSize)
+    for (int ch = 0; ch < channelsToProcess; ++ch)
+        channels[(size_t) ch].inputFifo.push (tempInPointers[(size_t) ch], produced);
+}
+
+void OnnxDenoiser::runReadyFrames (int channelsToProcess)
+{
+    for (bool framesLeft = true; framesLeft;)
     {
-        state.inputFifo.pop (state.frameIn.data(), modelFrameSize, false);
-        if (runModel (state.frameIn.data(), state.frameOut.data(), modelFrameSize))
-            state.outputFifo.push (state.frameOut.data(), modelFrameSize);
-        else
-            state.outputFifo.push (state.frameIn.data(), modelFrameSize);
+        int numFrames = 0;
+        framesLeft = false;
+
+        for (int ch = 0; ch < channelsToProcess; ++ch)
+        {
+            auto& state = channels[(size_t) ch];
+
+            while (state.inputFifo.available() >= modelFrameSize && numFrames < maxBatchFrames)
+            {
+                state.inputFifo.pop (batchInput.data() + (size_t) numFrames * modelFrameSize, modelFrameSize, false);
+                batchChannels[(size_t) numFrames++] = ch;
+            }
+
+            // Only when the host exceeded the prepared block size
+            framesLeft = framesLeft || state.inputFifo.available() >= modelFrameSize;
+        }
+
+        if (numFrames == 0)
+            return;
+
+        runFrames (numFrames);
+
+        for (int i = 0; i < numFrames; ++i)
+            channels[(size_t) batchChannels[(size_t) i]].outputFifo.push (batchOutput.data() + (size_t) i * modelFrameSize,
+                                                                         modelFrameSize);
     }
+}
 
-    const int requiredModelSamples = (int) std::ceil (resampleOutRatio * numSamples);
-    if ((int) state.tempOut.size() < requiredModelSamples)
-        state.tempOut.resize ((size_t) requiredModelSamples);
+void OnnxDenoiser::pullOutput (float* const* output, int channelsToProcess, int numSamples, float mix)
+{
+    // Exactly what the resampler needs for numSamples, so the model path never drifts
+    const bool bypassed = resamplerOut.isBypassed();
+    const int requiredModelSamples = resamplerOut.getNumInputRequired (numSamples);
 
-    state.outputFifo.pop (state.tempOut.data(), requiredModelSamples, true);
+    for (int ch = 0; ch < channelsToProcess; ++ch)
+    {
+        auto& state = channels[(size_t) ch];
 
-    state.resamplerOut.process (resampleOutRatio,
-                                state.tempOut.data(),
-                                output,
-                                numSamples);
+        if (inferenceThread != nullptr)
+            coverLateFrames (state, requiredModelSamples);
 
-    if (mix < 1.0f)
+        state.outputFifo.pop (bypassed ? output[ch] : state.tempOut.data(), requiredModelSamples, true);
+    }
+
+    if (!bypassed)
+        resamplerOut.process (tempOutPointers.data(), channelsToProcess, requiredModelSamples, output, numSamples);
+
+    // The dry path is delayed by the same latency as the model path
+    for (int ch = 0; ch < channelsToProcess; ++ch)
     {
-        const float dryMix = 1.0f - mix;
-        for (int i = 0; i < numSamples; ++i)
-            output[i] = input[i] * dryMix + output[i] * mix;
+        auto& state = channels[(size_t) ch];
+        float* dry = state.dryTemp.data();
+        state.dryFifo.pop (dry, numSamples, true);
+
+        if (mix < 1.0f)
+        {
+            const float dryMix = 1.0f - mix;
+            for (int i = 0; i < numSamples; ++i)
+                output[ch][i] = dry[i] * dryMix + output[ch][i] * mix;
+        }
     }
 }
 
-bool OnnxDenoiser::runModel (const float* input, float* output, int frameSize)
+bool OnnxDenoiser::processOffline (juce::AudioBuffer<float>& buffer, double sampleRate,
+                                   std::function<bool (double)> progressCallback)
 {
+    const int numSamples = buffer.getNumSamples();
+    const int offlineChannels = buffer.getNumChannels();
+
+    if (numSamples == 0 || offlineChannels == 0 || sampleRate <= 0.0)
+        return true;
+
+    if (!loadDefaultModelIfNeeded())
+        return false;
+
+    const juce::ScopedLock sl (sessionLock);
+
     if (session == nullptr)
         return false;
 
+    // Frames are laid out channel by channel, so each channel's run output is contiguous
+    const int framesPerChannel = juce::jmax (1, offlineBatchFrames / offlineChannels);
+    const int framesPerStep = framesPerChannel * offlineChannels;
+    std::vector<float> stepInput ((size_t) framesPerStep * modelFrameSize, 0.0f);
+    std::vector<float> stepOutput (stepInput.size(), 0.0f);
+
+    // Batch-capable models take the whole step in one Run; others one frame at a time,
+    // recurrent ones in order with one state per channel
+    std::vector<float> frameInput ((size_t) modelFrameSize, 0.0f);
+    std::vector<float> frameOutput ((size_t) modelFrameSize, 0.0f);
+    BoundRun run;
+    std::vector<std::unique_ptr<RecurrentStream>> streams;
+
     try
     {
-        auto inputShape = resolveInputShape (frameSize);
-        Ort::Value inputTensor = Ort::Value::CreateTensor<float> (memoryInfo,
-                                                                  const_cast<float*> (input),
-                                                                  (size_t) frameSize,
-                                                                  inputShape.data(),
-                                                                  inputShape.size());
+        if (isRecurrent())
+        {
+            for (int ch = 0; ch < offlineChannels; ++ch)
+                streams.push_back (createRecurrentStream());
+        }
+        else
+        {
+            run = supportsBatching ? createBoundRun (stepInput.data(), stepOutput.data(), framesPerStep)
+                                   : createBoundRun (frameInput.data(), frameOutput.data(), 1);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        DBG ("OnnxDenoiser: Failed to bind offline inputs/outputs: " + juce::String (e.what()));
+        return false;
+    }
+
+    PolyphaseResampler toModel;
+    PolyphaseResampler fromModel;
+    toModel.prepare (sampleRate, modelSampleRate, offlineChannels, offlineChunkSize);
+    fromModel.prepare (modelSampleRate, sampleRate, offlineChannels, framesPerChannel * modelFrameSize);
+
+    // Nothing is primed offline, so only the resamplers delay the result
+    const int latency = juce::roundToInt (toModel.getLatencyInInputSamples()
+                                          + fromModel.getLatencyInInputSamples() / toModel.getRatio());
+
+    const int modelChunkSize = toModel.getMaxOutput (offlineChunkSize);
+    std::vector<RingBuffer> pending ((size_t) offlineChannels);
+    std::vector<std::vector<float>> modelChunk ((size_t) offlineChannels);
+    std::vector<std::vector<float>> hostChunk ((size_t) offlineChannels);
+    std::vector<const float*> readPointers ((size_t) offlineChannels);
+    std::vector<float*> modelPointers, denoisedPointers, hostPointers;
+    const std::vector<float> zeros ((size_t) offlineChunkSize, 0.0f);
+
+    for (int ch = 0; ch < offlineChannels; ++ch)
+    {
+        pending[(size_t) ch].resize (modelChunkSize + modelFrameSize);
+        modelChunk[(size_t) ch].assign ((size_t) modelChunkSize, 0.0f);
+        hostChunk[(size_t) ch].assign ((size_t) fromModel.getMaxOutput (framesPerChannel * modelFrameSize), 0.0f);
+        modelPointers.push_back (modelChunk[(size_t) ch].data());
+        denoisedPointers.push_back (stepOutput.data() + (size_t) ch * framesPerChannel * modelFrameSize);
+        hostPointers.push_back (hostChunk[(size_t) ch].data());
+    }
+
+    // Written positions always trail the read position, so the buffer can be processed in place
+    juce::int64 produced = 0;
+
+    for (int readPosition = 0; produced < numSamples + latency; readPosition += offlineChunkSize)
+    {
+        const int count = readPosition < numSamples ? juce::jmin (offlineChunkSize, numSamples - readPosition)
+                                                    : offlineChunkSize;
+
+        // Past the end, zeros flush the resamplers and the last partial frame
+        for (int ch = 0; ch < offlineChannels; ++ch)
+            readPointers[(size_t) ch] = readPosition < numSamples ? buffer.getReadPointer (ch, readPosition) : zeros.data();
+
+        const int modelSamples = toModel.process (readPointers.data(), offlineChannels, count,
+                                                  modelPointers.data(), modelChunkSize);
+
+        for (int ch = 0; ch < offlineChannels; ++ch)
+            pending[(size_t) ch].push (modelPointers[(size_t) ch], modelSamples);
 
-        const char* inputNames[] = { inputName.c_str() };
-        const char* outputNames[] = { outputName.c_str() };
+        while (pending[0].available() >= modelFrameSize)
+        {
+            const int frames = juce::jmin (framesPerChannel, pending[0].available() / modelFrameSize);
+            const int stepSamples = frames * modelFrameSize;
 
-        auto outputTensor = session->Run (Ort::RunOptions { nullptr },
-                                          inputNames, &inputTensor, 1,
-                                          outputNames, 1);
+            for (int ch = 0; ch < offlineChannels; ++ch)
+                pending[(size_t) ch].pop (stepInput.data() + (size_t) ch * framesPerChannel * modelFrameSize,
+                                          stepSamples, false);
 
-        if (outputTensor.size() == 0)
+            // Slots past `frames` hold stale audio on a short final step; their results are ignored
+            if (!streams.empty())
+            {
+                for (int ch = 0; ch < offlineChannels; ++ch)
+                {
+                    for (int frame = 0; frame < frames; ++frame)
+                    {
+                        const size_t offset = ((size_t) ch * framesPerChannel + (size_t) frame) * modelFrameSize;
+                        runRecurrentFrame (*streams[(size_t) ch], stepInput.data() + offset, stepOutput.data() + offset);
+                    }
+                }
+            }
+            else if (supportsBatching)
+            {
+                if (!runBound (run))
+                    std::memcpy (stepOutput.data(), stepInput.data(), sizeof (float) * stepInput.size());
+            }
+            else
+            {
+                for (int ch = 0; ch < offlineChannels; ++ch)
+                {
+                    for (int frame = 0; frame < frames; ++frame)
+                    {
+                        const size_t offset = ((size_t) ch * framesPerChannel + (size_t) frame) * modelFrameSize;
+                        std::memcpy (frameInput.data(), stepInput.data() + offset, sizeof (float) * modelFrameSize);
+
+                        const float* result = runBound (run) ? frameOutput.data() : frameInput.data();
+                        std::memcpy (stepOutput.data() + offset, result, sizeof (float) * modelFrameSize);
+                    }
+                }
+            }
+
+            const int hostSamples = fromModel.process (denoisedPointers.data(), offlineChannels, stepSamples,
+                                                       hostPointers.data(), (int) hostChunk[0].size());
+
+            // Drop the first `latency` outputs and anything past the end
+            const juce::int64 start = produced - latency;
+            const int skip = (int) juce::jlimit ((juce::int64) 0, (juce::int64) hostSamples, -start);
+            const int copyCount = (int) juce::jlimit ((juce::int64) 0, (juce::int64) (hostSamples - skip),
+                                                      (juce::int64) numSamples - (start + skip));
+
+            for (int ch = 0; ch < offlineChannels && copyCount > 0; ++ch)
+                buffer.copyFrom (ch, (int) (start + skip), hostPointers[(size_t) ch] + skip, copyCount);
+
+            produced += hostSamples;
+        }
+
+        if (progressCallback != nullptr
+            && !progressCallback (juce::jlimit (0.0, 1.0, (double) (produced - latency) / numSamples)))
             return false;
+    }
+
+    return true;
+}
+
+void OnnxDenoiser::submitReadyFrames (int channelsToProcess)
+{
+    for (int ch = 0; ch < channelsToProcess; ++ch)
+    {
+        auto& state = channels[(size_t) ch];
+
+        while (state.inputFifo.available() >= modelFrameSize)
+        {
+            const auto scope = requestQueue.fifo.write (1);
+            float* frame = frameScratch.data();
+
+            // A full queue drops the request; the frame still waits in pendingFrames and goes out dry
+            if (scope.blockSize1 > 0)
+            {
+                const auto slot = (size_t) scope.startIndex1;
+                frame = requestQueue.samples.data() + slot * modelFrameSize;
+                requestQueue.channels[slot] = ch;
+                requestQueue.sequences[slot] = state.framesSubmitted;
+            }
+
+            state.inputFifo.pop (frame, modelFrameSize, false);
+            state.pendingFrames.push (frame, modelFrameSize);
+            ++state.framesSubmitted;
+        }
+    }
+}
+
+void OnnxDenoiser::collectResults()
+{
+    const auto scope = responseQueue.fifo.read (responseQueue.fifo.getNumReady());
+
+    scope.forEach ([this] (int slot)
+    {
+        deliverResult (responseQueue.channels[(size_t) slot],
+                       responseQueue.sequences[(size_t) slot],
+                       responseQueue.samples.data() + (size_t) slot * modelFrameSize);
+    });
+}
+
+void OnnxDenoiser::deliverResult (int channel, juce::int64 sequence, const float* frame)
+{
+    if (!juce::isPositiveAndBelow (channel, (int) channels.size()))
+        return;
+
+    auto& state = channels[(size_t) channel];
+
+    // Too late: that frame has already been played dry
+    if (sequence < state.framesDelivered || sequence >= state.framesSubmitted)
+        return;
+
+    // Earlier frames whose requests or results were dropped
+    while (state.framesDelivered < sequence)
+        deliverDryFrame (state);
+
+    state.pendingFrames.pop (frameScratch.data(), modelFrameSize, true);
+    state.outputFifo.push (frame, modelFrameSize);
+    ++state.framesDelivered;
+}
+
+void OnnxDenoiser::deliverDryFrame (ChannelState& state)
+{
+    state.pendingFrames.pop (frameScratch.data(), modelFrameSize, true);
+    state.outputFifo.push (frameScratch.data(), modelFrameSize);
+    ++state.framesDelivered;
+}
+
+void OnnxDenoiser::coverLateFrames (ChannelState& state, int requiredModelSamples)
+{
+    // The deadline: output is due now, so whatever the worker has not returned plays dry
+    while (state.outputFifo.available() < requiredModelSamples && state.framesDelivered < state.framesSubmitted)
+    {
+        deliverDryFrame (state);
+        lateFrames.fetch_add (1, std::memory_order_relaxed);
+    }
+}
+
+bool OnnxDenoiser::runQueuedFrames()
+{
+    const int numFrames = juce::jmin (requestQueue.fifo.getNumReady(), maxBatchFrames);
+    if (numFrames == 0)
+        return false;
+
+    {
+        const auto scope = requestQueue.fifo.read (numFrames);
+        int frame = 0;
+
+        scope.forEach ([this, &frame] (int slot)
+        {
+            std::memcpy (batchInput.data() + (size_t) frame * modelFrameSize,
+                         requestQueue.samples.data() + (size_t) slot * modelFrameSize,
+                         sizeof (float) * modelFrameSize);
+            batchChannels[(size_t) frame] = requestQueue.channels[(size_t) slot];
+            batchSequences[(size_t) frame] = requestQueue.sequences[(size_t) slot];
+            ++frame;
+        });
+    }
+
+    runFrames (numFrames);
+
+    // Results that do not fit are simply lost; the audio thread covers them with dry frames
+    const auto scope = responseQueue.fifo.write (juce::jmin (numFrames, responseQueue.fifo.getFreeSpace()));
+    int frame = 0;
+
+    scope.forEach ([this, &frame] (int slot)
+    {
+        std::memcpy (responseQueue.samples.data() + (size_t) slot * modelFrameSize,
+                     batchOutput.data() + (size_t) frame * modelFrameSize,
+                     sizeof (float) * modelFrameSize);
+        responseQueue.channels[(size_t) slot] = batchChannels[(size_t) frame];
+        responseQueue.sequences[(size_t) slot] = batchSequences[(size_t) frame];
+        ++frame;
+    });
+
+    return true;
+}
+
+void OnnxDenoiser::startInferenceThread()
+{
+    stopInferenceThread();
+
+    if (asyncDelaySamples == 0 || session == nullptr)
+        return;
+
+    // Room for every frame that can be in flight within the deadline, with margin
+    const int numSlots = maxBatchFrames * (asyncDeadlineFrames + 2) + 1;
+    requestQueue.resize (numSlots);
+    responseQueue.resize (numSlots);
+    batchSequences.assign ((size_t) maxBatchFrames, 0);
+
+    inferenceThread = std::make_unique<InferenceThread> (*this);
+    inferenceThread->startThread (juce::Thread::Priority::high);
+}
+
+void OnnxDenoiser::stopInferenceThread()
+{
+    if (inferenceThread == nullptr)
+        return;
+
+    inferenceThread->stopThread (2000);
+    inferenceThread.reset();
+}
+
+void OnnxDenoiser::FrameQueue::resize (int numSlots)
+{
+    fifo.setTotalSize (numSlots);
+    samples.assign ((size_t) numSlots * modelFrameSize, 0.0f);
+    channels.assign ((size_t) numSlots, 0);
+    sequences.assign ((size_t) numSlots, 0);
+}
+
+void OnnxDenoiser::runFrames (int numFrames)
+{
+    const auto passThrough = [this] (int first, int count)
+    {
+        std::memcpy (batchOutput.data() + (size_t) first * modelFrameSize,
+                     batchInput.data() + (size_t) first * modelFrameSize,
+                     sizeof (float) * (size_t) count * modelFrameSize);
+    };
+
+    // Recurrent: frames run in order, each against its own channel's state
+    if (isRecurrent())
+    {
+        for (int i = 0; i < numFrames; ++i)
+        {
+            auto* stream = channels[(size_t) batchChannels[(size_t) i]].recurrent.get();
+            const size_t offset = (size_t) i * modelFrameSize;
+
+            if (stream == nullptr)
+                passThrough (i, 1);
+            else
+                runRecurrentFrame (*stream, batchInput.data() + offset, batchOutput.data() + offset);
+        }
+
+        return;
+    }
+
+    if (boundRuns.empty())
+    {
+        passThrough (0, numFrames);
+        return;
+    }
+
+    // Batched: one run for the whole block. Otherwise one run per frame slot.
+    if (supportsBatching)
+    {
+        if (!runBound (boundRuns[(size_t) numFrames - 1]))
+            passThrough (0, numFrames);
+
+        return;
+    }
+
+    for (int i = 0; i < numFrames; ++i)
+        if (!runBound (boundRuns[(size_t) i]))
+            passThrough (i, 1);
+}
+
+bool OnnxDenoiser::runBound (BoundRun& run)
+{
+    try
+    {
+        session->Run (Ort::RunOptions { nullptr }, *run.binding);
+
+        if (!run.outputPreallocated)
+        {
+            // The output shape was not known up front, so ORT allocated it: copy what fits
+            auto outputs = run.binding->GetOutputValues();
+            if (outputs.empty())
+                return false;
+
+            const size_t outputCount = outputs[0].GetTensorTypeAndShapeInfo().GetElementCount();
+            const size_t samplesToCopy = juce::jmin (run.numValues, outputCount);
+            std::memcpy (run.outputData, outputs[0].GetTensorData<float>(), sizeof (float) * samplesToCopy);
+            std::fill (run.outputData + samplesToCopy, run.outputData + run.numValues, 0.0f);
+        }
 
-        float* outputData = outputTensor[0].GetTensorMutableData<float>();
-        auto outputInfo = outputTensor[0].GetTensorTypeAndShapeInfo();
-        size_t outputCount = outputInfo.GetElementCount();
-        size_t samplesToCopy = juce::jmin ((size_t) frameSize, outputCount);
-        std::memcpy (output, outputData, sizeof (float) * samplesToCopy);
-        if (samplesToCopy < (size_t) frameSize)
-            std::fill (output + samplesToCopy, output + frameSize, 0.0f);
         return true;
     }
     catch (...)
@@ -398,6 +1180,161 @@ bool OnnxDenoiser::runModel (const float* input, float* output, int frameSize)
     }
 }
 
+OnnxDenoiser::BoundRun OnnxDenoiser::createBoundRun (float* input, float* output, int frames)
+{
+    BoundRun run;
+    run.numValues = (size_t) frames * modelFrameSize;
+    run.outputData = output;
+
+    const auto inputShape = resolveShape (modelInputShape, frames, modelFrameSize);
+    run.input = Ort::Value::CreateTensor<float> (memoryInfo, input, run.numValues,
+                                                 inputShape.data(), inputShape.size());
+
+    run.binding = std::make_unique<Ort::IoBinding> (*session);
+    run.binding->BindInput (inputName.c_str(), run.input);
+
+    const auto outputShape = resolveShape (modelOutputShape, frames, modelFrameSize);
+    size_t outputCount = 1;
+    for (auto dim : outputShape)
+        outputCount *= (size_t) juce::jmax ((int64_t) 0, dim);
+
+    if (outputCount == run.numValues)
+    {
+        run.output = Ort::Value::CreateTensor<float> (memoryInfo, run.outputData, run.numValues,
+                                                      outputShape.data(), outputShape.size());
+        run.binding->BindOutput (outputName.c_str(), run.output);
+        run.outputPreallocated = true;
+    }
+    else
+    {
+        run.binding->BindOutput (outputName.c_str(), memoryInfo);
+    }
+
+    return run;
+}
+
+std::unique_ptr<OnnxDenoiser::RecurrentStream> OnnxDenoiser::createRecurrentStream()
+{
+    auto stream = std::make_unique<RecurrentStream>();
+    stream->frameInput.assign ((size_t) modelFrameSize, 0.0f);
+    stream->frameOutput.assign ((size_t) modelFrameSize, 0.0f);
+
+    for (auto& buffer : stream->state)
+        buffer.assign (stateSize, 0.0f);
+
+    for (int parity = 0; parity < 2; ++parity)
+    {
+        auto& run = stream->runs[(size_t) parity];
+        run = createBoundRun (stream->frameInput.data(), stream->frameOutput.data(), 1);
+
+        float* readState = stream->state[(size_t) parity].data();
+        float* writeState = stream->state[(size_t) (1 - parity)].data();
+
+        for (const auto& tensor : stateTensors)
+        {
+            run.states.push_back (Ort::Value::CreateTensor<float> (memoryInfo, readState + tensor.offset, tensor.size,
+                                                                   tensor.shape.data(), tensor.shape.size()));
+            run.binding->BindInput (tensor.inputName.c_str(), run.states.back());
+
+            run.states.push_back (Ort::Value::CreateTensor<float> (memoryInfo, writeState + tensor.offset, tensor.size,
+                                                                   tensor.shape.data(), tensor.shape.size()));
+            run.binding->BindOutput (tensor.outputName.c_str(), run.states.back());
+        }
+    }
+
+    return stream;
+}
+
+bool OnnxDenoiser::runRecurrentFrame (RecurrentStream& stream, const float* input, float* output)
+{
+    if (stream.clearPending.exchange (false))
+    {
+        for (auto& buffer : stream.state)
+            std::fill (buffer.begin(), buffer.end(), 0.0f);
+
+        stream.parity = 0;
+    }
+
+    std::memcpy (stream.frameInput.data(), input, sizeof (float) * modelFrameSize);
+
+    // On failure the state is left as it was, and the frame passes through
+    if (!runBound (stream.runs[(size_t) stream.parity]))
+    {
+        std::memcpy (output, input, sizeof (float) * modelFrameSize);
+        return false;
+    }
+
+    std::memcpy (output, stream.frameOutput.data(), sizeof (float) * modelFrameSize);
+    stream.parity ^= 1;
+    return true;
+}
+
+void OnnxDenoiser::prepareBindings()
+{
+    stopInferenceThread();
+    boundRuns.clear();
+
+    // Enough slots for one block of every channel, plus a partially filled frame
+    const int framesPerBlock = (int) std::ceil ((juce::jmax (1, maxBlock) * resampleOutRatio + 1.0) / modelFrameSize) + 1;
+    maxBatchFrames = juce::jmax (1, numChannels) * framesPerBlock;
+
+    batchInput.assign ((size_t) maxBatchFrames * modelFrameSize, 0.0f);
+    batchOutput.assign ((size_t) maxBatchFrames * modelFrameSize, 0.0f);
+    batchChannels.assign ((size_t) maxBatchFrames, 0);
+
+    if (session == nullptr)
+        return;
+
+    if (isRecurrent())
+    {
+        // The state follows one channel from frame to frame, so nothing is batched across channels
+        supportsBatching = false;
+
+        try
+        {
+            for (auto& channel : channels)
+                channel.recurrent = createRecurrentStream();
+        }
+        catch (const std::exception& e)
+        {
+            DBG ("OnnxDenoiser: Failed to bind recurrent state: " + juce::String (e.what()));
+
+            for (auto& channel : channels)
+                channel.recurrent.reset();
+        }
+
+        DBG ("OnnxDenoiser: Recurrent inference, " + juce::String ((int) stateTensors.size()) + " state tensors of "
+             + juce::String ((int) stateSize) + " values per channel");
+
+        startInferenceThread();
+        return;
+    }
+
+    // A dynamic leading dimension of a [batch, frame] or [batch, 1, frame] input is the batch axis
+    supportsBatching = (modelInputShape.size() == 2 || modelInputShape.size() == 3) && modelInputShape[0] < 0;
+
+    try
+    {
+        for (int i = 0; i < maxBatchFrames; ++i)
+        {
+            const int frames = supportsBatching ? i + 1 : 1;
+            const size_t offset = supportsBatching ? 0 : (size_t) i * modelFrameSize;
+
+            boundRuns.push_back (createBoundRun (batchInput.data() + offset, batchOutput.data() + offset, frames));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        DBG ("OnnxDenoiser: Failed to bind model inputs/outputs: " + juce::String (e.what()));
+        boundRuns.clear();
+    }
+
+    DBG ("OnnxDenoiser: " + juce::String (supportsBatching ? "Batched" : "Per-frame") + " inference, up to "
+         + juce::String (maxBatchFrames) + " frames per block");
+
+    startInferenceThread();
+}
+
 bool OnnxDenoiser::tryCreateSessionForProvider (const juce::File& file, Provider provider)
 {
     if (!file.existsAsFile())
@@ -406,16 +1343,66 @@ bool OnnxDenoiser::tryCreateSessionForProvider (const juce::File& file, Provider
         return false;
     }
 
-    session.reset();
+    VRS_RT_NOTE_FILE_IO();
+    DBG ("OnnxDenoiser: Attempting to create session for provider " + providerToString (provider) + " using " + file.getFileName());
+
+    // The expensive part runs without the lock; prepare() may run meanwhile
+    auto newSession = createSession (file, provider);
+    if (newSession == nullptr)
+        return false;
+
+    // The settings changed while this was being built
+    if (cancelLoad.load())
+        return false;
+
+    const juce::ScopedLock sl (sessionLock);
+    return installSession (std::move (newSession), provider);
+}
+
+std::unique_ptr<Ort::Session> OnnxDenoiser::createSession (const juce::File& file, Provider provider)
+{
+    const auto cachedModel = getOptimizedModelFile (file, provider);
+
+    // Already optimised for this provider and device: skip graph optimisation entirely
+    if (cachedModel.existsAsFile())
+    {
+        if (auto cached = createSessionFromFile (cachedModel, provider, GraphOptimizationLevel::ORT_DISABLE_ALL, {}))
+        {
+            DBG ("OnnxDenoiser: Using cached optimized model " + cachedModel.getFileName());
+            return cached;
+        }
+
+        // Stale or truncated: rebuild it below
+        cachedModel.deleteFile();
+    }
+
+    auto cacheDir = cachedModel.getParentDirectory();
+    const bool canCache = cacheDir.createDirectory() && cacheDir.hasWriteAccess();
+
+    return createSessionFromFile (file, provider, GraphOptimizationLevel::ORT_ENABLE_EXTENDED,
+                                  canCache ? cachedModel : juce::File());
+}
+
+std::unique_ptr<Ort::Session> OnnxDenoiser::createSessionFromFile (const juce::File& file, Provider provider,
+                                                                   GraphOptimizationLevel level, const juce::File& optimizedOutput)
+{
     juce::String providerName = providerToString (provider);
-    DBG ("OnnxDenoiser: Attempting to create session for provider " + providerName + " using " + file.getFileName());
 
     try
     {
-        sessionOptions = Ort::SessionOptions();
-        sessionOptions.SetIntraOpNumThreads (1);
-        sessionOptions.SetInterOpNumThreads (1);
-        sessionOptions.SetGraphOptimizationLevel (GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
+        // Runs on the shared environment's global thread pool
+        Ort::SessionOptions sessionOptions;
+        sessionOptions.DisablePerSessionThreads();
+        sessionOptions.SetGraphOptimizationLevel (level);
+
+        if (optimizedOutput != juce::File())
+        {
+           #if JUCE_WINDOWS
+            sessionOptions.SetOptimizedModelFilePath (optimizedOutput.getFullPathName().toWideCharPointer());
+           #else
+            sessionOptions.SetOptimizedModelFilePath (optimizedOutput.getFullPathName().toRawUTF8());
+           #endif
+        }
 
         bool providerReady = true;
         if (provider == Provider::dml)
@@ -469,21 +1456,36 @@ bool OnnxDenoiser::tryCreateSessionForProvider (const juce::File& file, Provider
         if (!providerReady)
         {
             DBG ("OnnxDenoiser: Provider " + providerName + " not supported or not ready.");
-            return false;
+            return nullptr;
         }
 
        #if JUCE_WINDOWS
         auto filePath = file.getFullPathName();
-        session = std::make_unique<Ort::Session> (env, filePath.toWideCharPointer(), sessionOptions);
+        return std::make_unique<Ort::Session> (getSharedEnv(), filePath.toWideCharPointer(), sessionOptions);
        #else
-        session = std::make_unique<Ort::Session> (env, file.getFullPathName().toRawUTF8(), sessionOptions);
+        return std::make_unique<Ort::Session> (getSharedEnv(), file.getFullPathName().toRawUTF8(), sessionOptions);
        #endif
+    }
+    catch (const std::exception& e)
+    {
+        DBG ("OnnxDenoiser: Exception during session creation for " + providerName + ": " + e.what());
+    }
+    catch (...)
+    {
+        DBG ("OnnxDenoiser: Unknown exception during session creation for " + providerName);
+    }
 
-        if (session == nullptr)
-        {
-            DBG ("OnnxDenoiser: Session creation returned null for " + providerName);
-            return false;
-        }
+    return nullptr;
+}
+
+bool OnnxDenoiser::installSession (std::unique_ptr<Ort::Session> newSession, Provider provider)
+{
+    juce::String providerName = providerToString (provider);
+    releaseSession();
+
+    try
+    {
+        session = std::move (newSession);
 
         Ort::AllocatorWithDefaultOptions allocator;
         auto inputAllocated = session->GetInputNameAllocated (0, allocator);
@@ -495,39 +1497,92 @@ bool OnnxDenoiser::tryCreateSessionForProvider (const juce::File& file, Provider
         if (inputName.empty() || outputName.empty())
         {
             DBG ("OnnxDenoiser: Failed to retrieve input/output names from model.");
-            session.reset();
+            releaseSession();
             return false;
         }
 
         auto inputTypeInfo = session->GetInputTypeInfo (0);
         auto tensorInfo = inputTypeInfo.GetTensorTypeAndShapeInfo();
         modelInputShape = tensorInfo.GetShape();
+        modelOutputShape = session->GetOutputTypeInfo (0).GetTensorTypeAndShapeInfo().GetShape();
+
+        // Any input after the audio is recurrent state, fed by the output at the same index
+        stateTensors.clear();
+        stateSize = 0;
+
+        const size_t numInputs = session->GetInputCount();
+        if (numInputs > 1 && session->GetOutputCount() != numInputs)
+        {
+            DBG ("OnnxDenoiser: Model has " + juce::String ((int) numInputs) + " inputs but "
+                 + juce::String ((int) session->GetOutputCount()) + " outputs; state inputs need matching outputs.");
+            releaseSession();
+            return false;
+        }
+
+        for (size_t i = 1; i < numInputs; ++i)
+        {
+            StateTensor tensor;
+            tensor.inputName = session->GetInputNameAllocated (i, allocator).get();
+            tensor.outputName = session->GetOutputNameAllocated (i, allocator).get();
+            tensor.shape = session->GetInputTypeInfo (i).GetTensorTypeAndShapeInfo().GetShape();
+
+            // One stream per Run, so a dynamic (batch) dimension is 1
+            tensor.size = 1;
+            for (auto& dim : tensor.shape)
+            {
+                dim = juce::jmax ((int64_t) 1, dim);
+                tensor.size *= (size_t) dim;
+            }
+
+            tensor.offset = stateSize;
+            stateSize += tensor.size;
+            stateTensors.push_back (std::move (tensor));
+        }
 
         activeProvider = provider;
         DBG ("OnnxDenoiser: Successfully created session for " + providerName);
+
+        prepareBindings();
     }
     catch (const std::exception& e)
     {
-        DBG ("OnnxDenoiser: Exception during session creation for " + providerName + ": " + e.what());
-        session.reset();
-        return false;
-    }
-    catch (...)
-    {
-        DBG ("OnnxDenoiser: Unknown exception during session creation for " + providerName);
-        session.reset();
+        DBG ("OnnxDenoiser: Exception while reading model info for " + providerName + ": " + e.what());
+        releaseSession();
         return false;
     }
 
-    return session != nullptr;
+    // Everything processBlock reads is in place before it can see the session
+    sessionActive.store (true, std::memory_order_release);
+    return true;
 }
 
-std::vector<int64_t> OnnxDenoiser::resolveInputShape (int frameSize) const
+juce::File OnnxDenoiser::getOptimizedModelFile (const juce::File& file, Provider provider) const
 {
-    if (modelInputShape.empty())
-        return { 1, frameSize };
+    // Keyed on everything the optimised graph depends on: the source model, the
+    // provider and its device, and the runtime that wrote it
+    juce::String key = file.getFullPathName()
+                     + "|" + juce::String (file.getSize())
+                     + "|" + juce::String (file.getLastModificationTime().toMilliseconds())
+                     + "|" + providerToString (provider)
+                     + "|" + juce::String (OrtGetApiBase()->GetVersionString());
 
-    auto shape = modelInputShape;
+    if (provider == Provider::dml)
+        key += "|" + juce::String (dmlDeviceId);
+    else if (provider == Provider::qnn)
+        key += "|" + qnnBackendPath;
+
+    return getModelCacheDirectory().getChildFile (file.getFileNameWithoutExtension()
+                                                  + "_" + providerToString (provider).toLowerCase()
+                                                  + "_" + juce::String::toHexString (key.hashCode64())
+                                                  + ".onnx");
+}
+
+std::vector<int64_t> OnnxDenoiser::resolveShape (const std::vector<int64_t>& modelShape, int batchSize, int frameSize)
+{
+    if (modelShape.empty())
+        return { batchSize, frameSize };
+
+    auto shape = modelShape;
     for (auto& dim : shape)
     {
         if (dim < 0)
@@ -538,12 +1593,12 @@ std::vector<int64_t> OnnxDenoiser::resolveInputShape (int frameSize) const
         shape[0] = frameSize;
     else if (shape.size() == 2)
     {
-        shape[0] = 1;
+        shape[0] = batchSize;
         shape[1] = frameSize;
     }
     else if (shape.size() == 3)
     {
-        shape[0] = 1;
+        shape[0] = batchSize;
         shape[1] = 1;
         shape[2] = frameSize;
     }
@@ -701,9 +1756,6 @@ std::vector<OnnxDenoiser::Provider> OnnxDenoiser::getProviderFallbackOrder() con
     if (!allowFallback && preferredProvider != Provider::autoSelect)
         return { preferredProvider };
 
-    if (preferredProvider == Provider::autoSelect)
-        return { Provider::qnn, Provider::dml, Provider::cuda, Provider::rocm, Provider::coreml, Provider::cpu };
-
     std::vector<Provider> order;
     auto appendUnique = [&order](Provider provider)
     {
@@ -711,6 +1763,18 @@ std::vector<OnnxDenoiser::Provider> OnnxDenoiser::getProviderFallbackOrder() con
             order.push_back (provider);
     };
 
+    // Auto: the measured winner first, when there is one
+    if (preferredProvider == Provider::autoSelect)
+    {
+        if (autoProvider != Provider::autoSelect)
+            appendUnique (autoProvider);
+
+        for (const auto provider : { Provider::qnn, Provider::dml, Provider::cuda, Provider::rocm, Provider::coreml, Provider::cpu })
+            appendUnique (provider);
+
+        return order;
+    }
+
     appendUnique (preferredProvider);
     if (allowFallback)
     {
@@ -735,14 +1799,30 @@ void OnnxDenoiser::reset() {}
 void OnnxDenoiser::setModelPath (const juce::File&) {}
 void OnnxDenoiser::clearModelPath() {}
 void OnnxDenoiser::setPreferredProvider (Provider) {}
+void OnnxDenoiser::setAutoProvider (Provider) {}
+std::vector<OnnxDenoiser::ProviderBenchmark> OnnxDenoiser::benchmarkProviders (std::function<bool()>) const { return {}; }
+juce::String OnnxDenoiser::getBenchmarkSignature() const { return {}; }
 bool OnnxDenoiser::loadDefaultModelIfNeeded() { return false; }
+void OnnxDenoiser::loadDefaultModelAsync() {}
 void OnnxDenoiser::processBlock (juce::AudioBuffer<float>&, float) {}
+bool OnnxDenoiser::processOffline (juce::AudioBuffer<float>&, double, std::function<bool (double)>) { return false; }
 
 juce::String OnnxDenoiser::providerToString (Provider) { return "Disabled"; }
 OnnxDenoiser::Provider OnnxDenoiser::providerFromString (const juce::String&) { return Provider::cpu; }
+void OnnxDenoiser::setThreadingSettings (const ThreadingSettings&) {}
 
 #endif
 
+juce::File OnnxDenoiser::getModelCacheDirectory()
+{
+    // Next to the settings file (see SettingsManager)
+    auto baseDir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory);
+   #if JUCE_MAC
+    baseDir = baseDir.getChildFile ("Application Support");
+   #endif
+    return baseDir.getChildFile ("VinylRestorationSuite").getChildFile ("ModelCache");
+}
+
 void OnnxDenoiser::RingBuffer::resize (int newCapacity)
 {
     capacity = juce::jmax (newCapacity, 1);
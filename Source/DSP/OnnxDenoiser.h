@@ -2,6 +2,10 @@
 
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_core/juce_core.h>
+#include "PolyphaseResampler.h"
+#include <array>
+#include <atomic>
+#include <functional>
 
 #if defined(ENABLE_ONNX_RUNTIME)
 #include <onnxruntime_cxx_api.h>
@@ -27,13 +31,34 @@ public:
     void prepare (double newSampleRate, int newNumChannels, int maxBlockSize);
     void reset();
 
-    void setEnabled (bool shouldEnable) { enabled = shouldEnable; }
+    void setEnabled (bool shouldEnable)
+    {
+        // Stale FIFO contents from before the last enable would replay old audio
+        if (shouldEnable && !enabled)
+            resetPending = true;
+
+        enabled = shouldEnable;
+    }
+
     bool isEnabled() const { return enabled; }
 
+    /** Fixed delay of processBlock in host samples: one model frame plus the resamplers
+        (none at 48 kHz), and the worker's budget when inference is asynchronous */
+    int getLatencySamples() const { return latencySamples; }
+
+    /** Runs the model on a background thread instead of inside processBlock. Frames
+        that miss the fixed deadline are replaced by the dry signal, so a stalled
+        execution provider never blocks the audio thread. Takes effect at the next prepare(). */
+    void setAsyncInference (bool shouldUseAsync) { asyncInference = shouldUseAsync; }
+    bool isAsyncInference() const { return asyncInference; }
+
+    /** Frames that missed the async deadline and were played dry, since construction */
+    juce::int64 getNumLateFrames() const { return lateFrames.load(); }
+
     bool isReady() const
     {
 #if defined(ENABLE_ONNX_RUNTIME)
-        return session != nullptr;
+        return sessionActive.load();
 #else
         return false;
 #endif
@@ -43,12 +68,61 @@ public:
     void clearModelPath();
     bool loadDefaultModelIfNeeded();
 
+    /** Creates the session on a background thread, unless one exists or is already on
+        its way; processBlock passes audio through untouched until it is ready.
+        prepare() calls this when no session exists. */
+    void loadDefaultModelAsync();
+
+    /** Called on the loading thread once a background load has finished, whether or not
+        it produced a session (e.g. to re-report latency) */
+    std::function<void()> onSessionLoaded;
+
+    /** Optimised graphs are serialised here, per model, provider and device */
+    static juce::File getModelCacheDirectory();
+
+    /** Real-time safe once prepared: passes audio through untouched until a session exists */
     void processBlock (juce::AudioBuffer<float>& buffer, float mix);
 
+    /**
+     * Offline: denoises a whole buffer in place, at its own sample rate, with the
+     * latency removed. The AI path is streamed through in large batches (one Run for
+     * hundreds of frames on batch-capable models), so a side takes seconds on a GPU
+     * provider. Loads the session synchronously if needed; returns false if there is
+     * no model or progressCallback (0.0 to 1.0) returned false, in which case the
+     * buffer is left partly processed.
+     *
+     * Not for the audio thread. Use an instance of its own rather than one whose
+     * processBlock is running.
+     */
+    bool processOffline (juce::AudioBuffer<float>& buffer, double sampleRate,
+                         std::function<bool (double)> progressCallback = nullptr);
+
     void setPreferredProvider (Provider provider);
     Provider getPreferredProvider() const { return preferredProvider; }
     Provider getActiveProvider() const { return activeProvider; }
 
+    /** Auto mode tries this provider first (the stored benchmark winner), then the usual
+        fallback order. autoSelect restores the plain fallback order. */
+    void setAutoProvider (Provider provider);
+    Provider getAutoProvider() const { return autoProvider; }
+
+    /** Measured cost of one provider on the model this instance would load */
+    struct ProviderBenchmark
+    {
+        Provider provider = Provider::cpu;
+        bool succeeded = false;
+        double msPerFrame = 0.0;    // Median per Run divided by its frames, averaged over the batch sizes
+    };
+
+    /** Times every usable provider, each in a session of its own, on 1, 8 and 64-frame
+        batches (a realtime callback up to an offline step). Takes seconds: call it from a
+        background thread. Stops early when shouldContinue returns false. */
+    std::vector<ProviderBenchmark> benchmarkProviders (std::function<bool()> shouldContinue = nullptr) const;
+
+    /** Identifies what a benchmark result applies to: runtime, OS, CPU, the providers built
+        in, the DML device or QNN backend, and the model file */
+    juce::String getBenchmarkSignature() const;
+
     void setAllowFallback (bool shouldAllow) { allowFallback = shouldAllow; }
     bool getAllowFallback() const { return allowFallback; }
 
@@ -61,6 +135,18 @@ public:
     static juce::String providerToString (Provider provider);
     static Provider providerFromString (const juce::String& name);
 
+    /** Process-wide ONNX Runtime thread pool, shared by the sessions of every instance */
+    struct ThreadingSettings
+    {
+        int intraOpThreads = 1;
+        bool allowSpinning = false;
+        juce::String intraOpAffinity;    // ORT syntax, one group per extra thread: "1,2;3-4"
+    };
+
+    /** The shared environment is created with the first session, so this only takes
+        effect if called before then (i.e. changes apply after a restart) */
+    static void setThreadingSettings (const ThreadingSettings& settings);
+
 private:
     struct RingBuffer
     {
@@ -77,43 +163,78 @@ private:
         int availableSamples = 0;
     };
 
+   #if defined(ENABLE_ONNX_RUNTIME)
+    struct RecurrentStream;
+   #endif
+
     struct ChannelState
     {
-        juce::LagrangeInterpolator resamplerIn;
-        juce::LagrangeInterpolator resamplerOut;
         RingBuffer inputFifo;
         RingBuffer outputFifo;
+        RingBuffer dryFifo;              // Input delayed by the latency, for the dry/wet mix
+        RingBuffer pendingFrames;        // Async: model-rate frames still waiting for a result
+        juce::int64 framesSubmitted = 0;
+        juce::int64 framesDelivered = 0;
         std::vector<float> tempIn;
         std::vector<float> tempOut;
-        std::vector<float> frameIn;
-        std::vector<float> frameOut;
+        std::vector<float> dryTemp;
+       #if defined(ENABLE_ONNX_RUNTIME)
+        std::unique_ptr<RecurrentStream> recurrent;   // Stateful models only
+       #endif
     };
 
+    void primeFifos (ChannelState& state);
+
     void ensureSession();
     bool loadModelInternal (const juce::File& file);
+    bool loadDefaultModel();
+    void cancelSessionLoad();
     juce::File getDefaultModelFile() const;
     std::vector<juce::File> getModelCandidates() const;
-    std::vector<int64_t> resolveInputShape (int frameSize) const;
+    static std::vector<int64_t> resolveShape (const std::vector<int64_t>& modelShape, int batchSize, int frameSize);
     bool tryCreateSessionForProvider (const juce::File& file, Provider provider);
+    double measureFrameCost (const std::function<bool()>& shouldContinue);
     bool isProviderUsable (Provider provider) const;
     std::vector<Provider> getProviderFallbackOrder() const;
 
-    void processChannel (ChannelState& state, const float* input, float* output, int numSamples, float mix);
-    bool runModel (const float* input, float* output, int frameSize);
+    void pushInput (const float* const* input, int channelsToProcess, int numSamples);
+    void runReadyFrames (int channelsToProcess);
+    void pullOutput (float* const* output, int channelsToProcess, int numSamples, float mix);
+    void runFrames (int numFrames);
+    void prepareBindings();
+    void releaseSession();
+
+    void submitReadyFrames (int channelsToProcess);
+    void collectResults();
+    void deliverResult (int channel, juce::int64 sequence, const float* frame);
+    void deliverDryFrame (ChannelState& state);
+    void coverLateFrames (ChannelState& state, int requiredModelSamples);
+    bool runQueuedFrames();
+    void startInferenceThread();
+    void stopInferenceThread();
 
     double hostSampleRate = 44100.0;
     int numChannels = 2;
     int maxBlock = 0;
     bool enabled = false;
+    bool resetPending = false;
+    int latencySamples = 0;
+    bool asyncInference = false;
+    int asyncDelaySamples = 0;             // Extra output priming (model rate) while async is prepared
+    std::atomic<juce::int64> lateFrames { 0 };
 
     static constexpr double modelSampleRate = 48000.0;
     static constexpr int modelFrameSize = 480;
+    static constexpr int asyncDeadlineFrames = 2;  // Worker slack beyond one host block
+    static constexpr int offlineBatchFrames = 256; // Frames per Run in processOffline, all channels
+    static constexpr int offlineChunkSize = 32768; // Host samples read per step in processOffline
 
     double resampleInRatio = 1.0;
     double resampleOutRatio = 1.0;
 
     juce::File modelPath;
     Provider preferredProvider = Provider::autoSelect;
+    Provider autoProvider = Provider::autoSelect;
     Provider activeProvider = Provider::cpu;
     bool allowFallback = true;
     int dmlDeviceId = 0;
@@ -121,14 +242,111 @@ private:
 
     std::vector<ChannelState> channels;
 
+    // Host rate <-> model rate, all channels at once; bypassed at 48 kHz
+    PolyphaseResampler resamplerIn;
+    PolyphaseResampler resamplerOut;
+    std::vector<float*> tempInPointers;
+    std::vector<float*> tempOutPointers;
+
 #if defined(ENABLE_ONNX_RUNTIME)
-    Ort::Env env;
-    Ort::SessionOptions sessionOptions;
+    static Ort::Env& getSharedEnv();
+
     std::unique_ptr<Ort::Session> session;
     Ort::MemoryInfo memoryInfo;
 
+    std::unique_ptr<Ort::Session> createSession (const juce::File& file, Provider provider);
+    std::unique_ptr<Ort::Session> createSessionFromFile (const juce::File& file, Provider provider,
+                                                         GraphOptimizationLevel level, const juce::File& optimizedOutput);
+    bool installSession (std::unique_ptr<Ort::Session> newSession, Provider provider);
+    juce::File getOptimizedModelFile (const juce::File& file, Provider provider) const;
+
+    // Published once the bindings are built; processBlock never looks at the session before that.
+    // sessionLock keeps prepare() and a background install apart and is never taken by the audio thread.
+    class SessionLoader;
+    std::unique_ptr<SessionLoader> sessionLoader;
+    std::atomic<bool> sessionActive { false };
+    std::atomic<bool> cancelLoad { false };
+    juce::CriticalSection sessionLock;
+
     std::string inputName;
     std::string outputName;
     std::vector<int64_t> modelInputShape;
+    std::vector<int64_t> modelOutputShape;
+
+    /** One pre-bound Run over the shared batch buffers */
+    struct BoundRun
+    {
+        Ort::Value input { nullptr };
+        Ort::Value output { nullptr };
+        std::unique_ptr<Ort::IoBinding> binding;
+        float* outputData = nullptr;
+        size_t numValues = 0;
+        bool outputPreallocated = false;
+        std::vector<Ort::Value> states;     // Recurrent models: state inputs and outputs
+    };
+
+    BoundRun createBoundRun (float* input, float* output, int frames);
+    bool runBound (BoundRun& run);
+
+    /** A recurrent input paired with the output at the same index, which feeds it next frame */
+    struct StateTensor
+    {
+        std::string inputName;
+        std::string outputName;
+        std::vector<int64_t> shape;
+        size_t offset = 0;                  // Into each RecurrentStream state buffer
+        size_t size = 0;
+    };
+
+    /**
+     * Hidden state of one stream of audio (a channel). The two state buffers
+     * ping-pong: runs[p] reads state[p] and writes state[1 - p], so state moves
+     * from one Run to the next without a copy.
+     */
+    struct RecurrentStream
+    {
+        std::array<std::vector<float>, 2> state;
+        std::array<BoundRun, 2> runs;
+        std::vector<float> frameInput;
+        std::vector<float> frameOutput;
+        int parity = 0;
+        std::atomic<bool> clearPending { false };   // Set by reset(), consumed by the inference thread
+    };
+
+    bool isRecurrent() const { return !stateTensors.empty(); }
+    std::unique_ptr<RecurrentStream> createRecurrentStream();
+    bool runRecurrentFrame (RecurrentStream& stream, const float* input, float* output);
+
+    std::vector<StateTensor> stateTensors;
+    size_t stateSize = 0;                   // Floats of all state tensors together
+
+    // Batched: entry n-1 runs n frames from the start of the buffers.
+    // Per-frame: entry i runs the single frame in slot i.
+    std::vector<BoundRun> boundRuns;
+    std::vector<float> batchInput;
+    std::vector<float> batchOutput;
+    std::vector<int> batchChannels;         // Owning channel of each frame slot
+    int maxBatchFrames = 0;
+    bool supportsBatching = false;
+
+    /** Single-producer/single-consumer queue of model frames tagged with channel and sequence */
+    struct FrameQueue
+    {
+        void resize (int numSlots);
+
+        juce::AbstractFifo fifo { 1 };
+        std::vector<float> samples;
+        std::vector<int> channels;
+        std::vector<juce::int64> sequences;
+    };
+
+    // Audio thread -> worker, and back. Only the worker touches the batch buffers and bindings
+    // while it runs; frameScratch belongs to the audio thread.
+    class InferenceThread;
+    std::unique_ptr<InferenceThread> inferenceThread;
+    FrameQueue requestQueue;
+    FrameQueue responseQueue;
+    std::vector<juce::int64> batchSequences;
+    std::vector<float> frameScratch;
 #endif
 };
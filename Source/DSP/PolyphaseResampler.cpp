@@ -0,0 +1,160 @@
+#include "PolyphaseResampler.h"
+
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <utility>
+
+namespace
+{
+    // Per-phase length at unity ratio; decimation scales it by M / L so the
+    // transition band stays the same width at the output rate
+    constexpr int baseTapsPerPhase = 64;
+    constexpr double stopbandAttenuationDb = PolyphaseResampler::stopbandAttenuationDb;
+
+    using TableKey = std::pair<int, int>;
+
+    struct CacheStorage
+    {
+        juce::CriticalSection lock;
+        std::map<TableKey, PolyphaseResampler::TablePtr> tables;
+    };
+
+    CacheStorage& getStorage()
+    {
+        static CacheStorage storage;
+        return storage;
+    }
+
+    double besselI0 (double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+
+        for (int k = 1; k < 64; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+
+            if (term < sum * 1.0e-12)
+                break;
+        }
+
+        return sum;
+    }
+
+    /** Smallest L/M equal to the ratio, or the closest with at most maxPhases phases.
+        Downsampling is searched as the inverse, so A -> B and B -> A always pair up exactly. */
+    TableKey findRatio (double inputRate, double outputRate)
+    {
+        if (outputRate < inputRate)
+        {
+            const auto inverse = findRatio (outputRate, inputRate);
+            return { inverse.second, inverse.first };
+        }
+
+        const double ratio = outputRate / inputRate;
+        TableKey best { 1, 1 };
+        double bestError = std::abs (ratio - 1.0);
+
+        for (int up = 1; up <= PolyphaseResampler::maxPhases; ++up)
+        {
+            const int down = juce::jmax (1, juce::roundToInt (up / ratio));
+            const double error = std::abs (static_cast<double> (up) / down - ratio);
+
+            if (error < bestError)
+            {
+                best = { up, down };
+                bestError = error;
+            }
+
+            if (bestError <= ratio * 1.0e-12)
+                break;
+        }
+
+        return best;
+    }
+
+    PolyphaseResampler::Table designTable (int up, int down)
+    {
+        PolyphaseResampler::Table table;
+        table.up = up;
+        table.down = down;
+
+        if (up == down)
+            return table;
+
+        table.taps = baseTapsPerPhase * juce::jmax (1, (down + up - 1) / up);
+
+        const int length = up * table.taps;
+        const double centre = 0.5 * (length - 1);
+
+        // Cutoff on the upsampled grid: the stopband starts at the lower Nyquist
+        const double transition = (stopbandAttenuationDb - 8.0) / (2.285 * juce::MathConstants<double>::twoPi * length);
+        const double cutoff = juce::jmax (0.5 / juce::jmax (up, down) - 0.5 * transition, 0.25 / juce::jmax (up, down));
+
+        std::vector<double> prototype (static_cast<size_t> (length));
+
+        for (int i = 0; i < length; ++i)
+            prototype[static_cast<size_t> (i)] = PolyphaseResampler::windowedSinc (i - centre, cutoff, centre);
+
+        // Phase p holds h[p + k*L], reversed, each normalised to unity DC gain so the
+        // phase sequence does not modulate the level
+        table.coefficients.resize (static_cast<size_t> (length));
+
+        for (int phase = 0; phase < up; ++phase)
+        {
+            double sum = 0.0;
+            for (int k = 0; k < table.taps; ++k)
+                sum += prototype[static_cast<size_t> (phase + k * up)];
+
+            const double gain = sum != 0.0 ? 1.0 / sum : 0.0;
+            float* destination = table.coefficients.data() + static_cast<size_t> (phase * table.taps);
+
+            for (int k = 0; k < table.taps; ++k)
+                destination[table.taps - 1 - k] = static_cast<float> (prototype[static_cast<size_t> (phase + k * up)] * gain);
+        }
+
+        table.latency = centre / up;
+        return table;
+    }
+}
+
+double PolyphaseResampler::windowedSinc (double t, double cutoff, double halfLength)
+{
+    static const double beta = 0.1102 * (stopbandAttenuationDb - 8.7);
+    static const double i0Beta = besselI0 (beta);
+
+    const double x = juce::MathConstants<double>::twoPi * cutoff * t;
+    const double sinc = t == 0.0 ? 1.0 : std::sin (x) / x;
+    const double r = t / halfLength;
+    const double window = besselI0 (beta * std::sqrt (juce::jmax (0.0, 1.0 - r * r))) / i0Beta;
+
+    return 2.0 * cutoff * sinc * window;
+}
+
+PolyphaseResampler::TablePtr PolyphaseResampler::getTable (double inputRate, double outputRate)
+{
+    jassert (inputRate > 0.0 && outputRate > 0.0);
+
+    const TableKey key = findRatio (inputRate, outputRate);
+
+    auto& storage = getStorage();
+    const juce::ScopedLock sl (storage.lock);
+
+    auto& table = storage.tables[key];
+
+    if (table == nullptr)
+        table = std::make_shared<const Table> (designTable (key.first, key.second));
+
+    return table;
+}
+
+void PolyphaseResampler::purgeUnused()
+{
+    auto& storage = getStorage();
+    const juce::ScopedLock sl (storage.lock);
+
+    for (auto it = storage.tables.begin(); it != storage.tables.end();)
+        it = (it->second.use_count() <= 1) ? storage.tables.erase (it) : std::next (it);
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * Polyphase Resampler
+ *
+ * Rational L/M sample rate converter with a Kaiser-windowed sinc prototype,
+ * for fixed conversions such as host rate <-> the 48 kHz model rate. Each
+ * output is one dot product with the filter phase it falls on; the phase
+ * tables are built once per ratio and shared by every instance (see
+ * getTable()), so the common 44.1k/88.2k/96k/192k conversions cost nothing
+ * to set up after the first.
+ *
+ * Channels are interleaved into SIMD lanes (juce::dsp::SIMDRegister), as in
+ * BiquadCascade: all channels share the same phase sequence, so a stereo or
+ * quad stream costs the same as mono.
+ *
+ * Sample counts are exact: process() consumes every input sample and
+ * getNumInputRequired() says how many inputs yield a given number of outputs,
+ * so a push side and a pull side never drift apart. Equal rates bypass the
+ * filter entirely; callers can then skip the copy as well (isBypassed()).
+ */
+class PolyphaseResampler
+{
+public:
+    /** Immutable filter bank for one ratio: `up` phases of `taps` coefficients each */
+    struct Table
+    {
+        int up = 1;
+        int down = 1;
+        int taps = 1;
+        double latency = 0.0;              // Group delay, in input samples
+        std::vector<float> coefficients;   // Time-reversed per phase, for a forward dot product
+    };
+
+    using TablePtr = std::shared_ptr<const Table>;
+
+    static constexpr int maxPhases = 1024;
+
+    PolyphaseResampler() = default;
+
+    /** Lets the cache drop the table if this was its last user */
+    ~PolyphaseResampler()
+    {
+        if (table == nullptr)
+            return;
+
+        table.reset();
+        purgeUnused();
+    }
+
+    //==============================================================================
+    /** Builds or fetches the table and allocates for blocks of up to maxInputBlock
+        input samples (larger calls are split). Not real-time safe. */
+    void prepare (double inputRate, double outputRate, int newNumChannels, int newMaxInputBlock)
+    {
+        numChannels = juce::jmax (1, newNumChannels);
+        maxInputBlock = juce::jmax (1, newMaxInputBlock);
+        numGroups = (numChannels + lanes - 1) / lanes;
+
+        auto previous = std::exchange (table, getTable (inputRate, outputRate));
+
+        // A rate change can leave the previous conversion's table unused
+        if (previous != nullptr && previous != table)
+        {
+            previous.reset();
+            purgeUnused();
+        }
+
+        historySize = table->taps;
+        groupStride = historySize + maxInputBlock;
+        frames.assign (static_cast<size_t> (numGroups * groupStride), broadcast (0.0f));
+
+        reset();
+    }
+
+    /** Clears the history; the next output lines up with the next input */
+    void reset()
+    {
+        std::fill (frames.begin(), frames.end(), broadcast (0.0f));
+        position = 0;
+    }
+
+    bool isBypassed() const { return table == nullptr || table->up == table->down; }
+
+    /** Output samples per input sample; may be a close rational approximation of the rates */
+    double getRatio() const { return table != nullptr ? static_cast<double> (table->up) / table->down : 1.0; }
+
+    /** Group delay, in input samples */
+    double getLatencyInInputSamples() const { return isBypassed() ? 0.0 : table->latency; }
+
+    /** Upper bound on the outputs of one process() call with numInput samples, for sizing */
+    int getMaxOutput (int numInput) const
+    {
+        if (isBypassed())
+            return numInput;
+
+        return static_cast<int> ((static_cast<juce::int64> (numInput) * table->up + table->down - 1) / table->down) + 1;
+    }
+
+    /** Upper bound on getNumInputRequired (numOutput), for sizing */
+    int getMaxInputRequired (int numOutput) const
+    {
+        if (isBypassed())
+            return numOutput;
+
+        return static_cast<int> ((static_cast<juce::int64> (numOutput) * table->down + table->up - 1) / table->up) + 1;
+    }
+
+    /** Exactly how many input samples the next process() call needs to produce numOutput samples */
+    int getNumInputRequired (int numOutput) const
+    {
+        if (isBypassed())
+            return numOutput;
+
+        if (numOutput <= 0)
+            return 0;
+
+        const juce::int64 needed = floorDiv (static_cast<juce::int64> (numOutput - 1) * table->down + position, table->up) + 1;
+        return static_cast<int> (juce::jmax (static_cast<juce::int64> (0), needed));
+    }
+
+    //==============================================================================
+    /**
+     * Audio thread: consumes all numInput samples of each channel and writes up to
+     * maxOutput samples per channel, returning the count. Outputs beyond maxOutput
+     * stay pending for the next call; callers either size maxOutput with
+     * getMaxOutput() or feed exactly getNumInputRequired().
+     */
+    int process (const float* const* input, int numInputChannels, int numInput, float* const* output, int maxOutput)
+    {
+        const int channelsToProcess = juce::jmin (numInputChannels, numChannels);
+
+        if (isBypassed())
+        {
+            const int count = juce::jmin (numInput, maxOutput);
+            for (int ch = 0; ch < channelsToProcess; ++ch)
+                if (output[ch] != input[ch])
+                    std::copy (input[ch], input[ch] + count, output[ch]);
+
+            return count;
+        }
+
+        int produced = 0;
+
+        for (int offset = 0; offset < numInput;)
+        {
+            const int count = juce::jmin (maxInputBlock, numInput - offset);
+            produced += processChunk (input, channelsToProcess, offset, count, output, produced, maxOutput - produced);
+            offset += count;
+        }
+
+        return produced;
+    }
+
+    //==============================================================================
+    /** Shared table for a conversion; thread-safe, allocates on first use */
+    static TablePtr getTable (double inputRate, double outputRate);
+
+    /** Drops cached tables that no resampler uses any more; prepare() and the destructor call it */
+    static void purgeUnused();
+
+    static constexpr double stopbandAttenuationDb = 80.0;
+
+    /**
+     * The Kaiser-windowed sinc lowpass every table is cut from (VariableRateResampler's
+     * too): its value t samples from the centre, for a cutoff in cycles per sample and
+     * a window reaching halfLength samples either side.
+     */
+    static double windowedSinc (double t, double cutoff, double halfLength);
+
+private:
+    //==============================================================================
+   #if JUCE_USE_SIMD
+    using Vector = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = static_cast<int> (Vector::SIMDNumElements);
+    static Vector broadcast (float value) { return Vector::expand (value); }
+   #else
+    using Vector = float;
+    static constexpr int lanes = 1;
+    static Vector broadcast (float value) { return value; }
+   #endif
+
+    static juce::int64 floorDiv (juce::int64 value, juce::int64 divisor)
+    {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    int processChunk (const float* const* input, int channelsToProcess, int inputOffset, int count,
+                      float* const* output, int outputOffset, int maxOutput)
+    {
+        // Interleave behind each group's history: one frame per sample, one lane per channel
+        for (int group = 0; group * lanes < channelsToProcess; ++group)
+        {
+            const int firstChannel = group * lanes;
+            const int lanesUsed = juce::jmin (lanes, channelsToProcess - firstChannel);
+            float* interleaved = reinterpret_cast<float*> (groupFrames (group) + historySize);
+
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                if (lane < lanesUsed)
+                {
+                    const float* source = input[firstChannel + lane] + inputOffset;
+                    for (int i = 0; i < count; ++i)
+                        interleaved[i * lanes + lane] = source[i];
+                }
+                else
+                {
+                    for (int i = 0; i < count; ++i)
+                        interleaved[i * lanes + lane] = 0.0f;
+                }
+            }
+        }
+
+        // position is the next output's place on the upsampled grid, relative to the
+        // end of the consumed input: negative means every input it needs has arrived
+        const int up = table->up;
+        const int down = table->down;
+        const int taps = table->taps;
+        const float* coefficients = table->coefficients.data();
+        const int newest = historySize + count - 1;
+
+        position -= static_cast<juce::int64> (count) * up;
+
+        int produced = 0;
+        while (position < 0 && produced < maxOutput)
+        {
+            const juce::int64 whole = floorDiv (position, up);
+            const float* phase = coefficients + static_cast<size_t> (position - whole * up) * static_cast<size_t> (taps);
+            const int first = newest + static_cast<int> (whole + 1) - taps + 1;
+            jassert (first >= 0);
+
+            for (int group = 0; group * lanes < channelsToProcess; ++group)
+            {
+                const Vector* x = groupFrames (group) + first;
+                Vector sum = broadcast (0.0f);
+
+                for (int k = 0; k < taps; ++k)
+                    sum += x[k] * phase[k];
+
+                const float* lanesOut = reinterpret_cast<const float*> (&sum);
+                const int firstChannel = group * lanes;
+                const int lanesUsed = juce::jmin (lanes, channelsToProcess - firstChannel);
+
+                for (int lane = 0; lane < lanesUsed; ++lane)
+                    output[firstChannel + lane][outputOffset + produced] = lanesOut[lane];
+            }
+
+            position += down;
+            ++produced;
+        }
+
+        // Keep the newest frames as history for the next chunk
+        for (int group = 0; group * lanes < channelsToProcess; ++group)
+        {
+            Vector* groupStart = groupFrames (group);
+            std::copy (groupStart + count, groupStart + count + historySize, groupStart);
+        }
+
+        return produced;
+    }
+
+    Vector* groupFrames (int group) { return frames.data() + group * groupStride; }
+
+    //==============================================================================
+    TablePtr table;
+    int numChannels = 1;
+    int numGroups = 1;
+    int maxInputBlock = 1;
+    int historySize = 0;
+    int groupStride = 0;
+    juce::int64 position = 0;
+
+    std::vector<Vector> frames;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseResampler)
+};
@@ -0,0 +1,4 @@
+// Implementation file for SpectralGain
+// All methods are currently defined in the header file as inline implementations.
+
+#include "SpectralGain.h"
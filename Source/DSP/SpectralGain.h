@@ -0,0 +1,222 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Spectral Gain Kernel
+ *
+ * Trig-free spectral subtraction on the interleaved spectrum produced by
+ * juce::dsp::FFT::performRealOnlyForwardTransform ([re0, im0, re1, im1, ...]).
+ *
+ * Instead of converting every bin to magnitude/phase and back, a real-valued
+ * gain mask is computed from the magnitude ratio and applied to the real and
+ * imaginary parts directly, which preserves the original phase:
+ *
+ *     gain = max (1 - noise * reduction / |X|, spectralFloor)
+ *
+ * The kernel is one pass over the bins in SIMD lanes, one bin per lane:
+ * magnitude, adaptive profile update, gain and spectral floor are computed
+ * on de-interleaved registers and written straight back. The square root and
+ * reciprocal use the native instructions, which std::sqrt under the default
+ * -fmath-errno never becomes.
+ *
+ * Shared by NoiseReduction and the CPU fallback path of GPUNoiseReduction.
+ */
+class SpectralGain
+{
+public:
+    struct Parameters
+    {
+        float reductionLinear = 1.0f;   // Over-subtraction factor applied to the profile
+        float spectralFloor = 0.01f;    // Minimum gain (-40 dB)
+        float adaptiveRate = 0.0f;      // 0 disables the adaptive profile update
+        float adaptiveThreshold = 1.5f; // Bins below profile * threshold are treated as noise
+    };
+
+    SpectralGain() = default;
+
+    //==============================================================================
+    /** Sets the FFT size; the kernel needs no scratch space */
+    void prepare (int newFftSize)
+    {
+        fftSize = newFftSize;
+        numBins = fftSize / 2 + 1;
+    }
+
+    int getNumBins() const { return numBins; }
+
+    //==============================================================================
+    /**
+     * Applies spectral subtraction in place.
+     *
+     * @param spectrum      Interleaved spectrum, at least 2 * numBins floats
+     * @param noiseProfile  Per-bin noise magnitudes (numBins); updated in place
+     *                      when params.adaptiveRate > 0
+     */
+    void process (float* spectrum, float* noiseProfile, const Parameters& params)
+    {
+        jassert (numBins > 0);
+
+        int bin = 0;
+
+       #if JUCE_USE_SIMD
+        const bool adaptive = params.adaptiveRate > 0.0f;
+        const auto rate = Vector::expand (params.adaptiveRate);
+        const auto threshold = Vector::expand (params.adaptiveThreshold);
+        const auto reduction = Vector::expand (params.reductionLinear);
+        const auto spectralFloor = Vector::expand (params.spectralFloor);
+        const auto one = Vector::expand (1.0f);
+        const auto epsilon = Vector::expand (magnitudeEpsilon);
+
+        alignas (Vector::SIMDRegisterSize) float realLanes[lanes];
+        alignas (Vector::SIMDRegisterSize) float imagLanes[lanes];
+        alignas (Vector::SIMDRegisterSize) float profileLanes[lanes];
+
+        for (; bin + lanes <= numBins; bin += lanes)
+        {
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                realLanes[lane] = spectrum[2 * (bin + lane)];
+                imagLanes[lane] = spectrum[2 * (bin + lane) + 1];
+                profileLanes[lane] = noiseProfile[bin + lane];
+            }
+
+            const auto real = Vector::fromRawArray (realLanes);
+            const auto imag = Vector::fromRawArray (imagLanes);
+            auto profile = Vector::fromRawArray (profileLanes);
+            const auto magnitude = squareRoot (real * real + imag * imag);
+
+            // Adaptive noise profile update (only where the bin is likely noise-dominant)
+            if (adaptive)
+            {
+                const auto noiseDominant = Vector::lessThanOrEqual (magnitude, profile * threshold);
+                profile += ((magnitude - profile) & noiseDominant) * rate;
+                profile.copyToRawArray (profileLanes);
+            }
+
+            // gain = 1 - (noise * reduction) / |X|; the spectral floor prevents musical noise
+            const auto gain = Vector::max (one - profile * reduction * reciprocal (magnitude + epsilon), spectralFloor);
+
+            (real * gain).copyToRawArray (realLanes);
+            (imag * gain).copyToRawArray (imagLanes);
+
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                spectrum[2 * (bin + lane)] = realLanes[lane];
+                spectrum[2 * (bin + lane) + 1] = imagLanes[lane];
+            }
+
+            if (adaptive)
+                std::copy (profileLanes, profileLanes + lanes, noiseProfile + bin);
+        }
+       #endif
+
+        for (; bin < numBins; ++bin)
+            processBin (spectrum + 2 * bin, noiseProfile[bin], params);
+    }
+
+    /** Adds the magnitude of each bin of an interleaved spectrum to accumulator. */
+    static void accumulateMagnitudes (const float* spectrum, float* accumulator, int numBins)
+    {
+        int bin = 0;
+
+       #if JUCE_USE_SIMD
+        alignas (Vector::SIMDRegisterSize) float realLanes[lanes];
+        alignas (Vector::SIMDRegisterSize) float imagLanes[lanes];
+
+        for (; bin + lanes <= numBins; bin += lanes)
+        {
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                realLanes[lane] = spectrum[2 * (bin + lane)];
+                imagLanes[lane] = spectrum[2 * (bin + lane) + 1];
+            }
+
+            const auto real = Vector::fromRawArray (realLanes);
+            const auto imag = Vector::fromRawArray (imagLanes);
+            squareRoot (real * real + imag * imag).copyToRawArray (realLanes);
+
+            for (int lane = 0; lane < lanes; ++lane)
+                accumulator[bin + lane] += realLanes[lane];
+        }
+       #endif
+
+        for (; bin < numBins; ++bin)
+        {
+            const float re = spectrum[2 * bin];
+            const float im = spectrum[2 * bin + 1];
+            accumulator[bin] += std::sqrt (re * re + im * im);
+        }
+    }
+
+    /** Scales the real and imaginary parts of each bin by a real gain. */
+    static void applyGains (float* spectrum, const float* gainMask, int numBins)
+    {
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            spectrum[2 * bin] *= gainMask[bin];
+            spectrum[2 * bin + 1] *= gainMask[bin];
+        }
+    }
+
+private:
+    //==============================================================================
+    static constexpr float magnitudeEpsilon = 1.0e-20f;
+
+    /** The kernel for one bin, for the bins past the last full register */
+    static void processBin (float* bin, float& profile, const Parameters& params)
+    {
+        const float magnitude = std::sqrt (bin[0] * bin[0] + bin[1] * bin[1]);
+
+        if (params.adaptiveRate > 0.0f && magnitude <= profile * params.adaptiveThreshold)
+            profile += params.adaptiveRate * (magnitude - profile);
+
+        const float gain = juce::jmax (1.0f - profile * params.reductionLinear / (magnitude + magnitudeEpsilon),
+                                       params.spectralFloor);
+        bin[0] *= gain;
+        bin[1] *= gain;
+    }
+
+   #if JUCE_USE_SIMD
+    using Vector = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = static_cast<int> (Vector::SIMDNumElements);
+
+    // SIMDRegister has neither a square root nor a division
+    static Vector squareRoot (Vector x)
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        static_assert (Vector::SIMDRegisterSize == sizeof (__m128), "SIMDRegister<float> is expected to be SSE here");
+        return Vector::fromNative (_mm_sqrt_ps (x.value));
+       #elif JUCE_USE_ARM_NEON && (defined (__aarch64__) || defined (_M_ARM64))
+        return Vector::fromNative (vsqrtq_f32 (x.value));
+       #else
+        for (size_t lane = 0; lane < Vector::SIMDNumElements; ++lane)
+            x.set (lane, std::sqrt (x.get (lane)));
+
+        return x;
+       #endif
+    }
+
+    static Vector reciprocal (Vector x)
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        return Vector::fromNative (_mm_div_ps (_mm_set1_ps (1.0f), x.value));
+       #elif JUCE_USE_ARM_NEON && (defined (__aarch64__) || defined (_M_ARM64))
+        return Vector::fromNative (vdivq_f32 (vdupq_n_f32 (1.0f), x.value));
+       #else
+        for (size_t lane = 0; lane < Vector::SIMDNumElements; ++lane)
+            x.set (lane, 1.0f / x.get (lane));
+
+        return x;
+       #endif
+    }
+   #endif
+
+    int fftSize = 0;
+    int numBins = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectralGain)
+};
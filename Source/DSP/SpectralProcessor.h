@@ -1,6 +1,8 @@
 #pragma once
 
 #include <juce_dsp/juce_dsp.h>
+#include "FFTCache.h"
+#include <utility>
 
 /**
  * Spectral Processor Utilities
@@ -13,6 +15,15 @@ class SpectralProcessor
 public:
     SpectralProcessor() = default;
 
+    ~SpectralProcessor()
+    {
+        if (window == nullptr)
+            return;
+
+        window.reset();
+        FFTCache::purgeUnused();
+    }
+
     //==============================================================================
     /** Initialize FFT with specified order */
     void initialize (int order)
@@ -20,14 +31,22 @@ public:
         fftOrder = order;
         fftSize = 1 << fftOrder;
 
-        fft = std::make_unique<juce::dsp::FFT> (fftOrder);
+        // Each processor owns its engine (a shared one would serialise every instance's perform())
+        if (fft == nullptr || fft->getSize() != fftSize)
+            fft = std::make_unique<juce::dsp::FFT> (fftOrder);
+
         fftData.resize (fftSize * 2);
-        window.resize (fftSize);
 
-        // Create Hann window
-        juce::dsp::WindowingFunction<float>::fillWindowingTables (
-            window.data(), fftSize,
-            juce::dsp::WindowingFunction<float>::hann, false);
+        // Periodic Hann window so that overlapping frames sum to a constant without ripple;
+        // the table is shared process-wide
+        auto previous = std::exchange (window, FFTCache::getWindow (fftSize, juce::dsp::WindowingFunction<float>::hann, true));
+
+        // A size change can leave the previous table unused
+        if (previous != nullptr && previous != window)
+        {
+            previous.reset();
+            FFTCache::purgeUnused();
+        }
     }
 
     //==============================================================================
@@ -37,7 +56,7 @@ public:
         // Copy and apply window
         for (int i = 0; i < fftSize; ++i)
         {
-            fftData[i] = inputData[i] * window[i];
+            fftData[i] = inputData[i] * (*window)[i];
             fftData[fftSize + i] = 0.0f; // Clear imaginary part
         }
 
@@ -70,6 +89,26 @@ public:
             outputData[i] = fftData[i];
     }
 
+    //==============================================================================
+    /**
+     * In-place forward FFT of already windowed real data.
+     * The buffer must hold 2 * fftSize floats; the result is the interleaved
+     * [re, im] spectrum for fftSize / 2 + 1 bins.
+     */
+    void performForwardTransform (float* data) const
+    {
+        fft->performRealOnlyForwardTransform (data, true);
+    }
+
+    /** In-place inverse FFT of an interleaved spectrum (2 * fftSize floats) */
+    void performInverseTransform (float* data) const
+    {
+        fft->performRealOnlyInverseTransform (data);
+    }
+
+    /** Analysis window (fftSize samples) */
+    const float* getWindow() const { return window->data(); }
+
     //==============================================================================
     /** Calculate magnitude spectrum */
     static void calculateMagnitude (const float* real, const float* imag,
@@ -114,7 +153,7 @@ private:
 
     std::unique_ptr<juce::dsp::FFT> fft;
     std::vector<float> fftData;
-    std::vector<float> window;
+    FFTCache::WindowPtr window;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectralProcessor)
 };
@@ -0,0 +1,4 @@
+// Implementation file for StftEngine
+// All methods are currently defined in the header file as inline implementations.
+
+#include "StftEngine.h"
@@ -0,0 +1,515 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "SpectralProcessor.h"
+#include <cmath>
+#include <vector>
+
+/**
+ * Streaming STFT Engine
+ *
+ * Shared short-time Fourier transform front end for all spectral modules.
+ * Framing is persistent across calls: every channel owns an input ring and an
+ * overlap-add output ring, and exactly one FFT runs per hop regardless of the
+ * host block size. Blocks of 32 samples and blocks of 8192 samples produce the
+ * same output and cost the same per second of audio.
+ *
+ * - process():           analysis -> spectrum callback -> resynthesis
+ * - processTimeFrames(): analysis window -> custom frame transform -> resynthesis
+ *                        (used by the GPU path, which runs its own FFT)
+ * - processTimeFrameBatches(): the same, with every frame of a block handed over
+ *                        at once so a device can transform them in one batch
+ * - processSpanBatches(): batched, with windowing and overlap-add left to the
+ *                        callback too: it gets raw input spans and returns
+ *                        overlap-added output spans (used by the fused GPU path)
+ * - processBypassed():   identity resynthesis, keeps latency and ring state intact
+ * - analyse():           analysis only, no output
+ * - transformFrame():    one-shot transform of an arbitrary frame (offline views)
+ *
+ * Spectra are in the interleaved [re, im] layout of juce::dsp::FFT for
+ * fftSize / 2 + 1 bins. Resynthesised output is delayed by getLatencySamples().
+ */
+class StftEngine
+{
+public:
+    StftEngine() = default;
+
+    //==============================================================================
+    /**
+     * Allocates rings and frame buffers. Not real-time safe.
+     * The hop size must divide the FFT size; it is rounded down to a power of two.
+     */
+    void prepare (int newFftOrder, int newHopSize, int newNumChannels)
+    {
+        spectral.initialize (newFftOrder);
+
+        fftOrder = newFftOrder;
+        fftSize = spectral.getFFTSize();
+        hopSize = juce::jlimit (1, fftSize, newHopSize);
+        hopSize = 1 << juce::jmax (0, static_cast<int> (std::log2 (static_cast<double> (hopSize))));
+        numChannels = juce::jmax (1, newNumChannels);
+
+        frameBuffer.assign (static_cast<size_t> (fftSize * 2), 0.0f);
+        oneShotBuffer.assign (static_cast<size_t> (fftSize * 2), 0.0f);
+
+        channels.resize (static_cast<size_t> (numChannels));
+        spanFrames.assign (static_cast<size_t> (numChannels), 0);
+        for (auto& state : channels)
+        {
+            state.inputRing.assign (static_cast<size_t> (fftSize), 0.0f);
+            state.outputRing.assign (static_cast<size_t> (fftSize), 0.0f);
+        }
+
+        // Synthesis window normalised by the overlap-add sum of the squared
+        // analysis window, giving perfect reconstruction for any hop <= fftSize / 2
+        const float* window = spectral.getWindow();
+        std::vector<double> overlapSum (static_cast<size_t> (hopSize), 0.0);
+
+        for (int i = 0; i < fftSize; ++i)
+            overlapSum[static_cast<size_t> (i % hopSize)] += static_cast<double> (window[i]) * window[i];
+
+        synthesisWindow.resize (static_cast<size_t> (fftSize));
+        for (int i = 0; i < fftSize; ++i)
+        {
+            const double norm = overlapSum[static_cast<size_t> (i % hopSize)];
+            synthesisWindow[static_cast<size_t> (i)] = norm > 1.0e-9 ? static_cast<float> (window[i] / norm) : 0.0f;
+        }
+
+        reset();
+    }
+
+    /** Clears all channel rings; the next frame is emitted after one full hop */
+    void reset()
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            resetChannel (channel);
+    }
+
+    /** Clears one channel's rings, e.g. when a new stream starts on it */
+    void resetChannel (int channel)
+    {
+        if (!juce::isPositiveAndBelow (channel, static_cast<int> (channels.size())))
+            return;
+
+        auto& state = channels[static_cast<size_t> (channel)];
+        std::fill (state.inputRing.begin(), state.inputRing.end(), 0.0f);
+        std::fill (state.outputRing.begin(), state.outputRing.end(), 0.0f);
+        state.position = 0;
+        state.hopCounter = 0;
+    }
+
+    //==============================================================================
+    int getFFTOrder() const { return fftOrder; }
+    int getFFTSize() const { return fftSize; }
+    int getHopSize() const { return hopSize; }
+    int getNumBins() const { return fftSize / 2 + 1; }
+    int getNumChannels() const { return numChannels; }
+    bool isPrepared() const { return !channels.empty(); }
+
+    /** Delay between input and resynthesised output, in samples */
+    int getLatencySamples() const { return fftSize; }
+
+    SpectralProcessor& getSpectralProcessor() { return spectral; }
+
+    /** Analysis window (fftSize) and the matching synthesis window, for callers that window frames themselves */
+    const float* getAnalysisWindow() const { return spectral.getWindow(); }
+    const float* getSynthesisWindow() const { return synthesisWindow.data(); }
+
+    /** Samples of input, or of overlap-added output, spanned by numFrames consecutive frames */
+    int getSpanLength (int numFrames) const { return fftSize + (juce::jmax (1, numFrames) - 1) * hopSize; }
+
+    //==============================================================================
+    /**
+     * Streams samples through analysis, a spectrum callback and resynthesis.
+     * onSpectrum (float* interleavedSpectrum, int channel) is invoked once per hop
+     * and may modify the spectrum in place.
+     */
+    template <typename SpectrumCallback>
+    void process (float* data, int numSamples, int channel, SpectrumCallback&& onSpectrum)
+    {
+        auto onFrame = [this, &onSpectrum] (float* frame, int ch)
+        {
+            spectral.performForwardTransform (frame);
+            onSpectrum (frame, ch);
+            spectral.performInverseTransform (frame);
+        };
+
+        run<true> (data, data, numSamples, channel, onFrame);
+    }
+
+    /**
+     * Streams samples through analysis windowing and resynthesis with a custom
+     * frame transform. onFrame (float* frame, int channel) receives fftSize
+     * windowed samples in a 2 * fftSize buffer and must leave the processed
+     * time-domain frame in the first fftSize floats.
+     */
+    template <typename FrameCallback>
+    void processTimeFrames (float* data, int numSamples, int channel, FrameCallback&& onFrame)
+    {
+        run<true> (data, data, numSamples, channel, onFrame);
+    }
+
+    /**
+     * Batched processTimeFrames() across channels. All frames the block produces
+     * are windowed into `frames` first, channel by channel, spaced 2 * fftSize
+     * floats apart like the single-frame buffer; onBatch (float* frames, int numFrames)
+     * then transforms them together, and resynthesis replays the block with the
+     * results. The output is identical to processTimeFrames(). Blocks that would
+     * produce more than maxFrames frames are handled in several batches.
+     *
+     * data[i] streams through engine channel channelIndices[i], or channel i when
+     * channelIndices is null, so unrelated streams can share one batch.
+     */
+    template <typename BatchCallback>
+    void processTimeFrameBatches (float* const* data, const int* channelIndices, int numChannelsToProcess,
+                                  int numSamples, float* frames, int maxFrames, BatchCallback&& onBatch)
+    {
+        if (channelIndices == nullptr)
+            numChannelsToProcess = juce::jmin (numChannelsToProcess, numChannels);
+        else
+            for (int ch = 0; ch < numChannelsToProcess; ++ch)
+                if (!juce::isPositiveAndBelow (channelIndices[ch], numChannels))
+                {
+                    jassertfalse;
+                    return;
+                }
+
+        const auto stateFor = [this, channelIndices] (int ch) -> ChannelState&
+        {
+            return channels[static_cast<size_t> (channelIndices != nullptr ? channelIndices[ch] : ch)];
+        };
+
+        const int maxFramesPerChannel = numChannelsToProcess > 0 ? maxFrames / numChannelsToProcess : 0;
+
+        if (maxFramesPerChannel < 1)
+        {
+            jassert (numChannelsToProcess == 0);
+            return;
+        }
+
+        const size_t frameStride = static_cast<size_t> (fftSize * 2);
+
+        for (int done = 0; done < numSamples;)
+        {
+            // Stop short of the hop that would complete one frame too many on any channel
+            int passSamples = numSamples - done;
+            for (int ch = 0; ch < numChannelsToProcess; ++ch)
+                passSamples = juce::jmin (passSamples, maxFramesPerChannel * hopSize - stateFor (ch).hopCounter);
+
+            // Analysis only depends on earlier input, so every frame can be cut before any is processed
+            int numFrames = 0;
+            auto collect = [this, frames, frameStride, &numFrames] (ChannelState& state)
+            {
+                windowFrame (state, frames + static_cast<size_t> (numFrames++) * frameStride);
+            };
+
+            for (int ch = 0; ch < numChannelsToProcess; ++ch)
+            {
+                auto& state = stateFor (ch);
+                state.batchPosition = state.position;
+                state.batchHopCounter = state.hopCounter;
+                walk<false> (state, data[ch] + done, nullptr, passSamples, collect);
+            }
+
+            if (numFrames > 0)
+                onBatch (frames, numFrames);
+
+            // Resynthesis replays the same positions, overlap-adding each result where it was cut
+            int nextFrame = 0;
+            auto emit = [this, frames, frameStride, &nextFrame] (ChannelState& state)
+            {
+                overlapAdd (state, frames + static_cast<size_t> (nextFrame++) * frameStride);
+            };
+
+            for (int ch = 0; ch < numChannelsToProcess; ++ch)
+            {
+                auto& state = stateFor (ch);
+                state.position = state.batchPosition;
+                state.hopCounter = state.batchHopCounter;
+                walk<true> (state, nullptr, data[ch] + done, passSamples, emit);
+            }
+
+            done += passSamples;
+        }
+    }
+
+    /**
+     * Batched processing where the callback does the windowing and overlap-add
+     * as well as the transform, so only raw samples change hands. For each
+     * channel i, inputSpans + i * spanStride receives the unwindowed input under
+     * its framesPerChannel[i] frames of the pass, oldest first: frame j covers
+     * [j * hopSize, j * hopSize + fftSize). onBatch (const float* inputSpans,
+     * float* outputSpans, const int* framesPerChannel, int numChannels, int spanStride)
+     * must fill outputSpans + i * spanStride, for getSpanLength (framesPerChannel[i])
+     * samples, with sum_j synthesisWindow * frame_j placed at j * hopSize. Channels
+     * with no frames in a pass are left alone. With that contract the output
+     * matches processTimeFrames() up to rounding.
+     *
+     * Both span buffers hold numChannelsToProcess * getSpanLength (maxFramesPerChannel)
+     * floats, with spanStride = getSpanLength (maxFramesPerChannel). channelIndices
+     * works as in processTimeFrameBatches(); at most getNumChannels() streams.
+     */
+    template <typename SpanCallback>
+    void processSpanBatches (float* const* data, const int* channelIndices, int numChannelsToProcess, int numSamples,
+                             float* inputSpans, float* outputSpans, int maxFramesPerChannel, SpanCallback&& onBatch)
+    {
+        numChannelsToProcess = juce::jmin (numChannelsToProcess, numChannels);
+
+        if (channelIndices != nullptr)
+            for (int ch = 0; ch < numChannelsToProcess; ++ch)
+                if (!juce::isPositiveAndBelow (channelIndices[ch], numChannels))
+                {
+                    jassertfalse;
+                    return;
+                }
+
+        const auto stateFor = [this, channelIndices] (int ch) -> ChannelState&
+        {
+            return channels[static_cast<size_t> (channelIndices != nullptr ? channelIndices[ch] : ch)];
+        };
+
+        if (maxFramesPerChannel < 1 || numChannelsToProcess == 0)
+            return;
+
+        const int spanStride = getSpanLength (maxFramesPerChannel);
+
+        for (int done = 0; done < numSamples;)
+        {
+            int passSamples = numSamples - done;
+            for (int ch = 0; ch < numChannelsToProcess; ++ch)
+                passSamples = juce::jmin (passSamples, maxFramesPerChannel * hopSize - stateFor (ch).hopCounter);
+
+            // The first frame brings the whole ring, every later one only its newest hop
+            bool anyFrames = false;
+
+            for (int ch = 0; ch < numChannelsToProcess; ++ch)
+            {
+                auto& state = stateFor (ch);
+                float* span = inputSpans + static_cast<size_t> (ch) * static_cast<size_t> (spanStride);
+                int& count = spanFrames[static_cast<size_t> (ch)];
+                count = 0;
+
+                auto collect = [this, span, &count] (ChannelState& s)
+                {
+                    if (count == 0)
+                        unrollRing (s, span, fftSize);
+                    else
+                        unrollRing (s, span + fftSize + (count - 1) * hopSize, hopSize);
+
+                    ++count;
+                };
+
+                state.batchPosition = state.position;
+                state.batchHopCounter = state.hopCounter;
+                walk<false> (state, data[ch] + done, nullptr, passSamples, collect);
+                anyFrames = anyFrames || count > 0;
+            }
+
+            if (anyFrames)
+                onBatch (static_cast<const float*> (inputSpans), outputSpans, static_cast<const int*> (spanFrames.data()),
+                         numChannelsToProcess, spanStride);
+
+            // The span already holds every frame's share, so a later frame only adds
+            // the hop that enters the output ring with it
+            for (int ch = 0; ch < numChannelsToProcess; ++ch)
+            {
+                auto& state = stateFor (ch);
+                const float* span = outputSpans + static_cast<size_t> (ch) * static_cast<size_t> (spanStride);
+                int next = 0;
+
+                auto emit = [this, span, &next] (ChannelState& s)
+                {
+                    if (next == 0)
+                        addToRing (s, span, 0, fftSize);
+                    else
+                        addToRing (s, span + fftSize + (next - 1) * hopSize, fftSize - hopSize, hopSize);
+
+                    ++next;
+                };
+
+                state.position = state.batchPosition;
+                state.hopCounter = state.batchHopCounter;
+                walk<true> (state, nullptr, data[ch] + done, passSamples, emit);
+            }
+
+            done += passSamples;
+        }
+    }
+
+    /** Identity resynthesis: delays the signal by the engine latency without any FFT */
+    void processBypassed (float* data, int numSamples, int channel)
+    {
+        auto identity = [] (float*, int) {};
+        run<true> (data, data, numSamples, channel, identity);
+    }
+
+    /**
+     * Streams samples through analysis only.
+     * onSpectrum (const float* interleavedSpectrum, int channel) is invoked once per hop.
+     */
+    template <typename SpectrumCallback>
+    void analyse (const float* data, int numSamples, int channel, SpectrumCallback&& onSpectrum)
+    {
+        auto onFrame = [this, &onSpectrum] (float* frame, int ch)
+        {
+            spectral.performForwardTransform (frame);
+            onSpectrum (static_cast<const float*> (frame), ch);
+        };
+
+        run<false> (data, nullptr, numSamples, channel, onFrame);
+    }
+
+    /**
+     * One-shot windowed transform of an arbitrary frame, zero-padded when
+     * numSamples < fftSize. Independent of the streaming state. The returned
+     * interleaved spectrum stays valid until the next call.
+     */
+    const float* transformFrame (const float* input, int numSamples)
+    {
+        const int count = juce::jlimit (0, fftSize, numSamples);
+        float* frame = oneShotBuffer.data();
+
+        juce::FloatVectorOperations::multiply (frame, input, spectral.getWindow(), count);
+        juce::FloatVectorOperations::clear (frame + count, fftSize * 2 - count);
+
+        spectral.performForwardTransform (frame);
+        return frame;
+    }
+
+private:
+    //==============================================================================
+    struct ChannelState
+    {
+        std::vector<float> inputRing;
+        std::vector<float> outputRing;
+        int position = 0;   // Next write index; also the oldest sample in inputRing
+        int hopCounter = 0; // Samples received since the last frame
+        int batchPosition = 0;    // Ring state at the start of a batch, for the resynthesis replay
+        int batchHopCounter = 0;
+    };
+
+    template <bool resynthesise, typename FrameCallback>
+    void run (const float* input, float* output, int numSamples, int channel, FrameCallback& onFrame)
+    {
+        if (!juce::isPositiveAndBelow (channel, numChannels))
+        {
+            jassertfalse;
+            return;
+        }
+
+        auto onHop = [this, channel, &onFrame] (ChannelState& state)
+        {
+            float* frame = frameBuffer.data();
+            windowFrame (state, frame);
+            onFrame (frame, channel);
+
+            if constexpr (resynthesise)
+                overlapAdd (state, frame);
+        };
+
+        walk<resynthesise> (channels[static_cast<size_t> (channel)], input, output, numSamples, onHop);
+    }
+
+    /**
+     * Advances a channel's rings by numSamples, calling onHop (ChannelState&) at
+     * every hop boundary. A null input leaves the input ring alone (replaying a
+     * block already analysed); readOutput moves samples out of the output ring.
+     */
+    template <bool readOutput, typename HopCallback>
+    void walk (ChannelState& state, const float* input, float* output, int numSamples, HopCallback& onHop)
+    {
+        float* inputRing = state.inputRing.data();
+        float* outputRing = state.outputRing.data();
+
+        while (numSamples > 0)
+        {
+            const int chunk = juce::jmin (numSamples, hopSize - state.hopCounter, fftSize - state.position);
+
+            // Input is copied before output is written, so data may be processed in place
+            if (input != nullptr)
+            {
+                juce::FloatVectorOperations::copy (inputRing + state.position, input, chunk);
+                input += chunk;
+            }
+
+            if constexpr (readOutput)
+            {
+                juce::FloatVectorOperations::copy (output, outputRing + state.position, chunk);
+                juce::FloatVectorOperations::clear (outputRing + state.position, chunk);
+                output += chunk;
+            }
+
+            numSamples -= chunk;
+            state.hopCounter += chunk;
+            state.position += chunk;
+
+            if (state.position == fftSize)
+                state.position = 0;
+
+            if (state.hopCounter == hopSize)
+            {
+                state.hopCounter = 0;
+                onHop (state);
+            }
+        }
+    }
+
+    /** Unrolls the input ring (oldest sample first) into frame and applies the analysis window */
+    void windowFrame (const ChannelState& state, float* frame) const
+    {
+        const float* window = spectral.getWindow();
+        const int newest = fftSize - state.position;
+
+        juce::FloatVectorOperations::multiply (frame, state.inputRing.data() + state.position, window, newest);
+        juce::FloatVectorOperations::multiply (frame + newest, state.inputRing.data(), window + newest, state.position);
+    }
+
+    /** Copies the newest count samples of the input ring, oldest first */
+    void unrollRing (const ChannelState& state, float* dest, int count) const
+    {
+        const int start = (state.position + fftSize - count) % fftSize;
+        const int first = juce::jmin (count, fftSize - start);
+
+        juce::FloatVectorOperations::copy (dest, state.inputRing.data() + start, first);
+        juce::FloatVectorOperations::copy (dest + first, state.inputRing.data(), count - first);
+    }
+
+    /** Adds count samples to the output ring at frame offset frameOffset, aligned as overlapAdd() */
+    void addToRing (ChannelState& state, const float* source, int frameOffset, int count)
+    {
+        const int start = (state.position + frameOffset) % fftSize;
+        const int first = juce::jmin (count, fftSize - start);
+
+        float* outputRing = state.outputRing.data();
+        juce::FloatVectorOperations::add (outputRing + start, source, first);
+        juce::FloatVectorOperations::add (outputRing, source + first, count - first);
+    }
+
+    /** Synthesis window and overlap-add, aligned with the input ring positions */
+    void overlapAdd (ChannelState& state, float* frame)
+    {
+        const int newest = fftSize - state.position;
+        juce::FloatVectorOperations::multiply (frame, synthesisWindow.data(), fftSize);
+
+        float* outputRing = state.outputRing.data();
+        juce::FloatVectorOperations::add (outputRing + state.position, frame, newest);
+        juce::FloatVectorOperations::add (outputRing, frame + newest, state.position);
+    }
+
+    //==============================================================================
+    SpectralProcessor spectral;
+
+    int fftOrder = 11;
+    int fftSize = 2048;
+    int hopSize = 512;
+    int numChannels = 0;
+
+    std::vector<float> frameBuffer;
+    std::vector<float> oneShotBuffer;
+    std::vector<float> synthesisWindow;
+    std::vector<ChannelState> channels;
+    std::vector<int> spanFrames;    // Frames per channel in the current span pass
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StftEngine)
+};
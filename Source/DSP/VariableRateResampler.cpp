@@ -0,0 +1,298 @@
+#include "VariableRateResampler.h"
+#include "PolyphaseResampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace
+{
+    // Kernel reach at unity speed, as PolyphaseResampler's 64 taps per phase
+    constexpr int baseRadius = 32;
+
+    // Speed bounds are rounded up to steps of 1/16, so a pass of many maps shares few tables
+    constexpr double speedSteps = 16.0;
+
+    struct CacheStorage
+    {
+        juce::CriticalSection lock;
+        std::map<int, VariableRateResampler::TablePtr> tables;
+    };
+
+    CacheStorage& getStorage()
+    {
+        static CacheStorage storage;
+        return storage;
+    }
+
+    int getSpeedKey (double maxSpeed)
+    {
+        return static_cast<int> (std::ceil (juce::jmax (1.0, maxSpeed) * speedSteps - 1.0e-9));
+    }
+
+    VariableRateResampler::Table designTable (int speedKey)
+    {
+        VariableRateResampler::Table table;
+        table.maxSpeed = speedKey / speedSteps;
+
+        const int radius = VariableRateResampler::getKernelRadius (table.maxSpeed);
+        table.taps = 2 * radius;
+
+        // Reading faster than real time decimates: the stopband starts at the output's Nyquist
+        const double transition = (PolyphaseResampler::stopbandAttenuationDb - 8.0)
+                                / (2.285 * juce::MathConstants<double>::twoPi * table.taps);
+        const double cutoff = juce::jmax (0.5 / table.maxSpeed - 0.5 * transition, 0.25 / table.maxSpeed);
+
+        // Row p is the kernel for a position p / numPhases past an input sample; tap k
+        // reads the sample radius - 1 - k before it. Each row has unity DC gain.
+        const int numRows = VariableRateResampler::numPhases + 1;
+        std::vector<float> rows (static_cast<size_t> (numRows * table.taps));
+
+        for (int row = 0; row < numRows; ++row)
+        {
+            const double fraction = static_cast<double> (row) / VariableRateResampler::numPhases;
+            std::vector<double> kernel (static_cast<size_t> (table.taps));
+            double sum = 0.0;
+
+            for (int k = 0; k < table.taps; ++k)
+            {
+                kernel[static_cast<size_t> (k)] = PolyphaseResampler::windowedSinc (fraction + radius - 1 - k, cutoff, radius);
+                sum += kernel[static_cast<size_t> (k)];
+            }
+
+            const double gain = sum != 0.0 ? 1.0 / sum : 0.0;
+            float* destination = rows.data() + static_cast<size_t> (row * table.taps);
+
+            for (int k = 0; k < table.taps; ++k)
+                destination[k] = static_cast<float> (kernel[static_cast<size_t> (k)] * gain);
+        }
+
+        const auto size = static_cast<size_t> (VariableRateResampler::numPhases * table.taps);
+        table.coefficients.assign (rows.begin(), rows.begin() + static_cast<std::ptrdiff_t> (size));
+        table.deltas.resize (size);
+
+        for (size_t i = 0; i < size; ++i)
+            table.deltas[i] = rows[i + static_cast<size_t> (table.taps)] - rows[i];
+
+        return table;
+    }
+}
+
+//==============================================================================
+VariableRateResampler::TimeMap VariableRateResampler::TimeMap::constantSpeed (double speed, juce::int64 numOutputs)
+{
+    jassert (speed > 0.0);
+
+    TimeMap map;
+    map.speed = map.maxSpeed = speed;
+    map.numOutputs = juce::jmax ((juce::int64) 0, numOutputs);
+    return map;
+}
+
+VariableRateResampler::TimeMap VariableRateResampler::TimeMap::fromSpeedCurve (SpeedCurve curve, juce::int64 numOutputs)
+{
+    TimeMap map;
+    map.curve = std::move (curve);
+    map.numOutputs = juce::jmax ((juce::int64) 0, numOutputs);
+
+    const auto numBlocks = (map.numOutputs + anchorInterval - 1) / anchorInterval;
+    std::vector<double> sums (static_cast<size_t> (numBlocks)), peaks (static_cast<size_t> (numBlocks));
+
+    const auto integrate = [&map, &sums, &peaks] (juce::int64 firstBlock, juce::int64 endBlock)
+    {
+        for (auto block = firstBlock; block < endBlock; ++block)
+        {
+            const auto end = juce::jmin (map.numOutputs, (block + 1) * anchorInterval);
+            double sum = 0.0;
+            double peak = 0.0;
+
+            for (auto n = block * anchorInterval; n < end; ++n)
+            {
+                const double speed = map.curve (n);
+                jassert (speed > 0.0);
+                sum += speed;
+                peak = juce::jmax (peak, speed);
+            }
+
+            sums[static_cast<size_t> (block)] = sum;
+            peaks[static_cast<size_t> (block)] = peak;
+        }
+    };
+
+    const int numThreads = static_cast<int> (juce::jlimit ((juce::int64) 1, juce::jmax ((juce::int64) 1, numBlocks),
+                                                           (juce::int64) juce::SystemStats::getNumCpus()));
+
+    if (numThreads == 1)
+    {
+        integrate (0, numBlocks);
+    }
+    else
+    {
+        // Each job owns a disjoint run of blocks, so they write without sharing
+        juce::ThreadPool pool (numThreads);
+
+        for (int job = 0; job < numThreads; ++job)
+        {
+            const auto from = numBlocks * job / numThreads;
+            const auto to = numBlocks * (job + 1) / numThreads;
+
+            pool.addJob ([integrate, from, to]
+            {
+                integrate (from, to);
+                return juce::ThreadPoolJob::jobHasFinished;
+            });
+        }
+
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep (1);
+    }
+
+    map.anchors.resize (static_cast<size_t> (numBlocks + 1));
+    map.anchors[0] = 0.0;
+    map.maxSpeed = 0.0;
+
+    for (size_t block = 0; block < sums.size(); ++block)
+    {
+        map.anchors[block + 1] = map.anchors[block] + sums[block];
+        map.maxSpeed = juce::jmax (map.maxSpeed, peaks[block]);
+    }
+
+    if (map.maxSpeed <= 0.0)
+        map.maxSpeed = 1.0;
+
+    return map;
+}
+
+void VariableRateResampler::TimeMap::getPositions (juce::int64 firstOutput, int count, double* positions) const
+{
+    if (curve == nullptr)
+    {
+        for (int i = 0; i < count; ++i)
+            positions[i] = static_cast<double> (firstOutput + i) * speed;
+
+        return;
+    }
+
+    // Walk from the anchor at or before the first output, restarting at every anchor on the
+    // way, so a position never depends on where its chunk began
+    const auto lastAnchor = static_cast<juce::int64> (anchors.size()) - 1;
+    auto anchor = juce::jlimit ((juce::int64) 0, lastAnchor, firstOutput / anchorInterval);
+    auto n = anchor * anchorInterval;
+    double position = anchors[static_cast<size_t> (anchor)];
+
+    for (; n < firstOutput; ++n)
+        position += curve (n);
+
+    for (int i = 0; i < count; ++i, ++n)
+    {
+        if (n % anchorInterval == 0 && n / anchorInterval <= lastAnchor)
+            position = anchors[static_cast<size_t> (n / anchorInterval)];
+
+        positions[i] = position;
+        position += curve (n);
+    }
+}
+
+//==============================================================================
+VariableRateResampler::VariableRateResampler (double maxSpeed)
+    : table (getTable (maxSpeed))
+{
+}
+
+int VariableRateResampler::getKernelRadius (double maxSpeed)
+{
+    return static_cast<int> (std::ceil (baseRadius * getSpeedKey (maxSpeed) / speedSteps));
+}
+
+void VariableRateResampler::render (const juce::AudioBuffer<float>& source, juce::Range<int> readable, int origin,
+                                    const TimeMap& map, juce::int64 firstOutput, int numOutputs,
+                                    juce::AudioBuffer<float>& output, int outputOffset) const
+{
+    const int numChannels = juce::jmin (source.getNumChannels(), output.getNumChannels());
+    const int taps = table->taps;
+    const int radius = taps / 2;
+
+    readable = readable.getIntersectionWith ({ 0, source.getNumSamples() });
+
+    std::vector<double> positions;
+    std::vector<Vector> frames;
+
+    for (int done = 0; done < numOutputs;)
+    {
+        const int count = juce::jmin (blockSize, numOutputs - done);
+        positions.resize (static_cast<size_t> (count));
+        map.getPositions (firstOutput + done, count, positions.data());
+
+        // Every input the block's kernels touch
+        const auto range = std::minmax_element (positions.begin(), positions.end());
+        const auto windowStart = static_cast<juce::int64> (std::floor (*range.first)) + origin - radius + 1;
+        const auto windowEnd = static_cast<juce::int64> (std::floor (*range.second)) + origin + radius + 1;
+        const int windowLength = static_cast<int> (windowEnd - windowStart);
+        const auto copyStart = juce::jmax (windowStart, static_cast<juce::int64> (readable.getStart()));
+        const auto copyEnd = juce::jmin (windowEnd, static_cast<juce::int64> (readable.getEnd()));
+
+        for (int group = 0; group * lanes < numChannels; ++group)
+        {
+            // Interleave the window, one frame per sample and one lane per channel, silent outside readable
+            const int firstChannel = group * lanes;
+            const int lanesUsed = juce::jmin (lanes, numChannels - firstChannel);
+
+            frames.assign (static_cast<size_t> (windowLength), broadcast (0.0f));
+            float* interleaved = reinterpret_cast<float*> (frames.data());
+
+            for (int lane = 0; lane < lanesUsed; ++lane)
+            {
+                const float* data = source.getReadPointer (firstChannel + lane);
+
+                for (auto i = copyStart; i < copyEnd; ++i)
+                    interleaved[(i - windowStart) * lanes + lane] = data[i];
+            }
+
+            for (int i = 0; i < count; ++i)
+            {
+                const double position = positions[static_cast<size_t> (i)] + static_cast<double> (origin - windowStart);
+                const double whole = std::floor (position);
+                const double phasePosition = (position - whole) * numPhases;
+                const int phase = juce::jmin (static_cast<int> (phasePosition), numPhases - 1);
+
+                const float* kernel = table->coefficients.data() + static_cast<size_t> (phase * taps);
+                const float* delta = table->deltas.data() + static_cast<size_t> (phase * taps);
+                const Vector* x = frames.data() + (static_cast<int> (whole) - radius + 1);
+
+                Vector sum = broadcast (0.0f);
+                Vector sumOfDeltas = broadcast (0.0f);
+
+                for (int k = 0; k < taps; ++k)
+                {
+                    sum += x[k] * kernel[k];
+                    sumOfDeltas += x[k] * delta[k];
+                }
+
+                sum += sumOfDeltas * broadcast (static_cast<float> (phasePosition - phase));
+
+                const float* lanesOut = reinterpret_cast<const float*> (&sum);
+
+                for (int lane = 0; lane < lanesUsed; ++lane)
+                    output.getWritePointer (firstChannel + lane)[outputOffset + done + i] = lanesOut[lane];
+            }
+        }
+
+        done += count;
+    }
+}
+
+//==============================================================================
+VariableRateResampler::TablePtr VariableRateResampler::getTable (double maxSpeed)
+{
+    const int key = getSpeedKey (maxSpeed);
+
+    auto& storage = getStorage();
+    const juce::ScopedLock sl (storage.lock);
+
+    auto& table = storage.tables[key];
+
+    if (table == nullptr)
+        table = std::make_shared<const Table> (designTable (key));
+
+    return table;
+}
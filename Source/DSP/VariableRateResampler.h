@@ -0,0 +1,124 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Variable Rate Resampler
+ *
+ * Offline resampling along a time map: output sample n is read from input
+ * position t(n), where t advances by a speed curve that may change every
+ * sample (an eccentric record's sinusoidal wow, a constant speed change).
+ * Each output is a windowed-sinc interpolation, with the kernel taken from a
+ * table of numPhases sub-sample phases and interpolated linearly between the
+ * two nearest, so any fractional position costs two dot products.
+ *
+ * The kernel is PolyphaseResampler's prototype (see windowedSinc()); where the
+ * map reads faster than real time its cutoff drops and it widens, so speeding
+ * up does not alias. Tables are shared per speed bound, like
+ * PolyphaseResampler's.
+ *
+ * Channels are interleaved into SIMD lanes, as in PolyphaseResampler: they
+ * share the time map, so stereo costs the same as mono. render() is const
+ * and keeps its state on the stack, so the chunks of one pass can render on
+ * several threads at once (see RegionProcessor).
+ */
+class VariableRateResampler
+{
+public:
+    static constexpr int numPhases = 256;
+
+    /** Immutable kernel bank for one speed bound */
+    struct Table
+    {
+        int taps = 0;                      // Even; the kernel reaches taps / 2 input samples either side
+        double maxSpeed = 1.0;             // The fastest read it is cut for
+        std::vector<float> coefficients;   // numPhases rows of taps
+        std::vector<float> deltas;         // Each row's difference to the next, for the interpolation
+    };
+
+    using TablePtr = std::shared_ptr<const Table>;
+
+    //==============================================================================
+    /**
+     * Where each output sample reads the input: t(0) = 0, t(n + 1) = t(n) + speed(n),
+     * in input samples relative to the start of what is resampled. Speeds are
+     * positive. Positions are integrated from anchors every anchorInterval
+     * outputs, so any range of outputs maps on its own and always to the same
+     * positions, however the outputs are split into chunks.
+     */
+    class TimeMap
+    {
+    public:
+        /** Input samples advanced per output sample, for output n; called from several threads */
+        using SpeedCurve = std::function<double (juce::int64 outputSample)>;
+
+        TimeMap() = default;
+
+        /** Output n reads input n * speed */
+        static TimeMap constantSpeed (double speed, juce::int64 numOutputs);
+
+        /** Integrates the curve once, on all cores, to place the anchors */
+        static TimeMap fromSpeedCurve (SpeedCurve curve, juce::int64 numOutputs);
+
+        juce::int64 getNumOutputs() const { return numOutputs; }
+
+        /** The fastest the map reads the input */
+        double getMaxSpeed() const { return maxSpeed; }
+
+        /** positions[i] = t (firstOutput + i) */
+        void getPositions (juce::int64 firstOutput, int count, double* positions) const;
+
+    private:
+        static constexpr int anchorInterval = 4096;
+
+        SpeedCurve curve;                  // Empty for a constant speed
+        double speed = 1.0;
+        double maxSpeed = 1.0;
+        juce::int64 numOutputs = 0;
+        std::vector<double> anchors;       // t (k * anchorInterval)
+    };
+
+    //==============================================================================
+    /** A resampler for maps that read at most maxSpeed input samples per output */
+    explicit VariableRateResampler (double maxSpeed = 1.0);
+
+    /** Input samples the kernel reads either side of a position, for a speed bound */
+    static int getKernelRadius (double maxSpeed);
+
+    int getKernelRadius() const { return table->taps / 2; }
+
+    /**
+     * Writes outputs [firstOutput, firstOutput + numOutputs) of the map into
+     * output[outputOffset, ...) for every channel both buffers have. Position 0
+     * of the map is source sample origin; samples outside readable read as
+     * silence. Thread-safe.
+     */
+    void render (const juce::AudioBuffer<float>& source, juce::Range<int> readable, int origin,
+                 const TimeMap& map, juce::int64 firstOutput, int numOutputs,
+                 juce::AudioBuffer<float>& output, int outputOffset = 0) const;
+
+    //==============================================================================
+    /** Shared table for a speed bound; thread-safe, allocates on first use */
+    static TablePtr getTable (double maxSpeed);
+
+private:
+   #if JUCE_USE_SIMD
+    using Vector = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = static_cast<int> (Vector::SIMDNumElements);
+    static Vector broadcast (float value) { return Vector::expand (value); }
+   #else
+    using Vector = float;
+    static constexpr int lanes = 1;
+    static Vector broadcast (float value) { return value; }
+   #endif
+
+    static constexpr int blockSize = 16384;    // Outputs mapped and windowed at a time
+
+    TablePtr table;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VariableRateResampler)
+};
@@ -0,0 +1,118 @@
+#include "VisualizationTap.h"
+#include <cmath>
+
+VisualizationTap::VisualizationTap()
+{
+    spectrum.setDecimation (4);
+}
+
+VisualizationTap::~VisualizationTap()
+{
+    spectrum.stop();
+}
+
+void VisualizationTap::prepare (double sampleRate)
+{
+    spectrum.prepare (sampleRate);
+
+    ring.reset();
+    pending = {};
+    pendingSamples = 0;
+    dropped.store (0);
+}
+
+void VisualizationTap::setSpectrumEnabled (bool enabled)
+{
+    if (enabled)
+        spectrum.start();
+    else
+        spectrum.stop();
+}
+
+void VisualizationTap::push (const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    spectrum.push (block);
+
+    const int numSamples = static_cast<int> (block.getNumSamples());
+    const int numChannels = juce::jmin (maxChannels, static_cast<int> (block.getNumChannels()));
+
+    if (numChannels == 0)
+        return;
+
+    for (int offset = 0; offset < numSamples;)
+    {
+        const int count = juce::jmin (summaryLength - pendingSamples, numSamples - offset);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const float* data = block.getChannelPointer (static_cast<size_t> (channel)) + offset;
+            const auto range = juce::FloatVectorOperations::findMinAndMax (data, count);
+            float sumSquares = 0.0f;
+
+            for (int i = 0; i < count; ++i)
+                sumSquares += data[i] * data[i];
+
+            auto& peak = pending.peak[static_cast<size_t> (channel)];
+            peak = juce::jmax (peak, -range.getStart(), range.getEnd());
+            pending.sumSquares[static_cast<size_t> (channel)] += sumSquares;
+        }
+
+        pendingSamples += count;
+        offset += count;
+
+        if (pendingSamples < summaryLength)
+            continue;
+
+        if (numChannels == 1)
+        {
+            pending.peak[1] = pending.peak[0];
+            pending.sumSquares[1] = pending.sumSquares[0];
+        }
+
+        // One summary at a time: the reader sees it only once it is complete
+        const auto scope = ring.write (1);
+
+        if (scope.blockSize1 > 0)
+            summaries[static_cast<size_t> (scope.startIndex1)] = pending;
+        else if (scope.blockSize2 > 0)
+            summaries[static_cast<size_t> (scope.startIndex2)] = pending;
+        else
+            dropped.fetch_add (1, std::memory_order_relaxed);
+
+        pending = {};
+        pendingSamples = 0;
+    }
+}
+
+VisualizationTap::Levels VisualizationTap::readLevels()
+{
+    Levels levels;
+    std::array<double, maxChannels> sumSquares {};
+
+    const auto scope = ring.read (ring.getNumReady());
+
+    const auto combine = [&] (int start, int count)
+    {
+        for (int index = start; index < start + count; ++index)
+        {
+            const auto& summary = summaries[static_cast<size_t> (index)];
+
+            for (size_t channel = 0; channel < static_cast<size_t> (maxChannels); ++channel)
+            {
+                levels.peak[channel] = juce::jmax (levels.peak[channel], summary.peak[channel]);
+                sumSquares[channel] += summary.sumSquares[channel];
+            }
+        }
+
+        levels.numSummaries += count;
+    };
+
+    combine (scope.startIndex1, scope.blockSize1);
+    combine (scope.startIndex2, scope.blockSize2);
+
+    if (levels.numSummaries > 0)
+        for (size_t channel = 0; channel < static_cast<size_t> (maxChannels); ++channel)
+            levels.rms[channel] = static_cast<float> (std::sqrt (sumSquares[channel] / (static_cast<double> (levels.numSummaries) * summaryLength)));
+
+    return levels;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "BandActivityMeter.h"
+#include <array>
+#include <atomic>
+
+/**
+ * Visualization Tap
+ *
+ * Carries what the meters and the spectrum analyzer show from the audio
+ * thread to the GUI, without a shared buffer the GUI could read half-written.
+ *
+ * push() reduces the output to a peak and a sum of squares per channel for
+ * every summaryLength samples and writes those summaries into a wait-free
+ * single-producer, single-consumer ring (juce::AbstractFifo); it never
+ * allocates or blocks, and drops summaries if the reader falls behind. The
+ * reader combines whatever arrived since its last call, so a peak between
+ * two display frames is never missed.
+ *
+ * The spectrum goes through a BandActivityMeter: decimated mono frames, and
+ * the FFTs on its own low-priority thread at display rate, only while a view
+ * has enabled it.
+ */
+class VisualizationTap
+{
+public:
+    static constexpr int maxChannels = 2;
+    static constexpr int summaryLength = 256;      // Samples per summary, ~6 ms at 44.1 kHz
+
+    struct Levels
+    {
+        std::array<float, maxChannels> peak {};
+        std::array<float, maxChannels> rms {};
+        int numSummaries = 0;                      // Summaries combined; 0 if no audio arrived
+    };
+
+    VisualizationTap();
+    ~VisualizationTap();
+
+    /** Before the audio thread starts */
+    void prepare (double sampleRate);
+
+    /** Message thread: runs the spectrum analysis while a view shows it */
+    void setSpectrumEnabled (bool enabled);
+
+    /** Audio thread: real-time safe. Mono blocks count for both channels. */
+    void push (const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    /** The reader (one thread): levels of everything pushed since the previous call */
+    Levels readLevels();
+
+    /** Smoothed level of an EQ band (0.0 to 1.0), while the spectrum is enabled */
+    float getSpectrumBand (int band) const { return spectrum.getLevel (band); }
+
+    /** Summaries dropped because the reader was not keeping up */
+    int getNumDropped() const { return dropped.load(); }
+
+private:
+    struct Summary
+    {
+        std::array<float, maxChannels> peak {};
+        std::array<float, maxChannels> sumSquares {};
+    };
+
+    static constexpr int ringSize = 512;           // ~3 s at 44.1 kHz, for a stalled message thread
+
+    juce::AbstractFifo ring { ringSize };
+    std::array<Summary, ringSize> summaries;
+    std::atomic<int> dropped { 0 };
+
+    // Audio thread only
+    Summary pending;
+    int pendingSamples = 0;
+
+    BandActivityMeter spectrum;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VisualizationTap)
+};
@@ -1,5 +1,16 @@
 #include "GPUBackend.h"
 #include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+
+#if defined(GPU_BACKEND_CUDA)
+    #include <cuda.h>
+    #include <nvrtc.h>
+#elif defined(GPU_BACKEND_HIP)
+    #include <hip/hiprtc.h>
+#endif
 
 namespace GPUBackend
 {
@@ -7,22 +18,76 @@ namespace GPUBackend
     // Global state
     static bool g_initialized = false;
     static std::string g_lastError;
-    static DeviceInfo g_deviceInfo;
-
-    #if defined(GPU_BACKEND_OPENCL)
-        static cl_context g_clContext = nullptr;
-        static cl_command_queue g_clQueue = nullptr;
-        static cl_device_id g_clDevice = nullptr;
-    #elif defined(GPU_BACKEND_CUDA)
-        static int g_cudaDevice = 0;
-    #elif defined(GPU_BACKEND_HIP)
-        static int g_hipDevice = 0;
-    #elif defined(GPU_BACKEND_VULKAN)
+
+    #if defined(GPU_BACKEND_VULKAN)
         static VkInstance g_vkInstance = VK_NULL_HANDLE;
         static VkDevice g_vkDevice = VK_NULL_HANDLE;
         static VkPhysicalDevice g_vkPhysicalDevice = VK_NULL_HANDLE;
     #endif
 
+    // Device memory pool: free allocations by size class, and the counters
+    struct MemoryPool
+    {
+        std::mutex lock;
+        std::map<size_t, std::vector<void*>> freeBuffers;
+        size_t explicitBudget = 0;
+        MemoryPoolStats stats;
+    };
+
+    // Everything that belongs to one device; each thread works on its current one
+    struct DeviceContext
+    {
+        int index = -1;
+        DeviceInfo info {};
+        MemoryPool pool;
+
+        #if defined(GPU_BACKEND_OPENCL)
+            cl_context clContext = nullptr;
+            cl_command_queue clQueue = nullptr;
+            cl_device_id clDevice = nullptr;
+        #elif defined(GPU_BACKEND_CUDA) || defined(GPU_BACKEND_HIP)
+            int ordinal = 0;
+        #endif
+    };
+
+    static std::vector<std::unique_ptr<DeviceContext>> g_devices;
+    static DeviceContext g_noDevice; // Stands in before initialize() and for a bad index
+    static thread_local int t_currentDevice = 0;
+
+    static DeviceContext& getContext(int deviceIndex)
+    {
+        if (deviceIndex < 0 || deviceIndex >= static_cast<int>(g_devices.size()))
+            return g_noDevice;
+
+        return *g_devices[static_cast<size_t>(deviceIndex)];
+    }
+
+    static DeviceContext& currentContext()
+    {
+        return getContext(t_currentDevice);
+    }
+
+    /** Makes a device current on this thread until the end of the scope */
+    struct ScopedDevice
+    {
+        explicit ScopedDevice(int deviceIndex) : previous(t_currentDevice) { setCurrentDevice(deviceIndex); }
+        ~ScopedDevice() { setCurrentDevice(previous); }
+
+        const int previous;
+    };
+
+    static void trimMemoryPoolLocked(DeviceContext& context);
+
+    // Compiled kernel cache; the default folder is resolved on first use
+    struct KernelCache
+    {
+        std::mutex lock;
+        bool directoryChosen = false;
+        juce::File directory;
+    };
+
+    static KernelCache g_kernelCache;
+
     //==============================================================================
     bool initialize()
     {
@@ -32,119 +97,169 @@ namespace GPUBackend
         juce::Logger::writeToLog("GPU Backend: Initializing...");
 
         #if defined(GPU_BACKEND_OPENCL)
-            // OpenCL initialization
-            cl_int err;
-            cl_platform_id platform;
-            cl_uint numPlatforms;
-
-            err = clGetPlatformIDs(1, &platform, &numPlatforms);
-            if (err != CL_SUCCESS || numPlatforms == 0)
+            // OpenCL initialization: every GPU on every platform gets its own context and queue
+            cl_uint numPlatforms = 0;
+            if (clGetPlatformIDs(0, nullptr, &numPlatforms) != CL_SUCCESS || numPlatforms == 0)
             {
                 g_lastError = "No OpenCL platforms found";
                 juce::Logger::writeToLog("GPU Backend: " + g_lastError);
                 return false;
             }
 
-            err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &g_clDevice, nullptr);
-            if (err != CL_SUCCESS)
+            std::vector<cl_platform_id> platforms(numPlatforms);
+            clGetPlatformIDs(numPlatforms, platforms.data(), nullptr);
+
+            for (cl_platform_id platform : platforms)
+            {
+                cl_uint numDevices = 0;
+                if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 0, nullptr, &numDevices) != CL_SUCCESS || numDevices == 0)
+                    continue;
+
+                std::vector<cl_device_id> devices(numDevices);
+                clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, numDevices, devices.data(), nullptr);
+
+                for (cl_device_id device : devices)
+                {
+                    auto context = std::make_unique<DeviceContext>();
+                    context->clDevice = device;
+
+                    cl_int err;
+                    context->clContext = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
+                    if (err != CL_SUCCESS)
+                        continue;
+
+                    #if defined(CL_VERSION_2_0)
+                        context->clQueue = clCreateCommandQueueWithProperties(context->clContext, device, nullptr, &err);
+                    #else
+                        context->clQueue = clCreateCommandQueue(context->clContext, device, 0, &err);
+                    #endif
+
+                    if (err != CL_SUCCESS)
+                    {
+                        clReleaseContext(context->clContext);
+                        continue;
+                    }
+
+                    // Get device info
+                    char deviceName[256];
+                    char vendor[256];
+                    char driverVersion[256];
+                    cl_ulong globalMem;
+                    cl_uint computeUnits;
+                    size_t maxWorkGroupSize;
+
+                    clGetDeviceInfo(device, CL_DEVICE_NAME, sizeof(deviceName), deviceName, nullptr);
+                    clGetDeviceInfo(device, CL_DEVICE_VENDOR, sizeof(vendor), vendor, nullptr);
+                    clGetDeviceInfo(device, CL_DRIVER_VERSION, sizeof(driverVersion), driverVersion, nullptr);
+                    clGetDeviceInfo(device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &globalMem, nullptr);
+                    clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnits, nullptr);
+                    clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &maxWorkGroupSize, nullptr);
+
+                    auto& info = context->info;
+                    info.name = deviceName;
+                    info.vendor = vendor;
+                    info.totalMemory = globalMem;
+                    info.availableMemory = globalMem; // Simplified
+                    info.computeUnits = static_cast<int>(computeUnits);
+                    info.maxWorkGroupSize = static_cast<int>(maxWorkGroupSize);
+                    info.backendName = "OpenCL";
+                    info.driverVersion = driverVersion;
+
+                    context->index = static_cast<int>(g_devices.size());
+                    g_devices.push_back(std::move(context));
+                }
+            }
+
+            if (g_devices.empty())
             {
                 g_lastError = "No OpenCL GPU devices found";
                 juce::Logger::writeToLog("GPU Backend: " + g_lastError);
                 return false;
             }
 
-            g_clContext = clCreateContext(nullptr, 1, &g_clDevice, nullptr, nullptr, &err);
-            if (err != CL_SUCCESS)
+        #elif defined(GPU_BACKEND_CUDA)
+            // CUDA initialization
+            int numDevices = 0;
+            if (cudaGetDeviceCount(&numDevices) != cudaSuccess || numDevices == 0)
             {
-                g_lastError = "Failed to create OpenCL context";
+                g_lastError = "CUDA device not found";
                 return false;
             }
 
-            #if defined(CL_VERSION_2_0)
-                g_clQueue = clCreateCommandQueueWithProperties(g_clContext, g_clDevice, nullptr, &err);
-            #else
-                g_clQueue = clCreateCommandQueue(g_clContext, g_clDevice, 0, &err);
-            #endif
+            int cudaDriverVersion = 0;
+            cudaDriverGetVersion(&cudaDriverVersion);
 
-            if (err != CL_SUCCESS)
+            for (int ordinal = 0; ordinal < numDevices; ++ordinal)
             {
-                g_lastError = "Failed to create OpenCL command queue";
-                clReleaseContext(g_clContext);
-                return false;
+                cudaDeviceProp prop;
+                if (cudaGetDeviceProperties(&prop, ordinal) != cudaSuccess)
+                    continue;
+
+                auto context = std::make_unique<DeviceContext>();
+                context->ordinal = ordinal;
+
+                auto& info = context->info;
+                info.name = prop.name;
+                info.vendor = "NVIDIA";
+                info.totalMemory = prop.totalGlobalMem;
+                info.availableMemory = prop.totalGlobalMem;
+                info.computeUnits = prop.multiProcessorCount;
+                info.maxWorkGroupSize = prop.maxThreadsPerBlock;
+                info.backendName = "CUDA";
+                info.architecture = "compute_" + std::to_string(prop.major) + std::to_string(prop.minor);
+                info.driverVersion = std::to_string(cudaDriverVersion);
+
+                context->index = static_cast<int>(g_devices.size());
+                g_devices.push_back(std::move(context));
             }
 
-            // Get device info
-            char deviceName[256];
-            char vendor[256];
-            cl_ulong globalMem;
-            cl_uint computeUnits;
-            size_t maxWorkGroupSize;
-
-            clGetDeviceInfo(g_clDevice, CL_DEVICE_NAME, sizeof(deviceName), deviceName, nullptr);
-            clGetDeviceInfo(g_clDevice, CL_DEVICE_VENDOR, sizeof(vendor), vendor, nullptr);
-            clGetDeviceInfo(g_clDevice, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &globalMem, nullptr);
-            clGetDeviceInfo(g_clDevice, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnits, nullptr);
-            clGetDeviceInfo(g_clDevice, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &maxWorkGroupSize, nullptr);
-
-            g_deviceInfo.name = deviceName;
-            g_deviceInfo.vendor = vendor;
-            g_deviceInfo.totalMemory = globalMem;
-            g_deviceInfo.availableMemory = globalMem; // Simplified
-            g_deviceInfo.computeUnits = computeUnits;
-            g_deviceInfo.maxWorkGroupSize = static_cast<int>(maxWorkGroupSize);
-            g_deviceInfo.backendName = "OpenCL";
-
-            g_initialized = true;
-            juce::Logger::writeToLog("GPU Backend: OpenCL initialized (" + g_deviceInfo.name + ")");
-            return true;
-
-        #elif defined(GPU_BACKEND_CUDA)
-            // CUDA initialization
-            cudaError_t err = cudaSetDevice(0);
-            if (err != cudaSuccess)
+            if (g_devices.empty())
             {
                 g_lastError = "CUDA device not found";
                 return false;
             }
 
-            cudaDeviceProp prop;
-            cudaGetDeviceProperties(&prop, 0);
-
-            g_deviceInfo.name = prop.name;
-            g_deviceInfo.vendor = "NVIDIA";
-            g_deviceInfo.totalMemory = prop.totalGlobalMem;
-            g_deviceInfo.availableMemory = prop.totalGlobalMem;
-            g_deviceInfo.computeUnits = prop.multiProcessorCount;
-            g_deviceInfo.maxWorkGroupSize = prop.maxThreadsPerBlock;
-            g_deviceInfo.backendName = "CUDA";
-
-            g_initialized = true;
-            juce::Logger::writeToLog("GPU Backend: CUDA initialized (" + g_deviceInfo.name + ")");
-            return true;
-
         #elif defined(GPU_BACKEND_HIP)
             // HIP initialization
-            hipError_t err = hipSetDevice(0);
-            if (err != hipSuccess)
+            int numDevices = 0;
+            if (hipGetDeviceCount(&numDevices) != hipSuccess || numDevices == 0)
             {
                 g_lastError = "HIP device not found";
                 return false;
             }
 
-            hipDeviceProp_t prop;
-            hipGetDeviceProperties(&prop, 0);
+            int hipDriverVersion = 0;
+            hipDriverGetVersion(&hipDriverVersion);
 
-            g_deviceInfo.name = prop.name;
-            g_deviceInfo.vendor = "AMD";
-            g_deviceInfo.totalMemory = prop.totalGlobalMem;
-            g_deviceInfo.availableMemory = prop.totalGlobalMem;
-            g_deviceInfo.computeUnits = prop.multiProcessorCount;
-            g_deviceInfo.maxWorkGroupSize = prop.maxThreadsPerBlock;
-            g_deviceInfo.backendName = "ROCm/HIP";
+            for (int ordinal = 0; ordinal < numDevices; ++ordinal)
+            {
+                hipDeviceProp_t prop;
+                if (hipGetDeviceProperties(&prop, ordinal) != hipSuccess)
+                    continue;
+
+                auto context = std::make_unique<DeviceContext>();
+                context->ordinal = ordinal;
+
+                auto& info = context->info;
+                info.name = prop.name;
+                info.vendor = "AMD";
+                info.totalMemory = prop.totalGlobalMem;
+                info.availableMemory = prop.totalGlobalMem;
+                info.computeUnits = prop.multiProcessorCount;
+                info.maxWorkGroupSize = prop.maxThreadsPerBlock;
+                info.backendName = "ROCm/HIP";
+                info.architecture = prop.gcnArchName;
+                info.driverVersion = std::to_string(hipDriverVersion);
+
+                context->index = static_cast<int>(g_devices.size());
+                g_devices.push_back(std::move(context));
+            }
 
-            g_initialized = true;
-            juce::Logger::writeToLog("GPU Backend: ROCm/HIP initialized (" + g_deviceInfo.name + ")");
-            return true;
+            if (g_devices.empty())
+            {
+                g_lastError = "HIP device not found";
+                return false;
+            }
 
         #elif defined(GPU_BACKEND_VULKAN)
             // Vulkan initialization
@@ -162,6 +277,17 @@ namespace GPUBackend
             g_lastError = "No GPU backend compiled";
             return false;
         #endif
+
+        #if defined(GPU_BACKEND_OPENCL) || defined(GPU_BACKEND_CUDA) || defined(GPU_BACKEND_HIP)
+            g_initialized = true;
+            setCurrentDevice(0);
+
+            for (const auto& context : g_devices)
+                juce::Logger::writeToLog("GPU Backend: " + context->info.backendName + " device "
+                                         + juce::String(context->index) + " initialized (" + context->info.name + ")");
+
+            return true;
+        #endif
     }
 
     void shutdown()
@@ -169,19 +295,28 @@ namespace GPUBackend
         if (!g_initialized)
             return;
 
-        #if defined(GPU_BACKEND_OPENCL)
-            if (g_clQueue) clReleaseCommandQueue(g_clQueue);
-            if (g_clContext) clReleaseContext(g_clContext);
-            g_clQueue = nullptr;
-            g_clContext = nullptr;
-            g_clDevice = nullptr;
-        #elif defined(GPU_BACKEND_CUDA)
-            cudaDeviceReset();
-        #elif defined(GPU_BACKEND_HIP)
-            hipDeviceReset();
-        #endif
+        for (const auto& context : g_devices)
+        {
+            ScopedDevice scope(context->index);
+
+            {
+                std::lock_guard<std::mutex> lock(context->pool.lock);
+                trimMemoryPoolLocked(*context);
+            }
+
+            #if defined(GPU_BACKEND_OPENCL)
+                if (context->clQueue) clReleaseCommandQueue(context->clQueue);
+                if (context->clContext) clReleaseContext(context->clContext);
+            #elif defined(GPU_BACKEND_CUDA)
+                cudaDeviceReset();
+            #elif defined(GPU_BACKEND_HIP)
+                hipDeviceReset();
+            #endif
+        }
 
+        g_devices.clear();
         g_initialized = false;
+        t_currentDevice = 0;
         juce::Logger::writeToLog("GPU Backend: Shutdown");
     }
 
@@ -192,7 +327,38 @@ namespace GPUBackend
 
     DeviceInfo getDeviceInfo()
     {
-        return g_deviceInfo;
+        return currentContext().info;
+    }
+
+    int getNumDevices()
+    {
+        return static_cast<int>(g_devices.size());
+    }
+
+    DeviceInfo getDeviceInfo(int deviceIndex)
+    {
+        return getContext(deviceIndex).info;
+    }
+
+    bool setCurrentDevice(int deviceIndex)
+    {
+        if (deviceIndex < 0 || deviceIndex >= static_cast<int>(g_devices.size()))
+            return false;
+
+        t_currentDevice = deviceIndex;
+
+        #if defined(GPU_BACKEND_CUDA)
+            return (cudaSetDevice(getContext(deviceIndex).ordinal) == cudaSuccess);
+        #elif defined(GPU_BACKEND_HIP)
+            return (hipSetDevice(getContext(deviceIndex).ordinal) == hipSuccess);
+        #else
+            return true;
+        #endif
+    }
+
+    int getCurrentDevice()
+    {
+        return t_currentDevice;
     }
 
     std::string getBackendName()
@@ -215,18 +381,395 @@ namespace GPUBackend
     void synchronize()
     {
         #if defined(GPU_BACKEND_OPENCL)
-            if (g_clQueue)
-                clFinish(g_clQueue);
+            if (currentContext().clQueue)
+                clFinish(currentContext().clQueue);
+        #elif defined(GPU_BACKEND_CUDA)
+            cudaDeviceSynchronize();
+        #elif defined(GPU_BACKEND_HIP)
+            hipDeviceSynchronize();
+        #endif
+    }
+
+    std::string getLastError()
+    {
+        return g_lastError;
+    }
+
+    //==============================================================================
+    // Device memory pool implementation
+    //==============================================================================
+    static void* allocateDeviceMemory(DeviceContext& context, size_t sizeInBytes)
+    {
+        juce::ignoreUnused(context);
+
+        #if defined(GPU_BACKEND_OPENCL)
+            cl_int err;
+            cl_mem buffer = clCreateBuffer(context.clContext, CL_MEM_READ_WRITE, sizeInBytes, nullptr, &err);
+            return (err == CL_SUCCESS) ? buffer : nullptr;
+        #elif defined(GPU_BACKEND_CUDA)
+            void* buffer = nullptr;
+            return (cudaMalloc(&buffer, sizeInBytes) == cudaSuccess) ? buffer : nullptr;
+        #elif defined(GPU_BACKEND_HIP)
+            void* buffer = nullptr;
+            return (hipMalloc(&buffer, sizeInBytes) == hipSuccess) ? buffer : nullptr;
+        #else
+            juce::ignoreUnused(sizeInBytes);
+            return nullptr;
+        #endif
+    }
+
+    static void freeDeviceMemory(void* buffer)
+    {
+        #if defined(GPU_BACKEND_OPENCL)
+            clReleaseMemObject(static_cast<cl_mem>(buffer));
+        #elif defined(GPU_BACKEND_CUDA)
+            cudaFree(buffer);
+        #elif defined(GPU_BACKEND_HIP)
+            hipFree(buffer);
+        #else
+            juce::ignoreUnused(buffer);
+        #endif
+    }
+
+    /** Four classes per octave above 64 KB, so a pooled buffer wastes at most a fifth */
+    static size_t roundToSizeClass(size_t sizeInBytes)
+    {
+        constexpr size_t smallestClass = 64 * 1024;
+        if (sizeInBytes <= smallestClass)
+            return smallestClass;
+
+        size_t octave = smallestClass;
+        while (octave * 2 <= sizeInBytes)
+            octave *= 2;
+
+        const size_t step = octave / 4;
+        return (sizeInBytes + step - 1) / step * step;
+    }
+
+    static size_t getEffectiveBudgetLocked(const DeviceContext& context)
+    {
+        if (context.pool.explicitBudget > 0)
+            return context.pool.explicitBudget;
+
+        // Leave a quarter for the driver, the display and other applications
+        return context.info.totalMemory / 4 * 3;
+    }
+
+    /** Frees the cached buffers; the context's device must be current */
+    static void trimMemoryPoolLocked(DeviceContext& context)
+    {
+        auto& pool = context.pool;
+
+        for (auto& [sizeClass, buffers] : pool.freeBuffers)
+        {
+            for (void* buffer : buffers)
+                freeDeviceMemory(buffer);
+
+            pool.stats.bytesCached -= sizeClass * buffers.size();
+        }
+
+        pool.freeBuffers.clear();
+    }
+
+    /** Allocates on the context's device, which must be current */
+    static void* acquirePooledBuffer(DeviceContext& context, size_t sizeInBytes, size_t& capacity)
+    {
+        const size_t sizeClass = roundToSizeClass(sizeInBytes);
+
+        auto& pool = context.pool;
+        std::lock_guard<std::mutex> lock(pool.lock);
+        auto& stats = pool.stats;
+        void* buffer = nullptr;
+
+        auto cached = pool.freeBuffers.find(sizeClass);
+        if (cached != pool.freeBuffers.end() && !cached->second.empty())
+        {
+            buffer = cached->second.back();
+            cached->second.pop_back();
+            stats.bytesCached -= sizeClass;
+            ++stats.reusedAllocations;
+        }
+        else
+        {
+            const size_t budget = getEffectiveBudgetLocked(context);
+
+            // Cached buffers of other classes are given back before the budget says no
+            if (budget > 0 && stats.bytesInUse + stats.bytesCached + sizeClass > budget)
+                trimMemoryPoolLocked(context);
+
+            if (budget > 0 && stats.bytesInUse + sizeClass > budget)
+            {
+                g_lastError = "GPU memory budget exceeded";
+                return nullptr;
+            }
+
+            buffer = allocateDeviceMemory(context, sizeClass);
+
+            // The driver may be out of room only because of what the pool holds
+            if (!buffer && stats.bytesCached > 0)
+            {
+                trimMemoryPoolLocked(context);
+                buffer = allocateDeviceMemory(context, sizeClass);
+            }
+
+            if (!buffer)
+            {
+                g_lastError = "GPU memory allocation failed";
+                return nullptr;
+            }
+
+            ++stats.deviceAllocations;
+        }
+
+        stats.bytesInUse += sizeClass;
+        stats.highWaterMark = std::max(stats.highWaterMark, stats.bytesInUse);
+        capacity = sizeClass;
+        return buffer;
+    }
+
+    static void recyclePooledBuffer(DeviceContext& context, void* buffer, size_t capacity)
+    {
+        auto& pool = context.pool;
+        std::lock_guard<std::mutex> lock(pool.lock);
+
+        pool.freeBuffers[capacity].push_back(buffer);
+        pool.stats.bytesInUse -= capacity;
+        pool.stats.bytesCached += capacity;
+    }
+
+    void setMemoryBudget(size_t bytes)
+    {
+        auto& pool = currentContext().pool;
+        std::lock_guard<std::mutex> lock(pool.lock);
+        pool.explicitBudget = bytes;
+    }
+
+    size_t getMemoryBudget()
+    {
+        auto& context = currentContext();
+        std::lock_guard<std::mutex> lock(context.pool.lock);
+        return getEffectiveBudgetLocked(context);
+    }
+
+    size_t getAvailableMemoryBudget()
+    {
+        auto& context = currentContext();
+        std::lock_guard<std::mutex> lock(context.pool.lock);
+        const size_t budget = getEffectiveBudgetLocked(context);
+
+        if (budget == 0)
+            return static_cast<size_t>(-1);
+
+        return budget > context.pool.stats.bytesInUse ? budget - context.pool.stats.bytesInUse : 0;
+    }
+
+    MemoryPoolStats getMemoryPoolStats()
+    {
+        auto& context = currentContext();
+        std::lock_guard<std::mutex> lock(context.pool.lock);
+        auto stats = context.pool.stats;
+        stats.budget = getEffectiveBudgetLocked(context);
+        return stats;
+    }
+
+    void trimMemoryPool()
+    {
+        auto& context = currentContext();
+        std::lock_guard<std::mutex> lock(context.pool.lock);
+        trimMemoryPoolLocked(context);
+    }
+
+    //==============================================================================
+    // GPUStream implementation
+    //==============================================================================
+    GPUStream::~GPUStream()
+    {
+        release();
+    }
+
+    bool GPUStream::create()
+    {
+        release();
+
+        #if defined(GPU_BACKEND_OPENCL)
+            // In-order queue: its work is ordered, but runs concurrently with other queues
+            cl_int err;
+            #if defined(CL_VERSION_2_0)
+                cl_command_queue queue = clCreateCommandQueueWithProperties(currentContext().clContext,
+                                                                            currentContext().clDevice, nullptr, &err);
+            #else
+                cl_command_queue queue = clCreateCommandQueue(currentContext().clContext, currentContext().clDevice, 0, &err);
+            #endif
+
+            if (err != CL_SUCCESS)
+            {
+                g_lastError = "Failed to create OpenCL command queue";
+                return false;
+            }
+
+            nativeStream = queue;
+            return true;
+        #elif defined(GPU_BACKEND_CUDA)
+            cudaStream_t cudaStream;
+            if (cudaStreamCreateWithFlags(&cudaStream, cudaStreamNonBlocking) != cudaSuccess)
+            {
+                g_lastError = "Failed to create CUDA stream";
+                return false;
+            }
+
+            nativeStream = cudaStream;
+            return true;
+        #elif defined(GPU_BACKEND_HIP)
+            hipStream_t hipStream;
+            if (hipStreamCreateWithFlags(&hipStream, hipStreamNonBlocking) != hipSuccess)
+            {
+                g_lastError = "Failed to create HIP stream";
+                return false;
+            }
+
+            nativeStream = hipStream;
+            return true;
+        #else
+            return false;
+        #endif
+    }
+
+    bool GPUStream::synchronize()
+    {
+        if (!nativeStream)
+            return false;
+
+        #if defined(GPU_BACKEND_OPENCL)
+            return (clFinish(static_cast<cl_command_queue>(nativeStream)) == CL_SUCCESS);
+        #elif defined(GPU_BACKEND_CUDA)
+            return (cudaStreamSynchronize(static_cast<cudaStream_t>(nativeStream)) == cudaSuccess);
+        #elif defined(GPU_BACKEND_HIP)
+            return (hipStreamSynchronize(static_cast<hipStream_t>(nativeStream)) == hipSuccess);
+        #else
+            return false;
+        #endif
+    }
+
+    void GPUStream::release()
+    {
+        if (nativeStream)
+        {
+            #if defined(GPU_BACKEND_OPENCL)
+                clReleaseCommandQueue(static_cast<cl_command_queue>(nativeStream));
+            #elif defined(GPU_BACKEND_CUDA)
+                cudaStreamDestroy(static_cast<cudaStream_t>(nativeStream));
+            #elif defined(GPU_BACKEND_HIP)
+                hipStreamDestroy(static_cast<hipStream_t>(nativeStream));
+            #endif
+
+            nativeStream = nullptr;
+        }
+    }
+
+    //==============================================================================
+    // GPUEvent implementation
+    //==============================================================================
+    GPUEvent::~GPUEvent()
+    {
+        release();
+    }
+
+    bool GPUEvent::record(GPUStream& stream)
+    {
+        if (!stream.getNativeHandle())
+            return false;
+
+        #if defined(GPU_BACKEND_OPENCL)
+            // OpenCL events are single-use: each marker replaces the previous one
+            release();
+
+            cl_event event = nullptr;
+            if (clEnqueueMarkerWithWaitList(static_cast<cl_command_queue>(stream.getNativeHandle()),
+                                            0, nullptr, &event) != CL_SUCCESS)
+                return false;
+
+            nativeEvent = event;
+            return true;
+        #elif defined(GPU_BACKEND_CUDA)
+            if (!nativeEvent)
+            {
+                cudaEvent_t event;
+                if (cudaEventCreateWithFlags(&event, cudaEventDisableTiming) != cudaSuccess)
+                    return false;
+
+                nativeEvent = event;
+            }
+
+            return (cudaEventRecord(static_cast<cudaEvent_t>(nativeEvent),
+                                    static_cast<cudaStream_t>(stream.getNativeHandle())) == cudaSuccess);
+        #elif defined(GPU_BACKEND_HIP)
+            if (!nativeEvent)
+            {
+                hipEvent_t event;
+                if (hipEventCreateWithFlags(&event, hipEventDisableTiming) != hipSuccess)
+                    return false;
+
+                nativeEvent = event;
+            }
+
+            return (hipEventRecord(static_cast<hipEvent_t>(nativeEvent),
+                                   static_cast<hipStream_t>(stream.getNativeHandle())) == hipSuccess);
+        #else
+            return false;
+        #endif
+    }
+
+    bool GPUEvent::makeStreamWait(GPUStream& stream)
+    {
+        if (!nativeEvent || !stream.getNativeHandle())
+            return false;
+
+        #if defined(GPU_BACKEND_OPENCL)
+            cl_event event = static_cast<cl_event>(nativeEvent);
+            return (clEnqueueBarrierWithWaitList(static_cast<cl_command_queue>(stream.getNativeHandle()),
+                                                 1, &event, nullptr) == CL_SUCCESS);
+        #elif defined(GPU_BACKEND_CUDA)
+            return (cudaStreamWaitEvent(static_cast<cudaStream_t>(stream.getNativeHandle()),
+                                        static_cast<cudaEvent_t>(nativeEvent), 0) == cudaSuccess);
+        #elif defined(GPU_BACKEND_HIP)
+            return (hipStreamWaitEvent(static_cast<hipStream_t>(stream.getNativeHandle()),
+                                       static_cast<hipEvent_t>(nativeEvent), 0) == hipSuccess);
+        #else
+            return false;
+        #endif
+    }
+
+    bool GPUEvent::synchronize()
+    {
+        if (!nativeEvent)
+            return false;
+
+        #if defined(GPU_BACKEND_OPENCL)
+            cl_event event = static_cast<cl_event>(nativeEvent);
+            return (clWaitForEvents(1, &event) == CL_SUCCESS);
         #elif defined(GPU_BACKEND_CUDA)
-            cudaDeviceSynchronize();
+            return (cudaEventSynchronize(static_cast<cudaEvent_t>(nativeEvent)) == cudaSuccess);
         #elif defined(GPU_BACKEND_HIP)
-            hipDeviceSynchronize();
+            return (hipEventSynchronize(static_cast<hipEvent_t>(nativeEvent)) == hipSuccess);
+        #else
+            return false;
         #endif
     }
 
-    std::string getLastError()
+    void GPUEvent::release()
     {
-        return g_lastError;
+        if (nativeEvent)
+        {
+            #if defined(GPU_BACKEND_OPENCL)
+                clReleaseEvent(static_cast<cl_event>(nativeEvent));
+            #elif defined(GPU_BACKEND_CUDA)
+                cudaEventDestroy(static_cast<cudaEvent_t>(nativeEvent));
+            #elif defined(GPU_BACKEND_HIP)
+                hipEventDestroy(static_cast<hipEvent_t>(nativeEvent));
+            #endif
+
+            nativeEvent = nullptr;
+        }
     }
 
     //==============================================================================
@@ -241,19 +784,13 @@ namespace GPUBackend
     {
         release();
 
-        size = sizeInBytes;
-
-        #if defined(GPU_BACKEND_OPENCL)
-            cl_int err;
-            nativeBuffer = clCreateBuffer(g_clContext, CL_MEM_READ_WRITE, sizeInBytes, nullptr, &err);
-            return (err == CL_SUCCESS);
-        #elif defined(GPU_BACKEND_CUDA)
-            return (cudaMalloc(&nativeBuffer, sizeInBytes) == cudaSuccess);
-        #elif defined(GPU_BACKEND_HIP)
-            return (hipMalloc(&nativeBuffer, sizeInBytes) == hipSuccess);
-        #else
+        device = getCurrentDevice();
+        nativeBuffer = acquirePooledBuffer(getContext(device), sizeInBytes, capacity);
+        if (!nativeBuffer)
             return false;
-        #endif
+
+        size = sizeInBytes;
+        return true;
     }
 
     bool GPUBuffer::upload(const void* hostData, size_t sizeInBytes)
@@ -262,7 +799,7 @@ namespace GPUBackend
             return false;
 
         #if defined(GPU_BACKEND_OPENCL)
-            cl_int err = clEnqueueWriteBuffer(g_clQueue, static_cast<cl_mem>(nativeBuffer),
+            cl_int err = clEnqueueWriteBuffer(getContext(device).clQueue, static_cast<cl_mem>(nativeBuffer),
                                              CL_TRUE, 0, sizeInBytes, hostData, 0, nullptr, nullptr);
             return (err == CL_SUCCESS);
         #elif defined(GPU_BACKEND_CUDA)
@@ -280,7 +817,7 @@ namespace GPUBackend
             return false;
 
         #if defined(GPU_BACKEND_OPENCL)
-            cl_int err = clEnqueueReadBuffer(g_clQueue, static_cast<cl_mem>(nativeBuffer),
+            cl_int err = clEnqueueReadBuffer(getContext(device).clQueue, static_cast<cl_mem>(nativeBuffer),
                                             CL_TRUE, 0, sizeInBytes, hostData, 0, nullptr, nullptr);
             return (err == CL_SUCCESS);
         #elif defined(GPU_BACKEND_CUDA)
@@ -292,20 +829,144 @@ namespace GPUBackend
         #endif
     }
 
+    bool GPUBuffer::uploadAsync(const void* hostData, size_t sizeInBytes, GPUStream& stream)
+    {
+        if (!nativeBuffer || sizeInBytes > size || !stream.getNativeHandle())
+            return false;
+
+        #if defined(GPU_BACKEND_OPENCL)
+            cl_int err = clEnqueueWriteBuffer(static_cast<cl_command_queue>(stream.getNativeHandle()),
+                                              static_cast<cl_mem>(nativeBuffer),
+                                              CL_FALSE, 0, sizeInBytes, hostData, 0, nullptr, nullptr);
+            return (err == CL_SUCCESS);
+        #elif defined(GPU_BACKEND_CUDA)
+            return (cudaMemcpyAsync(nativeBuffer, hostData, sizeInBytes, cudaMemcpyHostToDevice,
+                                    static_cast<cudaStream_t>(stream.getNativeHandle())) == cudaSuccess);
+        #elif defined(GPU_BACKEND_HIP)
+            return (hipMemcpyAsync(nativeBuffer, hostData, sizeInBytes, hipMemcpyHostToDevice,
+                                   static_cast<hipStream_t>(stream.getNativeHandle())) == hipSuccess);
+        #else
+            return false;
+        #endif
+    }
+
+    bool GPUBuffer::downloadAsync(void* hostData, size_t sizeInBytes, GPUStream& stream)
+    {
+        if (!nativeBuffer || sizeInBytes > size || !stream.getNativeHandle())
+            return false;
+
+        #if defined(GPU_BACKEND_OPENCL)
+            cl_int err = clEnqueueReadBuffer(static_cast<cl_command_queue>(stream.getNativeHandle()),
+                                             static_cast<cl_mem>(nativeBuffer),
+                                             CL_FALSE, 0, sizeInBytes, hostData, 0, nullptr, nullptr);
+            return (err == CL_SUCCESS);
+        #elif defined(GPU_BACKEND_CUDA)
+            return (cudaMemcpyAsync(hostData, nativeBuffer, sizeInBytes, cudaMemcpyDeviceToHost,
+                                    static_cast<cudaStream_t>(stream.getNativeHandle())) == cudaSuccess);
+        #elif defined(GPU_BACKEND_HIP)
+            return (hipMemcpyAsync(hostData, nativeBuffer, sizeInBytes, hipMemcpyDeviceToHost,
+                                   static_cast<hipStream_t>(stream.getNativeHandle())) == hipSuccess);
+        #else
+            return false;
+        #endif
+    }
+
     void GPUBuffer::release()
     {
         if (nativeBuffer)
         {
-            #if defined(GPU_BACKEND_OPENCL)
-                clReleaseMemObject(static_cast<cl_mem>(nativeBuffer));
-            #elif defined(GPU_BACKEND_CUDA)
-                cudaFree(nativeBuffer);
-            #elif defined(GPU_BACKEND_HIP)
-                hipFree(nativeBuffer);
-            #endif
+            // Back to its device's pool; the memory is freed by trimMemoryPool() or shutdown()
+            recyclePooledBuffer(getContext(device), nativeBuffer, capacity);
+
+            nativeBuffer = nullptr;
+            size = 0;
+            capacity = 0;
+        }
+    }
+
+    //==============================================================================
+    // PinnedHostBuffer implementation
+    //==============================================================================
+    PinnedHostBuffer::~PinnedHostBuffer()
+    {
+        release();
+    }
 
+    bool PinnedHostBuffer::allocate(size_t sizeInBytes)
+    {
+        release();
+        device = getCurrentDevice();
+
+        #if defined(GPU_BACKEND_OPENCL)
+            // A host-allocated buffer object, mapped once for the lifetime of the allocation
+            auto& context = getContext(device);
+            if (context.clContext && context.clQueue)
+            {
+                cl_int err;
+                cl_mem buffer = clCreateBuffer(context.clContext, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                                               sizeInBytes, nullptr, &err);
+                if (err == CL_SUCCESS)
+                {
+                    void* mapped = clEnqueueMapBuffer(context.clQueue, buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE,
+                                                      0, sizeInBytes, 0, nullptr, nullptr, &err);
+                    if (err == CL_SUCCESS)
+                    {
+                        nativeBuffer = buffer;
+                        hostData = mapped;
+                        pinned = true;
+                    }
+                    else
+                    {
+                        clReleaseMemObject(buffer);
+                    }
+                }
+            }
+        #elif defined(GPU_BACKEND_CUDA)
+            if (cudaHostAlloc(&hostData, sizeInBytes, cudaHostAllocDefault) == cudaSuccess)
+                pinned = true;
+            else
+                hostData = nullptr;
+        #elif defined(GPU_BACKEND_HIP)
+            if (hipHostMalloc(&hostData, sizeInBytes, hipHostMallocDefault) == hipSuccess)
+                pinned = true;
+            else
+                hostData = nullptr;
+        #endif
+
+        // Pageable memory still works, the driver just stages each copy
+        if (!hostData)
+            hostData = std::malloc(sizeInBytes);
+
+        size = hostData ? sizeInBytes : 0;
+        return (hostData != nullptr);
+    }
+
+    void PinnedHostBuffer::release()
+    {
+        if (hostData)
+        {
+            if (!pinned)
+            {
+                std::free(hostData);
+            }
+            else
+            {
+                #if defined(GPU_BACKEND_OPENCL)
+                    cl_command_queue queue = getContext(device).clQueue;
+                    clEnqueueUnmapMemObject(queue, static_cast<cl_mem>(nativeBuffer), hostData, 0, nullptr, nullptr);
+                    clFinish(queue);
+                    clReleaseMemObject(static_cast<cl_mem>(nativeBuffer));
+                #elif defined(GPU_BACKEND_CUDA)
+                    cudaFreeHost(hostData);
+                #elif defined(GPU_BACKEND_HIP)
+                    hipHostFree(hostData);
+                #endif
+            }
+
+            hostData = nullptr;
             nativeBuffer = nullptr;
             size = 0;
+            pinned = false;
         }
     }
 
@@ -319,23 +980,45 @@ namespace GPUBackend
 
     bool GPUFFT::createPlan(int fftSizeParam, int batchSizeParam)
     {
+        release();
+
         fftSize = fftSizeParam;
         batchSize = batchSizeParam;
 
         #if defined(GPU_BACKEND_CUDA)
-            cufftResult result = cufftPlan1d(reinterpret_cast<cufftHandle*>(&fftPlan),
-                                            fftSize, CUFFT_R2C, batchSize);
-            return (result == CUFFT_SUCCESS);
+            // Real-to-complex and complex-to-real need a plan each
+            if (cufftPlan1d(reinterpret_cast<cufftHandle*>(&fftPlan), fftSize, CUFFT_R2C, batchSize) != CUFFT_SUCCESS)
+                return false;
+
+            if (cufftPlan1d(reinterpret_cast<cufftHandle*>(&inversePlan), fftSize, CUFFT_C2R, batchSize) != CUFFT_SUCCESS)
+            {
+                release();
+                return false;
+            }
+
+            return true;
         #elif defined(GPU_BACKEND_HIP)
-            rocfft_status status = rocfft_plan_create(reinterpret_cast<rocfft_plan*>(&fftPlan),
-                                                     rocfft_placement_notinplace,
-                                                     rocfft_transform_type_real_forward,
-                                                     rocfft_precision_single,
-                                                     1, // 1D FFT
-                                                     reinterpret_cast<size_t*>(&fftSize),
-                                                     batchSize,
-                                                     nullptr);
-            return (status == rocfft_status_success);
+            const size_t length = static_cast<size_t>(fftSize);
+            const auto createDirection = [&](void** plan, rocfft_transform_type type)
+            {
+                return rocfft_plan_create(reinterpret_cast<rocfft_plan*>(plan),
+                                          rocfft_placement_notinplace,
+                                          type,
+                                          rocfft_precision_single,
+                                          1, // 1D FFT
+                                          &length,
+                                          static_cast<size_t>(batchSize),
+                                          nullptr) == rocfft_status_success;
+            };
+
+            if (!createDirection(&fftPlan, rocfft_transform_type_real_forward)
+                || !createDirection(&inversePlan, rocfft_transform_type_real_inverse))
+            {
+                release();
+                return false;
+            }
+
+            return true;
         #elif defined(GPU_BACKEND_OPENCL)
             // OpenCL FFT requires clFFT library which may not be available
             // For AMD GPUs, use HIP/ROCm backend instead (better performance)
@@ -362,6 +1045,9 @@ namespace GPUBackend
             if (status != rocfft_status_success)
                 return false;
 
+            if (stream)
+                rocfft_execution_info_set_stream(execInfo, stream);
+
             void* inputBuffer[] = {input.getNativeHandle()};
             void* outputBuffer[] = {output.getNativeHandle()};
 
@@ -380,7 +1066,7 @@ namespace GPUBackend
     bool GPUFFT::executeInverse(GPUBuffer& input, GPUBuffer& output)
     {
         #if defined(GPU_BACKEND_CUDA)
-            cufftResult result = cufftExecC2R(reinterpret_cast<cufftHandle>(fftPlan),
+            cufftResult result = cufftExecC2R(reinterpret_cast<cufftHandle>(inversePlan),
                                              static_cast<cufftComplex*>(input.getNativeHandle()),
                                              static_cast<cufftReal*>(output.getNativeHandle()));
             return (result == CUFFT_SUCCESS);
@@ -391,10 +1077,13 @@ namespace GPUBackend
             if (status != rocfft_status_success)
                 return false;
 
+            if (stream)
+                rocfft_execution_info_set_stream(execInfo, stream);
+
             void* inputBuffer[] = {input.getNativeHandle()};
             void* outputBuffer[] = {output.getNativeHandle()};
 
-            status = rocfft_execute(reinterpret_cast<rocfft_plan>(fftPlan),
+            status = rocfft_execute(reinterpret_cast<rocfft_plan>(inversePlan),
                                    inputBuffer,
                                    outputBuffer,
                                    execInfo);
@@ -406,20 +1095,314 @@ namespace GPUBackend
         #endif
     }
 
+    void GPUFFT::setStream(GPUStream& newStream)
+    {
+        stream = newStream.getNativeHandle();
+
+        #if defined(GPU_BACKEND_CUDA)
+            if (fftPlan)
+                cufftSetStream(reinterpret_cast<cufftHandle>(fftPlan), static_cast<cudaStream_t>(stream));
+            if (inversePlan)
+                cufftSetStream(reinterpret_cast<cufftHandle>(inversePlan), static_cast<cudaStream_t>(stream));
+        #endif
+    }
+
     void GPUFFT::release()
     {
-        if (fftPlan)
+        for (void** plan : { &fftPlan, &inversePlan })
         {
-            #if defined(GPU_BACKEND_CUDA)
-                cufftDestroy(reinterpret_cast<cufftHandle>(fftPlan));
-            #elif defined(GPU_BACKEND_HIP)
-                rocfft_plan_destroy(reinterpret_cast<rocfft_plan>(fftPlan));
-            #endif
+            if (*plan)
+            {
+                #if defined(GPU_BACKEND_CUDA)
+                    cufftDestroy(reinterpret_cast<cufftHandle>(*plan));
+                #elif defined(GPU_BACKEND_HIP)
+                    rocfft_plan_destroy(reinterpret_cast<rocfft_plan>(*plan));
+                #endif
+
+                *plan = nullptr;
+            }
+        }
+    }
+
+    //==============================================================================
+    // Kernel cache implementation
+    //==============================================================================
+    /** A compiled kernel as stored on disk */
+    struct CompiledKernel
+    {
+        std::string entryName;      // Symbol to look up: the kernel name, or its lowered C++ name
+        std::vector<char> binary;
+    };
+
+    static constexpr int kernelCacheMagic = 0x4b535256; // "VRSK"
+    static constexpr int kernelCacheVersion = 1;
+
+    static juce::File getKernelCacheFolderLocked()
+    {
+        if (!g_kernelCache.directoryChosen)
+        {
+            // Next to the settings file (see SettingsManager)
+            auto baseDir = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory);
+           #if JUCE_MAC
+            baseDir = baseDir.getChildFile("Application Support");
+           #endif
+            g_kernelCache.directory = baseDir.getChildFile("VinylRestorationSuite").getChildFile("KernelCache");
+            g_kernelCache.directoryChosen = true;
+        }
+
+        return g_kernelCache.directory;
+    }
 
-            fftPlan = nullptr;
+    /** Everything a compiled kernel depends on; the source is included whole, so a hash collision cannot load stale code */
+    static std::string makeKernelCacheKey(const std::string& source, const std::string& kernelName,
+                                          const std::vector<std::string>& options)
+    {
+        const auto& info = currentContext().info;
+        std::string key = info.backendName + "\n" + info.name + "\n" + info.driverVersion
+                          + "\n" + info.architecture + "\n" + kernelName + "\n";
+
+        for (const auto& option : options)
+            key += option + " ";
+
+        return key + "\n" + source;
+    }
+
+    static juce::File getKernelCacheFile(const juce::File& folder, const std::string& key)
+    {
+        return folder.getChildFile(juce::String::toHexString(juce::String(key).hashCode64()) + ".bin");
+    }
+
+    static bool readCachedKernel(const std::string& key, CompiledKernel& kernel)
+    {
+        std::lock_guard<std::mutex> lock(g_kernelCache.lock);
+        const auto folder = getKernelCacheFolderLocked();
+
+        if (folder == juce::File())
+            return false;
+
+        juce::FileInputStream input(getKernelCacheFile(folder, key));
+
+        if (!input.openedOk() || input.readInt() != kernelCacheMagic || input.readInt() != kernelCacheVersion)
+            return false;
+
+        if (input.readString().toStdString() != key)
+            return false;
+
+        kernel.entryName = input.readString().toStdString();
+        const juce::int64 size = input.readInt64();
+
+        if (size <= 0 || size > input.getNumBytesRemaining() || kernel.entryName.empty())
+            return false;
+
+        kernel.binary.resize(static_cast<size_t>(size));
+        return input.read(kernel.binary.data(), static_cast<int>(size)) == static_cast<int>(size);
+    }
+
+    static void writeCachedKernel(const std::string& key, const CompiledKernel& kernel)
+    {
+        std::lock_guard<std::mutex> lock(g_kernelCache.lock);
+        const auto folder = getKernelCacheFolderLocked();
+
+        if (folder == juce::File() || !folder.createDirectory())
+            return;
+
+        // Written aside and moved into place, so a crash or a second process never leaves half an entry
+        const auto target = getKernelCacheFile(folder, key);
+        juce::TemporaryFile temp(target);
+
+        {
+            juce::FileOutputStream output(temp.getFile());
+            if (!output.openedOk())
+                return;
+
+            output.writeInt(kernelCacheMagic);
+            output.writeInt(kernelCacheVersion);
+            output.writeString(juce::String(key));
+            output.writeString(juce::String(kernel.entryName));
+            output.writeInt64(static_cast<juce::int64>(kernel.binary.size()));
+            output.write(kernel.binary.data(), kernel.binary.size());
+            output.flush();
+
+            if (output.getStatus().failed())
+                return;
+        }
+
+        if (!temp.overwriteTargetFileWithTemporary())
+            juce::Logger::writeToLog("GPU Backend: Could not write kernel cache entry " + target.getFullPathName());
+    }
+
+    void setKernelCacheDirectory(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(g_kernelCache.lock);
+        g_kernelCache.directory = path.empty() ? juce::File() : juce::File(juce::String(path));
+        g_kernelCache.directoryChosen = true;
+    }
+
+    std::string getKernelCacheDirectory()
+    {
+        std::lock_guard<std::mutex> lock(g_kernelCache.lock);
+        return getKernelCacheFolderLocked().getFullPathName().toStdString();
+    }
+
+    void clearKernelCache()
+    {
+        std::lock_guard<std::mutex> lock(g_kernelCache.lock);
+        const auto folder = getKernelCacheFolderLocked();
+
+        if (folder == juce::File())
+            return;
+
+        for (const auto& file : folder.findChildFiles(juce::File::findFiles, false, "*.bin"))
+            file.deleteFile();
+    }
+
+    static std::string readKernelFile(const juce::String& filename)
+    {
+        juce::File kernelFile = juce::File::getCurrentWorkingDirectory()
+            .getChildFile("Source/GPU/kernels")
+            .getChildFile(filename);
+
+        if (!kernelFile.existsAsFile())
+        {
+            // Try relative to executable
+            kernelFile = juce::File::getSpecialLocation(juce::File::currentExecutableFile)
+                .getParentDirectory()
+                .getChildFile("kernels")
+                .getChildFile(filename);
+        }
+
+        return kernelFile.existsAsFile() ? kernelFile.loadFileAsString().toStdString() : std::string();
+    }
+
+    std::string loadKernelSource(const std::string& baseName)
+    {
+        std::string source;
+
+        #if defined(GPU_BACKEND_CUDA)
+            source = readKernelFile(baseName + ".cu");
+        #elif defined(GPU_BACKEND_HIP)
+            source = readKernelFile(baseName + ".hip");
+        #endif
+
+        // OpenCL, and the fallback when a native kernel is not shipped
+        if (source.empty())
+            source = readKernelFile(baseName + ".cl");
+
+        if (source.empty())
+            juce::Logger::writeToLog("Kernel file not found: " + juce::String(baseName));
+
+        return source;
+    }
+
+    #if defined(GPU_BACKEND_CUDA) || defined(GPU_BACKEND_HIP)
+    /** Code objects, cubins and PTX are loaded as they are; anything else is compiled */
+    static bool isModuleImage(const std::string& data)
+    {
+        return data.compare(0, 4, "\x7f" "ELF") == 0
+               || data.compare(0, 24, "__CLANG_OFFLOAD_BUNDLE__") == 0
+               || data.compare(0, 8, ".version") == 0
+               || data.find("\n.version ") != std::string::npos;
+    }
+    #endif
+
+    #if defined(GPU_BACKEND_CUDA)
+    /** NVRTC: source to PTX for the current device, with the kernel's lowered name */
+    static bool compileModule(const std::string& source, const std::string& kernelName,
+                              const std::vector<std::string>& options, CompiledKernel& result)
+    {
+        nvrtcProgram program;
+        if (nvrtcCreateProgram(&program, source.c_str(), "kernel.cu", 0, nullptr, nullptr) != NVRTC_SUCCESS)
+        {
+            g_lastError = "Failed to create NVRTC program";
+            return false;
+        }
+
+        nvrtcAddNameExpression(program, kernelName.c_str());
+
+        std::vector<const char*> optionPointers;
+        for (const auto& option : options)
+            optionPointers.push_back(option.c_str());
+
+        if (nvrtcCompileProgram(program, static_cast<int>(optionPointers.size()), optionPointers.data()) != NVRTC_SUCCESS)
+        {
+            size_t logSize = 0;
+            nvrtcGetProgramLogSize(program, &logSize);
+            std::string log(logSize, '\0');
+            nvrtcGetProgramLog(program, &log[0]);
+            g_lastError = "CUDA kernel compilation failed:\n" + log;
+            nvrtcDestroyProgram(&program);
+            return false;
+        }
+
+        const char* loweredName = nullptr;
+        size_t ptxSize = 0;
+        nvrtcGetLoweredName(program, kernelName.c_str(), &loweredName);
+        nvrtcGetPTXSize(program, &ptxSize);
+
+        result.entryName = loweredName != nullptr ? loweredName : kernelName;
+        result.binary.resize(ptxSize);
+        nvrtcGetPTX(program, result.binary.data());
+
+        nvrtcDestroyProgram(&program);
+        return ptxSize > 0;
+    }
+
+    static std::vector<std::string> getCompileOptions()
+    {
+        // cooperative_groups comes from the toolkit headers
+        const auto cudaPath = juce::SystemStats::getEnvironmentVariable("CUDA_PATH", "/usr/local/cuda");
+        return { "--gpu-architecture=" + currentContext().info.architecture, "--std=c++17",
+                 "--include-path=" + cudaPath.toStdString() + "/include" };
+    }
+
+    #elif defined(GPU_BACKEND_HIP)
+    /** hiprtc: source to a code object for the current device, with the kernel's lowered name */
+    static bool compileModule(const std::string& source, const std::string& kernelName,
+                              const std::vector<std::string>& options, CompiledKernel& result)
+    {
+        hiprtcProgram program;
+        if (hiprtcCreateProgram(&program, source.c_str(), "kernel.hip", 0, nullptr, nullptr) != HIPRTC_SUCCESS)
+        {
+            g_lastError = "Failed to create hiprtc program";
+            return false;
+        }
+
+        hiprtcAddNameExpression(program, kernelName.c_str());
+
+        std::vector<const char*> optionPointers;
+        for (const auto& option : options)
+            optionPointers.push_back(option.c_str());
+
+        if (hiprtcCompileProgram(program, static_cast<int>(optionPointers.size()), optionPointers.data()) != HIPRTC_SUCCESS)
+        {
+            size_t logSize = 0;
+            hiprtcGetProgramLogSize(program, &logSize);
+            std::string log(logSize, '\0');
+            hiprtcGetProgramLog(program, &log[0]);
+            g_lastError = "HIP kernel compilation failed:\n" + log;
+            hiprtcDestroyProgram(&program);
+            return false;
         }
+
+        const char* loweredName = nullptr;
+        size_t codeSize = 0;
+        hiprtcGetLoweredName(program, kernelName.c_str(), &loweredName);
+        hiprtcGetCodeSize(program, &codeSize);
+
+        result.entryName = loweredName != nullptr ? loweredName : kernelName;
+        result.binary.resize(codeSize);
+        hiprtcGetCode(program, result.binary.data());
+
+        hiprtcDestroyProgram(&program);
+        return codeSize > 0;
     }
 
+    static std::vector<std::string> getCompileOptions()
+    {
+        return { "--gpu-architecture=" + currentContext().info.architecture, "-O3" };
+    }
+    #endif
+
     //==============================================================================
     // GPUKernel implementation
     //==============================================================================
@@ -430,29 +1413,79 @@ namespace GPUBackend
 
     bool GPUKernel::loadFromSource(const std::string& kernelSource, const std::string& kernelName)
     {
+        loadedFromCache = false;
+        device = getCurrentDevice();
+
         #if defined(GPU_BACKEND_OPENCL)
-            const char* source = kernelSource.c_str();
-            size_t sourceSize = kernelSource.length();
+            auto& context = getContext(device);
+            const std::vector<std::string> options { "-cl-fast-relaxed-math" };
+            const std::string cacheKey = makeKernelCacheKey(kernelSource, kernelName, options);
 
             cl_int err;
-            cl_program program = clCreateProgramWithSource(g_clContext, 1, &source, &sourceSize, &err);
-            if (err != CL_SUCCESS)
+            cl_program program = nullptr;
+            CompiledKernel cached;
+
+            if (readCachedKernel(cacheKey, cached))
             {
-                g_lastError = "Failed to create OpenCL program";
-                return false;
+                const auto* binary = reinterpret_cast<const unsigned char*>(cached.binary.data());
+                const size_t binarySize = cached.binary.size();
+                cl_int binaryStatus = CL_SUCCESS;
+
+                program = clCreateProgramWithBinary(context.clContext, 1, &context.clDevice, &binarySize, &binary,
+                                                    &binaryStatus, &err);
+
+                // A binary the driver rejects is compiled again below and replaced
+                if (err != CL_SUCCESS || binaryStatus != CL_SUCCESS
+                    || clBuildProgram(program, 1, &context.clDevice, options[0].c_str(), nullptr, nullptr) != CL_SUCCESS)
+                {
+                    if (program)
+                        clReleaseProgram(program);
+
+                    program = nullptr;
+                }
+
+                loadedFromCache = program != nullptr;
             }
 
-            // Compile program
-            err = clBuildProgram(program, 1, &g_clDevice, "-cl-fast-relaxed-math", nullptr, nullptr);
-            if (err != CL_SUCCESS)
+            if (!program)
             {
-                // Get build log
-                char buildLog[4096];
-                clGetProgramBuildInfo(program, g_clDevice, CL_PROGRAM_BUILD_LOG,
-                                     sizeof(buildLog), buildLog, nullptr);
-                g_lastError = "OpenCL kernel compilation failed:\n" + std::string(buildLog);
-                clReleaseProgram(program);
-                return false;
+                const char* source = kernelSource.c_str();
+                size_t sourceSize = kernelSource.length();
+
+                program = clCreateProgramWithSource(context.clContext, 1, &source, &sourceSize, &err);
+                if (err != CL_SUCCESS)
+                {
+                    g_lastError = "Failed to create OpenCL program";
+                    return false;
+                }
+
+                // Compile program
+                err = clBuildProgram(program, 1, &context.clDevice, options[0].c_str(), nullptr, nullptr);
+                if (err != CL_SUCCESS)
+                {
+                    // Get build log
+                    char buildLog[4096];
+                    clGetProgramBuildInfo(program, context.clDevice, CL_PROGRAM_BUILD_LOG,
+                                         sizeof(buildLog), buildLog, nullptr);
+                    g_lastError = "OpenCL kernel compilation failed:\n" + std::string(buildLog);
+                    clReleaseProgram(program);
+                    return false;
+                }
+
+                // Keep the device binary for the next launch
+                size_t binarySize = 0;
+                clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &binarySize, nullptr);
+
+                if (binarySize > 0)
+                {
+                    CompiledKernel compiled;
+                    compiled.entryName = kernelName;
+                    compiled.binary.resize(binarySize);
+                    unsigned char* binaries[] = { reinterpret_cast<unsigned char*>(compiled.binary.data()) };
+
+                    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaries), binaries, nullptr) == CL_SUCCESS)
+                        writeCachedKernel(cacheKey, compiled);
+                }
             }
 
             // Create kernel
@@ -468,51 +1501,75 @@ namespace GPUBackend
             nativeKernel = kernel;
             return true;
 
-        #elif defined(GPU_BACKEND_HIP)
-            // HIP: Compile kernel at runtime
-            hipModule_t module;
-            hipError_t err = hipModuleLoadData(&module, kernelSource.c_str());
-            if (err != hipSuccess)
+        #elif defined(GPU_BACKEND_HIP) || defined(GPU_BACKEND_CUDA)
+            // Source is compiled at runtime for this device and the result cached;
+            // prebuilt module images are loaded as they are
+            const auto options = getCompileOptions();
+            const std::string cacheKey = makeKernelCacheKey(kernelSource, kernelName, options);
+            CompiledKernel compiled;
+
+            if (isModuleImage(kernelSource))
             {
-                g_lastError = "Failed to load HIP module";
-                return false;
+                compiled.entryName = kernelName;
+                compiled.binary.assign(kernelSource.begin(), kernelSource.end());
+                compiled.binary.push_back('\0');
             }
-
-            hipFunction_t function;
-            err = hipModuleGetFunction(&function, module, kernelName.c_str());
-            if (err != hipSuccess)
+            else if (readCachedKernel(cacheKey, compiled))
             {
-                g_lastError = "Failed to get HIP kernel function: " + kernelName;
-                hipModuleUnload(module);
-                return false;
+                loadedFromCache = true;
             }
-
-            nativeProgram = module;
-            nativeKernel = function;
-            return true;
-
-        #elif defined(GPU_BACKEND_CUDA)
-            // CUDA: Load PTX/cubin module
-            CUmodule module;
-            CUresult err = cuModuleLoadData(&module, kernelSource.c_str());
-            if (err != CUDA_SUCCESS)
+            else if (compileModule(kernelSource, kernelName, options, compiled))
             {
-                g_lastError = "Failed to load CUDA module";
-                return false;
+                writeCachedKernel(cacheKey, compiled);
             }
-
-            CUfunction function;
-            err = cuModuleGetFunction(&function, module, kernelName.c_str());
-            if (err != CUDA_SUCCESS)
+            else
             {
-                g_lastError = "Failed to get CUDA kernel function: " + kernelName;
-                cuModuleUnload(module);
                 return false;
             }
 
-            nativeProgram = module;
-            nativeKernel = function;
-            return true;
+            for (;;)
+            {
+               #if defined(GPU_BACKEND_HIP)
+                hipModule_t module;
+                hipFunction_t function;
+                const bool loaded = hipModuleLoadData(&module, compiled.binary.data()) == hipSuccess;
+
+                if (loaded && hipModuleGetFunction(&function, module, compiled.entryName.c_str()) == hipSuccess)
+                {
+                    nativeProgram = module;
+                    nativeKernel = function;
+                    return true;
+                }
+
+                if (loaded)
+                    hipModuleUnload(module);
+
+                g_lastError = "Failed to load HIP kernel function: " + kernelName;
+               #else
+                CUmodule module;
+                CUfunction function;
+                const bool loaded = cuModuleLoadData(&module, compiled.binary.data()) == CUDA_SUCCESS;
+
+                if (loaded && cuModuleGetFunction(&function, module, compiled.entryName.c_str()) == CUDA_SUCCESS)
+                {
+                    nativeProgram = module;
+                    nativeKernel = function;
+                    return true;
+                }
+
+                if (loaded)
+                    cuModuleUnload(module);
+
+                g_lastError = "Failed to load CUDA kernel function: " + kernelName;
+               #endif
+
+                // A cache entry the driver rejects is compiled again once and replaced
+                if (!loadedFromCache || !compileModule(kernelSource, kernelName, options, compiled))
+                    return false;
+
+                loadedFromCache = false;
+                writeCachedKernel(cacheKey, compiled);
+            }
 
         #else
             g_lastError = "No GPU backend available for kernel compilation";
@@ -566,13 +1623,17 @@ namespace GPUBackend
         #endif
     }
 
-    bool GPUKernel::execute(size_t globalWorkSize, size_t localWorkSize)
+    bool GPUKernel::execute(size_t globalWorkSize, size_t localWorkSize, GPUStream* stream)
     {
+        void* nativeStream = stream ? stream->getNativeHandle() : nullptr;
+        juce::ignoreUnused(nativeStream);
+
         #if defined(GPU_BACKEND_OPENCL)
             size_t global = globalWorkSize;
             size_t local = localWorkSize;
+            cl_command_queue queue = nativeStream ? static_cast<cl_command_queue>(nativeStream) : getContext(device).clQueue;
 
-            cl_int err = clEnqueueNDRangeKernel(g_clQueue, static_cast<cl_kernel>(nativeKernel),
+            cl_int err = clEnqueueNDRangeKernel(queue, static_cast<cl_kernel>(nativeKernel),
                                                1, nullptr, &global, &local,
                                                0, nullptr, nullptr);
             return (err == CL_SUCCESS);
@@ -586,7 +1647,7 @@ namespace GPUBackend
                 static_cast<hipFunction_t>(nativeKernel),
                 gridSize, 1, 1,
                 blockSize, 1, 1,
-                0, nullptr,
+                0, static_cast<hipStream_t>(nativeStream),
                 nullptr, nullptr);
             return (err == hipSuccess);
 
@@ -599,7 +1660,7 @@ namespace GPUBackend
                 static_cast<CUfunction>(nativeKernel),
                 gridSize, 1, 1,
                 blockSize, 1, 1,
-                0, nullptr,
+                0, static_cast<CUstream>(nativeStream),
                 nullptr, nullptr);
             return (err == CUDA_SUCCESS);
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <vector>
@@ -56,6 +57,8 @@ namespace GPUBackend
         int computeUnits;
         int maxWorkGroupSize;
         std::string backendName;
+        std::string driverVersion;
+        std::string architecture;   // Compile target: compute capability or gfx name; empty for OpenCL
     };
 
     //==============================================================================
@@ -71,9 +74,153 @@ namespace GPUBackend
     /** Get current device information */
     DeviceInfo getDeviceInfo();
 
+    /**
+     * Devices
+     *
+     * initialize() opens every usable GPU, each with its own context, default
+     * queue and memory pool; device 0 is the default. GPU calls on a thread go
+     * to that thread's current device. Buffers, kernels, plans and streams
+     * belong to the device that was current when they were created, so a
+     * thread that drives device n calls setCurrentDevice(n) before creating or
+     * using them. The memory budget functions apply to the current device.
+     */
+    int getNumDevices();
+
+    /** Information on one device, 0 to getNumDevices() - 1 */
+    DeviceInfo getDeviceInfo(int deviceIndex);
+
+    /** Selects this thread's device; false if there is no such device */
+    bool setCurrentDevice(int deviceIndex);
+
+    /** This thread's device (0 unless setCurrentDevice() changed it) */
+    int getCurrentDevice();
+
     /** Get backend name (OpenCL, CUDA, HIP, etc.) */
     std::string getBackendName();
 
+    //==============================================================================
+    /**
+     * Device memory pool
+     *
+     * GPUBuffer::allocate() rounds requests up to a size class (four per octave)
+     * and reuses a cached device allocation of that class when one is free;
+     * release() returns it to the cache. Repeated prepare() calls and long batch
+     * runs therefore stop allocating after warm-up and do not fragment VRAM.
+     *
+     * All allocations together stay within a budget: by default three quarters
+     * of the device memory, or whatever setMemoryBudget() sets. Callers size
+     * their chunks from getAvailableMemoryBudget() instead of failing.
+     */
+    struct MemoryPoolStats
+    {
+        size_t bytesInUse = 0;        // Held by live GPUBuffers (size classes, not requests)
+        size_t bytesCached = 0;       // Released, kept for reuse
+        size_t highWaterMark = 0;     // Peak of bytesInUse
+        size_t budget = 0;            // 0 = unlimited
+        int deviceAllocations = 0;    // Allocations that reached the driver
+        int reusedAllocations = 0;    // Allocations served from the cache
+    };
+
+    /** Limit on pooled device memory in bytes; 0 restores the default */
+    void setMemoryBudget(size_t bytes);
+
+    /** Current limit in bytes (0 = unlimited) */
+    size_t getMemoryBudget();
+
+    /** Budget not held by live buffers; cached buffers count as available */
+    size_t getAvailableMemoryBudget();
+
+    /** Pool counters, for diagnostics */
+    MemoryPoolStats getMemoryPoolStats();
+
+    /** Free every cached, unused allocation */
+    void trimMemoryPool();
+
+    //==============================================================================
+    /**
+     * Compiled kernel cache
+     *
+     * GPUKernel::loadFromSource() stores what it compiles (OpenCL program
+     * binaries, HIP code objects, CUDA PTX) on disk. Entries are keyed by
+     * backend, device, driver version, target architecture, build options,
+     * kernel name and a hash of the source, and the full key is checked on
+     * load. A new driver or edited kernel therefore misses and recompiles, so
+     * only the first launch pays the compile cost. A corrupt or rejected entry
+     * is compiled again and overwritten.
+     */
+
+    /** Cache folder; empty disables the cache. Defaults to the app data folder. */
+    void setKernelCacheDirectory(const std::string& path);
+    std::string getKernelCacheDirectory();
+
+    /** Delete every cached kernel */
+    void clearKernelCache();
+
+    /** Source of a shipped kernel for this backend: baseName.cu or .hip, else
+        baseName.cl, from Source/GPU/kernels or the kernels folder next to the
+        executable. Empty if not found. */
+    std::string loadKernelSource(const std::string& baseName);
+
+    //==============================================================================
+    /**
+     * Asynchronous work queue: a CUDA or HIP stream, or an OpenCL command queue.
+     * Work on one stream runs in order; work on different streams may overlap,
+     * so an upload on one can run while another computes.
+     */
+    class GPUStream
+    {
+    public:
+        GPUStream() = default;
+        ~GPUStream();
+
+        /** Create the stream on the current device */
+        bool create();
+
+        /** Block until everything queued on this stream has finished */
+        bool synchronize();
+
+        /** Destroy the stream */
+        void release();
+
+        /** Get native stream / queue handle */
+        void* getNativeHandle() const { return nativeStream; }
+
+    private:
+        void* nativeStream = nullptr;
+
+    private:
+        GPUStream(const GPUStream&) = delete;
+        GPUStream& operator=(const GPUStream&) = delete;
+    };
+
+    //==============================================================================
+    /** Marker in a stream, for waiting on part of its work or ordering another stream after it */
+    class GPUEvent
+    {
+    public:
+        GPUEvent() = default;
+        ~GPUEvent();
+
+        /** Mark the point after everything queued on stream so far */
+        bool record(GPUStream& stream);
+
+        /** Make stream wait for the recorded point before running later work */
+        bool makeStreamWait(GPUStream& stream);
+
+        /** Block until the recorded point is reached */
+        bool synchronize();
+
+        /** Release the event */
+        void release();
+
+    private:
+        void* nativeEvent = nullptr;
+
+    private:
+        GPUEvent(const GPUEvent&) = delete;
+        GPUEvent& operator=(const GPUEvent&) = delete;
+    };
+
     //==============================================================================
     /** GPU memory buffer wrapper */
     class GPUBuffer
@@ -91,24 +238,69 @@ namespace GPUBackend
         /** Copy data from GPU to host */
         bool download(void* hostData, size_t sizeInBytes);
 
+        /** Queue a host to GPU copy on stream; hostData must stay valid until it completes.
+            Pinned host memory (PinnedHostBuffer) lets the copy overlap other work. */
+        bool uploadAsync(const void* hostData, size_t sizeInBytes, GPUStream& stream);
+
+        /** Queue a GPU to host copy on stream; hostData is valid once the stream reaches it */
+        bool downloadAsync(void* hostData, size_t sizeInBytes, GPUStream& stream);
+
         /** Free GPU memory */
         void release();
 
         /** Get buffer size in bytes */
         size_t getSize() const { return size; }
 
+        /** Get size of the pooled allocation behind this buffer (its size class) */
+        size_t getCapacity() const { return capacity; }
+
         /** Get native GPU buffer handle */
         void* getNativeHandle() const { return nativeBuffer; }
 
     private:
         void* nativeBuffer = nullptr;
         size_t size = 0;
+        size_t capacity = 0;
+        int device = 0;               // Whose pool the allocation returns to
 
     private:
         GPUBuffer(const GPUBuffer&) = delete;
         GPUBuffer& operator=(const GPUBuffer&) = delete;
     };
 
+    //==============================================================================
+    /**
+     * Page-locked host memory, so async copies run by DMA without a staging copy.
+     * Falls back to ordinary memory (isPinned() false) where that is unavailable.
+     */
+    class PinnedHostBuffer
+    {
+    public:
+        PinnedHostBuffer() = default;
+        ~PinnedHostBuffer();
+
+        /** Allocate host memory; contents are undefined */
+        bool allocate(size_t sizeInBytes);
+
+        /** Free the memory */
+        void release();
+
+        float* getData() const { return static_cast<float*>(hostData); }
+        size_t getSize() const { return size; }
+        bool isPinned() const { return pinned; }
+
+    private:
+        void* hostData = nullptr;
+        void* nativeBuffer = nullptr; // OpenCL: the mapped buffer object
+        size_t size = 0;
+        bool pinned = false;
+        int device = 0;
+
+    private:
+        PinnedHostBuffer(const PinnedHostBuffer&) = delete;
+        PinnedHostBuffer& operator=(const PinnedHostBuffer&) = delete;
+    };
+
     //==============================================================================
     /** GPU FFT wrapper - unified interface for cuFFT/rocFFT/clFFT/VkFFT */
     class GPUFFT
@@ -123,23 +315,35 @@ namespace GPUBackend
         GPUFFT() = default;
         ~GPUFFT();
 
-        /** Create FFT plan for given size */
+        /**
+         * Create forward and inverse plans for batchSize transforms of fftSize.
+         * Batches are packed back to back: real frames fftSize floats apart,
+         * spectra fftSize / 2 + 1 complex bins apart.
+         */
         bool createPlan(int fftSize, int batchSize = 1);
 
-        /** Execute forward FFT (real input -> complex output) */
+        /** Execute forward FFT (real input -> complex output) on the whole batch */
         bool executeForward(GPUBuffer& input, GPUBuffer& output);
 
-        /** Execute inverse FFT (complex input -> real output) */
+        /** Execute inverse FFT (complex input -> real output, unnormalised) on the whole batch */
         bool executeInverse(GPUBuffer& input, GPUBuffer& output);
 
+        /** Queue later executions on stream instead of the default stream */
+        void setStream(GPUStream& stream);
+
         /** Destroy FFT plan */
         void release();
 
         /** Get FFT size */
         int getFFTSize() const { return fftSize; }
 
+        /** Get number of transforms per execution */
+        int getBatchSize() const { return batchSize; }
+
     private:
         void* fftPlan = nullptr;
+        void* inversePlan = nullptr;
+        void* stream = nullptr;
         int fftSize = 0;
         int batchSize = 1;
 
@@ -156,16 +360,19 @@ namespace GPUBackend
         GPUKernel() = default;
         ~GPUKernel();
 
-        /** Load kernel from source code string */
+        /** Compile kernel source, or load it from the kernel cache */
         bool loadFromSource(const std::string& kernelSource, const std::string& kernelName);
 
+        /** True if the last load skipped compilation */
+        bool wasLoadedFromCache() const { return loadedFromCache; }
+
         /** Set kernel argument */
         bool setArgument(int index, GPUBuffer& buffer);
         bool setArgument(int index, float value);
         bool setArgument(int index, int value);
 
-        /** Execute kernel with given work size */
-        bool execute(size_t globalWorkSize, size_t localWorkSize = 256);
+        /** Execute kernel with given work size, on stream or else the default queue */
+        bool execute(size_t globalWorkSize, size_t localWorkSize = 256, GPUStream* stream = nullptr);
 
         /** Release kernel resources */
         void release();
@@ -173,6 +380,8 @@ namespace GPUBackend
     private:
         void* nativeKernel = nullptr;
         void* nativeProgram = nullptr;
+        bool loadedFromCache = false;
+        int device = 0;
 
     private:
         GPUKernel(const GPUKernel&) = delete;
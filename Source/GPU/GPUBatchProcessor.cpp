@@ -1,20 +1,183 @@
 #include "GPUBatchProcessor.h"
 #include <juce_core/juce_core.h>
+#include <algorithm>
+#include <map>
 
+namespace
+{
+    /** Runs one pipeline stage */
+    class PipelineThread : public juce::Thread
+    {
+    public:
+        PipelineThread(const juce::String& name, std::function<void()> bodyToRun)
+            : juce::Thread(name), body(std::move(bodyToRun)) {}
+
+        void run() override { body(); }
+
+    private:
+        std::function<void()> body;
+    };
+}
+
+//==============================================================================
+/** A run of one segment's audio between two stages; silent past numSamples */
+struct GPUBatchProcessor::Chunk
+{
+    int jobIndex = 0;
+    int segment = 0;
+    int slot = -1;
+    juce::AudioBuffer<float> audio;
+    int numSamples = 0;     // Fed to the STFT
+    int outputStart = 0;    // audio[outputStart, outputStart + outputCount) is written
+    int outputCount = 0;
+    bool isFirst = false;   // Of its segment
+    bool isLast = false;
+    bool failed = false;    // The segment could not be read; carries no audio
+};
+
+/** Where a file in flight stands; each field is owned by one stage at a time */
+struct GPUBatchProcessor::FileState
+{
+    int numChannels = 0;
+    double sampleRate = 0.0;
+    juce::int64 lengthInSamples = 0;
+    int numSegments = 0;
+
+    // Written by the encoder under workLock, so decoders can tell how far ahead to read
+    int segmentsWritten = 0;
+
+    // Encoder
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::int64 samplesWritten = 0;
+    std::map<int, std::deque<std::unique_ptr<Chunk>>> earlyChunks;   // Segments waiting for an earlier one
+    bool failed = false;
+    std::string errorMessage;
+};
+
+/** One device's share of the pipeline */
+struct GPUBatchProcessor::DeviceLane
+{
+    int device = 0;
+    std::unique_ptr<GPUNoiseReduction> noiseReduction;
+    std::unique_ptr<ChunkQueue> decodedChunks;
+    std::atomic<int> activeDecoders { 0 };
+
+    std::mutex slotLock;
+    std::condition_variable slotFreed;
+    std::vector<int> freeSlots;
+
+    // Usage, for getDeviceUsage()
+    std::atomic<juce::int64> busyMicroseconds { 0 };
+    std::atomic<juce::int64> samplesProcessed { 0 };
+    std::atomic<int> segmentsProcessed { 0 };
+};
+
+/** A decoder's click removal: the segment being repaired, and the detector for its lane's device */
+struct GPUBatchProcessor::SegmentRepair
+{
+    ClickRemoval clickRemoval;
+    GPUClickDetector detector;
+    juce::AudioBuffer<float> audio;
+};
+
+/** Bounded FIFO between stages; push blocks while full, pop while empty */
+class GPUBatchProcessor::ChunkQueue
+{
+public:
+    explicit ChunkQueue(size_t capacityToUse) : capacity(capacityToUse) {}
+
+    /** False once the queue is closed; the chunk is dropped */
+    bool push(std::unique_ptr<Chunk> chunk)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return closed || chunks.size() < capacity; });
+
+        if (closed)
+            return false;
+
+        chunks.push_back(std::move(chunk));
+        changed.notify_all();
+        return true;
+    }
+
+    /** nullptr once the queue is closed and empty */
+    std::unique_ptr<Chunk> pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return closed || !chunks.empty(); });
+        return takeFront();
+    }
+
+    /** nullptr if nothing is waiting */
+    std::unique_ptr<Chunk> tryPop()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return takeFront();
+    }
+
+    /** Wakes every waiter; what is queued can still be popped */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        changed.notify_all();
+    }
+
+private:
+    std::unique_ptr<Chunk> takeFront()
+    {
+        if (chunks.empty())
+            return {};
+
+        auto chunk = std::move(chunks.front());
+        chunks.pop_front();
+        changed.notify_all();
+        return chunk;
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::unique_ptr<Chunk>> chunks;
+    const size_t capacity;
+    bool closed = false;
+};
+
+//==============================================================================
 GPUBatchProcessor::GPUBatchProcessor()
 {
     gpuEnabled = initializeGPU();
 
+    // One lane per device; each noise reduction runs on the device current when it is made.
+    // It falls back to the CPU by itself, so the pipeline runs either way.
+    const int numLanes = gpuEnabled ? juce::jmax(1, GPUBackend::getNumDevices()) : 1;
+    const int previousDevice = GPUBackend::getCurrentDevice();
+
+    for (int device = 0; device < numLanes; ++device)
+    {
+        auto lane = std::make_unique<DeviceLane>();
+        lane->device = device;
+
+        if (gpuEnabled)
+            GPUBackend::setCurrentDevice(device);
+
+        lane->noiseReduction = std::make_unique<GPUNoiseReduction>();
+        lanes.push_back(std::move(lane));
+    }
+
     if (gpuEnabled)
     {
-        juce::Logger::writeToLog("GPU Batch Processor: Initialized");
-        gpuNoiseReduction = std::make_unique<GPUNoiseReduction>();
+        GPUBackend::setCurrentDevice(previousDevice);
+        juce::Logger::writeToLog("GPU Batch Processor: Initialized with " + juce::String(numLanes) + " device(s)");
     }
 }
 
 GPUBatchProcessor::~GPUBatchProcessor()
 {
     cancelProcessing();
+
+    if (workerThread)
+        workerThread->stopThread(-1); // May still be calling onAllJobsComplete
+
     shutdownGPU();
 }
 
@@ -45,13 +208,9 @@ void GPUBatchProcessor::clearJobs()
 
 void GPUBatchProcessor::setSettings(const ProcessingSettings& newSettings)
 {
-    settings = newSettings;
-
-    if (gpuEnabled && gpuNoiseReduction && !settings.noiseProfile.empty())
-    {
-        // Upload noise profile to GPU
-        // TODO: Implement profile upload
-    }
+    // Applied when processing starts, once the noise reduction is prepared
+    if (!processing)
+        settings = newSettings;
 }
 
 void GPUBatchProcessor::startProcessing()
@@ -59,28 +218,53 @@ void GPUBatchProcessor::startProcessing()
     if (processing || jobs.empty())
         return;
 
+    if (workerThread)
+        workerThread->stopThread(-1); // The previous run has finished; just join it
+
     processing = true;
     cancelled = false;
     currentJobIndex = 0;
 
-    juce::Logger::writeToLog("Batch Processing: Starting " + juce::String(jobs.size()) +
-                            " jobs (" + (gpuEnabled ? "GPU" : "CPU") + ")");
+    // Everything the stages share lives until the next run, so cancelProcessing()
+    // can close the queues at any point
+    const int numLanes = static_cast<int>(lanes.size());
+    const int numStageThreads = juce::jlimit(1, maxFilesInFlight, juce::SystemStats::getNumCpus() / 2);
+    decodersPerLane = juce::jlimit(1, maxFilesInFlight, numStageThreads / numLanes);
 
-    // Start worker thread
-    class BatchWorkerThread : public juce::Thread
+    for (auto& lane : lanes)
     {
-    public:
-        BatchWorkerThread(GPUBatchProcessor& p) : juce::Thread("GPUBatchProcessor"), processor(p) {}
+        lane->decodedChunks = std::make_unique<ChunkQueue>(static_cast<size_t>(decodedQueueLength));
 
-        void run() override
-        {
-            processor.workerThreadFunction();
-        }
+        lane->freeSlots.clear();
+        for (int slot = maxFilesInFlight; --slot >= 0;)
+            lane->freeSlots.push_back(slot);
 
-        GPUBatchProcessor& processor;
-    };
+        lane->busyMicroseconds = 0;
+        lane->samplesProcessed = 0;
+        lane->segmentsProcessed = 0;
+    }
 
-    workerThread = std::make_unique<BatchWorkerThread>(*this);
+    encoderQueues.clear();
+    for (int i = 0; i < numStageThreads; ++i)
+        encoderQueues.push_back(std::make_unique<ChunkQueue>(static_cast<size_t>(encoderQueueLength)));
+
+    fileStates.clear();
+    for (size_t i = 0; i < jobs.size(); ++i)
+        fileStates.push_back(std::make_unique<FileState>());
+
+    // Enough segments of one file in flight to fill every device's slots
+    pendingSegments.clear();
+    nextJobToOpen = 0;
+    jobsOpening = 0;
+    maxSegmentsAhead = maxFilesInFlight * numLanes;
+
+    runStartTime = juce::Time::getMillisecondCounterHiRes();
+    runEndTime = 0.0;
+
+    juce::Logger::writeToLog("Batch Processing: Starting " + juce::String(jobs.size()) + " jobs (" +
+                            (gpuEnabled ? "GPU x" + juce::String(numLanes) : juce::String("CPU")) + ")");
+
+    workerThread = std::make_unique<PipelineThread>("GPUBatchProcessor", [this] { workerThreadFunction(); });
     workerThread->startThread();
 }
 
@@ -89,10 +273,26 @@ void GPUBatchProcessor::cancelProcessing()
     if (processing)
     {
         cancelled = true;
+        closeQueues();
+
+        {
+            std::lock_guard<std::mutex> lock(workLock);
+        }
+        workChanged.notify_all();
 
+        for (auto& lane : lanes)
+        {
+            {
+                std::lock_guard<std::mutex> lock(lane->slotLock);
+            }
+            lane->slotFreed.notify_all();
+        }
+
+        // Every stage returns promptly once its queues are closed; killing one
+        // could leave a lock held, so wait for it however long the chunk takes
         if (workerThread)
         {
-            workerThread->stopThread(5000);
+            workerThread->stopThread(-1);
             workerThread.reset();
         }
 
@@ -105,15 +305,13 @@ float GPUBatchProcessor::getOverallProgress() const
     if (jobs.empty())
         return 0.0f;
 
-    float completedJobs = static_cast<float>(currentJobIndex);
-    float currentProgress = 0.0f;
+    // Several files are in flight at once, so every job counts its own share
+    float total = 0.0f;
 
-    if (currentJobIndex < static_cast<int>(jobs.size()))
-    {
-        currentProgress = jobs[static_cast<size_t>(currentJobIndex)].progress;
-    }
+    for (const auto& job : jobs)
+        total += job.completed ? 1.0f : job.progress;
 
-    return (completedJobs + currentProgress) / static_cast<float>(jobs.size());
+    return total / static_cast<float>(jobs.size());
 }
 
 std::string GPUBatchProcessor::getGPUInfo() const
@@ -121,112 +319,616 @@ std::string GPUBatchProcessor::getGPUInfo() const
     if (!gpuEnabled)
         return "CPU";
 
-    auto deviceInfo = GPUBackend::getDeviceInfo();
-    return deviceInfo.name + " (" + deviceInfo.backendName + ")";
+    std::string names;
+
+    for (const auto& lane : lanes)
+    {
+        if (!names.empty())
+            names += ", ";
+
+        names += GPUBackend::getDeviceInfo(lane->device).name;
+    }
+
+    return names + " (" + GPUBackend::getBackendName() + ")";
+}
+
+std::vector<GPUBatchProcessor::DeviceUsage> GPUBatchProcessor::getDeviceUsage() const
+{
+    const double start = runStartTime.load();
+    const double end = runEndTime.load() > 0.0 ? runEndTime.load()
+                                               : (processing ? juce::Time::getMillisecondCounterHiRes() : start);
+    const double elapsedMs = end - start;
+
+    std::vector<DeviceUsage> usage;
+
+    for (const auto& lane : lanes)
+    {
+        DeviceUsage entry;
+        entry.deviceName = gpuEnabled ? GPUBackend::getDeviceInfo(lane->device).name : "CPU";
+        entry.samplesProcessed = lane->samplesProcessed.load();
+        entry.segmentsProcessed = lane->segmentsProcessed.load();
+
+        if (elapsedMs > 0.0)
+            entry.utilization = juce::jlimit(0.0f, 1.0f, static_cast<float>(lane->busyMicroseconds.load() / (elapsedMs * 1000.0)));
+
+        usage.push_back(entry);
+    }
+
+    return usage;
 }
 
 //==============================================================================
-void GPUBatchProcessor::processJobsGPU()
+void GPUBatchProcessor::workerThreadFunction()
 {
-    // TODO: Implement parallel GPU processing
-    // This would:
-    // 1. Load multiple files into GPU memory
-    // 2. Process them in parallel using GPU streams
-    // 3. Save results
+    // One STFT channel per slot channel; the noise profile must follow prepare()
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = 44100.0;
+    spec.maximumBlockSize = static_cast<juce::uint32>(chunkSamples);
+    spec.numChannels = static_cast<juce::uint32>(maxFilesInFlight * maxChannelsPerFile);
+
+    bool profileRejected = false;
+
+    for (auto& lane : lanes)
+    {
+        auto& noiseReduction = *lane->noiseReduction;
+        noiseReduction.prepare(spec);
+        noiseReduction.setReduction(settings.noiseReductionAmount);
 
-    // For now, process sequentially
-    for (size_t i = 0; i < jobs.size() && !cancelled; ++i)
+        if (settings.enableNoiseReduction && !settings.noiseProfile.empty()
+            && !noiseReduction.setNoiseProfile(settings.noiseProfile))
+            profileRejected = true;
+    }
+
+    if (profileRejected)
+        juce::Logger::writeToLog("Batch Processing: Noise profile size does not match the FFT size, ignoring it");
+
+    // Every lane has the same settings, so the first speaks for all of them
+    const auto& firstNoiseReduction = *lanes.front()->noiseReduction;
+    noiseReductionActive = settings.enableNoiseReduction && firstNoiseReduction.isActivelyReducing();
+    pipelineLatency = noiseReductionActive ? firstNoiseReduction.getLatencySamples() : 0;
+    segmentPreRoll = noiseReductionActive ? firstNoiseReduction.getFFTSize() : 0;
+
+    if (settings.enableNoiseReduction && !noiseReductionActive)
+        juce::Logger::writeToLog("Batch Processing: No noise profile, noise reduction skipped");
+
+    activeGPUStages = static_cast<int>(lanes.size());
+
+    stageThreads.clear();
+    for (auto& lane : lanes)
     {
-        currentJobIndex = static_cast<int>(i);
-        auto& job = jobs[i];
+        auto* deviceLane = lane.get();
+        deviceLane->activeDecoders = decodersPerLane;
 
-        job.success = processFileGPU(job);
-        job.completed = true;
-        job.progress = 1.0f;
+        for (int i = 0; i < decodersPerLane; ++i)
+            stageThreads.push_back(std::make_unique<PipelineThread>("BatchDecoder",
+                                                                    [this, deviceLane] { decodeJobs(*deviceLane); }));
 
-        if (onJobComplete)
-            onJobComplete(static_cast<int>(i), job.success, job.errorMessage);
+        stageThreads.push_back(std::make_unique<PipelineThread>("BatchGPU",
+                                                                [this, deviceLane] { processChunksGPU(*deviceLane); }));
     }
+
+    for (auto& queue : encoderQueues)
+    {
+        auto* encoderQueue = queue.get();
+        stageThreads.push_back(std::make_unique<PipelineThread>("BatchEncoder",
+                                                                [this, encoderQueue] { encodeChunks(*encoderQueue); }));
+    }
+
+    for (auto& thread : stageThreads)
+        thread->startThread();
+
+    for (auto& thread : stageThreads)
+        thread->waitForThreadToExit(-1);
+
+    stageThreads.clear();
+    runEndTime = juce::Time::getMillisecondCounterHiRes();
+
+    // Cancelled files keep whatever was written; mark them so callers can tell
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        fileStates[i]->writer.reset();
+        fileStates[i]->earlyChunks.clear();
+
+        if (!jobs[i].completed)
+        {
+            jobs[i].errorMessage = "Cancelled";
+            jobs[i].success = false;
+        }
+    }
+
+    processing = false;
+
+    if (onAllJobsComplete)
+        onAllJobsComplete();
 }
 
-void GPUBatchProcessor::processJobCPU(FileJob& job)
+void GPUBatchProcessor::decodeJobs(DeviceLane& lane)
 {
-    // CPU fallback processing
-    job.errorMessage = "CPU processing not yet implemented";
-    job.success = false;
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    // The detector works on the device current when it is made
+    std::unique_ptr<SegmentRepair> repair;
+
+    if (settings.enableClickRemoval && settings.clickSensitivity > 0.0f)
+    {
+        if (gpuEnabled)
+            GPUBackend::setCurrentDevice(lane.device);
+
+        juce::dsp::ProcessSpec spec;
+        spec.sampleRate = 44100.0;
+        spec.maximumBlockSize = 2048;
+        spec.numChannels = static_cast<juce::uint32>(maxChannelsPerFile);
+
+        repair = std::make_unique<SegmentRepair>();
+        repair->clickRemoval.prepare(spec);
+        repair->clickRemoval.setSensitivity(settings.clickSensitivity);
+        repair->clickRemoval.setStoreDetectedClicks(false);
+        repair->clickRemoval.setApplyRemoval(true);
+    }
+
+    int jobIndex = 0;
+    int segment = 0;
+    bool isNewJob = false;
+
+    while (takeWork(jobIndex, segment, isNewJob))
+    {
+        // Every segment opens its own reader, so any decoder can take any segment
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(jobs[static_cast<size_t>(jobIndex)].inputFile));
+
+        if (isNewJob && !openJob(jobIndex, reader.get()))
+            continue;
+
+        if (!decodeSegment(lane, reader.get(), repair.get(), jobIndex, segment))
+            break;
+    }
+
+    // The last decoder out lets this lane's GPU stage drain and finish
+    if (--lane.activeDecoders == 0)
+        lane.decodedChunks->close();
 }
 
-bool GPUBatchProcessor::processFileGPU(FileJob& job)
+bool GPUBatchProcessor::takeWork(int& jobIndex, int& segment, bool& isNewJob)
 {
-    // Simplified file processing
-    // TODO: Implement full GPU processing pipeline
+    std::unique_lock<std::mutex> lock(workLock);
 
-    try
+    for (;;)
     {
-        // Load file
-        juce::AudioFormatManager formatManager;
-        formatManager.registerBasicFormats();
+        if (cancelled)
+            return false;
 
-        std::unique_ptr<juce::AudioFormatReader> reader(
-            formatManager.createReaderFor(job.inputFile));
+        // Finish open files first, but only so far ahead of what has been written:
+        // the encoder holds on to segments that arrive before an earlier one
+        for (auto it = pendingSegments.begin(); it != pendingSegments.end(); ++it)
+        {
+            if (it->second < fileStates[static_cast<size_t>(it->first)]->segmentsWritten + maxSegmentsAhead)
+            {
+                jobIndex = it->first;
+                segment = it->second;
+                isNewJob = false;
+                pendingSegments.erase(it);
+                return true;
+            }
+        }
 
-        if (!reader)
+        if (nextJobToOpen < static_cast<int>(jobs.size()))
         {
-            job.errorMessage = "Failed to open input file";
-            return false;
+            jobIndex = nextJobToOpen++;
+            segment = 0;
+            isNewJob = true;
+            ++jobsOpening;
+            return true;
         }
 
-        job.progress = 0.5f;
+        if (pendingSegments.empty() && jobsOpening == 0)
+            return false;
 
-        // TODO: Process audio with GPU
-        // - Noise reduction
-        // - Click removal
-        // - Filtering
-        // - Normalization
+        workChanged.wait(lock);
+    }
+}
 
-        job.progress = 1.0f;
-        return true;
+bool GPUBatchProcessor::openJob(int jobIndex, juce::AudioFormatReader* reader)
+{
+    std::string errorMessage;
+
+    if (reader == nullptr)
+        errorMessage = "Failed to open input file";
+    else if (reader->numChannels < 1 || reader->numChannels > static_cast<unsigned int>(maxChannelsPerFile))
+        errorMessage = "Unsupported channel count: " + std::to_string(reader->numChannels);
+
+    auto& state = *fileStates[static_cast<size_t>(jobIndex)];
+
+    if (errorMessage.empty())
+    {
+        state.numChannels = static_cast<int>(reader->numChannels);
+        state.sampleRate = reader->sampleRate;
+        state.lengthInSamples = reader->lengthInSamples;
+        state.numSegments = static_cast<int>(juce::jmax(static_cast<juce::int64>(1),
+                                                        (reader->lengthInSamples + segmentSamples - 1) / segmentSamples));
+        currentJobIndex = jobIndex;
     }
-    catch (const std::exception& e)
+    else
+    {
+        finishJob(jobIndex, false, errorMessage);
+    }
+
+    // The caller decodes segment 0; the rest go to whichever decoder is free
     {
-        job.errorMessage = e.what();
+        std::lock_guard<std::mutex> lock(workLock);
+
+        if (errorMessage.empty())
+            for (int segment = 1; segment < state.numSegments; ++segment)
+                pendingSegments.emplace_back(jobIndex, segment);
+
+        --jobsOpening;
+    }
+
+    workChanged.notify_all();
+    return errorMessage.empty();
+}
+
+bool GPUBatchProcessor::decodeSegment(DeviceLane& lane, juce::AudioFormatReader* reader, SegmentRepair* repair,
+                                      int jobIndex, int segment)
+{
+    const int slot = acquireSlot(lane);
+    if (slot < 0)
         return false;
+
+    const auto& state = *fileStates[static_cast<size_t>(jobIndex)];
+
+    if (reader == nullptr)
+    {
+        // Still goes through, so the slot is released and the encoder moves on
+        auto chunk = std::make_unique<Chunk>();
+        chunk->jobIndex = jobIndex;
+        chunk->segment = segment;
+        chunk->slot = slot;
+        chunk->isFirst = true;
+        chunk->isLast = true;
+        chunk->failed = true;
+        return lane.decodedChunks->push(std::move(chunk));
+    }
+
+    // Reading starts an FFT size early (a multiple of the hop), so the frames
+    // covering the segment match a pass over the whole file. The latency's worth
+    // after the end is the next segment's audio, or silence that flushes the STFT.
+    const juce::int64 segmentStart = static_cast<juce::int64>(segment) * segmentSamples;
+    const juce::int64 segmentEnd = juce::jmin(state.lengthInSamples, segmentStart + segmentSamples);
+    const juce::int64 readStart = juce::jmax(static_cast<juce::int64>(0), segmentStart - segmentPreRoll);
+    const juce::int64 readEnd = segmentEnd + pipelineLatency;
+    const juce::int64 outputStart = segmentStart - readStart + pipelineLatency;
+    const juce::int64 outputEnd = outputStart + (segmentEnd - segmentStart);
+
+    // Click removal needs the whole read range at once, plus what its scan reads past the end
+    if (repair != nullptr)
+    {
+        const juce::int64 scanEnd = juce::jmin(readEnd, state.lengthInSamples);
+        const juce::int64 contextEnd = juce::jmin(scanEnd + repair->clickRemoval.getLatencySamples(), state.lengthInSamples);
+        const int contextLength = static_cast<int>(contextEnd - readStart);
+
+        repair->audio.setSize(state.numChannels, contextLength, false, false, true);
+        reader->read(&repair->audio, 0, contextLength, readStart, true, true);
+
+        repair->clickRemoval.setSampleOffset(readStart);
+        repair->detector.processBufferRegion(repair->clickRemoval, repair->audio, 0, static_cast<int>(scanEnd - readStart));
     }
+
+    juce::int64 position = readStart;
+
+    // At least one chunk always goes out so the segment's slot is released downstream
+    do
+    {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->jobIndex = jobIndex;
+        chunk->segment = segment;
+        chunk->slot = slot;
+        chunk->isFirst = position == readStart;
+        chunk->numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(chunkSamples), readEnd - position));
+        chunk->audio.setSize(state.numChannels, chunkSamples);
+        chunk->audio.clear();
+
+        const juce::int64 available = juce::jmax(static_cast<juce::int64>(0), state.lengthInSamples - position);
+        const int toRead = static_cast<int>(juce::jmin(static_cast<juce::int64>(chunk->numSamples), available));
+
+        if (toRead > 0 && repair != nullptr)
+        {
+            for (int ch = 0; ch < state.numChannels; ++ch)
+                chunk->audio.copyFrom(ch, 0, repair->audio, ch, static_cast<int>(position - readStart), toRead);
+        }
+        else if (toRead > 0)
+        {
+            reader->read(&chunk->audio, 0, toRead, position, true, true);
+        }
+
+        // Drop the pre-roll and latency at the front and the flush at the end
+        const juce::int64 offset = position - readStart;
+        const auto begin = juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(chunk->numSamples), outputStart - offset);
+        const auto end = juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(chunk->numSamples), outputEnd - offset);
+        chunk->outputStart = static_cast<int>(begin);
+        chunk->outputCount = static_cast<int>(end - begin);
+
+        position += chunk->numSamples;
+        chunk->isLast = position >= readEnd;
+
+        if (!lane.decodedChunks->push(std::move(chunk)))
+            return false;
+    }
+    while (position < readEnd && !cancelled);
+
+    return !cancelled;
 }
 
-void GPUBatchProcessor::workerThreadFunction()
+void GPUBatchProcessor::processChunksGPU(DeviceLane& lane)
 {
-    if (gpuEnabled)
-        processJobsGPU();
-    else
+    std::vector<std::unique_ptr<Chunk>> step;
+    std::deque<std::unique_ptr<Chunk>> deferred;
+    std::vector<float*> channelData;
+    std::vector<int> stftChannels;
+
+    const auto inStep = [&step](int slot)
     {
-        for (auto& job : jobs)
+        return std::any_of(step.begin(), step.end(), [slot](const auto& chunk) { return chunk->slot == slot; });
+    };
+
+    for (;;)
+    {
+        // One chunk per slot: a segment's chunks run through its STFT channels in turn.
+        // Chunks of segments already in the step wait, in order, for a later one.
+        step.clear();
+
+        for (auto it = deferred.begin(); it != deferred.end() && static_cast<int>(step.size()) < maxFilesInFlight;)
         {
-            if (cancelled)
+            if (inStep((*it)->slot))
+            {
+                ++it;
+                continue;
+            }
+
+            step.push_back(std::move(*it));
+            it = deferred.erase(it);
+        }
+
+        if (step.empty())
+        {
+            auto chunk = lane.decodedChunks->pop();
+            if (!chunk)
+                break;
+
+            step.push_back(std::move(chunk));
+        }
+
+        while (static_cast<int>(step.size()) < maxFilesInFlight && static_cast<int>(deferred.size()) < decodedQueueLength)
+        {
+            auto chunk = lane.decodedChunks->tryPop();
+            if (!chunk)
                 break;
 
-            processJobCPU(job);
-            job.completed = true;
+            if (inStep(chunk->slot))
+                deferred.push_back(std::move(chunk));
+            else
+                step.push_back(std::move(chunk));
+        }
+
+        if (noiseReductionActive)
+        {
+            channelData.clear();
+            stftChannels.clear();
+            int numSamples = 0;
+
+            for (auto& chunk : step)
+            {
+                const int firstChannel = chunk->slot * maxChannelsPerFile;
+
+                for (int ch = 0; ch < chunk->audio.getNumChannels(); ++ch)
+                {
+                    if (chunk->isFirst)
+                        lane.noiseReduction->resetChannel(firstChannel + ch);
+
+                    channelData.push_back(chunk->audio.getWritePointer(ch));
+                    stftChannels.push_back(firstChannel + ch);
+                }
+
+                numSamples = juce::jmax(numSamples, chunk->numSamples);
+            }
+
+            // Chunks are all chunkSamples long and silent past their end, so the
+            // longest one sets the length and the short ones are padded
+            const double startTime = juce::Time::getMillisecondCounterHiRes();
+            lane.noiseReduction->processChannels(channelData.data(), stftChannels.data(),
+                                                 static_cast<int>(stftChannels.size()), numSamples);
+            lane.busyMicroseconds += static_cast<juce::int64>((juce::Time::getMillisecondCounterHiRes() - startTime) * 1000.0);
+        }
+
+        for (auto& chunk : step)
+        {
+            lane.samplesProcessed += chunk->numSamples;
+
+            // Its STFT channels are done with, so the slot can take the next segment
+            if (chunk->isLast)
+            {
+                ++lane.segmentsProcessed;
+                releaseSlot(lane, chunk->slot);
+            }
+
+            auto& queue = *encoderQueues[static_cast<size_t>(chunk->jobIndex) % encoderQueues.size()];
+            if (!queue.push(std::move(chunk)))
+                return;
         }
     }
 
-    processing = false;
+    // The last lane out lets the encoders drain and finish
+    if (--activeGPUStages == 0)
+        for (auto& queue : encoderQueues)
+            queue->close();
+}
 
-    if (onAllJobsComplete)
-        onAllJobsComplete();
+void GPUBatchProcessor::encodeChunks(ChunkQueue& queue)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    while (auto chunk = queue.pop())
+    {
+        const int jobIndex = chunk->jobIndex;
+        auto& state = *fileStates[static_cast<size_t>(jobIndex)];
+
+        // Segments finish on different devices in any order; write them in file order
+        if (chunk->segment != state.segmentsWritten)
+        {
+            state.earlyChunks[chunk->segment].push_back(std::move(chunk));
+            continue;
+        }
+
+        writeChunk(*chunk, formatManager);
+        bool segmentDone = chunk->isLast;
+
+        while (segmentDone)
+        {
+            {
+                std::lock_guard<std::mutex> lock(workLock);
+                ++state.segmentsWritten;
+            }
+            workChanged.notify_all();
+
+            if (state.segmentsWritten == state.numSegments)
+            {
+                state.writer.reset(); // Flushes and closes the file
+                finishJob(jobIndex, !state.failed, state.errorMessage);
+                break;
+            }
+
+            auto early = state.earlyChunks.find(state.segmentsWritten);
+            if (early == state.earlyChunks.end())
+                break;
+
+            // Whatever arrived of the next segment; the rest of it comes straight here
+            auto waiting = std::move(early->second);
+            state.earlyChunks.erase(early);
+            segmentDone = false;
+
+            for (auto& waitingChunk : waiting)
+            {
+                writeChunk(*waitingChunk, formatManager);
+                segmentDone = waitingChunk->isLast;
+            }
+        }
+    }
 }
 
-bool GPUBatchProcessor::initializeGPU()
+void GPUBatchProcessor::writeChunk(Chunk& chunk, juce::AudioFormatManager& formatManager)
 {
-    return GPUBackend::isAvailable();
+    auto& job = jobs[static_cast<size_t>(chunk.jobIndex)];
+    auto& state = *fileStates[static_cast<size_t>(chunk.jobIndex)];
+
+    const auto fail = [&state](const std::string& message)
+    {
+        state.failed = true;
+        state.errorMessage = message;
+        state.writer.reset();
+    };
+
+    if (chunk.failed)
+    {
+        if (!state.failed)
+            fail("Failed to open input file");
+
+        return;
+    }
+
+    if (chunk.segment == 0 && chunk.isFirst)
+    {
+        auto* format = formatManager.findFormatForFileExtension(job.outputFile.getFileExtension());
+        job.outputFile.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> outputStream(job.outputFile.createOutputStream());
+
+        if (format == nullptr)
+            fail("Unsupported output format");
+        else if (outputStream == nullptr)
+            fail("Failed to open output file");
+        else
+        {
+            state.writer.reset(format->createWriterFor(outputStream.get(), state.sampleRate,
+                                                       static_cast<unsigned int>(state.numChannels),
+                                                       settings.outputBitDepth, {}, 0));
+
+            if (state.writer)
+                outputStream.release(); // The writer owns the stream now
+            else
+                fail("Failed to create writer");
+        }
+    }
+
+    if (state.writer)
+    {
+        if (chunk.outputCount > 0 && !state.writer->writeFromAudioSampleBuffer(chunk.audio, chunk.outputStart, chunk.outputCount))
+            fail("Failed to write output file");
+        else
+            state.samplesWritten += chunk.outputCount;
+
+        if (state.lengthInSamples > 0)
+        {
+            job.progress = static_cast<float>(state.samplesWritten) / static_cast<float>(state.lengthInSamples);
+
+            if (onProgressUpdate)
+                onProgressUpdate(chunk.jobIndex, job.progress);
+        }
+    }
 }
 
-void GPUBatchProcessor::shutdownGPU()
+void GPUBatchProcessor::finishJob(int jobIndex, bool success, const std::string& errorMessage)
+{
+    auto& job = jobs[static_cast<size_t>(jobIndex)];
+    job.success = success;
+    job.errorMessage = errorMessage;
+    job.progress = 1.0f;
+    job.completed = true;
+
+    if (onJobComplete)
+        onJobComplete(jobIndex, job.success, job.errorMessage);
+}
+
+void GPUBatchProcessor::closeQueues()
+{
+    for (auto& lane : lanes)
+        if (lane->decodedChunks)
+            lane->decodedChunks->close();
+
+    for (auto& queue : encoderQueues)
+        queue->close();
+}
+
+int GPUBatchProcessor::acquireSlot(DeviceLane& lane)
+{
+    std::unique_lock<std::mutex> lock(lane.slotLock);
+    lane.slotFreed.wait(lock, [this, &lane] { return cancelled || !lane.freeSlots.empty(); });
+
+    if (cancelled)
+        return -1;
+
+    const int slot = lane.freeSlots.back();
+    lane.freeSlots.pop_back();
+    return slot;
+}
+
+void GPUBatchProcessor::releaseSlot(DeviceLane& lane, int slot)
 {
-    if (gpuEnabled)
     {
-        gpuNoiseReduction.reset();
-        gpuFileBuffers.clear();
-        gpuEnabled = false;
+        std::lock_guard<std::mutex> lock(lane.slotLock);
+        lane.freeSlots.push_back(slot);
     }
+
+    lane.slotFreed.notify_one();
+}
+
+bool GPUBatchProcessor::initializeGPU()
+{
+    // The batch processor may be the first GPU user: the lanes and the device
+    // spread need the backend up before they are made
+    return GPUBackend::initialize() && GPUBackend::isAvailable();
+}
+
+void GPUBatchProcessor::shutdownGPU()
+{
+    lanes.clear();
+    gpuEnabled = false;
 }
@@ -2,10 +2,15 @@
 
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <vector>
 #include <functional>
 #include "GPUBackend.h"
 #include "GPUNoiseReduction.h"
+#include "GPUClickDetector.h"
 
 /**
  * GPU-Accelerated Batch Processing
@@ -19,6 +24,32 @@
  * - Progress tracking and cancellation
  * - Memory-efficient streaming for large files
  *
+ * Files stream through a three-stage pipeline, so decoding, GPU work and
+ * encoding all run at once:
+ * - A pool of decoder threads reads the work in fixed-size chunks into a
+ *   bounded queue.
+ * - One GPU thread takes a chunk from each segment that has one ready and
+ *   processes them all in a single batch; every segment in flight owns its
+ *   own STFT channels (a slot) on the GPUNoiseReduction.
+ * - A pool of encoder threads writes the chunks; each file sticks to one
+ *   encoder, so its chunks stay in order.
+ * Memory depends on the chunk size and queue lengths, never on file length.
+ * onProgressUpdate and onJobComplete are called from the pipeline threads.
+ *
+ * Every GPU gets its own decoders, queue, slots, GPU thread and
+ * GPUNoiseReduction (a lane). Files are split into segments of
+ * segmentSamples, and the lanes' decoders pull segments from one shared list
+ * as their slots come free, so a faster device takes on more of the work and
+ * one long file is spread across all of them. A segment is read from an
+ * FFT size earlier than its start, so the STFT enters it in the same state as
+ * a single pass over the whole file and the output does not depend on how it
+ * was split. getDeviceUsage() reports how busy each device was.
+ *
+ * With click removal enabled, each decoder reads a whole segment first and
+ * GPUClickDetector finds its clicks on the lane's device before the CPU
+ * repairs them; only a click right at a segment edge can differ from a scan
+ * of the whole file.
+ *
  * Performance example (RX 9070):
  * - 10 vinyl album sides (60 min each)
  * - CPU: ~3 hours total
@@ -91,13 +122,13 @@ public:
     void cancelProcessing();
 
     /** Check if processing is active */
-    bool isProcessing() const { return processing; }
+    bool isProcessing() const { return processing.load(); }
 
     /** Get overall progress (0.0 to 1.0) */
     float getOverallProgress() const;
 
-    /** Get current job being processed */
-    int getCurrentJobIndex() const { return currentJobIndex; }
+    /** Get the most recently started job; several may be in flight */
+    int getCurrentJobIndex() const { return currentJobIndex.load(); }
 
     /** Get total number of jobs */
     int getTotalJobs() const { return static_cast<int>(jobs.size()); }
@@ -108,9 +139,20 @@ public:
     /** Check if GPU is being used */
     bool isUsingGPU() const { return gpuEnabled; }
 
-    /** Get GPU info */
+    /** Get GPU info; lists every device in use */
     std::string getGPUInfo() const;
 
+    struct DeviceUsage
+    {
+        std::string deviceName;
+        float utilization = 0.0f;           // Share of the run spent processing, 0.0 to 1.0
+        juce::int64 samplesProcessed = 0;   // Per channel, including pre-roll
+        int segmentsProcessed = 0;
+    };
+
+    /** Per-device figures for the current or last run */
+    std::vector<DeviceUsage> getDeviceUsage() const;
+
     //==============================================================================
     /** Callback for progress updates */
     std::function<void(int jobIndex, float progress)> onProgressUpdate;
@@ -123,10 +165,25 @@ public:
 
 private:
     //==============================================================================
-    void processJobsGPU();
-    void processJobCPU(FileJob& job);
-    bool processFileGPU(FileJob& job);
+    struct Chunk;
+    struct FileState;
+    struct DeviceLane;
+    struct SegmentRepair;
+    class ChunkQueue;
+
     void workerThreadFunction();
+    void decodeJobs(DeviceLane& lane);
+    bool takeWork(int& jobIndex, int& segment, bool& isNewJob);
+    bool openJob(int jobIndex, juce::AudioFormatReader* reader);
+    bool decodeSegment(DeviceLane& lane, juce::AudioFormatReader* reader, SegmentRepair* repair, int jobIndex, int segment);
+    void processChunksGPU(DeviceLane& lane);
+    void encodeChunks(ChunkQueue& queue);
+    void writeChunk(Chunk& chunk, juce::AudioFormatManager& formatManager);
+    void finishJob(int jobIndex, bool success, const std::string& errorMessage);
+    void closeQueues();
+
+    int acquireSlot(DeviceLane& lane);
+    void releaseSlot(DeviceLane& lane, int slot);
 
     bool initializeGPU();
     void shutdownGPU();
@@ -135,17 +192,44 @@ private:
     std::vector<FileJob> jobs;
     ProcessingSettings settings;
 
-    bool processing = false;
-    bool cancelled = false;
-    int currentJobIndex = 0;
+    std::atomic<bool> processing { false };
+    std::atomic<bool> cancelled { false };
+    std::atomic<int> currentJobIndex { 0 };
 
-    // GPU resources
+    // GPU resources: one lane per device, or a single CPU lane
     bool gpuEnabled = false;
-    std::unique_ptr<GPUNoiseReduction> gpuNoiseReduction;
-    std::vector<std::unique_ptr<GPUBackend::GPUBuffer>> gpuFileBuffers;
+    std::vector<std::unique_ptr<DeviceLane>> lanes;
+    bool noiseReductionActive = false;
+    int pipelineLatency = 0;
+    int segmentPreRoll = 0;
+
+    // Pipeline: chunk size, segments in flight and queue lengths bound the memory used
+    static constexpr int chunkSamples = 65536;
+    static constexpr int segmentSamples = 16 * chunkSamples;
+    static constexpr int maxFilesInFlight = 4;     // Slots per lane
+    static constexpr int maxChannelsPerFile = 8;   // STFT channels per slot
+    static constexpr int decodedQueueLength = 16;
+    static constexpr int encoderQueueLength = 4;
+
+    std::vector<std::unique_ptr<ChunkQueue>> encoderQueues;
+    std::vector<std::unique_ptr<FileState>> fileStates;
+    int decodersPerLane = 1;
+    std::atomic<int> activeGPUStages { 0 };
+
+    // Work: segments of open files, then new jobs; guarded by workLock
+    std::mutex workLock;
+    std::condition_variable workChanged;
+    std::deque<std::pair<int, int>> pendingSegments;   // (jobIndex, segment)
+    int nextJobToOpen = 0;
+    int jobsOpening = 0;
+    int maxSegmentsAhead = 2;                          // Beyond the oldest one not yet written
+
+    std::atomic<double> runStartTime { 0.0 };
+    std::atomic<double> runEndTime { 0.0 };
 
     // Threading
     std::unique_ptr<juce::Thread> workerThread;
+    std::vector<std::unique_ptr<juce::Thread>> stageThreads;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GPUBatchProcessor)
 };
@@ -0,0 +1,294 @@
+#include "GPUClickDetector.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+
+//==============================================================================
+GPUClickDetector::GPUClickDetector()
+{
+    device = GPUBackend::getCurrentDevice();
+    gpuEnabled = initializeGPU();
+
+    if (!gpuEnabled)
+        shutdownGPU();
+}
+
+GPUClickDetector::~GPUClickDetector()
+{
+    shutdownGPU();
+}
+
+//==============================================================================
+int GPUClickDetector::processBufferRegion(ClickRemoval& clickRemoval, juce::AudioBuffer<float>& buffer,
+                                          int startSample, int numSamples, std::function<bool(double)> progressCallback)
+{
+    const int totalSamples = buffer.getNumSamples();
+    startSample = juce::jlimit(0, totalSamples, startSample);
+    numSamples = juce::jlimit(0, totalSamples - startSample, numSamples);
+
+    if (numSamples == 0)
+        return 0;
+
+    // Samples past the region are context, as far as the CPU scan would read them
+    const int channelsToProcess = juce::jmin(buffer.getNumChannels(), clickRemoval.getNumChannels());
+    const int numAvailable = juce::jmin(totalSamples - startSample, numSamples + clickRemoval.getLatencySamples());
+    const int segmentSize = ClickRemoval::getRmsSegmentSize();
+    const int numSegments = (numSamples + segmentSize - 1) / segmentSize;
+    const int64_t regionStartPosition = clickRemoval.getSampleOffset();
+    int totalClicks = 0;
+
+    if (gpuEnabled)
+        GPUBackend::setCurrentDevice(device);
+
+    for (int channel = 0; channel < channelsToProcess; ++channel)
+    {
+        if (progressCallback != nullptr && !progressCallback(channel / static_cast<double>(channelsToProcess)))
+            break;
+
+        float* samples = buffer.getWritePointer(channel, startSample);
+        residentBlock = -1;
+
+        segmentEnergies.resize(static_cast<size_t>(numSegments));
+        bool onGPU = gpuEnabled && computeEnergiesGPU(samples, numAvailable, numSegments);
+
+        if (!onGPU)
+            computeEnergiesCPU(samples, numAvailable, numSegments);
+
+        segmentRms.resize(segmentEnergies.size());
+        segmentThresholds.resize(segmentEnergies.size());
+        ClickRemoval::computeSegmentRms(segmentEnergies.data(), segmentEnergies.size(), segmentRms.data());
+
+        for (size_t segment = 0; segment < segmentRms.size(); ++segment)
+            segmentThresholds[segment] = clickRemoval.getDetectionThreshold(segmentRms[segment]);
+
+        onGPU = onGPU && findCandidatesGPU(samples, numSamples, numAvailable);
+
+        if (!onGPU)
+            findCandidatesCPU(samples, numSamples);
+
+        totalClicks += clickRemoval.verifyCandidates(samples, numSamples, numAvailable, candidates, segmentRms, channel);
+    }
+
+    if (progressCallback != nullptr)
+        progressCallback(1.0);
+
+    clickRemoval.setSampleOffset(regionStartPosition + numSamples);
+    return totalClicks;
+}
+
+//==============================================================================
+bool GPUClickDetector::computeEnergiesGPU(const float* samples, int numAvailable, int numSegments)
+{
+    const int segmentSize = ClickRemoval::getRmsSegmentSize();
+    const int paddedLength = numSegments * segmentSize;
+
+    for (int blockStart = 0; blockStart < paddedLength; blockStart += blockSamples)
+    {
+        const int blockLength = juce::jmin(blockSamples, paddedLength - blockStart);
+        const int blockSegments = blockLength / segmentSize;
+
+        if (!uploadBlock(samples, numAvailable, blockStart, blockLength))
+            return false;
+
+        energyKernel->setArgument(0, deviceSamples);
+        energyKernel->setArgument(1, deviceEnergies);
+        energyKernel->setArgument(2, segmentSize);
+        energyKernel->setArgument(3, blockSegments);
+
+        const size_t globalWorkSize = (static_cast<size_t>(blockSegments) + localWorkSize - 1) / localWorkSize * localWorkSize;
+
+        if (!energyKernel->execute(globalWorkSize, localWorkSize)
+            || !deviceEnergies.download(segmentEnergies.data() + blockStart / segmentSize,
+                                        static_cast<size_t>(blockSegments) * sizeof(float)))
+        {
+            juce::Logger::writeToLog("Click detection: segment energy kernel failed, using the CPU: " + GPUBackend::getLastError());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void GPUClickDetector::computeEnergiesCPU(const float* samples, int numAvailable, int numSegments)
+{
+    const int segmentSize = ClickRemoval::getRmsSegmentSize();
+
+    for (int segment = 0; segment < numSegments; ++segment)
+    {
+        float energy = 0.0f;
+
+        for (int i = segment * segmentSize; i < (segment + 1) * segmentSize; ++i)
+        {
+            const float sample = i < numAvailable ? samples[i] : 0.0f;
+            energy += sample * sample;
+        }
+
+        segmentEnergies[static_cast<size_t>(segment)] = energy;
+    }
+}
+
+bool GPUClickDetector::findCandidatesGPU(const float* samples, int numSamples, int numAvailable)
+{
+    const int segmentSize = ClickRemoval::getRmsSegmentSize();
+    candidates.clear();
+
+    for (int blockStart = 0; blockStart < numSamples; blockStart += blockSamples)
+    {
+        const int blockLength = juce::jmin(blockSamples, numSamples - blockStart);
+        const int firstSegment = blockStart / segmentSize;
+        const int blockSegments = (blockLength + segmentSize - 1) / segmentSize;
+
+        if (!uploadBlock(samples, numAvailable, blockStart, blockLength)
+            || !deviceThresholds.upload(segmentThresholds.data() + firstSegment, static_cast<size_t>(blockSegments) * sizeof(float)))
+            return false;
+
+        const size_t globalWorkSize = (static_cast<size_t>(blockLength) + localWorkSize - 1) / localWorkSize * localWorkSize;
+        int found = 0;
+
+        // A dense block overflows the list; it is run again with room for every crossing
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            const int zero = 0;
+
+            if (found > candidateCapacity)
+            {
+                if (!deviceCandidates.allocate(static_cast<size_t>(found) * sizeof(int)))
+                    return false;
+
+                candidateCapacity = found;
+            }
+
+            candidateKernel->setArgument(0, deviceSamples);
+            candidateKernel->setArgument(1, deviceThresholds);
+            candidateKernel->setArgument(2, deviceCandidates);
+            candidateKernel->setArgument(3, deviceCount);
+            candidateKernel->setArgument(4, segmentSize);
+            candidateKernel->setArgument(5, blockLength);
+            candidateKernel->setArgument(6, candidateCapacity);
+
+            if (!deviceCount.upload(&zero, sizeof(int))
+                || !candidateKernel->execute(globalWorkSize, localWorkSize)
+                || !deviceCount.download(&found, sizeof(int)))
+            {
+                juce::Logger::writeToLog("Click detection: candidate kernel failed, using the CPU: " + GPUBackend::getLastError());
+                return false;
+            }
+
+            if (found <= candidateCapacity)
+                break;
+        }
+
+        blockCandidates.resize(static_cast<size_t>(found));
+
+        if (found > 0 && !deviceCandidates.download(blockCandidates.data(), static_cast<size_t>(found) * sizeof(int)))
+            return false;
+
+        // Workgroups append in any order
+        std::sort(blockCandidates.begin(), blockCandidates.end());
+
+        for (const int position : blockCandidates)
+            candidates.push_back(blockStart + position);
+    }
+
+    return true;
+}
+
+void GPUClickDetector::findCandidatesCPU(const float* samples, int numSamples)
+{
+    const int segmentSize = ClickRemoval::getRmsSegmentSize();
+    candidates.clear();
+
+    // The stream starts from silence
+    float previous2 = 0.0f;
+    float previous1 = 0.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float later = samples[i] - previous1;
+        const float earlier = previous1 - previous2;
+
+        if (std::abs(later - earlier) > segmentThresholds[static_cast<size_t>(i / segmentSize)])
+            candidates.push_back(i);
+
+        previous2 = previous1;
+        previous1 = samples[i];
+    }
+}
+
+bool GPUClickDetector::uploadBlock(const float* samples, int numAvailable, int blockStart, int blockLength)
+{
+    if (residentBlock == blockStart)
+        return true;
+
+    // Whole segments, zero past what the scan may read, with the two samples before the block first
+    const int segmentSize = ClickRemoval::getRmsSegmentSize();
+    const int paddedLength = (blockLength + segmentSize - 1) / segmentSize * segmentSize;
+    hostBlock.assign(static_cast<size_t>(guardSamples + paddedLength), 0.0f);
+
+    for (int i = -guardSamples; i < paddedLength; ++i)
+    {
+        const int source = blockStart + i;
+        if (source >= 0 && source < numAvailable)
+            hostBlock[static_cast<size_t>(guardSamples + i)] = samples[source];
+    }
+
+    if (!deviceSamples.upload(hostBlock.data(), hostBlock.size() * sizeof(float)))
+    {
+        residentBlock = -1;
+        return false;
+    }
+
+    residentBlock = blockStart;
+    return true;
+}
+
+//==============================================================================
+bool GPUClickDetector::initializeGPU()
+{
+    if (!GPUBackend::initialize() || !GPUBackend::isAvailable())
+        return false;
+
+    const std::string kernelSource = GPUBackend::loadKernelSource("click_detection");
+
+    if (kernelSource.empty())
+    {
+        juce::Logger::writeToLog("Failed to load click detection kernel source");
+        return false;
+    }
+
+    energyKernel = std::make_unique<GPUBackend::GPUKernel>();
+    candidateKernel = std::make_unique<GPUBackend::GPUKernel>();
+
+    if (!energyKernel->loadFromSource(kernelSource, "clickSegmentEnergy")
+        || !candidateKernel->loadFromSource(kernelSource, "clickCandidates"))
+    {
+        juce::Logger::writeToLog("Failed to compile click detection kernels: " + GPUBackend::getLastError());
+        return false;
+    }
+
+    // Sized for a full block; the candidate list grows if a block needs more
+    const int segmentsPerBlock = blockSamples / ClickRemoval::getRmsSegmentSize();
+    candidateCapacity = blockSamples / 16;
+
+    return deviceSamples.allocate(static_cast<size_t>(guardSamples + blockSamples) * sizeof(float))
+        && deviceEnergies.allocate(static_cast<size_t>(segmentsPerBlock) * sizeof(float))
+        && deviceThresholds.allocate(static_cast<size_t>(segmentsPerBlock) * sizeof(float))
+        && deviceCandidates.allocate(static_cast<size_t>(candidateCapacity) * sizeof(int))
+        && deviceCount.allocate(sizeof(int));
+}
+
+void GPUClickDetector::shutdownGPU()
+{
+    deviceSamples.release();
+    deviceEnergies.release();
+    deviceThresholds.release();
+    deviceCandidates.release();
+    deviceCount.release();
+
+    if (energyKernel) energyKernel->release();
+    if (candidateKernel) candidateKernel->release();
+
+    energyKernel.reset();
+    candidateKernel.reset();
+    gpuEnabled = false;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "GPUBackend.h"
+#include "../DSP/ClickRemoval.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * GPU-Accelerated Click Detection
+ *
+ * Whole-region version of ClickRemoval::processBufferRegion(). The parts of
+ * the scan that look at every sample run on the GPU; the rest stays on the
+ * CPU:
+ * 1. GPU: sum of squares of every RMS segment
+ * 2. CPU: running RMS and threshold per segment (ClickRemoval's own recurrence)
+ * 3. GPU: second-derivative residual of every sample against its threshold,
+ *    compacted into a short list of candidate positions
+ * 4. CPU: ClickRemoval::verifyCandidates() runs the peak, periodicity and width
+ *    checks on the candidates only, and repairs them if removal is enabled
+ *
+ * Detection gives the same clicks as the CPU scan, stored and published
+ * through the ClickRemoval passed in, so CorrectionListView and
+ * WaveformDisplay read them from the same ClickStore. Blocks of blockSamples
+ * bound the device memory used, whatever the file length.
+ *
+ * An instance runs on the device that was current when it was constructed and
+ * makes that device current on the calling thread whenever it uses the GPU.
+ * Without a GPU, or if a GPU call fails, the same steps run on the CPU.
+ */
+class GPUClickDetector
+{
+public:
+    GPUClickDetector();
+    ~GPUClickDetector();
+
+    /** Check if GPU acceleration is active */
+    bool isUsingGPU() const { return gpuEnabled; }
+
+    /**
+     * Scans buffer[startSample, startSample + numSamples) with clickRemoval's
+     * settings, which must be prepared for the buffer's channels. Clicks are
+     * reported relative to its sample offset, which then moves past the region.
+     * The optional callback receives progress (0-1) and returns false to cancel.
+     * Returns the number of clicks detected.
+     */
+    int processBufferRegion(ClickRemoval& clickRemoval, juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                            std::function<bool(double)> progressCallback = nullptr);
+
+private:
+    //==============================================================================
+    bool initializeGPU();
+    void shutdownGPU();
+
+    /** Fills segmentEnergies for samples[0, numSegments * segment size), zero padded past numAvailable */
+    bool computeEnergiesGPU(const float* samples, int numAvailable, int numSegments);
+    void computeEnergiesCPU(const float* samples, int numAvailable, int numSegments);
+
+    /** Fills candidates in [0, numSamples), sorted, from segmentThresholds */
+    bool findCandidatesGPU(const float* samples, int numSamples, int numAvailable);
+    void findCandidatesCPU(const float* samples, int numSamples);
+
+    /** Prepares one block on the device: two guard samples, then the block, zero padded */
+    bool uploadBlock(const float* samples, int numAvailable, int blockStart, int blockLength);
+
+    //==============================================================================
+    static constexpr int blockSamples = 1 << 22;   // Samples per upload (16 MB)
+    static constexpr int guardSamples = 2;         // The residual looks two samples back
+    static constexpr int localWorkSize = 256;
+
+    bool gpuEnabled = false;
+    int device = 0;
+
+    std::unique_ptr<GPUBackend::GPUKernel> energyKernel;
+    std::unique_ptr<GPUBackend::GPUKernel> candidateKernel;
+
+    GPUBackend::GPUBuffer deviceSamples;
+    GPUBackend::GPUBuffer deviceEnergies;
+    GPUBackend::GPUBuffer deviceThresholds;
+    GPUBackend::GPUBuffer deviceCandidates;
+    GPUBackend::GPUBuffer deviceCount;
+    int candidateCapacity = 0;
+    int residentBlock = -1;                        // Block start already in deviceSamples
+
+    // Host side, reused from channel to channel
+    std::vector<float> hostBlock;
+    std::vector<float> segmentEnergies;
+    std::vector<float> segmentRms;
+    std::vector<float> segmentThresholds;
+    std::vector<int> candidates;
+    std::vector<int> blockCandidates;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GPUClickDetector)
+};
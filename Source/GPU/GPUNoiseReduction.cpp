@@ -1,15 +1,17 @@
 #include "GPUNoiseReduction.h"
 #include <juce_core/juce_core.h>
+#include <mutex>
 
 GPUNoiseReduction::GPUNoiseReduction()
 {
+    device = GPUBackend::getCurrentDevice();
     gpuEnabled = initializeGPU();
 
     if (gpuEnabled)
     {
         juce::Logger::writeToLog("GPU Noise Reduction: Initialized successfully");
         juce::Logger::writeToLog("GPU Backend: " + GPUBackend::getBackendName());
-        auto deviceInfo = GPUBackend::getDeviceInfo();
+        auto deviceInfo = GPUBackend::getDeviceInfo(device);
         juce::Logger::writeToLog("GPU Device: " + deviceInfo.name + " (" + deviceInfo.vendor + ")");
     }
     else
@@ -28,51 +30,88 @@ void GPUNoiseReduction::prepare(const juce::dsp::ProcessSpec& spec)
 {
     sampleRate = spec.sampleRate;
     numChannels = spec.numChannels;
+    maxBlockSize = static_cast<int>(juce::jmax(1u, spec.maximumBlockSize));
+    processingPath = ProcessingPath::cpu;
+    calibration = {};
 
     // Initialize FFT parameters
     fftSize = 1 << fftOrder;
     hopSize = fftSize / 4; // 75% overlap
 
-    // Allocate host buffers
-    hostInputBuffer.resize(fftSize * 2 * static_cast<size_t>(numChannels));
-    hostOutputBuffer.resize(fftSize * 2 * static_cast<size_t>(numChannels));
-    overlapBuffer.setSize(static_cast<int>(numChannels), fftSize);
-    overlapBuffer.clear();
+    // Streaming STFT framing (shared with the CPU module)
+    stft.prepare(fftOrder, hopSize, static_cast<int>(numChannels));
+    cpuSpectralGain.prepare(fftSize);
+    captureBuffer.resize(static_cast<size_t>(fftSize * 2));
+
+    // Batch every hop of a block for all channels, in a power of two so the plans cover it
+    const int framesPerBlock = static_cast<int>(spec.maximumBlockSize) / hopSize + 1;
+    maxBatchFrames = juce::jmin(maxFramesPerBatch, juce::nextPowerOfTwo(framesPerBlock * static_cast<int>(numChannels)));
+    maxBatchFrames = juce::jmax(maxBatchFrames, static_cast<int>(numChannels));
+
+    if (gpuEnabled)
+    {
+        GPUBackend::setCurrentDevice(device);
+
+        // Our previous buffers go back to the pool first, so they count towards what is available
+        transferLanes.clear();
+        gpuNoiseProfileBuffer.reset();
+        deviceAnalysisWindow.release();
+        deviceSynthesisWindow.release();
+        deviceProfileSum.release();
+
+        // Shrink the batch to fit the device memory budget rather than give up on the GPU
+        const size_t bytesPerFrame = static_cast<size_t>(numTransferLanes)
+                                     * (static_cast<size_t>(fftSize) * sizeof(float)              // Device frames
+                                        + static_cast<size_t>(fftSize / 2 + 1) * 2 * sizeof(float) // Device spectra
+                                        + static_cast<size_t>(fftSize) * sizeof(float));           // Spans, at most
+        const size_t available = GPUBackend::getAvailableMemoryBudget();
+
+        while (maxBatchFrames > static_cast<int>(numChannels)
+               && static_cast<size_t>(maxBatchFrames) * bytesPerFrame > available)
+            maxBatchFrames = juce::jmax(static_cast<int>(numChannels), maxBatchFrames / 2);
+    }
+
+    maxFramesPerChannel = juce::jmax(1, maxBatchFrames / static_cast<int>(numChannels));
+    const size_t spanBufferSize = static_cast<size_t>(numChannels) * static_cast<size_t>(stft.getSpanLength(maxFramesPerChannel));
+    hostInputSpans.resize(spanBufferSize);
+    hostOutputSpans.resize(spanBufferSize);
+    cpuFrame.resize(static_cast<size_t>(fftSize * 2));
+    channelPointers.resize(numChannels);
 
     // Initialize noise profile
     noiseProfile.resize(fftSize / 2 + 1, 0.0f);
     profileCaptured = false;
+    profileOnDevice = false;
+    capturingOnDevice = false;
+    lastProfileWriter = nullptr;
 
     if (gpuEnabled)
     {
-        // Create GPU FFT plan
-        gpuFFT = std::make_unique<GPUBackend::GPUFFT>();
-        if (!gpuFFT->createPlan(fftSize, static_cast<int>(numChannels)))
+        const size_t profileBytes = static_cast<size_t>(fftSize / 2 + 1) * sizeof(float);
+        gpuNoiseProfileBuffer = std::make_unique<GPUBackend::GPUBuffer>();
+
+        if (!createTransferLanes() || !uploadWindows()
+            || !gpuNoiseProfileBuffer->allocate(profileBytes) || !deviceProfileSum.allocate(profileBytes))
         {
-            juce::Logger::writeToLog("GPU FFT plan creation failed, falling back to CPU");
+            juce::Logger::writeToLog("GPU buffer, stream or FFT plan creation failed, falling back to CPU");
+            transferLanes.clear();
             gpuEnabled = false;
             return;
         }
 
-        // Allocate GPU buffers
-        gpuInputBuffer = std::make_unique<GPUBackend::GPUBuffer>();
-        gpuOutputBuffer = std::make_unique<GPUBackend::GPUBuffer>();
-        gpuNoiseProfileBuffer = std::make_unique<GPUBackend::GPUBuffer>();
-
-        size_t bufferSize = fftSize * 2 * numChannels * sizeof(float); // Complex data
-        gpuInputBuffer->allocate(bufferSize);
-        gpuOutputBuffer->allocate(bufferSize);
-        gpuNoiseProfileBuffer->allocate((fftSize / 2 + 1) * sizeof(float));
-
         juce::Logger::writeToLog("GPU Noise Reduction: Buffers allocated (FFT size: " +
-                                 juce::String(fftSize) + ")");
+                                 juce::String(fftSize) + ", up to " + juce::String(maxBatchFrames) + " frames per batch, "
+                                 + juce::String(numTransferLanes) + " streams)");
+
+        calibrateDispatch();
     }
 }
 
 void GPUNoiseReduction::reset()
 {
-    overlapBuffer.clear();
+    stft.reset();
     isCapturingProfile = false;
+    capturingOnDevice = false;
     profileCaptureFrames = 0;
 }
 
@@ -80,31 +119,67 @@ void GPUNoiseReduction::process(juce::dsp::ProcessContextReplacing<float>& conte
 {
     auto& block = context.getOutputBlock();
 
-    // Capture profile if requested
+    // Capture profile if requested (audio passes through delayed but unchanged)
     if (isCapturingProfile)
     {
-        if (gpuEnabled)
+        if (isUsingGPU() && !transferLanes.empty() && profileCaptureKernel)
             captureProfileGPU(block);
         else
-            processCPUFallback(block);
+            captureProfileFromBlock(block);
         return;
     }
 
-    // Bypass if no profile or zero reduction
+    const int channelsToProcess = juce::jmin(static_cast<int>(block.getNumChannels()), stft.getNumChannels());
+
+    for (int channel = 0; channel < channelsToProcess; ++channel)
+        channelPointers[static_cast<size_t>(channel)] = block.getChannelPointer(static_cast<size_t>(channel));
+
+    processChannels(channelPointers.data(), nullptr, channelsToProcess, static_cast<int>(block.getNumSamples()));
+}
+
+void GPUNoiseReduction::processChannels(float* const* channelData, const int* stftChannels,
+                                        int numChannelsToProcess, int numSamples)
+{
+    const auto stftChannel = [stftChannels](int i) { return stftChannels != nullptr ? stftChannels[i] : i; };
+
+    // Bypass if no profile or zero reduction; keep the STFT latency constant
     if (!profileCaptured || reductionAmount <= 0.0f)
+    {
+        for (int i = 0; i < numChannelsToProcess; ++i)
+            stft.processBypassed(channelData[i], numSamples, stftChannel(i));
         return;
+    }
 
-    // Process with GPU or CPU
-    if (gpuEnabled)
-        processGPU(block);
-    else
-        processCPUFallback(block);
+    if (gpuEnabled && processingPath == ProcessingPath::gpu && !transferLanes.empty() && spectralSubtractionKernel)
+    {
+        processBlockGPU(channelData, stftChannels, numChannelsToProcess, numSamples);
+        return;
+    }
+
+    // CPU-based spectral subtraction on the shared STFT engine
+    for (int i = 0; i < numChannelsToProcess; ++i)
+        stft.processTimeFrames(channelData[i], numSamples, stftChannel(i),
+                               [this](float* frame, int) { processFrameCPU(frame, true); });
+}
+
+void GPUNoiseReduction::processBlockGPU(float* const* channelData, const int* stftChannels,
+                                        int numChannelsToProcess, int numSamples)
+{
+    GPUBackend::setCurrentDevice(device);
+    stft.processSpanBatches(channelData, stftChannels, numChannelsToProcess, numSamples,
+                            hostInputSpans.data(), hostOutputSpans.data(), maxFramesPerChannel,
+                            [this](const float* inputSpans, float* outputSpans, const int* framesPerChannel,
+                                   int numSpans, int spanStride)
+                            {
+                                processSpansGPU({ inputSpans, outputSpans, spanStride }, framesPerChannel, numSpans);
+                            });
 }
 
 //==============================================================================
 void GPUNoiseReduction::captureProfile()
 {
     isCapturingProfile = true;
+    capturingOnDevice = false;
     profileCaptureFrames = 0;
     std::fill(noiseProfile.begin(), noiseProfile.end(), 0.0f);
 }
@@ -129,7 +204,7 @@ void GPUNoiseReduction::setFFTSize(int size)
         juce::dsp::ProcessSpec spec;
         spec.sampleRate = sampleRate;
         spec.numChannels = numChannels;
-        spec.maximumBlockSize = static_cast<juce::uint32>(fftSize);
+        spec.maximumBlockSize = static_cast<juce::uint32>(maxBlockSize > 0 ? maxBlockSize : fftSize);
         prepare(spec);
     }
 }
@@ -138,6 +213,36 @@ void GPUNoiseReduction::clearProfile()
 {
     std::fill(noiseProfile.begin(), noiseProfile.end(), 0.0f);
     profileCaptured = false;
+    profileOnDevice = false;
+}
+
+bool GPUNoiseReduction::setNoiseProfile(const std::vector<float>& profile)
+{
+    if (profile.size() != static_cast<size_t>(fftSize / 2 + 1))
+        return false;
+
+    noiseProfile = profile;
+    profileCaptured = true;
+    isCapturingProfile = false;
+    capturingOnDevice = false;
+    uploadNoiseProfile();
+    return true;
+}
+
+const std::vector<float>& GPUNoiseReduction::getNoiseProfile()
+{
+    // The only transfer back: everything the GPU does to the profile stays in device memory
+    if (profileOnDevice && gpuEnabled && gpuNoiseProfileBuffer)
+    {
+        GPUBackend::setCurrentDevice(device);
+
+        if (gpuNoiseProfileBuffer->download(noiseProfile.data(), noiseProfile.size() * sizeof(float)))
+            profileOnDevice = false;
+        else
+            juce::Logger::writeToLog("GPU Noise Reduction: Profile download failed: " + GPUBackend::getLastError());
+    }
+
+    return noiseProfile;
 }
 
 std::string GPUNoiseReduction::getGPUInfo() const
@@ -145,262 +250,442 @@ std::string GPUNoiseReduction::getGPUInfo() const
     if (!gpuEnabled)
         return "CPU (GPU unavailable)";
 
-    auto deviceInfo = GPUBackend::getDeviceInfo();
-    return deviceInfo.name + " (" + deviceInfo.backendName + ")";
+    auto deviceInfo = GPUBackend::getDeviceInfo(device);
+    const std::string deviceName = deviceInfo.name + " (" + deviceInfo.backendName + ")";
+
+    if (processingPath == ProcessingPath::cpu)
+        return "CPU (faster than " + deviceName + " for " + std::to_string(calibration.blockSize) + "-sample blocks)";
+
+    return deviceName;
 }
 
 //==============================================================================
-void GPUNoiseReduction::processGPU(juce::dsp::AudioBlock<float>& block)
+void GPUNoiseReduction::calibrateDispatch()
 {
-    if (!gpuEnabled || !gpuFFT || !spectralSubtractionKernel)
+    DispatchCalibration result;
+    result.device = device;
+    result.blockSize = maxBlockSize;
+    result.fftSize = fftSize;
+    result.numChannels = static_cast<int>(numChannels);
+
+    // Measured once per configuration and device, by whichever instance prepares first
+    static std::mutex cacheLock;
+    static std::vector<DispatchCalibration> cache;
+
     {
-        processCPUFallback(block);
-        return;
+        std::lock_guard<std::mutex> lock(cacheLock);
+
+        for (const auto& entry : cache)
+        {
+            if (entry.device == result.device && entry.blockSize == result.blockSize
+                && entry.fftSize == result.fftSize && entry.numChannels == result.numChannels)
+            {
+                calibration = entry;
+                processingPath = entry.path;
+                return;
+            }
+        }
+    }
+
+    // Low-level noise against a flat profile, so every frame does the full work
+    juce::AudioBuffer<float> source(static_cast<int>(numChannels), maxBlockSize);
+    juce::AudioBuffer<float> block(static_cast<int>(numChannels), maxBlockSize);
+    juce::Random random(fftSize);
+
+    for (int channel = 0; channel < source.getNumChannels(); ++channel)
+        for (int i = 0; i < maxBlockSize; ++i)
+            source.setSample(channel, i, (random.nextFloat() * 2.0f - 1.0f) * 1.0e-3f);
+
+    const auto savedProfile = getNoiseProfile();
+    const bool savedProfileCaptured = profileCaptured;
+    const float savedReduction = reductionAmount;
+
+    std::fill(noiseProfile.begin(), noiseProfile.end(), 1.0e-3f);
+    profileCaptured = true;
+    setReduction(12.0f);
+    uploadNoiseProfile();
+
+    result.cpuMicroseconds = measureBlockCost(ProcessingPath::cpu, source, block);
+    result.gpuMicroseconds = measureBlockCost(ProcessingPath::gpu, source, block);
+
+    // Ties go to the CPU, which has no transfers to wait for
+    result.path = result.gpuMicroseconds < result.cpuMicroseconds * gpuAdvantage ? ProcessingPath::gpu
+                                                                                 : ProcessingPath::cpu;
+
+    noiseProfile = savedProfile;
+    profileCaptured = savedProfileCaptured;
+    setReduction(savedReduction);
+    uploadNoiseProfile();
+    stft.reset();
+
+    calibration = result;
+    processingPath = result.path;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheLock);
+        cache.push_back(result);
     }
 
-    // Process each channel
-    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    juce::Logger::writeToLog("GPU Noise Reduction: " + juce::String(result.blockSize) + "-sample blocks, "
+                             + juce::String(result.numChannels) + " channels, FFT " + juce::String(result.fftSize)
+                             + ": CPU " + juce::String(result.cpuMicroseconds, 1) + " us, GPU "
+                             + juce::String(result.gpuMicroseconds, 1) + " us per block, using the "
+                             + (result.path == ProcessingPath::gpu ? "GPU" : "CPU"));
+}
+
+double GPUNoiseReduction::measureBlockCost(ProcessingPath path, const juce::AudioBuffer<float>& source,
+                                           juce::AudioBuffer<float>& block)
+{
+    processingPath = path;
+
+    // Enough blocks for the STFT to be producing frames, then whole hops' worth timed:
+    // small blocks only transform a frame every few calls
+    const int numSamples = block.getNumSamples();
+    const int warmUpBlocks = fftSize / numSamples + 2;
+    const int timedBlocks = juce::jmax(1, calibrationHops * hopSize / numSamples);
+    double fastest = 0.0;
+
+    for (int channel = 0; channel < block.getNumChannels(); ++channel)
+        channelPointers[static_cast<size_t>(channel)] = block.getWritePointer(channel);
+
+    for (int round = 0; round < calibrationRounds; ++round)
     {
-        float* channelData = block.getChannelPointer(channel);
-        size_t numSamples = block.getNumSamples();
+        stft.reset();
+        double elapsedMs = 0.0;
 
-        // Process in overlapping frames
-        for (size_t pos = 0; pos < numSamples; pos += hopSize)
+        for (int i = 0; i < warmUpBlocks + timedBlocks; ++i)
         {
-            size_t frameEnd = juce::jmin(pos + fftSize, numSamples);
-            size_t frameSamples = frameEnd - pos;
+            for (int channel = 0; channel < block.getNumChannels(); ++channel)
+                block.copyFrom(channel, 0, source, channel, 0, numSamples);
 
-            if (frameSamples < static_cast<size_t>(hopSize))
-                break;
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            processChannels(channelPointers.data(), nullptr, block.getNumChannels(), numSamples);
 
-            // 1. Upload audio frame to GPU
-            std::fill(hostInputBuffer.begin(), hostInputBuffer.end(), 0.0f);
-            for (size_t i = 0; i < frameSamples; ++i)
-            {
-                hostInputBuffer[i] = channelData[pos + i];
-            }
+            if (i >= warmUpBlocks)
+                elapsedMs += juce::Time::getMillisecondCounterHiRes() - start;
+        }
 
-            if (!gpuInputBuffer->upload(hostInputBuffer.data(), hostInputBuffer.size() * sizeof(float)))
-            {
-                juce::Logger::writeToLog("GPU upload failed, falling back to CPU");
-                processCPUFallback(block);
-                return;
-            }
+        const double microsecondsPerBlock = elapsedMs * 1000.0 / timedBlocks;
+        fastest = round == 0 ? microsecondsPerBlock : juce::jmin(fastest, microsecondsPerBlock);
+    }
 
-            // 2. Execute FFT on GPU
-            if (!gpuFFT->executeForward(*gpuInputBuffer, *gpuOutputBuffer))
-            {
-                juce::Logger::writeToLog("GPU FFT failed");
-                processCPUFallback(block);
-                return;
-            }
+    return fastest;
+}
 
-            // 3. Run spectral subtraction kernel
-            performSpectralSubtractionGPU();
+//==============================================================================
+void GPUNoiseReduction::processSpansGPU(const SpanBatch& batch, const int* framesPerChannel, int numSpans)
+{
+    int totalFrames = 0;
 
-            // 4. Execute inverse FFT
-            if (!gpuFFT->executeInverse(*gpuOutputBuffer, *gpuInputBuffer))
-            {
-                juce::Logger::writeToLog("GPU inverse FFT failed");
-                processCPUFallback(block);
-                return;
-            }
+    for (int i = 0; i < numSpans; ++i)
+    {
+        totalFrames += framesPerChannel[i];
 
-            // 5. Download results from GPU
-            if (!gpuInputBuffer->download(hostOutputBuffer.data(), hostOutputBuffer.size() * sizeof(float)))
-            {
-                juce::Logger::writeToLog("GPU download failed");
-                processCPUFallback(block);
-                return;
-            }
+        // Chunks add their share of a channel's span, so it starts silent
+        if (framesPerChannel[i] > 0)
+            std::fill_n(batch.outputSpans + static_cast<size_t>(i) * static_cast<size_t>(batch.spanStride),
+                        stft.getSpanLength(framesPerChannel[i]), 0.0f);
+    }
+
+    // Small batches go in one piece; large ones in power-of-two chunks, two per lane or more
+    const int chunkFrames = totalFrames < minFramesToPipeline
+                              ? totalFrames
+                              : juce::nextPowerOfTwo((totalFrames + 2 * numTransferLanes - 1) / (2 * numTransferLanes));
+
+    size_t laneIndex = 0;
+    TransferLane* filling = nullptr;
+    lastProfileWriter = nullptr; // Every chunk of the previous batch has finished
 
-            // 6. Overlap-add reconstruction (on CPU for now)
-            const float normFactor = 1.5f; // For 75% overlap with Hann window
-            for (size_t i = 0; i < frameSamples; ++i)
+    // Frames are taken channel by channel; a chunk holds whole or partial runs of several channels
+    for (int channel = 0; channel < numSpans; ++channel)
+    {
+        for (int frame = 0; frame < framesPerChannel[channel];)
+        {
+            if (filling == nullptr)
             {
-                if (pos + i < numSamples)
-                {
-                    channelData[pos + i] = hostOutputBuffer[i] / (fftSize * normFactor);
-
-                    // Add overlap from previous frame
-                    if (channel < overlapBuffer.getNumChannels() && i < static_cast<size_t>(overlapBuffer.getNumSamples()))
-                    {
-                        channelData[pos + i] += overlapBuffer.getSample(static_cast<int>(channel), static_cast<int>(i));
-                    }
-                }
+                filling = transferLanes[laneIndex].get();
+                laneIndex = (laneIndex + 1) % transferLanes.size();
+
+                // The lane's previous chunk must be out before its buffers are reused
+                if (filling->numFrames > 0)
+                    finishChunk(*filling, batch);
             }
 
-            // 7. Store overlap for next frame
-            if (channel < overlapBuffer.getNumChannels())
+            Run run;
+            run.channel = channel;
+            run.channelFrame = frame;
+            run.chunkFrame = filling->numFrames;
+            run.numFrames = juce::jmin(framesPerChannel[channel] - frame, chunkFrames - filling->numFrames);
+            run.spanStart = filling->totalLength;
+
+            filling->runs.push_back(run);
+            filling->numFrames += run.numFrames;
+            filling->totalLength += stft.getSpanLength(run.numFrames);
+            frame += run.numFrames;
+
+            if (filling->numFrames == chunkFrames || static_cast<int>(filling->runs.size()) == maxRunsPerChunk)
             {
-                for (int i = 0; i < overlapBuffer.getNumSamples(); ++i)
-                {
-                    if (static_cast<size_t>(i) + hopSize < frameSamples)
-                    {
-                        overlapBuffer.setSample(static_cast<int>(channel), i,
-                            hostOutputBuffer[i + hopSize] / (fftSize * normFactor));
-                    }
-                    else
-                    {
-                        overlapBuffer.setSample(static_cast<int>(channel), i, 0.0f);
-                    }
-                }
+                if (!enqueueChunk(*filling, batch))
+                    juce::Logger::writeToLog("GPU batch failed, falling back to CPU");
+
+                filling = nullptr;
             }
         }
     }
+
+    if (filling != nullptr && !enqueueChunk(*filling, batch))
+        juce::Logger::writeToLog("GPU batch failed, falling back to CPU");
+
+    for (auto& lane : transferLanes)
+        if (lane->numFrames > 0)
+            finishChunk(*lane, batch);
+}
+
+bool GPUNoiseReduction::enqueueChunk(TransferLane& lane, const SpanBatch& batch)
+{
+    auto& plan = getPlanForBatch(lane, lane.numFrames);
+    const int numRuns = static_cast<int>(lane.runs.size());
+
+    // A capture takes the frames in the order they are queued, until it has enough
+    lane.captureFrames = capturingOnDevice ? juce::jmin(lane.numFrames, maxCaptureFrames - profileCaptureFrames) : 0;
+    lane.wroteProfile = false;
+    profileCaptureFrames += lane.captureFrames;
+    float* packed = lane.hostInput.getData();
+    int* table = reinterpret_cast<int*>(lane.hostRuns.getData());
+
+    // 1. Pack each run's input samples back to back, with the table the kernels find them by
+    for (int i = 0; i < numRuns; ++i)
+    {
+        const auto& run = lane.runs[static_cast<size_t>(i)];
+        const float* source = batch.inputSpans + static_cast<size_t>(run.channel) * static_cast<size_t>(batch.spanStride)
+                              + static_cast<size_t>(run.channelFrame) * static_cast<size_t>(hopSize);
+
+        std::copy(source, source + stft.getSpanLength(run.numFrames), packed + run.spanStart);
+        table[3 * i] = run.spanStart;
+        table[3 * i + 1] = run.chunkFrame;
+        table[3 * i + 2] = run.numFrames;
+    }
+
+    const size_t spanBytes = static_cast<size_t>(lane.totalLength) * sizeof(float);
+    const int batchFrames = plan.getBatchSize();
+
+    windowFramesKernel->setArgument(0, lane.deviceSpans);
+    windowFramesKernel->setArgument(1, lane.deviceRuns);
+    windowFramesKernel->setArgument(2, numRuns);
+    windowFramesKernel->setArgument(3, deviceAnalysisWindow);
+    windowFramesKernel->setArgument(4, lane.deviceFrames);
+    windowFramesKernel->setArgument(5, fftSize);
+    windowFramesKernel->setArgument(6, hopSize);
+    windowFramesKernel->setArgument(7, lane.numFrames);
+    windowFramesKernel->setArgument(8, batchFrames);
+
+    const size_t localWorkSize = 256;
+    const auto roundUp = [localWorkSize](size_t n) { return (n + localWorkSize - 1) / localWorkSize * localWorkSize; };
+
+    // 2-4. Upload, cut and window the frames (slots the plan runs beyond the chunk are silent),
+    // batched FFT, spectral subtraction (or profile capture) and batched inverse FFT
+    lane.failed = !(lane.deviceSpans.uploadAsync(packed, spanBytes, lane.stream)
+                    && lane.deviceRuns.uploadAsync(table, static_cast<size_t>(3 * numRuns) * sizeof(int), lane.stream)
+                    && windowFramesKernel->execute(roundUp(static_cast<size_t>(batchFrames) * static_cast<size_t>(fftSize)),
+                                                   localWorkSize, &lane.stream)
+                    && plan.executeForward(lane.deviceFrames, lane.deviceSpectra)
+                    && performSpectralSubtractionGPU(lane, lane.numFrames)
+                    && plan.executeInverse(lane.deviceSpectra, lane.deviceFrames));
+
+    if (lane.failed)
+        return false;
+
+    overlapAddKernel->setArgument(0, lane.deviceFrames);
+    overlapAddKernel->setArgument(1, lane.deviceRuns);
+    overlapAddKernel->setArgument(2, numRuns);
+    overlapAddKernel->setArgument(3, deviceSynthesisWindow);
+    overlapAddKernel->setArgument(4, lane.deviceSpans);
+    overlapAddKernel->setArgument(5, fftSize);
+    overlapAddKernel->setArgument(6, hopSize);
+    overlapAddKernel->setArgument(7, lane.totalLength);
+
+    // 5-6. Synthesis window and overlap-add into the spans, then download them,
+    // all queued on the lane's stream so they overlap with the other lanes
+    lane.failed = !(overlapAddKernel->execute(roundUp(static_cast<size_t>(lane.totalLength)), localWorkSize, &lane.stream)
+                    && lane.deviceSpans.downloadAsync(lane.hostOutput.getData(), spanBytes, lane.stream)
+                    && lane.downloaded.record(lane.stream));
+
+    return !lane.failed;
 }
 
-void GPUNoiseReduction::processCPUFallback(juce::dsp::AudioBlock<float>& block)
+void GPUNoiseReduction::finishChunk(TransferLane& lane, const SpanBatch& batch)
 {
-    // CPU-based spectral subtraction using JUCE's FFT
-    static std::unique_ptr<juce::dsp::FFT> cpuFFT;
-    static std::vector<float> cpuFFTBuffer;
-    static std::vector<float> cpuWindow;
-    static int cpuFFTSize = 0;
+    // Only this lane's download is waited for; the other lanes keep running
+    bool succeeded = !lane.failed && lane.downloaded.synchronize();
 
-    // Initialize CPU FFT if needed
-    if (cpuFFTSize != fftSize)
+    if (!succeeded)
     {
-        cpuFFT = std::make_unique<juce::dsp::FFT>(fftOrder);
-        cpuFFTBuffer.resize(static_cast<size_t>(fftSize * 2));
-        cpuWindow.resize(static_cast<size_t>(fftSize));
-        cpuFFTSize = fftSize;
+        lane.stream.synchronize(); // Nothing may still be reading the host buffers
 
-        // Create Hann window
-        juce::dsp::WindowingFunction<float>::fillWindowingTables(
-            cpuWindow.data(), static_cast<size_t>(fftSize),
-            juce::dsp::WindowingFunction<float>::hann, false);
+        // The CPU redo needs the profile as the device has adapted it so far
+        if (profileOnDevice && lastProfileWriter != nullptr && lastProfileWriter->profileWritten.synchronize())
+            getNoiseProfile();
     }
 
-    if (!profileCaptured || reductionAmount <= 0.0f)
-        return;
-
-    // Process each channel
-    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    for (const auto& run : lane.runs)
     {
-        float* channelData = block.getChannelPointer(channel);
-        size_t numSamples = block.getNumSamples();
+        const size_t offset = static_cast<size_t>(run.channel) * static_cast<size_t>(batch.spanStride)
+                              + static_cast<size_t>(run.channelFrame) * static_cast<size_t>(hopSize);
+
+        // Runs of one channel overlap by fftSize - hopSize samples, so their shares add up.
+        // A failed chunk is redone from the input spans, so the CPU keeps the stream continuous;
+        // it captures into the host's share unless the device already summed its frames.
+        if (succeeded)
+            juce::FloatVectorOperations::add(batch.outputSpans + offset, lane.hostOutput.getData() + run.spanStart,
+                                             stft.getSpanLength(run.numFrames));
+        else
+            processRunCPU(batch.inputSpans + offset, batch.outputSpans + offset, run.numFrames,
+                          lane.wroteProfile ? 0 : juce::jlimit(0, run.numFrames, lane.captureFrames - run.chunkFrame));
+    }
+
+    lane.runs.clear();
+    lane.numFrames = 0;
+    lane.totalLength = 0;
+}
+
+GPUBackend::GPUFFT& GPUNoiseReduction::getPlanForBatch(TransferLane& lane, int numFrames)
+{
+    // Plan k runs 2^k frames, the last one maxBatchFrames
+    size_t index = 0;
+    while ((1 << index) < numFrames && index + 1 < lane.plans.size())
+        ++index;
+
+    return *lane.plans[index];
+}
+
+bool GPUNoiseReduction::createTransferLanes()
+{
+    transferLanes.clear();
+
+    const size_t batchFrames = static_cast<size_t>(maxBatchFrames);
+    const size_t framesBytes = batchFrames * static_cast<size_t>(fftSize) * sizeof(float);
+    const size_t spectraBytes = batchFrames * static_cast<size_t>(fftSize / 2 + 1) * 2 * sizeof(float);
 
-        // Process in overlapping frames
-        for (size_t pos = 0; pos < numSamples; pos += static_cast<size_t>(hopSize))
+    // Every run adds fftSize - hopSize samples to the hop per frame
+    const size_t maxRuns = static_cast<size_t>(juce::jmin(maxBatchFrames, maxRunsPerChunk));
+    const size_t spansBytes = (maxRuns * static_cast<size_t>(fftSize - hopSize) + batchFrames * static_cast<size_t>(hopSize))
+                              * sizeof(float);
+    const size_t runsBytes = static_cast<size_t>(3 * maxRunsPerChunk) * sizeof(int);
+
+    for (int i = 0; i < numTransferLanes; ++i)
+    {
+        auto lane = std::make_unique<TransferLane>();
+        lane->runs.reserve(static_cast<size_t>(maxRunsPerChunk));
+
+        if (!lane->stream.create()
+            || !lane->hostInput.allocate(spansBytes)
+            || !lane->hostOutput.allocate(spansBytes)
+            || !lane->hostRuns.allocate(runsBytes)
+            || !lane->deviceSpans.allocate(spansBytes)
+            || !lane->deviceRuns.allocate(runsBytes)
+            || !lane->deviceFrames.allocate(framesBytes)
+            || !lane->deviceSpectra.allocate(spectraBytes))
+            return false;
+
+        // Batched plans; a partial batch runs on the smallest plan that holds it.
+        // The last one covers maxBatchFrames even when that is not a power of two.
+        for (int batchSize = 1;; batchSize *= 2)
         {
-            size_t frameSamples = juce::jmin(static_cast<size_t>(fftSize), numSamples - pos);
+            auto plan = std::make_unique<GPUBackend::GPUFFT>();
+            if (!plan->createPlan(fftSize, juce::jmin(batchSize, maxBatchFrames)))
+                return false;
 
-            if (frameSamples < static_cast<size_t>(hopSize))
+            plan->setStream(lane->stream);
+            lane->plans.push_back(std::move(plan));
+
+            if (batchSize >= maxBatchFrames)
                 break;
+        }
 
-            // 1. Window the input
-            std::fill(cpuFFTBuffer.begin(), cpuFFTBuffer.end(), 0.0f);
-            for (size_t i = 0; i < frameSamples; ++i)
-            {
-                cpuFFTBuffer[i] = channelData[pos + i] * cpuWindow[i];
-            }
+        if (!lane->hostInput.isPinned())
+            juce::Logger::writeToLog("GPU Noise Reduction: Pinned host memory unavailable, transfers will not overlap");
 
-            // 2. Forward FFT
-            cpuFFT->performRealOnlyForwardTransform(cpuFFTBuffer.data());
+        transferLanes.push_back(std::move(lane));
+    }
 
-            // 3. Spectral subtraction
-            int numBins = fftSize / 2 + 1;
-            for (int bin = 0; bin < numBins; ++bin)
-            {
-                float real, imag;
-
-                // Extract from JUCE FFT format
-                if (bin == 0)
-                {
-                    real = cpuFFTBuffer[0];
-                    imag = 0.0f;
-                }
-                else if (bin == fftSize / 2)
-                {
-                    real = cpuFFTBuffer[static_cast<size_t>(fftSize / 2)];
-                    imag = 0.0f;
-                }
-                else
-                {
-                    real = cpuFFTBuffer[static_cast<size_t>(bin)];
-                    imag = cpuFFTBuffer[static_cast<size_t>(fftSize - bin)];
-                }
-
-                // Calculate magnitude and phase
-                float magnitude = std::sqrt(real * real + imag * imag);
-                float phase = std::atan2(imag, real);
-
-                // Subtract noise profile
-                float noiseMag = noiseProfile[static_cast<size_t>(bin)] * reductionLinear;
-                float cleanMag = magnitude - noiseMag;
-
-                // Apply spectral floor
-                cleanMag = juce::jmax(cleanMag, magnitude * spectralFloor);
-
-                // Reconstruct
-                real = cleanMag * std::cos(phase);
-                imag = cleanMag * std::sin(phase);
-
-                // Store back
-                if (bin == 0)
-                {
-                    cpuFFTBuffer[0] = real;
-                }
-                else if (bin == fftSize / 2)
-                {
-                    cpuFFTBuffer[static_cast<size_t>(fftSize / 2)] = real;
-                }
-                else
-                {
-                    cpuFFTBuffer[static_cast<size_t>(bin)] = real;
-                    cpuFFTBuffer[static_cast<size_t>(fftSize - bin)] = imag;
-                }
-            }
+    return true;
+}
+
+bool GPUNoiseReduction::uploadWindows()
+{
+    // The GPU inverse FFT is unnormalised, so its 1 / fftSize rides on the synthesis window
+    const float inverseScale = 1.0f / static_cast<float>(fftSize);
+    std::copy(stft.getSynthesisWindow(), stft.getSynthesisWindow() + fftSize, cpuFrame.begin());
+    juce::FloatVectorOperations::multiply(cpuFrame.data(), inverseScale, fftSize);
 
-            // 4. Inverse FFT
-            cpuFFT->performRealOnlyInverseTransform(cpuFFTBuffer.data());
+    const size_t windowBytes = static_cast<size_t>(fftSize) * sizeof(float);
 
-            // 5. Overlap-add with windowing
-            const float normFactor = 1.5f;
-            for (size_t i = 0; i < frameSamples; ++i)
-            {
-                if (pos + i < numSamples)
-                {
-                    channelData[pos + i] = cpuFFTBuffer[i] * cpuWindow[i] / (static_cast<float>(fftSize) * normFactor);
-
-                    // Add overlap from previous frame
-                    if (channel < static_cast<size_t>(overlapBuffer.getNumChannels()) &&
-                        i < static_cast<size_t>(overlapBuffer.getNumSamples()))
-                    {
-                        channelData[pos + i] += overlapBuffer.getSample(static_cast<int>(channel), static_cast<int>(i));
-                    }
-                }
-            }
+    return deviceAnalysisWindow.allocate(windowBytes)
+        && deviceSynthesisWindow.allocate(windowBytes)
+        && deviceAnalysisWindow.upload(stft.getAnalysisWindow(), windowBytes)
+        && deviceSynthesisWindow.upload(cpuFrame.data(), windowBytes);
+}
 
-            // 6. Store overlap for next frame
-            if (static_cast<int>(channel) < overlapBuffer.getNumChannels())
-            {
-                for (int i = 0; i < overlapBuffer.getNumSamples(); ++i)
-                {
-                    if (static_cast<size_t>(i) + static_cast<size_t>(hopSize) < frameSamples)
-                    {
-                        overlapBuffer.setSample(static_cast<int>(channel), i,
-                            cpuFFTBuffer[static_cast<size_t>(i + hopSize)] * cpuWindow[static_cast<size_t>(i + hopSize)] /
-                            (static_cast<float>(fftSize) * normFactor));
-                    }
-                    else
-                    {
-                        overlapBuffer.setSample(static_cast<int>(channel), i, 0.0f);
-                    }
-                }
-            }
-        }
+void GPUNoiseReduction::processRunCPU(const float* input, float* output, int numFrames, int framesToCapture)
+{
+    float* frame = cpuFrame.data();
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        juce::FloatVectorOperations::multiply(frame, input + i * hopSize, stft.getAnalysisWindow(), fftSize);
+
+        // Only the device adapts the profile, so the host copy is used as it is
+        if (!capturingOnDevice)
+            processFrameCPU(frame, false);
+        else if (i < framesToCapture)
+            accumulateProfileFrame(frame);
+
+        juce::FloatVectorOperations::multiply(frame, stft.getSynthesisWindow(), fftSize);
+        juce::FloatVectorOperations::add(output + i * hopSize, frame, fftSize);
+    }
+}
+
+void GPUNoiseReduction::processFrameCPU(float* frame, bool adapt)
+{
+    auto& spectral = stft.getSpectralProcessor();
+    spectral.performForwardTransform(frame);
+
+    // Shared trig-free gain-mask kernel
+    SpectralGain::Parameters params;
+    params.reductionLinear = reductionLinear;
+    params.spectralFloor = spectralFloor;
+    params.adaptiveRate = adapt && adaptiveEnabled ? adaptiveRate : 0.0f;
+    params.adaptiveThreshold = adaptiveThreshold;
+    cpuSpectralGain.process(frame, noiseProfile.data(), params);
+
+    spectral.performInverseTransform(frame);
+}
+
+void GPUNoiseReduction::captureProfileFromBlock(juce::dsp::AudioBlock<float>& block)
+{
+    const int channelsToProcess = juce::jmin(static_cast<int>(block.getNumChannels()), stft.getNumChannels());
+
+    for (int channel = 0; channel < channelsToProcess; ++channel)
+    {
+        stft.processTimeFrames(block.getChannelPointer(static_cast<size_t>(channel)),
+                               static_cast<int>(block.getNumSamples()), channel,
+                               [this](float* frame, int) { captureProfileFromFrame(frame); });
     }
 }
 
-void GPUNoiseReduction::captureProfileGPU(const juce::dsp::AudioBlock<float>& block)
+void GPUNoiseReduction::captureProfileFromFrame(const float* frame)
 {
-    // Simplified profile capture
+    if (!isCapturingProfile || profileCaptureFrames >= maxCaptureFrames)
+        return;
+
+    accumulateProfileFrame(frame);
     profileCaptureFrames++;
 
     if (profileCaptureFrames >= maxCaptureFrames)
     {
+        for (auto& val : noiseProfile)
+            val /= static_cast<float>(maxCaptureFrames);
+
         profileCaptured = true;
         isCapturingProfile = false;
 
@@ -414,58 +699,175 @@ void GPUNoiseReduction::captureProfileGPU(const juce::dsp::AudioBlock<float>& bl
     }
 }
 
-void GPUNoiseReduction::performSpectralSubtractionGPU()
+void GPUNoiseReduction::accumulateProfileFrame(const float* frame)
+{
+    // Transform a copy so the frame itself resynthesises unchanged
+    std::copy(frame, frame + fftSize, captureBuffer.begin());
+    stft.getSpectralProcessor().performForwardTransform(captureBuffer.data());
+    SpectralGain::accumulateMagnitudes(captureBuffer.data(), noiseProfile.data(), fftSize / 2 + 1);
+}
+
+void GPUNoiseReduction::captureProfileGPU(juce::dsp::AudioBlock<float>& block)
+{
+    const size_t profileBytes = noiseProfile.size() * sizeof(float);
+
+    // The device sums the magnitudes; noiseProfile (zeroed by captureProfile()) keeps
+    // the share of any chunk the CPU has to redo
+    if (!capturingOnDevice)
+    {
+        GPUBackend::setCurrentDevice(device);
+        std::fill(captureBuffer.begin(), captureBuffer.end(), 0.0f);
+
+        if (!deviceProfileSum.upload(captureBuffer.data(), profileBytes))
+        {
+            captureProfileFromBlock(block);
+            return;
+        }
+
+        capturingOnDevice = true;
+    }
+
+    const int channelsToProcess = juce::jmin(static_cast<int>(block.getNumChannels()), stft.getNumChannels());
+
+    for (int channel = 0; channel < channelsToProcess; ++channel)
+        channelPointers[static_cast<size_t>(channel)] = block.getChannelPointer(static_cast<size_t>(channel));
+
+    processBlockGPU(channelPointers.data(), nullptr, channelsToProcess, static_cast<int>(block.getNumSamples()));
+
+    if (profileCaptureFrames >= maxCaptureFrames)
+        finishCaptureGPU();
+}
+
+void GPUNoiseReduction::finishCaptureGPU()
+{
+    const int numBins = fftSize / 2 + 1;
+    const size_t profileBytes = static_cast<size_t>(numBins) * sizeof(float);
+    auto& lane = *transferLanes.front();
+
+    profileFinishKernel->setArgument(0, *gpuNoiseProfileBuffer);
+    profileFinishKernel->setArgument(1, deviceProfileSum);
+    profileFinishKernel->setArgument(2, profileCaptureFrames);
+    profileFinishKernel->setArgument(3, numBins);
+
+    // The host's share goes up once and the average is formed where the profile is used
+    const size_t localWorkSize = 256;
+    const bool averaged = gpuNoiseProfileBuffer->upload(noiseProfile.data(), profileBytes)
+                          && profileFinishKernel->execute((static_cast<size_t>(numBins) + localWorkSize - 1)
+                                                              / localWorkSize * localWorkSize,
+                                                          localWorkSize, &lane.stream)
+                          && lane.stream.synchronize();
+
+    if (averaged)
+    {
+        profileOnDevice = true;
+    }
+    else
+    {
+        // Average on the host instead
+        juce::Logger::writeToLog("GPU Noise Reduction: Profile averaging kernel failed: " + GPUBackend::getLastError());
+
+        if (deviceProfileSum.download(captureBuffer.data(), profileBytes))
+            juce::FloatVectorOperations::add(noiseProfile.data(), captureBuffer.data(), numBins);
+
+        for (auto& val : noiseProfile)
+            val /= static_cast<float>(profileCaptureFrames);
+
+        uploadNoiseProfile();
+    }
+
+    profileCaptured = true;
+    isCapturingProfile = false;
+    capturingOnDevice = false;
+
+    juce::Logger::writeToLog("Noise profile captured on the GPU (" + juce::String(profileCaptureFrames) + " frames)");
+}
+
+bool GPUNoiseReduction::performSpectralSubtractionGPU(TransferLane& lane, int numFrames)
 {
     if (!spectralSubtractionKernel)
-        return;
+        return false;
 
     // Set kernel arguments
     int numBins = fftSize / 2 + 1;
+    const bool adaptive = adaptiveEnabled && adaptiveRate > 0.0f;
 
-    spectralSubtractionKernel->setArgument(0, *gpuOutputBuffer);     // FFT data (input/output)
-    spectralSubtractionKernel->setArgument(1, *gpuNoiseProfileBuffer); // Noise profile
-    spectralSubtractionKernel->setArgument(2, *gpuOutputBuffer);     // Output (same buffer)
-    spectralSubtractionKernel->setArgument(3, reductionLinear);      // Reduction factor
-    spectralSubtractionKernel->setArgument(4, spectralFloor);        // Spectral floor
-    spectralSubtractionKernel->setArgument(5, numBins);              // Number of bins
+    // Once a capture has its frames, the rest of the block passes through unchanged
+    if (capturingOnDevice && lane.captureFrames == 0)
+        return true;
+
+    // The profile is read and written in place, so chunks on other lanes wait for the last writer
+    if (lastProfileWriter != nullptr && lastProfileWriter != &lane
+        && !lastProfileWriter->profileWritten.makeStreamWait(lane.stream))
+        return false;
 
-    // Execute kernel
-    size_t globalWorkSize = static_cast<size_t>(numBins);
+    // One work item per bin, rounded up to whole workgroups
     size_t localWorkSize = 256; // Workgroup size
+    const auto roundUp = [localWorkSize](size_t n) { return (n + localWorkSize - 1) / localWorkSize * localWorkSize; };
+    const size_t binWorkSize = roundUp(static_cast<size_t>(numBins));
+    GPUBackend::GPUKernel* writer = nullptr;
 
-    if (!spectralSubtractionKernel->execute(globalWorkSize, localWorkSize))
+    if (capturingOnDevice)
     {
-        juce::Logger::writeToLog("Spectral subtraction kernel execution failed");
+        profileCaptureKernel->setArgument(0, lane.deviceSpectra);
+        profileCaptureKernel->setArgument(1, deviceProfileSum);
+        profileCaptureKernel->setArgument(2, numBins);
+        profileCaptureKernel->setArgument(3, lane.captureFrames);
+        writer = profileCaptureKernel.get();
+    }
+    else if (adaptive)
+    {
+        // Each bin walks the chunk's frames in order, adapting its profile entry as it goes
+        adaptiveSubtractionKernel->setArgument(0, lane.deviceSpectra);
+        adaptiveSubtractionKernel->setArgument(1, *gpuNoiseProfileBuffer);
+        adaptiveSubtractionKernel->setArgument(2, lane.deviceSpectra);
+        adaptiveSubtractionKernel->setArgument(3, reductionLinear);
+        adaptiveSubtractionKernel->setArgument(4, spectralFloor);
+        adaptiveSubtractionKernel->setArgument(5, adaptiveRate);
+        adaptiveSubtractionKernel->setArgument(6, adaptiveThreshold);
+        adaptiveSubtractionKernel->setArgument(7, numBins);
+        adaptiveSubtractionKernel->setArgument(8, numFrames);
+        writer = adaptiveSubtractionKernel.get();
     }
 
-    // Synchronize to ensure kernel completes
-    GPUBackend::synchronize();
-}
+    if (writer != nullptr)
+    {
+        if (!writer->execute(binWorkSize, localWorkSize, &lane.stream))
+        {
+            juce::Logger::writeToLog("Noise profile kernel execution failed");
+            return false;
+        }
 
-//==============================================================================
-// Helper function to load kernel source from file
-static std::string loadKernelSource(const juce::String& filename)
-{
-    juce::File kernelFile = juce::File::getCurrentWorkingDirectory()
-        .getChildFile("Source/GPU/kernels")
-        .getChildFile(filename);
+        // A capture's result only counts once finishCaptureGPU() has averaged it
+        lane.wroteProfile = true;
+        if (!capturingOnDevice)
+            profileOnDevice = true;
 
-    if (!kernelFile.existsAsFile())
-    {
-        // Try relative to executable
-        kernelFile = juce::File::getSpecialLocation(juce::File::currentExecutableFile)
-            .getParentDirectory()
-            .getChildFile("kernels")
-            .getChildFile(filename);
+        if (!lane.profileWritten.record(lane.stream))
+            return false;
+
+        lastProfileWriter = &lane;
+        return true;
     }
 
-    if (kernelFile.existsAsFile())
+    spectralSubtractionKernel->setArgument(0, lane.deviceSpectra);   // FFT data (input/output)
+    spectralSubtractionKernel->setArgument(1, *gpuNoiseProfileBuffer); // Noise profile
+    spectralSubtractionKernel->setArgument(2, lane.deviceSpectra);   // Output (same buffer)
+    spectralSubtractionKernel->setArgument(3, reductionLinear);      // Reduction factor
+    spectralSubtractionKernel->setArgument(4, spectralFloor);        // Spectral floor
+    spectralSubtractionKernel->setArgument(5, numBins);              // Bins per frame
+    spectralSubtractionKernel->setArgument(6, numFrames);            // Frames in the batch
+
+    // One work item per bin of every frame
+    size_t globalWorkSize = roundUp(static_cast<size_t>(numBins) * static_cast<size_t>(numFrames));
+
+    // Queued behind the forward FFT on the lane's stream; no device-wide synchronize
+    if (!spectralSubtractionKernel->execute(globalWorkSize, localWorkSize, &lane.stream))
     {
-        return kernelFile.loadFileAsString().toStdString();
+        juce::Logger::writeToLog("Spectral subtraction kernel execution failed");
+        return false;
     }
 
-    juce::Logger::writeToLog("Kernel file not found: " + filename);
-    return "";
+    return true;
 }
 
 bool GPUNoiseReduction::initializeGPU()
@@ -483,24 +885,8 @@ bool GPUNoiseReduction::initializeGPU()
     }
 
     // Load appropriate kernel based on backend
-    std::string kernelSource;
-    std::string kernelName = "spectralSubtractionFused";
-
-    #if defined(USE_OPENCL)
-        kernelSource = loadKernelSource("spectral_subtraction.cl");
-    #elif defined(USE_HIP)
-        kernelSource = loadKernelSource("spectral_subtraction.hip");
-        // For HIP, we would normally compile to a binary first
-        // For now, use OpenCL as fallback
-        if (kernelSource.empty())
-            kernelSource = loadKernelSource("spectral_subtraction.cl");
-    #elif defined(USE_CUDA)
-        kernelSource = loadKernelSource("spectral_subtraction.cu");
-        // For CUDA, we would normally compile to PTX first
-        // For now, use OpenCL as fallback
-        if (kernelSource.empty())
-            kernelSource = loadKernelSource("spectral_subtraction.cl");
-    #endif
+    const std::string kernelSource = GPUBackend::loadKernelSource("spectral_subtraction");
+    const std::string kernelName = "spectralSubtractionBatched";
 
     if (kernelSource.empty())
     {
@@ -508,16 +894,33 @@ bool GPUNoiseReduction::initializeGPU()
         return false;
     }
 
-    // Create and compile kernel
+    // Create and compile kernels: the gain mask, the framing around the FFTs and the profile updates
     spectralSubtractionKernel = std::make_unique<GPUBackend::GPUKernel>();
-    if (!spectralSubtractionKernel->loadFromSource(kernelSource, kernelName))
+    windowFramesKernel = std::make_unique<GPUBackend::GPUKernel>();
+    overlapAddKernel = std::make_unique<GPUBackend::GPUKernel>();
+    adaptiveSubtractionKernel = std::make_unique<GPUBackend::GPUKernel>();
+    profileCaptureKernel = std::make_unique<GPUBackend::GPUKernel>();
+    profileFinishKernel = std::make_unique<GPUBackend::GPUKernel>();
+
+    if (!spectralSubtractionKernel->loadFromSource(kernelSource, kernelName)
+        || !windowFramesKernel->loadFromSource(kernelSource, "stftWindowFrames")
+        || !overlapAddKernel->loadFromSource(kernelSource, "stftOverlapAdd")
+        || !adaptiveSubtractionKernel->loadFromSource(kernelSource, "spectralSubtractionAdaptive")
+        || !profileCaptureKernel->loadFromSource(kernelSource, "noiseProfileCapture")
+        || !profileFinishKernel->loadFromSource(kernelSource, "noiseProfileFinish"))
     {
         juce::Logger::writeToLog("Failed to compile GPU kernel: " + GPUBackend::getLastError());
         spectralSubtractionKernel.reset();
+        windowFramesKernel.reset();
+        overlapAddKernel.reset();
+        adaptiveSubtractionKernel.reset();
+        profileCaptureKernel.reset();
+        profileFinishKernel.reset();
         return false;
     }
 
-    juce::Logger::writeToLog("GPU kernel compiled successfully");
+    juce::Logger::writeToLog(spectralSubtractionKernel->wasLoadedFromCache() ? "GPU kernel loaded from cache"
+                                                                             : "GPU kernel compiled successfully");
     return true;
 }
 
@@ -526,17 +929,27 @@ void GPUNoiseReduction::shutdownGPU()
     if (gpuEnabled)
     {
         // Release GPU resources
-        if (gpuFFT) gpuFFT->release();
-        if (gpuInputBuffer) gpuInputBuffer->release();
-        if (gpuOutputBuffer) gpuOutputBuffer->release();
+        for (auto& lane : transferLanes)
+            lane->stream.synchronize();
         if (gpuNoiseProfileBuffer) gpuNoiseProfileBuffer->release();
         if (spectralSubtractionKernel) spectralSubtractionKernel->release();
-
-        gpuFFT.reset();
-        gpuInputBuffer.reset();
-        gpuOutputBuffer.reset();
+        if (windowFramesKernel) windowFramesKernel->release();
+        if (overlapAddKernel) overlapAddKernel->release();
+        if (adaptiveSubtractionKernel) adaptiveSubtractionKernel->release();
+        if (profileCaptureKernel) profileCaptureKernel->release();
+        if (profileFinishKernel) profileFinishKernel->release();
+        deviceAnalysisWindow.release();
+        deviceSynthesisWindow.release();
+        deviceProfileSum.release();
+
+        transferLanes.clear();
         gpuNoiseProfileBuffer.reset();
         spectralSubtractionKernel.reset();
+        windowFramesKernel.reset();
+        overlapAddKernel.reset();
+        adaptiveSubtractionKernel.reset();
+        profileCaptureKernel.reset();
+        profileFinishKernel.reset();
 
         gpuEnabled = false;
     }
@@ -547,6 +960,8 @@ bool GPUNoiseReduction::uploadNoiseProfile()
     if (!gpuEnabled || !gpuNoiseProfileBuffer)
         return false;
 
+    GPUBackend::setCurrentDevice(device);
+    profileOnDevice = false;
     return gpuNoiseProfileBuffer->upload(noiseProfile.data(),
                                          noiseProfile.size() * sizeof(float));
 }
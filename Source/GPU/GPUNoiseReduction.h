@@ -3,6 +3,8 @@
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 #include "GPUBackend.h"
+#include "../DSP/StftEngine.h"
+#include "../DSP/SpectralGain.h"
 
 /**
  * GPU-Accelerated Spectral Noise Reduction
@@ -16,6 +18,35 @@
  * - Real-time processing even at 96kHz sample rate
  * - Batch processing of multiple channels in parallel
  *
+ * Every hop-frame of a block, across all channels, is transformed in one batch,
+ * and only PCM crosses the bus: each channel's raw samples under its frames go
+ * up (StftEngine::processSpanBatches()), a kernel cuts and windows the frames,
+ * then come a batched forward FFT, the gain kernel over every bin and a batched
+ * inverse FFT, and a kernel applies the synthesis window and overlap-adds the
+ * frames into output spans, which come back down. With 75% overlap that is
+ * about a quarter of the transfers of moving whole frames. The stream state
+ * stays in the host's StftEngine, so the output matches the CPU path.
+ *
+ * On the GPU path the noise profile lives in device memory. Capture sums each
+ * frame's magnitudes on the device and averages them there, and the adaptive
+ * update runs inside the gain kernel, so neither needs a transfer per frame.
+ * The host copy is only refreshed when getNoiseProfile() asks for it.
+ *
+ * Large batches (offline blocks) are split into chunks that alternate between
+ * transfer lanes, each with its own stream and pinned host buffers: while one
+ * chunk computes, the next uploads and the previous downloads.
+ *
+ * Small host blocks can be slower on the GPU than on the CPU, transfers
+ * included. prepare() therefore times both paths on noise for the spec's block
+ * size, FFT size and channel count and processes on the faster one; the STFT
+ * state is shared, so either path continues the same stream. Results are kept
+ * per configuration and device, so preparing again with a known spec does not
+ * measure again.
+ *
+ * An instance runs on the device that was current when it was constructed
+ * (GPUBackend::setCurrentDevice()) and makes that device current on the
+ * calling thread whenever it uses the GPU.
+ *
  * Supported GPU backends:
  * - OpenCL (AMD, NVIDIA, Intel, Apple)
  * - CUDA (NVIDIA optimized)
@@ -34,6 +65,17 @@ public:
     void reset();
     void process(juce::dsp::ProcessContextReplacing<float>& context);
 
+    /**
+     * Processes unrelated streams in one batch: channelData[i] runs through STFT
+     * channel stftChannels[i] (channel i when stftChannels is null), so a batch
+     * processor can interleave several files on one prepared instance. Profile
+     * capture is not available here.
+     */
+    void processChannels(float* const* channelData, const int* stftChannels, int numChannelsToProcess, int numSamples);
+
+    /** Clears one STFT channel, e.g. before a new file starts on it */
+    void resetChannel(int channel) { stft.resetChannel(channel); }
+
     //==============================================================================
     /** Capture noise profile from current audio section */
     void captureProfile();
@@ -44,10 +86,35 @@ public:
     /** Set FFT size (larger = better quality, more latency) */
     void setFFTSize(int size);
 
-    /** Check if GPU acceleration is active */
-    bool isUsingGPU() const { return gpuEnabled; }
+    /** Where process() and processChannels() run */
+    enum class ProcessingPath
+    {
+        cpu,
+        gpu
+    };
 
-    /** Get GPU device info */
+    /** Result of timing both paths for one configuration */
+    struct DispatchCalibration
+    {
+        int device = 0;
+        int blockSize = 0;
+        int fftSize = 0;
+        int numChannels = 0;
+        double cpuMicroseconds = 0.0;   // Per block, averaged over whole hops
+        double gpuMicroseconds = 0.0;
+        ProcessingPath path = ProcessingPath::cpu;
+    };
+
+    /** Check if GPU acceleration is active for the current configuration */
+    bool isUsingGPU() const { return gpuEnabled && processingPath == ProcessingPath::gpu; }
+
+    /** Path chosen by the last prepare() */
+    ProcessingPath getProcessingPath() const { return processingPath; }
+
+    /** Timings behind the current path; all zero when the GPU is unavailable */
+    const DispatchCalibration& getDispatchCalibration() const { return calibration; }
+
+    /** Get GPU device info, including the active path */
     std::string getGPUInfo() const;
 
     /** Check if noise profile has been captured */
@@ -56,24 +123,69 @@ public:
     /** Clear noise profile */
     void clearProfile();
 
+    /** Use a stored profile (fftSize / 2 + 1 magnitudes); false if the size does not match */
+    bool setNoiseProfile(const std::vector<float>& profile);
+
+    /** Current profile (fftSize / 2 + 1 magnitudes), e.g. for display. Copies it
+        back from the device when the GPU has captured or adapted it since, so call
+        it when the profile is needed rather than per block, and not during process(). */
+    const std::vector<float>& getNoiseProfile();
+
+    /** Enable adaptive noise profile updates during processing */
+    void setAdaptiveEnabled(bool enabled) { adaptiveEnabled = enabled; }
+
+    /** Set adaptive profile update rate (0.0 to 0.2) */
+    void setAdaptiveRate(float rate) { adaptiveRate = juce::jlimit(0.0f, 0.2f, rate); }
+
     /** Get activity metrics for visual feedback */
     bool isActivelyReducing() const { return profileCaptured && reductionAmount > 0.1f; }
     float getReductionAmount() const { return reductionAmount; }
 
+    /** Processing delay introduced by the STFT, in samples */
+    int getLatencySamples() const { return stft.getLatencySamples(); }
+
+    /** Frame length; an output sample depends on at most this much earlier input */
+    int getFFTSize() const { return fftSize; }
+
 private:
     //==============================================================================
-    void processGPU(juce::dsp::AudioBlock<float>& block);
-    void processCPUFallback(juce::dsp::AudioBlock<float>& block);
-    void captureProfileGPU(const juce::dsp::AudioBlock<float>& block);
-    void performSpectralSubtractionGPU();
+    struct TransferLane;
+
+    /** Span batch from the STFT engine: inputSpans in, overlap-added outputSpans out */
+    struct SpanBatch
+    {
+        const float* inputSpans = nullptr;
+        float* outputSpans = nullptr;
+        int spanStride = 0;
+    };
+
+    void processBlockGPU(float* const* channelData, const int* stftChannels, int numChannelsToProcess, int numSamples);
+    void processSpansGPU(const SpanBatch& batch, const int* framesPerChannel, int numSpans);
+    bool enqueueChunk(TransferLane& lane, const SpanBatch& batch);
+    void finishChunk(TransferLane& lane, const SpanBatch& batch);
+    bool createTransferLanes();
+    bool uploadWindows();
+    void processFrameCPU(float* frame, bool adapt);
+    void processRunCPU(const float* input, float* output, int numFrames, int framesToCapture);
+    void captureProfileFromBlock(juce::dsp::AudioBlock<float>& block);
+    void captureProfileFromFrame(const float* frame);
+    void accumulateProfileFrame(const float* frame);
+    void captureProfileGPU(juce::dsp::AudioBlock<float>& block);
+    void finishCaptureGPU();
+    bool performSpectralSubtractionGPU(TransferLane& lane, int numFrames);
+    GPUBackend::GPUFFT& getPlanForBatch(TransferLane& lane, int numFrames);
 
     bool initializeGPU();
     void shutdownGPU();
     bool uploadNoiseProfile();
 
+    void calibrateDispatch();
+    double measureBlockCost(ProcessingPath path, const juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& block);
+
     //==============================================================================
     double sampleRate = 44100.0;
     juce::uint32 numChannels = 2;
+    int maxBlockSize = 0;
 
     // FFT parameters
     int fftOrder = 12; // 4096 samples (larger than CPU version)
@@ -82,21 +194,84 @@ private:
 
     // GPU resources
     bool gpuEnabled = false;
-    std::unique_ptr<GPUBackend::GPUFFT> gpuFFT;
-    std::unique_ptr<GPUBackend::GPUBuffer> gpuInputBuffer;
-    std::unique_ptr<GPUBackend::GPUBuffer> gpuOutputBuffer;
+    int device = 0;
     std::unique_ptr<GPUBackend::GPUBuffer> gpuNoiseProfileBuffer;
     std::unique_ptr<GPUBackend::GPUKernel> spectralSubtractionKernel;
+    std::unique_ptr<GPUBackend::GPUKernel> windowFramesKernel;
+    std::unique_ptr<GPUBackend::GPUKernel> overlapAddKernel;
+    std::unique_ptr<GPUBackend::GPUKernel> adaptiveSubtractionKernel;
+    std::unique_ptr<GPUBackend::GPUKernel> profileCaptureKernel;
+    std::unique_ptr<GPUBackend::GPUKernel> profileFinishKernel;
+    GPUBackend::GPUBuffer deviceProfileSum;                     // Magnitudes summed during a capture
+    GPUBackend::GPUBuffer deviceAnalysisWindow;
+    GPUBackend::GPUBuffer deviceSynthesisWindow;                // Includes the inverse FFT's 1 / fftSize
+
+    // CPU/GPU dispatch
+    ProcessingPath processingPath = ProcessingPath::cpu;
+    DispatchCalibration calibration;
+    static constexpr int calibrationRounds = 3;     // Fastest round counts
+    static constexpr int calibrationHops = 32;      // Hops timed per round
+    static constexpr double gpuAdvantage = 0.9;     // The GPU must be 10% faster to be used
+
+    /** Consecutive frames of one channel within a chunk */
+    struct Run
+    {
+        int channel = 0;
+        int channelFrame = 0;                                   // First frame, within the channel's span
+        int chunkFrame = 0;                                     // First frame, within the chunk
+        int numFrames = 0;
+        int spanStart = 0;                                      // Offset of its samples in the chunk
+    };
+
+    /** One stream's worth of resources; a chunk's spans are packed back to back */
+    struct TransferLane
+    {
+        GPUBackend::GPUStream stream;
+        GPUBackend::GPUEvent downloaded;
+        GPUBackend::GPUEvent profileWritten;                    // After the chunk adapted or captured into the profile
+        GPUBackend::PinnedHostBuffer hostInput;                 // Input spans
+        GPUBackend::PinnedHostBuffer hostOutput;                // Overlap-added spans
+        GPUBackend::PinnedHostBuffer hostRuns;                  // Run table, 3 ints per run
+        GPUBackend::GPUBuffer deviceSpans;                      // Input spans, then the output spans
+        GPUBackend::GPUBuffer deviceRuns;
+        GPUBackend::GPUBuffer deviceFrames;                     // Real frames, fftSize apart
+        GPUBackend::GPUBuffer deviceSpectra;                    // Complex spectra
+        std::vector<std::unique_ptr<GPUBackend::GPUFFT>> plans; // Batch sizes 1, 2, 4 ... up to maxBatchFrames
+
+        std::vector<Run> runs;                                  // Chunk being filled or in flight
+        int numFrames = 0;
+        int totalLength = 0;                                    // Samples in the chunk's spans
+        int captureFrames = 0;                                  // Leading frames summed into the profile
+        bool wroteProfile = false;
+        bool failed = false;
+    };
+
+    static constexpr int numTransferLanes = 2;
+    static constexpr int minFramesToPipeline = 16;
+    static constexpr int maxRunsPerChunk = 64;                  // STFT_MAX_RUNS in the kernels
+    std::vector<std::unique_ptr<TransferLane>> transferLanes;
+    TransferLane* lastProfileWriter = nullptr;                  // Chunks that use the profile wait for it
+
+    // Batching: the STFT engine gathers a block's spans here, getSpanLength(maxFramesPerChannel) apart
+    static constexpr int maxFramesPerBatch = 256;
+    int maxBatchFrames = 1;
+    int maxFramesPerChannel = 1;
+    std::vector<float> hostInputSpans;
+    std::vector<float> hostOutputSpans;
+    std::vector<float> cpuFrame;                                // Fallback for a failed chunk
+    std::vector<float*> channelPointers;
 
-    // Host buffers for GPU transfer
-    std::vector<float> hostInputBuffer;
-    std::vector<float> hostOutputBuffer;
-    juce::AudioBuffer<float> overlapBuffer;
+    // STFT framing and CPU spectral kernel
+    StftEngine stft;
+    SpectralGain cpuSpectralGain;
+    std::vector<float> captureBuffer;
 
     // Noise profile
-    std::vector<float> noiseProfile;
+    std::vector<float> noiseProfile;                            // During a GPU capture: the frames the CPU redid
     bool profileCaptured = false;
     bool isCapturingProfile = false;
+    bool capturingOnDevice = false;
+    bool profileOnDevice = false;                               // The device copy is newer than noiseProfile
     int profileCaptureFrames = 0;
     const int maxCaptureFrames = 50; // More frames for better averaging with GPU
 
@@ -104,6 +279,9 @@ private:
     float reductionAmount = 0.0f;
     float reductionLinear = 1.0f;
     const float spectralFloor = 0.01f; // -40 dB
+    bool adaptiveEnabled = false;
+    float adaptiveRate = 0.0f;
+    const float adaptiveThreshold = 1.5f;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GPUNoiseReduction)
 };
@@ -38,11 +38,8 @@ void GPUSpectralProcessor::prepare(const juce::dsp::ProcessSpec& spec)
         frame.resize(fftSize / 2 + 1, 0.0f);
     }
 
-    // Window buffer
-    windowBuffer.resize(static_cast<size_t>(fftSize));
-    juce::dsp::WindowingFunction<float>::fillWindowingTables(
-        windowBuffer.data(), static_cast<size_t>(fftSize),
-        juce::dsp::WindowingFunction<float>::hann, false);
+    // Window table (shared process-wide)
+    windowTable = FFTCache::getWindow(fftSize, juce::dsp::WindowingFunction<float>::hann, false);
 
     if (gpuEnabled)
     {
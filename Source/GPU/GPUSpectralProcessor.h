@@ -4,6 +4,7 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "GPUBackend.h"
+#include "../DSP/FFTCache.h"
 
 /**
  * GPU-Accelerated Spectral Analysis & Visualization
@@ -109,7 +110,7 @@ private:
     float maxFrequency = 20000.0f;
 
     // Buffers
-    std::vector<float> windowBuffer;
+    FFTCache::WindowPtr windowTable;
     juce::AudioBuffer<float> audioBuffer;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GPUSpectralProcessor)
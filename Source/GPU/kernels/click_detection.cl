@@ -0,0 +1,89 @@
+/**
+ * OpenCL Kernels for GPU-Accelerated Click Detection
+ *
+ * Compatible with: AMD, NVIDIA, Intel, Apple GPUs
+ *
+ * Bulk version of the first pass of ClickRemoval's scan (see
+ * GPUClickDetector):
+ * 1. Sum of squares of every RMS segment, for the running RMS
+ * 2. Second-derivative residual of every sample against its segment's
+ *    threshold, compacted into a list of candidate positions
+ *
+ * Each block of samples starts with two guard samples (the two before it), so
+ * sample i is samples[i + 2]. No fused multiply-adds: the energies must match
+ * the CPU's bit for bit.
+ */
+
+#pragma OPENCL FP_CONTRACT OFF
+
+//==============================================================================
+// Kernel 1: Energy of each segment
+//==============================================================================
+__kernel void clickSegmentEnergy(
+    __global const float* samples,      // Guard samples, then the block (zero padded to whole segments)
+    __global float* energies,           // Output: sum of squares per segment
+    const int segmentSize,              // Samples per segment
+    const int numSegments)              // Segments in the block
+{
+    int segment = get_global_id(0);
+
+    if (segment >= numSegments)
+        return;
+
+    // In order, as the CPU sums them
+    __global const float* data = samples + 2 + segment * segmentSize;
+    float energy = 0.0f;
+
+    for (int i = 0; i < segmentSize; ++i)
+        energy += data[i] * data[i];
+
+    energies[segment] = energy;
+}
+
+//==============================================================================
+// Kernel 2: Threshold crossings, compacted per workgroup
+//==============================================================================
+__kernel void clickCandidates(
+    __global const float* samples,      // Guard samples, then the block
+    __global const float* thresholds,   // Detection threshold per segment
+    __global int* candidates,           // Output: block positions, in no particular order
+    __global int* count,                // In/out: candidates found (may exceed capacity)
+    const int segmentSize,              // Samples per segment
+    const int numSamples,               // Samples in the block
+    const int capacity)                 // Room in candidates
+{
+    __local int groupCount;
+    __local int groupBase;
+
+    int i = get_global_id(0);
+    int localId = get_local_id(0);
+
+    if (localId == 0)
+        groupCount = 0;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // |x[i] - 2 x[i-1] + x[i-2]|, as differences of differences like the CPU
+    bool crossing = false;
+
+    if (i < numSamples)
+    {
+        __global const float* x = samples + 2 + i;
+        float later = x[0] - x[-1];
+        float earlier = x[-1] - x[-2];
+        crossing = fabs(later - earlier) > thresholds[i / segmentSize];
+    }
+
+    // One global atomic per workgroup instead of one per crossing
+    int localSlot = crossing ? atomic_inc(&groupCount) : 0;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (localId == 0)
+        groupBase = groupCount > 0 ? atomic_add(count, groupCount) : 0;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (crossing && groupBase + localSlot < capacity)
+        candidates[groupBase + localSlot] = i;
+}
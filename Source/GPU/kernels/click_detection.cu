@@ -0,0 +1,103 @@
+/**
+ * CUDA Kernels for NVIDIA GPU-Accelerated Click Detection
+ *
+ * Bulk version of the first pass of ClickRemoval's scan (see
+ * GPUClickDetector):
+ * 1. Sum of squares of every RMS segment, for the running RMS
+ * 2. Second-derivative residual of every sample against its segment's
+ *    threshold, compacted into a list of candidate positions
+ *
+ * Each block of samples starts with two guard samples (the two before it), so
+ * sample i is samples[i + 2]. The energies use round-to-nearest intrinsics so
+ * no multiply-add is fused and they match the CPU's bit for bit.
+ */
+
+// NVRTC (see GPUKernel::loadFromSource) provides the runtime built in and compiles no host code
+#ifndef __CUDACC_RTC__
+#include <cuda_runtime.h>
+#endif
+
+//==============================================================================
+// Kernel 1: Energy of each segment
+//==============================================================================
+__global__ void clickSegmentEnergy(
+    const float* __restrict__ samples,
+    float* __restrict__ energies,
+    int segmentSize,
+    int numSegments)
+{
+    int segment = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (segment >= numSegments)
+        return;
+
+    // In order, as the CPU sums them
+    const float* data = samples + 2 + segment * segmentSize;
+    float energy = 0.0f;
+
+    for (int i = 0; i < segmentSize; ++i)
+        energy = __fadd_rn(energy, __fmul_rn(data[i], data[i]));
+
+    energies[segment] = energy;
+}
+
+//==============================================================================
+// Kernel 2: Threshold crossings, compacted per block with a warp ballot
+//==============================================================================
+__global__ void clickCandidates(
+    const float* __restrict__ samples,
+    const float* __restrict__ thresholds,
+    int* __restrict__ candidates,
+    int* __restrict__ count,
+    int segmentSize,
+    int numSamples,
+    int capacity)
+{
+    __shared__ int warpCounts[32];
+    __shared__ int warpBases[32];
+
+    int i = blockIdx.x * blockDim.x + threadIdx.x;
+    int lane = threadIdx.x & 31;
+    int warp = threadIdx.x >> 5;
+
+    // |x[i] - 2 x[i-1] + x[i-2]|, as differences of differences like the CPU
+    bool crossing = false;
+
+    if (i < numSamples)
+    {
+        const float* x = samples + 2 + i;
+        float later = x[0] - x[-1];
+        float earlier = x[-1] - x[-2];
+        crossing = fabsf(later - earlier) > __ldg(&thresholds[i / segmentSize]);
+    }
+
+    // Rank within the warp from the ballot, then one global atomic per block
+    unsigned int ballot = __ballot_sync(0xffffffffu, crossing);
+    int rank = __popc(ballot & ((1u << lane) - 1u));
+
+    if (lane == 0)
+        warpCounts[warp] = __popc(ballot);
+
+    __syncthreads();
+
+    if (threadIdx.x == 0)
+    {
+        int total = 0;
+        for (int w = 0; w < (blockDim.x + 31) / 32; ++w)
+        {
+            warpBases[w] = total;
+            total += warpCounts[w];
+        }
+
+        int base = total > 0 ? atomicAdd(count, total) : 0;
+        for (int w = 0; w < (blockDim.x + 31) / 32; ++w)
+            warpBases[w] += base;
+    }
+
+    __syncthreads();
+
+    int slot = warpBases[warp] + rank;
+
+    if (crossing && slot < capacity)
+        candidates[slot] = i;
+}
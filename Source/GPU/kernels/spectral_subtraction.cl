@@ -115,6 +115,217 @@ __kernel void spectralSubtractionFused(
     outputFFT[idx] = (float2)(cleanReal, cleanImag);
 }
 
+//==============================================================================
+// Kernel 3b: Batched spectral subtraction over numFrames spectra packed back to
+// back (numBins apart). One work item per bin of every frame; the complex value
+// is scaled by the gain instead of rebuilt from magnitude and phase.
+//==============================================================================
+__kernel void spectralSubtractionBatched(
+    __global const float2* fftData,        // Input: numFrames * numBins complex bins
+    __global const float* noiseProfile,    // Input: noise profile (numBins, shared by all frames)
+    __global float2* outputFFT,            // Output: cleaned complex FFT (may alias fftData)
+    const float reductionFactor,           // Noise reduction amount
+    const float spectralFloor,             // Spectral floor
+    const int numBins,                     // Bins per frame
+    const int numFrames)                   // Frames in the batch
+{
+    int idx = get_global_id(0);
+
+    if (idx >= numBins * numFrames)
+        return;
+
+    float2 complex = fftData[idx];
+    float magnitude = sqrt(complex.x * complex.x + complex.y * complex.y);
+
+    // max(|X| - N, |X| * floor) / |X|
+    float noiseMag = noiseProfile[idx % numBins] * reductionFactor;
+    float gain = magnitude > 1.0e-12f ? fmax(1.0f - noiseMag / magnitude, spectralFloor) : spectralFloor;
+
+    outputFFT[idx] = complex * gain;
+}
+
+//==============================================================================
+// Kernels 3c/3d: Device-side STFT framing around the batched FFTs
+//
+// A chunk uploads raw PCM rather than windowed frames: one span per run of
+// consecutive frames of a channel, fftSize + (numFrames - 1) * hopSize samples,
+// packed back to back. runs holds [spanStart, firstFrame, numFrames] per run,
+// ordered by firstFrame (frame indices within the chunk). The table is read
+// into local memory once per workgroup.
+//==============================================================================
+#define STFT_MAX_RUNS 64
+
+// Cut and window every frame of the chunk; frames past numFrames (the rest of
+// the FFT plan's batch) are cleared
+__kernel void stftWindowFrames(
+    __global const float* spans,           // Input: packed PCM spans
+    __global const int* runs,              // Input: numRuns * 3 ints
+    const int numRuns,
+    __global const float* window,          // Input: analysis window (fftSize)
+    __global float* frames,                // Output: batchFrames * fftSize windowed frames
+    const int fftSize,
+    const int hopSize,
+    const int numFrames,                   // Frames in the chunk
+    const int batchFrames)                 // Frames the FFT plan transforms
+{
+    __local int localRuns[3 * STFT_MAX_RUNS];
+
+    for (int i = get_local_id(0); i < 3 * numRuns; i += get_local_size(0))
+        localRuns[i] = runs[i];
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int idx = get_global_id(0);
+
+    if (idx >= batchFrames * fftSize)
+        return;
+
+    int frame = idx / fftSize;
+    int i = idx - frame * fftSize;
+    float value = 0.0f;
+
+    if (frame < numFrames)
+    {
+        int run = 0;
+        while (run + 1 < numRuns && frame >= localRuns[3 * (run + 1) + 1])
+            ++run;
+
+        int runFrame = frame - localRuns[3 * run + 1];
+        value = spans[localRuns[3 * run] + runFrame * hopSize + i] * window[i];
+    }
+
+    frames[idx] = value;
+}
+
+// Synthesis window and overlap-add of each run's frames into its span, gathered
+// per output sample so no atomics are needed. The window includes the 1 / fftSize
+// of the unnormalised inverse FFT.
+__kernel void stftOverlapAdd(
+    __global const float* frames,          // Input: numFrames * fftSize inverse transforms
+    __global const int* runs,              // Input: numRuns * 3 ints
+    const int numRuns,
+    __global const float* window,          // Input: scaled synthesis window (fftSize)
+    __global float* spans,                 // Output: packed overlap-added spans
+    const int fftSize,
+    const int hopSize,
+    const int totalLength)                 // Samples in all spans
+{
+    __local int localRuns[3 * STFT_MAX_RUNS];
+
+    for (int i = get_local_id(0); i < 3 * numRuns; i += get_local_size(0))
+        localRuns[i] = runs[i];
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int idx = get_global_id(0);
+
+    if (idx >= totalLength)
+        return;
+
+    int run = 0;
+    while (run + 1 < numRuns && idx >= localRuns[3 * (run + 1)])
+        ++run;
+
+    int t = idx - localRuns[3 * run];
+    int firstFrame = localRuns[3 * run + 1];
+    int lastFrame = min(localRuns[3 * run + 2] - 1, t / hopSize);
+    float sum = 0.0f;
+
+    for (int j = t >= fftSize ? (t - fftSize) / hopSize + 1 : 0; j <= lastFrame; ++j)
+    {
+        int k = t - j * hopSize;
+        sum += frames[(firstFrame + j) * fftSize + k] * window[k];
+    }
+
+    spans[idx] = sum;
+}
+
+//==============================================================================
+// Kernels 3e-3g: Device-resident noise profile
+//
+// The profile stays in device memory while it is captured or adapted. Each
+// kernel runs one work item per bin and walks the batch's frames in order, so
+// the reduction over frames needs no atomics and sums in the same order as
+// the CPU.
+//==============================================================================
+
+// Adds the magnitudes of the first numFrames spectra to a running sum per bin
+__kernel void noiseProfileCapture(
+    __global const float2* fftData,        // Input: batch of complex spectra, numBins apart
+    __global float* profileSum,            // Input/Output: magnitude sum per bin
+    const int numBins,                     // Bins per frame
+    const int numFrames)                   // Leading frames of the batch to count
+{
+    int bin = get_global_id(0);
+
+    if (bin >= numBins)
+        return;
+
+    float sum = profileSum[bin];
+
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        float2 complex = fftData[frame * numBins + bin];
+        sum += sqrt(complex.x * complex.x + complex.y * complex.y);
+    }
+
+    profileSum[bin] = sum;
+}
+
+// Averages a finished capture; noiseProfile arrives holding the share summed on the host
+__kernel void noiseProfileFinish(
+    __global float* noiseProfile,          // Input: host share of the sum; Output: averaged profile
+    __global const float* profileSum,      // Input: device share of the sum
+    const int numFrames,                   // Frames captured
+    const int numBins)                     // Number of bins
+{
+    int bin = get_global_id(0);
+
+    if (bin >= numBins)
+        return;
+
+    noiseProfile[bin] = (noiseProfile[bin] + profileSum[bin]) / (float)numFrames;
+}
+
+// Spectral subtraction with the adaptive profile update of the CPU path: a bin
+// below threshold * profile counts as noise and pulls the profile towards its
+// magnitude by rate, frame by frame, before that frame's gain is computed
+__kernel void spectralSubtractionAdaptive(
+    __global const float2* fftData,        // Input: numFrames * numBins complex bins
+    __global float* noiseProfile,          // Input/Output: noise profile, adapted in place
+    __global float2* outputFFT,            // Output: cleaned complex FFT (may alias fftData)
+    const float reductionFactor,           // Noise reduction amount
+    const float spectralFloor,             // Spectral floor
+    const float adaptiveRate,              // Profile update rate
+    const float adaptiveThreshold,         // Noise gate relative to the profile
+    const int numBins,                     // Bins per frame
+    const int numFrames)                   // Frames in the batch
+{
+    int bin = get_global_id(0);
+
+    if (bin >= numBins)
+        return;
+
+    float profile = noiseProfile[bin];
+
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        int idx = frame * numBins + bin;
+        float2 complex = fftData[idx];
+        float magnitude = sqrt(complex.x * complex.x + complex.y * complex.y);
+
+        if (magnitude <= profile * adaptiveThreshold)
+            profile += adaptiveRate * (magnitude - profile);
+
+        float noiseMag = profile * reductionFactor;
+        float gain = magnitude > 1.0e-12f ? fmax(1.0f - noiseMag / magnitude, spectralFloor) : spectralFloor;
+
+        outputFFT[idx] = complex * gain;
+    }
+
+    noiseProfile[bin] = profile;
+}
+
 //==============================================================================
 // Kernel 4: Noise profile accumulation (for capturing noise profile)
 //==============================================================================
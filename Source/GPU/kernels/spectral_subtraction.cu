@@ -11,8 +11,11 @@
  * - Cooperative groups
  */
 
+// NVRTC (see GPUKernel::loadFromSource) provides the runtime built in and compiles no host code
+#ifndef __CUDACC_RTC__
 #include <cuda_runtime.h>
 #include <cufft.h>
+#endif
 #include <cooperative_groups.h>
 
 namespace cg = cooperative_groups;
@@ -188,6 +191,213 @@ __global__ void spectralSubtractionMultiChannel(
     outputFFT[globalIdx] = polarToComplex(cleanMag, phase);
 }
 
+//==============================================================================
+// Kernel 4b: Batched spectral subtraction, 1D over numFrames spectra packed back
+// to back (matches the batched cuFFT layout)
+//==============================================================================
+__global__ void spectralSubtractionBatched(
+    const float2* __restrict__ fftData,
+    const float* __restrict__ noiseProfile,
+    float2* __restrict__ outputFFT,
+    float reductionFactor,
+    float spectralFloor,
+    int numBins,
+    int numFrames)
+{
+    int idx = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (idx >= numBins * numFrames)
+        return;
+
+    float2 complex = fftData[idx];
+    float mag = complexMagnitude(complex);
+
+    // Gain on the complex value: no atan2/sincos round trip
+    float noiseMag = __ldg(&noiseProfile[idx % numBins]) * reductionFactor;
+    float gain = mag > 1.0e-12f ? fmaxf(1.0f - noiseMag / mag, spectralFloor) : spectralFloor;
+
+    outputFFT[idx] = make_float2(complex.x * gain, complex.y * gain);
+}
+
+//==============================================================================
+// Kernels 4c/4d: Device-side STFT framing around the batched FFTs
+//
+// A chunk uploads raw PCM rather than windowed frames: one span per run of
+// consecutive frames of a channel, fftSize + (numFrames - 1) * hopSize samples,
+// packed back to back. runs holds [spanStart, firstFrame, numFrames] per run,
+// ordered by firstFrame (frame indices within the chunk). The table is read
+// into shared memory once per block.
+//==============================================================================
+#define STFT_MAX_RUNS 64
+
+// Cut and window every frame of the chunk; frames past numFrames (the rest of
+// the FFT plan's batch) are cleared
+__global__ void stftWindowFrames(
+    const float* __restrict__ spans,
+    const int* __restrict__ runs,
+    int numRuns,
+    const float* __restrict__ window,
+    float* __restrict__ frames,
+    int fftSize,
+    int hopSize,
+    int numFrames,
+    int batchFrames)
+{
+    __shared__ int localRuns[3 * STFT_MAX_RUNS];
+
+    for (int i = threadIdx.x; i < 3 * numRuns; i += blockDim.x)
+        localRuns[i] = runs[i];
+
+    __syncthreads();
+
+    int idx = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (idx >= batchFrames * fftSize)
+        return;
+
+    int frame = idx / fftSize;
+    int i = idx - frame * fftSize;
+    float value = 0.0f;
+
+    if (frame < numFrames)
+    {
+        int run = 0;
+        while (run + 1 < numRuns && frame >= localRuns[3 * (run + 1) + 1])
+            ++run;
+
+        int runFrame = frame - localRuns[3 * run + 1];
+        value = spans[localRuns[3 * run] + runFrame * hopSize + i] * __ldg(&window[i]);
+    }
+
+    frames[idx] = value;
+}
+
+// Synthesis window and overlap-add of each run's frames into its span, gathered
+// per output sample so no atomics are needed. The window includes the 1 / fftSize
+// of the unnormalised inverse FFT.
+__global__ void stftOverlapAdd(
+    const float* __restrict__ frames,
+    const int* __restrict__ runs,
+    int numRuns,
+    const float* __restrict__ window,
+    float* __restrict__ spans,
+    int fftSize,
+    int hopSize,
+    int totalLength)
+{
+    __shared__ int localRuns[3 * STFT_MAX_RUNS];
+
+    for (int i = threadIdx.x; i < 3 * numRuns; i += blockDim.x)
+        localRuns[i] = runs[i];
+
+    __syncthreads();
+
+    int idx = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (idx >= totalLength)
+        return;
+
+    int run = 0;
+    while (run + 1 < numRuns && idx >= localRuns[3 * (run + 1)])
+        ++run;
+
+    int t = idx - localRuns[3 * run];
+    int firstFrame = localRuns[3 * run + 1];
+    int lastFrame = min(localRuns[3 * run + 2] - 1, t / hopSize);
+    float sum = 0.0f;
+
+    for (int j = t >= fftSize ? (t - fftSize) / hopSize + 1 : 0; j <= lastFrame; ++j)
+    {
+        int k = t - j * hopSize;
+        sum += frames[(firstFrame + j) * fftSize + k] * __ldg(&window[k]);
+    }
+
+    spans[idx] = sum;
+}
+
+//==============================================================================
+// Kernels 4e-4g: Device-resident noise profile
+//
+// The profile stays in device memory while it is captured or adapted. Each
+// kernel runs one thread per bin and walks the batch's frames in order, so
+// the reduction over frames needs no atomics and sums in the same order as
+// the CPU.
+//==============================================================================
+
+// Adds the magnitudes of the first numFrames spectra to a running sum per bin
+__global__ void noiseProfileCapture(
+    const float2* __restrict__ fftData,
+    float* __restrict__ profileSum,
+    int numBins,
+    int numFrames)
+{
+    int bin = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (bin >= numBins)
+        return;
+
+    float sum = profileSum[bin];
+
+    for (int frame = 0; frame < numFrames; ++frame)
+        sum += complexMagnitude(fftData[frame * numBins + bin]);
+
+    profileSum[bin] = sum;
+}
+
+// Averages a finished capture; noiseProfile arrives holding the share summed on the host
+__global__ void noiseProfileFinish(
+    float* __restrict__ noiseProfile,
+    const float* __restrict__ profileSum,
+    int numFrames,
+    int numBins)
+{
+    int bin = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (bin >= numBins)
+        return;
+
+    noiseProfile[bin] = (noiseProfile[bin] + __ldg(&profileSum[bin])) / (float)numFrames;
+}
+
+// Spectral subtraction with the adaptive profile update of the CPU path: a bin
+// below threshold * profile counts as noise and pulls the profile towards its
+// magnitude by rate, frame by frame, before that frame's gain is computed
+__global__ void spectralSubtractionAdaptive(
+    const float2* fftData,
+    float* __restrict__ noiseProfile,
+    float2* outputFFT,
+    float reductionFactor,
+    float spectralFloor,
+    float adaptiveRate,
+    float adaptiveThreshold,
+    int numBins,
+    int numFrames)
+{
+    int bin = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (bin >= numBins)
+        return;
+
+    float profile = noiseProfile[bin];
+
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        int idx = frame * numBins + bin;
+        float2 complex = fftData[idx];
+        float mag = complexMagnitude(complex);
+
+        if (mag <= profile * adaptiveThreshold)
+            profile += adaptiveRate * (mag - profile);
+
+        float noiseMag = profile * reductionFactor;
+        float gain = mag > 1.0e-12f ? fmaxf(1.0f - noiseMag / mag, spectralFloor) : spectralFloor;
+
+        outputFFT[idx] = make_float2(complex.x * gain, complex.y * gain);
+    }
+
+    noiseProfile[bin] = profile;
+}
+
 //==============================================================================
 // Kernel 5: Noise profile accumulation with warp shuffle
 //==============================================================================
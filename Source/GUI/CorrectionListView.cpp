@@ -1,4 +1,5 @@
 #include "CorrectionListView.h"
+#include <algorithm>
 
 CorrectionListView::CorrectionListView()
 {
@@ -24,55 +25,146 @@ CorrectionListView::CorrectionListView()
 void CorrectionListView::addCorrection (int64_t position, float magnitude, int width,
                                        const juce::String& type, bool applied)
 {
-    corrections.emplace_back (position, magnitude, width, type, applied);
+    // Inserted at its sorted position
+    corrections->insert (position, width, magnitude, type == "Manual", applied);
 
-    // Sort by position
-    std::sort (corrections.begin(), corrections.end(),
-               [](const Correction& a, const Correction& b) { return a.position < b.position; });
+    updateRows();
+    repaint();
+}
 
-    table.updateContent();
+void CorrectionListView::setCorrections (ClickStore&& store)
+{
+    store.sortByPosition();
+    corrections = std::make_shared<ClickStore> (std::move (store));
+
+    updateRows();
     repaint();
 }
 
+CorrectionListView::Correction CorrectionListView::getCorrection (int index) const
+{
+    const auto i = static_cast<size_t> (index);
+    return Correction (corrections->getPosition (i), corrections->getMagnitude (i), corrections->getWidth (i),
+                       corrections->isManual (i) ? "Manual" : "Auto", corrections->isApplied (i));
+}
+
 void CorrectionListView::clearCorrections()
 {
-    corrections.clear();
-    table.updateContent();
+    corrections->clear();
+    updateRows();
     repaint();
 }
 
 void CorrectionListView::markAllApplied()
 {
-    for (auto& correction : corrections)
-    {
-        correction.applied = true;
-    }
+    corrections->markAllApplied();
     table.updateContent();
     repaint();
 }
 
 void CorrectionListView::removeCorrection (int index)
 {
-    if (index >= 0 && index < static_cast<int> (corrections.size()))
+    if (index >= 0 && index < static_cast<int> (corrections->size()))
     {
-        corrections.erase (corrections.begin() + index);
-        table.updateContent();
+        corrections->erase (static_cast<size_t> (index));
+        updateRows();
         repaint();
     }
 }
 
 void CorrectionListView::updateCorrection (int index, int64_t newPosition, float newMagnitude, int newWidth)
 {
-    if (index >= 0 && index < static_cast<int> (corrections.size()))
+    if (index >= 0 && index < static_cast<int> (corrections->size()))
     {
-        corrections[index].position = newPosition;
-        corrections[index].magnitude = newMagnitude;
-        corrections[index].width = newWidth;
-        table.updateContent();
+        // Re-inserted so the list stays sorted by position
+        const auto i = static_cast<size_t> (index);
+        const bool isManual = corrections->isManual (i);
+        const bool isApplied = corrections->isApplied (i);
+
+        corrections->erase (i);
+        corrections->insert (newPosition, newWidth, newMagnitude, isManual, isApplied);
+        updateRows();
         repaint();
     }
 }
 
+void CorrectionListView::setFilter (float minimumMagnitude, bool manualOnly)
+{
+    filterMinimumMagnitude = juce::jmax (0.0f, minimumMagnitude);
+    filterManualOnly = manualOnly;
+    updateRows();
+}
+
+void CorrectionListView::sortOrderChanged (int newSortColumnId, bool isForwards)
+{
+    sortColumnId = newSortColumnId;
+    sortForwards = isForwards;
+    updateRows();
+}
+
+int CorrectionListView::getStoreIndex (int rowNumber) const
+{
+    const int numRows = usesStoreOrder() ? static_cast<int> (corrections->size()) : static_cast<int> (rowIndex.size());
+
+    if (rowNumber < 0 || rowNumber >= numRows)
+        return -1;
+
+    if (usesStoreOrder())
+        return sortForwards ? rowNumber : numRows - 1 - rowNumber;
+
+    return static_cast<int> (rowIndex[static_cast<size_t> (rowNumber)]);
+}
+
+void CorrectionListView::updateRows()
+{
+    rowIndex.clear();
+
+    if (!usesStoreOrder())
+    {
+        // One pass over the store for the filter, then a sort of indices only
+        rowIndex.reserve (corrections->size());
+        corrections->forEach (0, corrections->size(), [this] (size_t i, int64_t, int, float magnitude, bool isManual, bool)
+        {
+            if (magnitude >= filterMinimumMagnitude && (isManual || !filterManualOnly))
+                rowIndex.push_back (static_cast<uint32_t> (i));
+        });
+
+        const auto& store = *corrections;
+
+        // Stable, and the store is in time order, so equal keys stay in time order
+        switch (sortColumnId)
+        {
+            case MagnitudeColumn:
+                std::stable_sort (rowIndex.begin(), rowIndex.end(), [&store] (uint32_t a, uint32_t b)
+                                  { return store.getMagnitude (a) < store.getMagnitude (b); });
+                break;
+
+            case WidthColumn:
+                std::stable_sort (rowIndex.begin(), rowIndex.end(), [&store] (uint32_t a, uint32_t b)
+                                  { return store.getWidth (a) < store.getWidth (b); });
+                break;
+
+            case TypeColumn:
+                std::stable_partition (rowIndex.begin(), rowIndex.end(), [&store] (uint32_t i) { return !store.isManual (i); });
+                break;
+
+            case AppliedColumn:
+                std::stable_partition (rowIndex.begin(), rowIndex.end(), [&store] (uint32_t i) { return !store.isApplied (i); });
+                break;
+
+            default:
+                break;
+        }
+
+        if (!sortForwards)
+            std::reverse (rowIndex.begin(), rowIndex.end());
+    }
+
+    table.deselectAllRows();
+    table.updateContent();
+    repaint();
+}
+
 void CorrectionListView::resized()
 {
     auto bounds = getLocalBounds();
@@ -97,7 +189,7 @@ void CorrectionListView::paint (juce::Graphics& g)
 
 int CorrectionListView::getNumRows()
 {
-    return static_cast<int> (corrections.size());
+    return usesStoreOrder() ? static_cast<int> (corrections->size()) : static_cast<int> (rowIndex.size());
 }
 
 void CorrectionListView::paintRowBackground (juce::Graphics& g, int rowNumber,
@@ -112,10 +204,12 @@ void CorrectionListView::paintRowBackground (juce::Graphics& g, int rowNumber,
 void CorrectionListView::paintCell (juce::Graphics& g, int rowNumber, int columnId,
                                    int width, int height, bool rowIsSelected)
 {
-    if (rowNumber >= static_cast<int> (corrections.size()))
+    const int index = getStoreIndex (rowNumber);
+
+    if (index < 0)
         return;
 
-    const auto& correction = corrections[rowNumber];
+    const auto correction = getCorrection (index);
 
     g.setColour (rowIsSelected ? juce::Colours::black : juce::Colour (0xff222222));
     g.setFont (14.0f);
@@ -151,9 +245,11 @@ void CorrectionListView::paintCell (juce::Graphics& g, int rowNumber, int column
 
 void CorrectionListView::cellClicked (int rowNumber, int columnId, const juce::MouseEvent& event)
 {
-    if (rowNumber >= 0 && rowNumber < static_cast<int> (corrections.size()))
+    const int index = getStoreIndex (rowNumber);
+
+    if (index >= 0)
     {
-        const auto& correction = corrections[rowNumber];
+        const auto correction = getCorrection (index);
 
         // Right-click: show context menu
         if (event.mods.isRightButtonDown())
@@ -170,16 +266,20 @@ void CorrectionListView::cellClicked (int rowNumber, int columnId, const juce::M
             menu.addItem (6, "Delete All Corrections");
             menu.addSeparator();
             menu.addItem (7, "Go to Position");
+            menu.addSeparator();
+            menu.addItem (8, "Show Only Magnitude " + juce::String (correction.magnitude, 2) + " and Above");
+            menu.addItem (9, "Show Only Manual Corrections", true, filterManualOnly);
+            menu.addItem (10, "Show All Corrections", isFiltered());
 
-            int selectedRow = rowNumber;  // Capture for lambda
+            int selectedRow = index;  // Store index, which a re-sort does not change
             menu.showMenuAsync (juce::PopupMenu::Options().withTargetScreenArea (
                 juce::Rectangle<int> (event.getScreenX(), event.getScreenY(), 1, 1)),
                 [this, selectedRow] (int result)
                 {
-                    if (selectedRow < 0 || selectedRow >= static_cast<int> (corrections.size()))
+                    if (selectedRow < 0 || selectedRow >= static_cast<int> (corrections->size()))
                         return;
 
-                    const auto& corr = corrections[selectedRow];
+                    const auto corr = getCorrection (selectedRow);
 
                     switch (result)
                     {
@@ -218,6 +318,18 @@ void CorrectionListView::cellClicked (int rowNumber, int columnId, const juce::M
                             if (onCorrectionSelected)
                                 onCorrectionSelected (corr.position);
                             break;
+
+                        case 8: // Filter by magnitude
+                            setFilter (corr.magnitude, filterManualOnly);
+                            break;
+
+                        case 9: // Filter manual
+                            setFilter (filterMinimumMagnitude, !filterManualOnly);
+                            break;
+
+                        case 10: // Show All
+                            clearFilter();
+                            break;
                     }
                 });
 
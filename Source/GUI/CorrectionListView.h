@@ -1,6 +1,9 @@
 #pragma once
 
 #include <juce_gui_basics/juce_gui_basics.h>
+#include "../DSP/ClickEvents.h"
+#include <memory>
+#include <vector>
 
 /**
  * Correction List View Component
@@ -16,6 +19,12 @@
  * - Right-click context menu
  * - Filter criteria
  *
+ * Rows are read straight from a ClickStore, which the waveform display can
+ * share, so large scans are neither copied nor converted per row. The table
+ * only paints the rows in view; sorting and filtering build an index of
+ * store positions rather than reordering or copying the store, and sorting
+ * by time needs no index at all, since the store is kept in time order.
+ *
  * Standalone mode only.
  */
 class CorrectionListView : public juce::Component,
@@ -41,8 +50,16 @@ public:
                        const juce::String& type = "Auto", bool applied = false);
     void clearCorrections();
     void markAllApplied();
-    int getNumCorrections() const { return corrections.size(); }
-    const Correction& getCorrection (int index) const { return corrections[index]; }
+    int getNumCorrections() const { return static_cast<int> (corrections->size()); }
+
+    /** A correction by store index (rows map to store indices through the sort and filter) */
+    Correction getCorrection (int index) const;
+
+    /** Replace all corrections with a scan result (moved, not copied) */
+    void setCorrections (ClickStore&& store);
+
+    /** Shared read-only view of the corrections, e.g. for WaveformDisplay */
+    std::shared_ptr<const ClickStore> getCorrectionStore() const { return corrections; }
 
     /** Set sample rate for time display */
     void setSampleRate (double sr) { sampleRate = sr; }
@@ -56,6 +73,11 @@ public:
     /** Set callback for audition request (play audio around correction) */
     std::function<void(int64_t position, float durationSec)> onAuditionCorrection;
 
+    /** Show only corrections at or above a magnitude, optionally manual ones only */
+    void setFilter (float minimumMagnitude, bool manualOnly);
+    void clearFilter() { setFilter (0.0f, false); }
+    bool isFiltered() const { return filterMinimumMagnitude > 0.0f || filterManualOnly; }
+
     /** Set callback for delete correction request */
     std::function<void(int index)> onDeleteCorrection;
 
@@ -78,17 +100,33 @@ public:
     void paintRowBackground (juce::Graphics& g, int rowNumber, int width, int height, bool rowIsSelected) override;
     void paintCell (juce::Graphics& g, int rowNumber, int columnId, int width, int height, bool rowIsSelected) override;
     void cellClicked (int rowNumber, int columnId, const juce::MouseEvent& event) override;
+    void sortOrderChanged (int newSortColumnId, bool isForwards) override;
     juce::Component* refreshComponentForCell (int rowNumber, int columnId, bool isRowSelected,
                                               juce::Component* existingComponentToUpdate) override;
 
 private:
     juce::String formatTime (int64_t samplePosition);
 
+    /** True while rows are the store's own order (by time, unfiltered), with no index */
+    bool usesStoreOrder() const { return sortColumnId == TimeColumn && !isFiltered(); }
+
+    /** Store index of a table row, or -1 */
+    int getStoreIndex (int rowNumber) const;
+
+    /** Rebuilds the row index after the store, sort or filter changed */
+    void updateRows();
+
     juce::TableListBox table;
-    std::vector<Correction> corrections;
+    std::shared_ptr<ClickStore> corrections = std::make_shared<ClickStore>();
     double sampleRate = 44100.0;
     juce::String statusText = "Ready";
 
+    std::vector<uint32_t> rowIndex;     // Store indices in row order, unless usesStoreOrder()
+    int sortColumnId = TimeColumn;
+    bool sortForwards = true;
+    float filterMinimumMagnitude = 0.0f;
+    bool filterManualOnly = false;
+
     enum ColumnIds
     {
         TimeColumn = 1,
@@ -131,104 +131,6 @@ namespace
     }
 }
 
-class SettingsComponent::ProviderTestThread : public juce::Thread
-{
-public:
-    ProviderTestThread (SettingsComponent& ownerToUse,
-                        const SettingsManager::DenoiseSettings& settingsToUse,
-                        const std::vector<ProviderEntry>& providersToUse)
-        : juce::Thread ("ProviderTestThread"),
-          owner (ownerToUse),
-          settings (settingsToUse),
-          providers (providersToUse)
-    {
-    }
-
-    void run() override
-    {
-        struct ProviderResult
-        {
-            juce::String name;
-            bool success = false;
-            double elapsedMs = 0.0;
-        };
-
-        std::vector<ProviderResult> results;
-
-        auto buildReport = [&results]()
-        {
-            juce::String report;
-            for (const auto& result : results)
-            {
-                report += result.name + ": " + (result.success ? "OK" : "Failed");
-                if (result.success)
-                    report += " (" + juce::String (result.elapsedMs, 2) + " ms)";
-                report += "\n";
-            }
-            return report;
-        };
-
-        auto publishReport = [this, &buildReport, &results](bool isFinal)
-        {
-            auto report = buildReport();
-            if (report.isEmpty())
-                report = "No results. Test canceled.";
-            juce::MessageManager::callAsync ([this, report, isFinal]()
-            {
-                owner.testResultsEditor.setText (report, juce::dontSendNotification);
-                if (isFinal)
-                    owner.providerTestThread.reset();
-            });
-        };
-
-        for (const auto& entry : providers)
-        {
-            if (threadShouldExit())
-                break;
-
-            ProviderResult result;
-            result.name = entry.label;
-            try
-            {
-                OnnxDenoiser tester;
-                tester.setPreferredProvider (entry.provider);
-                tester.setAllowFallback (false);
-                tester.setDmlDeviceId (settings.dmlDeviceId);
-                tester.setQnnBackendPath (settings.qnnBackendPath);
-                if (settings.modelPath.isNotEmpty())
-                    tester.setModelPath (juce::File (settings.modelPath));
-
-                tester.prepare (48000.0, 1, 480);
-                tester.setEnabled (true);
-
-                juce::AudioBuffer<float> buffer (1, 480);
-                buffer.clear();
-
-                auto start = juce::Time::getMillisecondCounterHiRes();
-                tester.processBlock (buffer, 1.0f);
-                auto elapsed = juce::Time::getMillisecondCounterHiRes() - start;
-
-                result.success = tester.isReady();
-                result.elapsedMs = elapsed;
-            }
-            catch (...)
-            {
-                result.success = false;
-                result.elapsedMs = 0.0;
-            }
-            results.push_back (result);
-            publishReport (false);
-        }
-
-        publishReport (true);
-    }
-
-private:
-    SettingsComponent& owner;
-    SettingsManager::DenoiseSettings settings;
-    std::vector<ProviderEntry> providers;
-};
-
 SettingsComponent::SettingsComponent (ApplyCallback onApplyCallback,
                                       ProviderCallback activeProviderCallback,
                                       bool allowInstallActionsIn)
@@ -265,7 +167,10 @@ SettingsComponent::SettingsComponent (ApplyCallback onApplyCallback,
     fallbackToggle.setButtonText ("Allow fallback if provider fails");
     aiPanel.addAndMakeVisible (fallbackToggle);
 
-    aiHintLabel.setText ("Auto tries QNN -> DML -> CPU. QNN requires a backend DLL from the QNN SDK.", juce::dontSendNotification);
+    asyncInferenceToggle.setButtonText ("Run inference on a background thread (adds latency, avoids dropouts)");
+    aiPanel.addAndMakeVisible (asyncInferenceToggle);
+
+    aiHintLabel.setText ("Auto uses the fastest provider measured on this machine, then QNN -> DML -> CPU. QNN requires a backend DLL from the QNN SDK.", juce::dontSendNotification);
     aiHintLabel.setColour (juce::Label::textColourId, juce::Colours::lightgrey);
     aiPanel.addAndMakeVisible (aiHintLabel);
 
@@ -301,9 +206,19 @@ SettingsComponent::SettingsComponent (ApplyCallback onApplyCallback,
 
     testResultsEditor.setMultiLine (true);
     testResultsEditor.setReadOnly (true);
-    testResultsEditor.setText ("Run tests to benchmark providers.\n");
     aiPanel.addAndMakeVisible (testResultsEditor);
 
+    // Replaces the stored result, so Auto follows it once applied
+    providerBenchmark.onFinished = [this] (const SettingsManager::ProviderBenchmarkRecord& record)
+    {
+        showBenchmarkResults (record);
+        if (onApply)
+            onApply();
+        updateActiveProviderLabel();
+    };
+
+    showBenchmarkResults (SettingsManager::getInstance().getProviderBenchmark());
+
     activeProviderLabel.setText ("Active provider: -", juce::dontSendNotification);
     aiPanel.addAndMakeVisible (activeProviderLabel);
 
@@ -337,6 +252,25 @@ SettingsComponent::SettingsComponent (ApplyCallback onApplyCallback,
     depsPanel.addAndMakeVisible (installMp3Button);
     installMp3Button.setEnabled (allowInstallActions);
 
+    threadsLabel.setText ("Inference Threads", juce::dontSendNotification);
+    advancedPanel.addAndMakeVisible (threadsLabel);
+    threadsSlider.setRange (1, juce::jmax (1, juce::SystemStats::getNumCpus()), 1);
+    threadsSlider.setSliderStyle (juce::Slider::IncDecButtons);
+    threadsSlider.setTextBoxStyle (juce::Slider::TextBoxLeft, false, 60, 20);
+    advancedPanel.addAndMakeVisible (threadsSlider);
+
+    spinningToggle.setButtonText ("Let idle inference threads spin (lower latency, more CPU)");
+    advancedPanel.addAndMakeVisible (spinningToggle);
+
+    affinityLabel.setText ("Thread Affinity", juce::dontSendNotification);
+    advancedPanel.addAndMakeVisible (affinityLabel);
+    affinityEditor.setTextToShowWhenEmpty ("e.g. 3;4 (one group per extra thread)", juce::Colours::grey);
+    advancedPanel.addAndMakeVisible (affinityEditor);
+
+    threadsHintLabel.setText ("One thread pool is shared by every instance. Changes apply after restarting the host or app.", juce::dontSendNotification);
+    threadsHintLabel.setColour (juce::Label::textColourId, juce::Colours::lightgrey);
+    advancedPanel.addAndMakeVisible (threadsHintLabel);
+
     settingsPathLabel.setText ("Settings file: -", juce::dontSendNotification);
     advancedPanel.addAndMakeVisible (settingsPathLabel);
     resetButton.addListener (this);
@@ -383,6 +317,7 @@ void SettingsComponent::resized()
 
     aiArea.removeFromTop (8);
     fallbackToggle.setBounds (aiArea.removeFromTop (24));
+    asyncInferenceToggle.setBounds (aiArea.removeFromTop (24));
 
     aiArea.removeFromTop (4);
     aiHintLabel.setBounds (aiArea.removeFromTop (32));
@@ -413,7 +348,7 @@ void SettingsComponent::resized()
     modelPathBrowseButton.setBounds (row.removeFromLeft (100));
 
     aiArea.removeFromTop (8);
-    testProvidersButton.setBounds (aiArea.removeFromTop (28).removeFromLeft (140));
+    testProvidersButton.setBounds (aiArea.removeFromTop (28).removeFromLeft (160));
 
     aiArea.removeFromTop (8);
     activeProviderLabel.setBounds (aiArea.removeFromTop (22));
@@ -438,6 +373,22 @@ void SettingsComponent::resized()
     installMp3Button.setBounds (depsRow.removeFromLeft (170));
 
     auto advArea = advancedPanel.getLocalBounds().reduced (12);
+    auto advRow = advArea.removeFromTop (26);
+    threadsLabel.setBounds (advRow.removeFromLeft (160));
+    threadsSlider.setBounds (advRow.removeFromLeft (200));
+
+    advArea.removeFromTop (8);
+    spinningToggle.setBounds (advArea.removeFromTop (24));
+
+    advArea.removeFromTop (8);
+    advRow = advArea.removeFromTop (26);
+    affinityLabel.setBounds (advRow.removeFromLeft (160));
+    affinityEditor.setBounds (advRow.removeFromLeft (360));
+
+    advArea.removeFromTop (4);
+    threadsHintLabel.setBounds (advArea.removeFromTop (32));
+
+    advArea.removeFromTop (12);
     settingsPathLabel.setBounds (advArea.removeFromTop (22));
     advArea.removeFromTop (12);
     resetButton.setBounds (advArea.removeFromTop (28).removeFromLeft (160));
@@ -600,6 +551,10 @@ void SettingsComponent::loadFromSettings()
     }
 
     fallbackToggle.setToggleState (settings.allowFallback, juce::dontSendNotification);
+    asyncInferenceToggle.setToggleState (settings.asyncInference, juce::dontSendNotification);
+    threadsSlider.setValue (settings.intraOpThreads, juce::dontSendNotification);
+    spinningToggle.setToggleState (settings.allowSpinning, juce::dontSendNotification);
+    affinityEditor.setText (settings.threadAffinity, juce::dontSendNotification);
     dmlDeviceSlider.setValue (settings.dmlDeviceId, juce::dontSendNotification);
     qnnBackendEditor.setText (settings.qnnBackendPath, juce::dontSendNotification);
     modelPathEditor.setText (settings.modelPath, juce::dontSendNotification);
@@ -616,6 +571,10 @@ void SettingsComponent::saveToSettings()
         settings.provider = OnnxDenoiser::providerToString (providerEntries[(size_t) index].provider);
 
     settings.allowFallback = fallbackToggle.getToggleState();
+    settings.asyncInference = asyncInferenceToggle.getToggleState();
+    settings.intraOpThreads = (int) threadsSlider.getValue();
+    settings.allowSpinning = spinningToggle.getToggleState();
+    settings.threadAffinity = affinityEditor.getText().trim();
     settings.dmlDeviceId = (int) dmlDeviceSlider.getValue();
     settings.qnnBackendPath = qnnBackendEditor.getText().trim();
     settings.modelPath = modelPathEditor.getText().trim();
@@ -783,12 +742,19 @@ void SettingsComponent::updateActiveProviderLabel()
 
 void SettingsComponent::runProviderTests()
 {
-    SettingsManager::DenoiseSettings settings = SettingsManager::getInstance().getDenoiseSettings();
-    testResultsEditor.setText ("Running provider tests...\n");
+    testResultsEditor.setText ("Benchmarking providers (one session each, this can take a while)...\n");
+    providerBenchmark.start (SettingsManager::getInstance().getDenoiseSettings());
+}
 
-    if (providerTestThread != nullptr)
-        providerTestThread->signalThreadShouldExit();
+void SettingsComponent::showBenchmarkResults (const SettingsManager::ProviderBenchmarkRecord& record)
+{
+    if (record.report.isEmpty())
+    {
+        testResultsEditor.setText ("Run tests to benchmark providers.\n", juce::dontSendNotification);
+        return;
+    }
 
-    providerTestThread = std::make_unique<ProviderTestThread> (*this, settings, providerEntries);
-    providerTestThread->startThread();
+    const auto winner = record.winner.isNotEmpty() ? record.winner : juce::String ("fallback order");
+    testResultsEditor.setText ("Last benchmark:\n" + record.report + "\nAuto uses: " + winner + "\n",
+                               juce::dontSendNotification);
 }
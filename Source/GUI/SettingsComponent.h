@@ -3,6 +3,7 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "../DSP/OnnxDenoiser.h"
 #include "../Utils/SettingsManager.h"
+#include "../Utils/ProviderBenchmarkRunner.h"
 
 class SettingsComponent : public juce::Component,
                           private juce::Button::Listener,
@@ -35,6 +36,7 @@ private:
     void refreshDmlDeviceList();
     void updateActiveProviderLabel();
     void runProviderTests();
+    void showBenchmarkResults (const SettingsManager::ProviderBenchmarkRecord& record);
 
     juce::String getProviderLabel (OnnxDenoiser::Provider provider) const;
     bool isStandalone() const { return allowInstallActions; }
@@ -53,6 +55,7 @@ private:
     juce::Label providerLabel;
     juce::ComboBox providerBox;
     juce::ToggleButton fallbackToggle;
+    juce::ToggleButton asyncInferenceToggle;
     juce::Label aiHintLabel;
 
     juce::Label dmlDeviceLabel;
@@ -68,7 +71,7 @@ private:
     juce::TextEditor modelPathEditor;
     juce::TextButton modelPathBrowseButton { "Browse..." };
 
-    juce::TextButton testProvidersButton { "Test Providers" };
+    juce::TextButton testProvidersButton { "Benchmark Providers" };
     juce::TextEditor testResultsEditor;
 
     juce::Label activeProviderLabel;
@@ -82,6 +85,12 @@ private:
     juce::TextButton installMp3Button { "Install MP3 (vcpkg)" };
 
     // Advanced panel
+    juce::Label threadsLabel;
+    juce::Slider threadsSlider;
+    juce::ToggleButton spinningToggle;
+    juce::Label affinityLabel;
+    juce::TextEditor affinityEditor;
+    juce::Label threadsHintLabel;
     juce::Label settingsPathLabel;
     juce::TextButton resetButton { "Reset Settings" };
 
@@ -90,8 +99,7 @@ private:
     juce::TextButton closeButton { "Close" };
 
     std::vector<ProviderEntry> providerEntries;
-    class ProviderTestThread;
-    std::unique_ptr<ProviderTestThread> providerTestThread;
+    ProviderBenchmarkRunner providerBenchmark;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SettingsComponent)
 };
@@ -2,9 +2,7 @@
 
 SpectrogramDisplay::SpectrogramDisplay()
 {
-    fft = std::make_unique<juce::dsp::FFT> (fftOrder);
-    window = std::make_unique<juce::dsp::WindowingFunction<float>> (
-        fftSize, juce::dsp::WindowingFunction<float>::hann);
+    updatePaletteTable();
 
     setOpaque (true);
     startTimerHz (30);  // Update at 30fps during analysis
@@ -12,16 +10,29 @@ SpectrogramDisplay::SpectrogramDisplay()
 
 SpectrogramDisplay::~SpectrogramDisplay()
 {
-    stopAnalysis();
     stopTimer();
+
+    // An owned cache's workers read audioData, so it goes first
+    detachTileCache();
+}
+
+void SpectrogramDisplay::detachTileCache()
+{
+    if (tileCache != nullptr)
+        tileCache->removeChangeListener (this);
+
+    tileCache.reset();
+    ownsTileCache = false;
 }
 
-void SpectrogramDisplay::stopAnalysis()
+juce::Rectangle<int> SpectrogramDisplay::getSpectrogramArea() const
 {
-    analyzing.store (false);
-    if (analysisThread && analysisThread->joinable())
-        analysisThread->join();
-    analysisThread.reset();
+    if (showAxes)
+        return getLocalBounds().reduced (leftMargin, topMargin)
+                               .withTrimmedRight (rightMargin)
+                               .withTrimmedBottom (bottomMargin);
+
+    return getLocalBounds().reduced (4);
 }
 
 void SpectrogramDisplay::paint (juce::Graphics& g)
@@ -32,49 +43,33 @@ void SpectrogramDisplay::paint (juce::Graphics& g)
     g.fillAll (juce::Colour (0xff1a1a2e));
 
     // Calculate spectrogram area
-    juce::Rectangle<int> spectrogramArea = bounds;
-    if (showAxes)
-    {
-        spectrogramArea = bounds.reduced (leftMargin, topMargin)
-                                  .withTrimmedRight (rightMargin)
-                                  .withTrimmedBottom (bottomMargin);
-    }
-    else
-    {
-        spectrogramArea = bounds.reduced (4);
-    }
+    const auto spectrogramArea = getSpectrogramArea();
 
-    if (imageReady.load() && spectrogramImage.isValid())
+    if (spectrogramImage.isValid())
     {
-        // Draw the spectrogram image
+        // Draw the spectrogram image; tiles still being computed are black
         g.drawImage (spectrogramImage, spectrogramArea.toFloat(),
                      juce::RectanglePlacement::stretchToFit);
     }
-    else if (analyzing.load())
+    else if (audioLength == 0)
     {
-        // Show progress
-        g.setColour (juce::Colours::white);
-        g.setFont (14.0f);
-        int percent = static_cast<int> (analysisProgress.load() * 100.0f);
-        g.drawText ("Analyzing: " + juce::String (percent) + "%",
+        // No audio loaded
+        g.setColour (juce::Colours::grey);
+        g.setFont (16.0f);
+        g.drawText ("Load an audio file to view spectrogram",
                     spectrogramArea, juce::Justification::centred);
+    }
 
+    if (analyzing)
+    {
         // Progress bar
         auto progressBounds = spectrogramArea.withSizeKeepingCentre (200, 8);
         g.setColour (juce::Colour (0xff333355));
         g.fillRoundedRectangle (progressBounds.toFloat(), 4.0f);
         g.setColour (juce::Colour (0xff6699ff));
-        progressBounds.setWidth (static_cast<int> (progressBounds.getWidth() * analysisProgress.load()));
+        progressBounds.setWidth (static_cast<int> (progressBounds.getWidth() * analysisProgress));
         g.fillRoundedRectangle (progressBounds.toFloat(), 4.0f);
     }
-    else if (audioData.getNumSamples() == 0)
-    {
-        // No audio loaded
-        g.setColour (juce::Colours::grey);
-        g.setFont (16.0f);
-        g.drawText ("Load an audio file to view spectrogram",
-                    spectrogramArea, juce::Justification::centred);
-    }
 
     // Draw border around spectrogram
     g.setColour (juce::Colour (0xff444466));
@@ -91,36 +86,79 @@ void SpectrogramDisplay::paint (juce::Graphics& g)
 
 void SpectrogramDisplay::resized()
 {
-    // Regenerate spectrogram at new size if we have data
-    if (audioData.getNumSamples() > 0 && !analyzing.load())
-    {
-        generateSpectrogram();
-    }
+    // Re-render at the new size from the tiles already computed
+    imageNeedsRender = true;
 }
 
 void SpectrogramDisplay::timerCallback()
 {
-    if (analyzing.load())
+    if (imageNeedsRender)
+    {
+        renderImage();
         repaint();
+    }
+}
+
+void SpectrogramDisplay::changeListenerCallback (juce::ChangeBroadcaster* source)
+{
+    // Tiles completed or invalidated; the next tick picks them up
+    if (tileCache != nullptr && source == tileCache.get())
+        imageNeedsRender = true;
 }
 
 void SpectrogramDisplay::analyzeBuffer (const juce::AudioBuffer<float>& buffer, double sampleRate)
 {
-    stopAnalysis();
+    if (!ownsTileCache)
+    {
+        detachTileCache();
+        tileCache = std::make_shared<SpectrogramTileCache>();
+        tileCache->addChangeListener (this);
+        tileCache->setFftOrder (fftOrder);
+        ownsTileCache = true;
+    }
+
+    {
+        const juce::ScopedLock sl (audioDataLock);
+        audioData.makeCopyOf (buffer);
+    }
+
+    tileCache->setSource (&audioData, sampleRate, &audioDataLock);
+    imageNeedsRender = true;
+}
+
+void SpectrogramDisplay::setTileCache (std::shared_ptr<SpectrogramTileCache> sharedCache)
+{
+    detachTileCache();
 
-    audioData.makeCopyOf (buffer);
-    audioSampleRate = sampleRate;
-    imageReady.store (false);
+    {
+        const juce::ScopedLock sl (audioDataLock);
+        audioData.setSize (0, 0);
+    }
+
+    tileCache = std::move (sharedCache);
 
-    generateSpectrogram();
+    if (tileCache != nullptr)
+    {
+        tileCache->addChangeListener (this);
+        fftSize = tileCache->getFftSize();
+        fftOrder = juce::roundToInt (std::log2 (fftSize));
+    }
+
+    imageNeedsRender = true;
 }
 
 void SpectrogramDisplay::clear()
 {
-    stopAnalysis();
-    audioData.setSize (0, 0);
+    detachTileCache();
+
+    {
+        const juce::ScopedLock sl (audioDataLock);
+        audioData.setSize (0, 0);
+    }
+
     spectrogramImage = juce::Image();
-    imageReady.store (false);
+    audioLength = 0;
+    analyzing = false;
     repaint();
 }
 
@@ -129,8 +167,7 @@ void SpectrogramDisplay::setPalette (Palette newPalette)
     if (currentPalette != newPalette)
     {
         currentPalette = newPalette;
-        if (audioData.getNumSamples() > 0 && !analyzing.load())
-            generateSpectrogram();
+        updatePaletteTable();
     }
 }
 
@@ -138,8 +175,7 @@ void SpectrogramDisplay::setDbRange (float lowerDb, float upperDb)
 {
     lowerDbRange = lowerDb;
     upperDbRange = upperDb;
-    if (audioData.getNumSamples() > 0 && !analyzing.load())
-        generateSpectrogram();
+    updatePaletteTable();
 }
 
 void SpectrogramDisplay::setFftSize (int newSize)
@@ -153,12 +189,10 @@ void SpectrogramDisplay::setFftSize (int newSize)
     {
         fftOrder = order;
         fftSize = 1 << fftOrder;
-        fft = std::make_unique<juce::dsp::FFT> (fftOrder);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>> (
-            fftSize, juce::dsp::WindowingFunction<float>::hann);
 
-        if (audioData.getNumSamples() > 0 && !analyzing.load())
-            generateSpectrogram();
+        // Drops the cached tiles; their views recompute what they show
+        if (tileCache != nullptr)
+            tileCache->setFftOrder (fftOrder);
     }
 }
 
@@ -167,127 +201,94 @@ void SpectrogramDisplay::setShowAxes (bool shouldShowAxes)
     if (showAxes != shouldShowAxes)
     {
         showAxes = shouldShowAxes;
-        if (audioData.getNumSamples() > 0 && !analyzing.load())
-            generateSpectrogram();
+        imageNeedsRender = true;
         repaint();
     }
 }
 
-void SpectrogramDisplay::generateSpectrogram()
+void SpectrogramDisplay::updatePaletteTable()
 {
-    if (audioData.getNumSamples() == 0)
-        return;
-
-    stopAnalysis();
+    // One colour per stored 16-bit level, so recolouring never touches a magnitude
+    paletteTable.resize (65536);
+    const float range = juce::jmax (1.0e-3f, upperDbRange - lowerDbRange);
 
-    // Calculate image dimensions
-    auto bounds = getLocalBounds();
-    int imageWidth = bounds.getWidth();
-    int imageHeight = bounds.getHeight();
-    if (showAxes)
+    for (int level = 0; level < 65536; ++level)
     {
-        imageWidth -= (leftMargin + rightMargin);
-        imageHeight -= (topMargin + bottomMargin);
+        const float db = SpectrogramTileCache::toDecibels (static_cast<juce::uint16> (level));
+        paletteTable[static_cast<size_t> (level)] = getColourForLevel (juce::jlimit (0.0f, 1.0f, (db - lowerDbRange) / range));
     }
-    else
+
+    imageNeedsRender = true;
+}
+
+void SpectrogramDisplay::renderImage()
+{
+    imageNeedsRender = false;
+
+    audioLength = tileCache != nullptr ? tileCache->getNumSamples() : 0;
+    audioSampleRate = tileCache != nullptr ? tileCache->getSampleRate() : audioSampleRate;
+
+    const auto area = getSpectrogramArea();
+    const int imageWidth = area.getWidth();
+    const int imageHeight = area.getHeight();
+
+    if (audioLength == 0 || imageWidth < 10 || imageHeight < 10)
     {
-        imageWidth -= 8;
-        imageHeight -= 8;
+        spectrogramImage = juce::Image();
+        analyzing = false;
+        return;
     }
 
-    if (imageWidth < 10 || imageHeight < 10)
-        return;
+    if (spectrogramImage.getWidth() != imageWidth || spectrogramImage.getHeight() != imageHeight)
+        spectrogramImage = juce::Image (juce::Image::RGB, imageWidth, imageHeight, true);
+
+    // The whole file across the image: a grid hop no coarser than one column per pixel
+    const int hop = SpectrogramTileCache::getHopForResolution (static_cast<double> (audioLength) / imageWidth);
+    const juce::int64 numColumns = (audioLength + hop - 1) / hop;
+    const int numBins = tileCache->getNumBins();
+
+    // Map rows to frequency bins (bottom = low freq, top = high freq)
+    std::vector<int> rowBins (static_cast<size_t> (imageHeight));
+    for (int row = 0; row < imageHeight; ++row)
+        rowBins[static_cast<size_t> (row)] = juce::jlimit (0, numBins - 1, static_cast<int> (static_cast<float> (row) / imageHeight * numBins));
 
-    analyzing.store (true);
-    analysisProgress.store (0.0f);
+    juce::Image::BitmapData pixels (spectrogramImage, juce::Image::BitmapData::writeOnly);
+    SpectrogramTileCache::TilePtr tile;
+    juce::int64 tileIndex = -1;
+    int tilesNeeded = 0, tilesMissing = 0;
 
-    // Start analysis in background thread
-    analysisThread = std::make_unique<std::thread> ([this, imageWidth, imageHeight]()
+    for (int x = 0; x < imageWidth; ++x)
     {
-        // Create image
-        juce::Image newImage (juce::Image::RGB, imageWidth, imageHeight, true);
+        const juce::int64 column = static_cast<juce::int64> (x) * numColumns / imageWidth;
 
-        // Mix to mono
-        std::vector<float> monoData (audioData.getNumSamples());
-        for (int i = 0; i < audioData.getNumSamples(); ++i)
+        if (column / SpectrogramTileCache::columnsPerTile != tileIndex)
         {
-            float sample = 0.0f;
-            for (int ch = 0; ch < audioData.getNumChannels(); ++ch)
-                sample += audioData.getSample (ch, i);
-            monoData[i] = sample / static_cast<float> (audioData.getNumChannels());
-        }
+            tileIndex = column / SpectrogramTileCache::columnsPerTile;
+            tile = tileCache->getTile (hop, tileIndex);
+            ++tilesNeeded;
 
-        // Calculate hop size to cover entire file in imageWidth columns
-        int hopSize = static_cast<int> (monoData.size() / imageWidth);
-        hopSize = juce::jmax (1, hopSize);
+            if (tile == nullptr)
+                ++tilesMissing;
+        }
 
-        // FFT buffers
-        std::vector<float> fftData (fftSize * 2, 0.0f);
-        std::vector<float> magnitudes (fftSize / 2);
+        const int columnInTile = static_cast<int> (column % SpectrogramTileCache::columnsPerTile);
 
-        // Process each column
-        for (int col = 0; col < imageWidth; ++col)
+        if (tile == nullptr || columnInTile >= tile->getNumColumns())
         {
-            if (!analyzing.load())
-                break;
-
-            // Get samples for this column
-            int startSample = col * hopSize;
-
-            // Clear and fill FFT buffer
-            std::fill (fftData.begin(), fftData.end(), 0.0f);
-
-            for (int i = 0; i < fftSize && (startSample + i) < static_cast<int> (monoData.size()); ++i)
-                fftData[i] = monoData[startSample + i];
-
-            // Apply window
-            window->multiplyWithWindowingTable (fftData.data(), fftSize);
-
-            // Perform FFT
-            fft->performFrequencyOnlyForwardTransform (fftData.data());
-
-            // Calculate magnitudes in dB
-            for (int bin = 0; bin < fftSize / 2; ++bin)
-            {
-                float magnitude = fftData[bin];
-                float db = juce::Decibels::gainToDecibels (magnitude, lowerDbRange);
-                magnitudes[bin] = db;
-            }
-
-            // Map to image pixels (frequency on Y axis, 0 at bottom)
-            for (int row = 0; row < imageHeight; ++row)
-            {
-                // Map row to frequency bin (bottom = low freq, top = high freq)
-                int y = imageHeight - 1 - row;
-                float binFloat = static_cast<float> (row) / imageHeight * (fftSize / 2);
-                int bin = static_cast<int> (binFloat);
-                bin = juce::jlimit (0, fftSize / 2 - 1, bin);
-
-                // Normalize dB to 0-1 range
-                float db = magnitudes[bin];
-                float level = (db - lowerDbRange) / (upperDbRange - lowerDbRange);
-                level = juce::jlimit (0.0f, 1.0f, level);
-
-                // Get color and set pixel
-                juce::Colour colour = getColourForLevel (level);
-                newImage.setPixelAt (col, y, colour);
-            }
-
-            // Update progress
-            analysisProgress.store (static_cast<float> (col + 1) / imageWidth);
-        }
+            for (int y = 0; y < imageHeight; ++y)
+                pixels.setPixelColour (x, y, juce::Colours::black);
 
-        if (analyzing.load())
-        {
-            spectrogramImage = newImage;
-            imageReady.store (true);
+            continue;
         }
 
-        analyzing.store (false);
+        const auto* levels = tile->getColumn (columnInTile);
+
+        for (int row = 0; row < imageHeight; ++row)
+            pixels.setPixelColour (x, imageHeight - 1 - row, paletteTable[levels[rowBins[static_cast<size_t> (row)]]]);
+    }
 
-        // Trigger repaint on message thread
-        juce::MessageManager::callAsync ([this]() { repaint(); });
-    });
+    analyzing = tilesMissing > 0;
+    analysisProgress = tilesNeeded > 0 ? static_cast<float> (tilesNeeded - tilesMissing) / tilesNeeded : 1.0f;
 }
 
 juce::Colour SpectrogramDisplay::getColourForLevel (float level) const
@@ -454,7 +455,7 @@ void SpectrogramDisplay::drawTimeAxis (juce::Graphics& g, juce::Rectangle<int> a
     g.setColour (juce::Colours::lightgrey);
     g.setFont (10.0f);
 
-    double duration = audioData.getNumSamples() / audioSampleRate;
+    double duration = audioLength / audioSampleRate;
 
     // Determine appropriate time step
     double timeStep;
@@ -3,9 +3,9 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_dsp/juce_dsp.h>
+#include "../Utils/SpectrogramTileCache.h"
+#include <memory>
 #include <vector>
-#include <thread>
-#include <atomic>
 
 /**
  * Spek-style Spectrogram Display
@@ -15,9 +15,14 @@
  * - Frequency on Y-axis (0 to Nyquist, linear scale)
  * - Intensity as color (multiple palettes available)
  * - Axis labels and dB scale
+ *
+ * Columns come from a SpectrogramTileCache, either one of its own over an
+ * analysed copy or one shared with other views of the same buffer; palette
+ * and dB range changes only recolour them.
  */
 class SpectrogramDisplay : public juce::Component,
-                           public juce::Timer
+                           public juce::Timer,
+                           public juce::ChangeListener
 {
 public:
     //==============================================================================
@@ -36,11 +41,15 @@ public:
     void paint (juce::Graphics& g) override;
     void resized() override;
     void timerCallback() override;
+    void changeListenerCallback (juce::ChangeBroadcaster* source) override;
 
     //==============================================================================
     /** Analyze audio buffer and generate spectrogram */
     void analyzeBuffer (const juce::AudioBuffer<float>& buffer, double sampleRate);
 
+    /** Show the tiles of a shared cache instead of analysing a copy */
+    void setTileCache (std::shared_ptr<SpectrogramTileCache> sharedCache);
+
     /** Clear the spectrogram */
     void clear();
 
@@ -58,16 +67,18 @@ public:
     void setShowAxes (bool shouldShowAxes);
     bool getShowAxes() const { return showAxes; }
 
-    /** Get analysis progress (0.0 to 1.0) */
-    float getProgress() const { return analysisProgress.load(); }
+    /** Get analysis progress (0.0 to 1.0): the share of the visible tiles computed */
+    float getProgress() const { return analysisProgress; }
 
     /** Check if analysis is running */
-    bool isAnalyzing() const { return analyzing.load(); }
+    bool isAnalyzing() const { return analyzing; }
 
 private:
     //==============================================================================
-    void generateSpectrogram();
-    void stopAnalysis();
+    juce::Rectangle<int> getSpectrogramArea() const;
+    void renderImage();
+    void updatePaletteTable();
+    void detachTileCache();
     juce::Colour getColourForLevel (float level) const;
     juce::Colour getSpectrumPaletteColour (float level) const;
     juce::Colour getSoxPaletteColour (float level) const;
@@ -81,22 +92,26 @@ private:
     juce::String formatTime (double seconds) const;
 
     //==============================================================================
-    // Audio data
+    // Audio data (analyzeBuffer() copies; a shared cache reads its own source)
     juce::AudioBuffer<float> audioData;
+    juce::CriticalSection audioDataLock;
     double audioSampleRate = 44100.0;
+    juce::int64 audioLength = 0;
 
     // FFT
     int fftOrder = 11;  // 2048 point FFT
     int fftSize = 1 << fftOrder;
-    std::unique_ptr<juce::dsp::FFT> fft;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
 
-    // Spectrogram image
+    // Magnitude tiles
+    std::shared_ptr<SpectrogramTileCache> tileCache;
+    bool ownsTileCache = false;
+
+    // Spectrogram image, recoloured from the tiles through a table of every level
     juce::Image spectrogramImage;
-    std::atomic<bool> imageReady {false};
-    std::atomic<bool> analyzing {false};
-    std::atomic<float> analysisProgress {0.0f};
-    std::unique_ptr<std::thread> analysisThread;
+    std::vector<juce::Colour> paletteTable;
+    bool imageNeedsRender = false;
+    bool analyzing = false;
+    float analysisProgress = 0.0f;
 
     // Display settings
     Palette currentPalette = Palette::Spectrum;
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <juce_gui_basics/juce_gui_basics.h>
-#include <juce_dsp/juce_dsp.h>
+#include "../DSP/VisualizationTap.h"
 #include <array>
 
 /**
@@ -9,15 +9,14 @@
  *
  * Displays frequency spectrum with vertical bars behind EQ sliders.
  * Color gradient: Blue (low) -> Green (mid) -> Red (high)
+ *
+ * The bands come from a VisualizationTap, analysed off the message thread.
  */
 class SpectrumAnalyzer : public juce::Component
 {
 public:
     SpectrumAnalyzer()
     {
-        // Initialize FFT for spectrum analysis
-        fft = std::make_unique<juce::dsp::FFT>(fftOrder);
-
         // Clear spectrum data
         for (auto& level : spectrumLevels)
             level = 0.0f;
@@ -25,7 +24,10 @@ public:
         setOpaque (false); // Transparent background
     }
 
-    ~SpectrumAnalyzer() override = default;
+    ~SpectrumAnalyzer() override
+    {
+        setSource (nullptr);
+    }
 
     //==============================================================================
     void paint (juce::Graphics& g) override
@@ -99,124 +101,35 @@ public:
     }
 
     //==============================================================================
-    /** Push audio samples for spectrum analysis */
-    void pushAudioSamples (const juce::AudioBuffer<float>& buffer, int numSamples)
+    /**
+     * Shows the bands of a tap (nullptr for none), running its spectrum
+     * analysis while attached. The tap must outlive the analyzer or be
+     * detached first.
+     */
+    void setSource (VisualizationTap* tapToShow)
     {
-        if (numSamples == 0)
-            return;
-
-        // Mix to mono and push to FIFO
-        for (int i = 0; i < numSamples; ++i)
-        {
-            float monoSample = 0.0f;
-            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
-            {
-                if (i < buffer.getNumSamples())
-                    monoSample += buffer.getSample (ch, i);
-            }
-            monoSample /= static_cast<float> (juce::jmax (1, buffer.getNumChannels()));
+        if (tap != nullptr)
+            tap->setSpectrumEnabled (false);
 
-            audioFifo[fifoIndex++] = monoSample;
+        tap = tapToShow;
 
-            if (fifoIndex >= fftSize)
-            {
-                // Perform FFT analysis
-                performFFT();
-                fifoIndex = 0;
-            }
-        }
+        if (tap != nullptr)
+            tap->setSpectrumEnabled (true);
     }
 
     /** Update spectrum display (call from timer) */
     void updateSpectrum()
     {
+        // The tap's thread has done the FFTs and the smoothing; this only reads the bands
+        for (size_t band = 0; band < spectrumLevels.size(); ++band)
+            spectrumLevels[band] = tap != nullptr ? tap->getSpectrumBand (static_cast<int> (band)) : 0.0f;
+
         repaint();
     }
 
 private:
-    void performFFT()
-    {
-        // Copy to temporary buffer for FFT processing
-        std::array<float, fftSize * 2> fftData = {};
-        std::copy(audioFifo.begin(), audioFifo.begin() + fftSize, fftData.begin());
-
-        // Apply Hann window
-        juce::dsp::WindowingFunction<float> window (fftSize, juce::dsp::WindowingFunction<float>::hann);
-        window.multiplyWithWindowingTable (fftData.data(), fftSize);
-
-        // Perform FFT
-        fft->performFrequencyOnlyForwardTransform (fftData.data());
-
-        // EQ band center frequencies: 31, 62, 125, 250, 500, 1k, 2k, 4k, 8k, 16k Hz
-        const float sampleRate = 44100.0f;
-        const float binWidth = sampleRate / (float)fftSize;
-
-        // Define frequency ranges for each band (in Hz)
-        const std::array<std::pair<float, float>, 10> bandFreqs = {{
-            {20.0f, 44.0f},      // 31 Hz band
-            {44.0f, 88.0f},      // 62 Hz band
-            {88.0f, 177.0f},     // 125 Hz band
-            {177.0f, 354.0f},    // 250 Hz band
-            {354.0f, 707.0f},    // 500 Hz band
-            {707.0f, 1414.0f},   // 1 kHz band
-            {1414.0f, 2828.0f},  // 2 kHz band
-            {2828.0f, 5657.0f},  // 4 kHz band
-            {5657.0f, 11314.0f}, // 8 kHz band
-            {11314.0f, 22050.0f} // 16 kHz band
-        }};
-
-        for (int band = 0; band < 10; ++band)
-        {
-            float lowFreq = bandFreqs[band].first;
-            float highFreq = bandFreqs[band].second;
-
-            // Convert frequencies to bin indices
-            int lowBin = (int)(lowFreq / binWidth);
-            int highBin = (int)(highFreq / binWidth);
-
-            // Clamp to valid range
-            lowBin = juce::jmax(0, juce::jmin(lowBin, fftSize / 2 - 1));
-            highBin = juce::jmax(lowBin + 1, juce::jmin(highBin, fftSize / 2));
-
-            // Calculate average magnitude in this frequency band
-            float bandLevel = 0.0f;
-            int numBins = highBin - lowBin;
-            if (numBins > 0)
-            {
-                for (int bin = lowBin; bin < highBin; ++bin)
-                {
-                    bandLevel += fftData[bin];
-                }
-                bandLevel /= (float)numBins;
-            }
-
-            // Scale and normalize
-            float normalizedLevel = juce::jlimit (0.0f, 1.0f, bandLevel * 8.0f);
-
-            // Smooth per-band attack/release - INDEPENDENT for each band!
-            const float attackCoeff = 0.3f;   // Fast rise
-            const float releaseCoeff = 0.92f; // Slow fall
-
-            if (normalizedLevel > spectrumLevels[band])
-            {
-                // Attack - rise quickly to new level
-                spectrumLevels[band] += (normalizedLevel - spectrumLevels[band]) * attackCoeff;
-            }
-            else
-            {
-                // Release - fall slowly
-                spectrumLevels[band] *= releaseCoeff;
-            }
-        }
-    }
-
     //==============================================================================
-    static constexpr int fftOrder = 11; // 2048 point FFT
-    static constexpr int fftSize = 1 << fftOrder;
-
-    std::unique_ptr<juce::dsp::FFT> fft;
-    std::array<float, fftSize * 2> audioFifo = {};
-    int fifoIndex = 0;
+    VisualizationTap* tap = nullptr;
 
     std::array<float, 10> spectrumLevels = {}; // 10 bands matching EQ
 
@@ -0,0 +1,161 @@
+#include "StageLoadMeter.h"
+
+namespace
+{
+    constexpr int refreshHz = 4;
+    constexpr int textWidth = 120;
+}
+
+StageLoadMeter::StageLoadMeter()
+{
+    setInterceptsMouseClicks (true, false);
+}
+
+StageLoadMeter::~StageLoadMeter()
+{
+    stopTimer();
+}
+
+void StageLoadMeter::setProfiler (StageProfiler* profilerToShow)
+{
+    profiler = profilerToShow;
+    snapshot = {};
+    heldPeak = 0.0;
+    lastShownMisses = 0;
+    missFlashTicks = 0;
+
+    if (profiler != nullptr)
+    {
+        // Counts from before the meter was attached are not this view's business
+        snapshot = profiler->takeSnapshot();
+        lastShownMisses = snapshot.deadlineMisses;
+        startTimerHz (refreshHz);
+    }
+    else
+    {
+        stopTimer();
+    }
+
+    updateTooltip();
+    repaint();
+}
+
+void StageLoadMeter::timerCallback()
+{
+    if (profiler == nullptr)
+        return;
+
+    snapshot = profiler->takeSnapshot();
+    heldPeak = juce::jmax (snapshot.total.peakLoad, heldPeak * 0.8);
+
+    if (snapshot.deadlineMisses != lastShownMisses)
+    {
+        lastShownMisses = snapshot.deadlineMisses;
+        missFlashTicks = 2 * refreshHz;
+    }
+    else if (missFlashTicks > 0)
+    {
+        --missFlashTicks;
+    }
+
+    updateTooltip();
+    repaint();
+}
+
+void StageLoadMeter::updateTooltip()
+{
+    if (profiler == nullptr)
+    {
+        setTooltip ({});
+        return;
+    }
+
+    juce::String text;
+    text << "DSP load per block (average / peak, blocks over budget)\n";
+
+    for (int stage = 0; stage < StageProfiler::numStages; ++stage)
+    {
+        const auto& load = snapshot.stages[static_cast<size_t> (stage)];
+        const auto overBudget = load.histogram[StageProfiler::numLoadBuckets - 1];
+
+        if (load.averageLoad <= 0.0 && load.peakLoad <= 0.0 && overBudget == 0)
+            continue;
+
+        text << RealtimeDiagnostics::getStageName (static_cast<StageProfiler::Stage> (stage)) << ": "
+             << juce::String (load.averageLoad * 100.0, 1) << "% / "
+             << juce::String (load.peakLoad * 100.0, 1) << "%, "
+             << overBudget << "\n";
+    }
+
+    text << "Total: " << juce::String (snapshot.total.averageLoad * 100.0, 1) << "% / "
+         << juce::String (snapshot.total.peakLoad * 100.0, 1) << "%\n"
+         << "Deadline misses: " << snapshot.deadlineMisses;
+
+    setTooltip (text);
+}
+
+void StageLoadMeter::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour (juce::Colour (0xff1e1e1e));
+    g.fillRoundedRectangle (bounds, 3.0f);
+
+    if (profiler == nullptr)
+        return;
+
+    auto textArea = bounds.removeFromRight (static_cast<float> (juce::jmin (textWidth, getWidth() / 2)));
+    auto barArea = bounds.reduced (3.0f, juce::jmax (2.0f, bounds.getHeight() * 0.25f));
+
+    g.setColour (juce::Colour (0xff333333));
+    g.fillRect (barArea);
+
+    // Stages stacked in chain order, each as wide as its share of the budget
+    float x = barArea.getX();
+
+    for (int stage = 0; stage < StageProfiler::numStages && x < barArea.getRight(); ++stage)
+    {
+        const auto load = static_cast<float> (snapshot.stages[static_cast<size_t> (stage)].averageLoad);
+        const float width = juce::jmin (barArea.getRight() - x, load * barArea.getWidth());
+
+        if (width <= 0.0f)
+            continue;
+
+        g.setColour (getStageColour (stage));
+        g.fillRect (x, barArea.getY(), width, barArea.getHeight());
+        x += width;
+    }
+
+    if (heldPeak > 0.0)
+    {
+        const float peakX = barArea.getX() + barArea.getWidth() * static_cast<float> (juce::jmin (1.0, heldPeak));
+        g.setColour (heldPeak >= 1.0 ? juce::Colours::red : juce::Colours::white.withAlpha (0.8f));
+        g.fillRect (peakX - 1.0f, barArea.getY() - 1.0f, 2.0f, barArea.getHeight() + 2.0f);
+    }
+
+    juce::String text = "DSP " + juce::String (juce::roundToInt (snapshot.total.averageLoad * 100.0)) + "%";
+
+    if (snapshot.deadlineMisses > 0)
+        text << "  " << snapshot.deadlineMisses << (snapshot.deadlineMisses == 1 ? " miss" : " misses");
+
+    g.setColour (missFlashTicks > 0 ? juce::Colours::red : juce::Colours::lightgrey);
+    g.setFont (juce::jmin (12.0f, textArea.getHeight() * 0.8f));
+    g.drawText (text, textArea.reduced (4.0f, 0.0f), juce::Justification::centredLeft, true);
+}
+
+juce::Colour StageLoadMeter::getStageColour (int stage)
+{
+    static const juce::Colour colours[] =
+    {
+        juce::Colour (0xff808080),   // Setup
+        juce::Colour (0xffe0a030),   // Click removal
+        juce::Colour (0xff40a0e0),   // Noise reduction
+        juce::Colour (0xffb060e0),   // AI denoise
+        juce::Colour (0xff50c070),   // Filter bank
+        juce::Colour (0xffe06060),   // Difference mode
+        juce::Colour (0xff60d0d0)    // Visualization
+    };
+
+    static_assert (sizeof (colours) / sizeof (colours[0]) == StageProfiler::numStages, "One colour per stage");
+    return colours[juce::jlimit (0, StageProfiler::numStages - 1, stage)];
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "../Utils/StageProfiler.h"
+
+/**
+ * Stage Load Meter
+ *
+ * One-line view of a StageProfiler: a bar split into the real-time stages'
+ * shares of the block budget, a marker at the heaviest block, and the total
+ * load and deadline-miss count. The tooltip breaks the load down per stage.
+ * Polls the profiler a few times a second; without one it shows nothing.
+ */
+class StageLoadMeter : public juce::Component,
+                       public juce::SettableTooltipClient,
+                       private juce::Timer
+{
+public:
+    StageLoadMeter();
+    ~StageLoadMeter() override;
+
+    /** The profiler to show, or nullptr; it must outlive the meter or be cleared first */
+    void setProfiler (StageProfiler* profilerToShow);
+
+    void paint (juce::Graphics& g) override;
+
+private:
+    void timerCallback() override;
+    void updateTooltip();
+
+    static juce::Colour getStageColour (int stage);
+
+    StageProfiler* profiler = nullptr;
+    StageProfiler::Snapshot snapshot;
+    double heldPeak = 0.0;          // The peak marker falls back slowly, as peak meters do
+    juce::int64 lastShownMisses = 0;
+    int missFlashTicks = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StageLoadMeter)
+};
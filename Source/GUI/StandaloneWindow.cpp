@@ -1,14 +1,119 @@
 #include "StandaloneWindow.h"
 #include "SettingsComponent.h"
+#include "../Utils/BufferSplice.h"
+#include "../DSP/VariableRateResampler.h"
+#include "../Utils/LameMP3AudioFormat.h"
+#if VRS_GPU_ENABLED
+#include "../GPU/GPUClickDetector.h"
+#endif
 #include <array>
 #include <atomic>
 #include <functional>
+#include <limits>
+#include <numeric>
 
 namespace
 {
+    /**
+     * Splits [scanStart, scanEnd) into segments for click scans on several
+     * cores. Each segment is scanned from warmUpSamples before its start, so
+     * the running RMS and click skips at its start are those of one scan from
+     * scanStart; the starts are aligned to the RMS segments for the same reason.
+     */
+    struct ClickScanSegments
+    {
+        ClickScanSegments (int scanStart, int scanEnd, double sampleRate, int processorLatency)
+        {
+            const int totalSamples = scanEnd - scanStart;
+            const int alignment = ClickRemoval::getRmsSegmentSize();
+            const int minSegmentLength = juce::jmax (alignment, static_cast<int> (sampleRate * 10.0));
+            const int numSegments = juce::jlimit (1, getNumWorkers() * 4, totalSamples / minSegmentLength);
+            const int warmUp = juce::jmax (8192, 2 * processorLatency);    // Several running RMS windows
+
+            warmUpSamples = (warmUp + alignment - 1) / alignment * alignment;
+
+            for (int segment = 0; segment <= numSegments; ++segment)
+            {
+                const int offset = static_cast<int> (static_cast<juce::int64> (totalSamples) * segment / numSegments);
+                starts.push_back (scanStart + (segment == numSegments ? offset : offset / alignment * alignment));
+            }
+        }
+
+        static int getNumWorkers() { return juce::jmax (1, juce::SystemStats::getNumCpus()); }
+
+        int getNumSegments() const { return static_cast<int> (starts.size()) - 1; }
+        int getStart (int segment) const { return starts[static_cast<size_t> (segment)]; }
+        int getEnd (int segment) const { return starts[static_cast<size_t> (segment) + 1]; }
+        int getContextStart (int segment) const { return juce::jmax (starts.front(), getStart (segment) - warmUpSamples); }
+
+        /** Samples read by scanning every segment, warm-ups included */
+        juce::int64 getTotalToScan() const
+        {
+            return static_cast<juce::int64> (starts.back() - starts.front())
+                 + static_cast<juce::int64> (getNumSegments() - 1) * warmUpSamples;
+        }
+
+        std::vector<int> starts;    // Segment boundaries, the last one being scanEnd
+        int warmUpSamples = 0;
+    };
+
+    /**
+     * Scans segments on one worker per core, each worker with a processor of
+     * its own that it reuses for every segment it takes. scanSegment (processor,
+     * segment, progressCallback) scans one segment; the task's progress covers
+     * all workers, and any worker stops when the task is asked to exit.
+     */
+    void runClickScan (juce::ThreadWithProgressWindow& task,
+                       const ClickScanSegments& segments,
+                       const std::vector<int>& segmentsToScan,
+                       std::atomic<juce::int64>& samplesScanned,
+                       const std::function<std::unique_ptr<ClickRemoval>()>& createProcessor,
+                       const std::function<void (ClickRemoval&, int, const std::function<bool (double)>&)>& scanSegment)
+    {
+        if (segmentsToScan.empty())
+            return;
+
+        const int numWorkers = juce::jmin (ClickScanSegments::getNumWorkers(), static_cast<int> (segmentsToScan.size()));
+        std::atomic<size_t> nextSegment { 0 };
+        juce::ThreadPool pool (numWorkers);
+
+        for (int worker = 0; worker < numWorkers; ++worker)
+        {
+            pool.addJob ([&]
+            {
+                auto processor = createProcessor();
+
+                for (size_t next = nextSegment++; next < segmentsToScan.size() && !task.threadShouldExit(); next = nextSegment++)
+                {
+                    const int segment = segmentsToScan[next];
+                    const juce::int64 length = segments.getEnd (segment) - segments.getContextStart (segment);
+                    juce::int64 reported = 0;
+
+                    scanSegment (*processor, segment, [&task, &samplesScanned, &reported, length] (double progress)
+                    {
+                        const auto scanned = static_cast<juce::int64> (progress * static_cast<double> (length));
+                        samplesScanned += scanned - reported;
+                        reported = scanned;
+                        return !task.threadShouldExit();
+                    });
+
+                    samplesScanned += length - reported;
+                }
+
+                return juce::ThreadPoolJob::jobHasFinished;
+            });
+        }
+
+        while (pool.getNumJobs() > 0)
+        {
+            juce::Thread::sleep (20);
+            task.setProgress (static_cast<double> (samplesScanned.load()) / static_cast<double> (segments.getTotalToScan()));
+        }
+    }
+
     struct ClickDetectionResult
     {
-        std::vector<ClickRemoval::ClickInfo> clicks;
+        ClickStore clicks;
         int totalClicks = 0;
         bool cancelled = false;
     };
@@ -39,54 +144,92 @@ namespace
             if (scanEnd <= scanStart)
                 return;
 
-            const int totalSamples = scanEnd - scanStart;
-            juce::AudioBuffer<float> scanBuffer (sourceBuffer.getNumChannels(), totalSamples);
-            for (int ch = 0; ch < sourceBuffer.getNumChannels(); ++ch)
-                scanBuffer.copyFrom (ch, 0, sourceBuffer, ch, scanStart, totalSamples);
+           #if VRS_GPU_ENABLED
+            // Whole-region scan on the GPU; finds the same clicks
+            GPUClickDetector detector;
 
-            juce::dsp::ProcessSpec spec;
-            spec.sampleRate = sampleRate;
-            spec.numChannels = static_cast<juce::uint32> (scanBuffer.getNumChannels());
-            spec.maximumBlockSize = 2048;
+            if (detector.isUsingGPU())
+            {
+                auto processor = createProcessor();
+                processor->setSampleOffset (scanStart);
+
+                // Detection only, so this view of the source is never written
+                juce::AudioBuffer<float> view (const_cast<float* const*> (sourceBuffer.getArrayOfReadPointers()),
+                                               sourceBuffer.getNumChannels(), sourceBuffer.getNumSamples());
+
+                result.totalClicks = detector.processBufferRegion (*processor, view, scanStart, scanEnd - scanStart,
+                                                                   [this] (double progress)
+                                                                   {
+                                                                       setProgress (progress);
+                                                                       return !threadShouldExit();
+                                                                   });
+
+                result.cancelled = threadShouldExit();
+                result.clicks = processor->takeDetectedClicks();
+                return;
+            }
+           #endif
 
-            ClickRemoval processor;
-            processor.prepare (spec);
-            processor.reset();
-            processor.setSensitivity (clickSensitivity);
-            processor.setMaxWidth (clickMaxWidth);
-            processor.setRemovalMethod (removalMethod);
-            processor.setStoreDetectedClicks (true);
-            processor.setApplyRemoval (false);
-            processor.resetSamplePosition();
-            processor.setSampleOffset (scanStart);
+            // Every segment at once, each read straight from the source
+            const ClickScanSegments segments (scanStart, scanEnd, sampleRate, createProcessor()->getLatencySamples());
+            std::vector<int> allSegments ((size_t) segments.getNumSegments());
+            std::iota (allSegments.begin(), allSegments.end(), 0);
 
-            const int blockSize = 2048;
-            int totalClicks = 0;
+            std::vector<ClickStore> segmentClicks (allSegments.size());
+            std::atomic<juce::int64> samplesScanned { 0 };
 
-            for (int start = 0; start < totalSamples; start += blockSize)
+            runClickScan (*this, segments, allSegments, samplesScanned, [this] { return createProcessor(); },
+                          [this, &segments, &segmentClicks] (ClickRemoval& processor, int segment,
+                                                              const std::function<bool (double)>& progressCallback)
             {
-                if (threadShouldExit())
-                {
-                    result.cancelled = true;
-                    return;
-                }
+                const int contextStart = segments.getContextStart (segment);
+                processor.setSampleOffset (contextStart);
+                processor.detectBufferRegion (sourceBuffer, contextStart, segments.getEnd (segment) - contextStart,
+                                              progressCallback);
+
+                // Drop what the warm-up found
+                auto found = processor.takeDetectedClicks();
+                auto& kept = segmentClicks[static_cast<size_t> (segment)];
+                kept.reserve (found.size());
+
+                found.forEach (found.lowerBound (segments.getStart (segment)), found.size(),
+                               [&kept] (size_t, int64_t position, int width, float magnitude, bool isManual, bool isApplied)
+                               {
+                                   kept.add (position, width, magnitude, isManual, isApplied);
+                               });
+            });
 
-                int samplesThisBlock = juce::jmin (blockSize, totalSamples - start);
-                juce::dsp::AudioBlock<float> block (scanBuffer.getArrayOfWritePointers(),
-                                                    static_cast<size_t> (scanBuffer.getNumChannels()),
-                                                    static_cast<size_t> (start),
-                                                    static_cast<size_t> (samplesThisBlock));
+            if (threadShouldExit())
+            {
+                result.cancelled = true;
+                return;
+            }
 
-                juce::dsp::ProcessContextReplacing<float> context (block);
-                processor.process (context);
+            // Concatenate in order; a click the next segment found again at a seam counts once
+            size_t numClicks = 0;
+
+            for (const auto& clicks : segmentClicks)
+                numClicks += clicks.size();
 
-                totalClicks += processor.getClicksDetectedLastBlock();
+            result.clicks.reserve (numClicks);
+            int64_t lastEnd = std::numeric_limits<int64_t>::min();
 
-                setProgress (juce::jlimit (0.0, 1.0, (start + samplesThisBlock) / (double) totalSamples));
+            for (const auto& clicks : segmentClicks)
+            {
+                const int64_t seamEnd = lastEnd;
+
+                clicks.forEach (0, clicks.size(), [this, &lastEnd, seamEnd] (size_t, int64_t position, int width, float magnitude,
+                                                                          bool isManual, bool isApplied)
+                {
+                    if (position < seamEnd)
+                        return;
+
+                    result.clicks.add (position, width, magnitude, isManual, isApplied);
+                    lastEnd = juce::jmax (lastEnd, position + width);
+                });
             }
 
-            result.totalClicks = totalClicks;
-            result.clicks = processor.getDetectedClicks();
+            result.totalClicks = static_cast<int> (result.clicks.size());
         }
 
         void threadComplete (bool userPressedCancel) override
@@ -98,9 +241,28 @@ namespace
         }
 
         ClickDetectionResult result;
-        std::function<void (const ClickDetectionResult&)> onComplete;
+        std::function<void (ClickDetectionResult&)> onComplete;
 
     private:
+        std::unique_ptr<ClickRemoval> createProcessor() const
+        {
+            juce::dsp::ProcessSpec spec;
+            spec.sampleRate = sampleRate;
+            spec.numChannels = static_cast<juce::uint32> (sourceBuffer.getNumChannels());
+            spec.maximumBlockSize = 2048;
+
+            auto processor = std::make_unique<ClickRemoval>();
+            processor->prepare (spec);
+            processor->reset();
+            processor->setSensitivity (clickSensitivity);
+            processor->setMaxWidth (clickMaxWidth);
+            processor->setRemovalMethod (removalMethod);
+            processor->setStoreDetectedClicks (true);
+            processor->setApplyRemoval (false);
+            processor->resetSamplePosition();
+            return processor;
+        }
+
         const juce::AudioBuffer<float>& sourceBuffer;
         double sampleRate = 0.0;
         int scanStart = 0;
@@ -110,190 +272,697 @@ namespace
         ClickRemoval::RemovalMethod removalMethod = ClickRemoval::Automatic;
     };
 
-    class ClickDetectionApplier : public juce::Timer
+    struct ClickRemovalResult
     {
-    public:
-        ClickDetectionApplier (CorrectionListView* listView,
-                               WaveformDisplay* waveformDisplay,
-                               std::vector<ClickRemoval::ClickInfo> clicks,
-                               juce::String rangeInfo,
-                               std::function<void (const juce::String&)> statusSetter,
-                               std::function<void (size_t)> onFinished)
-            : list (listView),
-              waveform (waveformDisplay),
-              pendingClicks (std::move (clicks)),
-              rangeDescription (std::move (rangeInfo)),
-              setStatus (std::move (statusSetter)),
-              finishedCallback (std::move (onFinished))
-        {
-            if (list != nullptr)
-                list->clearCorrections();
-            if (waveform != nullptr)
-                waveform->clearClickMarkers();
-
-            total = pendingClicks.size();
-            progressValue = 0.0;
-
-            progressWindow = std::make_unique<juce::AlertWindow> (
-                "Rendering Click Markers",
-                "Updating the timeline with detected clicks...",
-                juce::AlertWindow::InfoIcon);
-            progressWindow->addProgressBarComponent (progressValue);
-            progressWindow->setEscapeKeyCancels (false);
-            progressWindow->enterModalState (true, nullptr, true);
+        int totalClicksRemoved = 0;
+        bool cancelled = false;
+        AudioUndoManager::Edit undoEdit { "Click Removal", 44100.0 }; // The samples the repairs replaced
+    };
 
-            startTimerHz (30);
+    class ClickRemovalTask : public juce::ThreadWithProgressWindow
+    {
+    public:
+        ClickRemovalTask (juce::AudioBuffer<float>& target,
+                          double sr,
+                          int startSample,
+                          int endSample,
+                          float sensitivity,
+                          int maxWidth,
+                          ClickRemoval::RemovalMethod method)
+            : juce::ThreadWithProgressWindow ("Removing clicks...", true, false),
+              targetBuffer (target),
+              sampleRate (sr),
+              scanStart (startSample),
+              scanEnd (endSample),
+              clickSensitivity (sensitivity),
+              clickMaxWidth (maxWidth),
+              removalMethod (method)
+        {
+            result.undoEdit = AudioUndoManager::Edit ("Click Removal", sr);
         }
 
-        void timerCallback() override
+        void run() override
         {
-            if (total == 0)
+            if (scanEnd <= scanStart)
+                return;
+
+           #if VRS_GPU_ENABLED
+            // Detection on the GPU, repairs in place on the CPU
+            GPUClickDetector detector;
+
+            if (detector.isUsingGPU())
             {
-                if (progressWindow)
+                auto processor = createProcessor();
+                processor->setSampleOffset (scanStart);
+
+                // Offset by scanStart, repair positions are buffer positions
+                processor->setBeforeRepairCallback ([this] (int64_t position, int numSamples)
                 {
-                    progressWindow->exitModalState (0);
-                    progressWindow->setVisible (false);
-                    progressWindow.reset();
-                }
-                stopTimer();
-                if (finishedCallback)
-                    finishedCallback (0);
-                delete this;
+                    result.undoEdit.saveRegion (targetBuffer, static_cast<int> (position), numSamples);
+                });
+
+                result.totalClicksRemoved = detector.processBufferRegion (*processor, targetBuffer, scanStart, scanEnd - scanStart,
+                                                                          [this] (double progress)
+                                                                          {
+                                                                              setProgress (progress);
+                                                                              return !threadShouldExit();
+                                                                          });
+
+                result.cancelled = threadShouldExit();
                 return;
             }
+           #endif
+
+            // Repairs are local, so segments are repaired in place in parallel: first every
+            // even segment, then every odd one. A segment writes its own samples, plus the
+            // rest of any click it repairs across its end, and while it runs neither
+            // neighbour does, so its warm-up and lookahead read audio nobody is changing.
+            // A click over a seam is thus repaired whole by the segment before it, or
+            // already whole when that segment's successor starts.
+            const ClickScanSegments segments (scanStart, scanEnd, sampleRate, createProcessor()->getLatencySamples());
+            const int numSegments = segments.getNumSegments();
+
+            // The samples each segment's repairs replaced, and the clicks it repaired
+            std::vector<AudioUndoManager::Edit> segmentEdits;
+            std::vector<int> segmentClicks ((size_t) numSegments, 0);
 
-            const size_t chunkSize = 500;
-            size_t end = juce::jmin (total, index + chunkSize);
+            for (int segment = 0; segment < numSegments; ++segment)
+                segmentEdits.emplace_back ("Click Removal", sampleRate);
 
-            for (; index < end; ++index)
+            std::atomic<juce::int64> samplesScanned { 0 };
+
+            for (int parity = 0; parity < 2; ++parity)
             {
-                const auto& click = pendingClicks[index];
-                if (list != nullptr)
+                std::vector<int> phase;
+
+                for (int segment = parity; segment < numSegments; segment += 2)
+                    phase.push_back (segment);
+
+                runClickScan (*this, segments, phase, samplesScanned, [this] { return createProcessor(); },
+                              [this, &segments, &segmentEdits, &segmentClicks] (ClickRemoval& processor, int segment,
+                                                                                 const std::function<bool (double)>& progressCallback)
                 {
-                    list->addCorrection (click.position,
-                                         click.magnitude,
-                                         click.width,
-                                         click.isManual ? "Manual" : "Auto",
-                                         false);
-                }
+                    auto& edit = segmentEdits[static_cast<size_t> (segment)];
+                    const int contextStart = segments.getContextStart (segment);
+                    const int segmentStart = segments.getStart (segment);
 
-                if (waveform != nullptr)
-                    waveform->addClickMarker (click.position);
-            }
+                    processor.setBeforeRepairCallback ([this, &edit] (int64_t position, int numSamples)
+                    {
+                        edit.saveRegion (targetBuffer, static_cast<int> (position), numSamples);
+                    });
 
-            if (setStatus)
-            {
-                int percent = static_cast<int> ((index * 100) / total);
-                setStatus ("Rendering clicks... " + juce::String (percent) + "% (" +
-                          juce::String (index) + "/" + juce::String (total) + ")");
-            }
+                    processor.setSampleOffset (contextStart);
+                    processor.processBufferRegionFrom (targetBuffer, contextStart, segmentStart, segments.getEnd (segment),
+                                                       progressCallback);
 
-            progressValue = total > 0 ? (double) index / (double) total : 1.0;
+                    // Only the clicks repaired in the segment itself count
+                    const auto found = processor.takeDetectedClicks();
+                    segmentClicks[static_cast<size_t> (segment)] = static_cast<int> (found.size() - found.lowerBound (segmentStart));
+                });
+            }
 
-            if (index >= total)
+            // Only a repair across a seam overlaps the next segment's samples; undo restores
+            // last to first, so the edits are concatenated in the order the phases ran
+            for (int parity = 0; parity < 2; ++parity)
             {
-                if (progressWindow)
+                for (int segment = parity; segment < numSegments; segment += 2)
                 {
-                    progressWindow->exitModalState (0);
-                    progressWindow->setVisible (false);
-                    progressWindow.reset();
+                    result.undoEdit.append (std::move (segmentEdits[static_cast<size_t> (segment)]));
+                    result.totalClicksRemoved += segmentClicks[static_cast<size_t> (segment)];
                 }
-                stopTimer();
-                if (finishedCallback)
-                    finishedCallback (total);
-                delete this;
             }
+
+            result.cancelled = threadShouldExit();
+        }
+
+        void threadComplete (bool userPressedCancel) override
+        {
+            result.cancelled = result.cancelled || userPressedCancel;
+            if (onComplete)
+                onComplete (result);
+            delete this;
         }
 
+        ClickRemovalResult result;
+        std::function<void (ClickRemovalResult&)> onComplete;
+
     private:
-        CorrectionListView* list = nullptr;
-        WaveformDisplay* waveform = nullptr;
-        std::vector<ClickRemoval::ClickInfo> pendingClicks;
-        juce::String rangeDescription;
-        std::function<void (const juce::String&)> setStatus;
-        std::function<void (size_t)> finishedCallback;
-        std::unique_ptr<juce::AlertWindow> progressWindow;
-        double progressValue = 0.0;
-        size_t index = 0;
-        size_t total = 0;
+        std::unique_ptr<ClickRemoval> createProcessor() const
+        {
+            juce::dsp::ProcessSpec spec;
+            spec.sampleRate = sampleRate;
+            spec.numChannels = static_cast<juce::uint32> (targetBuffer.getNumChannels());
+            spec.maximumBlockSize = 2048;
+
+            auto processor = std::make_unique<ClickRemoval>();
+            processor->prepare (spec);
+            processor->reset();
+            processor->setSensitivity (clickSensitivity);
+            processor->setMaxWidth (clickMaxWidth);
+            processor->setRemovalMethod (removalMethod);
+            processor->setStoreDetectedClicks (true);     // Counted per segment, without the warm-up
+            processor->setApplyRemoval (true);
+            processor->resetSamplePosition();
+            return processor;
+        }
+
+        juce::AudioBuffer<float>& targetBuffer;
+        double sampleRate = 0.0;
+        int scanStart = 0;
+        int scanEnd = 0;
+        float clickSensitivity = 0.0f;
+        int clickMaxWidth = 0;
+        ClickRemoval::RemovalMethod removalMethod = ClickRemoval::Automatic;
     };
 
-    struct ClickRemovalResult
+    struct AIDenoiseResult
     {
-        int totalClicksRemoved = 0;
+        bool succeeded = false;
         bool cancelled = false;
+        double seconds = 0.0;
     };
 
-    class ClickRemovalTask : public juce::ThreadWithProgressWindow
+    class AIDenoiseTask : public juce::ThreadWithProgressWindow
     {
     public:
-        ClickRemovalTask (juce::AudioBuffer<float>& target,
-                          double sr,
-                          int startSample,
-                          int endSample,
-                          float sensitivity,
-                          int maxWidth,
-                          ClickRemoval::RemovalMethod method)
-            : juce::ThreadWithProgressWindow ("Removing clicks...", true, false),
+        AIDenoiseTask (OnnxDenoiser& denoiserToUse,
+                       juce::AudioBuffer<float>& target,
+                       double sr,
+                       int startSample,
+                       int endSample)
+            : juce::ThreadWithProgressWindow ("AI denoising...", true, true),
+              denoiser (denoiserToUse),
               targetBuffer (target),
               sampleRate (sr),
-              scanStart (startSample),
-              scanEnd (endSample),
-              clickSensitivity (sensitivity),
-              clickMaxWidth (maxWidth),
-              removalMethod (method)
+              regionStart (startSample),
+              regionEnd (endSample)
         {
         }
 
         void run() override
         {
-            if (scanEnd <= scanStart)
+            if (regionEnd <= regionStart)
                 return;
 
-            juce::dsp::ProcessSpec spec;
-            spec.sampleRate = sampleRate;
-            spec.numChannels = static_cast<juce::uint32> (targetBuffer.getNumChannels());
-            spec.maximumBlockSize = 2048;
+            // Processed in place through a view of the region, without copying it
+            juce::AudioBuffer<float> region (targetBuffer.getArrayOfWritePointers(), targetBuffer.getNumChannels(),
+                                             regionStart, regionEnd - regionStart);
+
+            setStatusMessage ("Loading model...");
+            const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+            result.succeeded = denoiser.processOffline (region, sampleRate,
+                                                        [this] (double progress)
+                                                        {
+                                                            setStatusMessage ("Denoising with "
+                                                                              + OnnxDenoiser::providerToString (denoiser.getActiveProvider())
+                                                                              + "...");
+                                                            setProgress (progress);
+                                                            return !threadShouldExit();
+                                                        });
+
+            result.cancelled = threadShouldExit();
+            result.seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        }
 
-            ClickRemoval processor;
-            processor.prepare (spec);
-            processor.reset();
-            processor.setSensitivity (clickSensitivity);
-            processor.setMaxWidth (clickMaxWidth);
-            processor.setRemovalMethod (removalMethod);
-            processor.setStoreDetectedClicks (false);
-            processor.setApplyRemoval (true);
-            processor.resetSamplePosition();
-            processor.setSampleOffset (scanStart);
+        void threadComplete (bool userPressedCancel) override
+        {
+            result.cancelled = result.cancelled || userPressedCancel;
+            if (onComplete)
+                onComplete (result);
+            delete this;
+        }
 
-            const int blockSize = 2048;
-            int totalClicksRemoved = 0;
-            int totalSamples = scanEnd - scanStart;
+        AIDenoiseResult result;
+        std::function<void (const AIDenoiseResult&)> onComplete;
+
+    private:
+        OnnxDenoiser& denoiser;
+        juce::AudioBuffer<float>& targetBuffer;
+        double sampleRate = 0.0;
+        int regionStart = 0;
+        int regionEnd = 0;
+    };
+
+    struct TrackExportResult
+    {
+        bool succeeded = false;
+        bool cancelled = false;
+    };
+
+    class TrackExportTask : public juce::ThreadWithProgressWindow
+    {
+    public:
+        /** Exports source, or the selection when one is given (the task keeps it) */
+        TrackExportTask (TrackDetector& detectorToUse,
+                         const juce::AudioBuffer<float>& source,
+                         juce::AudioBuffer<float>&& selectionToKeep,
+                         double sr,
+                         const juce::File& directory,
+                         const juce::String& name,
+                         const juce::String& fileExtension)
+            : juce::ThreadWithProgressWindow ("Exporting tracks...", true, true),
+              detector (detectorToUse),
+              selection (std::move (selectionToKeep)),
+              sourceBuffer (selection.getNumSamples() > 0 ? selection : source),
+              sampleRate (sr),
+              outputDirectory (directory),
+              baseName (name),
+              extension (fileExtension)
+        {
+        }
+
+        void run() override
+        {
+            result.succeeded = detector.exportTracks (sourceBuffer, sampleRate, outputDirectory, baseName, extension,
+                                                      [this] (double progress)
+                                                      {
+                                                          setProgress (progress);
+                                                          return !threadShouldExit();
+                                                      });
+
+            result.cancelled = threadShouldExit();
+        }
+
+        void threadComplete (bool userPressedCancel) override
+        {
+            result.cancelled = result.cancelled || userPressedCancel;
+            if (onComplete)
+                onComplete (result);
+            delete this;
+        }
+
+        TrackExportResult result;
+        std::function<void (const TrackExportResult&)> onComplete;
+
+    private:
+        TrackDetector& detector;
+        juce::AudioBuffer<float> selection;
+        const juce::AudioBuffer<float>& sourceBuffer;
+        double sampleRate = 0.0;
+        juce::File outputDirectory;
+        juce::String baseName;
+        juce::String extension;
+    };
+
+    //==============================================================================
+    // Offline Process menu tools, run by RegionProcessor
+
+    /** Multiplies each channel by its own gain; channels past the gains are left alone */
+    class GainOperation : public RegionOperation
+    {
+    public:
+        GainOperation (const juce::String& operationName, std::vector<float> channelGains)
+            : name (operationName), gains (std::move (channelGains))
+        {
+        }
+
+        juce::String getName() const override { return name; }
+
+        void processChunk (const Chunk& chunk) override
+        {
+            const int numChannels = juce::jmin (static_cast<int> (gains.size()), chunk.output.getNumChannels());
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                if (gains[static_cast<size_t> (channel)] != 1.0f)
+                    juce::FloatVectorOperations::multiply (chunk.output.getWritePointer (channel),
+                                                           gains[static_cast<size_t> (channel)],
+                                                           chunk.end - chunk.start);
+        }
+
+    protected:
+        juce::String name;
+        std::vector<float> gains;
+    };
+
+    /** One gain for every channel, to a target peak or (measured in prepare()) a target RMS */
+    class NormaliseOperation : public GainOperation
+    {
+    public:
+        NormaliseOperation (bool normaliseRms, float targetGainToUse, float currentPeakToUse)
+            : GainOperation ("Normalise", {}),
+              useRms (normaliseRms),
+              targetGain (targetGainToUse),
+              currentPeak (currentPeakToUse)
+        {
+        }
 
-            for (int start = scanStart; start < scanEnd; start += blockSize)
+        void prepare (const juce::AudioBuffer<float>& source, int regionStart, int regionEnd) override
+        {
+            gain = 1.0f;
+
+            if (!useRms)
+            {
+                if (currentPeak > 0.0001f)
+                    gain = targetGain / currentPeak;
+            }
+            else
             {
-                if (threadShouldExit())
+                const int numSamples = regionEnd - regionStart;
+                double sumSquares = 0.0;
+
+                for (int ch = 0; ch < source.getNumChannels(); ++ch)
                 {
-                    result.cancelled = true;
-                    return;
+                    const float* data = source.getReadPointer (ch) + regionStart;
+                    for (int i = 0; i < numSamples; ++i)
+                        sumSquares += data[i] * data[i];
                 }
 
-                int samplesThisBlock = juce::jmin (blockSize, scanEnd - start);
-                juce::dsp::AudioBlock<float> block (targetBuffer.getArrayOfWritePointers(),
-                                                    static_cast<size_t> (targetBuffer.getNumChannels()),
-                                                    static_cast<size_t> (start),
-                                                    static_cast<size_t> (samplesThisBlock));
+                const float rms = static_cast<float> (std::sqrt (sumSquares / (numSamples * static_cast<double> (source.getNumChannels()))));
 
-                juce::dsp::ProcessContextReplacing<float> context (block);
-                processor.process (context);
+                if (rms > 0.0001f)
+                    gain = targetGain / rms;
+
+                // Limit gain to avoid clipping
+                float maxGain = 1.0f / currentPeak;
+                gain = juce::jmin (gain, maxGain * 0.99f);
+            }
+
+            gains.assign (static_cast<size_t> (source.getNumChannels()), gain);
+        }
+
+        float getGain() const { return gain; }
+
+    private:
+        bool useRms = false;
+        float targetGain = 1.0f;
+        float currentPeak = 0.0f;
+        float gain = 1.0f;
+    };
+
+    /**
+     * Repairs runs of at least minLength samples below the threshold. A chunk
+     * repairs the part of every run that crosses it, finding the run's ends in
+     * the region around it, and counts the runs that start in it.
+     */
+    class DropoutRestorationOperation : public RegionOperation
+    {
+    public:
+        enum Method { interpolate = 0, copyOtherChannel, silence };
+
+        DropoutRestorationOperation (float thresholdLinear, int minLengthSamples, int repairMethod)
+            : threshold (thresholdLinear), minLength (minLengthSamples), method (repairMethod)
+        {
+        }
+
+        juce::String getName() const override { return "Dropout Restoration"; }
+        int getOverlapSamples() const override { return wholeRegion; }
+
+        void processChunk (const Chunk& chunk) override
+        {
+            const int chunkStart = chunk.regionStart + chunk.start;
+            const int chunkEnd = chunk.regionStart + chunk.end;
+
+            for (int ch = 0; ch < chunk.source.getNumChannels(); ++ch)
+            {
+                const float* channelData = chunk.source.getReadPointer (ch);
+                const auto isBelowThreshold = [&] (int i) { return std::abs (channelData[i]) < threshold; };
+
+                // A run open at the chunk start began in an earlier chunk
+                int dropoutStart = -1;
+
+                if (isBelowThreshold (chunkStart))
+                {
+                    dropoutStart = chunkStart;
+                    while (dropoutStart > chunk.regionStart && isBelowThreshold (dropoutStart - 1))
+                        --dropoutStart;
+                }
+
+                // Past the chunk end only to close the run it holds; a run open at the region end is left alone
+                for (int i = chunkStart; i < chunk.regionEnd; ++i)
+                {
+                    if (isBelowThreshold (i))
+                    {
+                        if (dropoutStart < 0)
+                        {
+                            if (i >= chunkEnd)
+                                break;
+
+                            dropoutStart = i;
+                        }
+                    }
+                    else
+                    {
+                        if (dropoutStart >= 0)
+                        {
+                            repair (chunk, ch, dropoutStart, i);
+                            dropoutStart = -1;
+                        }
+
+                        if (i >= chunkEnd)
+                            break;
+                    }
+                }
+            }
+        }
+
+        int getNumFound() const { return found.load(); }
+        int getNumRepaired() const { return repaired.load(); }
+
+    private:
+        /** Repairs the part of source[dropoutStart, dropoutEnd) of channel ch in the chunk */
+        void repair (const Chunk& chunk, int ch, int dropoutStart, int dropoutEnd)
+        {
+            const int dropoutLength = dropoutEnd - dropoutStart;
+
+            if (dropoutLength < minLength)
+                return;
+
+            const int chunkStart = chunk.regionStart + chunk.start;
+            const int first = juce::jmax (dropoutStart, chunkStart);
+            const int last = juce::jmin (dropoutEnd, chunk.regionStart + chunk.end);
+            const bool counts = dropoutStart >= chunkStart;
+            const float* channelData = chunk.source.getReadPointer (ch);
+            float* output = chunk.output.getWritePointer (ch);
+
+            if (counts)
+                ++found;
+
+            if (method == interpolate)
+            {
+                float startVal = (dropoutStart > chunk.regionStart) ? channelData[dropoutStart - 1] : 0.0f;
+                float endVal = channelData[dropoutEnd];
+
+                for (int j = first; j < last; ++j)
+                {
+                    float t = (float) (j - dropoutStart) / (float) dropoutLength;
+                    // Cosine interpolation for smooth transition
+                    float weight = 0.5f - 0.5f * std::cos (t * juce::MathConstants<float>::pi);
+                    output[j - chunkStart] = startVal + (endVal - startVal) * weight;
+                }
+            }
+            else if (method == copyOtherChannel && chunk.source.getNumChannels() > 1)
+            {
+                const float* otherData = chunk.source.getReadPointer (ch == 0 ? 1 : 0);
+
+                for (int j = first; j < last; ++j)
+                    output[j - chunkStart] = otherData[j];
+            }
+            else if (method != silence)
+            {
+                return;
+            }
+
+            // Silence: already silent, just marked as handled
+            if (counts)
+                ++repaired;
+        }
+
+        float threshold = 0.0f;
+        int minLength = 1;
+        int method = interpolate;
+        std::atomic<int> found { 0 };
+        std::atomic<int> repaired { 0 };
+    };
+
+    /**
+     * Eccentric record correction: reads the region along a sinusoidal speed
+     * curve through VariableRateResampler. The time map is integrated once in
+     * prepare(), so every chunk reads the same positions one pass would. The
+     * read position strays from the output position by at most deviation *
+     * samplesPerRevolution / pi samples; that plus the kernel's reach is the
+     * overlap.
+     */
+    class EccentricityCorrectionOperation : public RegionOperation
+    {
+    public:
+        EccentricityCorrectionOperation (double samplesPerRevolutionToUse, double phaseRadians, double deviation)
+            : samplesPerRevolution (samplesPerRevolutionToUse), phaseRad (phaseRadians), deviationRatio (deviation)
+        {
+        }
+
+        juce::String getName() const override { return "Eccentric Record Correction"; }
+
+        int getOverlapSamples() const override
+        {
+            return static_cast<int> (std::ceil (deviationRatio * samplesPerRevolution / juce::MathConstants<double>::pi))
+                 + VariableRateResampler::getKernelRadius (1.0 + deviationRatio) + 1;
+        }
+
+        void prepare (const juce::AudioBuffer<float>& source, int regionStart, int regionEnd) override
+        {
+            juce::ignoreUnused (source);
+
+            const double omega = juce::MathConstants<double>::twoPi / samplesPerRevolution;
+            const double phase = phaseRad;
+            const double deviation = deviationRatio;
+
+            // The recording ran at 1 + deviation * sin (phase); reading at 1 - deviation * sin (phase) undoes it
+            map = VariableRateResampler::TimeMap::fromSpeedCurve ([omega, phase, deviation] (juce::int64 n)
+            {
+                return 1.0 - deviation * std::sin (omega * static_cast<double> (n) + phase);
+            }, regionEnd - regionStart);
+
+            resampler = std::make_unique<VariableRateResampler> (map.getMaxSpeed());
+        }
+
+        void processChunk (const Chunk& chunk) override
+        {
+            resampler->render (chunk.source, { chunk.contextStart, chunk.contextEnd }, chunk.regionStart,
+                               map, chunk.start, chunk.end - chunk.start, chunk.output);
+        }
+
+    private:
+        double samplesPerRevolution = 1.0;
+        double phaseRad = 0.0;
+        double deviationRatio = 0.0;
+
+        VariableRateResampler::TimeMap map;
+        std::unique_ptr<VariableRateResampler> resampler;
+    };
+
+    /** Resamples the region by speedRatio (new length / old length) through VariableRateResampler */
+    class SpeedChangeOperation : public RegionOperation
+    {
+    public:
+        explicit SpeedChangeOperation (float ratio) : speedRatio (ratio) {}
+
+        juce::String getName() const override { return "Speed Correction"; }
+
+        int getResultLength (int regionLength) const override
+        {
+            return static_cast<int> (regionLength * speedRatio);
+        }
+
+        void prepare (const juce::AudioBuffer<float>& source, int regionStart, int regionEnd) override
+        {
+            juce::ignoreUnused (source);
 
-                totalClicksRemoved += processor.getClicksDetectedLastBlock();
+            // Slowing down (a ratio above 1) interpolates; speeding up gets a lowpass against aliasing
+            const double speed = 1.0 / speedRatio;
+            map = VariableRateResampler::TimeMap::constantSpeed (speed, getResultLength (regionEnd - regionStart));
+            resampler = std::make_unique<VariableRateResampler> (speed);
+        }
+
+        void processChunk (const Chunk& chunk) override
+        {
+            resampler->render (chunk.source, { chunk.contextStart, chunk.contextEnd }, chunk.regionStart,
+                               map, chunk.start, chunk.end - chunk.start, chunk.output);
+        }
+
+    private:
+        float speedRatio = 1.0f;
+
+        VariableRateResampler::TimeMap map;
+        std::unique_ptr<VariableRateResampler> resampler;
+    };
+
+    /**
+     * Decrackle with a stream per chunk. Each stream starts warmUpSamples
+     * before its chunk and runs as far past it, with the levels of the whole
+     * region, so the chunks join up as one pass over the region would.
+     */
+    class DecrackleOperation : public RegionOperation
+    {
+    public:
+        DecrackleOperation (float factorToUse, int widthToUse, double sr)
+            : factor (factorToUse), width (widthToUse), sampleRate (sr)
+        {
+        }
+
+        juce::String getName() const override { return "Decrackle"; }
+        int getOverlapSamples() const override { return warmUpSamples; }
 
-                setProgress (juce::jlimit (0.0, 1.0,
-                                           (start + samplesThisBlock - scanStart) / (double) totalSamples));
+        void prepare (const juce::AudioBuffer<float>& source, int regionStart, int regionEnd) override
+        {
+            const int numSamples = regionEnd - regionStart;
+            levels = Decrackle::measureLevels (source, regionStart, numSamples);
+            activeWidth = juce::jmin (width, numSamples / 2);
+        }
+
+        void processChunk (const Chunk& chunk) override
+        {
+            if (chunk.regionEnd - chunk.regionStart < 3)
+                return;
+
+            const int numChannels = chunk.source.getNumChannels();
+            const int contextLength = chunk.contextEnd - chunk.contextStart;
+
+            Decrackle decrackle;
+            decrackle.prepare ({ sampleRate, 2048u, static_cast<juce::uint32> (numChannels) });
+            decrackle.setFactor (factor);
+            decrackle.setAverageWidth (activeWidth);
+            decrackle.beginRegionStream (contextLength, levels);
+
+            // The context, then the latency's worth of zeros to flush it
+            const int latency = decrackle.getLatencySamples();
+            juce::AudioBuffer<float> stream (numChannels, contextLength + latency);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                stream.copyFrom (ch, 0, chunk.source, ch, chunk.contextStart, contextLength);
+                stream.clear (ch, contextLength, latency);
             }
 
-            result.totalClicksRemoved = totalClicksRemoved;
+            juce::dsp::AudioBlock<float> block (stream);
+            juce::dsp::ProcessContextReplacing<float> context (block);
+            decrackle.process (context);
+
+            // Output lags input by the latency
+            const int offset = chunk.regionStart + chunk.start - chunk.contextStart + latency;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                chunk.output.copyFrom (ch, 0, stream, ch, offset, chunk.end - chunk.start);
+        }
+
+    private:
+        static constexpr int warmUpSamples = 1024;
+
+        float factor = 0.5f;
+        int width = 3;
+        int activeWidth = 3;
+        double sampleRate = 44100.0;
+        std::vector<float> levels;
+    };
+
+    class RegionOperationTask : public juce::ThreadWithProgressWindow
+    {
+    public:
+        RegionOperationTask (const juce::String& title,
+                             std::shared_ptr<RegionOperation> operationToRun,
+                             juce::AudioBuffer<float>& target,
+                             juce::CriticalSection& targetLock,
+                             double sr,
+                             int startSample,
+                             int endSample)
+            : juce::ThreadWithProgressWindow (title, true, true),
+              operation (std::move (operationToRun)),
+              targetBuffer (target),
+              bufferLock (targetLock),
+              sampleRate (sr),
+              regionStart (startSample),
+              regionEnd (endSample)
+        {
+        }
+
+        void run() override
+        {
+            result = RegionProcessor::process (*operation, targetBuffer, bufferLock, sampleRate, regionStart, regionEnd,
+                                               [this] (double progress)
+                                               {
+                                                   setProgress (progress);
+                                                   return !threadShouldExit();
+                                               });
         }
 
         void threadComplete (bool userPressedCancel) override
@@ -304,17 +973,16 @@ namespace
             delete this;
         }
 
-        ClickRemovalResult result;
-        std::function<void (const ClickRemovalResult&)> onComplete;
+        RegionProcessor::Result result;
+        std::function<void (RegionProcessor::Result&)> onComplete;
 
     private:
+        std::shared_ptr<RegionOperation> operation;
         juce::AudioBuffer<float>& targetBuffer;
+        juce::CriticalSection& bufferLock;
         double sampleRate = 0.0;
-        int scanStart = 0;
-        int scanEnd = 0;
-        float clickSensitivity = 0.0f;
-        int clickMaxWidth = 0;
-        ClickRemoval::RemovalMethod removalMethod = ClickRemoval::Automatic;
+        int regionStart = 0;
+        int regionEnd = 0;
     };
 
 }
@@ -409,7 +1077,10 @@ public:
             format = std::make_unique<juce::FlacAudioFormat>();
         else if (ext == ".ogg")
             format = std::make_unique<juce::OggVorbisAudioFormat>();
-        #if JUCE_USE_MP3AUDIOFORMAT
+        #if USE_LAME
+        else if (ext == ".mp3")
+            format = std::make_unique<LameMP3AudioFormat>();  // Encodes the float blocks as they arrive
+        #elif JUCE_USE_MP3AUDIOFORMAT
         else if (ext == ".mp3")
             format = std::make_unique<juce::MP3AudioFormat>();
         #endif
@@ -479,8 +1150,6 @@ public:
         monitorGain.store (gain);
     }
 
-    void setSilenceThreshold (float db) { silenceThreshold.store (juce::Decibels::decibelsToGain (db)); }
-    void setSilenceDuration (float seconds) { silenceDurationReq.store (seconds); }
     void setPaused (bool shouldBePaused) { 
         if (paused.load() && !shouldBePaused) {
             recordingStartMs = juce::Time::getMillisecondCounterHiRes();
@@ -489,7 +1158,6 @@ public:
     }
 
     std::function<void(const float**, int, int)> onDataAvailable;
-    std::function<void(double positionSeconds)> onSilenceDetected;
 
     void audioDeviceIOCallbackWithContext (const float* const* inputChannelData, int numInputChannels,
                                            float* const* outputChannelData, int numOutputChannels, int numSamples,
@@ -519,8 +1187,6 @@ public:
         auto* writer = activeWriter.load();
         float currentRecordGain = recordGain.load();
         float currentMonitorGain = monitorGain.load();
-        float currentThreshold = silenceThreshold.load();
-        double currentDurationReq = silenceDurationReq.load();
 
         if (writer == nullptr || numInputChannels <= 0)
         {
@@ -539,41 +1205,19 @@ public:
         const float* channelsToRecord[2] = { nullptr, nullptr };
         juce::AudioBuffer<float> gainBuffer (juce::jmin (2, numInputChannels), numSamples);
 
-        float maxLevel = 0.0f;
         for (int ch = 0; ch < gainBuffer.getNumChannels(); ++ch)
         {
             juce::FloatVectorOperations::multiply (gainBuffer.getWritePointer (ch), inputChannelData[ch], currentRecordGain, numSamples);
             channelsToRecord[ch] = gainBuffer.getReadPointer (ch);
-            
-            for (int i = 0; i < numSamples; ++i)
-                maxLevel = juce::jmax (maxLevel, std::abs (channelsToRecord[ch][i]));
         }
 
+        // Silence and clicks are analysed by the capture that onDataAvailable feeds
         if (!paused.load())
         {
             writer->write (channelsToRecord, numSamples);
 
             if (onDataAvailable)
                 onDataAvailable (channelsToRecord, channelsToWrite, numSamples);
-
-            // Track silence for track detection
-            if (maxLevel < currentThreshold)
-            {
-                silenceSamples += numSamples;
-                double silenceDuration = silenceSamples / currentSampleRate;
-                
-                if (silenceDuration > currentDurationReq && !isSilenceTriggered)
-                {
-                    isSilenceTriggered = true;
-                    if (onSilenceDetected)
-                        onSilenceDetected (getSecondsRecorded());
-                }
-            }
-            else
-            {
-                silenceSamples = 0;
-                isSilenceTriggered = false;
-            }
         }
 
                 // Monitoring with gain
@@ -591,13 +1235,8 @@ public:
                 levelRight.store (computeMeterLevel (rightChannel, numSamples));
             }
         
-            void audioDeviceAboutToStart (juce::AudioIODevice* device) override
+            void audioDeviceAboutToStart (juce::AudioIODevice*) override
             {
-                if (device != nullptr)
-                    currentSampleRate = device->getCurrentSampleRate();
-                
-                silenceSamples = 0;
-                isSilenceTriggered = false;
                 levelLeft.store (0.0f);
                 levelRight.store (0.0f);
             }
@@ -632,10 +1271,6 @@ public:
             std::atomic<bool> monitoring { true };
                 std::atomic<float> recordGain { 1.0f };
                 std::atomic<float> monitorGain { 0.7f };
-                std::atomic<float> silenceThreshold { 0.01f }; // Default ~ -40dB
-                std::atomic<double> silenceDurationReq { 2.0 }; // Default 2.0s
-                int64_t silenceSamples = 0;
-                bool isSilenceTriggered = false;            double currentSampleRate = 48000.0;
             juce::File currentOutputFile;
             double recordingStartMs = 0.0;
             int channelsToWrite = 0;
@@ -645,16 +1280,30 @@ public:
 // StandaloneWindow Implementation
 //==============================================================================
 
+/**
+ * Plays the working buffer as it is, whatever its length: edits change the
+ * buffer under bufferLock and the source follows, so it is never rebuilt.
+ * A block that meets an edit in progress plays as silence.
+ */
 class StandaloneWindow::BufferAudioSource : public juce::PositionableAudioSource
 {
 public:
-    BufferAudioSource (const juce::AudioBuffer<float>& b) : buffer (b) {}
+    BufferAudioSource (const juce::AudioBuffer<float>& b, const juce::CriticalSection& lock, LivePreviewChain& previewToUse)
+        : buffer (b), bufferLock (lock), preview (previewToUse) {}
 
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override {}
     void releaseResources() override {}
 
     void getNextAudioBlock (const juce::AudioSourceChannelInfo& info) override
     {
+        const juce::ScopedTryLock sl (bufferLock);
+
+        if (!sl.isLocked() || buffer.getNumChannels() == 0)
+        {
+            info.clearActiveBufferRegion();
+            return;
+        }
+
         auto totalSamples = buffer.getNumSamples();
         auto readPos = position.load();
         auto numSamples = juce::jmin (info.numSamples, (int)(totalSamples - readPos));
@@ -667,6 +1316,10 @@ public:
         for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
             info.buffer->copyFrom (ch, info.startSample, buffer, ch % buffer.getNumChannels(), (int)readPos, numSamples);
 
+        // Previewed stages read ahead from the buffer, before any resampling by the transport
+        if (preview.isActive())
+            preview.process (buffer, readPos, *info.buffer, info.startSample, numSamples);
+
         if (numSamples < info.numSamples)
             info.buffer->clear (info.startSample + numSamples, info.numSamples - numSamples);
 
@@ -680,50 +1333,119 @@ public:
 
 private:
     const juce::AudioBuffer<float>& buffer;
+    const juce::CriticalSection& bufferLock;
+    LivePreviewChain& preview;
     std::atomic<juce::int64> position { 0 };
 };
 
-class StandaloneWindow::RestorationAudioSource : public juce::AudioSource
+class StandaloneWindow::RestorationAudioSource : public juce::AudioSource,
+                                                 private juce::AsyncUpdater
 {
 public:
-    RestorationAudioSource (juce::AudioSource& sourceToWrap, OnnxDenoiser& denoiserToUse, const bool& aiEnabledFlag, FilterBank& fb, const bool& eqEnabledFlag)
-        : source (sourceToWrap), denoiser (denoiserToUse), aiEnabled (aiEnabledFlag), filterBank (fb), eqEnabled (eqEnabledFlag) 
+    RestorationAudioSource (juce::AudioSource& sourceToWrap, OnnxDenoiser& denoiserToUse, const bool& aiEnabledFlag, FilterBank& fb, const bool& eqEnabledFlag,
+                            Decrackle& decrackleToUse, const bool& decrackleEnabledFlag)
+        : source (sourceToWrap), denoiser (denoiserToUse), aiEnabled (aiEnabledFlag), filterBank (fb), eqEnabled (eqEnabledFlag),
+          decrackle (decrackleToUse), decrackleEnabled (decrackleEnabledFlag)
     {
-        leftLevel.store (0.0f);
-        rightLevel.store (0.0f);
     }
 
+    ~RestorationAudioSource() override { cancelPendingUpdate(); }
+
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override
     {
         source.prepareToPlay (samplesPerBlockExpected, sampleRate);
-        currentSampleRate = sampleRate; currentBlockSize = samplesPerBlockExpected;
-        denoiser.prepare (sampleRate, currentNumChannels, samplesPerBlockExpected);
-        juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) samplesPerBlockExpected, (juce::uint32) currentNumChannels };
-        filterBank.prepare (spec);
+
+        {
+            const juce::SpinLock::ScopedLockType sl (stagesLock);
+            currentSampleRate = sampleRate; currentBlockSize = samplesPerBlockExpected;
+            prepareStages();
+        }
+
+        profiler.prepare (sampleRate);
+        visualizationTap.prepare (sampleRate);
     }
 
     void releaseResources() override { source.releaseResources(); denoiser.reset(); }
 
     void getNextAudioBlock (const juce::AudioSourceChannelInfo& info) override
     {
-        source.getNextAudioBlock (info);
-        if (info.buffer == nullptr || info.numSamples <= 0) 
+        const StageProfiler::ScopedBlock profiledBlock (profiler, info.numSamples);
+
         {
-            leftLevel.store (0.0f);
-            rightLevel.store (0.0f);
-            return;
+            // Reading (and resampling) the document is this chain's setup
+            VRS_PROFILE_STAGE (profiler, setup);
+            source.getNextAudioBlock (info);
         }
 
-        if (info.buffer->getNumChannels() != currentNumChannels) {
-            currentNumChannels = info.buffer->getNumChannels();
-            if (currentSampleRate > 0.0) {
-                denoiser.prepare (currentSampleRate, currentNumChannels, currentBlockSize);
-                juce::dsp::ProcessSpec spec { currentSampleRate, (juce::uint32) currentBlockSize, (juce::uint32) currentNumChannels };
-                filterBank.prepare (spec);
+        if (info.buffer == nullptr || info.numSamples <= 0)
+            return;
+
+        {
+            // Re-preparing for a new channel layout takes locks, joins threads and allocates, so it
+            // happens on the message thread; until it is done (or while it runs) the block plays dry
+            const juce::SpinLock::ScopedTryLockType stagesAvailable (stagesLock);
+
+            if (stagesAvailable.isLocked())
+            {
+                if (info.buffer->getNumChannels() == currentNumChannels)
+                    processStages (info);
+                else if (pendingNumChannels.exchange (info.buffer->getNumChannels()) != info.buffer->getNumChannels())
+                    triggerAsyncUpdate();
             }
         }
 
+        // Level summaries for metering; the meter reads everything since its last frame
+        VRS_PROFILE_STAGE (profiler, visualization);
+        juce::dsp::AudioBlock<float> block (*info.buffer, (size_t)info.startSample);
+        visualizationTap.push (block.getSubBlock (0, (size_t)info.numSamples));
+    }
+
+    VisualizationTap& getVisualizationTap() { return visualizationTap; }
+    StageProfiler& getStageProfiler() { return profiler; }
+
+private:
+    /** Called with stagesLock held */
+    void prepareStages()
+    {
+        if (currentSampleRate <= 0.0)
+            return;
+
+        denoiser.prepare (currentSampleRate, currentNumChannels, currentBlockSize);
+        juce::dsp::ProcessSpec spec { currentSampleRate, (juce::uint32) currentBlockSize, (juce::uint32) currentNumChannels };
+        filterBank.prepare (spec);
+        decrackle.prepare (spec);
+    }
+
+    void handleAsyncUpdate() override
+    {
+        const juce::SpinLock::ScopedLockType sl (stagesLock);
+        const int numChannels = pendingNumChannels.exchange (0);
+
+        if (numChannels <= 0 || numChannels == currentNumChannels)
+            return;
+
+        currentNumChannels = numChannels;
+        prepareStages();
+    }
+
+    void processStages (const juce::AudioSourceChannelInfo& info)
+    {
+        if (decrackleEnabled) {
+            VRS_PROFILE_STAGE (profiler, clickRemoval);
+
+            // Stale carry-over from before the last enable would click once
+            if (!decrackleWasEnabled)
+                decrackle.reset();
+
+            juce::dsp::AudioBlock<float> block (*info.buffer, (size_t)info.startSample);
+            auto subBlock = block.getSubBlock (0, (size_t)info.numSamples);
+            juce::dsp::ProcessContextReplacing<float> context (subBlock);
+            decrackle.process (context);
+        }
+        decrackleWasEnabled = decrackleEnabled;
+
         if (eqEnabled) {
+            VRS_PROFILE_STAGE (profiler, filterBank);
             juce::dsp::AudioBlock<float> block (*info.buffer, (size_t)info.startSample);
             auto subBlock = block.getSubBlock (0, (size_t)info.numSamples);
             juce::dsp::ProcessContextReplacing<float> context (subBlock);
@@ -731,6 +1453,8 @@ public:
         }
 
         if (aiEnabled) {
+            VRS_PROFILE_STAGE (profiler, aiDenoise);
+
             if (info.startSample == 0 && info.numSamples == info.buffer->getNumSamples()) {
                 denoiser.setEnabled (true); denoiser.processBlock (*info.buffer, 1.0f);
             } else {
@@ -738,32 +1462,19 @@ public:
                 for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
                     tempBuffer.copyFrom (ch, 0, *info.buffer, ch, info.startSample, info.numSamples);
                 denoiser.setEnabled (true); denoiser.processBlock (tempBuffer, 1.0f);
-                for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
-                    info.buffer->copyFrom (ch, info.startSample, tempBuffer, ch, 0, info.numSamples);
-            }
-        }
-
-        // Calculate levels for metering
-        float maxL = 0.0f, maxR = 0.0f;
-        auto* dataL = info.buffer->getReadPointer (0, info.startSample);
-        auto* dataR = info.buffer->getNumChannels() > 1 ? info.buffer->getReadPointer (1, info.startSample) : dataL;
-
-        for (int i = 0; i < info.numSamples; ++i)
-        {
-            maxL = juce::jmax (maxL, std::abs (dataL[i]));
-            maxR = juce::jmax (maxR, std::abs (dataR[i]));
+                for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
+                    info.buffer->copyFrom (ch, info.startSample, tempBuffer, ch, 0, info.numSamples);
+            }
         }
-
-        leftLevel.store (maxL);
-        rightLevel.store (maxR);
     }
 
-    float getLevel (int channel) const { return channel == 0 ? leftLevel.load() : rightLevel.load(); }
-
-private:
     juce::AudioSource& source; OnnxDenoiser& denoiser; const bool &aiEnabled, &eqEnabled; FilterBank& filterBank;
+    Decrackle& decrackle; const bool& decrackleEnabled; bool decrackleWasEnabled = false;
     juce::AudioBuffer<float> tempBuffer; double currentSampleRate = 0.0; int currentBlockSize = 0, currentNumChannels = 2;
-    std::atomic<float> leftLevel, rightLevel;
+    juce::SpinLock stagesLock;                  // Held by the message thread while the stages are prepared
+    std::atomic<int> pendingNumChannels { 0 };  // Layout the audio thread is waiting for, 0 for none
+    VisualizationTap visualizationTap;
+    StageProfiler profiler;
 };
 
 StandaloneWindow::StandaloneWindow()
@@ -782,6 +1493,11 @@ StandaloneWindow::StandaloneWindow()
     if (icon.isValid())
         setIcon (icon);
 
+    const auto undoSettings = SettingsManager::getInstance().getUndoSettings();
+    undoManager.setMaxStates (undoSettings.maxStates);
+    undoManager.setMemoryPolicy (undoSettings.residentStates,
+                                 static_cast<size_t> (juce::jmax (0, undoSettings.memoryBudgetMB)) * 1024 * 1024);
+
     // Initialize command manager
     commandManager.registerAllCommandsForTarget (this);
     addKeyListener (commandManager.getKeyMappings());
@@ -804,7 +1520,8 @@ StandaloneWindow::StandaloneWindow()
 
     // Setup audio transport
     transportSource.addChangeListener (this);
-    restorationSource = std::make_unique<RestorationAudioSource> (transportSource, realtimeDenoiser, aiDenoiseEnabled, filterBankProcessor, realtimeEqEnabled);
+    restorationSource = std::make_unique<RestorationAudioSource> (transportSource, realtimeDenoiser, aiDenoiseEnabled, filterBankProcessor, realtimeEqEnabled,
+                                                                  realtimeDecrackle, realtimeDecrackleEnabled);
     audioSourcePlayer.setSource (restorationSource.get());
     audioDeviceManager.addAudioCallback (&audioSourcePlayer);
     recorder = std::make_unique<AudioRecorder>();
@@ -816,38 +1533,44 @@ StandaloneWindow::StandaloneWindow()
             // Update thumbnail in real-time
             mainComponent->getWaveformDisplay().addBlock (data, numChannels, numSamples);
         }
+
+        recordingCapture.push (data, numChannels, numSamples);
     };
     audioDeviceManager.addAudioCallback (recorder.get());
     
-    recorder->onSilenceDetected = [this] (double pos)
+    // Track gaps found while recording are marked as they are found
+    recordingCapture.onTrackBoundary = [this] (int64_t position)
     {
-        juce::MessageManager::callAsync ([this, pos]()
+        juce::MessageManager::callAsync ([this, position]()
         {
-            auto* alert = new juce::AlertWindow ("Silence Detected", 
-                                                 "Potential track gap detected at " + juce::String (pos, 1) + "s.\nIs this a new track?", 
-                                                 juce::AlertWindow::QuestionIcon);
-            alert->addButton ("New Track", 1);
-            alert->addButton ("Continue", 0);
-            
-            alert->enterModalState (true, juce::ModalCallbackFunction::create ([this, pos](int result)
-            {
-                if (result == 1) // New Track
-                {
-                    // Add track marker
-                    int64_t posSamples = static_cast<int64_t> (pos * sampleRate);
-                    mainComponent->getWaveformDisplay().addClickMarker (posSamples);
-                    mainComponent->getTrackListView().addMarker (posSamples, "Auto Track " + juce::String (mainComponent->getTrackListView().getNumMarkers() + 1));
-                    mainComponent->getCorrectionListView().setStatusText ("Track marker added at " + juce::String (pos, 1) + "s");
-                }
-            }), true);
+            if (mainComponent == nullptr)
+                return;
+
+            auto& trackList = mainComponent->getTrackListView();
+            trackList.addMarker (position, "Auto Track " + juce::String (trackList.getNumMarkers() + 1));
+            mainComponent->getCorrectionListView().setStatusText ("Track marker added at "
+                                                                  + juce::String (position / recordingCapture.getSampleRate(), 1) + "s");
         });
     };
 
+    providerBenchmark.onFinished = [this] (const SettingsManager::ProviderBenchmarkRecord&) { applyDenoiserSettings(); };
     applyDenoiserSettings();
 
     // Create main component
     mainComponent = std::make_unique<MainComponent> (undoManager);
     mainComponent->setParentWindow (this);
+    mainComponent->setStageProfiler (&static_cast<RestorationAudioSource*> (restorationSource.get())->getStageProfiler());
+    spectrogramCache->setSource (&audioBuffer, sampleRate, &audioBufferLock);
+    mainComponent->getWaveformDisplay().setSpectrogramCache (spectrogramCache);
+
+    // Track detection levels follow edits: patched in place, or rebuilt when next needed
+    mainComponent->getWaveformDisplay().onAudioChanged = [this] (int64_t start, int64_t numSamples)
+    {
+        if (numSamples >= 0 && trackLevels.matches (audioBuffer, trackDetectionSettings.rmsWindowSamples))
+            trackLevels.update (audioBuffer, start, numSamples);
+        else
+            trackLevels.clear();
+    };
     mainComponent->setCorrectionListVisible (showCorrectionList);
 
     // Wire up waveform double-click to seek playback
@@ -915,6 +1638,17 @@ StandaloneWindow::~StandaloneWindow()
     audioDeviceManager.removeAudioCallback (&audioSourcePlayer);
     if (recorder)
         audioDeviceManager.removeAudioCallback (recorder.get());
+    recordingCapture.cancel();
+
+    if (mainComponent != nullptr)
+        mainComponent->setStageProfiler (nullptr);
+
+    // Open spectrogram views may keep the cache alive; detach it from the buffer
+    {
+        const juce::ScopedLock sl (audioBufferLock);
+        spectrogramCache->setSource (nullptr, sampleRate);
+    }
+
     recorder.reset();
     transportSource.removeChangeListener (this);
 
@@ -933,18 +1667,22 @@ void StandaloneWindow::updateTransportSourceFromBuffer (juce::int64 sampleOffset
     // Always use BufferAudioSource to ensure memory edits/recordings are audible
     if (audioBuffer.getNumSamples() > 0)
     {
-        bool isNewSource = false;
-        if (bufferSource == nullptr || bufferSource->getTotalLength() != audioBuffer.getNumSamples())
+        // The buffer source follows edits of any length, so it is only set up once
+        if (bufferSource == nullptr || readerSource != nullptr)
         {
             // Reset reader source if we were using one
             readerSource.reset();
-            
-            // Create and set buffer source
-            bufferSource.reset (new BufferAudioSource (audioBuffer));
+
+            if (bufferSource == nullptr)
+                bufferSource.reset (new BufferAudioSource (audioBuffer, audioBufferLock, livePreview));
+
             transportSource.setSource (bufferSource.get(), 0, nullptr, sampleRate);
-            isNewSource = true;
         }
 
+        // A file of another rate or layout needs preview stages prepared for it
+        if (sampleRate != livePreviewSampleRate || audioBuffer.getNumChannels() != livePreviewNumChannels)
+            updateLivePreview();
+
         // Get current playback position in samples
         juce::int64 currentPositionSamples = static_cast<juce::int64> (transportSource.getCurrentPosition() * sampleRate);
 
@@ -971,7 +1709,64 @@ void StandaloneWindow::updateTransportSourceFromBuffer (juce::int64 sampleOffset
         transportSource.setSource (nullptr);
         bufferSource.reset();
         readerSource.reset();
+
+        // The noise profile belonged to the closed audio
+        previewNoiseReductionEnabled = false;
+        noiseReductionPreview = {};
+        updateLivePreview();
+    }
+}
+
+void StandaloneWindow::updateLivePreview()
+{
+    const int numChannels = audioBuffer.getNumChannels();
+    livePreviewSampleRate = sampleRate;
+    livePreviewNumChannels = numChannels;
+
+    if (numChannels == 0 || sampleRate <= 0.0)
+    {
+        livePreview.setStages (nullptr, nullptr, 0, 0);
+        return;
+    }
+
+    // Built and prepared here, then handed to the audio thread whole
+    constexpr int blockSize = 2048;
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.numChannels = static_cast<juce::uint32> (numChannels);
+    spec.maximumBlockSize = blockSize;
+
+    std::unique_ptr<ClickRemoval> clicks;
+
+    if (previewClickRemovalEnabled)
+    {
+        clicks = std::make_unique<ClickRemoval>();
+        clicks->prepare (spec);
+        clicks->setSensitivity (clickSensitivity);
+        clicks->setMaxWidth (clickMaxWidth);
+        clicks->setRemovalMethod (static_cast<ClickRemoval::RemovalMethod> (clickRemovalMethod));
+        clicks->setStoreDetectedClicks (false);
+        clicks->setApplyRemoval (true);
+    }
+
+    std::unique_ptr<NoiseReduction> noise;
+
+    if (previewNoiseReductionEnabled && noiseReductionPreview.profileLength > 0)
+    {
+        noise = std::make_unique<NoiseReduction>();
+        noise->setResolution (noiseReductionProcessor.getFFTSize(), noiseReductionProcessor.getOverlap(),
+                              noiseReductionProcessor.isMultiResolution());
+        noise->prepare (spec);
+        noise->setReduction (noiseReductionPreview.reductionDB);
+        noise->setAdaptiveEnabled (noiseReductionPreview.adaptiveRate > 0.0f);
+        noise->setAdaptiveRate (noiseReductionPreview.adaptiveRate);
+        noise->captureProfileFromBuffer (audioBuffer, noiseReductionPreview.profileStart, noiseReductionPreview.profileLength);
+
+        if (!noise->hasProfile())
+            noise.reset();
     }
+
+    livePreview.setStages (std::move (clicks), std::move (noise), numChannels, blockSize);
 }
 
 void StandaloneWindow::closeButtonPressed()
@@ -1072,6 +1867,7 @@ juce::PopupMenu StandaloneWindow::getMenuForIndex (int topLevelMenuIndex, const
         menu.addSeparator();
         menu.addCommandItem (&commandManager, fileSave);
         menu.addCommandItem (&commandManager, fileSaveAs);
+        menu.addItem (fileExportSessionJSON, "Export Session as JSON...", currentFile.existsAsFile());
         menu.addSeparator();
         menu.addCommandItem (&commandManager, fileExport);
         menu.addCommandItem (&commandManager, fileRecord);
@@ -1105,6 +1901,7 @@ juce::PopupMenu StandaloneWindow::getMenuForIndex (int topLevelMenuIndex, const
         menu.addItem (processDecrackle, "Decrackle...", hasAudio);
         menu.addSeparator();
         menu.addItem (processNoiseReduction, "Noise Reduction...", hasAudio);
+        menu.addItem (processAIDenoise, "AI Denoise", hasAudio);
         menu.addSeparator();
         menu.addItem (processCutAndSplice, "Cut and Splice...", hasAudio);
         menu.addSeparator();
@@ -1160,6 +1957,10 @@ juce::PopupMenu StandaloneWindow::getMenuForIndex (int topLevelMenuIndex, const
         menu.addItem (optionsRecordingSettings, "Recording Settings...");
         menu.addSeparator();
         menu.addItem (optionsAIDenoise, "AI Denoise (Realtime)", true, aiDenoiseEnabled);
+        menu.addItem (optionsRealtimeDecrackle, "Decrackle (Realtime)", true, realtimeDecrackleEnabled);
+        menu.addItem (optionsPreviewClickRemoval, "Click Removal (Preview)", true, previewClickRemovalEnabled);
+        menu.addItem (optionsPreviewNoiseReduction, "Noise Reduction (Preview)",
+                      noiseReductionPreview.profileLength > 0, previewNoiseReductionEnabled);
     }
     else if (topLevelMenuIndex == 5) // Help
     {
@@ -1175,7 +1976,8 @@ void StandaloneWindow::menuItemSelected (int menuItemID, int)
     if (menuItemID >= 100 && menuItemID < 200)
     {
         juce::File file = recentFiles.getFile (menuItemID - 100);
-        if (file.exists()) openFile (file);
+        if (file.hasFileExtension ("vrs;json")) loadSession (file);
+        else if (file.exists()) openFile (file);
         return;
     }
 
@@ -1185,6 +1987,7 @@ void StandaloneWindow::menuItemSelected (int menuItemID, int)
         case fileClose: closeFile(); break;
         case fileCloseNoSave: hasUnsavedChanges = false; closeFile(); break;
         case fileExitNoSave: hasUnsavedChanges = false; juce::JUCEApplication::getInstance()->quit(); break;
+        case fileExportSessionJSON: exportSessionAsJSON(); break;
         case editMetadata: showMetadataEditor(); break;
         case viewToggleSpectral:
             if (mainComponent != nullptr) {
@@ -1207,6 +2010,7 @@ void StandaloneWindow::menuItemSelected (int menuItemID, int)
         case processRemoveClicks: removeClicks(); break;
         case processDecrackle: applyDecrackle(); break;
         case processNoiseReduction: applyNoiseReduction(); break;
+        case processAIDenoise: applyAIDenoise(); break;
         case processGraphicEQ: showGraphicEQ(); break;
         case processNormalise: normalise(); break;
         case processChannelBalance: channelBalance(); break;
@@ -1221,6 +2025,9 @@ void StandaloneWindow::menuItemSelected (int menuItemID, int)
         case optionsProcessingSettings: showProcessingSettings(); break;
         case optionsRecordingSettings: showRecordingSettings(); break;
         case optionsAIDenoise: aiDenoiseEnabled = !aiDenoiseEnabled; realtimeDenoiser.setEnabled (aiDenoiseEnabled); break;
+        case optionsRealtimeDecrackle: realtimeDecrackleEnabled = !realtimeDecrackleEnabled; break;
+        case optionsPreviewClickRemoval: previewClickRemovalEnabled = !previewClickRemovalEnabled; updateLivePreview(); break;
+        case optionsPreviewNoiseReduction: previewNoiseReductionEnabled = !previewNoiseReductionEnabled; updateLivePreview(); break;
         case helpAbout: showAboutDialog(); break;
         case helpDocumentation: showDocumentation(); break;
         default: break;
@@ -1243,11 +2050,11 @@ bool StandaloneWindow::perform (const juce::ApplicationCommandTarget::Invocation
     }
     switch (info.commandID) {
         case fileOpen: {
-            auto chooser = std::make_shared<juce::FileChooser> ("Open Audio File or Session", juce::File::getSpecialLocation (juce::File::userHomeDirectory), "*.wav;*.flac;*.aiff;*.ogg;*.mp3;*.vrs");
+            auto chooser = std::make_shared<juce::FileChooser> ("Open Audio File or Session", juce::File::getSpecialLocation (juce::File::userHomeDirectory), "*.wav;*.flac;*.aiff;*.ogg;*.mp3;*.vrs;*.json");
             chooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles, [this, chooser] (const juce::FileChooser&) {
                 auto file = chooser->getResult();
                 if (file.existsAsFile()) {
-                    if (file.hasFileExtension ("vrs")) loadSession (file);
+                    if (file.hasFileExtension ("vrs;json")) loadSession (file);
                     else openFile (file);
                 }
             });
@@ -1280,7 +2087,10 @@ bool StandaloneWindow::perform (const juce::ApplicationCommandTarget::Invocation
                 case editUndo:
                     if (undoManager.canUndo())
                     {
-                        undoManager.undo (audioBuffer, sampleRate);
+                        {
+                            const juce::ScopedLock sl (audioBufferLock);
+                            undoManager.undo (audioBuffer, sampleRate);
+                        }
                         updateTransportSourceFromBuffer();
                         if (mainComponent != nullptr)
                         {
@@ -1294,7 +2104,10 @@ bool StandaloneWindow::perform (const juce::ApplicationCommandTarget::Invocation
                 case editRedo:
                     if (undoManager.canRedo())
                     {
-                        undoManager.redo (audioBuffer, sampleRate);
+                        {
+                            const juce::ScopedLock sl (audioBufferLock);
+                            undoManager.redo (audioBuffer, sampleRate);
+                        }
                         updateTransportSourceFromBuffer();
                         if (mainComponent != nullptr)
                         {
@@ -1315,6 +2128,7 @@ bool StandaloneWindow::perform (const juce::ApplicationCommandTarget::Invocation
         case processRemoveClicks: removeClicks(); return true;
         case processDecrackle: applyDecrackle(); return true;
         case processNoiseReduction: applyNoiseReduction(); return true;
+        case processAIDenoise: applyAIDenoise(); return true;
         case processGraphicEQ: showGraphicEQ(); return true;
         case processNormalise: normalise(); return true;
         case processChannelBalance: channelBalance(); return true;
@@ -1360,7 +2174,8 @@ void StandaloneWindow::timerCallback()
             mainComponent->updatePlaybackPosition (pos / length);
             if (restorationSource != nullptr) {
                 auto* rs = static_cast<RestorationAudioSource*>(restorationSource.get());
-                mainComponent->setMeterLevel (rs->getLevel(0), rs->getLevel(1));
+                const auto levels = rs->getVisualizationTap().readLevels();
+                mainComponent->setMeterLevel (levels.peak[0], levels.peak[1]);
             }
         }
     }
@@ -1409,24 +2224,84 @@ void StandaloneWindow::openFile (const juce::File& file)
     if (!promptToSaveIfNeeded ("Opening File")) return;
     juce::AudioBuffer<float> newBuffer; double newSampleRate = 0.0;
     if (fileManager.loadAudioFile (file, newBuffer, newSampleRate)) {
-        audioBuffer = std::move (newBuffer); sampleRate = newSampleRate; currentFile = file; currentSessionFile = juce::File();
+        { const juce::ScopedLock sl (audioBufferLock); audioBuffer = std::move (newBuffer); }
+        sampleRate = newSampleRate; currentFile = file; currentSessionFile = juce::File();
         updateTransportSourceFromBuffer();
-        if (mainComponent != nullptr) { mainComponent->setAudioBuffer (&audioBuffer, sampleRate); mainComponent->getUndoHistoryView().refresh(); }
+        if (mainComponent != nullptr) { mainComponent->getWaveformDisplay().loadFile (file); mainComponent->setAudioBuffer (&audioBuffer, sampleRate); mainComponent->getUndoHistoryView().refresh(); }
         recentFiles.addFile (file); menuItemsChanged(); updateTitle();
     }
 }
 
 bool StandaloneWindow::saveFile (const juce::File& file)
 {
-    juce::var data = new juce::DynamicObject();
-    if (fileManager.saveSession (file, currentFile, data)) { currentSessionFile = file; hasUnsavedChanges = false; updateTitle(); return true; }
+    auto writer = createSessionWriter();
+    if (writer != nullptr && writer->writeTo (file)) { currentSessionFile = file; hasUnsavedChanges = false; updateTitle(); return true; }
     return false;
 }
 
+std::unique_ptr<SessionFile::Writer> StandaloneWindow::createSessionWriter()
+{
+    if (!currentFile.existsAsFile())
+        return nullptr;
+
+    auto writer = std::make_unique<SessionFile::Writer> (currentFile);
+    writer->setSettings (new juce::DynamicObject());
+
+    if (mainComponent != nullptr)
+    {
+        writer->setCorrections (*mainComponent->getCorrectionListView().getCorrectionStore());
+
+        auto& trackList = mainComponent->getTrackListView();
+        std::vector<TrackDetector::TrackBoundary> tracks;
+        tracks.reserve ((size_t) trackList.getNumMarkers());
+
+        for (int i = 0; i < trackList.getNumMarkers(); ++i)
+            tracks.emplace_back (trackList.getMarker (i).position, false, trackList.getMarker (i).name);
+
+        writer->setTracks (tracks);
+    }
+
+    // The sidecar checks its own fingerprint; the levels follow the buffer, so they only
+    // describe the file while there is no edit to undo
+    writer->addPeakCache (PeakPyramid::getSidecarFile (currentFile));
+
+    if (!undoManager.canUndo() && trackLevels.matches (audioBuffer, trackDetectionSettings.rmsWindowSamples))
+        writer->addLevelCache (trackLevels);
+
+    return writer;
+}
+
+void StandaloneWindow::exportSessionAsJSON()
+{
+    auto writer = createSessionWriter();
+
+    if (writer == nullptr)
+        return;
+
+    // Through the binary form, so the JSON holds exactly what a saved session would
+    juce::MemoryOutputStream binary;
+
+    if (!writer->writeTo (binary))
+        return;
+
+    const auto session = std::make_shared<SessionFile> (binary.getMemoryBlock());
+    const auto startFile = (currentSessionFile.exists() ? currentSessionFile : currentFile).withFileExtension ("json");
+    auto chooser = std::make_shared<juce::FileChooser> ("Export Session as JSON", startFile, "*.json");
+
+    chooser->launchAsync (juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles, [session, chooser] (const juce::FileChooser&) {
+        auto file = chooser->getResult();
+
+        if (file != juce::File() && !file.replaceWithText (juce::JSON::toString (session->toJSON())))
+            juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::WarningIcon, "Export Failed",
+                                                    "Could not write " + file.getFullPathName());
+    });
+}
+
 void StandaloneWindow::closeFile()
 {
     if (!promptToSaveIfNeeded ("Closing File")) return;
-    audioBuffer.setSize (0, 0); currentFile = juce::File(); currentSessionFile = juce::File();
+    { const juce::ScopedLock sl (audioBufferLock); audioBuffer.setSize (0, 0); }
+    currentFile = juce::File(); currentSessionFile = juce::File();
     updateTransportSourceFromBuffer();
     if (mainComponent != nullptr) mainComponent->setAudioBuffer (nullptr, 0.0);
     hasUnsavedChanges = false; updateTitle();
@@ -1572,6 +2447,9 @@ void StandaloneWindow::detectClicks()
                 clickMaxWidth = juce::jlimit (10, 2000, clickMaxWidth);
                 clickRemovalMethod = settingsComponent->getMethodIndex();
 
+                if (previewClickRemovalEnabled)
+                    updateLivePreview();
+
                 // Now perform the actual detection
                 performClickDetection();
             }
@@ -1611,7 +2489,7 @@ void StandaloneWindow::performClickDetection()
                                          clickMaxWidth,
                                          static_cast<ClickRemoval::RemovalMethod> (clickRemovalMethod));
 
-    task->onComplete = [this, rangeInfo] (const ClickDetectionResult& result)
+    task->onComplete = [this, rangeInfo] (ClickDetectionResult& result)
     {
         if (result.cancelled)
         {
@@ -1620,7 +2498,8 @@ void StandaloneWindow::performClickDetection()
         }
 
         DBG ("Total clicks detected during scan: " + juce::String (result.totalClicks));
-        DBG ("Clicks stored in vector: " + juce::String (result.clicks.size()));
+        DBG ("Clicks stored: " + juce::String (static_cast<int> (result.clicks.size()))
+             + " (" + juce::String (static_cast<int> (result.clicks.getMemoryUsage() / 1024)) + " KB)");
 
         if (result.clicks.empty())
         {
@@ -1631,27 +2510,18 @@ void StandaloneWindow::performClickDetection()
         }
         else
         {
-            auto* applier = new ClickDetectionApplier (
-                &mainComponent->getCorrectionListView(),
-                &mainComponent->getWaveformDisplay(),
-                result.clicks,
-                rangeInfo,
-                [this] (const juce::String& status)
-                {
-                    mainComponent->getCorrectionListView().setStatusText (status);
-                },
-                [this, rangeInfo] (size_t count)
-                {
-                    if (count > 0)
-                        hasUnsavedChanges = true;
+            const auto count = result.clicks.size();
 
-                    updateTitle();
+            // The list takes ownership of the store and the waveform shares it, so nothing is copied
+            auto& listView = mainComponent->getCorrectionListView();
+            listView.setCorrections (std::move (result.clicks));
+            mainComponent->getWaveformDisplay().setDetectedClicks (listView.getCorrectionStore());
 
-                    juce::String message = "Detected " + juce::String (count) + " clicks/pops in " + rangeInfo + ".";
-                    mainComponent->getCorrectionListView().setStatusText (message);
-                    mainComponent->getWaveformDisplay().repaint(); // Force markers to show up
-                });
-            (void) applier;
+            hasUnsavedChanges = true;
+            updateTitle();
+
+            juce::String message = "Detected " + juce::String (static_cast<int> (count)) + " clicks/pops in " + rangeInfo + ".";
+            listView.setStatusText (message);
         }
     };
 
@@ -1694,9 +2564,6 @@ void StandaloneWindow::removeClicks()
         return;
     }
 
-    // Save state for undo
-    undoManager.saveState (audioBuffer, sampleRate, "Click Removal");
-
     mainComponent->getCorrectionListView().setStatusText ("Removing clicks in " + rangeInfo + "...");
     DBG ("Starting click removal on " + juce::String (scanEnd - scanStart) + " samples (" + rangeInfo + ")");
 
@@ -1708,10 +2575,17 @@ void StandaloneWindow::removeClicks()
                                        clickMaxWidth,
                                        static_cast<ClickRemoval::RemovalMethod> (clickRemovalMethod));
 
-    task->onComplete = [this, rangeInfo] (const ClickRemovalResult& result)
+    task->onComplete = [this, rangeInfo, scanStart, scanEnd] (ClickRemovalResult& result)
     {
         DBG ("Total clicks removed: " + juce::String (result.totalClicksRemoved));
 
+        // Undo restores only the repaired samples, including those of a cancelled run
+        if (!result.undoEdit.isEmpty())
+        {
+            undoManager.addEdit (std::move (result.undoEdit));
+            mainComponent->getUndoHistoryView().refresh();
+        }
+
         // Mark corrections as applied in the list
         mainComponent->getCorrectionListView().markAllApplied();
 
@@ -1722,7 +2596,14 @@ void StandaloneWindow::removeClicks()
         mainComponent->getCorrectionListView().clearCorrections();
 
         // Update waveform display to show processed audio
-        mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
+        mainComponent->getWaveformDisplay().updateRegion (audioBuffer, sampleRate, scanStart, scanEnd - scanStart);
+
+        // Now in the audio, so the preview would repair it twice
+        if (previewClickRemovalEnabled)
+        {
+            previewClickRemovalEnabled = false;
+            updateLivePreview();
+        }
 
         hasUnsavedChanges = true;
         updateTitle();
@@ -1773,45 +2654,81 @@ void StandaloneWindow::applyDecrackle()
             factor = juce::jlimit (0.01f, 1.0f, factor);
             width = juce::jlimit (1, 10, width);
 
-            undoManager.saveState (audioBuffer, sampleRate, "Decrackle");
             auto range = getProcessingRange();
             mainComponent->getCorrectionListView().setStatusText ("Applying decrackle in " + range.rangeInfo + "...");
 
-            decrackleProcessor.setFactor (factor);
-            decrackleProcessor.setAverageWidth (width);
-            if (range.hasSelection)
-            {
-                const int selectionSamples = range.end - range.start;
-                juce::AudioBuffer<float> temp (audioBuffer.getNumChannels(), selectionSamples);
-                for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
-                    temp.copyFrom (ch, 0, audioBuffer, ch, range.start, selectionSamples);
-
-                decrackleProcessor.process (temp);
+            // Realtime preview follows the last applied settings
+            realtimeDecrackle.setFactor (factor);
+            realtimeDecrackle.setAverageWidth (width);
 
-                for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
-                    audioBuffer.copyFrom (ch, range.start, temp, ch, 0, selectionSamples);
-            }
-            else
+            runRegionOperation (std::make_shared<DecrackleOperation> (factor, width, sampleRate), range, "Applying decrackle...",
+                                [this, factor, width] (const RegionProcessor::Result&)
             {
-                decrackleProcessor.process (audioBuffer);
-            }
-
-            mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
-            hasUnsavedChanges = true;
-            updateTitle();
+                juce::String message = "Decrackle applied (factor " + juce::String (factor, 2) +
+                                       ", width " + juce::String (width) + ").";
+                mainComponent->getCorrectionListView().setStatusText (message);
 
-            juce::String message = "Decrackle applied (factor " + juce::String (factor, 2) +
-                                   ", width " + juce::String (width) + ").";
-            mainComponent->getCorrectionListView().setStatusText (message);
+                juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
+                                                        "Decrackle Complete",
+                                                        message);
+            });
 
-            juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
-                                                    "Decrackle Complete",
-                                                    message);
             delete dialog;
         }
     ), true);
 }
 
+void StandaloneWindow::applyAIDenoise()
+{
+    if (audioBuffer.getNumSamples() == 0)
+    {
+        juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::WarningIcon,
+                                                "No Audio",
+                                                "Please load an audio file first.");
+        return;
+    }
+
+    auto range = getProcessingRange();
+    if (range.end <= range.start)
+        return;
+
+    undoManager.saveRegion (audioBuffer, sampleRate, "AI Denoise", range.start, range.end - range.start);
+    mainComponent->getCorrectionListView().setStatusText ("AI denoising " + range.rangeInfo + "...");
+
+    auto* task = new AIDenoiseTask (offlineDenoiser, audioBuffer, sampleRate, range.start, range.end);
+
+    task->onComplete = [this, range] (const AIDenoiseResult& result)
+    {
+        // A cancelled or failed run may have left the region partly processed
+        if (!result.succeeded)
+        {
+            if (undoManager.canUndo())
+                undoManager.undo (audioBuffer, sampleRate);
+
+            mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
+            mainComponent->getUndoHistoryView().refresh();
+            mainComponent->getCorrectionListView().setStatusText ("Ready");
+
+            if (!result.cancelled)
+                juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::WarningIcon,
+                                                        "AI Denoise",
+                                                        "No AI denoise model could be loaded. Check the model path and provider in Settings.");
+            return;
+        }
+
+        mainComponent->getWaveformDisplay().updateRegion (audioBuffer, sampleRate, range.start, range.end - range.start);
+        hasUnsavedChanges = true;
+        updateTitle();
+
+        juce::String message = "AI denoise applied to " + range.rangeInfo + " in "
+                               + juce::String (result.seconds, 1) + " s ("
+                               + OnnxDenoiser::providerToString (offlineDenoiser.getActiveProvider()) + ").";
+        mainComponent->getCorrectionListView().setStatusText (message);
+    };
+
+    task->launchThread();
+}
+
 void StandaloneWindow::applyNoiseReduction()
 {
     if (audioBuffer.getNumSamples() == 0)
@@ -1938,12 +2855,31 @@ void StandaloneWindow::applyNoiseReduction()
     dialog->addCustomComponent (settingsComponent);
 
     dialog->addButton ("Apply", 1);
+    dialog->addButton ("Preview", 2);
     dialog->addButton ("Cancel", 0);
 
     dialog->enterModalState (true, juce::ModalCallbackFunction::create (
         [this, dialog, settingsComponent, range] (int result)
         {
-            if (result == 1)
+            if (result == 2)
+            {
+                // Heard on playback until applied, so the settings can be tuned without rendering
+                const float adaptiveRates[] = {0.0f, 0.01f, 0.03f, 0.06f};
+                const int profileStart = juce::jlimit (range.start, juce::jmax (range.start, range.end - 1),
+                                                       range.start + static_cast<int> (settingsComponent->getProfileStart() * sampleRate));
+
+                noiseReductionPreview.reductionDB = juce::jlimit (0.0f, 24.0f, settingsComponent->getReductionDb());
+                noiseReductionPreview.adaptiveRate = adaptiveRates[juce::jlimit (0, 3, settingsComponent->getAdaptiveIndex())];
+                noiseReductionPreview.profileStart = profileStart;
+                noiseReductionPreview.profileLength = juce::jmin (static_cast<int> (juce::jmax (0.1f, settingsComponent->getProfileLength()) * sampleRate),
+                                                                  range.end - profileStart);
+                previewNoiseReductionEnabled = true;
+                updateLivePreview();
+
+                mainComponent->getCorrectionListView().setStatusText ("Previewing " + juce::String (noiseReductionPreview.reductionDB, 1)
+                                                                      + " dB noise reduction on playback.");
+            }
+            else if (result == 1)
             {
                 float reductionDB = settingsComponent->getReductionDb();
                 float profileStart = settingsComponent->getProfileStart();
@@ -1983,9 +2919,6 @@ void StandaloneWindow::applyNoiseReductionWithSettings (float reductionDB,
         return;
     }
 
-    // Save state for undo
-    undoManager.saveState (audioBuffer, sampleRate, "Noise Reduction");
-
     mainComponent->getCorrectionListView().setStatusText ("Applying noise reduction...");
 
     // Configure noise reduction processor
@@ -2015,27 +2948,7 @@ void StandaloneWindow::applyNoiseReductionWithSettings (float reductionDB,
     }
 
     // Capture noise profile from specified section
-    noiseReductionProcessor.captureProfile();
-
-    // Feed profile section to the processor
-    const int blockSize = 2048;
-    for (int startSample = profileStartSample;
-         startSample < profileStartSample + profileLengthSamples;
-         startSample += blockSize)
-    {
-        int samplesThisBlock = juce::jmin (blockSize, profileStartSample + profileLengthSamples - startSample);
-
-        juce::dsp::AudioBlock<float> block (audioBuffer.getArrayOfWritePointers(),
-                                            static_cast<size_t> (audioBuffer.getNumChannels()),
-                                            static_cast<size_t> (startSample),
-                                            static_cast<size_t> (samplesThisBlock));
-
-        juce::dsp::ProcessContextReplacing<float> context (block);
-        noiseReductionProcessor.process (context);
-
-        if (noiseReductionProcessor.hasProfile())
-            break;  // Profile captured
-    }
+    noiseReductionProcessor.captureProfileFromBuffer (audioBuffer, profileStartSample, profileLengthSamples);
 
     if (!noiseReductionProcessor.hasProfile())
     {
@@ -2049,22 +2962,22 @@ void StandaloneWindow::applyNoiseReductionWithSettings (float reductionDB,
     // Now process the entire audio buffer
     mainComponent->getCorrectionListView().setStatusText ("Processing audio...");
 
-    for (int startSample = processStartSample; startSample < processEndSample; startSample += blockSize)
-    {
-        int samplesThisBlock = juce::jmin (blockSize, processEndSample - startSample);
-
-        juce::dsp::AudioBlock<float> block (audioBuffer.getArrayOfWritePointers(),
-                                            static_cast<size_t> (audioBuffer.getNumChannels()),
-                                            static_cast<size_t> (startSample),
-                                            static_cast<size_t> (samplesThisBlock));
+    // Save state for undo
+    undoManager.saveRegion (audioBuffer, sampleRate, "Noise Reduction",
+                            processStartSample, processEndSample - processStartSample);
 
-        juce::dsp::ProcessContextReplacing<float> context (block);
-        noiseReductionProcessor.process (context);
-    }
+    noiseReductionProcessor.processBufferRegion (audioBuffer, processStartSample,
+                                                 processEndSample - processStartSample);
 
     // Update waveform display
     updateTransportSourceFromBuffer();
-    mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
+    mainComponent->getWaveformDisplay().updateRegion (audioBuffer, sampleRate, processStartSample, processEndSample - processStartSample);
+
+    if (previewNoiseReductionEnabled)
+    {
+        previewNoiseReductionEnabled = false;
+        updateLivePreview();
+    }
 
     hasUnsavedChanges = true;
     updateTitle();
@@ -2088,40 +3001,183 @@ void StandaloneWindow::detectTracks()
         return;
     }
 
-    TrackDetector::DetectionSettings settings;
-    settings.silenceThresholdDb = -40.0f;
-    settings.minSilenceDurationSeconds = 2.0;
-    settings.minTrackDurationSeconds = 10.0;
+    class TrackDetectionSettingsComponent : public juce::Component
+    {
+    public:
+        TrackDetectionSettingsComponent (const TrackDetector::DetectionSettings& settings)
+        {
+            thresholdSlider.setRange (-80.0, -10.0, 0.5);
+            thresholdSlider.setValue (settings.silenceThresholdDb, juce::dontSendNotification);
+            thresholdSlider.setTextValueSuffix (" dB");
+            setupSlider (thresholdSlider, thresholdLabel, "Silence Threshold");
+
+            silenceSlider.setRange (0.2, 10.0, 0.1);
+            silenceSlider.setValue (settings.minSilenceDurationSeconds, juce::dontSendNotification);
+            silenceSlider.setTextValueSuffix (" s");
+            setupSlider (silenceSlider, silenceLabel, "Min Silence");
+
+            trackSlider.setRange (1.0, 120.0, 1.0);
+            trackSlider.setValue (settings.minTrackDurationSeconds, juce::dontSendNotification);
+            trackSlider.setTextValueSuffix (" s");
+            setupSlider (trackSlider, trackLabel, "Min Track Length");
+        }
 
-    auto range = getProcessingRange();
-    const juce::AudioBuffer<float>* bufferToAnalyze = &audioBuffer;
-    juce::AudioBuffer<float> selectionBuffer;
-    int64_t offset = 0;
+        void resized() override
+        {
+            auto area = getLocalBounds().reduced (10, 10);
+
+            for (auto [label, slider] : { std::make_pair (&thresholdLabel, &thresholdSlider),
+                                          std::make_pair (&silenceLabel, &silenceSlider),
+                                          std::make_pair (&trackLabel, &trackSlider) })
+            {
+                auto row = area.removeFromTop (28);
+                label->setBounds (row.removeFromLeft (140));
+                slider->setBounds (row);
+                area.removeFromTop (8);
+            }
+        }
+
+        void applyTo (TrackDetector::DetectionSettings& settings) const
+        {
+            settings.silenceThresholdDb = (float) thresholdSlider.getValue();
+            settings.minSilenceDurationSeconds = silenceSlider.getValue();
+            settings.minTrackDurationSeconds = trackSlider.getValue();
+        }
+
+        /** Called while any slider is dragged */
+        std::function<void()> onChange;
+
+    private:
+        void setupSlider (juce::Slider& slider, juce::Label& label, const juce::String& text)
+        {
+            slider.setSliderStyle (juce::Slider::LinearHorizontal);
+            slider.setTextBoxStyle (juce::Slider::TextBoxRight, false, 60, 20);
+            slider.setColour (juce::Slider::trackColourId, juce::Colour (0xff4a90e2));
+            slider.setColour (juce::Slider::backgroundColourId, juce::Colour (0xff1a1a1a));
+            slider.setColour (juce::Slider::thumbColourId, juce::Colour (0xff8bd0ff));
+            slider.onValueChange = [this] { if (onChange != nullptr) onChange(); };
+            addAndMakeVisible (slider);
+
+            label.setText (text, juce::dontSendNotification);
+            label.setJustificationType (juce::Justification::centredLeft);
+            addAndMakeVisible (label);
+        }
+
+        juce::Slider thresholdSlider;
+        juce::Slider silenceSlider;
+        juce::Slider trackSlider;
+        juce::Label thresholdLabel;
+        juce::Label silenceLabel;
+        juce::Label trackLabel;
+    };
+
+    auto* dialog = new juce::AlertWindow ("Detect Tracks",
+                                          "Track boundaries follow the settings as you change them:",
+                                          juce::AlertWindow::QuestionIcon);
+
+    auto* settingsComponent = new TrackDetectionSettingsComponent (trackDetectionSettings);
+    settingsComponent->setSize (440, 120);
+    dialog->addCustomComponent (settingsComponent);
+
+    // The levels are computed once; each change is only a rescan of them
+    const auto range = getProcessingRange();
+    const auto previousSettings = trackDetectionSettings;
 
-    if (range.hasSelection)
+    settingsComponent->onChange = [this, settingsComponent, range]
     {
-        const int selectionSamples = range.end - range.start;
-        selectionBuffer.setSize (audioBuffer.getNumChannels(), selectionSamples);
-        for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
-            selectionBuffer.copyFrom (ch, 0, audioBuffer, ch, range.start, selectionSamples);
-        bufferToAnalyze = &selectionBuffer;
-        offset = range.start;
-    }
+        settingsComponent->applyTo (trackDetectionSettings);
+        updateDetectedTracks (range);
+    };
+
+    updateDetectedTracks (range);
+
+    dialog->addButton ("OK", 1);
+    dialog->addButton ("Cancel", 0);
+
+    dialog->enterModalState (true, juce::ModalCallbackFunction::create (
+        [this, dialog, range, previousSettings] (int result)
+        {
+            if (result != 1)
+            {
+                trackDetectionSettings = previousSettings;
+                updateDetectedTracks (range);
+            }
+
+            const auto numBoundaries = trackDetector.getBoundaries().size();
+            mainComponent->getCorrectionListView().setStatusText ("Detected " + juce::String ((int) numBoundaries) + " track boundaries in "
+                                                                  + (range.hasSelection ? range.rangeInfo : juce::String ("whole file")) + ".");
+            delete dialog;
+        }
+    ), true);
+}
+
+void StandaloneWindow::updateDetectedTracks (const ProcessingRange& range)
+{
+    if (!trackLevels.matches (audioBuffer, trackDetectionSettings.rmsWindowSamples))
+        trackLevels.build (audioBuffer, trackDetectionSettings.rmsWindowSamples);
+
+    const auto boundaries = trackDetector.detectTracks (trackLevels, sampleRate, trackDetectionSettings, range.start, range.end);
+
+    if (mainComponent == nullptr)
+        return;
+
+    auto& trackList = mainComponent->getTrackListView();
+    trackList.clearMarkers();
+    trackList.addMarker (range.start, "Track 1");
 
-    auto boundaries = trackDetector.detectTracks (*bufferToAnalyze, sampleRate, settings);
+    for (size_t i = 0; i < boundaries.size(); ++i)
+        trackList.addMarker (boundaries[i].position, "Track " + juce::String ((int) i + 2));
+}
+
+void StandaloneWindow::runRegionOperation (std::shared_ptr<RegionOperation> operation,
+                                           const ProcessingRange& range,
+                                           const juce::String& progressTitle,
+                                           std::function<void (const RegionProcessor::Result&)> onApplied)
+{
+    const auto name = operation->getName();
+    auto* task = new RegionOperationTask (progressTitle, std::move (operation), audioBuffer, audioBufferLock,
+                                          sampleRate, range.start, range.end);
 
-    if (offset > 0 && !boundaries.empty())
+    task->onComplete = [this, range, name, onApplied] (RegionProcessor::Result& result)
     {
-        for (auto& boundary : boundaries)
-            boundary.position += offset;
-        trackDetector.setBoundaries (boundaries);
-    }
+        const int oldLength = range.end - range.start;
+        const bool changed = !result.undoEdit.isEmpty();
 
-    juce::String message = "Detected " + juce::String (boundaries.size()) + " track boundaries in " +
-                           (range.hasSelection ? range.rangeInfo : "whole file") + ".";
-    juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
-                                            "Track Detection",
-                                            message);
+        // Undo restores only what changed, including the part of a cancelled run already written
+        if (changed)
+        {
+            undoManager.addEdit (std::move (result.undoEdit));
+            mainComponent->getUndoHistoryView().refresh();
+        }
+
+        if (result.resultLength != oldLength && !result.cancelled)
+        {
+            mainComponent->getWaveformDisplay().updateRegion (audioBuffer, sampleRate, range.start, 0);
+            mainComponent->setAudioBuffer (&audioBuffer, sampleRate, false);
+            mainComponent->getWaveformDisplay().setSelection (range.start, range.start + result.resultLength);
+        }
+        else if (changed)
+        {
+            mainComponent->getWaveformDisplay().updateRegion (audioBuffer, sampleRate, range.start, oldLength);
+        }
+
+        if (changed)
+        {
+            hasUnsavedChanges = true;
+            updateTitle();
+        }
+
+        if (result.cancelled)
+        {
+            mainComponent->getCorrectionListView().setStatusText (name + " cancelled" + (changed ? " (undo reverts the part already done)." : "."));
+            return;
+        }
+
+        if (onApplied)
+            onApplied (result);
+    };
+
+    task->launchThread();
 }
 
 void StandaloneWindow::splitTracks()
@@ -2141,7 +3197,11 @@ void StandaloneWindow::splitTracks()
     dialog->addTextEditor ("baseName",
                            currentFile.exists() ? currentFile.getFileNameWithoutExtension() : "VinylRip",
                            "Base filename:");
+   #if USE_LAME
+    dialog->addComboBox ("format", {"wav", "flac", "mp3"}, "Format:");
+   #else
     dialog->addComboBox ("format", {"wav", "flac"}, "Format:");
+   #endif
     dialog->getComboBoxComponent ("format")->setSelectedItemIndex (0);
     dialog->addTextEditor ("discogsUrl", "", "Discogs URL (optional):");
     dialog->addTextEditor ("discogsToken", "", "Discogs token (optional):");
@@ -2163,7 +3223,7 @@ void StandaloneWindow::splitTracks()
                 baseName = "VinylRip";
 
             auto formatIdx = dialog->getComboBoxComponent ("format")->getSelectedItemIndex();
-            juce::String extension = (formatIdx == 1) ? "flac" : "wav";
+            juce::String extension = (formatIdx == 2) ? "mp3" : (formatIdx == 1) ? "flac" : "wav";
 
             juce::String discogsUrl = dialog->getTextEditorContents ("discogsUrl").trim();
             juce::String discogsToken = dialog->getTextEditorContents ("discogsToken").trim();
@@ -2182,13 +3242,7 @@ void StandaloneWindow::splitTracks()
                         return;
 
                     auto outputDir = results[0];
-                    TrackDetector::DetectionSettings settings;
-                    settings.silenceThresholdDb = -40.0f;
-                    settings.minSilenceDurationSeconds = 2.0;
-                    settings.minTrackDurationSeconds = 10.0;
-
                     auto range = getProcessingRange();
-                    const juce::AudioBuffer<float>* bufferToExport = &audioBuffer;
                     juce::AudioBuffer<float> selectionBuffer;
 
                     if (range.hasSelection)
@@ -2197,11 +3251,18 @@ void StandaloneWindow::splitTracks()
                         selectionBuffer.setSize (audioBuffer.getNumChannels(), selectionSamples);
                         for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
                             selectionBuffer.copyFrom (ch, 0, audioBuffer, ch, range.start, selectionSamples);
-                        bufferToExport = &selectionBuffer;
                     }
 
                     if (trackDetector.getBoundaries().empty() || range.hasSelection)
-                        trackDetector.detectTracks (*bufferToExport, sampleRate, settings);
+                    {
+                        updateDetectedTracks (range);
+
+                        // The levels cover the whole file; the export is of the selection alone
+                        auto boundaries = trackDetector.getBoundaries();
+                        for (auto& boundary : boundaries)
+                            boundary.position -= range.start;
+                        trackDetector.setBoundaries (boundaries);
+                    }
 
                     auto boundaryCount = (int) trackDetector.getBoundaries().size();
                     auto expectedTracks = boundaryCount + 1;
@@ -2242,13 +3303,28 @@ void StandaloneWindow::splitTracks()
                     }
 
                     mainComponent->getCorrectionListView().setStatusText ("Exporting tracks...");
-                    bool ok = trackDetector.exportTracks (*bufferToExport, sampleRate, outputDir, baseName, extension);
-                    mainComponent->getCorrectionListView().setStatusText (ok ? "Track export complete" : "Track export failed");
 
-                    juce::AlertWindow::showMessageBoxAsync (
-                        ok ? juce::AlertWindow::InfoIcon : juce::AlertWindow::WarningIcon,
-                        ok ? "Tracks Exported" : "Export Failed",
-                        ok ? "Tracks exported successfully." : "Failed to export tracks.");
+                    auto* task = new TrackExportTask (trackDetector, audioBuffer, std::move (selectionBuffer),
+                                                      sampleRate, outputDir, baseName, extension);
+
+                    task->onComplete = [this] (const TrackExportResult& result)
+                    {
+                        if (result.cancelled)
+                        {
+                            mainComponent->getCorrectionListView().setStatusText ("Track export cancelled");
+                            return;
+                        }
+
+                        const bool ok = result.succeeded;
+                        mainComponent->getCorrectionListView().setStatusText (ok ? "Track export complete" : "Track export failed");
+
+                        juce::AlertWindow::showMessageBoxAsync (
+                            ok ? juce::AlertWindow::InfoIcon : juce::AlertWindow::WarningIcon,
+                            ok ? "Tracks Exported" : "Export Failed",
+                            ok ? "Tracks exported successfully." : "Failed to export tracks.");
+                    };
+
+                    task->launchThread();
                 });
             delete dialog;
         }
@@ -2366,9 +3442,15 @@ void StandaloneWindow::showBatchProcessor()
     dialog->addComboBox ("clickRemoval", {"Disabled", "Low (25)", "Medium (50)", "High (75)", "Maximum (100)"}, "Click Removal:");
     dialog->getComboBoxComponent ("clickRemoval")->setSelectedItemIndex (2); // Default: Medium
 
+    dialog->addComboBox ("decrackle", {"Disabled", "Light (0.75)", "Medium (0.5)", "Strong (0.25)"}, "Decrackle:");
+    dialog->getComboBoxComponent ("decrackle")->setSelectedItemIndex (0); // Default: Disabled
+
     dialog->addComboBox ("noiseReduction", {"Disabled", "6 dB", "12 dB", "18 dB", "24 dB"}, "Noise Reduction:");
     dialog->getComboBoxComponent ("noiseReduction")->setSelectedItemIndex (0); // Default: Disabled
 
+    dialog->addComboBox ("aiDenoise", {"Disabled", "Enabled"}, "AI Denoise:");
+    dialog->getComboBoxComponent ("aiDenoise")->setSelectedItemIndex (0); // Default: Disabled
+
     dialog->addComboBox ("rumbleFilter", {"Disabled", "20 Hz", "40 Hz", "60 Hz", "80 Hz"}, "Rumble Filter:");
     dialog->getComboBoxComponent ("rumbleFilter")->setSelectedItemIndex (0); // Default: Disabled
 
@@ -2381,6 +3463,12 @@ void StandaloneWindow::showBatchProcessor()
     dialog->addComboBox ("bitDepth", {"16-bit", "24-bit", "32-bit float"}, "Output Bit Depth:");
     dialog->getComboBoxComponent ("bitDepth")->setSelectedItemIndex (1); // Default: 24-bit
 
+    dialog->addComboBox ("parallelFiles", {"Auto (one per core)", "1", "2", "4", "8"}, "Files at Once:");
+    dialog->getComboBoxComponent ("parallelFiles")->setSelectedItemIndex (0); // Default: Auto
+
+    dialog->addComboBox ("renderCache", {"Disabled", "Enabled"}, "Reuse Unchanged Renders:");
+    dialog->getComboBoxComponent ("renderCache")->setSelectedItemIndex (1); // Default: Enabled
+
     dialog->addButton ("Select Files...", 1);
     dialog->addButton ("Cancel", 0);
 
@@ -2396,10 +3484,22 @@ void StandaloneWindow::showBatchProcessor()
                 settings.clickRemoval = clickIdx > 0;
                 settings.clickSensitivity = clickIdx > 0 ? (clickIdx * 25.0f) : 0.0f;
 
+                int decrackleIdx = dialog->getComboBoxComponent ("decrackle")->getSelectedItemIndex();
+                settings.decrackle = decrackleIdx > 0;
+                float decrackleFactors[] = {0.5f, 0.75f, 0.5f, 0.25f};
+                settings.decrackleFactor = decrackleFactors[decrackleIdx];
+
                 int noiseIdx = dialog->getComboBoxComponent ("noiseReduction")->getSelectedItemIndex();
                 settings.noiseReduction = noiseIdx > 0;
                 settings.noiseReductionDB = noiseIdx > 0 ? (noiseIdx * 6.0f) : 0.0f;
 
+                // Same model and provider as the realtime AI denoise
+                const auto denoiseSettings = SettingsManager::getInstance().getDenoiseSettings();
+                settings.aiDenoise = dialog->getComboBoxComponent ("aiDenoise")->getSelectedItemIndex() > 0;
+                settings.aiProvider = denoiseSettings.provider;
+                settings.aiAllowFallback = denoiseSettings.allowFallback;
+                settings.aiModelPath = denoiseSettings.modelPath;
+
                 int rumbleIdx = dialog->getComboBoxComponent ("rumbleFilter")->getSelectedItemIndex();
                 settings.rumbleFilter = rumbleIdx > 0;
                 settings.rumbleFreq = rumbleIdx > 0 ? (rumbleIdx * 20.0f) : 20.0f;
@@ -2417,6 +3517,15 @@ void StandaloneWindow::showBatchProcessor()
                 int bitDepths[] = {16, 24, 32};
                 settings.outputBitDepth = bitDepths[bitIdx];
 
+                int parallelIdx = dialog->getComboBoxComponent ("parallelFiles")->getSelectedItemIndex();
+                int workerCounts[] = {0, 1, 2, 4, 8};
+                settings.numWorkers = workerCounts[parallelIdx];
+
+                if (dialog->getComboBoxComponent ("renderCache")->getSelectedItemIndex() > 0)
+                    settings.cacheDirectory = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                                                  .getChildFile ("VinylRestorationSuite")
+                                                  .getChildFile ("RenderCache");
+
                 // Show file chooser
                 auto chooser = std::make_shared<juce::FileChooser> ("Select Audio Files to Process",
                                juce::File::getSpecialLocation (juce::File::userHomeDirectory),
@@ -2481,8 +3590,9 @@ void StandaloneWindow::startBatchProcessing (const juce::Array<juce::File>& file
     activeBatchProcessor->setProgressCallback ([this] (const BatchProcessor::ProgressInfo& info)
     {
         mainComponent->getCorrectionListView().setStatusText (
-            "Batch: " + juce::String (info.currentFileIndex) + "/" +
-            juce::String (info.totalFiles) + " - " + info.currentFileName);
+            "Batch: " + juce::String (info.filesCompleted) + "/" +
+            juce::String (info.totalFiles) + " done (" +
+            juce::String (juce::roundToInt (info.progress * 100.0f)) + "%) - " + info.status);
     });
 
     // Set completion callback
@@ -2966,10 +4076,9 @@ void StandaloneWindow::loadSession (const juce::File& sessionFile)
     if (!promptToSaveIfNeeded ("opening a session"))
         return;
 
-    juce::File audioFile;
-    juce::var sessionData;
+    const auto session = AudioFileManager::openSession (sessionFile);
 
-    if (!fileManager.loadSession (sessionFile, audioFile, sessionData))
+    if (session == nullptr || !session->getAudioFile().existsAsFile())
     {
         juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::WarningIcon,
                                                 "Load Session Failed",
@@ -2977,6 +4086,14 @@ void StandaloneWindow::loadSession (const juce::File& sessionFile)
         return;
     }
 
+    const auto audioFile = session->getAudioFile();
+
+    // A bundled overview spares the scan when the sidecar did not travel with the audio
+    const auto peakSidecar = PeakPyramid::getSidecarFile (audioFile);
+
+    if (!peakSidecar.existsAsFile())
+        session->restorePeakCache (peakSidecar);
+
     // Load the referenced audio file
     if (!fileManager.loadAudioFile (audioFile, audioBuffer, sampleRate))
     {
@@ -2987,9 +4104,9 @@ void StandaloneWindow::loadSession (const juce::File& sessionFile)
     }
 
     currentFile = audioFile;
-    currentSessionFile = sessionFile;  // Track the session file
+    // A JSON session is saved again as binary, so Save asks where rather than overwriting it
+    currentSessionFile = SessionFile::isBinarySession (sessionFile) ? sessionFile : juce::File();
     recentFiles.addFile (sessionFile);
-    bufferedRecording.reset();
 
     // Save recent files immediately
     auto settingsDir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
@@ -3001,25 +4118,40 @@ void StandaloneWindow::loadSession (const juce::File& sessionFile)
     mainComponent->getWaveformDisplay().loadFile (audioFile);
     mainComponent->setAudioBuffer (&audioBuffer, sampleRate);
 
-    // Load into transport source for playback
-    juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
-    formatManager.registerFormat (new juce::FlacAudioFormat(), true);
-    formatManager.registerFormat (new juce::OggVorbisAudioFormat(), true);
-
-    #if JUCE_USE_MP3AUDIOFORMAT
-    formatManager.registerFormat (new juce::MP3AudioFormat(), true);
-    #endif
-
-    auto* reader = formatManager.createReaderFor (audioFile);
+    // Load into transport source for playback (mapped for PCM WAV/AIFF, so it shares
+    // the pages the load just touched)
+    auto* reader = fileManager.createReaderFor (audioFile).release();
     if (reader != nullptr)
     {
         readerSource.reset (new juce::AudioFormatReaderSource (reader, true));
         transportSource.setSource (readerSource.get(), 0, nullptr, reader->sampleRate);
     }
 
-    // TODO: Restore corrections from sessionData
-    mainComponent->getCorrectionListView().clearCorrections();
+    // Corrections and track markers; the list takes the store and the waveform shares it
+    auto& listView = mainComponent->getCorrectionListView();
+    ClickStore corrections;
+
+    if (session->readCorrections (corrections) && !corrections.empty())
+    {
+        listView.setCorrections (std::move (corrections));
+        mainComponent->getWaveformDisplay().setDetectedClicks (listView.getCorrectionStore());
+    }
+    else
+    {
+        listView.clearCorrections();
+        mainComponent->getWaveformDisplay().clearClickMarkers();
+    }
+
+    auto& trackList = mainComponent->getTrackListView();
+    trackList.clearMarkers();
+
+    for (const auto& track : session->readTracks())
+        trackList.addMarker (track.position, track.name);
+
+    trackDetector.setBoundaries ({});
+
+    // Detection levels of the unedited file, if the session kept them; otherwise built when next needed
+    session->readLevelCache (trackLevels, audioBuffer.getNumChannels(), audioBuffer.getNumSamples());
 
     hasUnsavedChanges = false;
     updateTitle();
@@ -3028,7 +4160,8 @@ void StandaloneWindow::loadSession (const juce::File& sessionFile)
     DBG ("Audio file: " + audioFile.getFullPathName());
 
     auto durationSec = audioBuffer.getNumSamples() / sampleRate;
-    juce::String status = "Session loaded: " + juce::String (durationSec / 60.0, 1) + " min";
+    juce::String status = "Session loaded: " + juce::String (durationSec / 60.0, 1) + " min, "
+                          + juce::String (listView.getNumCorrections()) + " corrections";
     mainComponent->getCorrectionListView().setStatusText (status);
 }
 
@@ -3084,15 +4217,12 @@ void StandaloneWindow::cutAndSplice()
         {
             if (result == 1)
             {
-                // Save state for undo
-                undoManager.saveState (audioBuffer, sampleRate, "Cut and Splice");
-
                 int fadeIdx = dialog->getComboBoxComponent ("fadeType")->getSelectedItemIndex();
                 int fadeSamples[] = {0, (int)(0.005 * sampleRate), (int)(0.010 * sampleRate),
                                      (int)(0.025 * sampleRate), (int)(0.050 * sampleRate)};
                 int fadeLength = fadeSamples[fadeIdx];
 
-                // Create new buffer without the selected region
+                // Cut the selected region out in place
                 int64_t cutLength = selEnd - selStart;
                 int newLength = audioBuffer.getNumSamples() - static_cast<int>(cutLength);
 
@@ -3105,27 +4235,17 @@ void StandaloneWindow::cutAndSplice()
                     return;
                 }
 
-                juce::AudioBuffer<float> newBuffer (audioBuffer.getNumChannels(), newLength);
-
-                // Copy audio before selection
                 int beforeEnd = static_cast<int>(juce::jmin (selStart, (int64_t)audioBuffer.getNumSamples()));
-                for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
-                {
-                    newBuffer.copyFrom (ch, 0, audioBuffer, ch, 0, beforeEnd);
-                }
-
-                // Copy audio after selection
                 int afterStart = static_cast<int>(juce::jmin (selEnd, (int64_t)audioBuffer.getNumSamples()));
                 int afterLength = audioBuffer.getNumSamples() - afterStart;
-                if (afterLength > 0)
-                {
-                    for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
-                    {
-                        newBuffer.copyFrom (ch, beforeEnd, audioBuffer, ch, afterStart, afterLength);
-                    }
-                }
 
-                // Apply crossfade at splice point
+                // Save state for undo: the faded samples before the splice point, then the cut itself
+                AudioUndoManager::Edit undoEdit ("Cut and Splice", sampleRate);
+                undoEdit.saveRegion (audioBuffer, juce::jmax (0, beforeEnd - fadeLength), juce::jmin (fadeLength, beforeEnd));
+                undoEdit.saveSplice (audioBuffer, beforeEnd, afterStart - beforeEnd, 0);
+                undoManager.addEdit (std::move (undoEdit));
+
+                // Apply crossfade at splice point (it fades the audio before the splice, which the cut leaves in place)
                 if (fadeLength > 0 && beforeEnd > fadeLength && afterLength > fadeLength)
                 {
                     int splicePoint = beforeEnd;
@@ -3133,29 +4253,30 @@ void StandaloneWindow::cutAndSplice()
                     int fadeEnd = splicePoint + fadeLength;
 
                     // Ensure we don't exceed buffer bounds
-                    fadeEnd = juce::jmin (fadeEnd, newBuffer.getNumSamples());
+                    fadeEnd = juce::jmin (fadeEnd, newLength);
 
-                    for (int ch = 0; ch < newBuffer.getNumChannels(); ++ch)
+                    for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
                     {
-                        auto* channelData = newBuffer.getWritePointer (ch);
-                        for (int i = fadeStart; i < fadeEnd; ++i)
+                        auto* channelData = audioBuffer.getWritePointer (ch);
+                        for (int i = fadeStart; i < splicePoint; ++i)
                         {
                             float phase = (float)(i - fadeStart) / (float)(fadeEnd - fadeStart);
                             float fade = 0.5f - 0.5f * std::cos (phase * juce::MathConstants<float>::pi);
                             // Smooth the splice point
-                            if (i < splicePoint)
-                                channelData[i] *= fade;
+                            channelData[i] *= fade;
                         }
                     }
                 }
 
-                // Replace audio buffer
-                audioBuffer = newBuffer;
+                {
+                    const juce::ScopedLock sl (audioBufferLock);
+                    BufferSplice::erase (audioBuffer, beforeEnd, afterStart - beforeEnd);
+                }
 
                 // Update displays
-                mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
+                mainComponent->getWaveformDisplay().updateRegion (audioBuffer, sampleRate, juce::jmax (0, beforeEnd - fadeLength), 0);
                 mainComponent->getWaveformDisplay().clearSelection();
-                mainComponent->setAudioBuffer (&audioBuffer, sampleRate);
+                mainComponent->setAudioBuffer (&audioBuffer, sampleRate, false);
 
                 hasUnsavedChanges = true;
                 updateTitle();
@@ -3462,10 +4583,10 @@ void StandaloneWindow::showGraphicEQ()
                 {
                     // Action already updated filterBankProcessor via onGainsChanged
                     // Now we perform the actual processing on the buffer
-                    undoManager.saveState (audioBuffer, sampleRate, "Graphic EQ");
                     auto range = getProcessingRange();
                     if (range.end > range.start)
                     {
+                        undoManager.saveRegion (audioBuffer, sampleRate, "Graphic EQ", range.start, range.end - range.start);
                         mainComponent->getCorrectionListView().setStatusText ("Applying EQ...");
                         
                         // ESSENTIAL: Prepare the processor before offline processing
@@ -3485,7 +4606,7 @@ void StandaloneWindow::showGraphicEQ()
                         }
                         
                         updateTransportSourceFromBuffer(); // Update playback source
-                        mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
+                        mainComponent->getWaveformDisplay().updateRegion (audioBuffer, sampleRate, range.start, range.end - range.start);
                         hasUnsavedChanges = true;
                         updateTitle();
                         mainComponent->getCorrectionListView().setStatusText ("EQ applied successfully");
@@ -3552,68 +4673,25 @@ void StandaloneWindow::normalise()
         {
             if (result == 1)
             {
-                // Save state for undo
-                undoManager.saveState (audioBuffer, sampleRate, "Normalise");
-
                 float targetDb = juce::jlimit (-20.0f, 0.0f,
                                                dialog->getTextEditorContents ("targetLevel").getFloatValue());
                 int mode = dialog->getComboBoxComponent ("mode")->getSelectedItemIndex();
 
                 mainComponent->getCorrectionListView().setStatusText ("Normalising...");
 
-                float targetGain = juce::Decibels::decibelsToGain (targetDb);
-                float gainFactor;
-
-                if (mode == 0) // Peak normalise
-                {
-                    if (currentPeak > 0.0001f)
-                        gainFactor = targetGain / currentPeak;
-                    else
-                        gainFactor = 1.0f;
-                }
-                else // RMS normalise
-                {
-                    // Calculate RMS
-                    float sumSquares = 0.0f;
-                    int selectionSamples = range.end - range.start;
-                    for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
-                    {
-                        const float* data = audioBuffer.getReadPointer (ch) + range.start;
-                        for (int i = 0; i < selectionSamples; ++i)
-                            sumSquares += data[i] * data[i];
-                    }
-                    float rms = std::sqrt (sumSquares / (selectionSamples * audioBuffer.getNumChannels()));
-
-                    if (rms > 0.0001f)
-                        gainFactor = targetGain / rms;
-                    else
-                        gainFactor = 1.0f;
-
-                    // Limit gain to avoid clipping
-                    float maxGain = 1.0f / currentPeak;
-                    gainFactor = juce::jmin (gainFactor, maxGain * 0.99f);
-                }
+                // RMS mode measures the selection on the worker, before the gain is applied
+                auto operation = std::make_shared<NormaliseOperation> (mode == 1, juce::Decibels::decibelsToGain (targetDb), currentPeak);
 
-                // Apply gain
-                for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
+                runRegionOperation (operation, range, "Normalising...", [this, operation] (const RegionProcessor::Result&)
                 {
-                    juce::FloatVectorOperations::multiply (
-                        audioBuffer.getWritePointer (ch) + range.start, gainFactor, range.end - range.start);
-                }
-
-                // Update display
-                mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
-
-                hasUnsavedChanges = true;
-                updateTitle();
-
-                float appliedDb = juce::Decibels::gainToDecibels (gainFactor);
-                juce::String message = "Applied " + juce::String (appliedDb, 1) + " dB gain.";
-                mainComponent->getCorrectionListView().setStatusText (message);
+                    float appliedDb = juce::Decibels::gainToDecibels (operation->getGain());
+                    juce::String message = "Applied " + juce::String (appliedDb, 1) + " dB gain.";
+                    mainComponent->getCorrectionListView().setStatusText (message);
 
-                juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
-                                                        "Normalise Complete",
-                                                        message);
+                    juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
+                                                            "Normalise Complete",
+                                                            message);
+                });
             }
             delete dialog;
         }
@@ -3687,9 +4765,6 @@ void StandaloneWindow::channelBalance()
         {
             if (result == 1 || result == 2)
             {
-                // Save state for undo
-                undoManager.saveState (audioBuffer, sampleRate, "Channel Balance");
-
                 float leftGain, rightGain;
 
                 if (result == 2) // Auto-balance
@@ -3709,26 +4784,18 @@ void StandaloneWindow::channelBalance()
 
                 mainComponent->getCorrectionListView().setStatusText ("Adjusting balance...");
 
-                // Apply gains
-                juce::FloatVectorOperations::multiply (
-                    audioBuffer.getWritePointer (0) + range.start, leftGain, range.end - range.start);
-                juce::FloatVectorOperations::multiply (
-                    audioBuffer.getWritePointer (1) + range.start, rightGain, range.end - range.start);
-
-                // Update display
-                mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
-
-                hasUnsavedChanges = true;
-                updateTitle();
-
-                juce::String message = "Balance adjusted: L " +
-                    juce::String (juce::Decibels::gainToDecibels (leftGain), 1) + " dB, R " +
-                    juce::String (juce::Decibels::gainToDecibels (rightGain), 1) + " dB";
-                mainComponent->getCorrectionListView().setStatusText (message);
+                runRegionOperation (std::make_shared<GainOperation> ("Channel Balance", std::vector<float> { leftGain, rightGain }),
+                                    range, "Adjusting balance...", [this, leftGain, rightGain] (const RegionProcessor::Result&)
+                {
+                    juce::String message = "Balance adjusted: L " +
+                        juce::String (juce::Decibels::gainToDecibels (leftGain), 1) + " dB, R " +
+                        juce::String (juce::Decibels::gainToDecibels (rightGain), 1) + " dB";
+                    mainComponent->getCorrectionListView().setStatusText (message);
 
-                juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
-                                                        "Channel Balance Complete",
-                                                        message);
+                    juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
+                                                            "Channel Balance Complete",
+                                                            message);
+                });
             }
             delete dialog;
         }
@@ -3826,9 +4893,6 @@ void StandaloneWindow::wowFlutterRemoval()
                     return;
                 }
 
-                // Save state for undo
-                undoManager.saveState (audioBuffer, sampleRate, "Eccentric Record Correction");
-
                 mainComponent->getCorrectionListView().setStatusText (
                     "Correcting wow in " + range.rangeInfo + " at " + juce::String (wowFrequency, 3) + " Hz, " +
                     juce::String (pitchDeviation, 2) + "% deviation...");
@@ -3838,18 +4902,6 @@ void StandaloneWindow::wowFlutterRemoval()
                      ", eccentricity=" + juce::String (eccentricity) + " mm" +
                      ", pitch deviation=" + juce::String (pitchDeviation, 3) + "%");
 
-                //==============================================================
-                // ECCENTRIC RECORD CORRECTION ALGORITHM
-                // Uses variable-rate resampling to correct sinusoidal pitch error
-                //==============================================================
-
-                const int numSamples = range.end - range.start;
-                const int numChannels = audioBuffer.getNumChannels();
-
-                // Create output buffer (same size - we're correcting, not changing duration)
-                juce::AudioBuffer<float> outputBuffer (numChannels, numSamples);
-                outputBuffer.clear();
-
                 // Calculate samples per revolution
                 double samplesPerRevolution = sampleRate / wowFrequency;
 
@@ -3859,81 +4911,21 @@ void StandaloneWindow::wowFlutterRemoval()
                 // Pitch deviation as ratio (e.g., 0.5% = 0.005)
                 double deviationRatio = pitchDeviation / 100.0;
 
-                // Process using sinusoidal resampling
-                // The idea: at each output sample, calculate where in the input
-                // we should read from, accounting for the sinusoidal speed variation
-
-                for (int ch = 0; ch < numChannels; ++ch)
+                runRegionOperation (std::make_shared<EccentricityCorrectionOperation> (samplesPerRevolution, phaseRad, deviationRatio),
+                                    range, "Correcting wow...", [this, rpm, wowFrequency, eccentricity, pitchDeviation] (const RegionProcessor::Result&)
                 {
-                    const float* input = audioBuffer.getReadPointer (ch) + range.start;
-                    float* output = outputBuffer.getWritePointer (ch);
-
-                    // Track cumulative phase for input position
-                    double inputPos = 0.0;
-
-                    for (int outSample = 0; outSample < numSamples; ++outSample)
-                    {
-                        // Calculate current phase in the wow cycle
-                        double wowPhase = (2.0 * juce::MathConstants<double>::pi * outSample / samplesPerRevolution) + phaseRad;
-
-                        // The original recording has speed variation: speed = 1 + deviation * sin(phase)
-                        // To correct, we need to read at variable rate: 1 / (1 + deviation * sin(phase))
-                        // Approximation for small deviations: 1 - deviation * sin(phase)
-                        double speedCorrection = 1.0 - deviationRatio * std::sin (wowPhase);
-
-                        // Advance input position by corrected amount
-                        inputPos += speedCorrection;
-
-                        // Cubic interpolation for high-quality resampling
-                        int idx = static_cast<int> (inputPos);
-                        double frac = inputPos - idx;
-
-                        if (idx >= 1 && idx < numSamples - 2)
-                        {
-                            // Cubic Hermite interpolation
-                            float y0 = input[idx - 1];
-                            float y1 = input[idx];
-                            float y2 = input[idx + 1];
-                            float y3 = input[idx + 2];
-
-                            float c0 = y1;
-                            float c1 = 0.5f * (y2 - y0);
-                            float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
-                            float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
-
-                            float t = static_cast<float> (frac);
-                            output[outSample] = ((c3 * t + c2) * t + c1) * t + c0;
-                        }
-                        else if (idx >= 0 && idx < numSamples)
-                        {
-                            // Linear interpolation at boundaries
-                            int idx1 = juce::jmin (idx + 1, numSamples - 1);
-                            output[outSample] = input[idx] + static_cast<float> (frac) * (input[idx1] - input[idx]);
-                        }
-                    }
-                }
-
-                // Copy result back
-                for (int ch = 0; ch < numChannels; ++ch)
-                    audioBuffer.copyFrom (ch, range.start, outputBuffer, ch, 0, numSamples);
-
-                // Update display
-                mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
-
-                hasUnsavedChanges = true;
-                updateTitle();
-
-                juce::String message = "Eccentric record correction applied.\n\n"
-                                       "RPM: " + juce::String (rpm, 1) + "\n"
-                                       "Wow frequency: " + juce::String (wowFrequency, 3) + " Hz\n"
-                                       "Eccentricity: " + juce::String (eccentricity, 1) + " mm\n"
-                                       "Pitch correction: +/- " + juce::String (pitchDeviation, 2) + "%";
+                    juce::String message = "Eccentric record correction applied.\n\n"
+                                           "RPM: " + juce::String (rpm, 1) + "\n"
+                                           "Wow frequency: " + juce::String (wowFrequency, 3) + " Hz\n"
+                                           "Eccentricity: " + juce::String (eccentricity, 1) + " mm\n"
+                                           "Pitch correction: +/- " + juce::String (pitchDeviation, 2) + "%";
 
-                mainComponent->getCorrectionListView().setStatusText ("Eccentric correction complete");
+                    mainComponent->getCorrectionListView().setStatusText ("Eccentric correction complete");
 
-                juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
-                                                        "Wow & Flutter Removal Complete",
-                                                        message);
+                    juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
+                                                            "Wow & Flutter Removal Complete",
+                                                            message);
+                });
             }
             delete dialog;
         }
@@ -3979,9 +4971,6 @@ void StandaloneWindow::dropoutRestoration()
                     return;
                 }
 
-                // Save state for undo
-                undoManager.saveState (audioBuffer, sampleRate, "Dropout Restoration");
-
                 float thresholdDb = juce::jlimit (-80.0f, -10.0f,
                                                   dialog->getTextEditorContents ("threshold").getFloatValue());
                 float minLengthMs = juce::jlimit (1.0f, 100.0f,
@@ -3993,83 +4982,19 @@ void StandaloneWindow::dropoutRestoration()
 
                 mainComponent->getCorrectionListView().setStatusText ("Detecting dropouts...");
 
-                int dropoutsFound = 0;
-                int dropoutsRepaired = 0;
+                // Only the repaired dropouts are saved for undo
+                auto operation = std::make_shared<DropoutRestorationOperation> (thresholdLinear, minLengthSamples, method);
 
-                // Detect and repair dropouts for each channel
-                for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
+                runRegionOperation (operation, range, "Repairing dropouts...", [this, operation] (const RegionProcessor::Result&)
                 {
-                    float* channelData = audioBuffer.getWritePointer (ch) + range.start;
-                    int numSamples = range.end - range.start;
-
-                    int dropoutStart = -1;
-
-                    for (int i = 0; i < numSamples; ++i)
-                    {
-                        bool isBelowThreshold = std::abs (channelData[i]) < thresholdLinear;
-
-                        if (isBelowThreshold && dropoutStart < 0)
-                        {
-                            dropoutStart = i;
-                        }
-                        else if (!isBelowThreshold && dropoutStart >= 0)
-                        {
-                            int dropoutLength = i - dropoutStart;
-
-                            if (dropoutLength >= minLengthSamples)
-                            {
-                                dropoutsFound++;
-
-                                // Repair based on method
-                                if (method == 0) // Interpolate
-                                {
-                                    float startVal = (dropoutStart > 0) ? channelData[dropoutStart - 1] : 0.0f;
-                                    float endVal = (i < numSamples) ? channelData[i] : 0.0f;
-
-                                    for (int j = dropoutStart; j < i; ++j)
-                                    {
-                                        float t = (float)(j - dropoutStart) / (float)dropoutLength;
-                                        // Cosine interpolation for smooth transition
-                                        float weight = 0.5f - 0.5f * std::cos (t * juce::MathConstants<float>::pi);
-                                        channelData[j] = startVal + (endVal - startVal) * weight;
-                                    }
-                                    dropoutsRepaired++;
-                                }
-                                else if (method == 1 && audioBuffer.getNumChannels() > 1) // Copy from other channel
-                                {
-                                    int otherCh = (ch == 0) ? 1 : 0;
-                                    const float* otherData = audioBuffer.getReadPointer (otherCh) + range.start;
-
-                                    for (int j = dropoutStart; j < i; ++j)
-                                    {
-                                        channelData[j] = otherData[j];
-                                    }
-                                    dropoutsRepaired++;
-                                }
-                                else if (method == 2) // Silence (already silent, just mark as handled)
-                                {
-                                    dropoutsRepaired++;
-                                }
-                            }
-
-                            dropoutStart = -1;
-                        }
-                    }
-                }
-
-                // Update display
-                mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
-
-                hasUnsavedChanges = true;
-                updateTitle();
-
-                juce::String message = "Found " + juce::String (dropoutsFound) + " dropouts, repaired " +
-                                       juce::String (dropoutsRepaired) + ".";
-                mainComponent->getCorrectionListView().setStatusText (message);
+                    juce::String message = "Found " + juce::String (operation->getNumFound()) + " dropouts, repaired " +
+                                           juce::String (operation->getNumRepaired()) + ".";
+                    mainComponent->getCorrectionListView().setStatusText (message);
 
-                juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
-                                                        "Dropout Restoration Complete",
-                                                        message);
+                    juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
+                                                            "Dropout Restoration Complete",
+                                                            message);
+                });
             }
             delete dialog;
         }
@@ -4147,81 +5072,23 @@ void StandaloneWindow::speedCorrection()
                     return;
                 }
 
-                // Save state for undo
-                undoManager.saveState (audioBuffer, sampleRate, "Speed Correction");
-
                 mainComponent->getCorrectionListView().setStatusText ("Applying speed correction...");
 
-                // Calculate new length
+                // The selection is replaced by one of the new length
                 float speedRatio = 100.0f / speedPercent;
-                int selectionSamples = range.end - range.start;
-                int newSelectionSamples = static_cast<int> (selectionSamples * speedRatio);
-
-                // Create new buffer for processed selection
-                juce::AudioBuffer<float> processedSelection (audioBuffer.getNumChannels(), newSelectionSamples);
-
-                for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
-                {
-                    const float* srcData = audioBuffer.getReadPointer (ch) + range.start;
-                    float* destData = processedSelection.getWritePointer (ch);
-
-                    for (int i = 0; i < newSelectionSamples; ++i)
-                    {
-                        // Calculate source position with linear interpolation
-                        float srcPos = i / speedRatio;
-                        int srcIdx = static_cast<int> (srcPos);
-                        float frac = srcPos - srcIdx;
-
-                        if (srcIdx + 1 < selectionSamples)
-                        {
-                            destData[i] = srcData[srcIdx] * (1.0f - frac) + srcData[srcIdx + 1] * frac;
-                        }
-                        else if (srcIdx < selectionSamples)
-                        {
-                            destData[i] = srcData[srcIdx];
-                        }
-                        else
-                        {
-                            destData[i] = 0.0f;
-                        }
-                    }
-                }
-
-                // Assemble new full buffer
-                int newTotalSamples = audioBuffer.getNumSamples() - selectionSamples + newSelectionSamples;
-                juce::AudioBuffer<float> newBuffer (audioBuffer.getNumChannels(), newTotalSamples);
 
-                for (int ch = 0; ch < audioBuffer.getNumChannels(); ++ch)
+                runRegionOperation (std::make_shared<SpeedChangeOperation> (speedRatio), range, "Applying speed correction...",
+                                    [this, speedPercent] (const RegionProcessor::Result&)
                 {
-                    newBuffer.copyFrom (ch, 0, audioBuffer, ch, 0, range.start);
-                    newBuffer.copyFrom (ch, range.start, processedSelection, ch, 0, newSelectionSamples);
-                    int afterStart = range.end;
-                    int afterLength = audioBuffer.getNumSamples() - afterStart;
-                    if (afterLength > 0)
-                    {
-                        newBuffer.copyFrom (ch, range.start + newSelectionSamples,
-                                            audioBuffer, ch, afterStart, afterLength);
-                    }
-                }
-
-                audioBuffer = newBuffer;
-
-                // Update display
-                mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
-                mainComponent->setAudioBuffer (&audioBuffer, sampleRate);
-                mainComponent->getWaveformDisplay().setSelection (range.start, range.start + newSelectionSamples);
-
-                hasUnsavedChanges = true;
-                updateTitle();
-
-                double newDurationSec = audioBuffer.getNumSamples() / sampleRate;
-                juce::String message = "Speed adjusted to " + juce::String (speedPercent, 1) + "%. " +
-                                       "New duration: " + juce::String (newDurationSec, 2) + " seconds.";
-                mainComponent->getCorrectionListView().setStatusText (message);
+                    double newDurationSec = audioBuffer.getNumSamples() / sampleRate;
+                    juce::String message = "Speed adjusted to " + juce::String (speedPercent, 1) + "%. " +
+                                           "New duration: " + juce::String (newDurationSec, 2) + " seconds.";
+                    mainComponent->getCorrectionListView().setStatusText (message);
 
-                juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
-                                                        "Speed Correction Complete",
-                                                        message);
+                    juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::InfoIcon,
+                                                            "Speed Correction Complete",
+                                                            message);
+                });
             }
             delete dialog;
         }
@@ -4653,16 +5520,40 @@ void StandaloneWindow::showProcessingSettings()
 
 void StandaloneWindow::applyDenoiserSettings()
 {
+    // Provider and model changes release the realtime session, which the audio callback may be
+    // using: take the player off the device meanwhile, as the plugin suspends processing.
+    // removeAudioCallback returns only once the callback is out.
+    audioDeviceManager.removeAudioCallback (&audioSourcePlayer);
+
     const auto settings = SettingsManager::getInstance().getDenoiseSettings();
-    realtimeDenoiser.setPreferredProvider (OnnxDenoiser::providerFromString (settings.provider));
-    realtimeDenoiser.setAllowFallback (settings.allowFallback);
-    realtimeDenoiser.setDmlDeviceId (settings.dmlDeviceId);
-    realtimeDenoiser.setQnnBackendPath (settings.qnnBackendPath);
+    OnnxDenoiser::setThreadingSettings ({ settings.intraOpThreads, settings.allowSpinning, settings.threadAffinity });
 
-    if (settings.modelPath.isNotEmpty())
-        realtimeDenoiser.setModelPath (juce::File (settings.modelPath));
-    else
-        realtimeDenoiser.clearModelPath();
+    // The offline instance loads its own session the first time it is used
+    for (auto* denoiser : { &realtimeDenoiser, &offlineDenoiser })
+    {
+        denoiser->setPreferredProvider (OnnxDenoiser::providerFromString (settings.provider));
+        denoiser->setAutoProvider (ProviderBenchmarkRunner::getStoredWinner());
+        denoiser->setAllowFallback (settings.allowFallback);
+        denoiser->setDmlDeviceId (settings.dmlDeviceId);
+        denoiser->setQnnBackendPath (settings.qnnBackendPath);
+
+        if (settings.modelPath.isNotEmpty())
+            denoiser->setModelPath (juce::File (settings.modelPath));
+        else
+            denoiser->clearModelPath();
+    }
+
+    realtimeDenoiser.setAsyncInference (settings.asyncInference); // From the prepare when the player is back
+
+    // First run, or the runtime, device or model changed: measure, then apply the winner
+    if (realtimeDenoiser.getPreferredProvider() == OnnxDenoiser::Provider::autoSelect)
+        providerBenchmark.startIfNeeded (settings);
+
+    // processBlock no longer loads models on the audio thread, and the UI does not wait for it either
+    realtimeDenoiser.loadDefaultModelAsync();
+
+    // Re-adding prepares the chain again, on this thread
+    audioDeviceManager.addAudioCallback (&audioSourcePlayer);
 }
 
 void StandaloneWindow::toggleRecording()
@@ -4779,10 +5670,18 @@ void StandaloneWindow::startRecording()
         return;
     }
 
-    recorder->setSilenceThreshold (silenceThresholdDB);
-    recorder->setSilenceDuration (silenceDurationRequirement);
     recorder->setPaused (true);
 
+    // Held in memory and analysed while it is captured, so nothing is decoded after stop
+    RecordingCapture::Settings captureSettings;
+    captureSettings.sampleRate = deviceSampleRate;
+    captureSettings.numChannels = juce::jmin (2, inputChannels);
+    captureSettings.clickSensitivity = clickSensitivity;
+    captureSettings.clickMaxWidth = clickMaxWidth;
+    captureSettings.silenceThresholdDb = silenceThresholdDB;
+    captureSettings.minSilenceSeconds = silenceDurationRequirement;
+    recordingCapture.start (captureSettings);
+
     if (mainComponent != nullptr)
     {
         mainComponent->getWaveformDisplay().prepareForRecording (deviceSampleRate, juce::jmin (2, inputChannels));
@@ -4792,8 +5691,6 @@ void StandaloneWindow::startRecording()
         mainComponent->getTrackListView().addMarker (0, "Track 1");
     }
 
-    bufferedRecording.reset();
-    
     // Enter Rec-pause state
     isRecording = true;
     isRecordingPaused = true;
@@ -4815,6 +5712,8 @@ void StandaloneWindow::stopRecording()
         recorder->stop();
     }
 
+    auto capture = recordingCapture.finish();
+
     isRecording = false;
     isRecordingPaused = false;
     setRecordingState (false);
@@ -4827,74 +5726,67 @@ void StandaloneWindow::stopRecording()
         return;
     }
 
-    if (mainComponent != nullptr)
-        mainComponent->getCorrectionListView().setStatusText ("Opening recording...");
-
     // Save state BEFORE opening the new file so we can undo back to previous buffer
     undoManager.saveState (audioBuffer, sampleRate, "Record Audio");
-    
-    openFile (recordedFile);
-    if (mainComponent != nullptr) mainComponent->getUndoHistoryView().refresh();
-}
-
-void StandaloneWindow::loadRecordingFromMemory (juce::MemoryBlock&& data)
-{
-    bufferedRecording = std::move (data);
-    if (bufferedRecording.getSize() == 0)
-        return;
-
-    transportSource.stop();
-    transportSource.setSource (nullptr);
-    readerSource.reset();
-    isPlaying = false;
-
-    juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
-    formatManager.registerFormat (new juce::FlacAudioFormat(), true);
-    formatManager.registerFormat (new juce::OggVorbisAudioFormat(), true);
 
-   #if JUCE_USE_MP3AUDIOFORMAT
-    formatManager.registerFormat (new juce::MP3AudioFormat(), true);
-   #endif
+    // The file has everything the device delivered; the capture only what it kept up with
+    if (capture.numDropped > 0 || capture.audio.getNumSamples() == 0)
+    {
+        DBG ("Recording capture dropped " + juce::String (capture.numDropped) + " samples; reopening the file");
 
-    auto memoryStream = std::make_unique<juce::MemoryInputStream> (bufferedRecording.getData(),
-                                                                   bufferedRecording.getSize(),
-                                                                   false);
-    std::unique_ptr<juce::AudioFormatReader> reader (
-        formatManager.createReaderFor (std::move (memoryStream)));
+        if (mainComponent != nullptr)
+            mainComponent->getCorrectionListView().setStatusText ("Opening recording...");
 
-    if (reader == nullptr)
+        openFile (recordedFile);
+    }
+    else
     {
-        bufferedRecording.reset();
-        juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::WarningIcon,
-                                               "Load Failed",
-                                               "Could not decode the buffered recording.");
-        return;
+        loadRecordingFromCapture (std::move (capture), recordedFile);
     }
 
-    sampleRate = reader->sampleRate;
-    const int numChannels = static_cast<int> (reader->numChannels);
-    const int numSamples = static_cast<int> (reader->lengthInSamples);
+    if (mainComponent != nullptr) mainComponent->getUndoHistoryView().refresh();
+}
 
-    audioBuffer.setSize (numChannels, numSamples);
-    reader->read (&audioBuffer, 0, numSamples, 0, true, true);
+void StandaloneWindow::loadRecordingFromCapture (RecordingCapture::Result&& capture, const juce::File& recordedFile)
+{
+    {
+        const juce::ScopedLock sl (audioBufferLock);
+        audioBuffer = std::move (capture.audio);
+    }
 
-    readerSource.reset (new juce::AudioFormatReaderSource (reader.release(), true));
-    transportSource.setSource (readerSource.get(), 0, nullptr, sampleRate);
+    sampleRate = recordingCapture.getSampleRate();
+    currentFile = recordedFile;
+    currentSessionFile = juce::File();
+    updateTransportSourceFromBuffer();
 
     if (mainComponent != nullptr)
     {
-        mainComponent->getWaveformDisplay().updateFromBuffer (audioBuffer, sampleRate);
-        mainComponent->getWaveformDisplay().clearSelection();
-        mainComponent->setAudioBuffer (&audioBuffer, sampleRate);
-        mainComponent->getCorrectionListView().clearCorrections();
-        mainComponent->getCorrectionListView().setStatusText ("Recording loaded (buffered). Use Export Audio to save.");
+        // The overview was built block by block while recording
+        spectrogramCache->setSampleRate (sampleRate);
+        spectrogramCache->invalidateAll();
+        trackLevels.clear();
+        mainComponent->setAudioBuffer (&audioBuffer, sampleRate, false);
+
+        const auto numClicks = capture.clicks.size();
+        auto& listView = mainComponent->getCorrectionListView();
+
+        if (numClicks > 0)
+        {
+            listView.setCorrections (std::move (capture.clicks));
+            mainComponent->getWaveformDisplay().setDetectedClicks (listView.getCorrectionStore());
+        }
+        else
+        {
+            listView.clearCorrections();
+        }
+
+        listView.setStatusText ("Recording loaded: " + juce::String (static_cast<int> (numClicks)) + " clicks and "
+                                + juce::String (static_cast<int> (capture.trackBoundaries.size())) + " track gaps found while recording.");
     }
 
-    undoManager.clear();
-    currentFile = juce::File();
-    currentSessionFile = juce::File();
+    recentFiles.addFile (recordedFile);
     hasUnsavedChanges = false;
+    menuItemsChanged();
     updateTitle();
 }
 
@@ -4938,15 +5830,14 @@ void StandaloneWindow::setUIScale (float newScale)
 class StandaloneWindow::SpectrogramWindow : public juce::DocumentWindow
 {
 public:
-    SpectrogramWindow (const juce::AudioBuffer<float>& buffer, double sampleRate,
-                      const juce::String& fileName)
+    SpectrogramWindow (std::shared_ptr<SpectrogramTileCache> cache, const juce::String& fileName)
         : DocumentWindow ("Spectrogram - " + fileName,
                          juce::Colour (0xff1a1a2e),
                          DocumentWindow::closeButton | DocumentWindow::minimiseButton)
     {
         auto* display = new SpectrogramDisplay();
         display->setSize (800, 400);
-        display->analyzeBuffer (buffer, sampleRate);
+        display->setTileCache (std::move (cache));
         setContentOwned (display, true);
 
         setUsingNativeTitleBar (true);
@@ -4980,7 +5871,7 @@ void StandaloneWindow::showSpectrogram()
         return;
     }
 
-    auto* sw = new SpectrogramWindow (audioBuffer, sampleRate, currentFile.getFileName());
+    auto* sw = new SpectrogramWindow (spectrogramCache, currentFile.getFileName());
     spectrogramWindow = sw;
 }
 
@@ -5060,7 +5951,14 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
     {
         if (parentWindow != nullptr)
         {
-            if (parentWindow->undoManager.performUndoTo (index, parentWindow->audioBuffer, parentWindow->sampleRate))
+            bool undone = false;
+
+            {
+                const juce::ScopedLock sl (parentWindow->audioBufferLock);
+                undone = parentWindow->undoManager.performUndoTo (index, parentWindow->audioBuffer, parentWindow->sampleRate);
+            }
+
+            if (undone)
             {
                 setAudioBuffer (&parentWindow->audioBuffer, parentWindow->sampleRate);
                 undoHistoryView.refresh();
@@ -5302,6 +6200,7 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
     addAndMakeVisible (statusLabel);
     statusLabel.setText ("Ready", juce::dontSendNotification);
     statusLabel.setJustificationType (juce::Justification::centredLeft);
+    addAndMakeVisible (stageLoadMeter);
 
     // Create resizer divider for waveform/correction list split
     addAndMakeVisible (resizeDivider);
@@ -5402,7 +6301,7 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
                 if (selLength > 0)
                 {
                     // Save undo state
-                    parentWindow->undoManager.saveState (buffer, sr, "Cut");
+                    parentWindow->undoManager.saveSplice (buffer, sr, "Cut", startSample, selLength, 0);
 
                     // Copy to clipboard
                     juce::AudioBuffer<float> clipboardData (buffer.getNumChannels(), selLength);
@@ -5411,15 +6310,10 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
                     waveformDisplay.setClipboardData (clipboardData, sr);
 
                     // Remove from buffer
-                    int newLength = buffer.getNumSamples() - selLength;
-                    juce::AudioBuffer<float> newBuffer (buffer.getNumChannels(), newLength);
-                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
                     {
-                        newBuffer.copyFrom (ch, 0, buffer, ch, 0, startSample);
-                        if (endSample < buffer.getNumSamples())
-                            newBuffer.copyFrom (ch, startSample, buffer, ch, endSample, buffer.getNumSamples() - endSample);
+                        const juce::ScopedLock sl (parentWindow->audioBufferLock);
+                        BufferSplice::erase (buffer, startSample, selLength);
                     }
-                    buffer = newBuffer;
 
                     // Adjust playhead if deletion happened before current position
                     int64_t playheadSamples = static_cast<int64_t> (parentWindow->transportSource.getCurrentPosition() * sr);
@@ -5427,7 +6321,7 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
                     
                     parentWindow->updateTransportSourceFromBuffer (samplesBeforePlayhead);
 
-                    waveformDisplay.updateFromBuffer (buffer, sr);
+                    waveformDisplay.updateRegion (buffer, sr, startSample, 0);
                     waveformDisplay.clearSelection();
                     parentWindow->hasUnsavedChanges = true;
                     parentWindow->updateTitle();
@@ -5449,32 +6343,18 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
             case WaveformDisplay::actionPaste:
                 if (waveformDisplay.hasClipboardData())
                 {
-                    // Save undo state
-                    parentWindow->undoManager.saveState (buffer, sr, "Paste");
-
                     const auto& clipData = waveformDisplay.getClipboardBuffer();
                     int insertPos = startSample;  // Paste at selection start (or cursor)
                     int pasteLen = clipData.getNumSamples();
 
-                    // Create new buffer with space for pasted data
-                    int newLength = buffer.getNumSamples() + pasteLen;
-                    juce::AudioBuffer<float> newBuffer (buffer.getNumChannels(), newLength);
+                    // Save undo state
+                    parentWindow->undoManager.saveSplice (buffer, sr, "Paste", insertPos, 0, pasteLen);
 
-                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    // Insert the clipboard in place (its last channel fills any the buffer has beyond it)
                     {
-                        // Copy before insertion point
-                        if (insertPos > 0)
-                            newBuffer.copyFrom (ch, 0, buffer, ch, 0, insertPos);
-
-                        // Copy clipboard data (handle channel mismatch)
-                        int srcCh = juce::jmin (ch, clipData.getNumChannels() - 1);
-                        newBuffer.copyFrom (ch, insertPos, clipData, srcCh, 0, pasteLen);
-
-                        // Copy after insertion point
-                        if (insertPos < buffer.getNumSamples())
-                            newBuffer.copyFrom (ch, insertPos + pasteLen, buffer, ch, insertPos, buffer.getNumSamples() - insertPos);
+                        const juce::ScopedLock sl (parentWindow->audioBufferLock);
+                        BufferSplice::insert (buffer, insertPos, clipData);
                     }
-                    buffer = newBuffer;
 
                     // Adjust playhead if insertion happened before current position
                     int64_t playheadSamples = static_cast<int64_t> (parentWindow->transportSource.getCurrentPosition() * sr);
@@ -5482,7 +6362,7 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
                     
                     parentWindow->updateTransportSourceFromBuffer (offsetToApply);
 
-                    waveformDisplay.updateFromBuffer (buffer, sr);
+                    waveformDisplay.updateRegion (buffer, sr, insertPos, 0);
                     waveformDisplay.setSelection (insertPos, insertPos + pasteLen);
                     parentWindow->hasUnsavedChanges = true;
                     parentWindow->updateTitle();
@@ -5494,18 +6374,13 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
                 if (selLength > 0)
                 {
                     // Save undo state
-                    parentWindow->undoManager.saveState (buffer, sr, "Delete Selection");
+                    parentWindow->undoManager.saveSplice (buffer, sr, "Delete Selection", startSample, selLength, 0);
 
                     // Remove selection from buffer
-                    int newLength = buffer.getNumSamples() - selLength;
-                    juce::AudioBuffer<float> newBuffer (buffer.getNumChannels(), newLength);
-                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
                     {
-                        newBuffer.copyFrom (ch, 0, buffer, ch, 0, startSample);
-                        if (endSample < buffer.getNumSamples())
-                            newBuffer.copyFrom (ch, startSample, buffer, ch, endSample, buffer.getNumSamples() - endSample);
+                        const juce::ScopedLock sl (parentWindow->audioBufferLock);
+                        BufferSplice::erase (buffer, startSample, selLength);
                     }
-                    buffer = newBuffer;
 
                     // Adjust playhead if deletion happened before current position
                     int64_t playheadSamples = static_cast<int64_t> (parentWindow->transportSource.getCurrentPosition() * sr);
@@ -5513,7 +6388,7 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
                     
                     parentWindow->updateTransportSourceFromBuffer (samplesBeforePlayhead);
 
-                    waveformDisplay.updateFromBuffer (buffer, sr);
+                    waveformDisplay.updateRegion (buffer, sr, startSample, 0);
                     waveformDisplay.clearSelection();
                     parentWindow->hasUnsavedChanges = true;
                     parentWindow->updateTitle();
@@ -5524,14 +6399,18 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
             case WaveformDisplay::actionCropToSelection:
                 if (selLength > 0)
                 {
-                    // Save undo state
-                    parentWindow->undoManager.saveState (buffer, sr, "Crop to Selection");
+                    // Save undo state: the audio after the selection, then the audio before it
+                    AudioUndoManager::Edit undoEdit ("Crop to Selection", sr);
+                    undoEdit.saveSplice (buffer, endSample, buffer.getNumSamples() - endSample, 0);
+                    undoEdit.saveSplice (buffer, 0, startSample, 0);
+                    parentWindow->undoManager.addEdit (std::move (undoEdit));
 
                     // Keep only the selected portion
-                    juce::AudioBuffer<float> newBuffer (buffer.getNumChannels(), selLength);
-                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
-                        newBuffer.copyFrom (ch, 0, buffer, ch, startSample, selLength);
-                    buffer = newBuffer;
+                    {
+                        const juce::ScopedLock sl (parentWindow->audioBufferLock);
+                        BufferSplice::erase (buffer, endSample, buffer.getNumSamples() - endSample);
+                        BufferSplice::erase (buffer, 0, startSample);
+                    }
 
                     // In crop, the new start is 'startSample', so we need to shift playhead right
                     parentWindow->updateTransportSourceFromBuffer (startSample);
@@ -5569,14 +6448,14 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
             case WaveformDisplay::actionFadeIn:
                 if (selLength > 0)
                 {
-                    parentWindow->undoManager.saveState (buffer, sr, "Fade In");
+                    parentWindow->undoManager.saveRegion (buffer, sr, "Fade In", startSample, selLength);
                     for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
                     {
                         float* data = buffer.getWritePointer (ch, startSample);
                         for (int i = 0; i < selLength; ++i)
                             data[i] *= (float)i / (float)selLength;
                     }
-                    waveformDisplay.updateFromBuffer (buffer, sr);
+                    waveformDisplay.updateRegion (buffer, sr, startSample, selLength);
                     parentWindow->hasUnsavedChanges = true;
                 }
                 break;
@@ -5584,14 +6463,14 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
             case WaveformDisplay::actionFadeOut:
                 if (selLength > 0)
                 {
-                    parentWindow->undoManager.saveState (buffer, sr, "Fade Out");
+                    parentWindow->undoManager.saveRegion (buffer, sr, "Fade Out", startSample, selLength);
                     for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
                     {
                         float* data = buffer.getWritePointer (ch, startSample);
                         for (int i = 0; i < selLength; ++i)
                             data[i] *= 1.0f - ((float)i / (float)selLength);
                     }
-                    waveformDisplay.updateFromBuffer (buffer, sr);
+                    waveformDisplay.updateRegion (buffer, sr, startSample, selLength);
                     parentWindow->hasUnsavedChanges = true;
                 }
                 break;
@@ -5639,6 +6518,7 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
     correctionListView.onDeleteCorrection = [this] (int index)
     {
         correctionListView.removeCorrection (index);
+        waveformDisplay.repaint();
         DBG ("Deleted correction at index " + juce::String (index));
     };
 
@@ -5672,6 +6552,7 @@ StandaloneWindow::MainComponent::MainComponent (AudioUndoManager& undoMgr)
                     int newWidth = dialog->getTextEditorContents ("width").getIntValue();
 
                     correctionListView.updateCorrection (corrIndex, newPos, newMag, newWidth);
+                    waveformDisplay.repaint();
                     DBG ("Updated correction " + juce::String (corrIndex));
                 }
                 delete dialog;
@@ -5885,6 +6766,8 @@ void StandaloneWindow::MainComponent::resized()
     // Status bar at bottom
     auto statusArea = area.removeFromBottom (statusRowHeight);
     statusArea.reduce (10, 5);
+    stageLoadMeter.setBounds (statusArea.removeFromRight (260).reduced (0, 2));
+    statusArea.removeFromRight (10);
     statusLabel.setBounds (statusArea);
 
     // List tabs take remaining space
@@ -6256,7 +7139,7 @@ void StandaloneWindow::MainComponent::mouseWheelMove (const juce::MouseEvent& ev
     }
 }
 
-void StandaloneWindow::MainComponent::setAudioBuffer (const juce::AudioBuffer<float>* buffer, double sampleRate)
+void StandaloneWindow::MainComponent::setAudioBuffer (const juce::AudioBuffer<float>* buffer, double sampleRate, bool rebuildWaveform)
 {
     currentBuffer = buffer;
     currentSampleRate = sampleRate;
@@ -6264,7 +7147,8 @@ void StandaloneWindow::MainComponent::setAudioBuffer (const juce::AudioBuffer<fl
 
     if (buffer != nullptr)
     {
-        waveformDisplay.updateFromBuffer (*buffer, sampleRate);
+        if (rebuildWaveform)
+            waveformDisplay.updateFromBuffer (*buffer, sampleRate);
 
         statusLabel.setText (juce::String (buffer->getNumChannels()) + " channels, " +
                            juce::String (sampleRate / 1000.0, 1) + " kHz, " +
@@ -10,14 +10,21 @@
 #include "ReaperLookAndFeel.h"
 #include "../Processors/BatchProcessor.h"
 #include "../Processors/TrackDetector.h"
+#include "../Processors/RegionOperation.h"
 #include "../Utils/AudioFileManager.h"
+#include "../Utils/SessionFile.h"
 #include "../DSP/ClickRemoval.h"
 #include "../DSP/Decrackle.h"
 #include "../DSP/NoiseReduction.h"
 #include "../DSP/FilterBank.h"
 #include "../DSP/OnnxDenoiser.h"
+#include "../DSP/LivePreviewChain.h"
+#include "../DSP/VisualizationTap.h"
+#include "../Utils/RecordingCapture.h"
 #include "../Utils/AudioUndoManager.h"
 #include "../Utils/SettingsManager.h"
+#include "../Utils/ProviderBenchmarkRunner.h"
+#include "StageLoadMeter.h"
 #include <array>
 
 /**
@@ -91,6 +98,7 @@ private:
         fileRecentClear,
         fileExit,
         fileExitNoSave,
+        fileExportSessionJSON,
 
         editUndo,
         editRedo,
@@ -102,6 +110,7 @@ private:
         processRemoveClicks,
         processDecrackle,
         processNoiseReduction,
+        processAIDenoise,
         processCutAndSplice,
         processGraphicEQ,
         processNormalise,
@@ -131,6 +140,9 @@ private:
         optionsProcessingSettings,
         optionsRecordingSettings,
         optionsAIDenoise,
+        optionsRealtimeDecrackle,
+        optionsPreviewClickRemoval,
+        optionsPreviewNoiseReduction,
 
         helpAbout,
         helpDocumentation,
@@ -174,6 +186,8 @@ private:
     juce::File currentFile;        // The loaded audio file (.wav, .flac, etc.)
     juce::File currentSessionFile; // The session file (.vrs) if saved
     juce::AudioBuffer<float> audioBuffer;
+    juce::CriticalSection audioBufferLock;    // Held while an edit changes audioBuffer's length or storage
+    std::shared_ptr<SpectrogramTileCache> spectrogramCache = std::make_shared<SpectrogramTileCache>();   // Shared by every spectrogram view of audioBuffer
     double sampleRate = 44100.0;
     bool hasUnsavedChanges = false;
 
@@ -191,7 +205,7 @@ private:
     bool isRecording = false;
     bool isRecordingPaused = false;
     bool monitoringEnabled = true;
-    juce::MemoryBlock bufferedRecording;
+    RecordingCapture recordingCapture;
     float meterLevelLeft = 0.0f;
     float meterLevelRight = 0.0f;
     bool showCorrectionList = true;
@@ -213,7 +227,7 @@ private:
     void startRecording();
     void stopRecording();
     void setRecordingState (bool recording);
-    void loadRecordingFromMemory (juce::MemoryBlock&& data);
+    void loadRecordingFromCapture (RecordingCapture::Result&& capture, const juce::File& recordedFile);
 
     // Recording settings
     juce::String recordingFormat = "WAV";
@@ -238,14 +252,34 @@ private:
     //==============================================================================
     // DSP Processors for audio restoration
     ClickRemoval clickRemovalProcessor;
-    Decrackle decrackleProcessor;
     NoiseReduction noiseReductionProcessor;
     FilterBank filterBankProcessor;
     TrackDetector trackDetector;
+    TrackDetector::DetectionSettings trackDetectionSettings;
+    TrackDetector::WindowLevels trackLevels;        // Of the whole buffer, kept up to date by edits
     class RestorationAudioSource;
     std::unique_ptr<juce::AudioSource> restorationSource;
     OnnxDenoiser realtimeDenoiser;
+    OnnxDenoiser offlineDenoiser;      // Process > AI Denoise; never touched by the audio callback
+    ProviderBenchmarkRunner providerBenchmark;
     bool realtimeEqEnabled = true;
+    Decrackle realtimeDecrackle;
+    bool realtimeDecrackleEnabled = false;
+
+    // Live preview of the offline stages, played from the buffer source
+    LivePreviewChain livePreview;
+    bool previewClickRemovalEnabled = false;
+    bool previewNoiseReductionEnabled = false;
+    double livePreviewSampleRate = 0.0;     // What the preview stages were prepared for
+    int livePreviewNumChannels = 0;
+
+    struct NoiseReductionPreview
+    {
+        float reductionDB = 12.0f;
+        float adaptiveRate = 0.0f;
+        int profileStart = 0;
+        int profileLength = 0;              // Zero until a preview was requested
+    } noiseReductionPreview;
 
     //==============================================================================
     // Undo/Redo management
@@ -278,6 +312,9 @@ private:
     void updateTransportSourceFromBuffer (juce::int64 sampleOffset = 0);
     bool saveFile (const juce::File& file);
     void exportFile();
+    /** The session as it stands: settings, corrections, track markers and the caches that still apply */
+    std::unique_ptr<SessionFile::Writer> createSessionWriter();
+    void exportSessionAsJSON();
     bool promptToSaveIfNeeded (const juce::String& actionName);
     bool saveCurrentSessionForPrompt();
     void detectClicks();
@@ -285,6 +322,8 @@ private:
     void removeClicks();
     void applyDecrackle();
     void applyNoiseReduction();
+    void updateLivePreview();
+    void applyAIDenoise();
     void applyNoiseReductionWithSettings (float reductionDB,
                                           float profileStartSec,
                                           float profileLengthSec,
@@ -329,6 +368,18 @@ private:
 
     ProcessingRange getProcessingRange() const;
 
+    /** Re-runs track detection over range from the cached levels and refreshes the track list */
+    void updateDetectedTracks (const ProcessingRange& range);
+
+    /**
+     * Runs operation over range behind a progress window, then adds its undo
+     * step and refreshes the display; onApplied follows unless it was cancelled.
+     */
+    void runRegionOperation (std::shared_ptr<RegionOperation> operation,
+                             const ProcessingRange& range,
+                             const juce::String& progressTitle,
+                             std::function<void (const RegionProcessor::Result&)> onApplied);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StandaloneWindow)
 };
 
@@ -381,9 +432,11 @@ public:
     juce::Button& getPauseButton() { return pauseButton; }
     juce::Button& getStopButton() { return stopButton; }
 
-    void setAudioBuffer (const juce::AudioBuffer<float>* buffer, double sampleRate);
+    /** Shows a buffer; pass rebuildWaveform = false when the waveform was already updated for the edit */
+    void setAudioBuffer (const juce::AudioBuffer<float>* buffer, double sampleRate, bool rebuildWaveform = true);
     void updatePlaybackPosition (double position);
     void setMeterLevel (float leftLevel, float rightLevel);
+    void setStageProfiler (StageProfiler* profiler) { stageLoadMeter.setProfiler (profiler); }
     void setCorrectionListVisible (bool visible);
     void setTrackListVisible (bool visible);
     void setUndoHistoryVisible (bool visible);
@@ -472,6 +525,7 @@ private:
 
     // Status
     juce::Label statusLabel;
+    StageLoadMeter stageLoadMeter;
 
     // Logo
     juce::Image logoImage;
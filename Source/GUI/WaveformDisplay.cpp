@@ -1,18 +1,8 @@
 #include "WaveformDisplay.h"
+#include <cmath>
 
 WaveformDisplay::WaveformDisplay()
-    : thumbnail (128, formatManager, thumbnailCache)
 {
-    // Register all supported audio formats (WAV, AIFF, FLAC, OGG, MP3)
-    formatManager.registerBasicFormats();
-    formatManager.registerFormat (new juce::FlacAudioFormat(), true);
-    formatManager.registerFormat (new juce::OggVorbisAudioFormat(), true);
-
-    #if JUCE_USE_MP3AUDIOFORMAT
-    formatManager.registerFormat (new juce::MP3AudioFormat(), true);
-    #endif
-
-    thumbnail.addChangeListener (this);
     startTimer (40); // 25 fps for smooth cursor updates
 
     // Enable OpenGL hardware acceleration for smooth waveform rendering
@@ -35,7 +25,8 @@ WaveformDisplay::WaveformDisplay()
 
 WaveformDisplay::~WaveformDisplay()
 {
-    thumbnail.removeChangeListener (this);
+    if (spectrogramCache != nullptr)
+        spectrogramCache->removeChangeListener (this);
 
     #if JUCE_OPENGL
     if (useOpenGL)
@@ -64,37 +55,21 @@ void WaveformDisplay::filesDropped (const juce::StringArray& files, int, int)
 
 void WaveformDisplay::loadFile (const juce::File& file)
 {
-    // Clear previous waveform first
-    thumbnail.clear();
-
-    auto* reader = formatManager.createReaderFor (file);
-
-    if (reader != nullptr)
-    {
-        sampleRate = reader->sampleRate;
-        DBG ("Audio file info: " + juce::String (reader->numChannels) + " channels, " +
-             juce::String (sampleRate) + " Hz, " +
-             juce::String (reader->lengthInSamples) + " samples");
-        delete reader;
-
-        // Load the file into the thumbnail
-        thumbnail.setSource (new juce::FileInputSource (file));
-
-        DBG ("Waveform thumbnail loading started for: " + file.getFullPathName());
-
-        // Force immediate repaint
-        repaint();
-    }
-    else
-    {
-        DBG ("Failed to create reader for file: " + file.getFullPathName());
-    }
+    // The decoded buffer follows through updateFromBuffer(), which takes the
+    // overview from the sidecar instead of scanning when the file is unchanged
+    peakSourceFile = file;
 }
 
 void WaveformDisplay::clear()
 {
-    thumbnail.clear();
+    {
+        const juce::ScopedLock sl (peaksLock);
+        peaks.clear();
+    }
+
+    peakSourceFile = juce::File();
     clickMarkers.clear();
+    detectedClicks.reset();
     selectionStart = -1;
     selectionEnd = -1;
     playbackPosition = 0.0;
@@ -109,17 +84,37 @@ void WaveformDisplay::setPlaybackPosition (double position)
 
 void WaveformDisplay::addClickMarker (int64_t samplePosition)
 {
-    clickMarkers.push_back (samplePosition);
-    std::sort (clickMarkers.begin(), clickMarkers.end());
+    // Kept sorted, so drawing finds the visible ones by binary search
+    clickMarkers.insert (std::upper_bound (clickMarkers.begin(), clickMarkers.end(), samplePosition), samplePosition);
     repaint();
 }
 
 void WaveformDisplay::clearClickMarkers()
 {
     clickMarkers.clear();
+    detectedClicks.reset();
+    repaint();
+}
+
+void WaveformDisplay::setDetectedClicks (std::shared_ptr<const ClickStore> store)
+{
+    detectedClicks = std::move (store);
     repaint();
 }
 
+void WaveformDisplay::setSpectrogramCache (std::shared_ptr<SpectrogramTileCache> cache)
+{
+    if (spectrogramCache != nullptr)
+        spectrogramCache->removeChangeListener (this);
+
+    spectrogramCache = std::move (cache);
+
+    if (spectrogramCache != nullptr)
+        spectrogramCache->addChangeListener (this);
+
+    spectrogramNeedsUpdate = true;
+}
+
 void WaveformDisplay::updateFromBuffer (const juce::AudioBuffer<float>& buffer, double newSampleRate)
 {
     if (buffer.getNumSamples() == 0)
@@ -127,25 +122,86 @@ void WaveformDisplay::updateFromBuffer (const juce::AudioBuffer<float>& buffer,
 
     sampleRate = newSampleRate;
 
-    // Clear previous thumbnail and reset it from the buffer
-    thumbnail.clear();
+    if (spectrogramCache != nullptr)
+    {
+        spectrogramCache->setSampleRate (newSampleRate);
+        spectrogramCache->invalidateAll();
+    }
+
+    // Only the first update after loadFile() shows the file's own content
+    const auto sourceFile = std::exchange (peakSourceFile, juce::File());
 
-    // Reset the thumbnail with new data
-    thumbnail.reset (buffer.getNumChannels(), newSampleRate, buffer.getNumSamples());
+    {
+        const juce::ScopedLock sl (peaksLock);
 
-    // Add the entire buffer to the thumbnail
-    thumbnail.addBlock (0, buffer, 0, buffer.getNumSamples());
+        if (sourceFile == juce::File())
+        {
+            peaks.build (buffer);
+        }
+        else
+        {
+            const auto sidecar = PeakPyramid::getSidecarFile (sourceFile);
+            const auto fileFingerprint = PeakPyramid::fingerprint (sourceFile);
 
+            if (peaks.load (sidecar, fileFingerprint, buffer.getNumChannels(), buffer.getNumSamples()))
+            {
+                DBG ("Waveform peaks read from " + sidecar.getFullPathName());
+            }
+            else
+            {
+                peaks.build (buffer);
+
+                if (!peaks.save (sidecar, fileFingerprint))
+                    DBG ("Waveform peaks: could not write " + sidecar.getFullPathName());
+            }
+        }
+    }
+
+    spectrogramNeedsUpdate = true;
     repaint();
+
+    if (onAudioChanged != nullptr)
+        onAudioChanged (0, -1);
+
     DBG ("Waveform updated from buffer: " + juce::String (buffer.getNumSamples()) + " samples");
 }
 
+void WaveformDisplay::updateRegion (const juce::AudioBuffer<float>& buffer, double newSampleRate, int64_t startSample, int64_t numSamples)
+{
+    sampleRate = newSampleRate;
+    peakSourceFile = juce::File();
+    bool lengthChanged = false;
+
+    {
+        const juce::ScopedLock sl (peaksLock);
+        lengthChanged = buffer.getNumSamples() != peaks.getNumSamples();
+
+        // Only the tiles over the edit are recomputed; a length change moved everything after it
+        if (spectrogramCache != nullptr)
+            spectrogramCache->invalidate (startSample, lengthChanged ? -1 : numSamples);
+
+        peaks.update (buffer, startSample, numSamples);
+    }
+
+    spectrogramNeedsUpdate = true;
+    repaint();
+
+    if (onAudioChanged != nullptr)
+        onAudioChanged (startSample, lengthChanged ? -1 : numSamples);
+}
+
 void WaveformDisplay::prepareForRecording (double newSampleRate, int numChannels)
 {
     sampleRate = newSampleRate;
-    thumbnail.clear();
-    thumbnail.reset (numChannels, newSampleRate);
+    peakSourceFile = juce::File();
+
+    {
+        const juce::ScopedLock sl (peaksLock);
+        peaks.reset (numChannels);
+    }
+
     clickMarkers.clear();
+    detectedClicks.reset();
     selectionStart = -1;
     selectionEnd = -1;
     playbackPosition = 0.0;
@@ -157,12 +213,8 @@ void WaveformDisplay::addBlock (const float** channelData, int numChannels, int
     if (numSamples <= 0 || sampleRate <= 0.0)
         return;
 
-    // Start sample is current total length in samples
-    int64_t startSample = static_cast<int64_t>(thumbnail.getTotalLength() * sampleRate);
-    
-    // Create a temporary buffer to use the AudioBuffer overload of addBlock
-    juce::AudioBuffer<float> tempBuffer (const_cast<float**>(channelData), numChannels, numSamples);
-    thumbnail.addBlock (startSample, tempBuffer, 0, numSamples);
+    const juce::ScopedLock sl (peaksLock);
+    peaks.append (channelData, numChannels, numSamples);
 }
 
 void WaveformDisplay::setHorizontalZoom (double samplesPerPixel)
@@ -182,7 +234,7 @@ bool WaveformDisplay::zoomToSelection()
     if (selectionStart < 0 || selectionEnd < 0 || sampleRate <= 0.0)
         return false;
 
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
     if (totalLength <= 0.0)
         return false;
 
@@ -213,7 +265,7 @@ void WaveformDisplay::paint (juce::Graphics& g)
     // Background - Reaper dark grey
     g.fillAll (juce::Colour (0xff1a1a1a));
 
-    if (thumbnail.getTotalLength() > 0.0)
+    if (getTotalLength() > 0.0)
     {
         auto rulerBounds = bounds.removeFromTop (timeRulerHeight);
         drawTimeRuler (g, rulerBounds);
@@ -233,13 +285,6 @@ void WaveformDisplay::paint (juce::Graphics& g)
         drawSelection (g, waveformBounds);
         drawPlaybackCursor (g, waveformBounds);
     }
-    else if (thumbnail.isFullyLoaded() == false && thumbnail.getNumChannels() > 0)
-    {
-        // Thumbnail is loading
-        g.setColour (juce::Colours::lightgrey);
-        g.setFont (16.0f);
-        g.drawText ("Loading waveform...", bounds, juce::Justification::centred);
-    }
     else
     {
         // No audio loaded
@@ -261,12 +306,12 @@ void WaveformDisplay::resized()
 
 void WaveformDisplay::mouseDown (const juce::MouseEvent& event)
 {
-    if (thumbnail.getTotalLength() <= 0.0)
+    if (getTotalLength() <= 0.0)
         return;
 
     if (event.position.y <= timeRulerHeight)
     {
-        double totalLength = thumbnail.getTotalLength();
+        double totalLength = getTotalLength();
         double visibleDuration = totalLength / horizontalZoom;
         double viewStartTime = scrollPosition * juce::jmax (0.001, totalLength - visibleDuration);
         double clickTime = viewStartTime + (event.position.x / (double) getWidth()) * visibleDuration;
@@ -304,7 +349,7 @@ void WaveformDisplay::mouseDown (const juce::MouseEvent& event)
     activeHandle = HandleDrag::none;
 
     // Calculate click time position
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
     double visibleDuration = totalLength / horizontalZoom;
     double viewStartTime = scrollPosition * juce::jmax (0.001, totalLength - visibleDuration);
     double clickTime = viewStartTime + (event.position.x / (double) getWidth()) * visibleDuration;
@@ -374,21 +419,21 @@ void WaveformDisplay::mouseDown (const juce::MouseEvent& event)
 
 void WaveformDisplay::mouseDrag (const juce::MouseEvent& event)
 {
-    if (thumbnail.getTotalLength() <= 0.0)
+    if (getTotalLength() <= 0.0)
         return;
 
     // Right-click drag: Do nothing (or could pan view)
     if (event.mods.isRightButtonDown())
         return;
 
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
     double visibleDuration = totalLength / horizontalZoom;
     double viewStartTime = scrollPosition * juce::jmax (0.001, totalLength - visibleDuration);
 
     // Handle dragging selection handles
     if (isHandleDrag && activeHandle != HandleDrag::none)
     {
-        double totalLength = thumbnail.getTotalLength();
+        double totalLength = getTotalLength();
         double visibleDuration = totalLength / horizontalZoom;
         double viewStartTime = scrollPosition * juce::jmax (0.001, totalLength - visibleDuration);
         double dragTime = viewStartTime + (event.position.x / (double) getWidth()) * visibleDuration;
@@ -497,7 +542,7 @@ void WaveformDisplay::showContextMenu (const juce::MouseEvent& event)
     editMenu.addItem (actionFadeOut, "Apply Fade-out", hasSelection());
     editMenu.addSeparator();
     editMenu.addItem (actionCropToSelection, "Crop to Selection", hasSelection());
-    editMenu.addItem (actionSelectAll, "Select All              Ctrl+A", thumbnail.getTotalLength() > 0.0);
+    editMenu.addItem (actionSelectAll, "Select All              Ctrl+A", getTotalLength() > 0.0);
     menu.addSubMenu ("Edit", editMenu);
     menu.addSeparator();
 
@@ -523,7 +568,7 @@ void WaveformDisplay::showContextMenu (const juce::MouseEvent& event)
     menu.addItem (3, "Clear Selection", hasSelection());
     menu.addSeparator();
     menu.addItem (4, "Mark Click at Cursor");
-    menu.addItem (5, "Clear All Markers", !clickMarkers.empty());
+    menu.addItem (5, "Clear All Markers", !clickMarkers.empty() || (detectedClicks != nullptr && !detectedClicks->empty()));
     menu.addSeparator();
 
     // Options
@@ -545,7 +590,7 @@ void WaveformDisplay::showContextMenu (const juce::MouseEvent& event)
                 case 2: // Zoom to Selection
                     if (hasSelection())
                     {
-                        double totalLength = thumbnail.getTotalLength();
+                        double totalLength = getTotalLength();
                         double selStartTime = selectionStart / sampleRate;
                         double selEndTime = selectionEnd / sampleRate;
                         double selDuration = selEndTime - selStartTime;
@@ -573,7 +618,7 @@ void WaveformDisplay::showContextMenu (const juce::MouseEvent& event)
 
                 case 4: // Mark Click at Cursor
                     {
-                        double totalLength = thumbnail.getTotalLength();
+                        double totalLength = getTotalLength();
                         double visibleDuration = totalLength / horizontalZoom;
                         double startTime = scrollPosition * (totalLength - visibleDuration);
                         // Use the position where context menu was triggered
@@ -604,11 +649,11 @@ void WaveformDisplay::showContextMenu (const juce::MouseEvent& event)
 
 void WaveformDisplay::mouseDoubleClick (const juce::MouseEvent& event)
 {
-    if (thumbnail.getTotalLength() <= 0.0)
+    if (getTotalLength() <= 0.0)
         return;
 
     // Calculate position in file (0.0 to 1.0)
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
     double clickTime = (event.position.x / (double) getWidth()) * totalLength;
     double position = clickTime / totalLength;
 
@@ -621,7 +666,7 @@ void WaveformDisplay::mouseDoubleClick (const juce::MouseEvent& event)
 
 void WaveformDisplay::mouseWheelMove (const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel)
 {
-    if (thumbnail.getTotalLength() <= 0.0)
+    if (getTotalLength() <= 0.0)
         return;
 
     if (!event.mods.isCtrlDown() && !event.mods.isCommandDown() && !event.mods.isShiftDown())
@@ -632,7 +677,7 @@ void WaveformDisplay::mouseWheelMove (const juce::MouseEvent& event, const juce:
             getSelection (selStart, selEnd);
             if (selStart >= 0 && selEnd > selStart)
             {
-                double totalLength = thumbnail.getTotalLength();
+                double totalLength = getTotalLength();
                 double selectionMidTime = ((selStart + selEnd) * 0.5) / sampleRate;
                 double zoomFactor = wheel.deltaY > 0 ? 1.25 : 0.8;
                 double newZoom = juce::jlimit (1.0, 100.0, horizontalZoom * zoomFactor);
@@ -663,7 +708,7 @@ void WaveformDisplay::mouseWheelMove (const juce::MouseEvent& event, const juce:
         double mouseXFraction = event.position.x / (double) getWidth();
 
         // Calculate current view parameters
-        double totalLength = thumbnail.getTotalLength();
+        double totalLength = getTotalLength();
         double visibleDuration = totalLength / horizontalZoom;
         double viewStartTime = scrollPosition * juce::jmax (0.001, totalLength - visibleDuration);
         double mouseTime = viewStartTime + mouseXFraction * visibleDuration;
@@ -710,8 +755,14 @@ void WaveformDisplay::mouseWheelMove (const juce::MouseEvent& event, const juce:
 
 void WaveformDisplay::changeListenerCallback (juce::ChangeBroadcaster* source)
 {
-    if (source == &thumbnail)
-        repaint();
+    // Spectral tiles completed or invalidated
+    if (source == spectrogramCache.get())
+    {
+        spectrogramNeedsUpdate = true;
+
+        if (showSpectralView)
+            repaint();
+    }
 }
 
 void WaveformDisplay::timerCallback()
@@ -723,7 +774,7 @@ void WaveformDisplay::timerCallback()
 void WaveformDisplay::drawWaveform (juce::Graphics& g, const juce::Rectangle<int>& bounds)
 {
     // Calculate visible range based on zoom and scroll
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
 
     if (totalLength <= 0.0)
         return;
@@ -737,19 +788,71 @@ void WaveformDisplay::drawWaveform (juce::Graphics& g, const juce::Rectangle<int
     endTime = juce::jmin (totalLength, endTime);
 
     // Draw waveform with zoom applied
-    g.setColour (juce::Colour (0xff88bb88)); // Reaper-like green waveform
-    thumbnail.drawChannels (g, bounds, startTime, endTime, verticalZoom);
+    drawPeaks (g, bounds, startTime, endTime, juce::Colour (0xff88bb88), true); // Reaper-like green waveform
+}
+
+void WaveformDisplay::drawPeaks (juce::Graphics& g, juce::Rectangle<int> area, double startTime, double endTime,
+                                 juce::Colour colour, bool showRms)
+{
+    const juce::ScopedLock sl (peaksLock);
+    const int numChannels = peaks.getNumChannels();
+
+    if (numChannels == 0 || area.isEmpty())
+        return;
+
+    // Deep zooms read the samples themselves when the buffer is the one shown
+    const auto* source = (mainAudioBuffer != nullptr && mainAudioBuffer->getNumSamples() == peaks.getNumSamples())
+                             ? mainAudioBuffer : nullptr;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto lane = area.removeFromTop (area.getHeight() / (numChannels - channel)).toFloat();
+        const float centre = lane.getCentreY();
+        const float halfHeight = lane.getHeight() * 0.5f * (float) verticalZoom;
+
+        peaks.getColumns (channel, startTime * sampleRate, endTime * sampleRate, (int) lane.getWidth(),
+                          columnPeaks, columnLengths, source);
+
+        juce::RectangleList<float> peakRects, rmsRects;
+
+        for (size_t x = 0; x < columnPeaks.size(); ++x)
+        {
+            if (columnLengths[x] <= 0)
+                continue;
+
+            const auto& peak = columnPeaks[x];
+            const float top = juce::jlimit (lane.getY(), lane.getBottom(), centre - peak.maximum * halfHeight);
+            const float bottom = juce::jlimit (lane.getY(), lane.getBottom(), centre - peak.minimum * halfHeight);
+            const float columnX = lane.getX() + (float) x;
+            peakRects.addWithoutMerging ({ columnX, top, 1.0f, juce::jmax (1.0f, bottom - top) });
+
+            if (showRms)
+            {
+                const float rms = juce::jmin (std::sqrt (peak.sumOfSquares / (float) columnLengths[x]) * halfHeight, lane.getHeight() * 0.5f);
+                rmsRects.addWithoutMerging ({ columnX, centre - rms, 1.0f, rms * 2.0f });
+            }
+        }
+
+        g.setColour (colour);
+        g.fillRectList (peakRects);
+
+        if (showRms)
+        {
+            g.setColour (colour.brighter (0.4f));
+            g.fillRectList (rmsRects);
+        }
+    }
 }
 
 void WaveformDisplay::drawTimeRuler (juce::Graphics& g, const juce::Rectangle<int>& bounds)
 {
-    if (thumbnail.getTotalLength() <= 0.0)
+    if (getTotalLength() <= 0.0)
         return;
 
     g.setColour (juce::Colour (0xff232323));
     g.fillRect (bounds);
 
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
     double visibleDuration = totalLength / horizontalZoom;
     double startTime = scrollPosition * (totalLength - visibleDuration);
     startTime = juce::jmax (0.0, startTime);
@@ -814,10 +917,11 @@ void WaveformDisplay::drawTimeRuler (juce::Graphics& g, const juce::Rectangle<in
 
 void WaveformDisplay::drawClickMarkers (juce::Graphics& g, const juce::Rectangle<int>& bounds)
 {
-    if (thumbnail.getTotalLength() <= 0.0 || clickMarkers.empty())
+    const bool hasDetectedClicks = detectedClicks != nullptr && !detectedClicks->empty();
+    if (getTotalLength() <= 0.0 || (clickMarkers.empty() && !hasDetectedClicks))
         return;
 
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
     double visibleDuration = totalLength / horizontalZoom;
     double startTime = scrollPosition * (totalLength - visibleDuration);
     startTime = juce::jmax (0.0, startTime);
@@ -825,12 +929,12 @@ void WaveformDisplay::drawClickMarkers (juce::Graphics& g, const juce::Rectangle
 
     g.setColour (juce::Colours::red.withAlpha (0.7f));
 
-    for (auto markerSample : clickMarkers)
-    {
-        double markerTime = markerSample / sampleRate;
-        if (markerTime < startTime || markerTime > endTime)
-            continue;
+    const auto firstMarker = std::lower_bound (clickMarkers.begin(), clickMarkers.end(), (int64_t) std::ceil (startTime * sampleRate));
+    const auto lastMarker = std::upper_bound (firstMarker, clickMarkers.end(), (int64_t) std::floor (endTime * sampleRate));
 
+    for (auto it = firstMarker; it != lastMarker; ++it)
+    {
+        double markerTime = *it / sampleRate;
         double posInView = (markerTime - startTime) / visibleDuration;
         float x = (float) (posInView * bounds.getWidth());
         g.drawVerticalLine ((int) x, (float) bounds.getY(), (float) bounds.getBottom());
@@ -838,14 +942,34 @@ void WaveformDisplay::drawClickMarkers (juce::Graphics& g, const juce::Rectangle
         // Draw small circle at marker
         g.fillEllipse (x - 3.0f, bounds.getCentreY() - 3.0f, 6.0f, 6.0f);
     }
+
+    if (!hasDetectedClicks || !detectedClicks->isSorted())
+        return;
+
+    // Detected clicks: only the visible range, at most one marker per pixel column
+    const auto first = detectedClicks->lowerBound ((int64_t) (startTime * sampleRate));
+    const auto last = detectedClicks->lowerBound ((int64_t) (endTime * sampleRate) + 1);
+    int lastX = std::numeric_limits<int>::min();
+
+    detectedClicks->forEach (first, last, [&] (size_t, int64_t markerSample, int, float, bool, bool)
+    {
+        double posInView = (markerSample / sampleRate - startTime) / visibleDuration;
+        int x = (int) (posInView * bounds.getWidth());
+        if (x == lastX)
+            return;
+
+        lastX = x;
+        g.drawVerticalLine (x, (float) bounds.getY(), (float) bounds.getBottom());
+        g.fillEllipse ((float) x - 3.0f, bounds.getCentreY() - 3.0f, 6.0f, 6.0f);
+    });
 }
 
 void WaveformDisplay::drawPlaybackCursor (juce::Graphics& g, const juce::Rectangle<int>& bounds)
 {
-    if (thumbnail.getTotalLength() <= 0.0)
+    if (getTotalLength() <= 0.0)
         return;
 
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
     double visibleDuration = totalLength / horizontalZoom;
     double startTime = scrollPosition * (totalLength - visibleDuration);
     startTime = juce::jmax (0.0, startTime);
@@ -864,11 +988,11 @@ void WaveformDisplay::drawPlaybackCursor (juce::Graphics& g, const juce::Rectang
 
 void WaveformDisplay::drawSelection (juce::Graphics& g, const juce::Rectangle<int>& bounds)
 {
-    if (selectionStart < 0 || selectionEnd < 0 || thumbnail.getTotalLength() <= 0.0)
+    if (selectionStart < 0 || selectionEnd < 0 || getTotalLength() <= 0.0)
         return;
 
     // Calculate visible range based on zoom
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
     double visibleDuration = totalLength / horizontalZoom;
     double startTime = scrollPosition * (totalLength - visibleDuration);
     startTime = juce::jmax (0.0, startTime);
@@ -909,7 +1033,7 @@ void WaveformDisplay::drawSelection (juce::Graphics& g, const juce::Rectangle<in
 
 void WaveformDisplay::drawSpectrogram (juce::Graphics& g, const juce::Rectangle<int>& bounds)
 {
-    double totalLength = thumbnail.getTotalLength();
+    double totalLength = getTotalLength();
     if (totalLength <= 0.0 || bounds.isEmpty()) return;
 
     double visibleDuration = totalLength / horizontalZoom;
@@ -928,9 +1052,9 @@ void WaveformDisplay::drawSpectrogram (juce::Graphics& g, const juce::Rectangle<
         juce::Graphics imgG (spectrogramImage);
         imgG.fillAll (juce::Colour (0xff050505));
 
-        if (mainAudioBuffer != nullptr && mainAudioBuffer->getNumSamples() > 0)
+        if (mainAudioBuffer != nullptr && mainAudioBuffer->getNumSamples() > 0 && spectrogramCache != nullptr)
         {
-            // Real-time Spectral Analysis (Serato style)
+            // Spectral colour view (Serato style) from the shared magnitude tiles
             // Divide the visible area into vertical strips (bins)
             const int numStrips = lastWidth;
             const int64_t startSample = static_cast<int64_t>(startTime * sampleRate);
@@ -940,56 +1064,77 @@ void WaveformDisplay::drawSpectrogram (juce::Graphics& g, const juce::Rectangle<
 
             if (samplesPerStrip > 0)
             {
+                {
+                    const juce::ScopedLock sl (peaksLock);
+                    peaks.getColumns (0, startTime * sampleRate, endTime * sampleRate, numStrips,
+                                      columnPeaks, columnLengths, mainAudioBuffer);
+                }
+
+                const float centre = lastHeight * 0.5f;
+                const float halfHeight = centre * (float) verticalZoom;
+
+                // Bass below 250 Hz, mids up to 4 kHz, highs above
+                const int hop = SpectrogramTileCache::getHopForResolution ((double) samplesPerStrip);
+                const int numBins = spectrogramCache->getNumBins();
+                const double binWidth = sampleRate / spectrogramCache->getFftSize();
+                const int lowEnd = juce::jlimit (1, numBins, (int) (250.0 / binWidth));
+                const int midEnd = juce::jlimit (lowEnd, numBins, (int) (4000.0 / binWidth));
+
+                SpectrogramTileCache::TilePtr tile;
+                int64_t tileIndex = -1;
+
                 for (int x = 0; x < numStrips; ++x)
                 {
                     int64_t stripStart = startSample + (x * samplesPerStrip);
-                    int stripLen = (int)juce::jmin (samplesPerStrip, (int64_t)mainAudioBuffer->getNumSamples() - stripStart);
-                    
-                    if (stripLen <= 0) break;
-
-                    // Analyze frequency content of this strip (simplified)
-                    float lowEnergy = 0, midEnergy = 0, highEnergy = 0;
-                    
-                    // Sample every Nth sample for speed
-                    int step = juce::jmax(1, stripLen / 64); 
-                    const float* data = mainAudioBuffer->getReadPointer(0, (int)stripStart);
-                    
-                    float lastVal = 0;
-                    for (int i = 0; i < stripLen; i += step)
+
+                    if (stripStart >= (int64_t) mainAudioBuffer->getNumSamples()) break;
+
+                    const int64_t column = stripStart / hop;
+
+                    if (column / SpectrogramTileCache::columnsPerTile != tileIndex)
                     {
-                        float val = std::abs(data[i]);
-                        float diff = std::abs(data[i] - lastVal);
-                        
-                        // Heuristic: Diff is higher for high frequencies
-                        if (diff > val * 1.5f) highEnergy += val;
-                        else if (diff > val * 0.5f) midEnergy += val;
-                        else lowEnergy += val;
-                        
-                        lastVal = data[i];
+                        tileIndex = column / SpectrogramTileCache::columnsPerTile;
+                        tile = spectrogramCache->getTile (hop, tileIndex);
+                    }
+
+                    const int columnInTile = (int) (column % SpectrogramTileCache::columnsPerTile);
+                    juce::Colour stripColor (0xff303030);   // Not computed yet
+
+                    if (tile != nullptr && columnInTile < tile->getNumColumns())
+                    {
+                        const auto* levels = tile->getColumn (columnInTile);
+                        float lowEnergy = 0, midEnergy = 0, highEnergy = 0;
+
+                        for (int bin = 0; bin < lowEnd; ++bin)       lowEnergy += SpectrogramTileCache::toGain (levels[bin]);
+                        for (int bin = lowEnd; bin < midEnd; ++bin)  midEnergy += SpectrogramTileCache::toGain (levels[bin]);
+                        for (int bin = midEnd; bin < numBins; ++bin) highEnergy += SpectrogramTileCache::toGain (levels[bin]);
+
+                        // Map energy to Serato colors: Bass = Red, Mid = Green, High = Blue
+                        float total = lowEnergy + midEnergy + highEnergy + 0.001f;
+                        juce::uint8 r = (juce::uint8)juce::jlimit(0, 255, (int)(255 * lowEnergy / total * 1.2f));
+                        juce::uint8 g_col = (juce::uint8)juce::jlimit(0, 255, (int)(255 * midEnergy / total * 1.2f));
+                        juce::uint8 b = (juce::uint8)juce::jlimit(0, 255, (int)(255 * highEnergy / total * 1.2f));
+                        stripColor = juce::Colour(r, g_col, b);
                     }
 
-                    // Map energy to Serato colors: Bass = Red, Mid = Green, High = Blue
-                    float total = lowEnergy + midEnergy + highEnergy + 0.001f;
-                    juce::uint8 r = (juce::uint8)juce::jlimit(0, 255, (int)(255 * lowEnergy / total * 1.2f));
-                    juce::uint8 g_col = (juce::uint8)juce::jlimit(0, 255, (int)(255 * midEnergy / total * 1.2f));
-                    juce::uint8 b = (juce::uint8)juce::jlimit(0, 255, (int)(255 * highEnergy / total * 1.2f));
-                    
-                    juce::Colour stripColor = juce::Colour(r, g_col, b);
                     imgG.setColour(stripColor);
-                    
-                    // Draw just this vertical strip of the thumbnail
-                    thumbnail.drawChannel(imgG, juce::Rectangle<int>(x, 0, 1, lastHeight), 
-                                         startTime + (x * visibleDuration / numStrips),
-                                         startTime + ((x + 1) * visibleDuration / numStrips),
-                                         0, verticalZoom);
+
+                    // Draw just this vertical strip of the overview
+                    if (x < (int) columnPeaks.size() && columnLengths[(size_t) x] > 0)
+                    {
+                        const auto& peak = columnPeaks[(size_t) x];
+                        const float top = juce::jlimit (0.0f, (float) lastHeight, centre - peak.maximum * halfHeight);
+                        const float bottom = juce::jlimit (0.0f, (float) lastHeight, centre - peak.minimum * halfHeight);
+                        imgG.fillRect ((float) x, top, 1.0f, juce::jmax (1.0f, bottom - top));
+                    }
                 }
             }
         }
         else
         {
             // Fallback to gradient if no buffer access
-            imgG.setColour (juce::Colours::orange.withAlpha (0.8f));
-            thumbnail.drawChannels (imgG, juce::Rectangle<int>(0, 0, lastWidth, lastHeight), startTime, endTime, verticalZoom);
+            drawPeaks (imgG, juce::Rectangle<int>(0, 0, lastWidth, lastHeight), startTime, endTime,
+                       juce::Colours::orange.withAlpha (0.8f), false);
         }
         
         // Horizontal analyzer lines
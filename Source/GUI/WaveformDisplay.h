@@ -3,12 +3,16 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_opengl/juce_opengl.h>
+#include "../DSP/ClickEvents.h"
+#include "../Utils/PeakPyramid.h"
+#include "../Utils/SpectrogramTileCache.h"
+#include <memory>
 
 /**
  * Waveform Display Component
  *
  * Displays audio waveform with:
- * - Zoomable view (horizontal and vertical)
+ * - Zoomable view (horizontal and vertical), drawn from a peak pyramid
  * - Overlay of corrected vs uncorrected waveforms
  * - Visual markers for clicks, track boundaries, cue points
  * - Playback cursor
@@ -30,7 +34,10 @@ public:
     void filesDropped (const juce::StringArray& files, int x, int y) override;
 
     //==============================================================================
-    /** Load audio file into waveform display */
+    /**
+     * Names the file the next updateFromBuffer() buffer was decoded from, so
+     * the overview comes from the file's peak sidecar when it still matches
+     */
     void loadFile (const juce::File& file);
 
     /** Clear waveform */
@@ -45,16 +52,25 @@ public:
     /** Clear all click markers */
     void clearClickMarkers();
 
+    /** Show detected clicks from a shared store (read in place, only the visible range is drawn) */
+    void setDetectedClicks (std::shared_ptr<const ClickStore> store);
+
     /** Update waveform from an audio buffer (after processing) */
     void updateFromBuffer (const juce::AudioBuffer<float>& buffer, double sampleRate);
 
+    /** Update only buffer[startSample, startSample + numSamples) after an edit; a changed length updates up to the end */
+    void updateRegion (const juce::AudioBuffer<float>& buffer, double sampleRate, int64_t startSample, int64_t numSamples);
+
     /** Link the main audio buffer for spectral analysis */
     void setAudioBuffer (const juce::AudioBuffer<float>* buffer) { mainAudioBuffer = buffer; spectrogramNeedsUpdate = true; }
 
-    /** Prepare the thumbnail for a new recording */
+    /** Spectral view columns, shared with the other views of the main audio buffer; edits invalidate their range */
+    void setSpectrogramCache (std::shared_ptr<SpectrogramTileCache> cache);
+
+    /** Prepare the overview for a new recording */
     void prepareForRecording (double sampleRate, int numChannels);
 
-    /** Add a block of samples to the thumbnail (for real-time recording view) */
+    /** Add a block of samples to the overview (for real-time recording view, from the audio thread) */
     void addBlock (const float** channelData, int numChannels, int numSamples);
 
     /** Set horizontal zoom level (samples per pixel) */
@@ -81,6 +97,9 @@ public:
     /** Set callback for clipboard operations (cut/copy/paste/delete) */
     std::function<void(int actionId, int64_t start, int64_t end)> onClipboardAction;
 
+    /** Called after updateFromBuffer()/updateRegion() with the changed range; a negative count means to the end */
+    std::function<void(int64_t start, int64_t numSamples)> onAudioChanged;
+
     // Process action IDs for context menu
     enum ProcessActionID
     {
@@ -120,7 +139,7 @@ public:
     double getClipboardSampleRate() const { return clipboardSampleRate; }
 
     /** Get total number of samples (for select all) */
-    int64_t getTotalSamples() const { return static_cast<int64_t>(thumbnail.getTotalLength() * sampleRate); }
+    int64_t getTotalSamples() const { return static_cast<int64_t> (peaks.getNumSamples()); }
 
     //==============================================================================
     // Public access to zoom levels (for UI controls)
@@ -150,6 +169,12 @@ public:
     void timerCallback() override;
 
 private:
+    /** Length of the audio shown, in seconds */
+    double getTotalLength() const { return sampleRate > 0.0 ? static_cast<double> (peaks.getNumSamples()) / sampleRate : 0.0; }
+
+    /** Draws each channel's min/max (and RMS) in its own lane, one column per pixel */
+    void drawPeaks (juce::Graphics& g, juce::Rectangle<int> area, double startTime, double endTime,
+                    juce::Colour colour, bool showRms);
     void drawWaveform (juce::Graphics& g, const juce::Rectangle<int>& bounds);
     void drawSpectrogram (juce::Graphics& g, const juce::Rectangle<int>& bounds);
     void drawTimeRuler (juce::Graphics& g, const juce::Rectangle<int>& bounds);
@@ -159,20 +184,24 @@ private:
     void showContextMenu (const juce::MouseEvent& event);
 
     // Spectrogram cache
+    std::shared_ptr<SpectrogramTileCache> spectrogramCache;
     juce::Image spectrogramImage;
     bool spectrogramNeedsUpdate = true;
     double lastStartTime = -1.0, lastEndTime = -1.0;
     int lastWidth = -1, lastHeight = -1;
 
     //==============================================================================
-    juce::AudioFormatManager formatManager;
-    juce::AudioThumbnailCache thumbnailCache {10}; // Increased cache size for better performance
-    juce::AudioThumbnail thumbnail;
+    PeakPyramid peaks;
+    juce::CriticalSection peaksLock;            // The recorder appends from the audio thread
+    juce::File peakSourceFile;
+    std::vector<PeakPyramid::Peak> columnPeaks;
+    std::vector<int> columnLengths;
 
     double sampleRate = 44100.0;
     double playbackPosition = 0.0;
 
     std::vector<int64_t> clickMarkers;
+    std::shared_ptr<const ClickStore> detectedClicks;
 
     // Selection
     int64_t selectionStart = -1;
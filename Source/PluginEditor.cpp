@@ -77,6 +77,11 @@ AudioRestorationEditor::AudioRestorationEditor (AudioRestorationProcessor& p)
     clickBypassButton.setColour (juce::ToggleButton::textColourId, juce::Colours::lightgrey);
     addAndMakeVisible (clickBypassButton);
 
+    clickCountLabel.setText ("No clicks yet", juce::dontSendNotification);
+    clickCountLabel.setJustificationType (juce::Justification::centred);
+    clickCountLabel.setColour (juce::Label::textColourId, juce::Colours::lightgrey);
+    addAndMakeVisible (clickCountLabel);
+
     clickSensitivityAttachment = std::make_unique<SliderAttachment> (
         audioProcessor.getParameters(), "clickSensitivity", clickSensitivitySlider);
     clickBypassAttachment = std::make_unique<ButtonAttachment> (
@@ -178,6 +183,7 @@ AudioRestorationEditor::AudioRestorationEditor (AudioRestorationProcessor& p)
     // Spectrum Analyzer removed per user request
     // addAndMakeVisible (spectrumAnalyzer);
     // spectrumAnalyzer.toBack();
+    // spectrumAnalyzer.setSource (&audioProcessor.getVisualizationTap());
 
     eqBypassButton.setButtonText ("Bypass");
     eqBypassButton.setColour (juce::ToggleButton::textColourId, juce::Colours::lightgrey);
@@ -237,6 +243,16 @@ AudioRestorationEditor::AudioRestorationEditor (AudioRestorationProcessor& p)
         eqAttachments.push_back (std::move (attachment));
     }
 
+    // Band metering only runs while the editor is open
+    audioProcessor.getFilterBank().setMeteringEnabled (true);
+
+    // So do live click events; anything a previous editor left queued is stale
+    audioProcessor.getClickRemoval().getEventQueue().popAll ([] (const ClickEvent&) {});
+    audioProcessor.getClickRemoval().setPublishLiveEvents (true);
+
+    addAndMakeVisible (loadMeter);
+    loadMeter.setProfiler (&audioProcessor.getStageProfiler());
+
     // Start timer for visual feedback updates (20 Hz)
     startTimer (50);
 }
@@ -244,6 +260,8 @@ AudioRestorationEditor::AudioRestorationEditor (AudioRestorationProcessor& p)
 AudioRestorationEditor::~AudioRestorationEditor()
 {
     stopTimer();
+    audioProcessor.getFilterBank().setMeteringEnabled (false);
+    audioProcessor.getClickRemoval().setPublishLiveEvents (false);
     settingsButton.removeListener (this);
 
     // Reset LookAndFeel to avoid dangling pointers
@@ -291,6 +309,16 @@ void AudioRestorationEditor::paint (juce::Graphics& g)
 
 void AudioRestorationEditor::timerCallback()
 {
+    // Drain the clicks detected since the last tick, whether or not they still show
+    const int newClicks = audioProcessor.getClickRemoval().getEventQueue().popAll ([] (const ClickEvent&) {});
+
+    if (newClicks > 0)
+    {
+        liveClickCount += newClicks;
+        clickCountLabel.setText (juce::String (liveClickCount) + (liveClickCount == 1 ? " click" : " clicks"),
+                                 juce::dontSendNotification);
+    }
+
     // Update Click Removal glow intensity based on activity
     bool clickBypassed = *audioProcessor.getParameters().getRawParameterValue ("clickBypass") > 0.5f;
     float clickSensitivity = *audioProcessor.getParameters().getRawParameterValue ("clickSensitivity");
@@ -301,6 +329,10 @@ void AudioRestorationEditor::timerCallback()
         // Map click rate to glow intensity (0-10 clicks/sec -> 0.0-1.0)
         float intensity = juce::jlimit (0.0f, 1.0f, clickRate / 10.0f);
 
+        // A click in this tick flashes the knob even when the rate is low
+        if (newClicks > 0)
+            intensity = juce::jmax (intensity, 0.6f);
+
         // Smooth interpolation
         float currentIntensity = clickKnobLAF.getGlowIntensity();
         float smoothed = currentIntensity + (intensity - currentIntensity) * 0.2f;
@@ -426,11 +458,6 @@ void AudioRestorationEditor::timerCallback()
     }
 
     // Spectrum analyzer removed per user request
-    // const auto& vizBuffer = audioProcessor.getVisualizationBuffer();
-    // if (vizBuffer.getNumSamples() > 0)
-    // {
-    //     spectrumAnalyzer.pushAudioSamples (vizBuffer, vizBuffer.getNumSamples());
-    // }
     // spectrumAnalyzer.updateSpectrum();
 }
 
@@ -474,6 +501,7 @@ void AudioRestorationEditor::resized()
     auto scaleArea = titleArea.removeFromRight (180);
     scaleLabel.setBounds (scaleArea.removeFromLeft (70));
     scaleSelector.setBounds (scaleArea.removeFromLeft (100).reduced (0, 5));
+    loadMeter.setBounds (titleArea.removeFromRight (220).reduced (8, 10));
 
     // Difference mode toggle (global control)
     auto diffModeArea = area.removeFromTop (35);
@@ -503,6 +531,7 @@ void AudioRestorationEditor::resized()
     clickContent.removeFromTop (5); // Small gap after bypass
     clickSensitivitySlider.setBounds (clickContent.removeFromTop (100).withSizeKeepingCentre (100, 100));
     clickSensitivityLabel.setBounds (clickContent.removeFromTop (20));
+    clickCountLabel.setBounds (clickContent.removeFromTop (20));
 
     auto noiseArea = topRow.removeFromLeft (noiseWidth).reduced (5);
     noiseGroup.setBounds (noiseArea);
@@ -3,6 +3,7 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "PluginProcessor.h"
 #include "GUI/GlowingKnobLookAndFeel.h"
+#include "GUI/StageLoadMeter.h"
 // #include "GUI/SpectrumAnalyzer.h"  // Removed per user request
 
 //==============================================================================
@@ -55,12 +56,16 @@ private:
     juce::ToggleButton differenceModeButton;
     juce::Label differenceModeLabel;
     juce::TextButton settingsButton {"Settings"};
+    StageLoadMeter loadMeter;
+    juce::TooltipWindow tooltipWindow { this, 500 };   // For the load meter's per-stage breakdown
 
     // Click Removal Section
     juce::GroupComponent clickGroup;
     juce::Slider clickSensitivitySlider;
     juce::Label clickSensitivityLabel;
     juce::ToggleButton clickBypassButton;
+    juce::Label clickCountLabel;
+    juce::int64 liveClickCount = 0;    // Clicks drained from the live event queue since the editor opened
 
     // Noise Reduction Section
     juce::GroupComponent noiseGroup;
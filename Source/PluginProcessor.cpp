@@ -1,6 +1,7 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "Utils/SettingsManager.h"
+#include "Utils/RealtimeDiagnostics.h"
 
 //==============================================================================
 AudioRestorationProcessor::AudioRestorationProcessor()
@@ -23,10 +24,58 @@ AudioRestorationProcessor::AudioRestorationProcessor()
     humFilterParam = parameters.getRawParameterValue ("humFilter");
     aiDenoiseEnableParam = parameters.getRawParameterValue ("aiDenoiseEnable");
     aiDenoiseMixParam = parameters.getRawParameterValue ("aiDenoiseMix");
+    noiseFftSizeParam = parameters.getRawParameterValue ("noiseFftSize");
+    noiseOverlapParam = parameters.getRawParameterValue ("noiseOverlap");
+    noiseMultiResParam = parameters.getRawParameterValue ("noiseMultiRes");
+    differenceModeParam = parameters.getRawParameterValue ("differenceMode");
+    clickBypassParam = parameters.getRawParameterValue ("clickBypass");
+    noiseBypassParam = parameters.getRawParameterValue ("noiseBypass");
+    rumbleBypassParam = parameters.getRawParameterValue ("rumbleBypass");
+    humBypassParam = parameters.getRawParameterValue ("humBypass");
+    eqBypassParam = parameters.getRawParameterValue ("eqBypass");
+
+    for (size_t i = 0; i < eqBandParams.size(); ++i)
+        eqBandParams[i] = parameters.getRawParameterValue ("eqBand" + juce::String (i));
+
+    parameters.addParameterListener ("noiseFftSize", this);
+    parameters.addParameterListener ("noiseOverlap", this);
+    parameters.addParameterListener ("noiseMultiRes", this);
+    parameters.addParameterListener ("aiDenoiseEnable", this);
+
+    // The model loads in the background; once it is ready the chain delay changes
+    onnxDenoiser.onSessionLoaded = [this] { latencyDirty.store (true); triggerAsyncUpdate(); };
+    providerBenchmark.onFinished = [this] (const SettingsManager::ProviderBenchmarkRecord&) { applyDenoiserSettings(); };
+
+    for (const auto& parameterID : getFilterParameterIDs())
+        parameters.addParameterListener (parameterID, this);
 }
 
 AudioRestorationProcessor::~AudioRestorationProcessor()
 {
+    parameters.removeParameterListener ("noiseFftSize", this);
+    parameters.removeParameterListener ("noiseOverlap", this);
+    parameters.removeParameterListener ("noiseMultiRes", this);
+    parameters.removeParameterListener ("aiDenoiseEnable", this);
+
+    for (const auto& parameterID : getFilterParameterIDs())
+        parameters.removeParameterListener (parameterID, this);
+
+    cancelPendingUpdate();
+}
+
+const juce::StringArray& AudioRestorationProcessor::getFilterParameterIDs()
+{
+    static const juce::StringArray ids = []
+    {
+        juce::StringArray result { "rumbleFilter", "rumbleBypass", "humFilter", "humBypass", "eqBypass" };
+
+        for (int i = 0; i < 10; ++i)
+            result.add ("eqBand" + juce::String (i));
+
+        return result;
+    }();
+
+    return ids;
 }
 
 //==============================================================================
@@ -71,6 +120,25 @@ juce::AudioProcessorValueTreeState::ParameterLayout AudioRestorationProcessor::c
         "Noise Bypass",
         false));
 
+    // Longer FFTs resolve low-frequency hum and rumble better but add latency
+    layout.add (std::make_unique<juce::AudioParameterChoice> (
+        "noiseFftSize",
+        "Noise FFT Size",
+        juce::StringArray { "256", "512", "1024", "2048", "4096", "8192" },
+        3));
+
+    layout.add (std::make_unique<juce::AudioParameterChoice> (
+        "noiseOverlap",
+        "Noise Overlap",
+        juce::StringArray { "75%", "50%" },
+        0));
+
+    // Long FFT below the crossover, short FFT above it for sharper transients
+    layout.add (std::make_unique<juce::AudioParameterBool> (
+        "noiseMultiRes",
+        "Noise Multi-Resolution",
+        false));
+
     // AI denoise parameters
     layout.add (std::make_unique<juce::AudioParameterBool> (
         "aiDenoiseEnable",
@@ -169,7 +237,8 @@ bool AudioRestorationProcessor::isMidiEffect() const
 
 double AudioRestorationProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // Everything still buffered in the lookahead, STFT and model FIFOs plays out after the input stops
+    return lastSampleRate > 0.0 ? getLatencySamples() / lastSampleRate : 0.0;
 }
 
 int AudioRestorationProcessor::getNumPrograms()
@@ -209,10 +278,24 @@ void AudioRestorationProcessor::prepareToPlay (double sampleRate, int samplesPer
 
     // Prepare DSP modules
     clickRemoval.prepare (spec);
+    applyNoiseResolution();
     noiseReduction.prepare (spec);
     filterBank.prepare (spec);
+    applyFilterParameters();
+
+    dryDelay.prepare (spec);
+    stageProfiler.prepare (sampleRate);
+    visualizationTap.prepare (sampleRate);
+
+    // Scratch for processBlock, so no stage allocates on the audio thread
+    const int scratchChannels = juce::jmax (getTotalNumInputChannels(), getTotalNumOutputChannels());
+    dryBuffer.setSize (scratchChannels, samplesPerBlock);
+
     applyDenoiserSettings();
     onnxDenoiser.prepare (sampleRate, getTotalNumOutputChannels(), samplesPerBlock);
+
+    // After the denoiser, whose latency depends on the sample rate and the loaded model
+    updateLatency();
 }
 
 void AudioRestorationProcessor::releaseResources()
@@ -221,23 +304,127 @@ void AudioRestorationProcessor::releaseResources()
     noiseReduction.reset();
     filterBank.reset();
     onnxDenoiser.reset();
+    dryDelay.reset();
+
+   #if VRS_RT_DIAGNOSTICS
+    if (RealtimeDiagnostics::hasViolations())
+        juce::Logger::writeToLog ("Audio thread violations since prepareToPlay:\n" + RealtimeDiagnostics::getReport());
+
+    RealtimeDiagnostics::resetCounts();
+   #endif
 }
 
+void AudioRestorationProcessor::parameterChanged (const juce::String& parameterID, float)
+{
+    // May be called from the audio thread (host automation): only flag and defer
+    if (parameterID == "noiseFftSize" || parameterID == "noiseOverlap" || parameterID == "noiseMultiRes")
+        noiseResolutionDirty.store (true);
+    else if (parameterID == "aiDenoiseEnable")
+        latencyDirty.store (true);
+    else
+        filterParametersDirty.store (true);
+
+    triggerAsyncUpdate();
+}
+
+void AudioRestorationProcessor::handleAsyncUpdate()
+{
+    if (lastSampleRate <= 0.0)
+        return;
+
+    // Lock-free handoff to the filter bank, no need to suspend processing
+    if (filterParametersDirty.exchange (false))
+        applyFilterParameters();
+
+    const bool resolutionChanged = noiseResolutionDirty.exchange (false);
+    const bool stagesToggled = latencyDirty.exchange (false);
+
+    if (resolutionChanged || stagesToggled)
+    {
+        // Waits for the current processBlock to finish before touching the STFT
+        // or the difference-mode delay
+        suspendProcessing (true);
+
+        if (resolutionChanged)
+            applyNoiseResolution();
+
+        updateLatency();
+        dryDelay.reset();
+        suspendProcessing (false);
+    }
+}
+
+void AudioRestorationProcessor::applyNoiseResolution()
+{
+    static const int fftSizes[] = { 256, 512, 1024, 2048, 4096, 8192 };
+    const int sizeIndex = juce::jlimit (0, 5, juce::roundToInt (noiseFftSizeParam->load()));
+    const auto overlap = noiseOverlapParam->load() > 0.5f ? NoiseReduction::Overlap::percent50
+                                                          : NoiseReduction::Overlap::percent75;
+
+    noiseReduction.setResolution (fftSizes[sizeIndex], overlap, noiseMultiResParam->load() > 0.5f);
+}
+
+void AudioRestorationProcessor::applyFilterParameters()
+{
+    // The setters only redesign sections whose value actually moved
+    filterBank.setRumbleFilter (rumbleFilterParam->load(), rumbleBypassParam->load() > 0.5f);
+    filterBank.setHumFilter (humFilterParam->load(), humBypassParam->load() > 0.5f);
+
+    const bool eqBypass = eqBypassParam->load() > 0.5f;
+    for (size_t i = 0; i < eqBandParams.size(); ++i)
+        filterBank.setEQBand (static_cast<int> (i), eqBypass ? 0.0f : eqBandParams[i]->load());
+}
+
+void AudioRestorationProcessor::updateLatency()
+{
+    // Click removal and noise reduction always run (bypass keeps their delay),
+    // the AI stage only delays the signal while it is enabled and has a model
+    int latency = clickRemoval.getLatencySamples() + noiseReduction.getLatencySamples();
+
+    if (aiDenoiseEnableParam->load() > 0.5f && onnxDenoiser.isReady())
+        latency += onnxDenoiser.getLatencySamples();
+
+    if (latency != getLatencySamples())
+        setLatencySamples (latency);
+
+    dryDelay.setMaximumDelayInSamples (latency + 1);
+    dryDelay.setDelay (static_cast<float> (latency));
+}
+
 void AudioRestorationProcessor::applyDenoiserSettings()
 {
+    // Model loading is file I/O and session creation: keep it off the audio thread
+    const bool wasSuspended = isSuspended();
+    suspendProcessing (true);
+
     const auto settings = SettingsManager::getInstance().getDenoiseSettings();
+    OnnxDenoiser::setThreadingSettings ({ settings.intraOpThreads, settings.allowSpinning, settings.threadAffinity });
     onnxDenoiser.setPreferredProvider (OnnxDenoiser::providerFromString (settings.provider));
+    onnxDenoiser.setAutoProvider (ProviderBenchmarkRunner::getStoredWinner());
     onnxDenoiser.setAllowFallback (settings.allowFallback);
     onnxDenoiser.setDmlDeviceId (settings.dmlDeviceId);
     onnxDenoiser.setQnnBackendPath (settings.qnnBackendPath);
+    onnxDenoiser.setAsyncInference (settings.asyncInference);
 
     if (settings.modelPath.isNotEmpty())
         onnxDenoiser.setModelPath (juce::File (settings.modelPath));
     else
         onnxDenoiser.clearModelPath();
 
+    // First run, or the runtime, device or model changed: measure, then apply the winner
+    if (onnxDenoiser.getPreferredProvider() == OnnxDenoiser::Provider::autoSelect)
+        providerBenchmark.startIfNeeded (settings);
+
     if (lastSampleRate > 0.0 && lastBlockSize > 0)
+    {
         onnxDenoiser.prepare (lastSampleRate, lastNumChannels, lastBlockSize);
+
+        // A model that failed (or started) to load changes the chain delay
+        updateLatency();
+        dryDelay.reset();
+    }
+
+    suspendProcessing (wasSuspended);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -265,20 +452,47 @@ bool AudioRestorationProcessor::isBusesLayoutSupported (const BusesLayout& layou
 
 void AudioRestorationProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    const StageProfiler::ScopedBlock profiledBlock (stageProfiler, buffer.getNumSamples());
+    VRS_PROFILE_STAGE (stageProfiler, setup);
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+
+    // Scratch is sized for the prepared block size: split oversized host blocks instead of allocating
+    if (numSamples > lastBlockSize)
+    {
+        jassert (lastBlockSize > 0);
+
+        for (int start = 0; lastBlockSize > 0 && start < numSamples; start += lastBlockSize)
+        {
+            juce::AudioBuffer<float> section (buffer.getArrayOfWritePointers(), numChannels,
+                                              start, juce::jmin (lastBlockSize, numSamples - start));
+            processBlock (section, midiMessages);
+        }
+
+        return;
+    }
 
     // Clear any extra output channels
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+        buffer.clear (i, 0, numSamples);
 
     // Store original audio for difference mode
-    bool differenceModeEnabled = *parameters.getRawParameterValue ("differenceMode") > 0.5f;
-    juce::AudioBuffer<float> originalBuffer;
+    const bool differenceModeEnabled = differenceModeParam->load() > 0.5f;
     if (differenceModeEnabled)
     {
-        originalBuffer.makeCopyOf (buffer);
+        VRS_PROFILE_STAGE (stageProfiler, differenceMode);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            dryBuffer.copyFrom (channel, 0, buffer, channel, 0, numSamples);
+
+        auto dryBlock = juce::dsp::AudioBlock<float> (dryBuffer)
+                            .getSubsetChannelBlock (0, static_cast<size_t> (numChannels))
+                            .getSubBlock (0, static_cast<size_t> (numSamples));
+        juce::dsp::ProcessContextReplacing<float> dryContext (dryBlock);
+        dryDelay.process (dryContext);
     }
 
     // Create audio block for DSP processing
@@ -286,79 +500,67 @@ void AudioRestorationProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     juce::dsp::ProcessContextReplacing<float> context (block);
 
     // Processing chain:
-    // 1. Click removal (if enabled)
-    if (!*parameters.getRawParameterValue ("clickBypass"))
+    // 1. Click removal (always runs so the lookahead latency stays constant;
+    //    zero sensitivity only delays the signal)
     {
-        clickRemoval.setSensitivity (*clickSensitivityParam);
+        VRS_PROFILE_STAGE (stageProfiler, clickRemoval);
+        const bool clickBypassed = clickBypassParam->load() > 0.5f;
+        clickRemoval.setSensitivity (clickBypassed ? 0.0f : clickSensitivityParam->load());
         clickRemoval.process (context);
     }
 
-    // 2. Spectral noise reduction (if enabled)
-    if (!*parameters.getRawParameterValue ("noiseBypass"))
-    {
-        noiseReduction.setReduction (*noiseReductionParam);
-        noiseReduction.process (context);
-    }
-
-    // 2b. AI denoise (optional)
-    if (aiDenoiseEnableParam != nullptr && aiDenoiseEnableParam->load() > 0.5f)
-    {
-        onnxDenoiser.setEnabled (true);
-        onnxDenoiser.processBlock (buffer, aiDenoiseMixParam != nullptr ? aiDenoiseMixParam->load() : 1.0f);
-    }
-    else
-    {
-        onnxDenoiser.setEnabled (false);
-    }
-
-    // 3. Filter bank (rumble, hum, EQ)
-    bool rumbleBypass = *parameters.getRawParameterValue ("rumbleBypass") > 0.5f;
-    bool humBypass = *parameters.getRawParameterValue ("humBypass") > 0.5f;
-    bool eqBypass = *parameters.getRawParameterValue ("eqBypass") > 0.5f;
-
-    filterBank.setRumbleFilter (*rumbleFilterParam, rumbleBypass);
-    filterBank.setHumFilter (*humFilterParam, humBypass);
+    // 2. Spectral noise reduction (always runs so the STFT latency stays constant)
+    {
+        VRS_PROFILE_STAGE (stageProfiler, noiseReduction);
+        noiseReduction.setBypassed (noiseBypassParam->load() > 0.5f);
+        noiseReduction.setReduction (*noiseReductionParam);
+        noiseReduction.process (context);
+    }
 
-    // Update EQ bands and check if any are active (only if EQ not bypassed)
-    bool anyEQActive = false;
-    if (!eqBypass)
+    // 2b. AI denoise (optional). The model is loaded in prepareToPlay/applyDenoiserSettings,
+    //     never here; without a session the block passes through untouched
     {
-        for (int i = 0; i < 10; ++i)
+        VRS_PROFILE_STAGE (stageProfiler, aiDenoise);
+        if (aiDenoiseEnableParam != nullptr && aiDenoiseEnableParam->load() > 0.5f)
+        {
+            onnxDenoiser.setEnabled (true);
+            onnxDenoiser.processBlock (buffer, aiDenoiseMixParam != nullptr ? aiDenoiseMixParam->load() : 1.0f);
+        }
+        else
         {
-            auto paramID = "eqBand" + juce::String (i);
-            float gain = *parameters.getRawParameterValue (paramID);
-            filterBank.setEQBand (i, gain);
-            if (std::abs (gain) > 0.01f)
-                anyEQActive = true;
+            onnxDenoiser.setEnabled (false);
         }
     }
 
-    // ALWAYS measure band activity for visual feedback (regardless of bypass state)
-    filterBank.measureBandActivityForMetering (block);
-
-    // Only process filterbank if something is enabled
-    if (!rumbleBypass || !humBypass || anyEQActive)
+    // 3. Filter bank (rumble, hum, EQ). Coefficients are redesigned on the message
+    //    thread when a filter parameter moves (see applyFilterParameters); bypassed
+    //    sections and flat bands cost nothing here
     {
+        VRS_PROFILE_STAGE (stageProfiler, filterBank);
+        // Band activity for visual feedback (regardless of bypass state): a decimated
+        // copy for the metering thread, nothing at all while the editor is closed
+        filterBank.measureBandActivityForMetering (block);
         filterBank.process (context);
     }
 
     // Difference mode: output what was removed (original - processed)
     if (differenceModeEnabled)
     {
-        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        VRS_PROFILE_STAGE (stageProfiler, differenceMode);
+
+        for (int channel = 0; channel < numChannels; ++channel)
         {
             auto* processedData = buffer.getWritePointer (channel);
-            const auto* originalData = originalBuffer.getReadPointer (channel);
-
-            for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-            {
-                processedData[sample] = originalData[sample] - processedData[sample];
-            }
+            juce::FloatVectorOperations::subtract (processedData, dryBuffer.getReadPointer (channel), processedData, numSamples);
         }
     }
 
-    // Store a copy of the processed audio for spectrum analyzer visualization
-    visualizationBuffer.makeCopyOf (buffer);
+    // Summarise the processed audio for the meters and the spectrum analyzer
+    // (a few values per block into a wait-free ring; the FFTs run on the tap's own thread)
+    {
+        VRS_PROFILE_STAGE (stageProfiler, visualization);
+        visualizationTap.push (block);
+    }
 }
 
 //==============================================================================
@@ -6,6 +6,9 @@
 #include "DSP/NoiseReduction.h"
 #include "DSP/FilterBank.h"
 #include "DSP/OnnxDenoiser.h"
+#include "DSP/VisualizationTap.h"
+#include "Utils/ProviderBenchmarkRunner.h"
+#include "Utils/StageProfiler.h"
 
 //==============================================================================
 /**
@@ -18,7 +21,9 @@
  * - Hum and rumble filtering
  * - Graphic EQ
  */
-class AudioRestorationProcessor : public juce::AudioProcessor
+class AudioRestorationProcessor : public juce::AudioProcessor,
+                                  private juce::AudioProcessorValueTreeState::Listener,
+                                  private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -69,11 +74,25 @@ public:
     OnnxDenoiser& getOnnxDenoiser() { return onnxDenoiser; }
     void applyDenoiserSettings();
 
-    // Get audio for spectrum analyzer visualization
-    const juce::AudioBuffer<float>& getVisualizationBuffer() const { return visualizationBuffer; }
+    // Levels and spectrum of the output for the GUI, carried without a shared buffer
+    VisualizationTap& getVisualizationTap() { return visualizationTap; }
+
+    // Per-stage timing of processBlock, for the editor's load meter
+    StageProfiler& getStageProfiler() { return stageProfiler; }
 
 private:
     //==============================================================================
+    // Noise reduction resolution changes re-prepare the STFT, so they are applied
+    // on the message thread with processing suspended. Filter changes only
+    // redesign coefficients there; the filter bank glides to them on its own.
+    // Toggling the AI stage changes the chain latency reported to the host.
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+    void applyNoiseResolution();
+    void applyFilterParameters();
+    void updateLatency();
+    static const juce::StringArray& getFilterParameterIDs();
+
     // Parameter management
     juce::AudioProcessorValueTreeState parameters;
 
@@ -81,18 +100,42 @@ private:
     ClickRemoval clickRemoval;
     NoiseReduction noiseReduction;
     FilterBank filterBank;
-    OnnxDenoiser onnxDenoiser;
+    OnnxDenoiser onnxDenoiser;
+    ProviderBenchmarkRunner providerBenchmark;    // Auto mode's first-run provider measurement
+
+    // Aligns the dry signal with the processed (STFT-delayed) signal in difference mode
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> dryDelay;
+
+    StageProfiler stageProfiler;
 
     // Parameter listeners
     std::atomic<float>* clickSensitivityParam = nullptr;
     std::atomic<float>* noiseReductionParam = nullptr;
+    std::atomic<float>* noiseFftSizeParam = nullptr;
+    std::atomic<float>* noiseOverlapParam = nullptr;
+    std::atomic<float>* noiseMultiResParam = nullptr;
     std::atomic<float>* rumbleFilterParam = nullptr;
     std::atomic<float>* humFilterParam = nullptr;
     std::atomic<float>* aiDenoiseEnableParam = nullptr;
     std::atomic<float>* aiDenoiseMixParam = nullptr;
+    std::atomic<float>* differenceModeParam = nullptr;
+    std::atomic<float>* clickBypassParam = nullptr;
+    std::atomic<float>* noiseBypassParam = nullptr;
+    std::atomic<float>* rumbleBypassParam = nullptr;
+    std::atomic<float>* humBypassParam = nullptr;
+    std::atomic<float>* eqBypassParam = nullptr;
+    std::array<std::atomic<float>*, 10> eqBandParams {};
+
+    // Set from parameterChanged (possibly the audio thread), consumed in handleAsyncUpdate
+    std::atomic<bool> noiseResolutionDirty { false };
+    std::atomic<bool> filterParametersDirty { false };
+    std::atomic<bool> latencyDirty { false };
 
-    // Audio buffer for spectrum analyzer visualization
-    juce::AudioBuffer<float> visualizationBuffer;
+    // Output levels and spectrum for the GUI
+    VisualizationTap visualizationTap;
+
+    // Dry copy for difference mode, sized in prepareToPlay
+    juce::AudioBuffer<float> dryBuffer;
 
     double lastSampleRate = 0.0;
     int lastBlockSize = 0;
@@ -1,10 +1,46 @@
 #include "BatchProcessor.h"
 #include "../Utils/AudioFileManager.h"
+#include "../Utils/RenderCache.h"
+#include "../Utils/StageProfiler.h"
 #include "../DSP/ClickRemoval.h"
+#include "../DSP/Decrackle.h"
 #include "../DSP/NoiseReduction.h"
 #include "../DSP/FilterBank.h"
+#include "../DSP/OfflineChain.h"
 #include <juce_events/juce_events.h>
+#include <algorithm>
+#include <type_traits>
 
+namespace
+{
+    constexpr int chainBlockSize = 2048;    // Samples each stage processes at a time, small enough to stay in cache
+}
+
+//==============================================================================
+/** One worker's processors, prepared again for every file it takes */
+struct BatchProcessor::WorkerChain
+{
+    ClickRemoval clickRemoval;
+    Decrackle decrackle;
+    NoiseReduction noiseReduction;
+    FilterBank filterBank;
+    int workerIndex = 0;
+    double passStart = 0.0;                  // Share of the file's progress done before the current render
+    double passShare = 1.0;                  // Share the current render covers
+    juce::StringArray notes;                 // For the log line of the file being processed
+};
+
+namespace
+{
+    juce::String formatPosition (juce::int64 sample, double sampleRate)
+    {
+        const double seconds = sample / sampleRate;
+        const int minutes = static_cast<int> (seconds / 60.0);
+        return juce::String (minutes) + ":" + juce::String (seconds - minutes * 60.0, 1).paddedLeft ('0', 4);
+    }
+}
+
+//==============================================================================
 BatchProcessor::BatchProcessor()
     : juce::Thread ("BatchProcessorThread")
 {
@@ -12,7 +48,9 @@ BatchProcessor::BatchProcessor()
 
 BatchProcessor::~BatchProcessor()
 {
-    stopThread (5000); // Wait up to 5 seconds for thread to finish
+    // Workers stop at their next cancellation check; the pool must not outlive run()
+    shouldCancel = true;
+    stopThread (-1);
 }
 
 void BatchProcessor::addFile (const juce::File& file)
@@ -35,6 +73,107 @@ int BatchProcessor::getQueueSize() const
     return static_cast<int> (fileQueue.size());
 }
 
+//==============================================================================
+BatchProcessor::Settings BatchProcessor::settingsFromVar (const juce::var& preset, const Settings& defaults)
+{
+    Settings settings = defaults;
+
+    auto* object = preset.getDynamicObject();
+    if (object == nullptr)
+        return settings;
+
+    auto read = [object] (const char* name, auto& value)
+    {
+        const juce::Identifier id (name);
+
+        if (object->hasProperty (id))
+            value = static_cast<std::remove_reference_t<decltype (value)>> (object->getProperty (id));
+    };
+
+    read ("clickRemoval", settings.clickRemoval);
+    read ("clickSensitivity", settings.clickSensitivity);
+    read ("decrackle", settings.decrackle);
+    read ("decrackleFactor", settings.decrackleFactor);
+    read ("decrackleWidth", settings.decrackleWidth);
+    read ("noiseReduction", settings.noiseReduction);
+    read ("noiseReductionDB", settings.noiseReductionDB);
+    read ("profileFromQuietest", settings.profileFromQuietest);
+    read ("profileRegions", settings.profileRegions);
+    read ("profileRegionSeconds", settings.profileRegionSeconds);
+    read ("aiDenoise", settings.aiDenoise);
+    read ("aiAllowFallback", settings.aiAllowFallback);
+    read ("rumbleFilter", settings.rumbleFilter);
+    read ("rumbleFreq", settings.rumbleFreq);
+    read ("humFilter", settings.humFilter);
+    read ("humFreq", settings.humFreq);
+    read ("normalize", settings.normalize);
+    read ("normalizeDB", settings.normalizeDB);
+    read ("detectTracks", settings.detectTracks);
+    read ("outputBitDepth", settings.outputBitDepth);
+    read ("numWorkers", settings.numWorkers);
+    read ("streaming", settings.streaming);
+    read ("cacheIntermediates", settings.cacheIntermediates);
+    read ("cacheLimitMB", settings.cacheLimitMB);
+
+    if (object->hasProperty ("aiProvider"))
+        settings.aiProvider = object->getProperty ("aiProvider").toString();
+
+    if (object->hasProperty ("aiModelPath"))
+        settings.aiModelPath = object->getProperty ("aiModelPath").toString();
+
+    if (object->hasProperty ("outputDirectory"))
+    {
+        const auto path = object->getProperty ("outputDirectory").toString();
+        settings.outputDirectory = path.isNotEmpty() ? juce::File (path) : juce::File();
+    }
+
+    if (object->hasProperty ("cacheDirectory"))
+    {
+        const auto path = object->getProperty ("cacheDirectory").toString();
+        settings.cacheDirectory = path.isNotEmpty() ? juce::File (path) : juce::File();
+    }
+
+    return settings;
+}
+
+juce::var BatchProcessor::settingsToVar (const Settings& settings)
+{
+    juce::DynamicObject::Ptr object = new juce::DynamicObject();
+
+    object->setProperty ("clickRemoval", settings.clickRemoval);
+    object->setProperty ("clickSensitivity", settings.clickSensitivity);
+    object->setProperty ("decrackle", settings.decrackle);
+    object->setProperty ("decrackleFactor", settings.decrackleFactor);
+    object->setProperty ("decrackleWidth", settings.decrackleWidth);
+    object->setProperty ("noiseReduction", settings.noiseReduction);
+    object->setProperty ("noiseReductionDB", settings.noiseReductionDB);
+    object->setProperty ("profileFromQuietest", settings.profileFromQuietest);
+    object->setProperty ("profileRegions", settings.profileRegions);
+    object->setProperty ("profileRegionSeconds", settings.profileRegionSeconds);
+    object->setProperty ("aiDenoise", settings.aiDenoise);
+    object->setProperty ("aiProvider", settings.aiProvider);
+    object->setProperty ("aiAllowFallback", settings.aiAllowFallback);
+    object->setProperty ("aiModelPath", settings.aiModelPath);
+    object->setProperty ("rumbleFilter", settings.rumbleFilter);
+    object->setProperty ("rumbleFreq", settings.rumbleFreq);
+    object->setProperty ("humFilter", settings.humFilter);
+    object->setProperty ("humFreq", settings.humFreq);
+    object->setProperty ("normalize", settings.normalize);
+    object->setProperty ("normalizeDB", settings.normalizeDB);
+    object->setProperty ("detectTracks", settings.detectTracks);
+    object->setProperty ("outputBitDepth", settings.outputBitDepth);
+    object->setProperty ("outputDirectory", settings.outputDirectory == juce::File() ? juce::String()
+                                                                                   : settings.outputDirectory.getFullPathName());
+    object->setProperty ("numWorkers", settings.numWorkers);
+    object->setProperty ("streaming", settings.streaming);
+    object->setProperty ("cacheDirectory", settings.cacheDirectory == juce::File() ? juce::String()
+                                                                                 : settings.cacheDirectory.getFullPathName());
+    object->setProperty ("cacheIntermediates", settings.cacheIntermediates);
+    object->setProperty ("cacheLimitMB", settings.cacheLimitMB);
+
+    return juce::var (object.get());
+}
+
 void BatchProcessor::startProcessing (const Settings& settings)
 {
     if (isThreadRunning())
@@ -45,6 +184,18 @@ void BatchProcessor::startProcessing (const Settings& settings)
 
     currentSettings = settings;
     shouldCancel = false;
+
+    if (settings.aiDenoise)
+    {
+        denoiser.setPreferredProvider (OnnxDenoiser::providerFromString (settings.aiProvider));
+        denoiser.setAllowFallback (settings.aiAllowFallback);
+
+        if (settings.aiModelPath.isNotEmpty())
+            denoiser.setModelPath (juce::File (settings.aiModelPath));
+        else
+            denoiser.clearModelPath();
+    }
+
     startThread();
     DBG ("Batch processing started with " + juce::String (fileQueue.size()) + " files");
 }
@@ -58,144 +209,419 @@ void BatchProcessor::cancelProcessing()
 
 void BatchProcessor::run()
 {
-    int totalFiles = static_cast<int> (fileQueue.size());
-    int successCount = 0;
-    int failureCount = 0;
+    const int totalFiles = static_cast<int> (fileQueue.size());
+    const int requestedWorkers = currentSettings.numWorkers > 0 ? currentSettings.numWorkers
+                                                                : juce::SystemStats::getNumCpus();
+    const int numWorkers = juce::jlimit (1, juce::jmax (1, totalFiles), requestedWorkers);
+
+    nextFileIndex = 0;
+    successCount = 0;
+    failureCount = 0;
 
-    for (int i = 0; i < totalFiles; ++i)
     {
-        if (threadShouldExit() || shouldCancel)
+        const juce::ScopedLock sl (progressLock);
+        fileProgress.assign (static_cast<size_t> (totalFiles), 0.0f);
+        fileLog.assign (static_cast<size_t> (totalFiles), {});
+        progressSum = 0.0f;
+        filesCompleted = 0;
+    }
+
+    renderCache.reset();
+    if (currentSettings.cacheDirectory != juce::File())
+        renderCache = std::make_unique<RenderCache> (currentSettings.cacheDirectory);
+
+    trace.reset();
+    if (currentSettings.traceFile != juce::File())
+        trace = std::make_unique<TraceRecorder>();
+
+    workerChains.clear();
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workerChains.push_back (std::make_unique<WorkerChain>());
+        workerChains.back()->workerIndex = i;
+    }
+
+    DBG ("Batch processing " + juce::String (totalFiles) + " files on " + juce::String (numWorkers) + " workers");
+
+    if (numWorkers == 1)
+    {
+        processQueue (0);
+    }
+    else
+    {
+        juce::ThreadPool pool (numWorkers);
+
+        for (int i = 0; i < numWorkers; ++i)
+            pool.addJob ([this, i]
+            {
+                processQueue (i);
+                return juce::ThreadPoolJob::jobHasFinished;
+            });
+
+        // Stopping this thread cancels the workers; the pool is joined before it goes out of scope
+        while (pool.getNumJobs() > 0)
         {
-            notifyCompletion (false, "Batch processing cancelled");
+            if (threadShouldExit())
+                shouldCancel = true;
+
+            wait (50);
+        }
+    }
+
+    workerChains.clear();
+
+    // Written even for a cancelled run, which is often the one worth looking at
+    if (trace != nullptr)
+    {
+        if (!trace->writeTo (currentSettings.traceFile))
+            DBG ("Could not write the trace: " + currentSettings.traceFile.getFullPathName());
+
+        trace.reset();
+    }
+
+    if (renderCache != nullptr)
+    {
+        renderCache->trim (static_cast<juce::int64> (juce::jmax (0, currentSettings.cacheLimitMB)) * 1024 * 1024);
+        renderCache.reset();
+    }
+
+    if (threadShouldExit() || shouldCancel)
+    {
+        notifyCompletion (false, "Batch processing cancelled");
+        return;
+    }
+
+    juce::String message = "Batch processing complete: " +
+                           juce::String (successCount.load()) + " succeeded, " +
+                           juce::String (failureCount.load()) + " failed";
+
+    notifyCompletion (failureCount == 0, message);
+}
+
+void BatchProcessor::processQueue (int workerIndex)
+{
+    const int totalFiles = static_cast<int> (fileQueue.size());
+    auto& chain = *workerChains[static_cast<size_t> (workerIndex)];
+
+    // Files are handed out in queue order, one at a time, to whichever worker is free
+    for (int i = nextFileIndex++; i < totalFiles; i = nextFileIndex++)
+    {
+        if (shouldCancel || threadShouldExit())
+        {
+            shouldCancel = true;
             return;
         }
 
-        const juce::File& inputFile = fileQueue[i];
+        const juce::File& inputFile = fileQueue[static_cast<size_t> (i)];
+        reportFileProgress (i, workerIndex, 0.0f, "Processing: " + inputFile.getFileName());
+
+        chain.notes.clear();
+        bool succeeded = false;
+
+        {
+            const TraceRecorder::ScopedEvent fileEvent (trace.get(), inputFile.getFileName(), "file", workerIndex);
+            succeeded = processFile (inputFile, currentSettings, i, chain);
+        }
 
-        ProgressInfo info;
-        info.currentFileIndex = i + 1;
-        info.totalFiles = totalFiles;
-        info.currentFileName = inputFile.getFileName();
-        info.progress = static_cast<float> (i) / static_cast<float> (totalFiles);
-        info.status = "Processing: " + inputFile.getFileName();
-        notifyProgress (info);
+        if (shouldCancel)
+            return;
 
-        if (processFile (inputFile, currentSettings, i))
+        if (succeeded)
             successCount++;
         else
             failureCount++;
+
+        {
+            const juce::ScopedLock sl (progressLock);
+            fileLog[static_cast<size_t> (i)] = (succeeded ? "Finished: " : "Failed: ") + inputFile.getFullPathName()
+                                             + (chain.notes.isEmpty() ? juce::String() : " (" + chain.notes.joinIntoString ("; ") + ")");
+        }
+
+        reportFileProgress (i, workerIndex, 1.0f, (succeeded ? "Finished: " : "Failed: ") + inputFile.getFileName());
     }
+}
 
-    juce::String message = "Batch processing complete: " +
-                           juce::String (successCount) + " succeeded, " +
-                           juce::String (failureCount) + " failed";
+juce::StringArray BatchProcessor::getLog() const
+{
+    juce::StringArray lines;
+    const juce::ScopedLock sl (progressLock);
 
-    notifyCompletion (failureCount == 0, message);
+    for (const auto& line : fileLog)
+        if (line.isNotEmpty())
+            lines.add (line);
+
+    return lines;
+}
+
+void BatchProcessor::reportFileProgress (int fileIndex, int workerIndex, float progress, const juce::String& status)
+{
+    ProgressInfo info;
+    info.currentFileIndex = fileIndex + 1;
+    info.totalFiles = static_cast<int> (fileQueue.size());
+    info.currentFileName = fileQueue[static_cast<size_t> (fileIndex)].getFileName();
+    info.fileProgress = progress;
+    info.workerIndex = workerIndex;
+    info.status = status.isNotEmpty() ? status : "Processing: " + info.currentFileName;
+
+    {
+        const juce::ScopedLock sl (progressLock);
+        auto& previous = fileProgress[static_cast<size_t> (fileIndex)];
+
+        // Stage callbacks come often; only whole percents of a file are passed on
+        if (status.isEmpty() && progress < previous + 0.01f)
+            return;
+
+        progressSum += progress - previous;
+        previous = progress;
+
+        if (progress >= 1.0f)
+            ++filesCompleted;
+
+        info.progress = juce::jlimit (0.0f, 1.0f, progressSum / static_cast<float> (info.totalFiles));
+        info.filesCompleted = filesCompleted;
+    }
+
+    notifyProgress (info);
 }
 
-bool BatchProcessor::processFile (const juce::File& inputFile, const Settings& settings, int /*fileIndex*/)
+bool BatchProcessor::processFile (const juce::File& inputFile, const Settings& settings, int fileIndex, WorkerChain& chain)
 {
     DBG ("Processing file " + juce::String (fileIndex + 1) + ": " + inputFile.getFullPathName());
 
-    // Load audio file
-    AudioFileManager fileManager;
-    juce::AudioBuffer<float> buffer;
-    double sampleRate = 0.0;
+    // Determine output file
+    juce::File outputFile;
+    if (settings.outputDirectory.isDirectory())
+    {
+        juce::String outputName = inputFile.getFileNameWithoutExtension() + "_processed.wav";
+        outputFile = settings.outputDirectory.getChildFile (outputName);
+    }
+    else
+    {
+        // Save next to original file
+        juce::String outputName = inputFile.getFileNameWithoutExtension() + "_processed.wav";
+        outputFile = inputFile.getSiblingFile (outputName);
+    }
+
+    if (renderCache == nullptr || !renderCache->isValid())
+        return renderFile (inputFile, outputFile, settings, fileIndex, chain);
+
+    // Keyed by content, so a renamed or moved input still hits
+    const auto inputHash = RenderCache::hashFile (inputFile);
 
-    if (!fileManager.loadAudioFile (inputFile, buffer, sampleRate))
+    if (inputHash.isEmpty())
     {
         DBG ("Failed to load file: " + inputFile.getFullPathName());
         return false;
     }
 
-    int numChannels = buffer.getNumChannels();
-    int numSamples = buffer.getNumSamples();
+    const auto outputKey = RenderCache::makeKey (inputHash, getCacheDescription (settings));
 
-    // Configure DSP processing spec
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.numChannels = static_cast<juce::uint32> (numChannels);
-    spec.maximumBlockSize = 2048;
+    if (renderCache->fetch (outputKey, outputFile))
+    {
+        DBG ("Render cache hit: " + outputFile.getFullPathName());
+        chain.notes.add ("copied from the render cache");
+        return true;
+    }
 
-    const int blockSize = 2048;
+    // Restoration (click removal, decrackle, the denoisers) runs first and the
+    // finishing stages (filters, normalization) last, so they split cleanly
+    Settings restoration = settings;
+    restoration.rumbleFilter = restoration.humFilter = restoration.normalize = false;
+    restoration.outputBitDepth = 32;
 
-    // Apply Click & Pop Removal
-    if (settings.clickRemoval && !shouldCancel)
-    {
-        DBG ("Applying click removal...");
+    Settings finishing = settings;
+    finishing.clickRemoval = finishing.decrackle = finishing.noiseReduction = finishing.aiDenoise = false;
+
+    const bool hasRestoration = settings.clickRemoval || settings.decrackle || settings.noiseReduction || settings.aiDenoise;
+    const bool hasFinishing = settings.rumbleFilter || settings.humFilter || settings.normalize;
+    bool rendered = false;
 
-        ClickRemoval clickProcessor;
-        clickProcessor.prepare (spec);
-        clickProcessor.setSensitivity (settings.clickSensitivity);
-        clickProcessor.setRemovalMethod (ClickRemoval::Automatic);
+    if (settings.cacheIntermediates && hasRestoration && hasFinishing)
+    {
+        const auto restoredKey = RenderCache::makeKey (inputHash, getCacheDescription (restoration));
 
-        for (int startSample = 0; startSample < numSamples && !shouldCancel; startSample += blockSize)
+        if (!renderCache->contains (restoredKey))
         {
-            int samplesThisBlock = juce::jmin (blockSize, numSamples - startSample);
+            chain.passShare = 0.5;
 
-            juce::dsp::AudioBlock<float> block (buffer.getArrayOfWritePointers(),
-                                                static_cast<size_t> (numChannels),
-                                                static_cast<size_t> (startSample),
-                                                static_cast<size_t> (samplesThisBlock));
+            if (!renderCache->storeRendered (restoredKey, [&] (const juce::File& target)
+                                             { return renderFile (inputFile, target, restoration, fileIndex, chain); }))
+            {
+                chain.passShare = 1.0;
+                return false;
+            }
 
-            juce::dsp::ProcessContextReplacing<float> context (block);
-            clickProcessor.process (context);
+            chain.passStart = 0.5;
         }
+
+        rendered = renderFile (renderCache->useEntry (restoredKey), outputFile, finishing, fileIndex, chain);
+        chain.passStart = 0.0;
+        chain.passShare = 1.0;
+    }
+    else
+    {
+        rendered = renderFile (inputFile, outputFile, settings, fileIndex, chain);
     }
 
-    // Apply Noise Reduction
-    if (settings.noiseReduction && !shouldCancel)
+    if (rendered && !renderCache->store (outputKey, outputFile))
+        DBG ("Could not add to the render cache: " + outputFile.getFullPathName());
+
+    return rendered;
+}
+
+bool BatchProcessor::renderFile (const juce::File& inputFile, const juce::File& outputFile,
+                                 const Settings& settings, int fileIndex, WorkerChain& chain)
+{
+    // The AI denoiser's offline pass works on a whole buffer
+    if (settings.streaming && !settings.aiDenoise)
+        return processFileStreaming (inputFile, outputFile, settings, fileIndex, chain);
+
+    return processFileInMemory (inputFile, outputFile, settings, fileIndex, chain);
+}
+
+juce::String BatchProcessor::getCacheDescription (const Settings& settings)
+{
+    // Parameters of disabled stages, paths, worker counts and the cache's own
+    // settings leave the output as it is; streaming or not renders the same
+    const Settings defaults;
+    Settings canonical = settings;
+
+    if (!settings.clickRemoval)
+        canonical.clickSensitivity = defaults.clickSensitivity;
+
+    if (!settings.decrackle)
     {
-        DBG ("Applying noise reduction...");
+        canonical.decrackleFactor = defaults.decrackleFactor;
+        canonical.decrackleWidth = defaults.decrackleWidth;
+    }
+
+    if (!settings.noiseReduction)
+    {
+        canonical.noiseReductionDB = defaults.noiseReductionDB;
+        canonical.profileFromQuietest = defaults.profileFromQuietest;
+    }
+
+    if (!canonical.noiseReduction || !canonical.profileFromQuietest)
+    {
+        canonical.profileRegions = defaults.profileRegions;
+        canonical.profileRegionSeconds = defaults.profileRegionSeconds;
+    }
+
+    if (!settings.aiDenoise)
+    {
+        canonical.aiProvider = defaults.aiProvider;
+        canonical.aiAllowFallback = defaults.aiAllowFallback;
+        canonical.aiModelPath = defaults.aiModelPath;
+    }
+
+    if (!settings.rumbleFilter)
+        canonical.rumbleFreq = defaults.rumbleFreq;
 
-        NoiseReduction noiseProcessor;
-        noiseProcessor.prepare (spec);
-        noiseProcessor.setReduction (settings.noiseReductionDB);
+    if (!settings.humFilter)
+        canonical.humFreq = defaults.humFreq;
 
-        // Capture noise profile from first second of audio (assuming it contains noise)
-        noiseProcessor.captureProfile();
+    if (!settings.normalize)
+        canonical.normalizeDB = defaults.normalizeDB;
+
+    canonical.outputDirectory = defaults.outputDirectory;
+    canonical.numWorkers = defaults.numWorkers;
+    canonical.streaming = defaults.streaming;
+    canonical.cacheDirectory = defaults.cacheDirectory;
+    canonical.cacheIntermediates = defaults.cacheIntermediates;
+    canonical.cacheLimitMB = defaults.cacheLimitMB;
+
+    auto description = juce::JSON::toString (settingsToVar (canonical), true);
+
+    // A model replaced at the same path renders differently
+    if (settings.aiDenoise && settings.aiModelPath.isNotEmpty())
+    {
+        const juce::File model (settings.aiModelPath);
+        description << "\n" << model.getSize() << " " << model.getLastModificationTime().toMilliseconds();
+    }
+
+    return description;
+}
+
+void BatchProcessor::addChainStages (OfflineChain& offlineChain, WorkerChain& chain, const Settings& settings,
+                                     double sampleRate, int numChannels, juce::int64 length,
+                                     const FileAnalysis& analysis, bool beforeDenoiser)
+{
+    // Configure DSP processing spec
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.numChannels = static_cast<juce::uint32> (numChannels);
+    spec.maximumBlockSize = static_cast<juce::uint32> (chainBlockSize);
 
-        int profileSamples = juce::jmin (static_cast<int> (sampleRate), numSamples);
-        for (int startSample = 0; startSample < profileSamples && !shouldCancel; startSample += blockSize)
+    if (beforeDenoiser)
+    {
+        // Click & Pop Removal
+        if (settings.clickRemoval)
         {
-            int samplesThisBlock = juce::jmin (blockSize, profileSamples - startSample);
+            DBG ("Applying click removal...");
 
-            juce::dsp::AudioBlock<float> block (buffer.getArrayOfWritePointers(),
-                                                static_cast<size_t> (numChannels),
-                                                static_cast<size_t> (startSample),
-                                                static_cast<size_t> (samplesThisBlock));
+            ClickRemoval& clickProcessor = chain.clickRemoval;
+            clickProcessor.prepare (spec);
+            clickProcessor.setSensitivity (settings.clickSensitivity);
+            clickProcessor.setRemovalMethod (ClickRemoval::Automatic);
+            clickProcessor.beginRegionStream (length);
+            offlineChain.addProcessor (clickProcessor);
+            offlineChain.setStageName (offlineChain.getNumStages() - 1, "Click Removal");
+        }
 
-            juce::dsp::ProcessContextReplacing<float> context (block);
-            noiseProcessor.process (context);
+        // Decrackle (too short a file has nothing to repair, as in processBufferRegion())
+        if (settings.decrackle && length >= 3)
+        {
+            DBG ("Applying decrackle...");
 
-            if (noiseProcessor.hasProfile())
-                break;
+            Decrackle& decrackleProcessor = chain.decrackle;
+            decrackleProcessor.prepare (spec);
+            decrackleProcessor.setFactor (settings.decrackleFactor);
+            decrackleProcessor.setAverageWidth (static_cast<int> (juce::jmin (static_cast<juce::int64> (settings.decrackleWidth), length / 2)));
+            decrackleProcessor.beginRegionStream (length, analysis.meanDeltas);
+            offlineChain.addProcessor (decrackleProcessor);
+            offlineChain.setStageName (offlineChain.getNumStages() - 1, "Decrackle");
         }
 
-        // Process entire file with noise reduction
-        if (noiseProcessor.hasProfile())
+        // Noise Reduction: the profile comes from the quietest regions of the file when
+        // they were found; otherwise the stage holds the first second of its input,
+        // captures the profile from it (assuming it contains noise), then processes it
+        if (settings.noiseReduction)
         {
-            for (int startSample = 0; startSample < numSamples && !shouldCancel; startSample += blockSize)
-            {
-                int samplesThisBlock = juce::jmin (blockSize, numSamples - startSample);
+            DBG ("Applying noise reduction...");
+
+            NoiseReduction& noiseProcessor = chain.noiseReduction;
+            noiseProcessor.prepare (spec);
+            noiseProcessor.setReduction (settings.noiseReductionDB);
 
-                juce::dsp::AudioBlock<float> block (buffer.getArrayOfWritePointers(),
-                                                    static_cast<size_t> (numChannels),
-                                                    static_cast<size_t> (startSample),
-                                                    static_cast<size_t> (samplesThisBlock));
+            if (!analysis.profileRegions.empty())
+                noiseProcessor.captureProfileFromRegions (analysis.profileAudio, analysis.profileRegions);
+
+            if (noiseProcessor.hasProfile())
+            {
+                offlineChain.addProcessor (noiseProcessor);
+            }
+            else
+            {
+                const int profileSamples = static_cast<int> (juce::jmin (static_cast<juce::int64> (sampleRate), length));
 
-                juce::dsp::ProcessContextReplacing<float> context (block);
-                noiseProcessor.process (context);
+                offlineChain.addProcessor (noiseProcessor, profileSamples,
+                                           [&noiseProcessor] (const juce::AudioBuffer<float>& held, int numSamples)
+                                           {
+                                               noiseProcessor.captureProfileFromBuffer (held, 0, numSamples);
+                                               noiseProcessor.reset();
+                                               return noiseProcessor.hasProfile();
+                                           });
             }
+
+            offlineChain.setStageName (offlineChain.getNumStages() - 1, "Noise Reduction");
         }
     }
-
-    // Apply Filters (Rumble and Hum)
-    if ((settings.rumbleFilter || settings.humFilter) && !shouldCancel)
+    else if (settings.rumbleFilter || settings.humFilter)
     {
+        // Filters (Rumble and Hum)
         DBG ("Applying filters...");
 
-        FilterBank filterProcessor;
+        FilterBank& filterProcessor = chain.filterBank;
         filterProcessor.prepare (spec);
 
         if (settings.rumbleFilter)
@@ -208,49 +634,373 @@ bool BatchProcessor::processFile (const juce::File& inputFile, const Settings& s
         else
             filterProcessor.setHumFilter (60.0f, true);
 
-        for (int startSample = 0; startSample < numSamples && !shouldCancel; startSample += blockSize)
+        offlineChain.addStage ([&filterProcessor] (juce::dsp::ProcessContextReplacing<float>& context) { filterProcessor.process (context); }, 0);
+        offlineChain.setStageName (offlineChain.getNumStages() - 1, "Filter Bank");
+    }
+}
+
+void BatchProcessor::collectProfileRegions (FileAnalysis& analysis, WorkerChain& chain, const Settings& settings,
+                                            const TrackDetector::LevelEnvelope& envelope, double sampleRate,
+                                            int numChannels, juce::int64 length,
+                                            const std::function<void (juce::AudioBuffer<float>& destination, int destStart,
+                                                                      juce::int64 sourceStart, int numSamples)>& read)
+{
+    const auto regionSamples = static_cast<juce::int64> (juce::jmax (0.1f, settings.profileRegionSeconds) * sampleRate);
+    auto regions = TrackDetector::findQuietestRegions (envelope, regionSamples, juce::jmax (1, settings.profileRegions));
+
+    // The envelope's last window may be partial
+    int totalSamples = 0;
+    for (auto& region : regions)
+    {
+        region = region.getIntersectionWith ({ 0, length });
+        totalSamples += static_cast<int> (region.getLength());
+    }
+
+    if (totalSamples <= 0)
+    {
+        DBG ("No quiet region found, noise profile from the first second");
+        chain.notes.add ("noise profile from the first second, no quiet region found");
+        return;
+    }
+
+    // Read in file order, so a stream reader never seeks back
+    std::sort (regions.begin(), regions.end(), [] (const auto& a, const auto& b) { return a.getStart() < b.getStart(); });
+
+    analysis.profileAudio.setSize (numChannels, totalSamples);
+    analysis.profileRegions.clear();
+
+    juce::StringArray positions;
+    int destStart = 0;
+
+    for (const auto& region : regions)
+    {
+        const int count = static_cast<int> (region.getLength());
+
+        if (count <= 0)
+            continue;
+
+        read (analysis.profileAudio, destStart, region.getStart(), count);
+        analysis.profileRegions.push_back ({ destStart, destStart + count });
+        positions.add (formatPosition (region.getStart(), sampleRate) + "-" + formatPosition (region.getEnd(), sampleRate));
+        destStart += count;
+    }
+
+    DBG ("Noise profile regions: " + positions.joinIntoString (", "));
+    chain.notes.add ("noise profile from " + positions.joinIntoString (", "));
+}
+
+bool BatchProcessor::processFileStreaming (const juce::File& inputFile, const juce::File& outputFile,
+                                           const Settings& settings, int fileIndex, WorkerChain& chain)
+{
+    AudioFileManager fileManager;
+    std::unique_ptr<juce::AudioFormatReader> reader (fileManager.createReaderFor (inputFile));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->numChannels == 0 || reader->sampleRate <= 0.0)
+    {
+        DBG ("Failed to load file: " + inputFile.getFullPathName());
+        return false;
+    }
+
+    const double sampleRate = reader->sampleRate;
+    const int numChannels = static_cast<int> (reader->numChannels);
+    const juce::int64 length = reader->lengthInSamples;
+
+    const int readSize = 65536;           // Samples read, and written, per step
+    juce::AudioBuffer<float> readBuffer (numChannels, readSize);
+
+    // Every pass over the file is an equal share of its progress
+    const bool findProfile = settings.noiseReduction && settings.profileFromQuietest;
+    const bool analyse = settings.decrackle || findProfile;
+    const int numPasses = 1 + (analyse ? 1 : 0) + (settings.normalize ? 1 : 0);
+    int passesDone = 0;
+
+    const auto passProgress = [this, fileIndex, &chain, &passesDone, numPasses] (double fraction)
+    {
+        const double progress = chain.passStart + chain.passShare * (passesDone + juce::jlimit (0.0, 1.0, fraction)) / numPasses;
+        reportFileProgress (fileIndex, chain.workerIndex, juce::jmin (0.99f, static_cast<float> (progress)), {});
+        return !shouldCancel;
+    };
+
+    const auto readBlock = [&readBuffer, readSize, length] (juce::AudioFormatReader& source, juce::int64 position)
+    {
+        const int samplesThisRead = static_cast<int> (juce::jmin (static_cast<juce::int64> (readSize), length - position));
+        source.read (&readBuffer, 0, samplesThisRead, position, true, true);
+        return samplesThisRead;
+    };
+
+    // Analysis pass: Decrackle's threshold follows each channel's mean |delta| over
+    // the whole file. It is measured on the input, before click removal, which
+    // changes too few samples to move it. The same pass builds the level envelope
+    // the quietest regions for the noise profile are picked from.
+    FileAnalysis analysis;
+    TrackDetector::LevelEnvelope envelope (numChannels, TrackDetector::DetectionSettings().rmsWindowSamples);
+
+    if (analyse && !shouldCancel)
+    {
+        DBG ("Analysing levels...");
+        const TraceRecorder::ScopedEvent passEvent (trace.get(), "Analysis", "pass", chain.workerIndex);
+
+        std::vector<double> absSums (static_cast<size_t> (numChannels), 0.0);
+        std::vector<float> previous (static_cast<size_t> (numChannels), 0.0f);
+
+        for (juce::int64 position = 0; position < length && passProgress (position / static_cast<double> (length)); )
         {
-            int samplesThisBlock = juce::jmin (blockSize, numSamples - startSample);
+            const int samplesThisRead = readBlock (*reader, position);
+
+            if (findProfile)
+                envelope.process (readBuffer, 0, samplesThisRead);
 
-            juce::dsp::AudioBlock<float> block (buffer.getArrayOfWritePointers(),
-                                                static_cast<size_t> (numChannels),
-                                                static_cast<size_t> (startSample),
-                                                static_cast<size_t> (samplesThisBlock));
+            for (int ch = 0; ch < numChannels && settings.decrackle; ++ch)
+            {
+                const float* channelData = readBuffer.getReadPointer (ch);
+                float last = position > 0 ? previous[(size_t) ch] : channelData[0];
+                double sum = 0.0;
+
+                for (int i = 0; i < samplesThisRead; ++i)
+                {
+                    sum += std::abs (channelData[i] - last);
+                    last = channelData[i];
+                }
 
-            juce::dsp::ProcessContextReplacing<float> context (block);
-            filterProcessor.process (context);
+                absSums[(size_t) ch] += sum;
+                previous[(size_t) ch] = last;
+            }
+
+            position += samplesThisRead;
         }
+
+        for (int ch = 0; ch < numChannels && settings.decrackle; ++ch)
+            analysis.meanDeltas.push_back (length > 1 ? static_cast<float> (absSums[(size_t) ch] / static_cast<double> (length - 1)) : 0.0f);
+
+        envelope.finish();
+        ++passesDone;
     }
 
+    if (findProfile && !shouldCancel)
+        collectProfileRegions (analysis, chain, settings, envelope, sampleRate, numChannels, length,
+                               [&reader] (juce::AudioBuffer<float>& destination, int destStart, juce::int64 sourceStart, int numSamples)
+                               {
+                                   reader->read (&destination, destStart, numSamples, sourceStart, true, true);
+                               });
+
+    // Normalizing needs the peak of the result, so the chain then writes floats to
+    // a temporary file and a last pass applies the gain on the way to the output
+    juce::TemporaryFile unnormalized (outputFile);
+    const juce::File chainOutput = settings.normalize ? unnormalized.getFile() : outputFile;
+    std::unique_ptr<juce::AudioFormatWriter> writer (fileManager.createWriterFor (chainOutput, sampleRate, numChannels,
+                                                                                  settings.normalize ? 32 : settings.outputBitDepth));
+
+    if (writer == nullptr)
+    {
+        DBG ("Failed to save file: " + outputFile.getFullPathName());
+        return false;
+    }
+
+    bool outputStarted = !settings.normalize;    // createWriterFor() has replaced any previous output
+
+    OfflineChain offlineChain (numChannels, chainBlockSize);
+    addChainStages (offlineChain, chain, settings, sampleRate, numChannels, length, analysis, true);
+    addChainStages (offlineChain, chain, settings, sampleRate, numChannels, length, analysis, false);
+    offlineChain.setTrace (trace.get(), chain.workerIndex);
+
+    offlineChain.setSink ([&writer] (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        return writer->writeFromAudioSampleBuffer (buffer, startSample, numSamples);
+    });
+
+    DBG ("Streaming " + juce::String (length) + " samples through the chain...");
+    bool written = true;
+
+    {
+        const TraceRecorder::ScopedEvent passEvent (trace.get(), "Chain", "pass", chain.workerIndex);
+
+        for (juce::int64 position = 0; position < length && written && passProgress (position / static_cast<double> (length)); )
+        {
+            const int samplesThisRead = readBlock (*reader, position);
+            written = offlineChain.push (readBuffer, 0, samplesThisRead);
+            position += samplesThisRead;
+        }
+
+        written = written && !shouldCancel && offlineChain.finish();
+    }
+
+    writer.reset();                       // Closes the file
+    ++passesDone;
+
     // Apply Normalization
-    if (settings.normalize && !shouldCancel)
+    if (written && settings.normalize && !shouldCancel)
     {
         DBG ("Applying normalization...");
-        float maxLevel = 0.0f;
+        const TraceRecorder::ScopedEvent passEvent (trace.get(), "Normalize", "pass", chain.workerIndex);
 
-        // Find peak level
-        for (int ch = 0; ch < numChannels; ++ch)
+        const float maxLevel = offlineChain.getPeakLevel();
+        const float gain = maxLevel > 0.0f ? juce::Decibels::decibelsToGain (settings.normalizeDB) / maxLevel : 1.0f;
+        std::unique_ptr<juce::AudioFormatReader> processed (fileManager.createReaderFor (chainOutput));
+        writer = fileManager.createWriterFor (outputFile, sampleRate, numChannels, settings.outputBitDepth);
+        outputStarted = true;
+        written = processed != nullptr && writer != nullptr;
+
+        for (juce::int64 position = 0; position < length && written && passProgress (position / static_cast<double> (length)); )
         {
-            const float* channelData = buffer.getReadPointer (ch);
-            for (int i = 0; i < numSamples; ++i)
+            const int samplesThisRead = readBlock (*processed, position);
+            readBuffer.applyGain (0, samplesThisRead, gain);
+            written = writer->writeFromAudioSampleBuffer (readBuffer, 0, samplesThisRead);
+            position += samplesThisRead;
+        }
+
+        writer.reset();
+
+        if (maxLevel > 0.0f)
+            DBG ("Normalized with gain: " + juce::String (juce::Decibels::gainToDecibels (gain), 2) + " dB");
+    }
+
+    if (shouldCancel || !written)
+    {
+        if (outputStarted)
+            outputFile.deleteFile();
+
+        if (shouldCancel)
+            DBG ("Processing cancelled");
+        else
+            DBG ("Failed to save file: " + outputFile.getFullPathName());
+
+        return false;
+    }
+
+    DBG ("Successfully processed and saved: " + outputFile.getFullPathName());
+    return true;
+}
+
+bool BatchProcessor::processFileInMemory (const juce::File& inputFile, const juce::File& outputFile,
+                                          const Settings& settings, int fileIndex, WorkerChain& chain)
+{
+    // Load audio file
+    AudioFileManager fileManager;
+    juce::AudioBuffer<float> buffer;
+    double sampleRate = 0.0;
+    bool loaded = false;
+
+    {
+        const TraceRecorder::ScopedEvent passEvent (trace.get(), "Load", "pass", chain.workerIndex);
+        loaded = fileManager.loadAudioFile (inputFile, buffer, sampleRate);
+    }
+
+    if (!loaded)
+    {
+        DBG ("Failed to load file: " + inputFile.getFullPathName());
+        return false;
+    }
+
+    int numChannels = buffer.getNumChannels();
+    int numSamples = buffer.getNumSamples();
+
+    // The stages run fused, block by block, in one pass; the AI denoiser needs the
+    // whole buffer, so when it is on the filters get a pass of their own after it.
+    // Each pass, the AI denoise, normalization and saving are equal shares of progress.
+    const int numStages = 2 + (settings.aiDenoise ? 2 : 0) + (settings.normalize ? 1 : 0);
+    int stagesDone = 0;
+
+    const auto stageProgress = [this, fileIndex, &chain, &stagesDone, numStages] (double fraction)
+    {
+        const double progress = chain.passStart + chain.passShare * (stagesDone + juce::jlimit (0.0, 1.0, fraction)) / numStages;
+        reportFileProgress (fileIndex, chain.workerIndex, juce::jmin (0.99f, static_cast<float> (progress)), {});
+        return !shouldCancel;
+    };
+
+    const auto finishStage = [&stagesDone, &stageProgress]
+    {
+        ++stagesDone;
+        stageProgress (0.0);
+    };
+
+    // Decrackle's threshold follows the mean |delta| of the input (click removal
+    // changes too few samples to move it); the noise profile regions are copied
+    // out before the buffer is processed in place
+    FileAnalysis analysis;
+    if (settings.decrackle)
+        analysis.meanDeltas = Decrackle::measureLevels (buffer, 0, numSamples);
+
+    if (settings.noiseReduction && settings.profileFromQuietest)
+    {
+        TrackDetector::LevelEnvelope envelope (numChannels, TrackDetector::DetectionSettings().rmsWindowSamples);
+        envelope.process (buffer, 0, numSamples);
+        envelope.finish();
+
+        collectProfileRegions (analysis, chain, settings, envelope, sampleRate, numChannels, numSamples,
+                               [&buffer, numChannels] (juce::AudioBuffer<float>& destination, int destStart, juce::int64 sourceStart, int count)
+                               {
+                                   for (int ch = 0; ch < numChannels; ++ch)
+                                       destination.copyFrom (ch, destStart, buffer, ch, static_cast<int> (sourceStart), count);
+                               });
+    }
+
+    // The pass that runs last also measures the peak for normalization
+    OfflineChain offlineChain (numChannels, chainBlockSize);
+    addChainStages (offlineChain, chain, settings, sampleRate, numChannels, numSamples, analysis, true);
+
+    if (!settings.aiDenoise)
+        addChainStages (offlineChain, chain, settings, sampleRate, numChannels, numSamples, analysis, false);
+
+    if (offlineChain.getNumStages() > 0 || (settings.normalize && !settings.aiDenoise))
+    {
+        const TraceRecorder::ScopedEvent passEvent (trace.get(), "Chain", "pass", chain.workerIndex);
+        offlineChain.setTrace (trace.get(), chain.workerIndex);
+        offlineChain.processRegion (buffer, 0, numSamples, stageProgress);
+    }
+
+    float maxLevel = offlineChain.getPeakLevel();
+    finishStage();
+
+    // Apply AI Denoise (whole file in large batches, latency compensated).
+    // The session is shared, so workers take turns; it spreads each file over its own threads.
+    if (settings.aiDenoise && !shouldCancel)
+    {
+        DBG ("Applying AI denoise...");
+
+        {
+            const juce::ScopedLock sl (denoiserLock);
+            const TraceRecorder::ScopedEvent passEvent (trace.get(), "AI Denoise", "pass", chain.workerIndex);
+
+            if (!denoiser.processOffline (buffer, sampleRate, stageProgress) && !shouldCancel)
             {
-                maxLevel = juce::jmax (maxLevel, std::abs (channelData[i]));
+                DBG ("AI denoise failed: no model could be loaded");
+                return false;
             }
         }
 
+        finishStage();
+
+        OfflineChain afterDenoiser (numChannels, chainBlockSize);
+        addChainStages (afterDenoiser, chain, settings, sampleRate, numChannels, numSamples, analysis, false);
+
+        if ((afterDenoiser.getNumStages() > 0 || settings.normalize) && !shouldCancel)
+        {
+            const TraceRecorder::ScopedEvent passEvent (trace.get(), "Chain", "pass", chain.workerIndex);
+            afterDenoiser.setTrace (trace.get(), chain.workerIndex);
+            afterDenoiser.processRegion (buffer, 0, numSamples, stageProgress);
+        }
+
+        maxLevel = afterDenoiser.getPeakLevel();
+        finishStage();
+    }
+
+    // Apply Normalization (one gain sweep, from the peak measured in the last pass)
+    if (settings.normalize && !shouldCancel)
+    {
+        DBG ("Applying normalization...");
+
         if (maxLevel > 0.0f)
         {
             float targetLevel = juce::Decibels::decibelsToGain (settings.normalizeDB);
             float gain = targetLevel / maxLevel;
 
             // Apply gain
-            for (int ch = 0; ch < numChannels; ++ch)
-            {
-                buffer.applyGain (ch, 0, numSamples, gain);
-            }
+            buffer.applyGain (gain);
 
             DBG ("Normalized with gain: " + juce::String (juce::Decibels::gainToDecibels (gain), 2) + " dB");
         }
+
+        finishStage();
     }
 
     if (shouldCancel)
@@ -259,22 +1009,15 @@ bool BatchProcessor::processFile (const juce::File& inputFile, const Settings& s
         return false;
     }
 
-    // Determine output file
-    juce::File outputFile;
-    if (settings.outputDirectory.isDirectory())
-    {
-        juce::String outputName = inputFile.getFileNameWithoutExtension() + "_processed.wav";
-        outputFile = settings.outputDirectory.getChildFile (outputName);
-    }
-    else
+    // Save processed audio
+    bool saved = false;
+
     {
-        // Save next to original file
-        juce::String outputName = inputFile.getFileNameWithoutExtension() + "_processed.wav";
-        outputFile = inputFile.getSiblingFile (outputName);
+        const TraceRecorder::ScopedEvent passEvent (trace.get(), "Save", "pass", chain.workerIndex);
+        saved = fileManager.saveAudioFile (outputFile, buffer, sampleRate, settings.outputBitDepth);
     }
 
-    // Save processed audio
-    if (!fileManager.saveAudioFile (outputFile, buffer, sampleRate, settings.outputBitDepth))
+    if (!saved)
     {
         DBG ("Failed to save file: " + outputFile.getFullPathName());
         return false;
@@ -286,7 +1029,11 @@ bool BatchProcessor::processFile (const juce::File& inputFile, const Settings& s
 
 void BatchProcessor::notifyProgress (const ProgressInfo& info)
 {
-    if (progressCallback)
+    if (progressCallback && !callbacksOnMessageThread)
+    {
+        progressCallback (info);
+    }
+    else if (progressCallback)
     {
         juce::MessageManager::callAsync ([this, info]() {
             if (progressCallback)
@@ -299,7 +1046,11 @@ void BatchProcessor::notifyCompletion (bool success, const juce::String& message
 {
     DBG (message);
 
-    if (completionCallback)
+    if (completionCallback && !callbacksOnMessageThread)
+    {
+        completionCallback (success, message);
+    }
+    else if (completionCallback)
     {
         juce::MessageManager::callAsync ([this, success, message]() {
             if (completionCallback)
@@ -2,20 +2,50 @@
 
 #include <juce_core/juce_core.h>
 #include <juce_audio_formats/juce_audio_formats.h>
+#include "../DSP/OnnxDenoiser.h"
+#include "TrackDetector.h"
 #include <functional>
 #include <atomic>
 
+class OfflineChain;
+class RenderCache;
+class TraceRecorder;
+
 /**
  * Batch Processor
  *
  * Processes multiple audio files with saved settings.
- * Standalone mode only.
+ * Standalone app and command-line tool only.
  *
  * Features:
  * - File queue management
- * - Progress tracking
+ * - Progress tracking, per file and for the whole batch
  * - Cancellation support
  * - Results logging
+ *
+ * Files are spread over a pool of workers (Settings::numWorkers, by default
+ * one per core). Each worker takes the next file from the queue and runs it
+ * through its own ClickRemoval / Decrackle / NoiseReduction / FilterBank
+ * chain, so the workers share no DSP state. Only the AI denoiser is shared,
+ * because its session is loaded once per batch and already runs its own
+ * threads; workers take turns with it.
+ *
+ * The enabled stages run fused in an OfflineChain, each 2048-sample block
+ * going through all of them before the next is read. Files stream from
+ * reader to writer in blocks (Settings::streaming), so a worker holds a few
+ * blocks per stage instead of the decoded file. What needs
+ * the whole file comes from extra passes over the file: Decrackle's level from
+ * an analysis pass before the chain, the normalization gain from a pass over
+ * a temporary float copy after it. AI denoising still loads the whole file,
+ * as does turning streaming off.
+ *
+ * With a cache directory set, a file whose content and output-shaping settings
+ * match an earlier render is copied from the cache instead of processed. The
+ * restored audio before the filters and normalization is cached as well, so
+ * changing only those skips click removal, decrackle and the denoisers.
+ *
+ * With Settings::traceFile set, the run is written there as a Chrome trace:
+ * a row per worker, with each file, its passes and the chain stages' time.
  */
 class BatchProcessor : public juce::Thread
 {
@@ -27,8 +57,18 @@ public:
     {
         bool clickRemoval = true;
         float clickSensitivity = 50.0f;
+        bool decrackle = false;
+        float decrackleFactor = 0.5f;
+        int decrackleWidth = 3;
         bool noiseReduction = false;
         float noiseReductionDB = 12.0f;
+        bool profileFromQuietest = true;     // Noise profile from the quietest regions, else the first second
+        int profileRegions = 3;              // Regions averaged into the profile
+        float profileRegionSeconds = 1.0f;
+        bool aiDenoise = false;
+        juce::String aiProvider = "Auto";    // OnnxDenoiser::providerToString() name
+        bool aiAllowFallback = true;
+        juce::String aiModelPath;            // Empty: the discovered default model
         bool rumbleFilter = false;
         float rumbleFreq = 20.0f;
         bool humFilter = false;
@@ -38,14 +78,32 @@ public:
         bool detectTracks = false;
         int outputBitDepth = 16;
         juce::File outputDirectory;
+        int numWorkers = 0;                  // Files processed at once; 0 = one per core
+        bool streaming = true;               // Reader to writer in blocks, unless aiDenoise is on
+        juce::File cacheDirectory;           // Render cache (see RenderCache); empty for none
+        bool cacheIntermediates = true;      // Also cache the audio before the filters and normalization
+        int cacheLimitMB = 8192;             // Size the cache is trimmed to after each batch
+        juce::File traceFile;                // Chrome trace of the run, written when it ends; empty for none
     };
 
+    /**
+     * Preset form of the settings: a JSON object keyed by the Settings field
+     * names, outputDirectory as a path. Missing keys keep their value in
+     * defaults, so a preset only needs the fields it changes.
+     */
+    static Settings settingsFromVar (const juce::var& preset, const Settings& defaults);
+    static juce::var settingsToVar (const Settings& settings);
+
+    /** Sent whenever a file starts, advances or finishes; workers report independently */
     struct ProgressInfo
     {
-        int currentFileIndex = 0;
+        int currentFileIndex = 0;            // 1-based index of the file this update is about
         int totalFiles = 0;
         juce::String currentFileName;
-        float progress = 0.0f; // 0.0 to 1.0
+        float progress = 0.0f;               // Whole batch, 0.0 to 1.0
+        float fileProgress = 0.0f;           // This file, 0.0 to 1.0
+        int filesCompleted = 0;              // Finished, successfully or not
+        int workerIndex = 0;
         juce::String status;
     };
 
@@ -57,6 +115,13 @@ public:
     void setProgressCallback (ProgressCallback callback) { progressCallback = callback; }
     void setCompletionCallback (CompletionCallback callback) { completionCallback = callback; }
 
+    /**
+     * By default the callbacks are posted to the message thread. Without one
+     * (console use), turn this off to have them called straight from the
+     * worker threads, several at once.
+     */
+    void setCallbacksOnMessageThread (bool shouldPost) { callbacksOnMessageThread = shouldPost; }
+
     //==============================================================================
     void addFile (const juce::File& file);
     void clearQueue();
@@ -72,18 +137,78 @@ public:
     /** Check if batch is currently processing */
     bool isProcessing() const { return isThreadRunning(); }
 
+    /**
+     * Results log: a line per file finished so far, in queue order, with
+     * notes on how it was processed (where the noise profile came from,
+     * render cache hits). Safe to call while processing.
+     */
+    juce::StringArray getLog() const;
+
 private:
+    struct WorkerChain;
+
+    /** What the chain needs to know about a file before it runs */
+    struct FileAnalysis
+    {
+        std::vector<float> meanDeltas;                 // Decrackle's level per channel
+        juce::AudioBuffer<float> profileAudio;         // The noise profile regions, back to back
+        std::vector<juce::Range<int>> profileRegions;  // Of profileAudio; empty: profile from the first second
+    };
+
     void run() override;
-    bool processFile (const juce::File& inputFile, const Settings& settings, int fileIndex);
+    void processQueue (int workerIndex);
+    bool processFile (const juce::File& inputFile, const Settings& settings, int fileIndex, WorkerChain& chain);
+    bool renderFile (const juce::File& inputFile, const juce::File& outputFile,
+                     const Settings& settings, int fileIndex, WorkerChain& chain);
+    bool processFileStreaming (const juce::File& inputFile, const juce::File& outputFile,
+                               const Settings& settings, int fileIndex, WorkerChain& chain);
+    bool processFileInMemory (const juce::File& inputFile, const juce::File& outputFile,
+                              const Settings& settings, int fileIndex, WorkerChain& chain);
+
+    /** Adds the enabled stages that run before the AI denoiser, or those after it */
+    static void addChainStages (OfflineChain& offlineChain, WorkerChain& chain, const Settings& settings,
+                                double sampleRate, int numChannels, juce::int64 length,
+                                const FileAnalysis& analysis, bool beforeDenoiser);
+
+    /**
+     * Picks the quietest regions of an envelope of the file for the noise
+     * profile and has read copy them into the analysis; notes them in the log.
+     */
+    static void collectProfileRegions (FileAnalysis& analysis, WorkerChain& chain, const Settings& settings,
+                                       const TrackDetector::LevelEnvelope& envelope, double sampleRate,
+                                       int numChannels, juce::int64 length,
+                                       const std::function<void (juce::AudioBuffer<float>& destination, int destStart,
+                                                                 juce::int64 sourceStart, int numSamples)>& read);
+    /** Everything in the settings that shapes the output, for render cache keys */
+    static juce::String getCacheDescription (const Settings& settings);
+
+    void reportFileProgress (int fileIndex, int workerIndex, float fileProgress, const juce::String& status);
     void notifyProgress (const ProgressInfo& info);
     void notifyCompletion (bool success, const juce::String& message);
 
     std::vector<juce::File> fileQueue;
     Settings currentSettings;
+    OnnxDenoiser denoiser;                   // Kept across files, so the session loads once per batch
+    std::unique_ptr<RenderCache> renderCache;
+    std::unique_ptr<TraceRecorder> trace;    // While a run with a trace file is in progress
+    juce::CriticalSection denoiserLock;
     std::atomic<bool> shouldCancel {false};
 
+    // Worker state, set up by run()
+    std::vector<std::unique_ptr<WorkerChain>> workerChains;
+    std::atomic<int> nextFileIndex {0};
+    std::atomic<int> successCount {0};
+    std::atomic<int> failureCount {0};
+
+    mutable juce::CriticalSection progressLock;
+    std::vector<float> fileProgress;         // Last reported progress of each file
+    std::vector<juce::String> fileLog;       // Log line of each file, once finished
+    float progressSum = 0.0f;
+    int filesCompleted = 0;
+
     ProgressCallback progressCallback;
     CompletionCallback completionCallback;
+    bool callbacksOnMessageThread = true;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchProcessor)
 };
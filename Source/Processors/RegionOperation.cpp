@@ -0,0 +1,204 @@
+#include "RegionOperation.h"
+#include "../Utils/BufferSplice.h"
+#include <atomic>
+#include <vector>
+
+RegionProcessor::Result RegionProcessor::process (RegionOperation& operation,
+                                                  juce::AudioBuffer<float>& buffer,
+                                                  juce::CriticalSection& bufferLock,
+                                                  double sampleRate,
+                                                  int regionStart,
+                                                  int regionEnd,
+                                                  ProgressCallback progressCallback,
+                                                  int chunkSamples)
+{
+    Result result;
+    result.undoEdit = AudioUndoManager::Edit (operation.getName(), sampleRate);
+
+    regionStart = juce::jlimit (0, buffer.getNumSamples(), regionStart);
+    regionEnd = juce::jlimit (regionStart, buffer.getNumSamples(), regionEnd);
+    const int regionLength = regionEnd - regionStart;
+    result.resultLength = regionLength;
+
+    if (regionLength == 0)
+        return result;
+
+    operation.prepare (buffer, regionStart, regionEnd);
+
+    const int resultLength = juce::jmax (0, operation.getResultLength (regionLength));
+    const bool inPlace = resultLength == regionLength;
+    const int overlap = inPlace ? juce::jmax (0, operation.getOverlapSamples()) : RegionOperation::wholeRegion;
+    const bool deferred = overlap > 0;
+    const int numChannels = buffer.getNumChannels();
+
+    chunkSamples = juce::jmax (1, chunkSamples);
+    const int numChunks = (resultLength + chunkSamples - 1) / chunkSamples;
+
+    std::vector<juce::AudioBuffer<float>> rendered (deferred ? static_cast<size_t> (numChunks) : 0);
+    std::vector<AudioUndoManager::Edit> chunkEdits;
+
+    for (int chunk = 0; chunk < numChunks; ++chunk)
+        chunkEdits.emplace_back (operation.getName(), sampleRate);
+
+    std::atomic<juce::int64> samplesRendered { 0 };
+    std::atomic<bool> cancelled { false };
+
+    const auto renderChunk = [&] (int chunk, juce::AudioBuffer<float>& output)
+    {
+        const int start = chunk * chunkSamples;
+        const int end = juce::jmin (resultLength, start + chunkSamples);
+
+        output.setSize (numChannels, end - start, false, false, true);
+
+        if (inPlace)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                output.copyFrom (channel, 0, buffer, channel, regionStart + start, end - start);
+        }
+        else
+        {
+            output.clear();
+        }
+
+        const int contextStart = inPlace ? regionStart + juce::jmax (0, start - overlap) : regionStart;
+        const int contextEnd = inPlace ? regionStart + static_cast<int> (juce::jmin (static_cast<juce::int64> (regionLength),
+                                                                                      static_cast<juce::int64> (end) + overlap))
+                                       : regionEnd;
+
+        operation.processChunk ({ buffer, regionStart, regionEnd, start, end, contextStart, contextEnd, output });
+        samplesRendered += end - start;
+    };
+
+    // One worker per core, each taking the next chunk until none are left
+    const int numWorkers = juce::jlimit (1, juce::jmax (1, numChunks), juce::SystemStats::getNumCpus());
+    juce::ThreadPool pool (numWorkers);
+
+    const auto forEachChunk = [&] (const std::function<void (int chunk, juce::AudioBuffer<float>& scratch)>& job, bool canCancel)
+    {
+        std::atomic<int> nextChunk { 0 };
+
+        for (int worker = 0; worker < numWorkers; ++worker)
+        {
+            pool.addJob ([&]
+            {
+                juce::AudioBuffer<float> scratch;
+
+                for (int chunk = nextChunk++; chunk < numChunks && !(canCancel && cancelled); chunk = nextChunk++)
+                    job (chunk, scratch);
+
+                return juce::ThreadPoolJob::jobHasFinished;
+            });
+        }
+
+        while (pool.getNumJobs() > 0)
+        {
+            juce::Thread::sleep (20);
+
+            if (canCancel && progressCallback != nullptr
+                && !progressCallback (static_cast<double> (samplesRendered.load()) / juce::jmax (1, resultLength)))
+                cancelled = true;
+        }
+    };
+
+    // Without overlap a chunk is the only reader of its samples, so it goes straight back
+    forEachChunk ([&] (int chunk, juce::AudioBuffer<float>& scratch)
+    {
+        if (deferred)
+        {
+            renderChunk (chunk, rendered[static_cast<size_t> (chunk)]);
+            return;
+        }
+
+        renderChunk (chunk, scratch);
+        commitChanges (buffer, regionStart + chunk * chunkSamples, scratch, scratch.getNumSamples(),
+                       chunkEdits[static_cast<size_t> (chunk)]);
+    }, true);
+
+    result.cancelled = cancelled.load();
+
+    if (!result.cancelled && deferred)
+    {
+        if (inPlace)
+        {
+            // Every chunk has read what it needs; the chunks are disjoint, so they commit in parallel
+            forEachChunk ([&] (int chunk, juce::AudioBuffer<float>&)
+            {
+                auto& output = rendered[static_cast<size_t> (chunk)];
+                commitChanges (buffer, regionStart + chunk * chunkSamples, output, output.getNumSamples(),
+                               chunkEdits[static_cast<size_t> (chunk)]);
+                output.setSize (0, 0);
+            }, false);
+        }
+        else
+        {
+            result.undoEdit.saveSplice (buffer, regionStart, regionLength, resultLength);
+
+            const juce::ScopedLock sl (bufferLock);
+            BufferSplice::replace (buffer, regionStart, regionLength, nullptr, resultLength);
+
+            for (int chunk = 0; chunk < numChunks; ++chunk)
+            {
+                auto& output = rendered[static_cast<size_t> (chunk)];
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    buffer.copyFrom (channel, regionStart + chunk * chunkSamples, output, channel, 0, output.getNumSamples());
+            }
+
+            result.resultLength = resultLength;
+        }
+    }
+
+    // Chunks never overlap, so their undo regions are simply concatenated
+    for (auto& edit : chunkEdits)
+        result.undoEdit.append (std::move (edit));
+
+    return result;
+}
+
+void RegionProcessor::commitChanges (juce::AudioBuffer<float>& buffer, int position,
+                                     const juce::AudioBuffer<float>& rendered, int numSamples,
+                                     AudioUndoManager::Edit& edit)
+{
+    constexpr int joinGap = 16;     // Fewer, slightly longer undo regions for scattered changes
+    const int numChannels = juce::jmin (buffer.getNumChannels(), rendered.getNumChannels());
+
+    const auto differs = [&] (int index)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (rendered.getReadPointer (channel)[index] != buffer.getReadPointer (channel)[position + index])
+                return true;
+
+        return false;
+    };
+
+    const auto write = [&] (int start, int end)
+    {
+        edit.saveRegion (buffer, position + start, end - start);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.copyFrom (channel, position + start, rendered, channel, start, end - start);
+    };
+
+    int runStart = -1;
+    int runEnd = -1;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (!differs (i))
+            continue;
+
+        if (runStart >= 0 && i - runEnd > joinGap)
+        {
+            write (runStart, runEnd);
+            runStart = -1;
+        }
+
+        if (runStart < 0)
+            runStart = i;
+
+        runEnd = i + 1;
+    }
+
+    if (runStart >= 0)
+        write (runStart, runEnd);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include "../Utils/AudioUndoManager.h"
+#include <functional>
+#include <limits>
+
+/**
+ * Region Operation
+ *
+ * One offline edit of a region of the document, such as a gain change, a
+ * dropout repair or a resampling pass. The region's result is split into
+ * chunks that RegionProcessor renders on several cores; every chunk reads
+ * the document as it was before the edit and renders its part of the result
+ * into a buffer of its own, so chunks never depend on each other's output.
+ *
+ * An operation that reads samples around its chunk (a filter's history, an
+ * interpolator's taps) declares how far with getOverlapSamples(); one whose
+ * result is a different length from the region (a speed change) says so
+ * with getResultLength().
+ */
+class RegionOperation
+{
+public:
+    /** Overlap of an operation that may read anywhere in the region */
+    static constexpr int wholeRegion = std::numeric_limits<int>::max();
+
+    struct Chunk
+    {
+        const juce::AudioBuffer<float>& source;   // The document, unchanged until every chunk is rendered
+        int regionStart;                          // The region being processed, in source samples
+        int regionEnd;
+        int start;                                // This chunk's part of the result, counted from the start of the result
+        int end;
+        int contextStart;                         // Source samples the chunk may read: [start, end) of the region plus the
+        int contextEnd;                           // overlap, within the region (the whole region if the length changes)
+
+        /**
+         * Result samples [start, end) from index 0. For a length-preserving
+         * operation it already holds the source samples, so only what changes
+         * has to be written; otherwise it is cleared.
+         */
+        juce::AudioBuffer<float>& output;
+    };
+
+    virtual ~RegionOperation() = default;
+
+    /** Name of the undo step */
+    virtual juce::String getName() const = 0;
+
+    /** Source samples either side of a chunk that it reads (0: only its own, wholeRegion: any) */
+    virtual int getOverlapSamples() const { return 0; }
+
+    /** Length of the result that replaces a region of regionLength samples */
+    virtual int getResultLength (int regionLength) const { return regionLength; }
+
+    /** Called once before the chunks, on the processing thread, for analysis of the whole region */
+    virtual void prepare (const juce::AudioBuffer<float>& source, int regionStart, int regionEnd)
+    {
+        juce::ignoreUnused (source, regionStart, regionEnd);
+    }
+
+    /** Renders one chunk; called for different chunks from several threads at once */
+    virtual void processChunk (const Chunk& chunk) = 0;
+};
+
+/**
+ * Region Processor
+ *
+ * Runs a RegionOperation over a region of a buffer on one worker per core
+ * and records the delta undo state for it.
+ *
+ * A length-preserving operation only writes back the samples it changed, and
+ * only those are saved for undo, so a repair that touches a few dropouts in
+ * an hour of audio keeps a few dropouts' worth of undo. Without overlap each
+ * chunk is written back as soon as it is rendered (nobody else reads it);
+ * with overlap the chunks are written back once all are rendered, as their
+ * neighbours read the original samples. A length-changing operation replaces
+ * the region in one splice under the buffer's lock.
+ */
+class RegionProcessor
+{
+public:
+    static constexpr int defaultChunkSamples = 1 << 16;
+
+    /** Receives progress (0.0 to 1.0) and returns false to cancel */
+    using ProgressCallback = std::function<bool (double progress)>;
+
+    struct Result
+    {
+        AudioUndoManager::Edit undoEdit { {}, 44100.0 };   // What the operation replaced, to add to the undo manager
+        int resultLength = 0;                               // Length of the region after the edit
+        bool cancelled = false;                             // Nothing was changed, or (without overlap) only what undoEdit holds
+    };
+
+    /**
+     * Processes buffer[regionStart, regionEnd) in place. bufferLock is held
+     * while the buffer's length changes; in-place writes follow the click
+     * repairs and do not take it.
+     */
+    static Result process (RegionOperation& operation,
+                           juce::AudioBuffer<float>& buffer,
+                           juce::CriticalSection& bufferLock,
+                           double sampleRate,
+                           int regionStart,
+                           int regionEnd,
+                           ProgressCallback progressCallback = nullptr,
+                           int chunkSamples = defaultChunkSamples);
+
+private:
+    /**
+     * Writes the samples of rendered[0, numSamples) that differ from
+     * buffer[position, ...) into the buffer, saving each changed run in edit
+     * first. Runs closer than a few samples are saved as one.
+     */
+    static void commitChanges (juce::AudioBuffer<float>& buffer, int position,
+                               const juce::AudioBuffer<float>& rendered, int numSamples,
+                               AudioUndoManager::Edit& edit);
+};
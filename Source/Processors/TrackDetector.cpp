@@ -1,5 +1,8 @@
 #include "TrackDetector.h"
+#include "../Utils/AudioFileManager.h"
 #include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+#include <atomic>
 
 TrackDetector::TrackDetector()
 {
@@ -8,46 +11,48 @@ TrackDetector::TrackDetector()
 std::vector<TrackDetector::TrackBoundary> TrackDetector::detectTracks (const juce::AudioBuffer<float>& buffer,
                                                                        double sampleRate,
                                                                        const DetectionSettings& settings)
+{
+    WindowLevels levels;
+    levels.build (buffer, settings.rmsWindowSamples);
+    return detectTracks (levels, sampleRate, settings);
+}
+
+std::vector<TrackDetector::TrackBoundary> TrackDetector::detectTracks (const WindowLevels& levels,
+                                                                       double sampleRate,
+                                                                       const DetectionSettings& settings,
+                                                                       int64_t startSample,
+                                                                       int64_t endSample)
 {
     std::vector<TrackBoundary> detectedBoundaries;
 
-    if (buffer.getNumSamples() == 0)
+    const int hopSamples = levels.getHopSamples();
+
+    if (levels.getNumSamples() == 0 || hopSamples <= 0)
         return detectedBoundaries;
 
-    const int numSamples = buffer.getNumSamples();
-    const int numChannels = buffer.getNumChannels();
-    const int windowSize = settings.rmsWindowSamples;
+    if (endSample < 0)
+        endSample = levels.getNumSamples();
+
+    startSample = juce::jlimit ((int64_t) 0, levels.getNumSamples(), startSample);
+    endSample = juce::jlimit (startSample, levels.getNumSamples(), endSample);
 
     // Convert thresholds to sample counts
     const int64_t minSilenceSamples = (int64_t) (settings.minSilenceDurationSeconds * sampleRate);
     const int64_t minTrackSamples = (int64_t) (settings.minTrackDurationSeconds * sampleRate);
 
-    // Detect silence regions
+    // Detect silence regions, one window (two hops) at each hop: 50% overlap
     std::vector<std::pair<int64_t, int64_t>> silenceRegions; // [start, end] pairs
 
     int64_t silenceStart = -1;
     bool inSilence = false;
+    const int firstHop = (int) (startSample / hopSamples);
+    const int endHop = (int) ((endSample + hopSamples - 1) / hopSamples);
 
-    for (int64_t i = 0; i < numSamples; i += windowSize / 2) // 50% overlap
+    for (int hop = firstHop; hop < endHop; ++hop)
     {
-        int samplesToCheck = juce::jmin (windowSize, (int) (numSamples - i));
-
-        // Calculate level (RMS or peak) across all channels
-        float level = 0.0f;
-
-        for (int ch = 0; ch < numChannels; ++ch)
-        {
-            float channelLevel = settings.useRMSDetection
-                ? calculateRMS (buffer, ch, (int) i, samplesToCheck)
-                : calculatePeak (buffer, ch, (int) i, samplesToCheck);
-
-            level = juce::jmax (level, channelLevel);
-        }
-
-        // Convert to dB
-        float levelDb = juce::Decibels::gainToDecibels (level, -100.0f);
-
-        bool isSilent = levelDb < settings.silenceThresholdDb;
+        const int64_t i = (int64_t) hop * hopSamples;
+        const float levelDb = juce::Decibels::gainToDecibels (levels.getWindowLevel (hop, settings.useRMSDetection), -100.0f);
+        const bool isSilent = levelDb < settings.silenceThresholdDb;
 
         if (isSilent && !inSilence)
         {
@@ -58,31 +63,20 @@ std::vector<TrackDetector::TrackBoundary> TrackDetector::detectTracks (const juc
         else if (!isSilent && inSilence)
         {
             // End of silence
-            int64_t silenceEnd = i;
-            int64_t silenceDuration = silenceEnd - silenceStart;
-
-            if (silenceDuration >= minSilenceSamples)
-            {
-                silenceRegions.emplace_back (silenceStart, silenceEnd);
-            }
+            if (i - silenceStart >= minSilenceSamples)
+                silenceRegions.emplace_back (silenceStart, i);
 
             inSilence = false;
         }
     }
 
-    // Handle silence at end of file
-    if (inSilence)
-    {
-        int64_t silenceDuration = numSamples - silenceStart;
-        if (silenceDuration >= minSilenceSamples)
-        {
-            silenceRegions.emplace_back (silenceStart, numSamples);
-        }
-    }
+    // Handle silence at end of range
+    if (inSilence && endSample - silenceStart >= minSilenceSamples)
+        silenceRegions.emplace_back (silenceStart, endSample);
 
     // Create track boundaries at midpoints of silence regions
-    // First track starts at 0
-    int64_t lastTrackEnd = 0;
+    // First track starts at the start of the range
+    int64_t lastTrackEnd = startSample;
 
     for (const auto& silenceRegion : silenceRegions)
     {
@@ -106,6 +100,334 @@ std::vector<TrackDetector::TrackBoundary> TrackDetector::detectTracks (const juc
     return boundaries;
 }
 
+//==============================================================================
+namespace
+{
+    /** Sum of squares in SIMD lanes, from the first aligned sample */
+    float sumOfSquares (const float* data, int numSamples)
+    {
+        float sum = 0.0f;
+        int i = 0;
+
+       #if JUCE_USE_SIMD
+        using Vector = juce::dsp::SIMDRegister<float>;
+        const auto* aligned = Vector::getNextSIMDAlignedPtr (const_cast<float*> (data));
+        const int head = juce::jmin (numSamples, static_cast<int> (aligned - data));
+
+        for (; i < head; ++i)
+            sum += data[i] * data[i];
+
+        auto lanes = Vector::expand (0.0f);
+
+        for (; i + (int) Vector::SIMDNumElements <= numSamples; i += (int) Vector::SIMDNumElements)
+        {
+            const auto x = Vector::fromRawArray (data + i);
+            lanes += x * x;
+        }
+
+        sum += lanes.sum();
+       #endif
+
+        for (; i < numSamples; ++i)
+            sum += data[i] * data[i];
+
+        return sum;
+    }
+}
+
+void TrackDetector::WindowLevels::build (const juce::AudioBuffer<float>& buffer, int windowSamples)
+{
+    hopSamples = juce::jmax (1, windowSamples / 2);
+    numSamples = 0;
+    sumSquares.clear();
+    peaks.clear();
+    update (buffer, 0, -1);
+}
+
+void TrackDetector::WindowLevels::update (const juce::AudioBuffer<float>& buffer, int64_t startSample, int64_t numSamplesChanged)
+{
+    if (hopSamples <= 0)
+        return;
+
+    const bool lengthChanged = buffer.getNumSamples() != numSamples
+                               || (size_t) buffer.getNumChannels() != sumSquares.size();
+
+    numSamples = buffer.getNumSamples();
+    const int numHops = getNumHops();
+
+    sumSquares.resize ((size_t) buffer.getNumChannels());
+    peaks.resize ((size_t) buffer.getNumChannels());
+
+    for (size_t ch = 0; ch < sumSquares.size(); ++ch)
+    {
+        sumSquares[ch].resize ((size_t) numHops, 0.0f);
+        peaks[ch].resize ((size_t) numHops, 0.0f);
+    }
+
+    const int64_t endSample = (numSamplesChanged < 0 || lengthChanged) ? numSamples
+                                                                       : juce::jmin (numSamples, startSample + numSamplesChanged);
+    const int firstHop = (int) (juce::jlimit ((int64_t) 0, numSamples, startSample) / hopSamples);
+    const int endHop = (int) juce::jmin ((int64_t) numHops, (endSample + hopSamples - 1) / hopSamples);
+
+    computeHops (buffer, firstHop, endHop);
+}
+
+bool TrackDetector::WindowLevels::matches (const juce::AudioBuffer<float>& buffer, int windowSamples) const
+{
+    return hopSamples == juce::jmax (1, windowSamples / 2)
+           && numSamples == buffer.getNumSamples()
+           && sumSquares.size() == (size_t) buffer.getNumChannels()
+           && numSamples > 0;
+}
+
+void TrackDetector::WindowLevels::clear()
+{
+    numSamples = 0;
+    sumSquares.clear();
+    peaks.clear();
+}
+
+float TrackDetector::WindowLevels::getWindowLevel (int hop, bool useRMS) const
+{
+    const int numHops = getNumHops();
+
+    if (hop < 0 || hop >= numHops)
+        return 0.0f;
+
+    // A window is this hop and the next; the last one is cut short by the end
+    const bool hasNext = hop + 1 < numHops;
+    const int64_t windowStart = (int64_t) hop * hopSamples;
+    const int64_t windowLength = juce::jmin ((int64_t) hopSamples * 2, numSamples - windowStart);
+    float level = 0.0f;
+
+    for (size_t ch = 0; ch < sumSquares.size(); ++ch)
+    {
+        const float channelLevel = useRMS
+            ? std::sqrt ((sumSquares[ch][(size_t) hop] + (hasNext ? sumSquares[ch][(size_t) hop + 1] : 0.0f)) / (float) windowLength)
+            : juce::jmax (peaks[ch][(size_t) hop], hasNext ? peaks[ch][(size_t) hop + 1] : 0.0f);
+
+        level = juce::jmax (level, channelLevel);
+    }
+
+    return level;
+}
+
+void TrackDetector::WindowLevels::writeTo (juce::OutputStream& output) const
+{
+    output.writeInt (hopSamples);
+    output.writeInt64 (numSamples);
+    output.writeInt ((int) sumSquares.size());
+
+    for (size_t ch = 0; ch < sumSquares.size(); ++ch)
+    {
+        for (auto value : sumSquares[ch])
+            output.writeFloat (value);
+
+        for (auto value : peaks[ch])
+            output.writeFloat (value);
+    }
+}
+
+bool TrackDetector::WindowLevels::readFrom (juce::InputStream& input, int expectedChannels, int64_t expectedSamples)
+{
+    clear();
+
+    const int hops = input.readInt();
+    const int64_t samples = input.readInt64();
+
+    if (hops <= 0 || samples != expectedSamples || samples <= 0 || input.readInt() != expectedChannels)
+        return false;
+
+    hopSamples = hops;
+    numSamples = samples;
+    const auto numHops = (size_t) getNumHops();
+
+    if (input.getNumBytesRemaining() < (juce::int64) (numHops * 2 * sizeof (float)) * expectedChannels)
+    {
+        clear();
+        return false;
+    }
+
+    sumSquares.assign ((size_t) expectedChannels, std::vector<float> (numHops));
+    peaks.assign ((size_t) expectedChannels, std::vector<float> (numHops));
+
+    for (size_t ch = 0; ch < sumSquares.size(); ++ch)
+    {
+        for (auto& value : sumSquares[ch])
+            value = input.readFloat();
+
+        for (auto& value : peaks[ch])
+            value = input.readFloat();
+    }
+
+    return true;
+}
+
+void TrackDetector::WindowLevels::computeHops (const juce::AudioBuffer<float>& buffer, int firstHop, int endHop)
+{
+    const int numChannels = (int) sumSquares.size();
+
+    const auto computeRange = [this, &buffer, numChannels] (int first, int end)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int hop = first; hop < end; ++hop)
+            {
+                const int64_t start = (int64_t) hop * hopSamples;
+                const int count = (int) juce::jmin ((int64_t) hopSamples, numSamples - start);
+                const float* data = buffer.getReadPointer (ch, (int) start);
+                const auto range = juce::FloatVectorOperations::findMinAndMax (data, count);
+
+                sumSquares[(size_t) ch][(size_t) hop] = sumOfSquares (data, count);
+                peaks[(size_t) ch][(size_t) hop] = juce::jmax (-range.getStart(), range.getEnd());
+            }
+        }
+    };
+
+    // A small edit is patched inline; a whole file is split over the cores
+    constexpr int hopsPerJob = 4096;
+    const int numHops = endHop - firstHop;
+
+    if (numHops <= hopsPerJob)
+    {
+        computeRange (firstHop, endHop);
+        return;
+    }
+
+    const int numJobs = (numHops + hopsPerJob - 1) / hopsPerJob;
+    juce::ThreadPool pool (juce::jlimit (1, numJobs, juce::SystemStats::getNumCpus()));
+
+    for (int first = firstHop; first < endHop; first += hopsPerJob)
+    {
+        const int end = juce::jmin (endHop, first + hopsPerJob);
+
+        pool.addJob ([computeRange, first, end]
+        {
+            computeRange (first, end);
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep (1);
+}
+
+//==============================================================================
+TrackDetector::LevelEnvelope::LevelEnvelope (int numChannels, int windowSamplesToUse)
+    : windowSamples (juce::jmax (1, windowSamplesToUse)),
+      sums (static_cast<size_t> (juce::jmax (1, numChannels)), 0.0)
+{
+}
+
+void TrackDetector::LevelEnvelope::process (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    const int numChannels = juce::jmin (static_cast<int> (sums.size()), buffer.getNumChannels());
+
+    while (numSamples > 0)
+    {
+        const int count = juce::jmin (numSamples, windowSamples - filled);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* data = buffer.getReadPointer (ch, startSample);
+            double sum = 0.0;
+
+            for (int i = 0; i < count; ++i)
+                sum += data[i] * data[i];
+
+            sums[(size_t) ch] += sum;
+        }
+
+        filled += count;
+        startSample += count;
+        numSamples -= count;
+
+        if (filled == windowSamples)
+            finish();
+    }
+}
+
+void TrackDetector::LevelEnvelope::finish()
+{
+    if (filled == 0)
+        return;
+
+    double loudest = 0.0;
+
+    for (auto& sum : sums)
+    {
+        loudest = juce::jmax (loudest, sum);
+        sum = 0.0;
+    }
+
+    meanSquares.push_back (static_cast<float> (loudest / filled));
+    filled = 0;
+}
+
+std::vector<juce::Range<int64_t>> TrackDetector::findQuietestRegions (const LevelEnvelope& envelope,
+                                                                      int64_t regionSamples,
+                                                                      int maxRegions)
+{
+    std::vector<juce::Range<int64_t>> regions;
+
+    const auto& levels = envelope.getMeanSquares();
+    const int numWindows = static_cast<int> (levels.size());
+    const int windowSamples = envelope.getWindowSamples();
+    const int regionWindows = juce::jlimit (1, juce::jmax (1, numWindows),
+                                            static_cast<int> ((regionSamples + windowSamples - 1) / windowSamples));
+
+    if (numWindows == 0 || maxRegions <= 0)
+        return regions;
+
+    // Below -90 dBFS a window is digital silence (padding, a muted input), not noise
+    const float silenceFloor = 1.0e-9f;
+
+    // Running sums give every candidate's mean level in one pass
+    std::vector<double> levelSums (static_cast<size_t> (numWindows) + 1, 0.0);
+    std::vector<int> silentCounts (static_cast<size_t> (numWindows) + 1, 0);
+
+    for (int i = 0; i < numWindows; ++i)
+    {
+        const bool silent = levels[(size_t) i] < silenceFloor;
+        levelSums[(size_t) i + 1] = levelSums[(size_t) i] + (silent ? 0.0 : levels[(size_t) i]);
+        silentCounts[(size_t) i + 1] = silentCounts[(size_t) i] + (silent ? 1 : 0);
+    }
+
+    std::vector<char> taken (static_cast<size_t> (numWindows), 0);
+
+    for (int r = 0; r < maxRegions; ++r)
+    {
+        int best = -1;
+        double bestLevel = 0.0;
+
+        for (int start = 0; start + regionWindows <= numWindows; ++start)
+        {
+            const auto end = (size_t) (start + regionWindows);
+
+            // All regions are as long, so one overlapping a pick has its first or last window in it
+            if (silentCounts[end] != silentCounts[(size_t) start] || taken[(size_t) start] || taken[end - 1])
+                continue;
+
+            const double level = levelSums[end] - levelSums[(size_t) start];
+
+            if (best < 0 || level < bestLevel)
+            {
+                best = start;
+                bestLevel = level;
+            }
+        }
+
+        if (best < 0)
+            break;
+
+        std::fill (taken.begin() + best, taken.begin() + best + regionWindows, 1);
+        regions.push_back ({ (int64_t) best * windowSamples, (int64_t) (best + regionWindows) * windowSamples });
+    }
+
+    return regions;
+}
+
+//==============================================================================
 void TrackDetector::addManualBoundary (int64_t position, const juce::String& name)
 {
     boundaries.emplace_back (position, true, name);
@@ -138,73 +460,56 @@ void TrackDetector::setTrackNames (const juce::StringArray& names)
     trackNames = names;
 }
 
-std::vector<juce::AudioBuffer<float>> TrackDetector::splitIntoTracks (const juce::AudioBuffer<float>& buffer,
-                                                                      double sampleRate,
-                                                                      bool applyFades)
+std::vector<TrackDetector::TrackRange> TrackDetector::getTrackRanges (int64_t numSamples, double sampleRate, bool applyFades)
 {
-    std::vector<juce::AudioBuffer<float>> tracks;
+    std::vector<TrackRange> ranges;
+    const int fadeLength = (int) (0.01 * sampleRate); // 10ms fade
 
     if (boundaries.empty())
     {
-        // No boundaries - return entire buffer as single track
-        juce::AudioBuffer<float> track (buffer.getNumChannels(), buffer.getNumSamples());
-
-        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
-            track.copyFrom (ch, 0, buffer, ch, 0, buffer.getNumSamples());
-
-        if (applyFades)
-        {
-            int fadeSamples = (int) (0.01 * sampleRate); // 10ms fade
-            applyFadeInOut (track, fadeSamples);
-        }
+        // No boundaries - the entire buffer as single track
+        if (numSamples > 0)
+            ranges.push_back ({ 0, numSamples, applyFades ? fadeLength : 0 });
 
-        tracks.push_back (std::move (track));
-        return tracks;
+        return ranges;
     }
 
     sortBoundaries();
 
-    // Create tracks between boundaries
+    // Tracks between boundaries, then the final one (from last boundary to end)
     int64_t startSample = 0;
 
-    for (const auto& boundary : boundaries)
+    const auto addTrack = [&ranges, applyFades, fadeLength] (int64_t start, int64_t trackLength)
     {
-        int64_t endSample = boundary.position;
-        int64_t trackLength = endSample - startSample;
-
         if (trackLength > 0)
-        {
-            juce::AudioBuffer<float> track (buffer.getNumChannels(), (int) trackLength);
+            ranges.push_back ({ start, trackLength, applyFades ? juce::jmin (fadeLength, (int) trackLength / 10) : 0 });
+    };
 
-            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
-                track.copyFrom (ch, 0, buffer, ch, (int) startSample, (int) trackLength);
-
-            if (applyFades)
-            {
-                int fadeSamples = juce::jmin ((int) (0.01 * sampleRate), (int) trackLength / 10);
-                applyFadeInOut (track, fadeSamples);
-            }
+    for (const auto& boundary : boundaries)
+    {
+        addTrack (startSample, boundary.position - startSample);
+        startSample = boundary.position;
+    }
 
-            tracks.push_back (std::move (track));
-        }
+    addTrack (startSample, numSamples - startSample);
+    return ranges;
+}
 
-        startSample = endSample;
-    }
+std::vector<juce::AudioBuffer<float>> TrackDetector::splitIntoTracks (const juce::AudioBuffer<float>& buffer,
+                                                                      double sampleRate,
+                                                                      bool applyFades)
+{
+    std::vector<juce::AudioBuffer<float>> tracks;
 
-    // Final track (from last boundary to end)
-    int64_t finalTrackLength = buffer.getNumSamples() - startSample;
-    if (finalTrackLength > 0)
+    for (const auto& range : getTrackRanges (buffer.getNumSamples(), sampleRate, applyFades))
     {
-        juce::AudioBuffer<float> track (buffer.getNumChannels(), (int) finalTrackLength);
+        juce::AudioBuffer<float> track (buffer.getNumChannels(), (int) range.length);
 
         for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
-            track.copyFrom (ch, 0, buffer, ch, (int) startSample, (int) finalTrackLength);
+            track.copyFrom (ch, 0, buffer, ch, (int) range.start, (int) range.length);
 
-        if (applyFades)
-        {
-            int fadeSamples = juce::jmin ((int) (0.01 * sampleRate), (int) finalTrackLength / 10);
-            applyFadeInOut (track, fadeSamples);
-        }
+        if (range.fadeSamples > 0)
+            applyFadeInOut (track, range.fadeSamples);
 
         tracks.push_back (std::move (track));
     }
@@ -212,110 +517,152 @@ std::vector<juce::AudioBuffer<float>> TrackDetector::splitIntoTracks (const juce
     return tracks;
 }
 
+juce::String TrackDetector::getTrackName (size_t index, size_t numTracks, const juce::String& baseName) const
+{
+    juce::String trackName = baseName + "_Track_" + juce::String ((int) (index + 1));
+
+    // Prefer track names (if provided) then boundary names
+    if (trackNames.size() == (int) numTracks)
+    {
+        if (trackNames[(int) index].isNotEmpty())
+            trackName = baseName + "_" + trackNames[(int) index];
+    }
+    else if (index < boundaries.size() && boundaries[index].name.isNotEmpty())
+    {
+        trackName = baseName + "_" + boundaries[index].name;
+    }
+
+    return trackName;
+}
+
 bool TrackDetector::exportTracks (const juce::AudioBuffer<float>& buffer,
                                  double sampleRate,
                                  const juce::File& outputDirectory,
                                  const juce::String& baseName,
-                                 const juce::String& extension)
+                                 const juce::String& extension,
+                                 ExportProgressCallback progressCallback)
 {
+    const juce::String format = extension.toLowerCase();
+
+    if (format != "wav" && format != "flac" && format != "ogg")
+    {
+       #if USE_LAME
+        if (format != "mp3")
+       #endif
+            return false;
+    }
+
     if (!outputDirectory.exists())
         outputDirectory.createDirectory();
 
-    auto tracks = splitIntoTracks (buffer, sampleRate, true);
+    const auto ranges = getTrackRanges (buffer.getNumSamples(), sampleRate, true);
+    const int numChannels = buffer.getNumChannels();
+    const int bitDepth = (format == "wav" || format == "flac") ? 24 : 16;   // 24-bit where lossless
 
-    juce::WavAudioFormat wavFormat;
-    juce::FlacAudioFormat flacFormat;
+    int64_t totalSamples = 0;
+    for (const auto& range : ranges)
+        totalSamples += range.length;
 
-    juce::AudioFormat* format = nullptr;
+    std::vector<juce::File> outputFiles;
+    for (size_t i = 0; i < ranges.size(); ++i)
+        outputFiles.push_back (outputDirectory.getChildFile (getTrackName (i, ranges.size(), baseName) + "." + extension));
 
-    if (extension.toLowerCase() == "wav")
-        format = &wavFormat;
-    else if (extension.toLowerCase() == "flac")
-        format = &flacFormat;
-    else
-        return false;
+    std::atomic<int64_t> samplesWritten {0};
+    std::atomic<bool> cancelled {false};
+    std::atomic<bool> failed {false};
+    std::vector<char> finished (ranges.size(), 0);    // Each written by its own track's job
 
-    for (size_t i = 0; i < tracks.size(); ++i)
-    {
-        juce::String trackName = baseName + "_Track_" + juce::String ((int) (i + 1));
+    // One job per track; an encoder is sequential, so tracks are the unit of parallelism
+    const int numThreads = juce::jlimit (1, juce::jmax (1, (int) ranges.size()), juce::SystemStats::getNumCpus());
+    juce::ThreadPool pool (numThreads);
 
-        // Prefer track names (if provided) then boundary names
-        if (trackNames.size() == (int) tracks.size())
-        {
-            if (trackNames[(int) i].isNotEmpty())
-                trackName = baseName + "_" + trackNames[(int) i];
-        }
-        else if (i < boundaries.size() && boundaries[i].name.isNotEmpty())
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        pool.addJob ([&, i]
         {
-            trackName = baseName + "_" + boundaries[i].name;
-        }
+            const auto& range = ranges[i];
+            const auto& outputFile = outputFiles[i];
 
-        juce::File outputFile = outputDirectory.getChildFile (trackName + "." + extension);
+            std::unique_ptr<juce::AudioFormatWriter> writer (AudioFileManager::createWriterFor (outputFile, sampleRate,
+                                                                                                    numChannels, bitDepth));
 
-        // Create output stream
-        std::unique_ptr<juce::FileOutputStream> fileStream (outputFile.createOutputStream());
+            if (writer == nullptr)
+            {
+                DBG ("Failed to create writer for: " + outputFile.getFullPathName());
+                failed = true;
+                return juce::ThreadPoolJob::jobHasFinished;
+            }
 
-        if (fileStream == nullptr)
-        {
-            DBG ("Failed to create output file: " + outputFile.getFullPathName());
-            return false;
-        }
+            // Samples outside the fades are written straight from the source; blocks
+            // that touch a fade are copied and faded first
+            constexpr int blockSize = 65536;
+            juce::AudioBuffer<float> faded (numChannels, blockSize);
 
-        // Create writer
-        std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (fileStream.get(),
-                                                                                   sampleRate,
-                                                                                   tracks[i].getNumChannels(),
-                                                                                   24, // 24-bit
-                                                                                   {},
-                                                                                   0));
+            for (int64_t position = 0; position < range.length && !cancelled && !failed; position += blockSize)
+            {
+                const int samplesThisBlock = (int) juce::jmin ((int64_t) blockSize, range.length - position);
+                const int64_t fadeSamples = juce::jmin ((int64_t) range.fadeSamples, range.length / 2);
+                const bool inFade = position < fadeSamples || position + samplesThisBlock > range.length - fadeSamples;
+                bool ok;
+
+                if (inFade)
+                {
+                    for (int ch = 0; ch < numChannels; ++ch)
+                    {
+                        const float* source = buffer.getReadPointer (ch, (int) (range.start + position));
+                        float* dest = faded.getWritePointer (ch);
+
+                        for (int s = 0; s < samplesThisBlock; ++s)
+                            dest[s] = source[s] * getFadeGain (position + s, range.length, range.fadeSamples);
+                    }
+
+                    ok = writer->writeFromAudioSampleBuffer (faded, 0, samplesThisBlock);
+                }
+                else
+                {
+                    ok = writer->writeFromAudioSampleBuffer (buffer, (int) (range.start + position), samplesThisBlock);
+                }
+
+                if (!ok)
+                {
+                    DBG ("Failed to write: " + outputFile.getFullPathName());
+                    failed = true;
+                }
+
+                samplesWritten += samplesThisBlock;
+            }
 
-        if (writer != nullptr)
-        {
-            fileStream.release(); // Writer takes ownership
+            writer.reset();     // Finishes the file
 
-            // Write audio data
-            writer->writeFromAudioSampleBuffer (tracks[i], 0, tracks[i].getNumSamples());
+            if (!cancelled && !failed)
+            {
+                finished[i] = 1;
+                DBG ("Exported track: " + outputFile.getFullPathName());
+            }
 
-            DBG ("Exported track: " + outputFile.getFullPathName());
-        }
-        else
-        {
-            DBG ("Failed to create writer for: " + outputFile.getFullPathName());
-            return false;
-        }
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
     }
 
-    return true;
-}
-
-float TrackDetector::calculateRMS (const juce::AudioBuffer<float>& buffer, int channel,
-                                   int startSample, int numSamples)
-{
-    if (channel >= buffer.getNumChannels() || numSamples == 0)
-        return 0.0f;
-
-    const float* data = buffer.getReadPointer (channel, startSample);
-
-    float sum = 0.0f;
-    for (int i = 0; i < numSamples; ++i)
-        sum += data[i] * data[i];
-
-    return std::sqrt (sum / numSamples);
-}
+    while (pool.getNumJobs() > 0)
+    {
+        juce::Thread::sleep (20);
 
-float TrackDetector::calculatePeak (const juce::AudioBuffer<float>& buffer, int channel,
-                                    int startSample, int numSamples)
-{
-    if (channel >= buffer.getNumChannels() || numSamples == 0)
-        return 0.0f;
+        if (progressCallback != nullptr && !cancelled && totalSamples > 0
+            && !progressCallback ((double) samplesWritten.load() / (double) totalSamples))
+            cancelled = true;
+    }
 
-    const float* data = buffer.getReadPointer (channel, startSample);
+    if (cancelled || failed)
+    {
+        for (size_t i = 0; i < ranges.size(); ++i)
+            if (finished[i] == 0)
+                outputFiles[i].deleteFile();
 
-    float peak = 0.0f;
-    for (int i = 0; i < numSamples; ++i)
-        peak = juce::jmax (peak, std::abs (data[i]));
+        return false;
+    }
 
-    return peak;
+    return true;
 }
 
 void TrackDetector::applyFadeInOut (juce::AudioBuffer<float>& buffer, int fadeSamples)
@@ -351,6 +698,20 @@ void TrackDetector::applyFadeInOut (juce::AudioBuffer<float>& buffer, int fadeSa
     }
 }
 
+float TrackDetector::getFadeGain (int64_t index, int64_t length, int fadeSamples)
+{
+    const int64_t fade = juce::jmin ((int64_t) fadeSamples, length / 2);
+    float gain = 1.0f;
+
+    if (index < fade)
+        gain *= (float) index / (float) fade;
+
+    if (index >= length - fade)
+        gain *= 1.0f - ((float) (index - (length - fade)) / (float) fade);
+
+    return gain;
+}
+
 void TrackDetector::sortBoundaries()
 {
     std::sort (boundaries.begin(), boundaries.end(),
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <functional>
 #include <vector>
 
 /**
@@ -39,6 +40,90 @@ public:
         int rmsWindowSamples = 1024;         // Window size for RMS calculation
     };
 
+    /** One track of the split: a range of the source and its fade length */
+    struct TrackRange
+    {
+        int64_t start = 0;
+        int64_t length = 0;
+        int fadeSamples = 0;                 // Fade in and out, 0 without fades
+    };
+
+    /** Receives export progress (0.0 to 1.0) and returns false to cancel */
+    using ExportProgressCallback = std::function<bool (double progress)>;
+
+    /**
+     * Decimated level envelope: the mean square of consecutive windows, the
+     * loudest channel's, fed block by block (e.g. from a reader) so a file
+     * never has to be in memory. A few floats per window make it cheap to
+     * keep for hours of audio.
+     */
+    class LevelEnvelope
+    {
+    public:
+        LevelEnvelope (int numChannels, int windowSamples);
+
+        void process (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+        /** Closes the last, partial window after the last process() */
+        void finish();
+
+        int getWindowSamples() const { return windowSamples; }
+        const std::vector<float>& getMeanSquares() const { return meanSquares; }
+
+    private:
+        const int windowSamples;
+        std::vector<double> sums;        // Per channel, over the open window
+        int filled = 0;                  // Samples in the open window
+        std::vector<float> meanSquares;
+    };
+
+    /**
+     * Window levels of a whole buffer, as detectTracks() measures them: the
+     * sum of squares and the peak of each channel over hops of half a window,
+     * a window being two hops. Built once per document, in parallel and with
+     * SIMD sums, and patched after an edit by recomputing only the hops it
+     * touched, so detection with new thresholds is a scan of a few floats per
+     * window rather than of the audio.
+     */
+    class WindowLevels
+    {
+    public:
+        /** Computes every hop of buffer for windows of windowSamples */
+        void build (const juce::AudioBuffer<float>& buffer, int windowSamples);
+
+        /**
+         * Recomputes the hops over [startSample, startSample + numSamples) after
+         * an edit of buffer; a negative count or a length change means to the end.
+         */
+        void update (const juce::AudioBuffer<float>& buffer, int64_t startSample, int64_t numSamples);
+
+        /** True once built for a buffer of this layout and windows of windowSamples */
+        bool matches (const juce::AudioBuffer<float>& buffer, int windowSamples) const;
+
+        void clear();
+
+        int getHopSamples() const { return hopSamples; }
+        int64_t getNumSamples() const { return numSamples; }
+        int getNumHops() const { return static_cast<int> ((numSamples + hopSamples - 1) / juce::jmax (1, hopSamples)); }
+
+        /** Loudest channel's RMS or peak over the window starting at hop */
+        float getWindowLevel (int hop, bool useRMS) const;
+
+        /** Writes the hops to a stream, e.g. to keep them with a session */
+        void writeTo (juce::OutputStream& output) const;
+
+        /** Reads hops written by writeTo() if they cover a buffer of this shape; otherwise leaves the levels cleared */
+        bool readFrom (juce::InputStream& input, int expectedChannels, int64_t expectedSamples);
+
+    private:
+        void computeHops (const juce::AudioBuffer<float>& buffer, int firstHop, int endHop);
+
+        int hopSamples = 0;
+        int64_t numSamples = 0;
+        std::vector<std::vector<float>> sumSquares;  // Per channel, per hop
+        std::vector<std::vector<float>> peaks;
+    };
+
     //==============================================================================
     TrackDetector();
 
@@ -47,6 +132,29 @@ public:
                                              double sampleRate,
                                              const DetectionSettings& settings);
 
+    /**
+     * Detect track boundaries in [startSample, endSample) from precomputed
+     * levels, built for settings.rmsWindowSamples. A scan of the levels only,
+     * cheap enough to repeat while a threshold is being dragged. Ranges are
+     * measured on the levels' hop grid; a negative endSample means the end.
+     */
+    std::vector<TrackBoundary> detectTracks (const WindowLevels& levels,
+                                             double sampleRate,
+                                             const DetectionSettings& settings,
+                                             int64_t startSample = 0,
+                                             int64_t endSample = -1);
+
+    /**
+     * Up to maxRegions non-overlapping regions of regionSamples where the
+     * envelope is quietest, quietest first: lead-in grooves, gaps between
+     * tracks. Windows of digital silence are never picked, as they hold no
+     * noise to measure. Regions are in samples and may overrun the end of the
+     * audio by up to a window; empty if the envelope has no such region.
+     */
+    static std::vector<juce::Range<int64_t>> findQuietestRegions (const LevelEnvelope& envelope,
+                                                                   int64_t regionSamples,
+                                                                   int maxRegions);
+
     /** Add manual track boundary */
     void addManualBoundary (int64_t position, const juce::String& name = juce::String());
 
@@ -65,26 +173,35 @@ public:
     /** Set track names (in order) for export */
     void setTrackNames (const juce::StringArray& names);
 
+    /** Ranges of a source of numSamples that splitIntoTracks() would copy, in order */
+    std::vector<TrackRange> getTrackRanges (int64_t numSamples, double sampleRate, bool applyFades = true);
+
     /** Split audio buffer into separate track buffers based on boundaries */
     std::vector<juce::AudioBuffer<float>> splitIntoTracks (const juce::AudioBuffer<float>& buffer,
                                                            double sampleRate,
                                                            bool applyFades = true);
 
-    /** Export individual tracks to files */
+    /**
+     * Export individual tracks to files (wav, flac, ogg, or mp3 when built with
+     * LAME). Tracks are encoded concurrently on a pool, each written straight
+     * from its range of buffer with the fades applied on the way out, so nothing
+     * is copied. Blocks the calling thread, which receives the progress; on
+     * cancel or failure the files of unfinished tracks are deleted.
+     */
     bool exportTracks (const juce::AudioBuffer<float>& buffer,
                       double sampleRate,
                       const juce::File& outputDirectory,
                       const juce::String& baseName,
-                      const juce::String& extension = "wav");
+                      const juce::String& extension = "wav",
+                      ExportProgressCallback progressCallback = nullptr);
 
 private:
-    float calculateRMS (const juce::AudioBuffer<float>& buffer, int channel,
-                       int startSample, int numSamples);
+    void applyFadeInOut (juce::AudioBuffer<float>& buffer, int fadeSamples);
 
-    float calculatePeak (const juce::AudioBuffer<float>& buffer, int channel,
-                        int startSample, int numSamples);
+    /** Fade gain of sample index in a track of length samples, as applyFadeInOut() applies it */
+    static float getFadeGain (int64_t index, int64_t length, int fadeSamples);
 
-    void applyFadeInOut (juce::AudioBuffer<float>& buffer, int fadeSamples);
+    juce::String getTrackName (size_t index, size_t numTracks, const juce::String& baseName) const;
 
     void sortBoundaries();
 
@@ -1,5 +1,7 @@
 #include "AudioFileManager.h"
 #include "LameMP3AudioFormat.h"
+#include "SessionFile.h"
+#include <atomic>
 
 AudioFileManager::AudioFileManager()
 {
@@ -56,14 +58,11 @@ bool AudioFileManager::loadAudioFileWithProgress (const juce::File& file,
             return false;  // User cancelled
     }
 
-    // Create reader for the file
-    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+    // Create reader for the file (mapped for PCM WAV/AIFF)
+    std::unique_ptr<juce::AudioFormatReader> reader (createReaderFor (file));
 
     if (reader == nullptr)
-    {
-        DBG ("Could not create reader for file: " + file.getFullPathName());
         return false;
-    }
 
     // Get file properties
     sampleRate = reader->sampleRate;
@@ -98,6 +97,12 @@ bool AudioFileManager::loadAudioFileWithProgress (const juce::File& file,
             return false;
     }
 
+    // Long files in formats that seek sample-accurately decode in segments, in parallel
+    const int numSegments = getNumDecodeSegments (file, lengthInSamples, sampleRate);
+
+    if (numSegments > 1)
+        return readInSegments (file, buffer, numSegments, progressCallback);
+
     // Read in chunks with progress reporting
     const juce::int64 chunkSize = 1024 * 1024;  // 1M samples per chunk (~4MB for stereo float)
     juce::int64 samplesRead = 0;
@@ -141,17 +146,158 @@ bool AudioFileManager::loadAudioFileWithProgress (const juce::File& file,
     return true;
 }
 
-bool AudioFileManager::saveAudioFile (const juce::File& file,
-                                      const juce::AudioBuffer<float>& buffer,
-                                      double sampleRate,
-                                      int bitDepth)
+int AudioFileManager::getNumDecodeSegments (const juce::File& file, juce::int64 lengthInSamples, double sampleRate)
 {
-    if (buffer.getNumSamples() == 0)
+    // FLAC (seektable or binary search), Vorbis and PCM readers all seek to the exact
+    // sample. The mpg123 reader decodes from the start to seek, so MP3 stays serial.
+    juce::String extension = file.getFileExtension().toLowerCase();
+
+    if (extension != ".flac" && extension != ".ogg" && extension != ".wav"
+        && extension != ".aif" && extension != ".aiff")
+        return 1;
+
+    // Segments shorter than this spend too much of their time seeking
+    const auto minSegmentLength = juce::jmax (static_cast<juce::int64> (1), static_cast<juce::int64> (sampleRate * 30.0));
+
+    return static_cast<int> (juce::jlimit (static_cast<juce::int64> (1),
+                                           static_cast<juce::int64> (juce::SystemStats::getNumCpus()),
+                                           lengthInSamples / minSegmentLength));
+}
+
+bool AudioFileManager::readInSegments (const juce::File& file,
+                                       juce::AudioBuffer<float>& buffer,
+                                       int numSegments,
+                                       ProgressCallback progressCallback)
+{
+    const auto lengthInSamples = static_cast<juce::int64> (buffer.getNumSamples());
+    const int numChannels = buffer.getNumChannels();
+
+    // One reader per segment, opened here so the workers share no decoder state
+    std::vector<std::unique_ptr<juce::AudioFormatReader>> readers;
+
+    for (int segment = 0; segment < numSegments; ++segment)
     {
-        DBG ("Cannot save empty buffer");
+        readers.push_back (createReaderFor (file));
+
+        if (readers.back() == nullptr)
+        {
+            buffer.setSize (0, 0);
+            return false;
+        }
+    }
+
+    DBG ("Decoding in " + juce::String (numSegments) + " parallel segments");
+
+    const juce::int64 chunkSize = 1024 * 1024;  // 1M samples per chunk, as in the serial read
+    float* const* destChannels = buffer.getArrayOfWritePointers();
+    std::atomic<juce::int64> samplesRead {0};
+    std::atomic<bool> cancelled {false};
+
+    juce::ThreadPool pool (numSegments);
+
+    for (int segment = 0; segment < numSegments; ++segment)
+    {
+        const juce::int64 segmentStart = lengthInSamples * segment / numSegments;
+        const juce::int64 segmentEnd = lengthInSamples * (segment + 1) / numSegments;
+        auto* reader = readers[(size_t) segment].get();
+
+        pool.addJob ([reader, destChannels, numChannels, segmentStart, segmentEnd, chunkSize, &samplesRead, &cancelled]
+        {
+            for (auto position = segmentStart; position < segmentEnd && !cancelled; position += chunkSize)
+            {
+                const auto samplesToRead = static_cast<int> (juce::jmin (chunkSize, segmentEnd - position));
+
+                // A buffer of its own over this chunk of the destination, so nothing is shared
+                juce::AudioBuffer<float> region (destChannels, numChannels, static_cast<int> (position), samplesToRead);
+                reader->read (&region, 0, samplesToRead, position, true, true);
+
+                samplesRead += samplesToRead;
+            }
+
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    // Progress (10% to 95% for reading) comes from all the workers
+    while (pool.getNumJobs() > 0)
+    {
+        juce::Thread::sleep (20);
+
+        if (progressCallback && !cancelled)
+        {
+            double progress = 0.1 + 0.85 * (static_cast<double> (samplesRead.load()) / static_cast<double> (lengthInSamples));
+            int percent = static_cast<int> (progress * 100.0);
+            juce::String status = "Reading audio... " + juce::String (percent) + "%";
+
+            if (!progressCallback (progress, status))
+                cancelled = true;
+        }
+    }
+
+    if (cancelled)
+    {
+        DBG ("Loading cancelled by user");
+        buffer.setSize (0, 0);  // Clear partial buffer
         return false;
     }
 
+    if (progressCallback)
+    {
+        progressCallback (1.0, "Complete!");
+    }
+
+    DBG ("Audio file loaded successfully");
+    return true;
+}
+
+std::unique_ptr<juce::AudioFormatReader> AudioFileManager::createReaderFor (const juce::File& file)
+{
+    if (!file.existsAsFile())
+    {
+        DBG ("Audio file does not exist: " + file.getFullPathName());
+        return nullptr;
+    }
+
+    if (auto mappedReader = createMemoryMappedReaderFor (file))
+        return mappedReader;
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+    if (reader == nullptr)
+        DBG ("Could not create reader for file: " + file.getFullPathName());
+
+    return reader;
+}
+
+std::unique_ptr<juce::MemoryMappedAudioFormatReader> AudioFileManager::createMemoryMappedReaderFor (const juce::File& file)
+{
+    juce::String extension = file.getFileExtension().toLowerCase();
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+
+    if (extension == ".wav")
+        reader.reset (juce::WavAudioFormat().createMemoryMappedReader (file));
+    else if (extension == ".aif" || extension == ".aiff")
+        reader.reset (juce::AiffAudioFormat().createMemoryMappedReader (file));
+
+    // Compressed or odd layouts have no mapped reader; a file too big for the
+    // address space cannot be mapped whole. Both fall back to a stream reader.
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+        return nullptr;
+
+    if (!reader->mapEntireFile())
+    {
+        DBG ("Could not map audio file, reading it as a stream: " + file.getFullPathName());
+        return nullptr;
+    }
+
+    return reader;
+}
+
+std::unique_ptr<juce::AudioFormatWriter> AudioFileManager::createWriterFor (const juce::File& file,
+                                                                            double sampleRate,
+                                                                            int numChannels,
+                                                                            int bitDepth)
+{
     // Delete existing file
     if (file.existsAsFile())
     {
@@ -164,7 +310,7 @@ bool AudioFileManager::saveAudioFile (const juce::File& file,
     if (outputStream == nullptr)
     {
         DBG ("Could not create output stream for: " + file.getFullPathName());
-        return false;
+        return nullptr;
     }
 
     // Determine format from file extension
@@ -202,14 +348,14 @@ bool AudioFileManager::saveAudioFile (const juce::File& file,
         DBG ("Supported formats: WAV, FLAC, OGG");
         DBG ("Install LAME for MP3 writing: sudo pacman -S lame");
         #endif
-        return false;
+        return nullptr;
     }
 
     // Create writer
     std::unique_ptr<juce::AudioFormatWriter> writer;
     writer.reset (format->createWriterFor (outputStream.get(),
                                            sampleRate,
-                                           (unsigned int) buffer.getNumChannels(),
+                                           (unsigned int) numChannels,
                                            bitDepth,
                                            {},              // metadata
                                            qualityOption)); // quality option (for MP3: 0=128, 1=192, 2=256, 3=320 kbps)
@@ -217,11 +363,57 @@ bool AudioFileManager::saveAudioFile (const juce::File& file,
     if (writer == nullptr)
     {
         DBG ("Could not create writer for: " + file.getFullPathName());
-        return false;
+        return nullptr;
     }
 
     // Release ownership of the stream to the writer
     outputStream.release();
+    return writer;
+}
+
+bool AudioFileManager::saveAudioFile (const juce::File& file,
+                                      const juce::AudioBuffer<float>& buffer,
+                                      double sampleRate,
+                                      int bitDepth)
+{
+    if (buffer.getNumSamples() == 0)
+    {
+        DBG ("Cannot save empty buffer");
+        return false;
+    }
+
+    #if USE_LAME
+    // The whole buffer is here, so long MP3s encode in segments on all cores
+    if (file.hasFileExtension (".mp3"))
+    {
+        if (file.existsAsFile())
+            file.deleteFile();
+
+        std::unique_ptr<juce::FileOutputStream> outputStream (file.createOutputStream());
+
+        if (outputStream == nullptr)
+        {
+            DBG ("Could not create output stream for: " + file.getFullPathName());
+            return false;
+        }
+
+        const bool encoded = LameMP3AudioFormat::encodeInSegments (buffer, 0, buffer.getNumSamples(), sampleRate,
+                                                                   3, *outputStream);  // Best quality (320 kbps), as createWriterFor()
+        outputStream.reset();
+
+        if (encoded)
+            DBG ("Audio file saved successfully");
+        else
+            DBG ("Failed to write audio data");
+
+        return encoded;
+    }
+    #endif
+
+    auto writer = createWriterFor (file, sampleRate, buffer.getNumChannels(), bitDepth);
+
+    if (writer == nullptr)
+        return false;
 
     DBG ("Saving audio file:");
     DBG ("  Path: " + file.getFullPathName());
@@ -303,20 +495,10 @@ bool AudioFileManager::saveSession (const juce::File& sessionFile,
         return false;
     }
 
-    // Create JSON object for session
-    juce::DynamicObject::Ptr sessionObject = new juce::DynamicObject();
-
-    sessionObject->setProperty ("audioFile", audioFile.getFullPathName());
-    sessionObject->setProperty ("timestamp", juce::Time::getCurrentTime().toISO8601 (true));
-    sessionObject->setProperty ("fileSize", audioFile.getSize());
-    sessionObject->setProperty ("sessionData", sessionData);
+    SessionFile::Writer writer (audioFile);
+    writer.setSettings (sessionData);
 
-    juce::var sessionVar (sessionObject.get());
-
-    // Write JSON to file
-    juce::String jsonString = juce::JSON::toString (sessionVar, true);
-
-    bool success = sessionFile.replaceWithText (jsonString);
+    bool success = writer.writeTo (sessionFile);
 
     if (success)
         DBG ("Session saved: " + sessionFile.getFullPathName());
@@ -330,42 +512,55 @@ bool AudioFileManager::loadSession (const juce::File& sessionFile,
                                     juce::File& audioFile,
                                     juce::var& sessionData)
 {
-    if (!sessionFile.existsAsFile())
-    {
-        DBG ("Session file does not exist: " + sessionFile.getFullPathName());
+    auto session = openSession (sessionFile);
+
+    if (session == nullptr)
         return false;
-    }
 
-    // Read JSON from file
-    juce::String jsonString = sessionFile.loadFileAsString();
-    juce::var sessionVar = juce::JSON::parse (jsonString);
+    audioFile = session->getAudioFile();
 
-    if (!sessionVar.isObject())
+    if (!audioFile.existsAsFile())
     {
-        DBG ("Invalid session file format");
+        DBG ("Audio file referenced in session does not exist: " + audioFile.getFullPathName());
         return false;
     }
 
-    juce::DynamicObject* sessionObject = sessionVar.getDynamicObject();
+    sessionData = session->getSettings();
+    return true;
+}
 
-    if (sessionObject == nullptr)
+std::unique_ptr<SessionFile> AudioFileManager::openSession (const juce::File& sessionFile)
+{
+    if (!sessionFile.existsAsFile())
     {
-        DBG ("Could not parse session object");
-        return false;
+        DBG ("Session file does not exist: " + sessionFile.getFullPathName());
+        return nullptr;
     }
 
-    // Extract audio file path
-    juce::String audioFilePath = sessionObject->getProperty ("audioFile").toString();
-    audioFile = juce::File (audioFilePath);
+    std::unique_ptr<SessionFile> session;
 
-    if (!audioFile.existsAsFile())
+    if (SessionFile::isBinarySession (sessionFile))
     {
-        DBG ("Audio file referenced in session does not exist: " + audioFilePath);
-        return false;
+        session = std::make_unique<SessionFile> (sessionFile);
+
+        if (!session->isValid())
+            session.reset();
+    }
+    else
+    {
+        // Sessions saved before the binary format, and JSON exported for interchange
+        session = SessionFile::fromJSON (juce::JSON::parse (sessionFile));
+    }
+
+    if (session == nullptr)
+    {
+        DBG ("Invalid session file format");
+        return nullptr;
     }
 
     // Verify file hasn't changed (optional check using file size)
-    juce::int64 expectedSize = sessionObject->getProperty ("fileSize");
+    const auto audioFile = session->getAudioFile();
+    juce::int64 expectedSize = session->getAudioFileSize();
     juce::int64 actualSize = audioFile.getSize();
 
     if (expectedSize != actualSize)
@@ -375,12 +570,9 @@ bool AudioFileManager::loadSession (const juce::File& sessionFile,
         DBG ("  Actual: " + juce::String (actualSize) + " bytes");
     }
 
-    // Extract session data
-    sessionData = sessionObject->getProperty ("sessionData");
-
     DBG ("Session loaded: " + sessionFile.getFullPathName());
     DBG ("  Audio file: " + audioFile.getFullPathName());
-    DBG ("  Timestamp: " + sessionObject->getProperty ("timestamp").toString());
+    DBG ("  Timestamp: " + session->getTimestamp().toISO8601 (true));
 
-    return true;
+    return session;
 }
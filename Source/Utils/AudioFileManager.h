@@ -3,6 +3,9 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_core/juce_core.h>
 #include <functional>
+#include <memory>
+
+class SessionFile;
 
 /**
  * Audio File Manager
@@ -23,12 +26,13 @@ public:
     /** Progress callback: (progress 0.0-1.0, statusMessage) -> shouldContinue */
     using ProgressCallback = std::function<bool(double progress, const juce::String& status)>;
 
-    /** Load audio file (WAV, FLAC, MP3, OGG) */
+    /** Load audio file (WAV, FLAC, MP3, OGG); PCM WAV/AIFF convert straight from a mapping of the file */
     bool loadAudioFile (const juce::File& file,
                         juce::AudioBuffer<float>& buffer,
                         double& sampleRate);
 
-    /** Load audio file with progress reporting */
+    /** Load audio file with progress reporting. Long FLAC, Ogg, WAV and AIFF files are
+        decoded in segments on all cores; progressCallback is still called on this thread. */
     bool loadAudioFileWithProgress (const juce::File& file,
                                     juce::AudioBuffer<float>& buffer,
                                     double& sampleRate,
@@ -40,6 +44,25 @@ public:
                         double sampleRate,
                         int bitDepth = 16);
 
+    /** Opens a file for reading in blocks, or returns nullptr (for streaming large files).
+        PCM WAV and AIFF come back memory-mapped (see createMemoryMappedReaderFor()). */
+    std::unique_ptr<juce::AudioFormatReader> createReaderFor (const juce::File& file);
+
+    /**
+     * Maps a PCM WAV or AIFF file whole and returns a reader on the mapping, or
+     * nullptr for other formats and files that cannot be mapped. Nothing is read
+     * up front: samples are converted as they are read, from pages the OS loads
+     * on first touch and shares with every other reader of the file.
+     */
+    static std::unique_ptr<juce::MemoryMappedAudioFormatReader> createMemoryMappedReaderFor (const juce::File& file);
+
+    /** Replaces a file with an empty one to write in blocks, in the format its
+        extension names (as saveAudioFile() does), or returns nullptr */
+    static std::unique_ptr<juce::AudioFormatWriter> createWriterFor (const juce::File& file,
+                                                                     double sampleRate,
+                                                                     int numChannels,
+                                                                     int bitDepth = 16);
+
     struct Metadata
     {
         juce::String title;
@@ -60,17 +83,28 @@ public:
                                     int quality = 3);
 
     //==============================================================================
-    /** Save session file (corrections, settings) as JSON */
+    /** Save a session of settings only, in the binary format (see SessionFile::Writer for the rest) */
     bool saveSession (const juce::File& sessionFile,
                       const juce::File& audioFile,
                       const juce::var& sessionData);
 
-    /** Load session file from JSON */
+    /** Load a session's audio file and settings, binary or JSON */
     bool loadSession (const juce::File& sessionFile,
                       juce::File& audioFile,
                       juce::var& sessionData);
 
+    /** Opens a binary session mapped, or converts a JSON one; nullptr if it is neither */
+    static std::unique_ptr<SessionFile> openSession (const juce::File& sessionFile);
+
 private:
+    static int getNumDecodeSegments (const juce::File& file, juce::int64 lengthInSamples, double sampleRate);
+
+    /** Decodes segments of the file on a pool, each with its own reader, into their regions of buffer */
+    bool readInSegments (const juce::File& file,
+                         juce::AudioBuffer<float>& buffer,
+                         int numSegments,
+                         ProgressCallback progressCallback);
+
     juce::AudioFormatManager formatManager;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFileManager)
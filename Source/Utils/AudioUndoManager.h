@@ -2,17 +2,30 @@
 
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_core/juce_core.h>
+#include "BufferSplice.h"
+#include "UndoSpillStore.h"
+#include <algorithm>
 #include <deque>
+#include <vector>
 
 /**
  * Audio Undo Manager
  *
  * Manages undo/redo history for audio editing operations.
- * Stores snapshots of audio buffer states with descriptions.
+ * Stores the previous contents of the regions each operation changed,
+ * with descriptions.
  *
  * Memory management:
  * - Limits number of undo states to prevent excessive memory usage
- * - Each state stores a complete copy of the audio buffer
+ * - A state keeps only the samples its operation changed: a selection-scoped
+ *   process costs the selection, a click repair the clicks, a cut the cut
+ *   samples. saveState() still copies the whole buffer, for operations that
+ *   replace it.
+ * - Undo and redo swap the saved samples with the current ones in place, so
+ *   each state is always the inverse of the edit that follows it
+ * - Only the newest states of either stack stay in memory, and only while they
+ *   fit the memory budget; older ones are compressed to a temporary file by
+ *   UndoSpillStore and read back when undo or redo reaches them
  */
 class AudioUndoManager
 {
@@ -23,27 +36,275 @@ public:
     }
 
     //==============================================================================
-    /** Save current state before making changes */
+    /**
+     * One undo state: the regions an operation is about to change, each saved
+     * before it changes. Regions are restored last to first, so one may
+     * overlap or follow another that changed the length; a region's position
+     * is in the buffer as it is when the region is saved.
+     *
+     * Can be filled on the thread that does the processing and added from the
+     * message thread with addEdit().
+     */
+    class Edit
+    {
+    public:
+        Edit (const juce::String& editDescription, double editSampleRate)
+            : description (editDescription), sampleRate (editSampleRate)
+        {
+        }
+
+        Edit (Edit&&) = default;
+        Edit& operator= (Edit&&) = default;
+
+        /** Saves buffer[startSample, startSample + numSamples) before it is changed in place */
+        void saveRegion (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+        {
+            startSample = juce::jlimit (0, buffer.getNumSamples(), startSample);
+            numSamples = juce::jlimit (0, buffer.getNumSamples() - startSample, numSamples);
+
+            if (numSamples == 0)
+                return;
+
+            // A region that continues the previous one only needs the samples past its end
+            if (!regions.empty())
+            {
+                auto& last = regions.back();
+                const int lastEnd = last.startSample + last.numSamplesAfter;
+
+                if (!last.wholeBuffer && last.isInPlace() && startSample >= last.startSample && startSample <= lastEnd)
+                {
+                    const int extra = startSample + numSamples - lastEnd;
+
+                    if (extra > 0)
+                    {
+                        last.previous.setSize (last.previous.getNumChannels(), last.numSamplesAfter + extra, true, false, true);
+
+                        for (int channel = 0; channel < last.previous.getNumChannels(); ++channel)
+                            last.previous.copyFrom (channel, last.numSamplesAfter, buffer, channel, lastEnd, extra);
+
+                        last.numSamplesAfter += extra;
+                    }
+
+                    return;
+                }
+            }
+
+            saveSplice (buffer, startSample, numSamples, numSamples);
+        }
+
+        /** Saves buffer[startSample, startSample + numSamplesToReplace) before it is replaced by numReplacementSamples new samples */
+        void saveSplice (const juce::AudioBuffer<float>& buffer, int startSample, int numSamplesToReplace, int numReplacementSamples)
+        {
+            startSample = juce::jlimit (0, buffer.getNumSamples(), startSample);
+            numSamplesToReplace = juce::jlimit (0, buffer.getNumSamples() - startSample, numSamplesToReplace);
+
+            Region region;
+            region.startSample = startSample;
+            region.numSamplesAfter = juce::jmax (0, numReplacementSamples);
+            region.previous.setSize (buffer.getNumChannels(), numSamplesToReplace);
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                region.previous.copyFrom (channel, 0, buffer, channel, startSample, numSamplesToReplace);
+
+            regions.push_back (std::move (region));
+        }
+
+        /** Saves the whole buffer, for an operation that replaces it (any length or channel count) */
+        void saveWholeBuffer (const juce::AudioBuffer<float>& buffer)
+        {
+            Region region;
+            region.wholeBuffer = true;
+            region.previous.makeCopyOf (buffer);
+            regions.push_back (std::move (region));
+        }
+
+        /** Takes over the regions of another edit of the same buffer; any that overlap these must have been saved after them */
+        void append (Edit&& other)
+        {
+            jassert (other.spilled == nullptr);
+
+            for (auto& region : other.regions)
+                regions.push_back (std::move (region));
+
+            other.regions.clear();
+        }
+
+        bool isEmpty() const { return regions.empty(); }
+
+        /** True while the saved samples are in the spill store rather than in memory */
+        bool isSpilled() const { return spilled != nullptr; }
+
+        const juce::String& getDescription() const { return description; }
+
+        /** Memory held by the saved samples (none while spilled) */
+        size_t getNumBytes() const
+        {
+            size_t total = 0;
+
+            for (const auto& region : regions)
+                total += static_cast<size_t> (region.previous.getNumChannels())
+                       * static_cast<size_t> (region.previous.getNumSamples()) * sizeof (float);
+
+            return total;
+        }
+
+    private:
+        friend class AudioUndoManager;
+
+        struct Region
+        {
+            bool isInPlace() const { return previous.getNumSamples() == numSamplesAfter; }
+
+            int startSample = 0;
+            int numSamplesAfter = 0;            // Samples that replaced previous in the buffer
+            bool wholeBuffer = false;           // previous is the entire buffer
+            juce::AudioBuffer<float> previous;
+        };
+
+        /** Moves the saved samples to the spill store */
+        void spill (UndoSpillStore& store)
+        {
+            if (spilled != nullptr || regions.empty())
+                return;
+
+            std::vector<juce::AudioBuffer<float>> buffers;
+            buffers.reserve (regions.size());
+
+            for (auto& region : regions)
+                buffers.push_back (std::move (region.previous));
+
+            spilled = store.spill (std::move (buffers));
+        }
+
+        /** Brings spilled samples back; false if they cannot be read */
+        bool unspill (UndoSpillStore& store)
+        {
+            if (spilled == nullptr)
+                return true;
+
+            std::vector<juce::AudioBuffer<float>> buffers;
+
+            if (!store.reload (spilled, buffers) || buffers.size() != regions.size())
+                return false;
+
+            for (size_t i = 0; i < regions.size(); ++i)
+                regions[i].previous = std::move (buffers[i]);
+
+            spilled.reset();
+            return true;
+        }
+
+        /** Restores the regions into buffer and returns the edit that puts them back */
+        Edit revert (juce::AudioBuffer<float>& buffer, double& bufferSampleRate)
+        {
+            Edit inverse (description, bufferSampleRate);
+
+            for (auto it = regions.rbegin(); it != regions.rend(); ++it)
+            {
+                auto& region = *it;
+                Region restored;
+                restored.startSample = region.startSample;
+                restored.wholeBuffer = region.wholeBuffer;
+                restored.numSamplesAfter = region.previous.getNumSamples();
+
+                if (region.wholeBuffer)
+                {
+                    std::swap (buffer, region.previous);
+                    restored.previous = std::move (region.previous);
+                }
+                else
+                {
+                    const int start = juce::jlimit (0, buffer.getNumSamples(), region.startSample);
+                    const int numAfter = juce::jlimit (0, buffer.getNumSamples() - start, region.numSamplesAfter);
+                    const int numChannels = juce::jmin (buffer.getNumChannels(), region.previous.getNumChannels());
+                    jassert (numAfter == region.numSamplesAfter && numChannels == buffer.getNumChannels());
+
+                    if (region.isInPlace() && numAfter == region.numSamplesAfter)
+                    {
+                        // Same length: the saved and current samples trade places
+                        for (int channel = 0; channel < numChannels; ++channel)
+                        {
+                            auto* current = buffer.getWritePointer (channel, start);
+                            std::swap_ranges (current, current + numAfter, region.previous.getWritePointer (channel));
+                        }
+
+                        restored.previous = std::move (region.previous);
+                    }
+                    else
+                    {
+                        restored.previous.setSize (buffer.getNumChannels(), numAfter);
+
+                        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                            restored.previous.copyFrom (channel, 0, buffer, channel, start, numAfter);
+
+                        BufferSplice::replace (buffer, start, numAfter, region.previous);
+                    }
+                }
+
+                inverse.regions.push_back (std::move (restored));
+            }
+
+            // The inverse holds the regions last to first, each saved in the buffer as this loop
+            // left it; restoring it last to first redoes them first to last, in the buffers they
+            // were saved in
+            regions.clear();
+
+            bufferSampleRate = sampleRate;
+            return inverse;
+        }
+
+        juce::String description;
+        double sampleRate = 44100.0;
+        juce::Time timestamp = juce::Time::getCurrentTime();
+        std::vector<Region> regions;
+        UndoSpillStore::Handle spilled;
+    };
+
+    //==============================================================================
+    /** Save current state before making changes (whole-buffer copy) */
     void saveState (const juce::AudioBuffer<float>& buffer, double sampleRate, const juce::String& description)
     {
-        // Clear any redo states when new action is performed
-        while (!redoStack.empty())
-            redoStack.pop_back();
+        Edit edit (description, sampleRate);
+        edit.saveWholeBuffer (buffer);
+        addEdit (std::move (edit));
+    }
+
+    /** Save buffer[startSample, startSample + numSamples) before changing it in place */
+    void saveRegion (const juce::AudioBuffer<float>& buffer, double sampleRate, const juce::String& description,
+                     int startSample, int numSamples)
+    {
+        Edit edit (description, sampleRate);
+        edit.saveRegion (buffer, startSample, numSamples);
+        addEdit (std::move (edit));
+    }
+
+    /** Save buffer[startSample, startSample + numSamplesToReplace) before replacing it by numReplacementSamples new ones */
+    void saveSplice (const juce::AudioBuffer<float>& buffer, double sampleRate, const juce::String& description,
+                     int startSample, int numSamplesToReplace, int numReplacementSamples)
+    {
+        Edit edit (description, sampleRate);
+        edit.saveSplice (buffer, startSample, numSamplesToReplace, numReplacementSamples);
+        addEdit (std::move (edit));
+    }
 
-        // Create state snapshot
-        UndoState state;
-        state.buffer.makeCopyOf (buffer);
-        state.sampleRate = sampleRate;
-        state.description = description;
-        state.timestamp = juce::Time::getCurrentTime();
+    /** Add an edit whose regions were saved as the operation ran (it has already been applied) */
+    void addEdit (Edit&& edit)
+    {
+        // Clear any redo states when new action is performed
+        redoStack.clear();
 
-        undoStack.push_back (std::move (state));
+        const auto description = edit.getDescription();
+        const auto numBytes = edit.getNumBytes();
+        undoStack.push_back (std::move (edit));
 
         // Limit stack size
         while (undoStack.size() > static_cast<size_t> (maxStates))
             undoStack.pop_front();
 
-        DBG ("Undo state saved: " + description + " (stack size: " + juce::String (undoStack.size()) + ")");
+        enforceMemoryBudget();
+
+        DBG ("Undo state saved: " + description + " (" + juce::String (static_cast<juce::int64> (numBytes / 1024)) + " KB, stack size: "
+             + juce::String (undoStack.size()) + ")");
     }
 
     //==============================================================================
@@ -77,56 +338,39 @@ public:
 
     //==============================================================================
     /** Perform undo - returns true if successful */
-    bool undo (juce::AudioBuffer<float>& currentBuffer, double& currentSampleRate,
-               const juce::String& currentDescription = "Current state")
+    bool undo (juce::AudioBuffer<float>& currentBuffer, double& currentSampleRate)
     {
         if (undoStack.empty())
             return false;
 
-        // Save current state to redo stack
-        UndoState currentState;
-        currentState.buffer.makeCopyOf (currentBuffer);
-        currentState.sampleRate = currentSampleRate;
-        currentState.description = currentDescription;
-        currentState.timestamp = juce::Time::getCurrentTime();
-        redoStack.push_back (std::move (currentState));
-
-        // Restore previous state
-        UndoState& previousState = undoStack.back();
-        currentBuffer.makeCopyOf (previousState.buffer);
-        currentSampleRate = previousState.sampleRate;
+        if (!undoStack.back().unspill (spillStore))
+            return false;
 
-        juce::String desc = previousState.description;
+        // Restoring the regions gives the redo state for them
+        auto inverse = undoStack.back().revert (currentBuffer, currentSampleRate);
         undoStack.pop_back();
 
-        DBG ("Undo performed: " + desc);
+        DBG ("Undo performed: " + inverse.description);
+        redoStack.push_back (std::move (inverse));
+        enforceMemoryBudget();
         return true;
     }
 
     /** Perform redo - returns true if successful */
-    bool redo (juce::AudioBuffer<float>& currentBuffer, double& currentSampleRate,
-               const juce::String& currentDescription = "Current state")
+    bool redo (juce::AudioBuffer<float>& currentBuffer, double& currentSampleRate)
     {
         if (redoStack.empty())
             return false;
 
-        // Save current state to undo stack
-        UndoState currentState;
-        currentState.buffer.makeCopyOf (currentBuffer);
-        currentState.sampleRate = currentSampleRate;
-        currentState.description = currentDescription;
-        currentState.timestamp = juce::Time::getCurrentTime();
-        undoStack.push_back (std::move (currentState));
-
-        // Restore next state
-        UndoState& nextState = redoStack.back();
-        currentBuffer.makeCopyOf (nextState.buffer);
-        currentSampleRate = nextState.sampleRate;
+        if (!redoStack.back().unspill (spillStore))
+            return false;
 
-        juce::String desc = nextState.description;
+        auto inverse = redoStack.back().revert (currentBuffer, currentSampleRate);
         redoStack.pop_back();
 
-        DBG ("Redo performed: " + desc);
+        DBG ("Redo performed: " + inverse.description);
+        undoStack.push_back (std::move (inverse));
+        enforceMemoryBudget();
         return true;
     }
 
@@ -162,6 +406,39 @@ public:
     /** Get number of redo states */
     int getNumRedoStates() const { return static_cast<int> (redoStack.size()); }
 
+    /**
+     * Keeps at most numResidentStates of each stack in memory, newest first,
+     * and only while they total memoryBudgetBytes; the next undo and redo
+     * state always stay. Older states are spilled to disk.
+     */
+    void setMemoryPolicy (int numResidentStates, size_t memoryBudgetBytes)
+    {
+        residentStates = juce::jmax (1, numResidentStates);
+        memoryBudget = memoryBudgetBytes;
+        enforceMemoryBudget();
+    }
+
+    /** Maximum number of undo states kept */
+    void setMaxStates (int maxUndoStates)
+    {
+        maxStates = juce::jmax (1, maxUndoStates);
+
+        while (undoStack.size() > static_cast<size_t> (maxStates))
+            undoStack.pop_front();
+    }
+
+    /** Memory held by the undo and redo states (spilled states excluded) */
+    size_t getNumBytes() const
+    {
+        size_t total = 0;
+
+        for (const auto* stack : { &undoStack, &redoStack })
+            for (const auto& edit : *stack)
+                total += edit.getNumBytes();
+
+        return total;
+    }
+
     /** Get list of undo descriptions (newest first) */
     juce::StringArray getUndoHistory() const
     {
@@ -181,17 +458,39 @@ public:
     }
 
 private:
-    struct UndoState
+    void enforceMemoryBudget()
     {
-        juce::AudioBuffer<float> buffer;
-        double sampleRate = 44100.0;
-        juce::String description;
-        juce::Time timestamp;
-    };
+        size_t residentBytes = 0;
+
+        // The states nearest the current one are the likeliest to be needed again
+        for (int depth = 0; depth < static_cast<int> (juce::jmax (undoStack.size(), redoStack.size())); ++depth)
+        {
+            for (auto* stack : { &undoStack, &redoStack })
+            {
+                if (depth >= static_cast<int> (stack->size()))
+                    continue;
+
+                auto& edit = (*stack)[stack->size() - 1 - static_cast<size_t> (depth)];
+
+                if (edit.isSpilled())
+                    continue;
+
+                const auto numBytes = edit.getNumBytes();
+
+                if (depth == 0 || (depth < residentStates && residentBytes + numBytes <= memoryBudget))
+                    residentBytes += numBytes;
+                else
+                    edit.spill (spillStore);
+            }
+        }
+    }
 
-    std::deque<UndoState> undoStack;
-    std::deque<UndoState> redoStack;
+    UndoSpillStore spillStore;          // Declared first, so it outlives the states that refer to it
+    std::deque<Edit> undoStack;
+    std::deque<Edit> redoStack;
     int maxStates;
+    int residentStates = 4;
+    size_t memoryBudget = static_cast<size_t> (1024) * 1024 * 1024;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioUndoManager)
 };
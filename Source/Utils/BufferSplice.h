@@ -0,0 +1,78 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cstring>
+
+/**
+ * In-place structural edits of an audio buffer
+ *
+ * Cuts, inserts and replacements that change the length move the audio after
+ * the edit within the buffer's own storage instead of assembling a new
+ * buffer: a cut costs one move of the tail and never allocates, an insert
+ * allocates only when the buffer outgrows its storage.
+ */
+namespace BufferSplice
+{
+    /**
+     * Replaces buffer[startSample, startSample + numToReplace) with
+     * replacement[0, numReplacement). Replacement channels beyond its own
+     * count repeat its last channel; a null replacement inserts silence.
+     */
+    inline void replace (juce::AudioBuffer<float>& buffer, int startSample, int numToReplace,
+                         const juce::AudioBuffer<float>* replacement, int numReplacement)
+    {
+        const int oldLength = buffer.getNumSamples();
+        startSample = juce::jlimit (0, oldLength, startSample);
+        numToReplace = juce::jlimit (0, oldLength - startSample, numToReplace);
+        numReplacement = juce::jmax (0, numReplacement);
+
+        if (replacement != nullptr)
+            numReplacement = juce::jmin (numReplacement, replacement->getNumSamples());
+
+        const int newLength = oldLength - numToReplace + numReplacement;
+        const int tailStart = startSample + numToReplace;
+        const int numChannels = buffer.getNumChannels();
+
+        if (newLength > oldLength)
+            buffer.setSize (numChannels, newLength, true, false, true);
+
+        // Move the audio after the range to where the replacement ends
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = buffer.getWritePointer (channel);
+
+            if (numReplacement != numToReplace)
+                std::memmove (data + startSample + numReplacement, data + tailStart,
+                              static_cast<size_t> (oldLength - tailStart) * sizeof (float));
+
+            const int sourceChannel = replacement != nullptr ? juce::jmin (channel, replacement->getNumChannels() - 1) : -1;
+
+            if (sourceChannel >= 0)
+                buffer.copyFrom (channel, startSample, *replacement, sourceChannel, 0, numReplacement);
+            else
+                buffer.clear (channel, startSample, numReplacement);
+        }
+
+        if (newLength < oldLength)
+            buffer.setSize (numChannels, newLength, true, false, true);
+    }
+
+    /** Replaces buffer[startSample, startSample + numToReplace) with all of replacement */
+    inline void replace (juce::AudioBuffer<float>& buffer, int startSample, int numToReplace,
+                         const juce::AudioBuffer<float>& replacement)
+    {
+        replace (buffer, startSample, numToReplace, &replacement, replacement.getNumSamples());
+    }
+
+    /** Removes buffer[startSample, startSample + numSamples) */
+    inline void erase (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        replace (buffer, startSample, numSamples, nullptr, 0);
+    }
+
+    /** Inserts all of source at position */
+    inline void insert (juce::AudioBuffer<float>& buffer, int position, const juce::AudioBuffer<float>& source)
+    {
+        replace (buffer, position, 0, &source, source.getNumSamples());
+    }
+}
@@ -4,6 +4,8 @@
 
 #if USE_LAME
 #include <lame/lame.h>
+#include <atomic>
+#include <vector>
 #endif
 
 #if USE_MPG123
@@ -124,24 +126,34 @@ public:
         if (!isValid || mh == nullptr)
             return false;
 
-        // Reset and seek to start
-        mpg123_close (mh);
-        mpg123_open_feed (mh);
-        mpg123_feed (mh, static_cast<const unsigned char*> (allData.getData()), allData.getSize());
-
-        // Skip to start position
-        std::vector<unsigned char> tempBuffer (8192);
-        juce::int64 samplesDecoded = 0;
         size_t done;
 
-        while (samplesDecoded < startSampleInFile)
+        // A read that continues where the last one stopped carries on decoding; any
+        // other position resets the decoder and decodes up to it (loading reads in order)
+        if (startSampleInFile != nextSampleInFile)
         {
-            int result = mpg123_read (mh, tempBuffer.data(), tempBuffer.size(), &done);
-            if (result != MPG123_OK && result != MPG123_NEW_FORMAT)
-                break;
+            mpg123_close (mh);
+            mpg123_open_feed (mh);
+            mpg123_feed (mh, static_cast<const unsigned char*> (allData.getData()), allData.getSize());
+
+            // Skip to start position, never past it
+            std::vector<unsigned char> tempBuffer (8192);
+            juce::int64 samplesDecoded = 0;
+
+            while (samplesDecoded < startSampleInFile)
+            {
+                const auto bytesToSkip = static_cast<size_t> (juce::jmin (static_cast<juce::int64> (tempBuffer.size()),
+                                                                          (startSampleInFile - samplesDecoded) * 2 * numChannels));
+
+                int result = mpg123_read (mh, tempBuffer.data(), bytesToSkip, &done);
+                if (result != MPG123_OK && result != MPG123_NEW_FORMAT)
+                    break;
+
+                juce::int64 samplesInBuffer = done / (2 * numChannels);
+                samplesDecoded += samplesInBuffer;
+            }
 
-            juce::int64 samplesInBuffer = done / (2 * numChannels);
-            samplesDecoded += samplesInBuffer;
+            nextSampleInFile = samplesDecoded;
         }
 
         // Now read the requested samples
@@ -163,6 +175,10 @@ public:
             }
         }
 
+        // A short read (end of stream, decode error) restarts the next read from scratch
+        nextSampleInFile = (nextSampleInFile == startSampleInFile && samplesRead == numSamples)
+                             ? startSampleInFile + numSamples : -1;
+
         // Convert to int and copy to destination
         for (int ch = 0; ch < numDestChannels && ch < static_cast<int> (numChannels); ++ch)
         {
@@ -192,6 +208,7 @@ private:
     mpg123_handle* mh = nullptr;
     juce::InputStream* inputStream;
     juce::MemoryBlock allData;
+    juce::int64 nextSampleInFile = -1;      // Where the decoder stands, or -1 to reset it first
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LameMP3AudioFormatReader)
 };
@@ -203,113 +220,185 @@ private:
 //==============================================================================
 #if USE_LAME
 
-class LameMP3AudioFormatWriter : public juce::AudioFormatWriter
+namespace
 {
-public:
-    LameMP3AudioFormatWriter (juce::OutputStream* destStream,
-                              double sampleRateToUse,
-                              unsigned int numberOfChannels,
-                              int quality)
-        : juce::AudioFormatWriter (destStream, "MP3", sampleRateToUse, numberOfChannels, 16),
-          outputStream (destStream),
-          qualityIndex (quality)
+    constexpr int encodeBlockSize = 8192;   // Samples per lame_encode call, what the MP3 buffer is sized for
+
+    int getBitrateForQuality (int qualityIndex)
+    {
+        // 0 = Low (128 kbps), 1 = Medium (192 kbps), 2 = High (256 kbps), 3 = Best (320 kbps)
+        const int bitrates[] = { 128, 192, 256, 320 };
+        return bitrates[juce::jlimit (0, 3, qualityIndex)];
+    }
+
+    /**
+     * One LAME encoder, fed non-interleaved float channels (no conversion or
+     * interleaving) in blocks, with one MP3 buffer preallocated for a block's
+     * worst case and reused for every call.
+     *
+     * With independentFrames, the bit reservoir is off and no tag frame is
+     * written, so every frame holds all of its own data: frames from separate
+     * encoders can then be spliced at any frame boundary.
+     */
+    class LameEncoder
     {
-        // Initialize LAME
-        lame = lame_init();
-        if (lame == nullptr)
+    public:
+        LameEncoder (double sampleRate, int numChannelsToUse, int qualityIndex, bool independentFrames)
+            : numChannels (juce::jlimit (1, 2, numChannelsToUse))
         {
-            DBG ("LAME initialization failed");
-            return;
-        }
+            lame = lame_init();
+            if (lame == nullptr)
+            {
+                DBG ("LAME initialization failed");
+                return;
+            }
 
-        // Configure LAME
-        lame_set_in_samplerate (lame, static_cast<int> (sampleRateToUse));
-        lame_set_num_channels (lame, static_cast<int> (numberOfChannels));
+            lame_set_in_samplerate (lame, static_cast<int> (sampleRate));
+            lame_set_num_channels (lame, numChannels);
+            lame_set_brate (lame, getBitrateForQuality (qualityIndex));
+            lame_set_mode (lame, numChannels == 1 ? MONO : JOINT_STEREO);
+            lame_set_quality (lame, 2);  // 2 = high quality, reasonably fast
 
-        // Quality presets
-        // 0 = Low (128 kbps), 1 = Medium (192 kbps), 2 = High (256 kbps), 3 = Best (320 kbps)
-        int bitrates[] = {128, 192, 256, 320};
-        int bitrate = bitrates[juce::jlimit (0, 3, quality)];
+            if (independentFrames)
+            {
+                lame_set_disable_reservoir (lame, 1);
+                lame_set_bWriteVbrTag (lame, 0);
+                lame_set_write_id3tag_automatic (lame, 0);
+            }
 
-        lame_set_brate (lame, bitrate);
-        lame_set_mode (lame, numberOfChannels == 1 ? MONO : JOINT_STEREO);
-        lame_set_quality (lame, 2);  // 2 = high quality, reasonably fast
+            if (lame_init_params (lame) < 0)
+            {
+                DBG ("LAME init_params failed");
+                lame_close (lame);
+                lame = nullptr;
+                return;
+            }
 
-        if (lame_init_params (lame) < 0)
-        {
-            DBG ("LAME init_params failed");
-            lame_close (lame);
-            lame = nullptr;
-            return;
+            mp3Buffer.resize (static_cast<size_t> (1.25 * encodeBlockSize + 7200));  // Worst case, from the LAME docs
         }
 
-        mp3Buffer.resize (1.25 * 8192 + 7200);  // Recommended buffer size from LAME docs
-        isValid = true;
+        ~LameEncoder()
+        {
+            if (lame != nullptr)
+                lame_close (lame);
+        }
 
-        DBG ("LAME MP3 writer initialized: " + juce::String (bitrate) + " kbps");
-    }
+        bool isValid() const { return lame != nullptr; }
 
-    ~LameMP3AudioFormatWriter() override
-    {
-        if (lame != nullptr)
+        /** Encodes numSamples and passes the bytes to output (const unsigned char*, int) -> bool */
+        template <typename Output>
+        bool encode (const float* left, const float* right, int numSamples, Output&& output)
         {
-            // Flush remaining data
-            int bytesWritten = lame_encode_flush (lame, mp3Buffer.data(), static_cast<int> (mp3Buffer.size()));
-            if (bytesWritten > 0)
+            // Mono encoders ignore the right channel
+            if (numChannels == 1 || right == nullptr)
+                right = left;
+
+            for (int done = 0; done < numSamples; done += encodeBlockSize)
             {
-                outputStream->write (mp3Buffer.data(), bytesWritten);
+                const int count = juce::jmin (encodeBlockSize, numSamples - done);
+                const int bytes = lame_encode_buffer_ieee_float (lame, left + done, right + done, count,
+                                                                 mp3Buffer.data(), static_cast<int> (mp3Buffer.size()));
+
+                if (bytes < 0)
+                {
+                    DBG ("LAME encoding error: " + juce::String (bytes));
+                    return false;
+                }
+
+                if (bytes > 0 && !output (mp3Buffer.data(), bytes))
+                    return false;
             }
 
-            lame_close (lame);
+            return true;
         }
-    }
 
-    bool write (const int** samplesToWrite, int numSamples) override
+        /** Encodes what LAME still holds, padding the last frame */
+        template <typename Output>
+        bool flush (Output&& output)
+        {
+            const int bytes = lame_encode_flush (lame, mp3Buffer.data(), static_cast<int> (mp3Buffer.size()));
+            return bytes >= 0 && (bytes == 0 || output (mp3Buffer.data(), bytes));
+        }
+
+    private:
+        lame_global_flags* lame = nullptr;
+        const int numChannels;
+        std::vector<unsigned char> mp3Buffer;
+
+        JUCE_DECLARE_NON_COPYABLE (LameEncoder)
+    };
+
+    /** Length of the MPEG audio Layer III frame with this header, or 0 if it is not one */
+    int getFrameLength (const unsigned char* header)
     {
-        if (!isValid || lame == nullptr)
-            return false;
+        if (header[0] != 0xff || (header[1] & 0xe0) != 0xe0 || ((header[1] >> 1) & 3) != 1)
+            return 0;
 
-        // Convert int samples to float
-        std::vector<float> leftChannel (numSamples);
-        std::vector<float> rightChannel (numSamples);
+        const int version = (header[1] >> 3) & 3;          // 3 = MPEG-1, 2 = MPEG-2, 0 = MPEG-2.5
+        const int bitrateIndex = header[2] >> 4;
+        const int rateIndex = (header[2] >> 2) & 3;
+        const int padding = (header[2] >> 1) & 1;
 
-        for (int i = 0; i < numSamples; ++i)
-        {
-            leftChannel[i] = samplesToWrite[0][i] / 2147483648.0f;
-            if (numChannels > 1)
-                rightChannel[i] = samplesToWrite[1][i] / 2147483648.0f;
-            else
-                rightChannel[i] = leftChannel[i];
-        }
+        static const int mpeg1Bitrates[] = { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 };
+        static const int mpeg2Bitrates[] = { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 };
+        static const int sampleRates[4][3] = { { 11025, 12000, 8000 }, { 0, 0, 0 }, { 22050, 24000, 16000 }, { 44100, 48000, 32000 } };
 
-        // Encode
-        int bytesWritten = lame_encode_buffer_ieee_float (lame,
-                                                          leftChannel.data(),
-                                                          rightChannel.data(),
-                                                          numSamples,
-                                                          mp3Buffer.data(),
-                                                          static_cast<int> (mp3Buffer.size()));
+        if (version == 1 || rateIndex == 3)
+            return 0;
 
-        if (bytesWritten > 0)
-        {
-            return outputStream->write (mp3Buffer.data(), bytesWritten);
-        }
-        else if (bytesWritten < 0)
-        {
-            DBG ("LAME encoding error: " + juce::String (bytesWritten));
+        const int bitrate = (version == 3 ? mpeg1Bitrates : mpeg2Bitrates)[bitrateIndex] * 1000;
+        const int sampleRate = sampleRates[version][rateIndex];
+
+        if (bitrate == 0)
+            return 0;
+
+        return (version == 3 ? 144 : 72) * bitrate / sampleRate + padding;
+    }
+}
+
+class LameMP3AudioFormatWriter : public juce::AudioFormatWriter
+{
+public:
+    LameMP3AudioFormatWriter (juce::OutputStream* destStream,
+                              double sampleRateToUse,
+                              unsigned int numberOfChannels,
+                              int quality)
+        : juce::AudioFormatWriter (destStream, "MP3", sampleRateToUse, numberOfChannels, 32),
+          encoder (sampleRateToUse, static_cast<int> (numberOfChannels), quality, false)
+    {
+        // Float in, so LAME takes the caller's channels as they are
+        usesFloatingPointData = true;
+        isValid = encoder.isValid();
+
+        if (isValid)
+            DBG ("LAME MP3 writer initialized: " + juce::String (getBitrateForQuality (quality)) + " kbps");
+    }
+
+    ~LameMP3AudioFormatWriter() override
+    {
+        if (isValid && output != nullptr)
+            encoder.flush ([this] (const unsigned char* data, int numBytes) { return output->write (data, (size_t) numBytes); });
+    }
+
+    bool write (const int** samplesToWrite, int numSamples) override
+    {
+        if (!isValid)
             return false;
-        }
 
-        return true;
+        // usesFloatingPointData: the channels are floats
+        const auto** channels = reinterpret_cast<const float**> (samplesToWrite);
+
+        return encoder.encode (channels[0], numChannels > 1 ? channels[1] : nullptr, numSamples,
+                               [this] (const unsigned char* data, int numBytes) { return output->write (data, (size_t) numBytes); });
     }
 
+    /** Leaves the stream to the caller, for a writer that failed to open */
+    void releaseStream() { output = nullptr; }
+
     bool isValid = false;
 
 private:
-    lame_global_flags* lame = nullptr;
-    juce::OutputStream* outputStream;
-    int qualityIndex;
-    std::vector<unsigned char> mp3Buffer;
+    LameEncoder encoder;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LameMP3AudioFormatWriter)
 };
@@ -404,7 +493,8 @@ std::unique_ptr<juce::AudioFormatWriter> LameMP3AudioFormat::createWriterFor (
     if (writer->isValid)
         return writer;
 
-    // If failed, restore stream ownership
+    // If failed, restore stream ownership (taken back from the writer, so it is not deleted twice)
+    writer->releaseStream();
     streamToWriteTo.reset (rawStream);
 #else
     juce::ignoreUnused (streamToWriteTo, options);
@@ -413,4 +503,124 @@ std::unique_ptr<juce::AudioFormatWriter> LameMP3AudioFormat::createWriterFor (
     return nullptr;
 }
 
+#if USE_LAME
+bool LameMP3AudioFormat::encodeInSegments (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                           double sampleRate, int qualityOptionIndex,
+                                           juce::OutputStream& destination, int numThreads)
+{
+    const int numChannels = juce::jmin (2, buffer.getNumChannels());
+
+    if (numChannels == 0 || numSamples <= 0)
+        return false;
+
+    auto writeTo = [] (juce::OutputStream& stream)
+    {
+        return [&stream] (const unsigned char* data, int numBytes) { return stream.write (data, (size_t) numBytes); };
+    };
+
+    auto getChannel = [&buffer, numChannels] (int channel, int position)
+    {
+        return buffer.getReadPointer (juce::jmin (channel, numChannels - 1), position);
+    };
+
+    // Layer III frames are 1152 samples, 576 for the MPEG-2 sample rates
+    const int frameSize = sampleRate >= 32000.0 ? 1152 : 576;
+    const int totalFrames = (numSamples + frameSize - 1) / frameSize;
+    const int minSegmentFrames = static_cast<int> (30.0 * sampleRate) / frameSize;  // Shorter segments are not worth a thread
+
+    if (numThreads <= 0)
+        numThreads = juce::SystemStats::getNumCpus();
+
+    const int numSegments = juce::jlimit (1, juce::jmax (1, numThreads), totalFrames / juce::jmax (1, minSegmentFrames));
+
+    if (numSegments == 1)
+    {
+        LameEncoder encoder (sampleRate, numChannels, qualityOptionIndex, false);
+
+        return encoder.isValid()
+            && encoder.encode (getChannel (0, startSample), getChannel (1, startSample), numSamples, writeTo (destination))
+            && encoder.flush (writeTo (destination));
+    }
+
+    // Each segment's encoder starts a few frames early so its psychoacoustic
+    // state has settled by the first frame it keeps, and runs a few frames on
+    // so its last kept frame is not shaped by the flush. Input starts on frame
+    // boundaries, so the encoders' frames line up with a single pass's (the
+    // encoder delay is the same for all), and without the bit reservoir no
+    // frame refers to another's data: kept frames splice without gaps.
+    constexpr int preRollFrames = 8;
+    constexpr int postRollFrames = 4;
+
+    std::vector<juce::MemoryOutputStream> segmentData ((size_t) numSegments);
+    std::atomic<bool> failed { false };
+
+    juce::ThreadPool pool (numSegments);
+
+    for (int segment = 0; segment < numSegments; ++segment)
+    {
+        pool.addJob ([&, segment]
+        {
+            const int firstFrame = totalFrames * segment / numSegments;
+            const int endFrame = totalFrames * (segment + 1) / numSegments;
+            const bool isLast = segment == numSegments - 1;
+
+            const int inputFrame = juce::jmax (0, firstFrame - preRollFrames);
+            const int inputStart = inputFrame * frameSize;
+            const int inputEnd = isLast ? numSamples : juce::jmin (numSamples, (endFrame + postRollFrames) * frameSize);
+
+            juce::MemoryOutputStream encoded;
+            LameEncoder encoder (sampleRate, numChannels, qualityOptionIndex, true);
+
+            if (!encoder.isValid()
+                || !encoder.encode (getChannel (0, startSample + inputStart), getChannel (1, startSample + inputStart),
+                                    inputEnd - inputStart, writeTo (encoded))
+                || !encoder.flush (writeTo (encoded)))
+            {
+                failed = true;
+                return juce::ThreadPoolJob::jobHasFinished;
+            }
+
+            // Keep frames [firstFrame, endFrame) of the whole stream; the last segment keeps the tail too
+            const auto* bytes = static_cast<const unsigned char*> (encoded.getData());
+            const auto size = encoded.getDataSize();
+            auto& kept = segmentData[(size_t) segment];
+            int frame = inputFrame;
+
+            for (size_t position = 0; position + 4 <= size && (isLast || frame < endFrame); ++frame)
+            {
+                const int frameLength = getFrameLength (bytes + position);
+
+                if (frameLength == 0 || position + (size_t) frameLength > size)
+                {
+                    DBG ("MP3 segment " + juce::String (segment) + ": unexpected data in the encoded stream");
+                    failed = true;
+                    break;
+                }
+
+                if (frame >= firstFrame)
+                    kept.write (bytes + position, (size_t) frameLength);
+
+                position += (size_t) frameLength;
+            }
+
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep (5);
+
+    if (failed)
+        return false;
+
+    DBG ("Encoded MP3 in " + juce::String (numSegments) + " parallel segments");
+
+    for (auto& data : segmentData)
+        if (!destination.write (data.getData(), data.getDataSize()))
+            return false;
+
+    return true;
+}
+#endif // USE_LAME
+
 #endif // USE_LAME || USE_MPG123
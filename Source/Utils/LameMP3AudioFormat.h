@@ -9,6 +9,11 @@
  * Writing: Uses LAME library for MP3 encoding
  *
  * This provides a patent-free, open-source alternative to proprietary MP3 codecs.
+ *
+ * The writer takes float channels as they are (no interleaving or integer
+ * conversion) and reuses its encode buffer, so it suits live recording.
+ * encodeInSegments() encodes a buffer that is already in memory on several
+ * threads, for long exports.
  */
 
 #if USE_LAME || USE_MPG123
@@ -35,6 +40,20 @@ public:
     std::unique_ptr<juce::AudioFormatWriter> createWriterFor (std::unique_ptr<juce::OutputStream>& streamToWriteTo,
                                                               const juce::AudioFormatWriterOptions& options) override;
 
+    #if USE_LAME
+    /**
+     * Encodes a region of a buffer as MP3 onto destination, splitting it into
+     * segments (of at least 30 seconds) encoded on up to numThreads threads
+     * (0 = one per core). The segments are joined on frame boundaries with
+     * the bit reservoir disabled, so playback is gapless; audio too short to
+     * split is encoded in one pass as the writer does. Only the first two
+     * channels are used. Returns false if encoding fails.
+     */
+    static bool encodeInSegments (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                  double sampleRate, int qualityOptionIndex,
+                                  juce::OutputStream& destination, int numThreads = 0);
+    #endif
+
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LameMP3AudioFormat)
 };
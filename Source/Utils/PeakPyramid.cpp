@@ -0,0 +1,426 @@
+#include "PeakPyramid.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const char* const sidecarMagic = "VRSP";
+    constexpr int sidecarVersion = 1;
+    constexpr juce::int64 parallelScanThreshold = 1 << 20;    // Samples below which a scan stays on the calling thread
+    constexpr int fingerprintStripes = 16;
+    constexpr int fingerprintStripeBytes = 64 * 1024;
+
+    PeakPyramid::Peak scanSamples (const float* data, int numSamples)
+    {
+        PeakPyramid::Peak peak;
+
+        if (numSamples <= 0)
+            return peak;
+
+        peak.minimum = peak.maximum = data[0];
+        float sumOfSquares = 0.0f;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float sample = data[i];
+            peak.minimum = juce::jmin (peak.minimum, sample);
+            peak.maximum = juce::jmax (peak.maximum, sample);
+            sumOfSquares += sample * sample;
+        }
+
+        peak.sumOfSquares = sumOfSquares;
+        return peak;
+    }
+
+    PeakPyramid::Peak mergePeaks (const PeakPyramid::Peak& a, const PeakPyramid::Peak& b)
+    {
+        return { juce::jmin (a.minimum, b.minimum), juce::jmax (a.maximum, b.maximum), a.sumOfSquares + b.sumOfSquares };
+    }
+
+    /** FNV-1a; a fingerprint, not a checksum */
+    void mixHash (juce::uint64& hash, const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const juce::uint8*> (data);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+}
+
+//==============================================================================
+void PeakPyramid::clear()
+{
+    levels.clear();
+    numSamples = 0;
+}
+
+void PeakPyramid::reset (int numChannels)
+{
+    clear();
+    resizeLevels (numChannels);
+}
+
+void PeakPyramid::build (const juce::AudioBuffer<float>& buffer)
+{
+    clear();
+    numSamples = buffer.getNumSamples();
+    resizeLevels (buffer.getNumChannels());
+    scanBaseBlocks (buffer, 0, getNumBlocks (0));
+    mergeLevels (0, getNumBlocks (0));
+}
+
+void PeakPyramid::update (const juce::AudioBuffer<float>& buffer, juce::int64 startSample, juce::int64 numSamplesChanged)
+{
+    if (buffer.getNumChannels() != getNumChannels() || levels.empty())
+    {
+        build (buffer);
+        return;
+    }
+
+    const juce::int64 newLength = buffer.getNumSamples();
+    const bool lengthChanged = newLength != numSamples.load();
+
+    numSamples = newLength;
+    const auto firstNewLevel = resizeLevels (buffer.getNumChannels());
+
+    const auto numBaseBlocks = getNumBlocks (0);
+    startSample = juce::jlimit ((juce::int64) 0, newLength, startSample);
+
+    // A shortened buffer still rescans its last block, whose ancestors lost children
+    const auto firstBlock = lengthChanged ? juce::jmin (startSample / baseBlockSize, juce::jmax ((juce::int64) 0, numBaseBlocks - 1))
+                                          : startSample / baseBlockSize;
+    const auto endBlock = lengthChanged ? numBaseBlocks
+                                        : juce::jmin (numBaseBlocks, (startSample + juce::jmax ((juce::int64) 0, numSamplesChanged) + baseBlockSize - 1) / baseBlockSize);
+
+    scanBaseBlocks (buffer, firstBlock, endBlock);
+    mergeLevels (firstBlock, endBlock, firstNewLevel);
+}
+
+void PeakPyramid::append (const float* const* channelData, int numChannels, int numNewSamples)
+{
+    if (numNewSamples <= 0 || numChannels <= 0)
+        return;
+
+    if (numChannels != getNumChannels())
+        reset (numChannels);
+
+    const juce::int64 oldLength = numSamples.load();
+    const juce::int64 newLength = oldLength + numNewSamples;
+    const bool extendsPartialBlock = oldLength % baseBlockSize != 0;
+
+    numSamples = newLength;
+    const auto firstNewLevel = resizeLevels (numChannels);
+
+    const auto firstBlock = oldLength / baseBlockSize;
+    const auto endBlock = getNumBlocks (0);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto& blocks = levels[0][(size_t) channel];
+
+        for (auto block = firstBlock; block < endBlock; ++block)
+        {
+            const auto from = juce::jmax (block * baseBlockSize, oldLength);
+            const auto to = juce::jmin ((block + 1) * baseBlockSize, newLength);
+            const auto peak = scanSamples (channelData[channel] + (from - oldLength), (int) (to - from));
+
+            blocks[(size_t) block] = (block == firstBlock && extendsPartialBlock) ? mergePeaks (blocks[(size_t) block], peak) : peak;
+        }
+    }
+
+    mergeLevels (firstBlock, endBlock, firstNewLevel);
+}
+
+void PeakPyramid::getColumns (int channel, double startSample, double endSample, int numColumns,
+                              std::vector<Peak>& columns, std::vector<int>& columnLengths,
+                              const juce::AudioBuffer<float>* source) const
+{
+    columns.assign ((size_t) juce::jmax (0, numColumns), Peak());
+    columnLengths.assign ((size_t) juce::jmax (0, numColumns), 0);
+
+    const juce::int64 total = numSamples.load();
+
+    if (total <= 0 || numColumns <= 0 || channel < 0 || channel >= getNumChannels() || endSample <= startSample)
+        return;
+
+    const double samplesPerColumn = (endSample - startSample) / numColumns;
+    const bool scanSource = source != nullptr && samplesPerColumn < baseBlockSize
+                            && source->getNumSamples() == total && channel < source->getNumChannels();
+
+    // The coarsest level whose blocks still fit in a column
+    int level = 0;
+    while (level + 1 < (int) levels.size() && getBlockSize (level + 1) <= samplesPerColumn)
+        ++level;
+
+    const auto blockSize = getBlockSize (level);
+    const auto numBlocks = getNumBlocks (level);
+    const auto& blocks = levels[(size_t) level][(size_t) channel];
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        const auto from = juce::jlimit ((juce::int64) 0, total, (juce::int64) std::floor (startSample + column * samplesPerColumn));
+        const auto to = juce::jlimit (from, total, juce::jmax (from + 1, (juce::int64) std::floor (startSample + (column + 1) * samplesPerColumn)));
+
+        if (from >= to)
+            break;
+
+        if (scanSource)
+        {
+            columns[(size_t) column] = scanSamples (source->getReadPointer (channel, (int) from), (int) (to - from));
+            columnLengths[(size_t) column] = (int) (to - from);
+            continue;
+        }
+
+        const auto firstBlock = from / blockSize;
+        const auto endBlock = juce::jmin (numBlocks, (to + blockSize - 1) / blockSize);
+        auto peak = blocks[(size_t) firstBlock];
+
+        for (auto block = firstBlock + 1; block < endBlock; ++block)
+            peak = mergePeaks (peak, blocks[(size_t) block]);
+
+        columns[(size_t) column] = peak;
+        columnLengths[(size_t) column] = (int) (juce::jmin (endBlock * blockSize, total) - firstBlock * blockSize);
+    }
+}
+
+//==============================================================================
+juce::File PeakPyramid::getSidecarFile (const juce::File& audioFile)
+{
+    return audioFile.getSiblingFile (audioFile.getFileName() + ".vrspeaks");
+}
+
+juce::uint64 PeakPyramid::fingerprint (const juce::File& audioFile)
+{
+    juce::FileInputStream input (audioFile);
+
+    if (!input.openedOk())
+        return 0;
+
+    juce::uint64 hash = 14695981039346656037ull;
+    const juce::int64 size = input.getTotalLength();
+    const juce::int64 modified = audioFile.getLastModificationTime().toMilliseconds();
+    mixHash (hash, &size, sizeof (size));
+    mixHash (hash, &modified, sizeof (modified));
+
+    // Evenly spaced stripes, the header and the end included, catch edits that keep size and date
+    juce::HeapBlock<char> stripe (fingerprintStripeBytes);
+
+    for (int i = 0; i < fingerprintStripes; ++i)
+    {
+        const auto position = juce::jmax ((juce::int64) 0, (size - fingerprintStripeBytes) * i / (fingerprintStripes - 1));
+
+        if (!input.setPosition (position))
+            return 0;
+
+        const int numRead = input.read (stripe.get(), fingerprintStripeBytes);
+        mixHash (hash, stripe.get(), (size_t) juce::jmax (0, numRead));
+    }
+
+    return hash;
+}
+
+bool PeakPyramid::save (const juce::File& sidecar, juce::uint64 fileFingerprint) const
+{
+   #if JUCE_BIG_ENDIAN
+    // The blocks are stored in little-endian order as they lie in memory
+    juce::ignoreUnused (sidecar, fileFingerprint);
+    return false;
+   #else
+    if (levels.empty() || fileFingerprint == 0)
+        return false;
+
+    juce::TemporaryFile temp (sidecar);
+
+    {
+        juce::FileOutputStream output (temp.getFile());
+
+        if (!output.openedOk()
+            || !output.write (sidecarMagic, 4)
+            || !output.writeInt (sidecarVersion)
+            || !output.writeInt64 ((juce::int64) fileFingerprint)
+            || !output.writeInt (baseBlockSize)
+            || !output.writeInt (getNumChannels())
+            || !output.writeInt64 (numSamples.load()))
+            return false;
+
+        for (const auto& blocks : levels.front())
+            if (!output.write (blocks.data(), blocks.size() * sizeof (Peak)))
+                return false;
+
+        output.flush();
+
+        if (!output.getStatus().wasOk())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+   #endif
+}
+
+bool PeakPyramid::load (const juce::File& sidecar, juce::uint64 fileFingerprint, int expectedChannels, juce::int64 expectedSamples)
+{
+   #if JUCE_BIG_ENDIAN
+    juce::ignoreUnused (sidecar, fileFingerprint, expectedChannels, expectedSamples);
+    return false;
+   #else
+    juce::FileInputStream input (sidecar);
+    char magic[4] = {};
+
+    if (fileFingerprint == 0 || !input.openedOk()
+        || input.read (magic, 4) != 4 || std::memcmp (magic, sidecarMagic, 4) != 0
+        || input.readInt() != sidecarVersion
+        || (juce::uint64) input.readInt64() != fileFingerprint
+        || input.readInt() != baseBlockSize
+        || input.readInt() != expectedChannels
+        || input.readInt64() != expectedSamples)
+        return false;
+
+    clear();
+    numSamples = expectedSamples;
+    resizeLevels (expectedChannels);
+
+    for (auto& blocks : levels.front())
+    {
+        const auto numBytes = (int) (blocks.size() * sizeof (Peak));
+
+        if (input.read (blocks.data(), numBytes) != numBytes)
+        {
+            clear();
+            return false;
+        }
+    }
+
+    mergeLevels (0, getNumBlocks (0));
+    return true;
+   #endif
+}
+
+//==============================================================================
+juce::int64 PeakPyramid::getBlockSize (int level)
+{
+    juce::int64 size = baseBlockSize;
+
+    for (int i = 0; i < level; ++i)
+        size *= levelFactor;
+
+    return size;
+}
+
+juce::int64 PeakPyramid::getNumBlocks (int level) const
+{
+    const auto blockSize = getBlockSize (level);
+    return (numSamples.load() + blockSize - 1) / blockSize;
+}
+
+size_t PeakPyramid::resizeLevels (int numChannels)
+{
+    const auto previousNumLevels = levels.size();
+
+    int numLevels = 1;
+    while (getNumBlocks (numLevels - 1) > 1)
+        ++numLevels;
+
+    levels.resize ((size_t) numLevels);
+
+    for (int level = 0; level < numLevels; ++level)
+    {
+        auto& channels = levels[(size_t) level];
+        channels.resize ((size_t) numChannels);
+
+        for (auto& blocks : channels)
+            blocks.resize ((size_t) getNumBlocks (level));
+    }
+
+    return previousNumLevels;
+}
+
+void PeakPyramid::scanBaseBlocks (const juce::AudioBuffer<float>& buffer, juce::int64 firstBlock, juce::int64 endBlock)
+{
+    const juce::int64 length = buffer.getNumSamples();
+    const int numChannels = juce::jmin (buffer.getNumChannels(), getNumChannels());
+
+    auto scanRange = [this, &buffer, length, numChannels] (juce::int64 from, juce::int64 to)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const float* data = buffer.getReadPointer (channel);
+            auto& blocks = levels[0][(size_t) channel];
+
+            for (auto block = from; block < to; ++block)
+            {
+                const auto start = block * baseBlockSize;
+                blocks[(size_t) block] = scanSamples (data + start, (int) juce::jmin ((juce::int64) baseBlockSize, length - start));
+            }
+        }
+    };
+
+    if (endBlock <= firstBlock)
+        return;
+
+    const int numThreads = juce::jmax (1, juce::SystemStats::getNumCpus());
+
+    if ((endBlock - firstBlock) * baseBlockSize < parallelScanThreshold || numThreads == 1)
+    {
+        scanRange (firstBlock, endBlock);
+        return;
+    }
+
+    // Each job owns a disjoint run of blocks, so they write without sharing
+    juce::ThreadPool pool (numThreads);
+    const auto numBlocks = endBlock - firstBlock;
+
+    for (int job = 0; job < numThreads; ++job)
+    {
+        const auto from = firstBlock + numBlocks * job / numThreads;
+        const auto to = firstBlock + numBlocks * (job + 1) / numThreads;
+
+        pool.addJob ([scanRange, from, to]
+        {
+            scanRange (from, to);
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep (1);
+}
+
+void PeakPyramid::mergeLevels (juce::int64 firstBaseBlock, juce::int64 endBaseBlock, size_t firstNewLevel)
+{
+    if (getNumChannels() == 0)
+        return;
+
+    auto first = firstBaseBlock;
+    auto end = endBaseBlock;
+
+    for (size_t level = 1; level < levels.size(); ++level)
+    {
+        const auto numChildren = (juce::int64) levels[level - 1].front().size();
+        const auto numBlocks = (juce::int64) levels[level].front().size();
+
+        // A level that did not exist before has no blocks worth keeping
+        first = level >= firstNewLevel ? 0 : first / levelFactor;
+        end = juce::jmin (numBlocks, (end + levelFactor - 1) / levelFactor);
+
+        for (size_t channel = 0; channel < levels[level].size(); ++channel)
+        {
+            const auto& children = levels[level - 1][channel];
+            auto& blocks = levels[level][channel];
+
+            for (auto block = first; block < end; ++block)
+            {
+                const auto firstChild = block * levelFactor;
+                const auto endChild = juce::jmin (numChildren, firstChild + levelFactor);
+                auto peak = children[(size_t) firstChild];
+
+                for (auto child = firstChild + 1; child < endChild; ++child)
+                    peak = mergePeaks (peak, children[(size_t) child]);
+
+                blocks[(size_t) block] = peak;
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <vector>
+
+/**
+ * Peak Pyramid
+ *
+ * Mip-mapped min/max/energy overview of an audio buffer for drawing
+ * waveforms at any zoom. Level 0 summarises blocks of baseBlockSize samples,
+ * each level above merges levelFactor blocks of the one below, so a column
+ * of any width is drawn from a handful of blocks of the coarsest level that
+ * still resolves it.
+ *
+ * - build() scans the whole buffer on all cores
+ * - update() rescans only the blocks an edit touched and their ancestors
+ * - append() extends the overview while recording
+ * - save()/load() keep level 0 in a sidecar next to the audio file, keyed
+ *   by a fingerprint of that file, so reopening it needs no scan at all
+ *
+ * Not thread-safe: callers serialise access (getNumSamples() excepted).
+ */
+class PeakPyramid
+{
+public:
+    struct Peak
+    {
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+        float sumOfSquares = 0.0f;
+    };
+
+    static constexpr int baseBlockSize = 256;
+    static constexpr int levelFactor = 4;
+
+    PeakPyramid() = default;
+
+    /** Empties the overview */
+    void clear();
+
+    /** Empties the overview and prepares it for append() */
+    void reset (int numChannels);
+
+    /** Rebuilds the overview from a whole buffer */
+    void build (const juce::AudioBuffer<float>& buffer);
+
+    /**
+     * Rescans buffer[startSample, startSample + numSamples) after an edit.
+     * If the buffer's length changed, everything from startSample on moved
+     * and is rescanned too.
+     */
+    void update (const juce::AudioBuffer<float>& buffer, juce::int64 startSample, juce::int64 numSamples);
+
+    /** Extends the overview by a block of samples */
+    void append (const float* const* channelData, int numChannels, int numSamples);
+
+    int getNumChannels() const { return static_cast<int> (levels.empty() ? 0 : levels.front().size()); }
+    juce::int64 getNumSamples() const { return numSamples.load(); }
+
+    /**
+     * Summarises [startSample, endSample) of a channel in numColumns equal
+     * columns. Columns narrower than a base block are scanned from source
+     * when it is given and matches the overview.
+     */
+    void getColumns (int channel, double startSample, double endSample, int numColumns,
+                     std::vector<Peak>& columns, std::vector<int>& columnLengths,
+                     const juce::AudioBuffer<float>* source = nullptr) const;
+
+    //==============================================================================
+    /** The sidecar file kept next to an audio file */
+    static juce::File getSidecarFile (const juce::File& audioFile);
+
+    /** Cheap fingerprint of an audio file: its size, date and sampled content */
+    static juce::uint64 fingerprint (const juce::File& audioFile);
+
+    /** Writes level 0 to a sidecar */
+    bool save (const juce::File& sidecar, juce::uint64 fileFingerprint) const;
+
+    /** Reads a sidecar if it matches the fingerprint and the buffer's shape */
+    bool load (const juce::File& sidecar, juce::uint64 fileFingerprint, int expectedChannels, juce::int64 expectedSamples);
+
+private:
+    static juce::int64 getBlockSize (int level);
+    juce::int64 getNumBlocks (int level) const;
+
+    void scanBaseBlocks (const juce::AudioBuffer<float>& buffer, juce::int64 firstBlock, juce::int64 endBlock);
+    size_t resizeLevels (int numChannels);     // Returns the number of levels before
+    void mergeLevels (juce::int64 firstBaseBlock, juce::int64 endBaseBlock, size_t firstNewLevel = 0);
+
+    std::vector<std::vector<std::vector<Peak>>> levels;    // [level][channel][block]
+    std::atomic<juce::int64> numSamples { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PeakPyramid)
+};
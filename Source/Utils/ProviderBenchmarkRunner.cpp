@@ -0,0 +1,108 @@
+#include "ProviderBenchmarkRunner.h"
+
+ProviderBenchmarkRunner::ProviderBenchmarkRunner()
+    : juce::Thread ("ProviderBenchmark")
+{
+}
+
+ProviderBenchmarkRunner::~ProviderBenchmarkRunner()
+{
+    // A session being created cannot be interrupted, so this may wait for it
+    stopThread (-1);
+}
+
+void ProviderBenchmarkRunner::startIfNeeded (const SettingsManager::DenoiseSettings& newSettings)
+{
+    if (isThreadRunning())
+        return;
+
+    OnnxDenoiser probe;
+    configure (probe, newSettings);
+
+    if (SettingsManager::getInstance().getProviderBenchmark().signature == probe.getBenchmarkSignature())
+        return;
+
+    start (newSettings);
+}
+
+void ProviderBenchmarkRunner::start (const SettingsManager::DenoiseSettings& newSettings)
+{
+    stopThread (-1);
+    settings = newSettings;
+    startThread (juce::Thread::Priority::low);
+}
+
+OnnxDenoiser::Provider ProviderBenchmarkRunner::getStoredWinner()
+{
+    const auto winner = SettingsManager::getInstance().getProviderBenchmark().winner;
+    return winner.isNotEmpty() ? OnnxDenoiser::providerFromString (winner) : OnnxDenoiser::Provider::autoSelect;
+}
+
+void ProviderBenchmarkRunner::run()
+{
+    OnnxDenoiser denoiser;
+    configure (denoiser, settings);
+
+    const auto results = denoiser.benchmarkProviders ([this] { return !threadShouldExit(); });
+
+    if (threadShouldExit())
+        return;
+
+    auto winner = OnnxDenoiser::Provider::autoSelect;
+    double fastest = 0.0;
+
+    for (const auto& result : results)
+    {
+        if (result.succeeded && (winner == OnnxDenoiser::Provider::autoSelect || result.msPerFrame < fastest))
+        {
+            winner = result.provider;
+            fastest = result.msPerFrame;
+        }
+    }
+
+    // Stored even when nothing worked, so the next start does not measure again
+    SettingsManager::ProviderBenchmarkRecord record;
+    record.signature = denoiser.getBenchmarkSignature();
+    record.winner = winner != OnnxDenoiser::Provider::autoSelect ? OnnxDenoiser::providerToString (winner) : juce::String();
+    record.report = formatReport (results, winner);
+
+    juce::WeakReference<ProviderBenchmarkRunner> weakThis (this);
+    juce::MessageManager::callAsync ([weakThis, record]
+    {
+        SettingsManager::getInstance().setProviderBenchmark (record);
+
+        if (weakThis != nullptr && weakThis->onFinished)
+            weakThis->onFinished (record);
+    });
+}
+
+void ProviderBenchmarkRunner::configure (OnnxDenoiser& denoiser, const SettingsManager::DenoiseSettings& settingsToUse)
+{
+    denoiser.setDmlDeviceId (settingsToUse.dmlDeviceId);
+    denoiser.setQnnBackendPath (settingsToUse.qnnBackendPath);
+
+    if (settingsToUse.modelPath.isNotEmpty())
+        denoiser.setModelPath (juce::File (settingsToUse.modelPath));
+}
+
+juce::String ProviderBenchmarkRunner::formatReport (const std::vector<OnnxDenoiser::ProviderBenchmark>& results,
+                                                    OnnxDenoiser::Provider winner)
+{
+    juce::String report;
+
+    for (const auto& result : results)
+    {
+        report += OnnxDenoiser::providerToString (result.provider) + ": ";
+        report += result.succeeded ? juce::String (result.msPerFrame, 3) + " ms per frame" : juce::String ("Failed");
+
+        if (result.succeeded && result.provider == winner)
+            report += " (fastest)";
+
+        report += "\n";
+    }
+
+    if (report.isEmpty())
+        report = "No usable providers.\n";
+
+    return report;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+#include "../DSP/OnnxDenoiser.h"
+#include "SettingsManager.h"
+#include <functional>
+
+/**
+ * Provider Benchmark Runner
+ *
+ * Picks the provider Auto mode uses by measurement rather than by the fixed
+ * fallback order. startIfNeeded() compares the stored result's signature
+ * (OnnxDenoiser::getBenchmarkSignature(): runtime, OS, CPU, device, model) with
+ * the current one; only when they differ, e.g. on first run or after a driver,
+ * runtime or model change, are the usable providers timed on a background
+ * thread. The fastest is stored in SettingsManager along with a report, and
+ * onFinished is called on the message thread.
+ */
+class ProviderBenchmarkRunner : private juce::Thread
+{
+public:
+    ProviderBenchmarkRunner();
+    ~ProviderBenchmarkRunner() override;
+
+    /** Message thread: benchmarks unless the stored result matches these settings */
+    void startIfNeeded (const SettingsManager::DenoiseSettings& settings);
+
+    /** Message thread: benchmarks again, replacing any stored result */
+    void start (const SettingsManager::DenoiseSettings& settings);
+
+    bool isRunning() const { return isThreadRunning(); }
+
+    /** Message thread, once the result is stored */
+    std::function<void (const SettingsManager::ProviderBenchmarkRecord&)> onFinished;
+
+    /** The stored winner for Auto mode, or autoSelect if there is none */
+    static OnnxDenoiser::Provider getStoredWinner();
+
+private:
+    void run() override;
+
+    static void configure (OnnxDenoiser& denoiser, const SettingsManager::DenoiseSettings& settings);
+    static juce::String formatReport (const std::vector<OnnxDenoiser::ProviderBenchmark>& results,
+                                      OnnxDenoiser::Provider winner);
+
+    SettingsManager::DenoiseSettings settings;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (ProviderBenchmarkRunner)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProviderBenchmarkRunner)
+};
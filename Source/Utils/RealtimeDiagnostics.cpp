@@ -0,0 +1,169 @@
+#include "RealtimeDiagnostics.h"
+
+#if VRS_RT_DIAGNOSTICS
+#include <cstdlib>
+#include <new>
+#endif
+
+//==============================================================================
+std::array<RealtimeDiagnostics::AtomicCounts, static_cast<size_t> (RealtimeDiagnostics::Stage::numStages)>& RealtimeDiagnostics::getStorage() noexcept
+{
+    static std::array<AtomicCounts, static_cast<size_t> (Stage::numStages)> storage;
+    return storage;
+}
+
+int& RealtimeDiagnostics::currentStage() noexcept
+{
+    // Constant-initialised, so safe to touch from inside operator new
+    static thread_local int stage = -1;
+    return stage;
+}
+
+RealtimeDiagnostics::ScopedStage::ScopedStage (Stage stage) noexcept
+    : previous (currentStage())
+{
+    currentStage() = static_cast<int> (stage);
+}
+
+RealtimeDiagnostics::ScopedStage::~ScopedStage() noexcept
+{
+    currentStage() = previous;
+}
+
+//==============================================================================
+void RealtimeDiagnostics::noteAllocation() noexcept
+{
+    const int stage = currentStage();
+    if (stage >= 0)
+        getStorage()[static_cast<size_t> (stage)].allocations.fetch_add (1, std::memory_order_relaxed);
+}
+
+void RealtimeDiagnostics::noteLock() noexcept
+{
+    const int stage = currentStage();
+    if (stage >= 0)
+        getStorage()[static_cast<size_t> (stage)].locks.fetch_add (1, std::memory_order_relaxed);
+}
+
+void RealtimeDiagnostics::noteFileAccess() noexcept
+{
+    const int stage = currentStage();
+    if (stage >= 0)
+        getStorage()[static_cast<size_t> (stage)].fileAccesses.fetch_add (1, std::memory_order_relaxed);
+}
+
+RealtimeDiagnostics::Counts RealtimeDiagnostics::getCounts (Stage stage) noexcept
+{
+    const auto& stored = getStorage()[static_cast<size_t> (stage)];
+
+    Counts counts;
+    counts.allocations = stored.allocations.load (std::memory_order_relaxed);
+    counts.locks = stored.locks.load (std::memory_order_relaxed);
+    counts.fileAccesses = stored.fileAccesses.load (std::memory_order_relaxed);
+    return counts;
+}
+
+bool RealtimeDiagnostics::hasViolations() noexcept
+{
+    for (int i = 0; i < static_cast<int> (Stage::numStages); ++i)
+    {
+        const auto counts = getCounts (static_cast<Stage> (i));
+        if (counts.allocations + counts.locks + counts.fileAccesses > 0)
+            return true;
+    }
+
+    return false;
+}
+
+void RealtimeDiagnostics::resetCounts() noexcept
+{
+    for (auto& stored : getStorage())
+    {
+        stored.allocations.store (0, std::memory_order_relaxed);
+        stored.locks.store (0, std::memory_order_relaxed);
+        stored.fileAccesses.store (0, std::memory_order_relaxed);
+    }
+}
+
+juce::String RealtimeDiagnostics::getReport()
+{
+    juce::String report;
+
+    for (int i = 0; i < static_cast<int> (Stage::numStages); ++i)
+    {
+        const auto stage = static_cast<Stage> (i);
+        const auto counts = getCounts (stage);
+
+        if (counts.allocations + counts.locks + counts.fileAccesses == 0)
+            continue;
+
+        report << getStageName (stage) << ": "
+               << counts.allocations << " allocations, "
+               << counts.locks << " locks, "
+               << counts.fileAccesses << " file accesses\n";
+    }
+
+    return report;
+}
+
+const char* RealtimeDiagnostics::getStageName (Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case Stage::setup: return "Setup";
+        case Stage::clickRemoval: return "Click Removal";
+        case Stage::noiseReduction: return "Noise Reduction";
+        case Stage::aiDenoise: return "AI Denoise";
+        case Stage::filterBank: return "Filter Bank";
+        case Stage::differenceMode: return "Difference Mode";
+        case Stage::visualization: return "Visualization";
+        case Stage::numStages: break;
+    }
+
+    return "Unknown";
+}
+
+//==============================================================================
+#if VRS_RT_DIAGNOSTICS
+// Global replacements: count, then hand over to malloc/free. Aligned overloads
+// keep the library defaults, which pair with their own deletes.
+void* operator new (std::size_t size)
+{
+    RealtimeDiagnostics::noteAllocation();
+
+    if (void* ptr = std::malloc (size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeDiagnostics::noteAllocation();
+    return std::malloc (size == 0 ? 1 : size);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new (size, tag);
+}
+
+void operator delete (void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeDiagnostics::noteAllocation();
+
+    std::free (ptr);
+}
+
+void operator delete[] (void* ptr) noexcept                          { operator delete (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept               { operator delete (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept             { operator delete (ptr); }
+void operator delete (void* ptr, const std::nothrow_t&) noexcept     { operator delete (ptr); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept   { operator delete (ptr); }
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+/**
+ * Real-time Diagnostics
+ *
+ * Debug/profiling aid for audio-thread dropouts. Built with the CMake option
+ * VRS_RT_DIAGNOSTICS, every heap allocation or free, lock acquisition and file
+ * access made while a VRS_RT_STAGE scope is open is counted against that
+ * stage. Allocations are caught by replacing the global operator new/delete;
+ * locks and file access are counted where the code notes them with
+ * VRS_RT_NOTE_LOCK() / VRS_RT_NOTE_FILE_IO().
+ *
+ * Only threads inside a stage scope are counted, so offline and GUI work is
+ * ignored. Without the option every macro compiles to nothing.
+ */
+class RealtimeDiagnostics
+{
+public:
+    enum class Stage
+    {
+        setup,
+        clickRemoval,
+        noiseReduction,
+        aiDenoise,
+        filterBank,
+        differenceMode,
+        visualization,
+        numStages
+    };
+
+    struct Counts
+    {
+        juce::int64 allocations = 0;
+        juce::int64 locks = 0;
+        juce::int64 fileAccesses = 0;
+    };
+
+    /** Marks the calling thread as running a stage until destroyed (nests) */
+    class ScopedStage
+    {
+    public:
+        explicit ScopedStage (Stage stage) noexcept;
+        ~ScopedStage() noexcept;
+
+    private:
+        int previous;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedStage)
+    };
+
+    static void noteAllocation() noexcept;
+    static void noteLock() noexcept;
+    static void noteFileAccess() noexcept;
+
+    static Counts getCounts (Stage stage) noexcept;
+    static bool hasViolations() noexcept;
+    static void resetCounts() noexcept;
+
+    /** One line per stage with a non-zero count, or an empty string */
+    static juce::String getReport();
+    static const char* getStageName (Stage stage) noexcept;
+
+private:
+    struct AtomicCounts
+    {
+        std::atomic<juce::int64> allocations { 0 };
+        std::atomic<juce::int64> locks { 0 };
+        std::atomic<juce::int64> fileAccesses { 0 };
+    };
+
+    static std::array<AtomicCounts, static_cast<size_t> (Stage::numStages)>& getStorage() noexcept;
+    static int& currentStage() noexcept;
+};
+
+#if VRS_RT_DIAGNOSTICS
+ #define VRS_RT_STAGE(stage)   const RealtimeDiagnostics::ScopedStage JUCE_JOIN_MACRO (rtStage_, __LINE__) (RealtimeDiagnostics::Stage::stage)
+ #define VRS_RT_NOTE_LOCK()    RealtimeDiagnostics::noteLock()
+ #define VRS_RT_NOTE_FILE_IO() RealtimeDiagnostics::noteFileAccess()
+#else
+ #define VRS_RT_STAGE(stage)
+ #define VRS_RT_NOTE_LOCK()
+ #define VRS_RT_NOTE_FILE_IO()
+#endif
@@ -0,0 +1,253 @@
+#include "RecordingCapture.h"
+#include "../DSP/ClickRemoval.h"
+#include <utility>
+
+namespace
+{
+    constexpr int analysisBlockSize = 4096;
+    constexpr int envelopeWindowSamples = 1024;
+}
+
+RecordingCapture::RecordingCapture()
+    : juce::Thread ("Recording Capture")
+{
+}
+
+RecordingCapture::~RecordingCapture()
+{
+    cancel();
+}
+
+void RecordingCapture::start (const Settings& newSettings)
+{
+    cancel();
+
+    settings = newSettings;
+    settings.numChannels = juce::jmax (1, settings.numChannels);
+
+    // Room for a few seconds, so a stall of the capture thread loses nothing
+    const int fifoSize = juce::nextPowerOfTwo (juce::jmax (1 << 16, static_cast<int> (settings.sampleRate * 4.0)));
+    fifo = std::make_unique<juce::AbstractFifo> (fifoSize);
+    fifoBuffer.setSize (settings.numChannels, fifoSize);
+    scratch.setSize (settings.numChannels, analysisBlockSize);
+    dropped.store (0);
+
+    segments.clear();
+    numCaptured = 0;
+    windowsAnalysed = 0;
+    silenceStart = -1;
+    lastBoundary = 0;
+    boundaries.clear();
+
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = settings.sampleRate;
+    spec.numChannels = static_cast<juce::uint32> (settings.numChannels);
+    spec.maximumBlockSize = analysisBlockSize;
+
+    clickDetector = std::make_unique<ClickRemoval>();
+    clickDetector->prepare (spec);
+    clickDetector->setSensitivity (settings.clickSensitivity);
+    clickDetector->setMaxWidth (settings.clickMaxWidth);
+    clickDetector->setApplyRemoval (false);
+    clickDetector->setStoreDetectedClicks (true);
+    clickDetector->setSampleOffset (0);
+
+    envelope = std::make_unique<TrackDetector::LevelEnvelope> (settings.numChannels, envelopeWindowSamples);
+
+    capturing.store (true);
+    startThread (juce::Thread::Priority::low);
+}
+
+void RecordingCapture::push (const float* const* channelData, int numChannels, int numSamples) noexcept
+{
+    if (!capturing.load() || channelData == nullptr || numChannels <= 0 || numSamples <= 0)
+        return;
+
+    const auto scope = fifo->write (numSamples);
+    const int written = scope.blockSize1 + scope.blockSize2;
+
+    for (int channel = 0; channel < fifoBuffer.getNumChannels(); ++channel)
+    {
+        const float* source = channelData[channel % numChannels];
+
+        if (scope.blockSize1 > 0)
+            fifoBuffer.copyFrom (channel, scope.startIndex1, source, scope.blockSize1);
+
+        if (scope.blockSize2 > 0)
+            fifoBuffer.copyFrom (channel, scope.startIndex2, source + scope.blockSize1, scope.blockSize2);
+    }
+
+    if (written < numSamples)
+        dropped.fetch_add (numSamples - written);
+}
+
+RecordingCapture::Result RecordingCapture::finish()
+{
+    Result result;
+
+    if (!capturing.exchange (false))
+        return result;
+
+    stopThread (5000);
+
+    // The thread has stopped, so what it left queued is analysed here
+    while (drain() > 0)
+    {
+    }
+
+    // Close the click stream at the last sample and flush its lookahead
+    clickDetector->endStream();
+
+    for (int remaining = clickDetector->getLatencySamples(); remaining > 0; remaining -= analysisBlockSize)
+    {
+        const int count = juce::jmin (analysisBlockSize, remaining);
+        scratch.clear();
+        juce::dsp::AudioBlock<float> block (scratch.getArrayOfWritePointers(), (size_t) scratch.getNumChannels(), 0, (size_t) count);
+        juce::dsp::ProcessContextReplacing<float> context (block);
+        clickDetector->process (context);
+    }
+
+    envelope->finish();
+    analyseSilence (true);
+
+    // One allocation of the final length and one pass over the segments
+    result.audio.setSize (settings.numChannels, static_cast<int> (numCaptured), false, false, false);
+
+    int64_t position = 0;
+
+    for (auto& segment : segments)
+    {
+        const int count = static_cast<int> (juce::jmin (static_cast<int64_t> (segmentSamples), numCaptured - position));
+
+        for (int channel = 0; channel < settings.numChannels; ++channel)
+            result.audio.copyFrom (channel, static_cast<int> (position), *segment, channel, 0, count);
+
+        position += count;
+        segment.reset();
+    }
+
+    result.clicks = clickDetector->takeDetectedClicks();
+    result.trackBoundaries = std::move (boundaries);
+    result.numDropped = dropped.load();
+
+    segments.clear();
+    boundaries.clear();
+    numCaptured = 0;
+    clickDetector.reset();
+    envelope.reset();
+    return result;
+}
+
+void RecordingCapture::cancel()
+{
+    capturing.store (false);
+    stopThread (5000);
+
+    segments.clear();
+    boundaries.clear();
+    numCaptured = 0;
+    clickDetector.reset();
+    envelope.reset();
+}
+
+//==============================================================================
+void RecordingCapture::run()
+{
+    while (!threadShouldExit())
+    {
+        if (drain() == 0)
+            wait (10);
+    }
+}
+
+int RecordingCapture::drain()
+{
+    const auto scope = fifo->read (juce::jmin (fifo->getNumReady(), analysisBlockSize));
+    int moved = 0;
+
+    for (auto [start, count] : { std::make_pair (scope.startIndex1, scope.blockSize1),
+                                 std::make_pair (scope.startIndex2, scope.blockSize2) })
+    {
+        if (count <= 0)
+            continue;
+
+        for (int channel = 0; channel < settings.numChannels; ++channel)
+            scratch.copyFrom (channel, moved, fifoBuffer, channel, start, count);
+
+        moved += count;
+    }
+
+    if (moved > 0)
+        append (moved);
+
+    return moved;
+}
+
+void RecordingCapture::append (int numSamples)
+{
+    // Into the segments: a full one is never touched again
+    for (int done = 0; done < numSamples;)
+    {
+        const int used = static_cast<int> (numCaptured % segmentSamples);
+
+        if (used == 0)
+            segments.push_back (std::make_unique<juce::AudioBuffer<float>> (settings.numChannels, segmentSamples));
+
+        const int count = juce::jmin (numSamples - done, segmentSamples - used);
+
+        for (int channel = 0; channel < settings.numChannels; ++channel)
+            segments.back()->copyFrom (channel, used, scratch, channel, done, count);
+
+        numCaptured += count;
+        done += count;
+    }
+
+    envelope->process (scratch, 0, numSamples);
+    analyseSilence (false);
+
+    // Detection only, but the detector works in place; scratch is not needed after this
+    juce::dsp::AudioBlock<float> block (scratch.getArrayOfWritePointers(), (size_t) settings.numChannels, 0, (size_t) numSamples);
+    juce::dsp::ProcessContextReplacing<float> context (block);
+    clickDetector->process (context);
+}
+
+void RecordingCapture::analyseSilence (bool atEnd)
+{
+    const auto& meanSquares = envelope->getMeanSquares();
+    const float threshold = juce::Decibels::decibelsToGain (settings.silenceThresholdDb, -100.0f);
+    const float thresholdSquared = threshold * threshold;
+
+    for (; windowsAnalysed < meanSquares.size(); ++windowsAnalysed)
+    {
+        const int64_t windowStart = static_cast<int64_t> (windowsAnalysed) * envelopeWindowSamples;
+        const bool isSilent = meanSquares[windowsAnalysed] < thresholdSquared;
+
+        if (isSilent && silenceStart < 0)
+            silenceStart = windowStart;
+        else if (!isSilent && silenceStart >= 0)
+            closeSilence (windowStart);
+    }
+
+    // Silence at the end of the side still separates its last track, as in detectTracks()
+    if (atEnd && silenceStart >= 0)
+        closeSilence (numCaptured);
+}
+
+void RecordingCapture::closeSilence (int64_t endSample)
+{
+    const int64_t start = std::exchange (silenceStart, static_cast<int64_t> (-1));
+
+    if (endSample - start < static_cast<int64_t> (settings.minSilenceSeconds * settings.sampleRate))
+        return;
+
+    const int64_t midpoint = (start + endSample) / 2;
+
+    if (midpoint - lastBoundary < static_cast<int64_t> (settings.minTrackSeconds * settings.sampleRate))
+        return;
+
+    boundaries.push_back (midpoint);
+    lastBoundary = midpoint;
+
+    if (onTrackBoundary != nullptr)
+        onTrackBoundary (midpoint);
+}
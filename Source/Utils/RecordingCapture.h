@@ -0,0 +1,104 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include "../DSP/ClickEvents.h"
+#include "../Processors/TrackDetector.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class ClickRemoval;
+
+/**
+ * Recording Capture
+ *
+ * Holds a recording in memory while it is captured and analyses it on the
+ * way in. The audio thread only copies its blocks into a preallocated FIFO;
+ * a background thread moves them into fixed-size segments, so a long side
+ * never reallocates or copies what it already holds, and runs click
+ * detection and silence analysis on each new stretch as it arrives.
+ *
+ * Silence runs become track boundaries by the rules of
+ * TrackDetector::detectTracks(): a boundary at the middle of a long enough
+ * gap, at least the minimum track length after the one before. By the time
+ * the recording stops, its clicks and track boundaries are known.
+ */
+class RecordingCapture : private juce::Thread
+{
+public:
+    static constexpr int segmentSamples = 1 << 16;
+
+    struct Settings
+    {
+        double sampleRate = 44100.0;
+        int numChannels = 2;
+        float clickSensitivity = 60.0f;
+        int clickMaxWidth = 500;
+        float silenceThresholdDb = -40.0f;
+        double minSilenceSeconds = 2.0;
+        double minTrackSeconds = 10.0;
+    };
+
+    struct Result
+    {
+        juce::AudioBuffer<float> audio;
+        ClickStore clicks;
+        std::vector<int64_t> trackBoundaries;
+        int numDropped = 0;                 // Samples lost because the FIFO was full
+    };
+
+    RecordingCapture();
+    ~RecordingCapture() override;
+
+    /** Message thread: starts an empty capture (stopping any previous one) */
+    void start (const Settings& settings);
+
+    bool isCapturing() const { return capturing.load(); }
+    double getSampleRate() const { return settings.sampleRate; }
+
+    /** Audio thread: appends a block; channels beyond numChannels map round */
+    void push (const float* const* channelData, int numChannels, int numSamples) noexcept;
+
+    /**
+     * Message thread: stops the capture, analyses what is still queued and
+     * returns the recording in one buffer with its clicks and boundaries.
+     */
+    Result finish();
+
+    /** Message thread: stops the capture and drops what it holds */
+    void cancel();
+
+    /** Called on the capture thread with each track boundary as it is found */
+    std::function<void (int64_t position)> onTrackBoundary;
+
+private:
+    void run() override;
+
+    /** Moves up to one analysis block out of the FIFO; returns the samples moved */
+    int drain();
+    void append (int numSamples);
+    void analyseSilence (bool atEnd);
+    void closeSilence (int64_t endSample);
+
+    Settings settings;
+    std::atomic<bool> capturing { false };
+    std::atomic<int> dropped { 0 };
+
+    std::unique_ptr<juce::AbstractFifo> fifo;
+    juce::AudioBuffer<float> fifoBuffer;
+    juce::AudioBuffer<float> scratch;
+
+    // Capture thread only, until finish() has stopped it
+    std::vector<std::unique_ptr<juce::AudioBuffer<float>>> segments;
+    int64_t numCaptured = 0;
+    std::unique_ptr<ClickRemoval> clickDetector;
+    std::unique_ptr<TrackDetector::LevelEnvelope> envelope;
+    size_t windowsAnalysed = 0;
+    int64_t silenceStart = -1;
+    int64_t lastBoundary = 0;
+    std::vector<int64_t> boundaries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RecordingCapture)
+};
@@ -0,0 +1,221 @@
+#include "RenderCache.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifndef VRS_VERSION_STRING
+ #define VRS_VERSION_STRING "unversioned"
+#endif
+
+namespace
+{
+    const char* const entryExtension = ".wav";    // Renders are written as WAV
+
+    /**
+     * 128-bit content hash, two independent 64-bit lanes over 8-byte words.
+     * Not cryptographic: it only has to tell renders apart.
+     */
+    class ContentHasher
+    {
+    public:
+        void add (const void* data, size_t numBytes)
+        {
+            auto* bytes = static_cast<const juce::uint8*> (data);
+            length += numBytes;
+
+            // Top up a partial word left by the previous call
+            while (numPending > 0 && numBytes > 0)
+            {
+                addPendingByte (*bytes++);
+                --numBytes;
+            }
+
+            for (; numBytes >= 8; bytes += 8, numBytes -= 8)
+            {
+                juce::uint64 word;
+                std::memcpy (&word, bytes, sizeof (word));
+                addWord (word);
+            }
+
+            while (numBytes-- > 0)
+                addPendingByte (*bytes++);
+        }
+
+        juce::String toString()
+        {
+            if (numPending > 0)
+                addWord (pending);
+
+            const auto high = finalise (laneA ^ length);
+            const auto low = finalise (laneB + length);
+            return juce::String::toHexString (static_cast<juce::int64> (high)).paddedLeft ('0', 16)
+                 + juce::String::toHexString (static_cast<juce::int64> (low)).paddedLeft ('0', 16);
+        }
+
+    private:
+        static juce::uint64 rotate (juce::uint64 value, int bits)
+        {
+            return (value << bits) | (value >> (64 - bits));
+        }
+
+        static juce::uint64 finalise (juce::uint64 value)
+        {
+            value ^= value >> 33;
+            value *= 0xff51afd7ed558ccdULL;
+            value ^= value >> 33;
+            value *= 0xc4ceb9fe1a85ec53ULL;
+            value ^= value >> 33;
+            return value;
+        }
+
+        void addWord (juce::uint64 word)
+        {
+            laneA = rotate (laneA ^ (word * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+            laneB = rotate (laneB + (word ^ 0x52dce729da3ed7c5ULL), 27) * 0x9e3779b97f4a7c15ULL + laneA;
+        }
+
+        void addPendingByte (juce::uint8 byte)
+        {
+            pending |= static_cast<juce::uint64> (byte) << (8 * numPending);
+
+            if (++numPending == 8)
+            {
+                addWord (pending);
+                pending = 0;
+                numPending = 0;
+            }
+        }
+
+        juce::uint64 laneA = 0x6a09e667f3bcc908ULL;
+        juce::uint64 laneB = 0xbb67ae8584caa73bULL;
+        juce::uint64 length = 0;
+        juce::uint64 pending = 0;
+        int numPending = 0;
+    };
+}
+
+//==============================================================================
+RenderCache::RenderCache (const juce::File& directoryToUse)
+    : directory (directoryToUse),
+      valid (directoryToUse != juce::File() && directoryToUse.createDirectory().wasOk())
+{
+    if (!valid)
+        DBG ("Render cache unavailable: " + directory.getFullPathName());
+}
+
+//==============================================================================
+juce::String RenderCache::hashFile (const juce::File& file)
+{
+    juce::FileInputStream stream (file);
+
+    if (!stream.openedOk())
+        return {};
+
+    ContentHasher hasher;
+    std::vector<char> block (1 << 20);
+
+    for (;;)
+    {
+        const int bytesRead = stream.read (block.data(), static_cast<int> (block.size()));
+
+        if (bytesRead <= 0)
+            break;
+
+        hasher.add (block.data(), static_cast<size_t> (bytesRead));
+    }
+
+    return hasher.toString();
+}
+
+juce::String RenderCache::makeKey (const juce::String& inputHash, const juce::String& renderDescription)
+{
+    const auto text = inputHash + "\n" + renderDescription + "\n" VRS_VERSION_STRING;
+
+    ContentHasher hasher;
+    hasher.add (text.toRawUTF8(), text.getNumBytesAsUTF8());
+    return hasher.toString();
+}
+
+//==============================================================================
+juce::File RenderCache::getEntryFile (const juce::String& key) const
+{
+    return directory.getChildFile (key + entryExtension);
+}
+
+bool RenderCache::contains (const juce::String& key) const
+{
+    return valid && key.isNotEmpty() && getEntryFile (key).existsAsFile();
+}
+
+juce::File RenderCache::useEntry (const juce::String& key) const
+{
+    const auto entry = getEntryFile (key);
+
+    // The modification time doubles as the last use, for trim()
+    entry.setLastModificationTime (juce::Time::getCurrentTime());
+    return entry;
+}
+
+bool RenderCache::fetch (const juce::String& key, const juce::File& destination) const
+{
+    if (!contains (key))
+        return false;
+
+    // Copied beside the destination first, so a failed copy leaves no partial output
+    juce::TemporaryFile temp (destination);
+
+    return useEntry (key).copyFileTo (temp.getFile())
+        && temp.overwriteTargetFileWithTemporary();
+}
+
+bool RenderCache::store (const juce::String& key, const juce::File& source) const
+{
+    if (!valid || key.isEmpty())
+        return false;
+
+    juce::TemporaryFile temp (getEntryFile (key));
+
+    return source.copyFileTo (temp.getFile())
+        && temp.overwriteTargetFileWithTemporary();
+}
+
+bool RenderCache::storeRendered (const juce::String& key, const std::function<bool (const juce::File& target)>& render) const
+{
+    if (!valid || key.isEmpty())
+        return false;
+
+    juce::TemporaryFile temp (getEntryFile (key));
+
+    return render (temp.getFile())
+        && temp.overwriteTargetFileWithTemporary();
+}
+
+void RenderCache::trim (juce::int64 maxBytes) const
+{
+    if (!valid)
+        return;
+
+    auto entries = directory.findChildFiles (juce::File::findFiles, false, juce::String ("*") + entryExtension);
+
+    // Temporary files of renders still in progress are not entries yet
+    entries.removeIf ([] (const juce::File& file) { return file.getFileNameWithoutExtension().contains ("_temp"); });
+
+    std::sort (entries.begin(), entries.end(), [] (const juce::File& a, const juce::File& b)
+    {
+        return a.getLastModificationTime() > b.getLastModificationTime();
+    });
+
+    juce::int64 totalBytes = 0;
+    int numDeleted = 0;
+
+    for (const auto& entry : entries)
+    {
+        totalBytes += entry.getSize();
+
+        if (totalBytes > maxBytes && entry.deleteFile())
+            ++numDeleted;
+    }
+
+    if (numDeleted > 0)
+        DBG ("Render cache: removed " + juce::String (numDeleted) + " least recently used entries");
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <functional>
+
+/**
+ * Render Cache
+ *
+ * Keeps rendered audio files in a directory, content-addressed: an entry's
+ * key is a hash of the input file's content together with a description of
+ * everything that shapes the render (the settings, the build version), so a
+ * renamed or moved input still hits and any change misses. A hit is copied
+ * out, not linked, so editing an output cannot change the cache.
+ *
+ * Entries are written to a temporary file and renamed into place, so
+ * several workers or processes may share one directory. trim() drops the
+ * least recently used entries beyond a size limit.
+ */
+class RenderCache
+{
+public:
+    explicit RenderCache (const juce::File& directory);
+
+    /** False if the directory could not be created */
+    bool isValid() const { return valid; }
+
+    //==============================================================================
+    /** Hash of a file's content, as hex; empty if it cannot be read. Reads the whole file. */
+    static juce::String hashFile (const juce::File& file);
+
+    /** Key of the render of an input (by hashFile()) described by renderDescription */
+    static juce::String makeKey (const juce::String& inputHash, const juce::String& renderDescription);
+
+    //==============================================================================
+    bool contains (const juce::String& key) const;
+
+    /** The entry's file, which exists once contains() is true; also marks the entry used */
+    juce::File useEntry (const juce::String& key) const;
+
+    /** Copies an entry to destination, replacing it; false on a miss */
+    bool fetch (const juce::String& key, const juce::File& destination) const;
+
+    /** Copies a rendered file in as the entry for key */
+    bool store (const juce::String& key, const juce::File& source) const;
+
+    /** Has render write the entry for key, to a file with the entry's extension; false if render fails */
+    bool storeRendered (const juce::String& key, const std::function<bool (const juce::File& target)>& render) const;
+
+    /** Deletes the least recently used entries until the rest fit in maxBytes */
+    void trim (juce::int64 maxBytes) const;
+
+private:
+    juce::File getEntryFile (const juce::String& key) const;
+
+    const juce::File directory;
+    const bool valid;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderCache)
+};
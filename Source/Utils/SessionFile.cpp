@@ -0,0 +1,642 @@
+#include "SessionFile.h"
+#include "PeakPyramid.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+    const char* const sessionMagic = "VRSS";
+    constexpr size_t headerSize = 16;           // Magic, version, number of sections, reserved
+    constexpr size_t tableEntrySize = 24;       // Id, reserved, offset, size
+    constexpr size_t sectionAlignment = 8;
+    constexpr size_t correctionsHeaderSize = 16;
+
+    constexpr juce::uint32 makeSectionId (const char (&name)[5])
+    {
+        return (juce::uint32) (juce::uint8) name[0] | (juce::uint32) (juce::uint8) name[1] << 8
+             | (juce::uint32) (juce::uint8) name[2] << 16 | (juce::uint32) (juce::uint8) name[3] << 24;
+    }
+
+    constexpr juce::uint32 infoSection = makeSectionId ("INFO");
+    constexpr juce::uint32 settingsSection = makeSectionId ("SETS");
+    constexpr juce::uint32 correctionsSection = makeSectionId ("CLIK");
+    constexpr juce::uint32 tracksSection = makeSectionId ("TRAK");
+    constexpr juce::uint32 peakCacheSection = makeSectionId ("PEAK");
+    constexpr juce::uint32 levelCacheSection = makeSectionId ("LEVL");
+
+    constexpr juce::uint8 manualFlag = 1;
+    constexpr juce::uint8 appliedFlag = 2;
+
+    size_t alignUp (size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void padTo (juce::OutputStream& output, size_t alignment)
+    {
+        while ((size_t) output.getPosition() % alignment != 0)
+            output.writeByte (0);
+    }
+
+    //==============================================================================
+    // Positions are stored as differences from the one before, zigzagged so an
+    // unsorted store still gets small numbers, in 7-bit groups
+    juce::uint64 zigzag (juce::int64 value)
+    {
+        return ((juce::uint64) value << 1) ^ (juce::uint64) (value >> 63);
+    }
+
+    juce::int64 unzigzag (juce::uint64 value)
+    {
+        return (juce::int64) (value >> 1) ^ -(juce::int64) (value & 1);
+    }
+
+    void writeVarint (juce::OutputStream& output, juce::uint64 value)
+    {
+        while (value >= 0x80)
+        {
+            output.writeByte ((char) (value | 0x80));
+            value >>= 7;
+        }
+
+        output.writeByte ((char) value);
+    }
+
+    bool readVarint (const juce::uint8*& position, const juce::uint8* end, juce::uint64& value)
+    {
+        value = 0;
+
+        for (int shift = 0; shift < 64 && position < end; shift += 7)
+        {
+            const auto byte = *position++;
+            value |= (juce::uint64) (byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    //==============================================================================
+    template <typename Type>
+    Type fromLittleEndian (const void* source)
+    {
+        static_assert (std::is_trivially_copyable<Type>::value, "Columns hold plain values");
+
+        Type value;
+        std::memcpy (&value, source, sizeof (Type));
+
+       #if JUCE_BIG_ENDIAN
+        auto* bytes = reinterpret_cast<char*> (&value);
+        std::reverse (bytes, bytes + sizeof (Type));
+       #endif
+
+        return value;
+    }
+
+    template <typename Type>
+    bool writeColumn (juce::OutputStream& output, std::vector<Type>& values)
+    {
+       #if JUCE_BIG_ENDIAN
+        for (auto& value : values)
+        {
+            auto* bytes = reinterpret_cast<char*> (&value);
+            std::reverse (bytes, bytes + sizeof (Type));
+        }
+       #endif
+
+        return values.empty() || output.write (values.data(), values.size() * sizeof (Type));
+    }
+}
+
+//==============================================================================
+bool SessionFile::isBinarySession (const juce::File& file)
+{
+    juce::FileInputStream input (file);
+    char magic[4] = {};
+
+    return input.openedOk() && input.read (magic, 4) == 4 && std::memcmp (magic, sessionMagic, 4) == 0;
+}
+
+//==============================================================================
+SessionFile::Writer::Writer (const juce::File& audioFileToUse)
+    : audioFile (audioFileToUse),
+      audioFileSize (audioFileToUse.getSize()),
+      timestamp (juce::Time::getCurrentTime())
+{
+}
+
+void SessionFile::Writer::setSettings (const juce::var& settings)
+{
+    juce::MemoryOutputStream output;
+
+    // Values go in as JSON, as var::writeToStream() cannot hold objects
+    if (auto* object = settings.getDynamicObject())
+    {
+        const auto& properties = object->getProperties();
+        output.writeCompressedInt (properties.size());
+
+        for (const auto& property : properties)
+        {
+            output.writeString (property.name.toString());
+            output.writeString (juce::JSON::toString (property.value, true));
+        }
+    }
+    else
+    {
+        output.writeCompressedInt (0);
+    }
+
+    sections[settingsSection] = output.getMemoryBlock();
+}
+
+void SessionFile::Writer::setCorrections (const ClickStore& corrections)
+{
+    const auto count = corrections.size();
+
+    juce::MemoryOutputStream positions (count * 3);
+    std::vector<juce::uint16> widths;
+    std::vector<float> magnitudes;
+    std::vector<juce::uint8> flags;
+    widths.reserve (count);
+    magnitudes.reserve (count);
+    flags.reserve (count);
+
+    juce::int64 previous = 0;
+    corrections.forEach (0, count, [&] (size_t, int64_t position, int width, float magnitude, bool isManual, bool isApplied)
+    {
+        writeVarint (positions, zigzag ((juce::int64) position - previous));
+        previous = (juce::int64) position;
+
+        widths.push_back ((juce::uint16) width);
+        magnitudes.push_back (magnitude);
+        flags.push_back ((juce::uint8) ((isManual ? manualFlag : 0) | (isApplied ? appliedFlag : 0)));
+    });
+
+    juce::MemoryOutputStream output (correctionsHeaderSize + positions.getDataSize() + count * 7 + 8);
+    output.writeInt64 ((juce::int64) count);
+    output.writeInt64 ((juce::int64) positions.getDataSize());
+    output.write (positions.getData(), positions.getDataSize());
+
+    // Each fixed-width column starts aligned for its type
+    padTo (output, 4);
+    writeColumn (output, widths);
+    padTo (output, 4);
+    writeColumn (output, magnitudes);
+    writeColumn (output, flags);
+
+    sections[correctionsSection] = output.getMemoryBlock();
+}
+
+void SessionFile::Writer::setTracks (const std::vector<TrackDetector::TrackBoundary>& tracks)
+{
+    juce::MemoryOutputStream output;
+    output.writeInt64 ((juce::int64) tracks.size());
+
+    juce::int64 previous = 0;
+
+    for (const auto& track : tracks)
+    {
+        writeVarint (output, zigzag ((juce::int64) track.position - previous));
+        previous = (juce::int64) track.position;
+
+        output.writeByte (track.isManual ? 1 : 0);
+        output.writeString (track.name);
+    }
+
+    sections[tracksSection] = output.getMemoryBlock();
+}
+
+void SessionFile::Writer::addPeakCache (const juce::File& sidecar)
+{
+    juce::MemoryBlock sidecarData;
+
+    if (sidecar.existsAsFile() && sidecar.loadFileAsData (sidecarData) && sidecarData.getSize() > 0)
+        sections[peakCacheSection] = std::move (sidecarData);
+}
+
+void SessionFile::Writer::addLevelCache (const TrackDetector::WindowLevels& levels)
+{
+    const auto fingerprint = PeakPyramid::fingerprint (audioFile);
+
+    if (fingerprint == 0 || levels.getNumSamples() <= 0)
+        return;
+
+    juce::MemoryOutputStream output;
+    output.writeInt64 ((juce::int64) fingerprint);
+    levels.writeTo (output);
+
+    sections[levelCacheSection] = output.getMemoryBlock();
+}
+
+bool SessionFile::Writer::writeTo (juce::OutputStream& output) const
+{
+    juce::MemoryOutputStream info;
+    info.writeString (audioFile.getFullPathName());
+    info.writeInt64 (audioFileSize);
+    info.writeInt64 (timestamp.toMilliseconds());
+
+    const auto infoBlock = info.getMemoryBlock();
+    std::vector<std::pair<juce::uint32, const juce::MemoryBlock*>> contents;
+    contents.emplace_back (infoSection, &infoBlock);
+
+    for (const auto& section : sections)
+        contents.emplace_back (section.first, &section.second);
+
+    const auto start = output.getPosition();
+
+    if (!output.write (sessionMagic, 4)
+        || !output.writeInt (currentVersion)
+        || !output.writeInt ((int) contents.size())
+        || !output.writeInt (0))
+        return false;
+
+    auto offset = alignUp (headerSize + contents.size() * tableEntrySize, sectionAlignment);
+
+    for (const auto& section : contents)
+    {
+        if (!output.writeInt ((int) section.first)
+            || !output.writeInt (0)
+            || !output.writeInt64 ((juce::int64) offset)
+            || !output.writeInt64 ((juce::int64) section.second->getSize()))
+            return false;
+
+        offset = alignUp (offset + section.second->getSize(), sectionAlignment);
+    }
+
+    for (const auto& section : contents)
+    {
+        while ((size_t) (output.getPosition() - start) % sectionAlignment != 0)
+            output.writeByte (0);
+
+        if (section.second->getSize() > 0 && !output.write (section.second->getData(), section.second->getSize()))
+            return false;
+    }
+
+    return true;
+}
+
+bool SessionFile::Writer::writeTo (const juce::File& sessionFile) const
+{
+    juce::TemporaryFile temp (sessionFile);
+
+    {
+        juce::FileOutputStream output (temp.getFile());
+
+        if (!output.openedOk() || !writeTo (output))
+            return false;
+
+        output.flush();
+
+        if (!output.getStatus().wasOk())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+SessionFile::SessionFile (const juce::File& sessionFile)
+{
+    mappedFile = std::make_unique<juce::MemoryMappedFile> (sessionFile, juce::MemoryMappedFile::readOnly);
+
+    if (mappedFile->getData() != nullptr)
+    {
+        data = static_cast<const char*> (mappedFile->getData());
+        dataSize = mappedFile->getSize();
+    }
+    else
+    {
+        // Some file systems cannot be mapped; read the whole file instead
+        mappedFile.reset();
+
+        if (sessionFile.loadFileAsData (ownedData))
+        {
+            data = static_cast<const char*> (ownedData.getData());
+            dataSize = ownedData.getSize();
+        }
+    }
+
+    parse();
+}
+
+SessionFile::SessionFile (juce::MemoryBlock sessionData)
+    : ownedData (std::move (sessionData))
+{
+    data = static_cast<const char*> (ownedData.getData());
+    dataSize = ownedData.getSize();
+    parse();
+}
+
+void SessionFile::parse()
+{
+    if (data == nullptr || dataSize < headerSize || std::memcmp (data, sessionMagic, 4) != 0)
+        return;
+
+    version = fromLittleEndian<juce::int32> (data + 4);
+    const auto numSections = fromLittleEndian<juce::int32> (data + 8);
+
+    // A newer version may have changed the sections this one knows
+    if (version < 1 || version > currentVersion || numSections < 0
+        || (size_t) numSections > (dataSize - headerSize) / tableEntrySize)
+        return;
+
+    for (size_t i = 0; i < (size_t) numSections; ++i)
+    {
+        const char* entry = data + headerSize + i * tableEntrySize;
+        const auto id = fromLittleEndian<juce::uint32> (entry);
+        const auto offset = fromLittleEndian<juce::int64> (entry + 8);
+        const auto size = fromLittleEndian<juce::int64> (entry + 16);
+
+        if (offset < 0 || size < 0 || (juce::uint64) offset > dataSize || (juce::uint64) size > dataSize - (size_t) offset)
+            return;
+
+        sections[id] = { data + offset, (size_t) size };
+    }
+
+    const auto info = getSection (infoSection);
+
+    if (info.data == nullptr)
+        return;
+
+    juce::MemoryInputStream input (info.data, info.size, false);
+    audioFile = juce::File (input.readString());
+    audioFileSize = input.readInt64();
+    timestamp = juce::Time (input.readInt64());
+
+    valid = audioFile != juce::File();
+}
+
+SessionFile::Section SessionFile::getSection (juce::uint32 id) const
+{
+    const auto it = sections.find (id);
+    return it != sections.end() ? it->second : Section();
+}
+
+//==============================================================================
+juce::var SessionFile::getSettings() const
+{
+    const auto section = getSection (settingsSection);
+    auto* settings = new juce::DynamicObject();
+    juce::var result (settings);
+
+    if (section.data == nullptr)
+        return result;
+
+    juce::MemoryInputStream input (section.data, section.size, false);
+    const int numSettings = input.readCompressedInt();
+
+    for (int i = 0; i < numSettings && !input.isExhausted(); ++i)
+    {
+        const auto key = input.readString();
+        settings->setProperty (key, juce::JSON::fromString (input.readString()));
+    }
+
+    return result;
+}
+
+juce::int64 SessionFile::getNumCorrections() const
+{
+    const auto section = getSection (correctionsSection);
+    return section.size >= correctionsHeaderSize ? fromLittleEndian<juce::int64> (section.data) : 0;
+}
+
+bool SessionFile::readCorrections (ClickStore& store) const
+{
+    const auto section = getSection (correctionsSection);
+
+    if (section.size < correctionsHeaderSize)
+        return false;
+
+    const auto count = fromLittleEndian<juce::int64> (section.data);
+    const auto positionBytes = fromLittleEndian<juce::int64> (section.data + 8);
+
+    // Every correction takes at least eight bytes, which bounds the count before anything is sized by it
+    if (count < 0 || positionBytes < 0 || (juce::uint64) count > section.size / 8
+        || (juce::uint64) positionBytes > section.size - correctionsHeaderSize)
+        return false;
+
+    const auto numCorrections = (size_t) count;
+    const auto widthsOffset = alignUp (correctionsHeaderSize + (size_t) positionBytes, 4);
+    const auto magnitudesOffset = alignUp (widthsOffset + numCorrections * sizeof (juce::uint16), 4);
+    const auto flagsOffset = magnitudesOffset + numCorrections * sizeof (float);
+
+    if (flagsOffset + numCorrections > section.size)
+        return false;
+
+    const auto* position = reinterpret_cast<const juce::uint8*> (section.data + correctionsHeaderSize);
+    const auto* positionsEnd = position + positionBytes;
+    const char* widths = section.data + widthsOffset;
+    const char* magnitudes = section.data + magnitudesOffset;
+    const auto* flags = reinterpret_cast<const juce::uint8*> (section.data + flagsOffset);
+
+    store.clear();
+    store.reserve (numCorrections);
+
+    juce::int64 previous = 0;
+
+    for (size_t i = 0; i < numCorrections; ++i)
+    {
+        juce::uint64 delta = 0;
+
+        if (!readVarint (position, positionsEnd, delta))
+        {
+            store.clear();
+            return false;
+        }
+
+        previous += unzigzag (delta);
+
+        store.add (previous,
+                   fromLittleEndian<juce::uint16> (widths + i * sizeof (juce::uint16)),
+                   fromLittleEndian<float> (magnitudes + i * sizeof (float)),
+                   (flags[i] & manualFlag) != 0,
+                   (flags[i] & appliedFlag) != 0);
+    }
+
+    return true;
+}
+
+std::vector<TrackDetector::TrackBoundary> SessionFile::readTracks() const
+{
+    std::vector<TrackDetector::TrackBoundary> tracks;
+    const auto section = getSection (tracksSection);
+
+    if (section.size < 8)
+        return tracks;
+
+    const auto count = fromLittleEndian<juce::int64> (section.data);
+    const auto* position = reinterpret_cast<const juce::uint8*> (section.data + 8);
+    const auto* end = reinterpret_cast<const juce::uint8*> (section.data + section.size);
+
+    // At least three bytes a track: position, flag and the name's terminator
+    if (count < 0 || (juce::uint64) count > section.size / 3)
+        return tracks;
+
+    tracks.reserve ((size_t) count);
+    juce::int64 previous = 0;
+
+    for (juce::int64 i = 0; i < count; ++i)
+    {
+        juce::uint64 delta = 0;
+
+        if (!readVarint (position, end, delta) || position >= end)
+            break;
+
+        previous += unzigzag (delta);
+        const bool isManual = *position++ != 0;
+
+        const auto* nameEnd = std::find (position, end, (juce::uint8) 0);
+
+        if (nameEnd == end)
+            break;
+
+        tracks.emplace_back (previous, isManual,
+                             juce::String::fromUTF8 (reinterpret_cast<const char*> (position), (int) (nameEnd - position)));
+        position = nameEnd + 1;
+    }
+
+    return tracks;
+}
+
+bool SessionFile::restorePeakCache (const juce::File& sidecar) const
+{
+    const auto section = getSection (peakCacheSection);
+    return section.size > 0 && sidecar.replaceWithData (section.data, section.size);
+}
+
+bool SessionFile::readLevelCache (TrackDetector::WindowLevels& levels, int numChannels, juce::int64 numSamples) const
+{
+    const auto section = getSection (levelCacheSection);
+
+    if (section.size < 8)
+        return false;
+
+    juce::MemoryInputStream input (section.data, section.size, false);
+    const auto fingerprint = PeakPyramid::fingerprint (audioFile);
+
+    if (fingerprint == 0 || (juce::uint64) input.readInt64() != fingerprint)
+        return false;
+
+    return levels.readFrom (input, numChannels, numSamples);
+}
+
+//==============================================================================
+juce::var SessionFile::toJSON() const
+{
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("audioFile", audioFile.getFullPathName());
+    root->setProperty ("timestamp", timestamp.toISO8601 (true));
+    root->setProperty ("fileSize", audioFileSize);
+    root->setProperty ("sessionData", getSettings());
+
+    ClickStore corrections;
+
+    if (readCorrections (corrections))
+    {
+        // Columns, as in the binary form: a fifth of the size of an object per correction
+        juce::Array<juce::var> positions, widths, magnitudes, manual, applied;
+        const auto count = (int) corrections.size();
+
+        for (auto* column : { &positions, &widths, &magnitudes, &manual, &applied })
+            column->ensureStorageAllocated (count);
+
+        corrections.forEach (0, corrections.size(), [&] (size_t, int64_t position, int width, float magnitude, bool isManual, bool isApplied)
+        {
+            positions.add ((juce::int64) position);
+            widths.add (width);
+            magnitudes.add (magnitude);
+            manual.add (isManual);
+            applied.add (isApplied);
+        });
+
+        auto* columns = new juce::DynamicObject();
+        columns->setProperty ("position", positions);
+        columns->setProperty ("width", widths);
+        columns->setProperty ("magnitude", magnitudes);
+        columns->setProperty ("manual", manual);
+        columns->setProperty ("applied", applied);
+        root->setProperty ("corrections", juce::var (columns));
+    }
+
+    juce::Array<juce::var> tracks;
+
+    for (const auto& track : readTracks())
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty ("position", (juce::int64) track.position);
+        object->setProperty ("manual", track.isManual);
+        object->setProperty ("name", track.name);
+        tracks.add (juce::var (object));
+    }
+
+    root->setProperty ("tracks", tracks);
+    return juce::var (root);
+}
+
+std::unique_ptr<SessionFile> SessionFile::fromJSON (const juce::var& json)
+{
+    if (!json.isObject() || json["audioFile"].toString().isEmpty())
+        return nullptr;
+
+    Writer writer (juce::File (json["audioFile"].toString()));
+
+    if (json.hasProperty ("fileSize"))
+        writer.audioFileSize = (juce::int64) json["fileSize"];
+
+    if (json.hasProperty ("timestamp"))
+        writer.timestamp = juce::Time::fromISO8601 (json["timestamp"].toString());
+
+    writer.setSettings (json["sessionData"]);
+
+    const auto corrections = json["corrections"];
+
+    if (const auto* positions = corrections["position"].getArray())
+    {
+        const auto* widths = corrections["width"].getArray();
+        const auto* magnitudes = corrections["magnitude"].getArray();
+        const auto* manual = corrections["manual"].getArray();
+        const auto* applied = corrections["applied"].getArray();
+
+        const auto valueAt = [] (const juce::Array<juce::var>* column, int index)
+        {
+            return column != nullptr && index < column->size() ? column->getReference (index) : juce::var();
+        };
+
+        ClickStore store;
+        store.reserve ((size_t) positions->size());
+
+        for (int i = 0; i < positions->size(); ++i)
+            store.add ((juce::int64) positions->getReference (i),
+                       (int) valueAt (widths, i),
+                       (float) valueAt (magnitudes, i),
+                       (bool) valueAt (manual, i),
+                       (bool) valueAt (applied, i));
+
+        writer.setCorrections (store);
+    }
+
+    if (const auto* trackArray = json["tracks"].getArray())
+    {
+        std::vector<TrackDetector::TrackBoundary> tracks;
+
+        for (const auto& track : *trackArray)
+            tracks.emplace_back ((juce::int64) track["position"], (bool) track["manual"], track["name"].toString());
+
+        writer.setTracks (tracks);
+    }
+
+    juce::MemoryOutputStream output;
+
+    if (!writer.writeTo (output))
+        return nullptr;
+
+    auto session = std::make_unique<SessionFile> (output.getMemoryBlock());
+
+    if (!session->isValid())
+        return nullptr;
+
+    return session;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "../DSP/ClickEvents.h"
+#include "../Processors/TrackDetector.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * Session File
+ *
+ * The binary session format (.vrs). Sessions of badly damaged records hold
+ * hundreds of thousands of corrections, which as JSON took seconds to write
+ * and parse and a var per value in memory. Here they are columns:
+ *
+ *   header      "VRSS", version, number of sections
+ *   table       per section: id, offset and size
+ *   INFO        audio file path, size and save time
+ *   SETS        settings, a small block of key / JSON value pairs
+ *   CLIK        corrections: positions as varint deltas, then widths,
+ *               magnitudes and flags as fixed-width arrays
+ *   TRAK        track boundaries, positions as varint deltas
+ *   PEAK        the waveform overview sidecar, verbatim      (optional)
+ *   LEVL        track detection levels of the audio file     (optional)
+ *
+ * Little-endian throughout; sections start on 8-byte boundaries, so the
+ * fixed-width columns can be used in place. A file is memory-mapped and
+ * only its header and table are read on opening: a section is decoded, and
+ * its pages touched, when it is asked for. Unknown sections are skipped,
+ * so later versions can add some without breaking older readers.
+ *
+ * toJSON() / fromJSON() convert to and from the JSON form, which the older
+ * sessions were saved in and which stays the format for interchange.
+ */
+class SessionFile
+{
+public:
+    static constexpr int currentVersion = 1;
+
+    /** True if the file starts like a binary session (as opposed to a JSON one) */
+    static bool isBinarySession (const juce::File& file);
+
+    //==============================================================================
+    /** Collects a session's contents, section by section, and writes them as one file */
+    class Writer
+    {
+    public:
+        /** A session of audioFile, saved now */
+        explicit Writer (const juce::File& audioFile);
+
+        /** The settings; the object's properties become the key / value block */
+        void setSettings (const juce::var& settings);
+
+        void setCorrections (const ClickStore& corrections);
+        void setTracks (const std::vector<TrackDetector::TrackBoundary>& tracks);
+
+        /** Bundles a waveform overview sidecar, if it exists (it carries its own fingerprint of the audio) */
+        void addPeakCache (const juce::File& sidecar);
+
+        /** Bundles track detection levels; only valid for the audio file exactly as saved */
+        void addLevelCache (const TrackDetector::WindowLevels& levels);
+
+        bool writeTo (juce::OutputStream& output) const;
+
+        /** Replaces sessionFile, through a temporary file so a failed save leaves the old one */
+        bool writeTo (const juce::File& sessionFile) const;
+
+    private:
+        friend class SessionFile;
+
+        juce::File audioFile;
+        juce::int64 audioFileSize = 0;
+        juce::Time timestamp;
+        std::map<juce::uint32, juce::MemoryBlock> sections;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Writer)
+    };
+
+    //==============================================================================
+    /** Opens a binary session, mapped; see isValid() */
+    explicit SessionFile (const juce::File& sessionFile);
+
+    /** A binary session held in memory */
+    explicit SessionFile (juce::MemoryBlock sessionData);
+
+    /** Builds a session from its JSON form; nullptr if the JSON is not a session */
+    static std::unique_ptr<SessionFile> fromJSON (const juce::var& json);
+
+    /** The JSON form: audio file, settings, corrections and tracks (the caches are left out) */
+    juce::var toJSON() const;
+
+    bool isValid() const { return valid; }
+    int getVersion() const { return version; }
+
+    juce::File getAudioFile() const { return audioFile; }
+    juce::int64 getAudioFileSize() const { return audioFileSize; }
+    juce::Time getTimestamp() const { return timestamp; }
+
+    /** The settings block, decoded on each call */
+    juce::var getSettings() const;
+
+    /** Number of corrections, without decoding them */
+    juce::int64 getNumCorrections() const;
+
+    /** Decodes the corrections into store; false if the section is missing or damaged */
+    bool readCorrections (ClickStore& store) const;
+
+    std::vector<TrackDetector::TrackBoundary> readTracks() const;
+
+    /** Writes the bundled waveform overview out as sidecar; false if there is none */
+    bool restorePeakCache (const juce::File& sidecar) const;
+
+    /** Reads the bundled track detection levels if the audio file is unchanged and of this shape */
+    bool readLevelCache (TrackDetector::WindowLevels& levels, int numChannels, juce::int64 numSamples) const;
+
+private:
+    struct Section
+    {
+        const char* data = nullptr;
+        size_t size = 0;
+    };
+
+    void parse();
+    Section getSection (juce::uint32 id) const;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    juce::MemoryBlock ownedData;
+    const char* data = nullptr;
+    size_t dataSize = 0;
+
+    std::map<juce::uint32, Section> sections;
+    bool valid = false;
+    int version = 0;
+
+    juce::File audioFile;
+    juce::int64 audioFileSize = 0;
+    juce::Time timestamp;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SessionFile)
+};
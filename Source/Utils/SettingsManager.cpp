@@ -7,6 +7,16 @@ namespace
     constexpr const char* kDmlDeviceKey = "aiDmlDeviceId";
     constexpr const char* kQnnBackendKey = "aiQnnBackendPath";
     constexpr const char* kModelPathKey = "aiModelPath";
+    constexpr const char* kAsyncInferenceKey = "aiAsyncInference";
+    constexpr const char* kIntraOpThreadsKey = "aiIntraOpThreads";
+    constexpr const char* kAllowSpinningKey = "aiAllowSpinning";
+    constexpr const char* kThreadAffinityKey = "aiThreadAffinity";
+    constexpr const char* kBenchmarkSignatureKey = "aiBenchmarkSignature";
+    constexpr const char* kBenchmarkWinnerKey = "aiBenchmarkWinner";
+    constexpr const char* kBenchmarkReportKey = "aiBenchmarkReport";
+    constexpr const char* kUndoMaxStatesKey = "undoMaxStates";
+    constexpr const char* kUndoResidentStatesKey = "undoResidentStates";
+    constexpr const char* kUndoMemoryBudgetKey = "undoMemoryBudgetMB";
 }
 
 SettingsManager& SettingsManager::getInstance()
@@ -37,6 +47,10 @@ SettingsManager::DenoiseSettings SettingsManager::getDenoiseSettings()
     settings.dmlDeviceId = props->getIntValue (kDmlDeviceKey, 0);
     settings.qnnBackendPath = props->getValue (kQnnBackendKey, "");
     settings.modelPath = props->getValue (kModelPathKey, "");
+    settings.asyncInference = props->getBoolValue (kAsyncInferenceKey, false);
+    settings.intraOpThreads = props->getIntValue (kIntraOpThreadsKey, 1);
+    settings.allowSpinning = props->getBoolValue (kAllowSpinningKey, false);
+    settings.threadAffinity = props->getValue (kThreadAffinityKey, "");
     return settings;
 }
 
@@ -48,6 +62,48 @@ void SettingsManager::setDenoiseSettings (const DenoiseSettings& settings)
     props->setValue (kDmlDeviceKey, settings.dmlDeviceId);
     props->setValue (kQnnBackendKey, settings.qnnBackendPath);
     props->setValue (kModelPathKey, settings.modelPath);
+    props->setValue (kAsyncInferenceKey, settings.asyncInference);
+    props->setValue (kIntraOpThreadsKey, settings.intraOpThreads);
+    props->setValue (kAllowSpinningKey, settings.allowSpinning);
+    props->setValue (kThreadAffinityKey, settings.threadAffinity);
+    props->saveIfNeeded();
+}
+
+SettingsManager::ProviderBenchmarkRecord SettingsManager::getProviderBenchmark()
+{
+    auto* props = appProperties.getUserSettings();
+    ProviderBenchmarkRecord record;
+    record.signature = props->getValue (kBenchmarkSignatureKey, "");
+    record.winner = props->getValue (kBenchmarkWinnerKey, "");
+    record.report = props->getValue (kBenchmarkReportKey, "");
+    return record;
+}
+
+void SettingsManager::setProviderBenchmark (const ProviderBenchmarkRecord& record)
+{
+    auto* props = appProperties.getUserSettings();
+    props->setValue (kBenchmarkSignatureKey, record.signature);
+    props->setValue (kBenchmarkWinnerKey, record.winner);
+    props->setValue (kBenchmarkReportKey, record.report);
+    props->saveIfNeeded();
+}
+
+SettingsManager::UndoSettings SettingsManager::getUndoSettings()
+{
+    auto* props = appProperties.getUserSettings();
+    UndoSettings settings;
+    settings.maxStates = props->getIntValue (kUndoMaxStatesKey, settings.maxStates);
+    settings.residentStates = props->getIntValue (kUndoResidentStatesKey, settings.residentStates);
+    settings.memoryBudgetMB = props->getIntValue (kUndoMemoryBudgetKey, settings.memoryBudgetMB);
+    return settings;
+}
+
+void SettingsManager::setUndoSettings (const UndoSettings& settings)
+{
+    auto* props = appProperties.getUserSettings();
+    props->setValue (kUndoMaxStatesKey, settings.maxStates);
+    props->setValue (kUndoResidentStatesKey, settings.residentStates);
+    props->setValue (kUndoMemoryBudgetKey, settings.memoryBudgetMB);
     props->saveIfNeeded();
 }
 
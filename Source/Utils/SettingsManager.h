@@ -12,6 +12,28 @@ public:
         int dmlDeviceId = 0;
         juce::String qnnBackendPath;
         juce::String modelPath;
+        bool asyncInference = false;
+
+        // Shared ONNX Runtime thread pool, applied at the next start
+        int intraOpThreads = 1;
+        bool allowSpinning = false;
+        juce::String threadAffinity;
+    };
+
+    /** Last execution-provider benchmark (see ProviderBenchmarkRunner) */
+    struct ProviderBenchmarkRecord
+    {
+        juce::String signature;    // OnnxDenoiser::getBenchmarkSignature() it was measured on
+        juce::String winner;       // Provider name, empty if none worked
+        juce::String report;       // One line per provider, for the settings dialog
+    };
+
+    /** Undo history depth and how much of it stays in memory (see AudioUndoManager) */
+    struct UndoSettings
+    {
+        int maxStates = 50;
+        int residentStates = 4;      // Newest states of each stack kept in memory
+        int memoryBudgetMB = 1024;   // Older or larger states are compressed to disk
     };
 
     static SettingsManager& getInstance();
@@ -19,6 +41,12 @@ public:
     DenoiseSettings getDenoiseSettings();
     void setDenoiseSettings (const DenoiseSettings& settings);
 
+    ProviderBenchmarkRecord getProviderBenchmark();
+    void setProviderBenchmark (const ProviderBenchmarkRecord& record);
+
+    UndoSettings getUndoSettings();
+    void setUndoSettings (const UndoSettings& settings);
+
     juce::PropertiesFile& getProperties();
     juce::File getSettingsFile();
 
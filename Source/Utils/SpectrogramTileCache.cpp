@@ -0,0 +1,276 @@
+#include "SpectrogramTileCache.h"
+#include "../DSP/StftEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SpectrogramTileCache::SpectrogramTileCache() = default;
+
+SpectrogramTileCache::~SpectrogramTileCache()
+{
+    // A tile in progress is a few hundred FFTs; let it finish
+    pool.removeAllJobs (true, 10000);
+}
+
+void SpectrogramTileCache::setSource (const juce::AudioBuffer<float>* buffer, double newSampleRate, const juce::CriticalSection* bufferLock)
+{
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        source = buffer;
+        sourceLock = bufferLock;
+        sampleRate = newSampleRate;
+        entries.clear();
+        pending.clear();
+        numBytes = 0;
+    }
+
+    sendChangeMessage();
+}
+
+juce::int64 SpectrogramTileCache::getNumSamples() const
+{
+    const std::lock_guard<std::mutex> guard (lock);
+    return source != nullptr ? source->getNumSamples() : 0;
+}
+
+void SpectrogramTileCache::setFftOrder (int order)
+{
+    if (order == fftOrder.load())
+        return;
+
+    fftOrder = order;
+    invalidateAll();
+}
+
+void SpectrogramTileCache::invalidate (juce::int64 startSample, juce::int64 numSamples)
+{
+    const auto endSample = numSamples < 0 ? std::numeric_limits<juce::int64>::max() : startSample + numSamples;
+
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        const juce::int64 fftSize = getFftSize();
+
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            // A tile's frames start within its columns and reach one FFT beyond the last
+            const juce::int64 span = (juce::int64) columnsPerTile * it->first.hop;
+            const auto tileStart = it->first.index * span;
+            const auto tileEnd = tileStart + span + fftSize;
+
+            if (tileStart < endSample && tileEnd > startSample)
+            {
+                if (it->second.tile != nullptr)
+                    numBytes -= it->second.tile->levels.size() * sizeof (juce::uint16);
+
+                it = entries.erase (it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    sendChangeMessage();
+}
+
+void SpectrogramTileCache::invalidateAll()
+{
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        entries.clear();
+        pending.clear();
+        numBytes = 0;
+    }
+
+    sendChangeMessage();
+}
+
+int SpectrogramTileCache::getHopForResolution (double samplesPerColumn)
+{
+    int hop = minHop;
+
+    while (hop < (1 << 24) && hop * 2.0 <= samplesPerColumn)
+        hop *= 2;
+
+    return hop;
+}
+
+juce::uint16 SpectrogramTileCache::toLevel (float decibels)
+{
+    const float normalised = (juce::jlimit (minDecibels, maxDecibels, decibels) - minDecibels) / (maxDecibels - minDecibels);
+    return (juce::uint16) juce::roundToInt (normalised * 65535.0f);
+}
+
+float SpectrogramTileCache::toGain (juce::uint16 level)
+{
+    static const std::vector<float> table = []
+    {
+        std::vector<float> gains (65536);
+
+        for (size_t i = 0; i < gains.size(); ++i)
+            gains[i] = juce::Decibels::decibelsToGain (toDecibels ((juce::uint16) i), minDecibels);
+
+        return gains;
+    }();
+
+    return table[level];
+}
+
+//==============================================================================
+SpectrogramTileCache::TilePtr SpectrogramTileCache::getTile (int hop, juce::int64 tileIndex)
+{
+    const std::lock_guard<std::mutex> guard (lock);
+    const Key key { hop, tileIndex };
+    auto& entry = entries[key];
+    entry.lastUsed = ++useCounter;
+
+    if (entry.id == 0)
+    {
+        entry.id = ++nextId;
+        pending.push_back (key);
+
+        pool.addJob ([this]
+        {
+            computeNextTile();
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    return entry.tile;
+}
+
+void SpectrogramTileCache::computeNextTile()
+{
+    Key key {};
+    juce::uint64 id = 0;
+    int order = 0;
+    const juce::AudioBuffer<float>* buffer = nullptr;
+    const juce::CriticalSection* bufferLock = nullptr;
+
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+
+        // Drop keys whose tile was invalidated, computed or taken by another worker
+        pending.erase (std::remove_if (pending.begin(), pending.end(), [this] (const Key& k)
+        {
+            const auto found = entries.find (k);
+            return found == entries.end() || found->second.tile != nullptr || found->second.computing;
+        }), pending.end());
+
+        // The most recently requested tile first: it is the one on screen now
+        const auto best = std::max_element (pending.begin(), pending.end(), [this] (const Key& a, const Key& b)
+        {
+            return entries[a].lastUsed < entries[b].lastUsed;
+        });
+
+        if (best == pending.end())
+            return;
+
+        key = *best;
+        pending.erase (best);
+
+        auto& entry = entries[key];
+        entry.computing = true;
+        id = entry.id;
+        order = fftOrder;
+        buffer = source;
+        bufferLock = sourceLock;
+    }
+
+    const int fftSize = 1 << order;
+    const int numBins = fftSize / 2;
+    std::vector<float> frames ((size_t) columnsPerTile * (size_t) fftSize, 0.0f);
+    std::vector<int> frameLengths ((size_t) columnsPerTile, 0);
+    int numColumns = 0;
+
+    // Copy out only the frames, so the source is held for as short a time as possible
+    {
+        const juce::CriticalSection unlocked;
+        const juce::ScopedLock sl (bufferLock != nullptr ? *bufferLock : unlocked);
+
+        // The source may have been detached while this worker waited for its lock
+        {
+            const std::lock_guard<std::mutex> guard (lock);
+
+            if (source != buffer)
+                buffer = nullptr;
+        }
+
+        const juce::int64 length = buffer != nullptr ? buffer->getNumSamples() : 0;
+        const int numChannels = buffer != nullptr ? buffer->getNumChannels() : 0;
+
+        for (int column = 0; column < columnsPerTile && numChannels > 0; ++column)
+        {
+            const auto start = (key.index * columnsPerTile + column) * (juce::int64) key.hop;
+
+            if (start >= length)
+                break;
+
+            const int count = (int) juce::jmin ((juce::int64) fftSize, length - start);
+            float* frame = frames.data() + (size_t) column * (size_t) fftSize;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::add (frame, buffer->getReadPointer (channel, (int) start), count);
+
+            juce::FloatVectorOperations::multiply (frame, 1.0f / (float) numChannels, count);
+            frameLengths[(size_t) column] = count;
+            numColumns = column + 1;
+        }
+    }
+
+    auto tile = std::make_shared<Tile>();
+    tile->numBins = numBins;
+    tile->numColumns = numColumns;
+    tile->levels.resize ((size_t) numColumns * (size_t) numBins);
+
+    StftEngine stft;
+    stft.prepare (order, fftSize / 4, 1);
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        const float* spectrum = stft.transformFrame (frames.data() + (size_t) column * (size_t) fftSize, frameLengths[(size_t) column]);
+        auto* levels = tile->levels.data() + (size_t) column * (size_t) numBins;
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            const float re = spectrum[bin * 2];
+            const float im = spectrum[bin * 2 + 1];
+            levels[bin] = toLevel (juce::Decibels::gainToDecibels (std::sqrt (re * re + im * im), minDecibels));
+        }
+    }
+
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        const auto found = entries.find (key);
+
+        // Invalidated while it was being computed
+        if (found == entries.end() || found->second.id != id)
+            return;
+
+        found->second.tile = std::move (tile);
+        found->second.computing = false;
+        numBytes += found->second.tile->levels.size() * sizeof (juce::uint16);
+        evictIfNeeded();
+    }
+
+    sendChangeMessage();
+}
+
+void SpectrogramTileCache::evictIfNeeded()
+{
+    while (numBytes > maxBytes)
+    {
+        auto oldest = entries.end();
+
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+            if (it->second.tile != nullptr && (oldest == entries.end() || it->second.lastUsed < oldest->second.lastUsed))
+                oldest = it;
+
+        if (oldest == entries.end())
+            return;
+
+        numBytes -= oldest->second.tile->levels.size() * sizeof (juce::uint16);
+        entries.erase (oldest);
+    }
+}
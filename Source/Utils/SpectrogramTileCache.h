@@ -0,0 +1,135 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_events/juce_events.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Spectrogram Tile Cache
+ *
+ * Magnitude columns of an audio buffer, computed on a thread pool in tiles
+ * of columnsPerTile columns and kept for every spectrogram view of that
+ * buffer. A column is the windowed FFT of the (mono-mixed) frame starting
+ * at column * hop; hops are powers of two, so each zoom level has its own
+ * grid of tiles and zooming back finds its tiles still cached.
+ *
+ * Magnitudes are stored in dB as 16-bit levels, so a palette or dB range
+ * change is only a recolour. getTile() returns a tile when it is ready and
+ * otherwise queues it; the most recently requested tiles are computed first,
+ * so the tiles of the current view come before those scrolled away from.
+ * A change message is sent whenever tiles complete or are invalidated.
+ *
+ * After an edit, invalidate() drops only the tiles whose frames overlap the
+ * changed samples; a length change drops everything after the edit point.
+ */
+class SpectrogramTileCache : public juce::ChangeBroadcaster
+{
+public:
+    static constexpr int columnsPerTile = 128;
+    static constexpr int minHop = 64;
+    static constexpr float minDecibels = -200.0f;
+    static constexpr float maxDecibels = 40.0f;
+
+    SpectrogramTileCache();
+    ~SpectrogramTileCache() override;
+
+    /**
+     * The buffer the tiles are computed from. It must outlive the cache;
+     * bufferLock, if given, is held while a worker copies its frames and
+     * must be held by anything that reallocates the buffer.
+     */
+    void setSource (const juce::AudioBuffer<float>* buffer, double sampleRate, const juce::CriticalSection* bufferLock = nullptr);
+
+    void setSampleRate (double newSampleRate) { sampleRate = newSampleRate; }
+    double getSampleRate() const { return sampleRate; }
+
+    /** Length of the source in samples */
+    juce::int64 getNumSamples() const;
+
+    /** FFT size 2^order; changing it drops every tile */
+    void setFftOrder (int order);
+    int getFftSize() const { return 1 << fftOrder; }
+    int getNumBins() const { return getFftSize() / 2; }
+
+    /** Drops the tiles over [startSample, startSample + numSamples); a negative count means to the end */
+    void invalidate (juce::int64 startSample, juce::int64 numSamples);
+
+    /** Drops every tile */
+    void invalidateAll();
+
+    /** The hop of the grid for drawing samplesPerColumn samples per pixel column */
+    static int getHopForResolution (double samplesPerColumn);
+
+    //==============================================================================
+    class Tile
+    {
+    public:
+        /** numBins dB levels of a column, lowest frequency first */
+        const juce::uint16* getColumn (int column) const { return levels.data() + (size_t) column * (size_t) numBins; }
+
+        /** Columns of this tile that lie within the source */
+        int getNumColumns() const { return numColumns; }
+
+    private:
+        friend class SpectrogramTileCache;
+
+        int numBins = 0;
+        int numColumns = 0;
+        std::vector<juce::uint16> levels;
+    };
+
+    using TilePtr = std::shared_ptr<const Tile>;
+
+    /** The tile if it is ready; otherwise queues it and returns null */
+    TilePtr getTile (int hop, juce::int64 tileIndex);
+
+    static juce::uint16 toLevel (float decibels);
+    static float toDecibels (juce::uint16 level)
+    {
+        return minDecibels + (maxDecibels - minDecibels) * (float) level / 65535.0f;
+    }
+
+    /** Linear magnitude of a level, from a table */
+    static float toGain (juce::uint16 level);
+
+private:
+    struct Key
+    {
+        int hop;
+        juce::int64 index;
+
+        bool operator< (const Key& other) const { return hop != other.hop ? hop < other.hop : index < other.index; }
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<Tile> tile;     // Null until computed
+        juce::uint64 id = 0;            // A worker only stores into the entry it started from
+        juce::uint64 lastUsed = 0;
+        bool computing = false;
+    };
+
+    void computeNextTile();
+    void evictIfNeeded();
+
+    const juce::AudioBuffer<float>* source = nullptr;
+    const juce::CriticalSection* sourceLock = nullptr;
+    std::atomic<double> sampleRate { 44100.0 };
+    std::atomic<int> fftOrder { 11 };
+
+    mutable std::mutex lock;
+    std::map<Key, Entry> entries;
+    std::vector<Key> pending;       // Newest last
+    juce::uint64 nextId = 0;
+    juce::uint64 useCounter = 0;
+    size_t numBytes = 0;
+    size_t maxBytes = (size_t) 256 * 1024 * 1024;
+
+    juce::ThreadPool pool { juce::jmax (1, juce::SystemStats::getNumCpus() - 1) };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrogramTileCache)
+};
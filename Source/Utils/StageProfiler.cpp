@@ -0,0 +1,239 @@
+#include "StageProfiler.h"
+#include <utility>
+
+namespace
+{
+    // Upper edges of the load buckets; the last bucket is everything over budget
+    constexpr std::array<double, StageProfiler::numLoadBuckets - 1> loadBucketEdges { 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0 };
+
+    int getLoadBucket (double load) noexcept
+    {
+        int bucket = 0;
+
+        while (bucket < static_cast<int> (loadBucketEdges.size()) && load >= loadBucketEdges[static_cast<size_t> (bucket)])
+            ++bucket;
+
+        return bucket;
+    }
+}
+
+void StageProfiler::prepare (double sampleRate)
+{
+    ticksPerSample = sampleRate > 0.0 ? static_cast<double> (juce::Time::getHighResolutionTicksPerSecond()) / sampleRate : 0.0;
+
+    blockDepth = 0;
+    currentStage = -1;
+    blockTicks.fill (0);
+
+    const auto clear = [] (AtomicLoad& load)
+    {
+        load.ticks.store (0);
+        load.peakPermille.store (0);
+
+        for (auto& count : load.histogram)
+            count.store (0);
+    };
+
+    for (auto& load : stageLoads)
+        clear (load);
+
+    clear (totalLoad);
+    budgetTicks.store (0);
+    blocks.store (0);
+    misses.store (0);
+
+    lastStageTicks.fill (0);
+    lastTotalTicks = lastBudgetTicks = lastBlocks = lastMisses = 0;
+}
+
+//==============================================================================
+StageProfiler::ScopedBlock::ScopedBlock (StageProfiler& profiler, int samples) noexcept
+    : owner (profiler), numSamples (samples), outermost (profiler.blockDepth++ == 0)
+{
+    if (outermost)
+    {
+        owner.blockStart = owner.segmentStart = juce::Time::getHighResolutionTicks();
+        owner.currentStage = -1;
+    }
+}
+
+StageProfiler::ScopedBlock::~ScopedBlock() noexcept
+{
+    --owner.blockDepth;
+
+    if (outermost)
+        owner.endBlock (numSamples);
+}
+
+StageProfiler::ScopedTimer::ScopedTimer (StageProfiler& profiler, Stage stage) noexcept
+    : owner (profiler), previous (profiler.currentStage)
+{
+    owner.switchStage (static_cast<int> (stage), juce::Time::getHighResolutionTicks());
+}
+
+StageProfiler::ScopedTimer::~ScopedTimer() noexcept
+{
+    owner.switchStage (previous, juce::Time::getHighResolutionTicks());
+}
+
+void StageProfiler::switchStage (int newStage, juce::int64 now) noexcept
+{
+    // Outside a block there is no budget to charge against
+    if (blockDepth > 0 && currentStage >= 0)
+        blockTicks[static_cast<size_t> (currentStage)] += now - segmentStart;
+
+    currentStage = newStage;
+    segmentStart = now;
+}
+
+void StageProfiler::endBlock (int numSamples) noexcept
+{
+    const auto now = juce::Time::getHighResolutionTicks();
+    switchStage (-1, now);
+
+    const double budget = ticksPerSample * numSamples;
+
+    if (budget <= 0.0)
+        return;
+
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        auto& ticks = blockTicks[static_cast<size_t> (stage)];
+
+        if (ticks > 0)
+            record (stageLoads[static_cast<size_t> (stage)], ticks, budget);
+
+        ticks = 0;
+    }
+
+    const auto elapsed = now - blockStart;
+    record (totalLoad, elapsed, budget);
+
+    budgetTicks.fetch_add (static_cast<juce::int64> (budget), std::memory_order_relaxed);
+    blocks.fetch_add (1, std::memory_order_relaxed);
+
+    if (static_cast<double> (elapsed) > budget)
+        misses.fetch_add (1, std::memory_order_relaxed);
+}
+
+void StageProfiler::record (AtomicLoad& load, juce::int64 ticks, double budget) noexcept
+{
+    const double blockLoad = static_cast<double> (ticks) / budget;
+
+    load.ticks.fetch_add (ticks, std::memory_order_relaxed);
+    load.histogram[static_cast<size_t> (getLoadBucket (blockLoad))].fetch_add (1, std::memory_order_relaxed);
+
+    // Only this thread raises the peak; the reader only resets it
+    const auto permille = static_cast<juce::int64> (blockLoad * 1000.0);
+
+    if (permille > load.peakPermille.load (std::memory_order_relaxed))
+        load.peakPermille.store (permille, std::memory_order_relaxed);
+}
+
+//==============================================================================
+StageProfiler::Snapshot StageProfiler::takeSnapshot()
+{
+    Snapshot snapshot;
+
+    const auto budget = budgetTicks.load (std::memory_order_relaxed);
+    const auto recentBudget = budget - std::exchange (lastBudgetTicks, budget);
+
+    for (int stage = 0; stage < numStages; ++stage)
+        snapshot.stages[static_cast<size_t> (stage)] = read (stageLoads[static_cast<size_t> (stage)],
+                                                             lastStageTicks[static_cast<size_t> (stage)], recentBudget);
+
+    snapshot.total = read (totalLoad, lastTotalTicks, recentBudget);
+
+    const auto numBlocks = blocks.load (std::memory_order_relaxed);
+    snapshot.numBlocks = numBlocks - std::exchange (lastBlocks, numBlocks);
+
+    snapshot.deadlineMisses = misses.load (std::memory_order_relaxed);
+    snapshot.recentDeadlineMisses = snapshot.deadlineMisses - std::exchange (lastMisses, snapshot.deadlineMisses);
+    return snapshot;
+}
+
+StageProfiler::StageLoad StageProfiler::read (AtomicLoad& load, juce::int64& lastTicks, juce::int64 recentBudget)
+{
+    StageLoad result;
+
+    const auto ticks = load.ticks.load (std::memory_order_relaxed);
+    const auto recentTicks = ticks - std::exchange (lastTicks, ticks);
+
+    if (recentBudget > 0)
+        result.averageLoad = static_cast<double> (recentTicks) / static_cast<double> (recentBudget);
+
+    result.peakLoad = static_cast<double> (load.peakPermille.exchange (0, std::memory_order_relaxed)) / 1000.0;
+
+    for (int bucket = 0; bucket < numLoadBuckets; ++bucket)
+        result.histogram[static_cast<size_t> (bucket)] = load.histogram[static_cast<size_t> (bucket)].load (std::memory_order_relaxed);
+
+    return result;
+}
+
+juce::String StageProfiler::getLoadBucketName (int bucket)
+{
+    if (bucket >= static_cast<int> (loadBucketEdges.size()))
+        return ">100%";
+
+    return "<" + juce::String (loadBucketEdges[static_cast<size_t> (bucket)] * 100.0, 0) + "%";
+}
+
+//==============================================================================
+TraceRecorder::TraceRecorder()
+    : originTicks (juce::Time::getHighResolutionTicks())
+{
+}
+
+void TraceRecorder::addEvent (const juce::String& name, const juce::String& category, int threadId,
+                              juce::int64 startTicks, juce::int64 endTicks)
+{
+    const juce::ScopedLock sl (lock);
+    events.push_back ({ name, category, threadId, startTicks, endTicks });
+}
+
+int TraceRecorder::getNumEvents() const
+{
+    const juce::ScopedLock sl (lock);
+    return static_cast<int> (events.size());
+}
+
+bool TraceRecorder::writeTo (const juce::File& file) const
+{
+    const double microsecondsPerTick = 1.0e6 / static_cast<double> (juce::Time::getHighResolutionTicksPerSecond());
+    juce::Array<juce::var> traceEvents;
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        for (const auto& event : events)
+        {
+            auto* object = new juce::DynamicObject();
+            object->setProperty ("name", event.name);
+            object->setProperty ("cat", event.category);
+            object->setProperty ("ph", "X");
+            object->setProperty ("ts", static_cast<double> (event.startTicks - originTicks) * microsecondsPerTick);
+            object->setProperty ("dur", static_cast<double> (event.endTicks - event.startTicks) * microsecondsPerTick);
+            object->setProperty ("pid", 1);
+            object->setProperty ("tid", event.threadId);
+            traceEvents.add (juce::var (object));
+        }
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("traceEvents", traceEvents);
+    root->setProperty ("displayTimeUnit", "ms");
+
+    return file.replaceWithText (juce::JSON::toString (juce::var (root)));
+}
+
+TraceRecorder::ScopedEvent::ScopedEvent (TraceRecorder* recorderToUse, juce::String eventName, juce::String eventCategory, int thread)
+    : recorder (recorderToUse), name (std::move (eventName)), category (std::move (eventCategory)), threadId (thread),
+      start (recorderToUse != nullptr ? juce::Time::getHighResolutionTicks() : 0)
+{
+}
+
+TraceRecorder::ScopedEvent::~ScopedEvent()
+{
+    if (recorder != nullptr)
+        recorder->addEvent (name, category, threadId, start, juce::Time::getHighResolutionTicks());
+}
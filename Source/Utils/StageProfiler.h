@@ -0,0 +1,187 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "RealtimeDiagnostics.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+/**
+ * Stage Profiler
+ *
+ * Always-on timing of the real-time chain, cheap enough to leave in release
+ * builds. The audio thread reads the high-resolution tick counter at every
+ * stage boundary and, at the end of each block, adds each stage's ticks to
+ * its totals and to a lock-free histogram of its load (its share of the
+ * block's real-time duration). A block that took longer than its duration
+ * counts as a deadline miss, the kind that becomes an xrun once the device's
+ * buffering is used up.
+ *
+ * Stages are those of RealtimeDiagnostics. Timers nest: while a stage runs
+ * inside another, its time is its own and not its parent's, so the stages of
+ * a block add up to the block. A ScopedBlock inside another (a host block
+ * split into prepared-size pieces) is part of the outer one.
+ *
+ * One thread writes (the audio callback), one other reads (a GUI timer).
+ */
+class StageProfiler
+{
+public:
+    using Stage = RealtimeDiagnostics::Stage;
+
+    static constexpr int numStages = static_cast<int> (Stage::numStages);
+
+    /** Load histogram buckets: under 1%, 2%, 5%, 10%, 20%, 50%, 100% of the block, and over */
+    static constexpr int numLoadBuckets = 8;
+
+    struct StageLoad
+    {
+        double averageLoad = 0.0;   // Share of the real-time budget since the last snapshot
+        double peakLoad = 0.0;      // Highest single block since the last snapshot
+        std::array<juce::int64, numLoadBuckets> histogram {};   // Blocks per load bucket since prepare
+    };
+
+    struct Snapshot
+    {
+        std::array<StageLoad, numStages> stages;
+        StageLoad total;                    // Whole blocks
+        juce::int64 numBlocks = 0;          // Since the last snapshot
+        juce::int64 deadlineMisses = 0;     // Since prepare
+        juce::int64 recentDeadlineMisses = 0;  // Since the last snapshot
+    };
+
+    StageProfiler() = default;
+
+    /** Before the audio thread starts; clears everything counted so far */
+    void prepare (double sampleRate);
+
+    /** Times one block of numSamples against its duration at the prepared rate */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock (StageProfiler& profiler, int numSamples) noexcept;
+        ~ScopedBlock() noexcept;
+
+    private:
+        StageProfiler& owner;
+        int numSamples;
+        bool outermost;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlock)
+    };
+
+    /** Charges the time until destroyed to a stage, pausing the enclosing one */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer (StageProfiler& profiler, Stage stage) noexcept;
+        ~ScopedTimer() noexcept;
+
+    private:
+        StageProfiler& owner;
+        int previous;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedTimer)
+    };
+
+    /** Reader thread: loads since the previous call, histograms and misses since prepare */
+    Snapshot takeSnapshot();
+
+    static juce::String getLoadBucketName (int bucket);
+
+private:
+    struct AtomicLoad
+    {
+        std::atomic<juce::int64> ticks { 0 };
+        std::atomic<juce::int64> peakPermille { 0 };
+        std::array<std::atomic<juce::int64>, numLoadBuckets> histogram {};
+    };
+
+    void switchStage (int newStage, juce::int64 now) noexcept;
+    void endBlock (int numSamples) noexcept;
+    static void record (AtomicLoad& load, juce::int64 ticks, double budgetTicks) noexcept;
+    static StageLoad read (AtomicLoad& load, juce::int64& lastTicks, juce::int64 budgetTicks);
+
+    double ticksPerSample = 0.0;
+
+    // Audio thread only
+    int blockDepth = 0;
+    int currentStage = -1;
+    juce::int64 blockStart = 0;
+    juce::int64 segmentStart = 0;
+    std::array<juce::int64, numStages> blockTicks {};
+
+    // Written by the audio thread, read by the reader
+    std::array<AtomicLoad, numStages> stageLoads;
+    AtomicLoad totalLoad;
+    std::atomic<juce::int64> budgetTicks { 0 };
+    std::atomic<juce::int64> blocks { 0 };
+    std::atomic<juce::int64> misses { 0 };
+
+    // Reader only
+    std::array<juce::int64, numStages> lastStageTicks {};
+    juce::int64 lastTotalTicks = 0;
+    juce::int64 lastBudgetTicks = 0;
+    juce::int64 lastBlocks = 0;
+    juce::int64 lastMisses = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StageProfiler)
+};
+
+/** Times a RealtimeDiagnostics stage and notes it for the diagnostics build */
+#define VRS_PROFILE_STAGE(profiler, stage) \
+    VRS_RT_STAGE (stage); \
+    const StageProfiler::ScopedTimer JUCE_JOIN_MACRO (stageTimer_, __LINE__) (profiler, StageProfiler::Stage::stage)
+
+/**
+ * Trace Recorder
+ *
+ * Collects complete events ("ph":"X") from offline work, such as each file
+ * and each chain stage of a batch run, and writes them in the Chrome trace
+ * event format for chrome://tracing or Perfetto. Each event is taken under a
+ * lock, so this is for offline threads only.
+ */
+class TraceRecorder
+{
+public:
+    TraceRecorder();
+
+    /** An event from start to end (high-resolution ticks) on a numbered thread */
+    void addEvent (const juce::String& name, const juce::String& category, int threadId,
+                   juce::int64 startTicks, juce::int64 endTicks);
+
+    /** Records the time until destroyed as one event */
+    class ScopedEvent
+    {
+    public:
+        ScopedEvent (TraceRecorder* recorder, juce::String name, juce::String category, int threadId);
+        ~ScopedEvent();
+
+    private:
+        TraceRecorder* recorder;
+        juce::String name, category;
+        int threadId;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedEvent)
+    };
+
+    int getNumEvents() const;
+
+    /** Writes {"traceEvents": [...]} with times in microseconds from construction */
+    bool writeTo (const juce::File& file) const;
+
+private:
+    struct Event
+    {
+        juce::String name, category;
+        int threadId;
+        juce::int64 startTicks, endTicks;
+    };
+
+    const juce::int64 originTicks;
+    mutable juce::CriticalSection lock;
+    std::vector<Event> events;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TraceRecorder)
+};
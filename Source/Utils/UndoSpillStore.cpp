@@ -0,0 +1,318 @@
+#include "UndoSpillStore.h"
+#include <cstring>
+
+namespace
+{
+    const char* const spillMagic = "VRSU";
+    constexpr int spillVersion = 1;
+    constexpr int blockSamples = 1 << 18;       // Samples per compressed block of a channel
+    constexpr int maxChannels = 256;
+
+    /** Zig-zagged difference of a sample's bit pattern from the one before it */
+    inline juce::uint32 encodeResidual (juce::uint32 bits, juce::uint32 previous)
+    {
+        const juce::uint32 difference = bits - previous;
+        return (difference << 1) ^ static_cast<juce::uint32> (static_cast<juce::int32> (difference) >> 31);
+    }
+
+    inline juce::uint32 decodeResidual (juce::uint32 residual, juce::uint32 previous)
+    {
+        return previous + ((residual >> 1) ^ (0u - (residual & 1u)));
+    }
+
+    bool writeChannel (juce::OutputStream& output, const float* samples, int numSamples, std::vector<juce::uint8>& planes)
+    {
+        juce::uint32 previous = 0;
+
+        for (int blockStart = 0; blockStart < numSamples; blockStart += blockSamples)
+        {
+            const int numThisBlock = juce::jmin (blockSamples, numSamples - blockStart);
+            const auto planeSize = static_cast<size_t> (numThisBlock);
+            planes.resize (planeSize * 4);
+
+            // Byte planes: the high bytes of small residuals form long runs of zeros
+            for (int i = 0; i < numThisBlock; ++i)
+            {
+                juce::uint32 bits;
+                std::memcpy (&bits, samples + blockStart + i, sizeof (bits));
+                const auto residual = encodeResidual (bits, previous);
+                previous = bits;
+
+                for (size_t plane = 0; plane < 4; ++plane)
+                    planes[plane * planeSize + static_cast<size_t> (i)] = static_cast<juce::uint8> (residual >> (8 * plane));
+            }
+
+            juce::MemoryOutputStream compressed;
+
+            {
+                juce::GZIPCompressorOutputStream deflate (compressed, 1);
+
+                if (!deflate.write (planes.data(), planes.size()))
+                    return false;
+            }
+
+            if (!output.writeInt (static_cast<int> (compressed.getDataSize()))
+                || !output.write (compressed.getData(), compressed.getDataSize()))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool readChannel (juce::InputStream& input, float* samples, int numSamples, std::vector<juce::uint8>& planes)
+    {
+        juce::uint32 previous = 0;
+        juce::MemoryBlock compressed;
+
+        for (int blockStart = 0; blockStart < numSamples; blockStart += blockSamples)
+        {
+            const int numThisBlock = juce::jmin (blockSamples, numSamples - blockStart);
+            const auto planeSize = static_cast<size_t> (numThisBlock);
+            const int compressedSize = input.readInt();
+
+            if (compressedSize <= 0 || compressedSize > input.getNumBytesRemaining())
+                return false;
+
+            compressed.setSize (static_cast<size_t> (compressedSize));
+
+            if (input.read (compressed.getData(), compressedSize) != compressedSize)
+                return false;
+
+            planes.resize (planeSize * 4);
+            juce::MemoryInputStream source (compressed, false);
+            juce::GZIPDecompressorInputStream inflate (source);
+            size_t numRead = 0;
+
+            while (numRead < planes.size())
+            {
+                const int read = inflate.read (planes.data() + numRead, static_cast<int> (planes.size() - numRead));
+
+                if (read <= 0)
+                    return false;
+
+                numRead += static_cast<size_t> (read);
+            }
+
+            for (int i = 0; i < numThisBlock; ++i)
+            {
+                juce::uint32 residual = 0;
+
+                for (size_t plane = 0; plane < 4; ++plane)
+                    residual |= static_cast<juce::uint32> (planes[plane * planeSize + static_cast<size_t> (i)]) << (8 * plane);
+
+                previous = decodeResidual (residual, previous);
+                std::memcpy (samples + blockStart + i, &previous, sizeof (previous));
+            }
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+UndoSpillStore::Entry::~Entry()
+{
+    if (file != juce::File())
+        file.deleteFile();
+}
+
+juce::int64 UndoSpillStore::Entry::getNumBytesOnDisk() const
+{
+    const std::lock_guard<std::mutex> guard (lock);
+    return numBytesOnDisk;
+}
+
+//==============================================================================
+UndoSpillStore::UndoSpillStore() = default;
+
+UndoSpillStore::~UndoSpillStore()
+{
+    // Entries still queued keep their buffers; one being written is finished first
+    writer.removeAllJobs (false, -1);
+
+    if (directory != juce::File())
+        directory.deleteRecursively();
+}
+
+UndoSpillStore::Handle UndoSpillStore::spill (std::vector<juce::AudioBuffer<float>>&& buffers)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->buffers = std::move (buffers);
+
+    writer.addJob ([this, entry]
+    {
+        write (entry);
+        return juce::ThreadPoolJob::jobHasFinished;
+    });
+
+    return entry;
+}
+
+bool UndoSpillStore::reload (const Handle& entry, std::vector<juce::AudioBuffer<float>>& buffers)
+{
+    if (entry == nullptr)
+        return false;
+
+    std::unique_lock<std::mutex> guard (entry->lock);
+    entry->statusChanged.wait (guard, [&] { return entry->status != Entry::Status::writing; });
+
+    switch (entry->status)
+    {
+        case Entry::Status::queued:
+        case Entry::Status::failed:
+            buffers = std::move (entry->buffers);
+            entry->buffers.clear();
+            entry->status = Entry::Status::reloaded;
+            return true;
+
+        case Entry::Status::written:
+        {
+            bool ok = false;
+
+            {
+                juce::FileInputStream input (entry->file);
+                ok = input.openedOk() && readBuffers (input, buffers);
+            }
+
+            if (!ok)
+            {
+                DBG ("Undo spill: could not read " + entry->file.getFullPathName());
+                return false;
+            }
+
+            entry->file.deleteFile();
+            entry->file = juce::File();
+            entry->status = Entry::Status::reloaded;
+            return true;
+        }
+
+        case Entry::Status::writing:
+        case Entry::Status::reloaded:
+        default:
+            jassertfalse;
+            return false;
+    }
+}
+
+void UndoSpillStore::write (const Handle& entry)
+{
+    // Dropped from the history before its turn came
+    if (entry.use_count() <= 1)
+        return;
+
+    std::vector<juce::AudioBuffer<float>> buffers;
+
+    {
+        const std::lock_guard<std::mutex> guard (entry->lock);
+
+        // Reloaded before its turn came
+        if (entry->status != Entry::Status::queued)
+            return;
+
+        entry->status = Entry::Status::writing;
+        buffers = std::move (entry->buffers);
+        entry->buffers.clear();
+    }
+
+    const auto file = getDirectory().getChildFile ("state-" + juce::String (nextFileIndex++) + ".vrsundo");
+    bool written = false;
+
+    {
+        juce::FileOutputStream output (file);
+
+        if (output.openedOk() && output.setPosition (0) && output.truncate().wasOk())
+        {
+            written = writeBuffers (output, buffers);
+            output.flush();
+            written = written && output.getStatus().wasOk();
+        }
+    }
+
+    {
+        const std::lock_guard<std::mutex> guard (entry->lock);
+
+        if (written)
+        {
+            entry->file = file;
+            entry->numBytesOnDisk = file.getSize();
+            entry->status = Entry::Status::written;
+        }
+        else
+        {
+            DBG ("Undo spill: could not write " + file.getFullPathName() + ", keeping the state in memory");
+            file.deleteFile();
+            entry->buffers = std::move (buffers);
+            entry->status = Entry::Status::failed;
+        }
+    }
+
+    entry->statusChanged.notify_all();
+}
+
+juce::File UndoSpillStore::getDirectory()
+{
+    if (directory == juce::File())
+    {
+        directory = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                        .getChildFile ("VinylRestorationUndo-" + juce::Uuid().toString());
+        directory.createDirectory();
+    }
+
+    return directory;
+}
+
+//==============================================================================
+bool UndoSpillStore::writeBuffers (juce::OutputStream& output, const std::vector<juce::AudioBuffer<float>>& buffers)
+{
+    if (!output.write (spillMagic, 4) || !output.writeInt (spillVersion)
+        || !output.writeInt (static_cast<int> (buffers.size())))
+        return false;
+
+    std::vector<juce::uint8> planes;
+
+    for (const auto& buffer : buffers)
+    {
+        if (!output.writeInt (buffer.getNumChannels()) || !output.writeInt (buffer.getNumSamples()))
+            return false;
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            if (!writeChannel (output, buffer.getReadPointer (channel), buffer.getNumSamples(), planes))
+                return false;
+    }
+
+    return true;
+}
+
+bool UndoSpillStore::readBuffers (juce::InputStream& input, std::vector<juce::AudioBuffer<float>>& buffers)
+{
+    char magic[4] = {};
+
+    if (input.read (magic, 4) != 4 || std::memcmp (magic, spillMagic, 4) != 0 || input.readInt() != spillVersion)
+        return false;
+
+    const int numBuffers = input.readInt();
+
+    if (numBuffers < 0)
+        return false;
+
+    std::vector<juce::AudioBuffer<float>> result (static_cast<size_t> (numBuffers));
+    std::vector<juce::uint8> planes;
+
+    for (auto& buffer : result)
+    {
+        const int numChannels = input.readInt();
+        const int numSamples = input.readInt();
+
+        if (numChannels < 0 || numChannels > maxChannels || numSamples < 0)
+            return false;
+
+        buffer.setSize (numChannels, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (!readChannel (input, buffer.getWritePointer (channel), numSamples, planes))
+                return false;
+    }
+
+    buffers = std::move (result);
+    return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Undo Spill Store
+ *
+ * Moves the saved samples of old undo states out of RAM: spill() takes a set
+ * of buffers and a background thread compresses them losslessly into a file
+ * of a private temporary directory; reload() brings them back, bit-exact.
+ *
+ * The codec predicts each sample's bit pattern from the one before it, so
+ * the residuals of smooth audio have mostly zero high bytes, splits them
+ * into byte planes and deflates each plane. Silence and processed regions
+ * (faded, normalised) compress best; noise barely at all.
+ *
+ * A spill that fails keeps its buffers in RAM, so no state is ever lost, and
+ * reloading a state whose spill has not started takes the buffers straight back.
+ */
+class UndoSpillStore
+{
+public:
+    UndoSpillStore();
+    ~UndoSpillStore();
+
+    /** One spilled set of buffers; its file is deleted with it */
+    class Entry
+    {
+    public:
+        ~Entry();
+
+        /** Compressed bytes on disk, once written */
+        juce::int64 getNumBytesOnDisk() const;
+
+    private:
+        friend class UndoSpillStore;
+
+        enum class Status { queued, writing, written, failed, reloaded };
+
+        mutable std::mutex lock;
+        std::condition_variable statusChanged;
+        Status status = Status::queued;
+        std::vector<juce::AudioBuffer<float>> buffers;    // Until written, or after a failed write
+        juce::File file;
+        juce::int64 numBytesOnDisk = 0;
+    };
+
+    using Handle = std::shared_ptr<Entry>;
+
+    /** Takes the buffers and writes them out in the background */
+    Handle spill (std::vector<juce::AudioBuffer<float>>&& buffers);
+
+    /** Returns the buffers of an entry, waiting for a write in progress; false if they cannot be read */
+    bool reload (const Handle& entry, std::vector<juce::AudioBuffer<float>>& buffers);
+
+    //==============================================================================
+    /** The spill file format: the buffers, losslessly compressed */
+    static bool writeBuffers (juce::OutputStream& output, const std::vector<juce::AudioBuffer<float>>& buffers);
+    static bool readBuffers (juce::InputStream& input, std::vector<juce::AudioBuffer<float>>& buffers);
+
+private:
+    void write (const Handle& entry);
+    juce::File getDirectory();
+
+    juce::ThreadPool writer { 1 };
+    juce::File directory;
+    std::atomic<int> nextFileIndex { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UndoSpillStore)
+};